@@ -0,0 +1,101 @@
+#include "trx/parsing/ParserDriver.h"
+#include "trx/runtime/Interpreter.h"
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/ListSort.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr const char *source = R"TRX(
+    ROUTINE arithmetic(request: JSON) : JSON {
+        var total DECIMAL := 0;
+        var i INTEGER := 0;
+        WHILE i < request.count {
+            total := total + (i * 3 + request.offset) / 2 - i % 7;
+            i := i + 1;
+        }
+        RETURN { "total": total };
+    }
+
+    ROUTINE fields(request: JSON) : JSON {
+        var total DECIMAL := 0;
+        var i INTEGER := 0;
+        WHILE i < request.count {
+            total := total + request.order.customer.discount * request.order.line.qty + request.order.line.price;
+            i := i + 1;
+        }
+        RETURN { "total": total };
+    }
+)TRX";
+
+// One interpreter over the benchmark routines, built on first use
+trx::runtime::Interpreter &interpreter() {
+    static trx::parsing::ParserDriver driver;
+    static const std::unique_ptr<trx::runtime::Interpreter> instance = [] {
+        if (!driver.parseString(source, "bench.trx")) {
+            std::cerr << "Benchmark routines failed to parse\n";
+            std::abort();
+        }
+        trx::runtime::DatabaseConfig config;
+        config.type = trx::runtime::DatabaseType::SQLITE;
+        config.databasePath = ":memory:";
+        return std::make_unique<trx::runtime::Interpreter>(driver.context().module(),
+                                                           std::make_unique<trx::runtime::SQLiteDriver>(config));
+    }();
+    return *instance;
+}
+
+// Each iteration runs the routine once; the counters report the loop's per-expression cost
+void runLoop(benchmark::State &state, const std::string &routine, const std::string &request) {
+    auto &runner = interpreter();
+    const auto input = trx::runtime::JsonParser(request).parse();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(runner.execute(routine, input));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_EvaluateArithmetic(benchmark::State &state) {
+    runLoop(state, "arithmetic", R"({"count": )" + std::to_string(state.range(0)) + R"(, "offset": 5})");
+}
+BENCHMARK(BM_EvaluateArithmetic)->Arg(1000);
+
+void BM_EvaluateFieldAccess(benchmark::State &state) {
+    runLoop(state, "fields",
+            R"({"count": )" + std::to_string(state.range(0)) +
+                R"(, "order": {"customer": {"discount": 0.9}, "line": {"qty": 3, "price": 19.5}}})");
+}
+BENCHMARK(BM_EvaluateFieldAccess)->Arg(1000);
+
+// SORT over a list of objects: by a number, then by a string when numbers tie
+void BM_SortByKeys(benchmark::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    trx::runtime::JsonValue::Array items;
+    items.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        trx::runtime::JsonValue::Object item;
+        item["score"] = trx::runtime::JsonValue(static_cast<double>((i * 7919) % 1000));
+        item["name"] = trx::runtime::JsonValue("name-" + std::to_string((i * 104729) % count));
+        items.emplace_back(std::move(item));
+    }
+    const std::vector<trx::ast::SortKey> keys{{-1.0, "score"}, {1.0, "name"}};
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto copy = items;
+        state.ResumeTiming();
+        trx::runtime::sortByKeys(copy, keys);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SortByKeys)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,66 @@
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/JsonWriter.h"
+#include "trx/runtime/RequestArena.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+namespace {
+
+// An order of |lines| lines, shaped like the request bodies the examples post
+std::string orderPayload(int lines) {
+    std::string text = R"({"orderId": 918273, "customer": {"id": 4411, "name": "Ada Lovelace", "email": "ada@example.com",)"
+                       R"( "address": {"street": "12 Analytical Row", "city": "London", "zip": "N1 9GU"}}, "express": false,)"
+                       R"( "note": "Leave at the door \"please\"\n", "lines": [)";
+    for (int i = 0; i < lines; ++i) {
+        if (i > 0) {
+            text += ", ";
+        }
+        text += R"({"sku": "SKU-)" + std::to_string(100000 + i) + R"(", "description": "Item number )" + std::to_string(i) +
+                R"(", "qty": )" + std::to_string(1 + i % 7) + R"(, "price": )" + std::to_string(i % 100) + ".25, \"taxable\": true}";
+    }
+    text += "]}";
+    return text;
+}
+
+void BM_JsonParse(benchmark::State &state) {
+    const auto text = orderPayload(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        trx::runtime::JsonParser parser(text);
+        benchmark::DoNotOptimize(parser.parse());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_JsonParse)->Arg(1)->Arg(20)->Arg(500);
+
+// As the server parses: into the request arena, released after each request
+void BM_JsonParseArena(benchmark::State &state) {
+    const auto text = orderPayload(static_cast<int>(state.range(0)));
+    trx::runtime::RequestArena arena;
+    for (auto _ : state) {
+        {
+            trx::runtime::JsonParser parser(text, arena.resource());
+            benchmark::DoNotOptimize(parser.parse());
+        }
+        arena.release();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_JsonParseArena)->Arg(1)->Arg(20)->Arg(500);
+
+void BM_JsonWrite(benchmark::State &state) {
+    const auto text = orderPayload(static_cast<int>(state.range(0)));
+    const auto value = trx::runtime::JsonParser(text).parse();
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        trx::runtime::JsonWriter(out).write(value);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * out.size()));
+}
+BENCHMARK(BM_JsonWrite)->Arg(1)->Arg(20)->Arg(500);
+
+} // namespace
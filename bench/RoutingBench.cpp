@@ -0,0 +1,56 @@
+#include "cli/RouteTable.h"
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace {
+
+// |count| routines split between resource_N and resource_N/{id: INTEGER}/lines/{line: INTEGER}
+struct Routes {
+    std::deque<trx::ast::ProcedureDecl> procedures;
+    trx::cli::RouteTable table;
+    std::vector<std::string> paths;
+
+    explicit Routes(std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            auto &procedure = procedures.emplace_back();
+            procedure.name.baseName = "resource_" + std::to_string(i);
+            if (i % 2 == 0) {
+                procedure.name.pathTemplate = procedure.name.baseName;
+                paths.push_back("/api/" + procedure.name.baseName);
+            } else {
+                procedure.name.pathTemplate = procedure.name.baseName + "/{id}/lines/{line}";
+                procedure.name.pathParameters.push_back({{"id"}, {"INTEGER"}});
+                procedure.name.pathParameters.push_back({{"line"}, {"INTEGER"}});
+                paths.push_back("/api/" + procedure.name.baseName + "/" + std::to_string(1000 + i) + "/lines/7");
+            }
+            table.add("GET", &procedure);
+        }
+    }
+};
+
+void BM_RouteMatch(benchmark::State &state) {
+    const Routes routes(static_cast<std::size_t>(state.range(0)));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        trx::cli::RouteTable::Match match;
+        benchmark::DoNotOptimize(routes.table.match("GET", routes.paths[next], match));
+        benchmark::DoNotOptimize(match.procedure);
+        next = next + 1 == routes.paths.size() ? 0 : next + 1;
+    }
+}
+BENCHMARK(BM_RouteMatch)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_RouteMiss(benchmark::State &state) {
+    const Routes routes(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        trx::cli::RouteTable::Match match;
+        benchmark::DoNotOptimize(routes.table.match("GET", "/api/resource_1/not-a-number/lines/7", match));
+    }
+}
+BENCHMARK(BM_RouteMiss)->Arg(10)->Arg(1000);
+
+} // namespace
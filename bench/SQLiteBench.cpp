@@ -0,0 +1,69 @@
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::unique_ptr<trx::runtime::SQLiteDriver> openDatabase(std::size_t rows) {
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = ":memory:";
+    auto driver = std::make_unique<trx::runtime::SQLiteDriver>(config);
+    driver->initialize();
+    driver->executeSql("CREATE TABLE bench_rows (id INTEGER PRIMARY KEY, name TEXT, amount REAL)");
+    driver->executeSql("WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(rows) +
+                       ") INSERT INTO bench_rows SELECT x, 'row ' || x, x * 1.5 FROM n");
+    return driver;
+}
+
+// Parameterised single-row INSERTs, committed every 1000 rows
+void BM_SQLiteExec(benchmark::State &state) {
+    auto driver = openDatabase(0);
+    const std::string sql = "INSERT INTO bench_rows (name, amount) VALUES (?, ?)";
+    std::vector<trx::runtime::SqlParameter> params{{"name", trx::runtime::JsonValue("bench")}, {"amount", trx::runtime::JsonValue(2.5)}};
+    std::size_t pending = 0;
+    driver->beginTransaction();
+    for (auto _ : state) {
+        driver->executeSql(sql, params);
+        if (++pending == 1000) {
+            driver->commitTransaction();
+            driver->beginTransaction();
+            pending = 0;
+        }
+    }
+    driver->commitTransaction();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SQLiteExec);
+
+// A parameterised query returning |range| rows at once
+void BM_SQLiteQuery(benchmark::State &state) {
+    auto driver = openDatabase(10000);
+    const std::vector<trx::runtime::SqlParameter> params{{"limit", trx::runtime::JsonValue(static_cast<double>(state.range(0)))}};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(driver->querySql("SELECT id, name, amount FROM bench_rows WHERE id <= ?", params));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SQLiteQuery)->Arg(1)->Arg(100)->Arg(10000);
+
+// OPEN, FETCH every row, CLOSE, as a cursor loop in a routine does
+void BM_SQLiteCursor(benchmark::State &state) {
+    auto driver = openDatabase(10000);
+    const std::vector<trx::runtime::SqlParameter> params{{"limit", trx::runtime::JsonValue(static_cast<double>(state.range(0)))}};
+    for (auto _ : state) {
+        driver->openCursor("bench_cursor", "SELECT id, name, amount FROM bench_rows WHERE id <= ?", params);
+        while (driver->cursorNext("bench_cursor")) {
+            benchmark::DoNotOptimize(driver->cursorGetRow("bench_cursor"));
+        }
+        driver->closeCursor("bench_cursor");
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SQLiteCursor)->Arg(1)->Arg(100)->Arg(10000);
+
+} // namespace
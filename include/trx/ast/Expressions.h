@@ -2,6 +2,7 @@
 
 #include "trx/ast/SourceLocation.h"
 
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string>
@@ -17,8 +18,30 @@ struct Identifier {
     SourceLocation location{};
 };
 
+// A lowercased identifier, interned for the life of the process: equal names share one
+// copy of their text, so symbols compare by pointer and can be kept by value anywhere
+class Symbol {
+public:
+    Symbol() = default;
+
+    // The symbol of |identifier|, whatever its case
+    static Symbol of(std::string_view identifier);
+
+    const std::string &str() const noexcept;
+    bool empty() const noexcept { return text_ == nullptr; }
+
+    bool operator==(const Symbol &) const = default;
+    friend bool operator==(const Symbol &symbol, std::string_view text) { return symbol.str() == text; }
+
+private:
+    explicit Symbol(const std::string *text) : text_{text} {}
+
+    const std::string *text_{nullptr};
+};
+
 struct Expression;
 using ExpressionPtr = std::shared_ptr<Expression>;
+struct ProcedureDecl;
 
 struct LiteralExpression {
     std::variant<double, std::string, bool> value;
@@ -32,13 +55,29 @@ struct ArrayLiteralExpression {
     std::vector<ExpressionPtr> elements;
 };
 
+// Frame slot of a variable the resolver never placed: module-level code or a hand-built AST
+inline constexpr std::size_t unresolvedSlot = static_cast<std::size_t>(-1);
+
+// What an expression is known to yield before it runs. Declared types are not enforced on
+// assignment, so a variable typed INTEGER may still hold null or a string: evaluation uses
+// a static type to pick its path and still checks the value it gets.
+struct StaticType {
+    enum class Kind { Unknown, Number, String, Boolean };
+    Kind kind{Kind::Unknown};
+    short scale{-1}; // decimals of an exact number: 0 for INTEGER, s for DECIMAL(p,s); -1 when not exact
+};
+
 struct VariableSegment {
     std::string identifier;
     std::optional<ExpressionPtr> subscript; // nullptr when scalar access
+    Symbol key{};                           // lowercased identifier, set by resolveFrameSlots()
+    std::size_t field{unresolvedSlot};     // index of the field in the parent's record type, set by resolveRecordFields()
 };
 
 struct VariableExpression {
     std::vector<VariableSegment> path;
+    std::size_t slot{unresolvedSlot};       // frame slot of the root variable, set by resolveFrameSlots()
+    StaticType type{};                      // declared type of the whole path, set by resolveRecordFields()
 };
 
 enum class UnaryOperator {
@@ -72,11 +111,37 @@ struct BinaryExpression {
     BinaryOperator op;
     ExpressionPtr lhs;
     ExpressionPtr rhs;
+    bool numeric{false}; // both operands are statically numbers, set by checkTypes()
+    short scale{-1};     // decimals an exact Add, Subtract or Multiply result is rounded to, set by checkTypes()
+};
+
+// Functions provided by the runtime; calls are bound to one by resolveCalls()
+enum class BuiltinFunction {
+    None,
+    Length,
+    Append,
+    Substr,
+    Debug,
+    Info,
+    Error,
+    Trace,
+    Http,
+    HttpAll,
+    IndexBy,
+    GroupBy,
+    Lookup,
+    Sum,
+    Min,
+    Max,
+    Avg,
+    CountIf
 };
 
 struct FunctionCallExpression {
     std::string functionName;
     std::vector<ExpressionPtr> arguments;
+    BuiltinFunction builtin{BuiltinFunction::None}; // set by resolveCalls(); takes precedence over routine
+    const ProcedureDecl *routine{nullptr};          // user routine of that name, set by resolveCalls()
 };
 
 struct MethodCallExpression {
@@ -121,6 +186,8 @@ struct Expression {
     Node node;
 };
 
+// Allocated in the arena current on this thread, if any (see NodeArena::Scope)
+ExpressionPtr makeExpression(Expression expression);
 ExpressionPtr makeNumericLiteral(double value);
 ExpressionPtr makeStringLiteral(std::string value);
 ExpressionPtr makeBooleanLiteral(bool value);
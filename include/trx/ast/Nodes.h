@@ -1,8 +1,11 @@
 #pragma once
 
+#include "trx/ast/Arena.h"
 #include "trx/ast/SourceLocation.h"
 #include "trx/ast/Statements.h"
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -18,12 +21,13 @@ struct IncludeDecl {
 
 struct ConstantDecl {
     Identifier name;
-    std::variant<double, std::string> value;
+    std::variant<double, std::string, bool> value;
 };
 
 struct ParameterDecl {
     Identifier name;
     Identifier type;
+    std::size_t slot{unresolvedSlot}; // frame slot the argument is bound to, set by resolveFrameSlots()
 };
 
 struct ProcedureName {
@@ -35,6 +39,8 @@ struct ProcedureName {
 struct ProcedureConfig {
     std::optional<std::string> httpMethod;
     std::vector<std::pair<std::string, std::string>> httpHeaders;
+    double cacheSeconds{0.0};
+    double timeoutSeconds{0.0};
 };
 
 struct ProcedureDecl {
@@ -46,6 +52,15 @@ struct ProcedureDecl {
     bool isFunction{false};
     std::optional<std::string> httpMethod; // Optional HTTP method override
     std::vector<std::pair<std::string, std::string>> httpHeaders; // Optional custom headers
+    double cacheSeconds{0.0}; // CACHE n: how long the server may reuse a response; 0 when not cached
+    double timeoutSeconds{0.0}; // TIMEOUT n: how long a call may run before DeadlineExceeded; 0 for no limit
+    std::vector<std::string> frameSlots; // lowercased local names indexed by frame slot
+    bool runsSql{true}; // cleared by resolveCalls() when neither the body nor its callees run SQL
+    bool emits{false};  // set by resolveCalls() when the body or a callee has an EMIT statement
+    bool readOnly{false};    // set by resolveCalls() when no SQL of the body or its callees can write
+    bool usesCursors{false}; // set by resolveCalls() when the body or a callee declares or opens a cursor
+    std::vector<std::string> readsTables;  // set by resolveCalls(): tables the body and its callees read
+    std::vector<std::string> writesTables; // and the ones they write
 };
 
 struct RecordField {
@@ -101,6 +116,47 @@ using Declaration = std::variant<IncludeDecl,
 struct Module {
     std::vector<Declaration> declarations;
     std::vector<Statement> statements;
+    std::shared_ptr<NodeArena> arena{std::make_shared<NodeArena>()}; // where the parser puts the module's expressions
 };
 
+// Give every local of a routine (arguments, declarations and any variable the body binds)
+// a slot in a flat per-call frame and precompute the lowercased key of each path segment,
+// so the interpreter resolves variables by index instead of by name.
+void resolveFrameSlots(ProcedureDecl &procedure);
+
+// Record every field access of a routine whose parent has a statically known TYPE with the
+// field's index in that type, so record values are read by offset. Runs once all TYPE
+// declarations, including those taken from a table, have their fields.
+void resolveRecordFields(Module &module);
+
+// Copy of |module| that shares no expression nodes with it. Expressions are shared
+// pointers that resolving and folding rewrite in place, so a parsed module that is
+// loaded more than once has to be copied this way each time.
+Module copyModule(const Module &module);
+
+// Bind every function call to the builtin or user routine it names, so calls skip the
+// lookup by name, and mark the routines that can be proven to run no SQL, or only SQL
+// that reads, directly or through their callees. Also marks the cursors a WHERE CURRENT OF
+// names and the PARALLEL FOR loops whose bodies only read. Returns one message per call
+// that names neither.
+std::vector<std::string> resolveCalls(Module &module);
+
+// Infer the static type of every expression from literals, operators and the types
+// resolveRecordFields() stamped on variables. Marks the binary operators applied to
+// numbers, with the scale an exact INTEGER or DECIMAL(p,s) result keeps, and returns one
+// message per operator given an operand it can never take, such as 'a' - 1. Runs before
+// foldConstants(), which folds with those marks.
+std::vector<std::string> checkTypes(Module &module);
+
+// Operators applied to literal operands, supplied by the runtime so folding gives exactly
+// what evaluation would; returning nothing leaves the expression to fail at run time.
+struct ConstantFolder {
+    std::function<std::optional<LiteralExpression>(UnaryOperator, const LiteralExpression &)> unary;
+    std::function<std::optional<LiteralExpression>(const BinaryExpression &, const LiteralExpression &, const LiteralExpression &)> binary;
+};
+
+// Replace reads of CONSTANTs that nothing in the module rebinds by their value, and
+// operators whose operands are all literals by their result.
+void foldConstants(Module &module, const ConstantFolder &folder);
+
 } // namespace trx::ast
@@ -3,6 +3,7 @@
 #include "trx/ast/Expressions.h"
 #include "trx/ast/SourceLocation.h"
 
+#include <cstddef>
 #include <optional>
 #include <string>
 #include <variant>
@@ -49,17 +50,26 @@ struct VariableDeclarationStatement {
     std::string typeName;
     std::optional<ExpressionPtr> initializer;
     std::optional<std::string> tableName; // If set, type will be inferred from database table schema
+    std::size_t slot{unresolvedSlot};     // frame slot of the declared local, set by resolveFrameSlots()
+    std::optional<short> scale{};         // decimals of a DECIMAL(p,s) variable
 };
 
 struct BatchStatement {
     std::string name;
     std::optional<VariableExpression> argument;
+    std::optional<VariableExpression> jobId;   // `id := BATCH name(...)`: receives the queued job's id
+    const ProcedureDecl *routine{nullptr};      // the routine queued, set by resolveCalls()
 };
 
 struct ThrowStatement {
     ExpressionPtr value;
 };
 
+// Sends one value to the response while the routine keeps running
+struct EmitStatement {
+    ExpressionPtr value;
+};
+
 enum class SqlStatementKind {
     ExecImmediate,
     DeclareCursor,
@@ -70,14 +80,40 @@ enum class SqlStatementKind {
     SelectInto
 };
 
+// Driver-ready form of an embedded SQL statement, produced once by compileSqlStatement()
+struct CompiledSql {
+    std::string text;            // SQL handed to the driver
+    std::size_t intoCount{0};    // leading host variables that receive SELECT INTO columns; the rest are parameters
+    // UPDATE ... WHERE CURRENT OF: SET items (one host variable each) for dropping unresolved assignments
+    std::string updatePrefix;
+    std::vector<std::string> setAssignments;
+    std::string currentOfClause;
+    std::string currentOfCursor; // UPDATE/DELETE ... WHERE CURRENT OF: the upper-cased cursor name
+    bool positioned{false};      // DECLARE: a WHERE CURRENT OF in the module names this cursor, set by resolveCalls()
+    bool batchable{false};       // plain INSERT/UPDATE/DELETE that a FOR loop may send as one executeBatch call
+    std::vector<std::string> readsTables;  // lowercased tables named after FROM or JOIN
+    std::vector<std::string> writesTables; // lowercased tables the statement inserts into, updates, deletes from or alters
+    bool readOnly{false};        // a query or cursor step that writes nothing and locks no rows
+    // FETCH cursor INTO LIST :rows [LIMIT n] and SELECT ... INTO LIST :rows: the rows replace the
+    // list in the first host variable
+    bool intoList{false};
+    std::size_t fetchLimit{0};   // most rows one FETCH INTO LIST reads; 0 reads the rest of the cursor
+    bool limitVariable{false};   // LIMIT :n, taken from the second host variable
+};
+
 struct SqlStatement {
     SqlStatementKind kind{SqlStatementKind::ExecImmediate};
     std::string identifier;      // cursor name when applicable
     std::string sql;             // textual SQL (for exec and declare)
     std::vector<VariableExpression> hostVariables; // fetch target list
     std::vector<VariableExpression> openParameters; // parameters for OPEN cursor USING
+    CompiledSql compiled;
+    std::string listType;        // TYPE of an INTO LIST target's elements, set by resolveRecordFields()
 };
 
+// Precompute the SQL text and host variable layout for a classified statement
+void compileSqlStatement(SqlStatement &statement);
+
 struct TryCatchStatement;
 struct BlockStatement;
 
@@ -130,6 +166,9 @@ struct ForStatement {
     VariableExpression loopVar;
     ExpressionPtr collection;
     StatementList body;
+    bool parallel{false};      // PARALLEL FOR: iterations run side by side, each in a context of its own
+    ExpressionPtr maxParallel; // MAX n of a PARALLEL FOR; null for the default
+    bool readOnlyBody{false};  // set by resolveCalls() when the body and its callees can only read
 };
 
 struct Statement {
@@ -142,6 +181,7 @@ struct Statement {
                               VariableDeclarationStatement,
                               BatchStatement,
                               ThrowStatement,
+                              EmitStatement,
                               TryCatchStatement,
                               SqlStatement,
                               IfStatement,
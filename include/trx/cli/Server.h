@@ -14,6 +14,9 @@ struct ServeOptions {
     std::optional<std::string> routine;
     trx::runtime::DatabaseConfig dbConfig;
     size_t threadCount{std::thread::hardware_concurrency()};
+    size_t poolMinConnections{1};
+    size_t poolMaxConnections{0}; // 0 = one connection per worker thread
+    int keepAliveTimeoutSeconds{5}; // Idle time before a keep-alive connection is closed; 0 disables keep-alive
 };
 
 int runServer(const std::vector<std::filesystem::path> &sourcePaths, ServeOptions options);
@@ -25,6 +25,7 @@ public:
     void addInclude(std::string name, const ast::SourceLocation &location);
     void addConstant(std::string name, double value, const ast::SourceLocation &location);
     void addConstant(std::string name, std::string value, const ast::SourceLocation &location);
+    void addConstant(std::string name, bool value, const ast::SourceLocation &location);
     void addRecord(ast::RecordDecl record);
     void addProcedure(ast::ProcedureDecl procedure);
     void addExternalProcedure(ast::ExternalProcedureDecl externalProcedure);
@@ -27,7 +27,7 @@ private:
 
     diagnostics::DiagnosticEngine diagnostics_{};
     ParserContext context_;
-    std::string currentFile_{};
+    std::string_view currentFile_{};
 };
 
 } // namespace trx::parsing
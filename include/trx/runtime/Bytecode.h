@@ -0,0 +1,107 @@
+#pragma once
+
+#include "trx/ast/Nodes.h"
+#include "trx/runtime/JsonValue.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * Register machine instructions for routine bodies. Operands a/b/c are register
+ * numbers, pool indexes or jump targets depending on the opcode (see compileProcedure).
+ */
+enum class OpCode : std::uint8_t {
+    LoadConst,     // r[a] = constants[b]
+    LoadSlot,      // r[a] = frame[b], falling back to variables[c] while the slot is unbound
+    LoadVar,       // r[a] = value of variables[b]
+    LoadSqlCode,   // r[a] = SQLCODE
+    StoreSlot,     // frame[b] = move(r[a]), falling back to variables[c] while the slot is unbound
+    StoreVar,      // target of variables[b] = move(r[a])
+    BindSlot,      // declare local frame[b] = move(r[a])
+    Positive,      // r[a] = +r[b]
+    Negate,        // r[a] = -r[b]
+    Not,           // r[a] = !r[b]
+    Add,           // r[a] = r[b] op r[c], for every binary operator from Add to Or
+    Subtract,
+    Multiply,
+    Divide,
+    Modulo,
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    And,
+    Or,
+    RoundScale,    // r[a] rounded to b decimals when it is a number: DECIMAL(p,s) arithmetic (see checkTypes)
+    NewObject,     // r[a] = {}
+    SetField,      // r[a][keys[b]] = move(r[c])
+    NewArray,      // r[a] = []
+    Push,          // r[a].push_back(move(r[b]))
+    Builtin,       // r[a] = builtin expressions[b]
+    EvalTree,      // r[a] = expressions[b] evaluated by the tree-walker (calls, SQL fragments)
+    Jump,          // pc = a
+    JumpIfNotTrue, // if r[a] is not boolean true: pc = b
+    JumpIfEqual,   // if r[a] == r[b]: pc = c
+    LoopGuard,     // ++r[a]; throws past the WHILE iteration limit
+    ForInit,       // r[a] must be an array; r[a + 1] = 0
+    ForNext,       // if r[a + 1] < size(r[a]): target of variables[b] = r[a][r[a + 1]++] else pc = c
+    ForInitVar,    // variables[b] must be an array; r[a] = its size, r[a + 1] = 0
+    ForNextVar,    // as ForNext over the list stored in variables[b + 1], read in place and capped at r[a] items
+    TryBegin,      // push handler: catch into variables[a] (or none when a == noOperand), resume at b
+    TryEnd,        // pop the innermost handler
+    Throw,         // THROW r[a]
+    Return,        // RETURN r[a], or RETURN without a value when a == noOperand
+    ReturnSlot,    // RETURN frame[a], moved out of the frame; variables[b] while the slot is unbound
+    ExecSql,       // run statements[a] through the SQL executor
+    ExecStatement  // run statements[a] with the tree-walker
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t a{0};
+    std::uint32_t b{0};
+    std::uint32_t c{0};
+};
+
+inline constexpr std::uint32_t noOperand = UINT32_MAX;
+
+/**
+ * Compiled form of one routine body. Pools point into the AST, which must outlive
+ * the program; the program itself is immutable and shared between forked interpreters.
+ */
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<JsonValue> constants;
+    std::vector<std::string> keys;                             // object literal property names
+    std::vector<const ast::VariableExpression *> variables;
+    std::vector<ast::ExpressionPtr> expressions;
+    std::vector<const ast::Statement *> statements;
+    std::uint32_t registerCount{0};
+};
+
+/**
+ * Lower a routine body to bytecode. Control flow, arithmetic, literals, variable
+ * access and SQL statements get their own instructions; statements without one
+ * (SORT, SYSTEM, bare declarations, ...) are delegated to the tree-walker.
+ * Requires resolveFrameSlots() to have run on the procedure.
+ */
+std::shared_ptr<const Program> compileProcedure(const ast::ProcedureDecl &procedure);
+
+/**
+ * Human-readable listing of a program, one instruction per line.
+ */
+std::string disassemble(const Program &program);
+
+/**
+ * Hash of a program's code, constants, keys and register count. Code compiled ahead
+ * of time from a program only runs in place of a program with the same fingerprint.
+ */
+std::string fingerprint(const Program &program);
+
+} // namespace trx::runtime
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "trx/runtime/DatabaseDriver.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * Sizing and lifetime settings for a connection pool.
+ */
+struct ConnectionPoolConfig {
+    std::size_t minConnections{1};                   // Opened eagerly and never pruned
+    std::size_t maxConnections{8};                   // Upper bound on open connections
+    std::chrono::milliseconds idleTimeout{300000};   // Idle connections above the minimum are closed after this
+    std::chrono::milliseconds checkoutTimeout{5000}; // How long checkout waits for a free connection
+    std::chrono::milliseconds healthCheckInterval{30000}; // Idle connections older than this are pinged before reuse
+};
+
+/**
+ * Thread-safe pool of database connections created from a single configuration.
+ * Connections are handed out exclusively with checkout() and handed back with checkin().
+ */
+class ConnectionPool {
+public:
+    using ConnectionFactory = std::function<std::unique_ptr<DatabaseDriver>()>;
+
+    struct Stats {
+        std::size_t open{0};
+        std::size_t idle{0};
+        std::size_t inUse{0};
+        std::size_t created{0};
+        std::size_t discarded{0};
+        std::size_t waits{0};
+    };
+
+    ConnectionPool(DatabaseConfig config, ConnectionPoolConfig poolConfig = {});
+    ConnectionPool(ConnectionFactory factory, ConnectionPoolConfig poolConfig = {});
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    /**
+     * Open the minimum number of connections. Safe to call more than once.
+     */
+    void initialize();
+
+    /**
+     * Take an initialized connection out of the pool, opening a new one if the pool
+     * is below its maximum size. Blocks up to checkoutTimeout when all connections are in use.
+     * @return Exclusive connection; hand it back with checkin()
+     */
+    std::unique_ptr<DatabaseDriver> checkout();
+
+    /**
+     * Return a connection to the pool.
+     * @param connection Connection obtained from checkout()
+     * @param reusable false if the connection is broken and must be closed
+     */
+    void checkin(std::unique_ptr<DatabaseDriver> connection, bool reusable = true);
+
+    Stats stats() const;
+    const ConnectionPoolConfig &config() const { return poolConfig_; }
+
+    /**
+     * Statement cache counters added up over every connection the pool has opened.
+     * A connection's counters are folded in when it is checked in or passed to
+     * recordStatementCacheStats(), so work on a checked-out connection shows up late.
+     */
+    StatementCacheStats statementCacheStats() const;
+
+    /**
+     * Fold the statement cache counters of a checked-out connection into the pool totals.
+     * Must be called by the thread that holds the connection.
+     */
+    void recordStatementCacheStats(const DatabaseDriver &connection);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleConnection {
+        std::unique_ptr<DatabaseDriver> driver;
+        Clock::time_point lastUsed;
+    };
+
+    std::unique_ptr<DatabaseDriver> openConnection();
+    void pruneIdleLocked(Clock::time_point now, std::vector<std::unique_ptr<DatabaseDriver>> &closed);
+    void recordStatementCacheStatsLocked(const DatabaseDriver *connection, const StatementCacheStats &current);
+
+    ConnectionFactory factory_;
+    ConnectionPoolConfig poolConfig_;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<IdleConnection> idle_; // Most recently used at the back
+    std::size_t open_{0};
+    std::size_t inUse_{0};
+    std::size_t created_{0};
+    std::size_t discarded_{0};
+    std::size_t waits_{0};
+    bool initialized_{false};
+    StatementCacheStats statementCache_; // hits, misses and evictions of every connection so far
+    std::unordered_map<const DatabaseDriver *, StatementCacheStats> reportedStatementCaches_; // last counters seen per open connection
+};
+
+/**
+ * DatabaseDriver that borrows connections from a ConnectionPool.
+ * A connection is checked out for the duration of a transaction (and while cursors are
+ * open); statements outside a transaction borrow one for a single call.
+ */
+class PooledDatabaseDriver : public DatabaseDriver {
+public:
+    explicit PooledDatabaseDriver(std::shared_ptr<ConnectionPool> pool);
+    ~PooledDatabaseDriver() override;
+
+    void initialize() override;
+    void executeSql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    std::vector<std::size_t> executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) override;
+    bool queueSql(const std::string& sql, const std::vector<SqlParameter>& params) override;
+    bool syncQueued() override;
+    std::vector<std::vector<SqlValue>> querySql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) override;
+    void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void openDeclaredCursor(const std::string& name) override;
+    void openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params = {}) override;
+    bool cursorNext(const std::string& name) override;
+    std::vector<SqlValue> cursorGetRow(const std::string& name) override;
+    void closeCursor(const std::string& name) override;
+    void createOrMigrateTable(const std::string& tableName, const std::vector<TableColumn>& columns) override;
+    std::vector<TableColumn> getTableSchema(const std::string& tableName) override;
+    std::optional<std::string> schemaVersion() override;
+    void beginTransaction() override;
+    void beginReadOnlyTransaction() override;
+    void commitTransaction() override;
+    void rollbackTransaction() override;
+    bool isInTransaction() override;
+    bool ping() override;
+    void setDeadline(const Deadline& deadline) override;
+    StatementCacheStats statementCacheStats() const override;
+    std::unique_ptr<DatabaseDriver> openSibling() override;
+
+    ConnectionPool &pool() const { return *pool_; }
+
+private:
+    DatabaseDriver &connection();
+    void release(bool reusable);
+    void releaseIfIdle();
+    void discardConnection();
+
+    template <typename Fn>
+    auto withConnection(Fn &&fn) -> decltype(fn(std::declval<DatabaseDriver &>()));
+
+    std::shared_ptr<ConnectionPool> pool_;
+    std::unique_ptr<DatabaseDriver> connection_;
+    std::set<std::string> openCursors_;
+    bool inTransaction_{false};
+    bool queued_{false}; // the connection has queued statements; kept until syncQueued()
+    Deadline deadline_;  // applied to whichever connection is borrowed
+};
+
+} // namespace trx::runtime
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "trx/runtime/Deadline.h"
 #include "trx/runtime/JsonValue.h"
+#include "trx/runtime/StatementCache.h"
 
+#include <cstddef>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -17,6 +22,10 @@ struct SqlParameter {
     SqlValue value;
 };
 
+// Receives one result row; the row buffer is reused and only valid during the call.
+// Return false to stop reading further rows.
+using RowCallback = std::function<bool(const std::vector<SqlValue>& row)>;
+
 struct TableColumn {
     std::string name;
     std::string typeName;
@@ -47,6 +56,43 @@ public:
      */
     virtual void executeSql(const std::string& sql, const std::vector<SqlParameter>& params = {}) = 0;
 
+    /**
+     * Execute one statement once per parameter set, as a bulk operation where the backend supports it.
+     * Each set behaves like a separate executeSql call: a failing set does not stop the remaining ones.
+     * The default implementation loops over executeSql; drivers override it to reuse one prepared
+     * statement and avoid a round trip per set.
+     * @param sql The SQL statement to execute (INSERT, UPDATE, DELETE)
+     * @param paramSets Parameters to bind, one vector per execution
+     * @return Indexes of the parameter sets that failed, in ascending order
+     */
+    virtual std::vector<std::size_t> executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) {
+        std::vector<std::size_t> failed;
+        for (std::size_t i = 0; i < paramSets.size(); ++i) {
+            try {
+                executeSql(sql, paramSets[i]);
+            } catch (const std::exception&) {
+                failed.push_back(i);
+            }
+        }
+        return failed;
+    }
+
+    /**
+     * Send a statement that doesn't return results without waiting for its outcome, when the
+     * driver is configured to. Any later call on the driver waits for queued statements first.
+     * The default implementation queues nothing.
+     * @param sql The SQL statement to send (INSERT, UPDATE, DELETE)
+     * @param params Parameters to bind to the statement
+     * @return true if the statement was queued; false if the caller should run it with executeSql
+     */
+    virtual bool queueSql(const std::string& /*sql*/, const std::vector<SqlParameter>& /*params*/) { return false; }
+
+    /**
+     * Wait for every statement sent with queueSql.
+     * @return false if the last statement queued failed, even when another call already waited for it
+     */
+    virtual bool syncQueued() { return true; }
+
     /**
      * Execute a SELECT statement and return results.
      * @param sql The SELECT SQL statement
@@ -55,6 +101,36 @@ public:
      */
     virtual std::vector<std::vector<SqlValue>> querySql(const std::string& sql, const std::vector<SqlParameter>& params = {}) = 0;
 
+    /**
+     * Execute a SELECT statement and stream its rows to a callback without materializing the result.
+     * The default implementation falls back to querySql; drivers override it to read row by row.
+     * @param sql The SELECT SQL statement
+     * @param params Parameters to bind
+     * @param onRow Called for each row until it returns false
+     */
+    virtual void queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) {
+        for (const auto& row : querySql(sql, params)) {
+            if (!onRow(row)) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * Execute a SELECT statement and return only its first row.
+     * @param sql The SELECT SQL statement
+     * @param params Parameters to bind
+     * @return First row, or std::nullopt if the query matched nothing
+     */
+    std::optional<std::vector<SqlValue>> queryFirstRow(const std::string& sql, const std::vector<SqlParameter>& params = {}) {
+        std::optional<std::vector<SqlValue>> first;
+        queryRows(sql, params, [&](const std::vector<SqlValue>& row) {
+            first = row;
+            return false;
+        });
+        return first;
+    }
+
     /**
      * Prepare a cursor for iterative access.
      * @param name Cursor name
@@ -63,6 +139,17 @@ public:
      */
     virtual void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) = 0;
 
+    /**
+     * Prepare a cursor that UPDATE or DELETE ... WHERE CURRENT OF statements target.
+     * Drivers that prefetch rows keep such a cursor on the row last fetched instead.
+     * @param name Cursor name
+     * @param sql The SELECT SQL statement
+     * @param params Parameters to bind
+     */
+    virtual void openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) {
+        openCursor(name, sql, params);
+    }
+
     /**
      * Open a previously declared cursor.
      * @param name Cursor name
@@ -110,6 +197,12 @@ public:
      */
     virtual std::vector<TableColumn> getTableSchema(const std::string& tableName) = 0;
 
+    /**
+     * Fingerprint of every table definition in the database, read in one query.
+     * @return A string that changes whenever a table does, or std::nullopt if the driver has none
+     */
+    virtual std::optional<std::string> schemaVersion() { return std::nullopt; }
+
     /**
      * Check if currently in a transaction.
      * @return true if in a transaction, false otherwise
@@ -121,6 +214,12 @@ public:
      */
     virtual void beginTransaction() = 0;
 
+    /**
+     * Begin a transaction that only reads, for routines that need one to keep cursors open.
+     * The default implementation begins an ordinary transaction.
+     */
+    virtual void beginReadOnlyTransaction() { beginTransaction(); }
+
     /**
      * Commit a transaction.
      */
@@ -130,8 +229,44 @@ public:
      * Rollback a transaction.
      */
     virtual void rollbackTransaction() = 0;
+
+    /**
+     * Check that the connection is still usable.
+     * @return true if a trivial query succeeds, false otherwise
+     */
+    virtual bool ping() {
+        try {
+            querySql("SELECT 1");
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    /**
+     * Bound the statements run from now on by |deadline|; an unset deadline lifts the bound.
+     * Each statement is given what is left of it and stopped, where the backend allows,
+     * when it passes; a stopped statement fails like any other SQL error.
+     * The default implementation ignores the deadline.
+     */
+    virtual void setDeadline(const Deadline& /*deadline*/) {}
+
+    /**
+     * Counters of the driver's prepared-statement cache.
+     * @return Cache statistics; all zero for drivers without a cache
+     */
+    virtual StatementCacheStats statementCacheStats() const { return {}; }
+
+    /**
+     * Open another driver on the same database that uses connections of its own, for work
+     * running alongside this driver on another thread. The default implementation has none.
+     * @return The new driver, not yet initialized, or nullptr if the driver cannot open one
+     */
+    virtual std::unique_ptr<DatabaseDriver> openSibling() { return nullptr; }
 };
 
+class SqlStatistics;
+
 /**
  * Factory function to create database drivers.
  */
@@ -154,6 +289,16 @@ struct DatabaseConfig {
     std::string username;
     std::string password;
     std::string databaseName;
+    std::size_t statementCacheSize{64}; // Prepared statements kept per connection; 0 disables the cache
+    std::size_t cursorFetchSize{500};   // Rows prefetched per cursor round trip; 1 fetches row by row
+    std::vector<std::string> replicas;  // Read replicas (connection strings, or paths for SQLite) for read-only routines
+    bool pipelineWrites{false};         // PostgreSQL: queue INSERT/UPDATE/DELETE in pipeline mode until a result is needed
+    bool sqliteWal{false};              // SQLite: WAL journal, so readers run alongside the one writer
+    bool readOnly{false};               // SQLite: open the connection with SQLITE_OPEN_READONLY
+    int sqliteBusyTimeoutMs{5000};      // SQLite: how long a statement waits for a competing writer
+    std::size_t sqliteMmapSize{0};      // SQLite: bytes of the file read through mmap; 0 reads through the page cache
+    std::size_t sqliteCacheSize{0};     // SQLite: KiB of page cache per connection; 0 keeps SQLite's default
+    std::shared_ptr<SqlStatistics> sqlStatistics; // When set, every driver made from this config records its statements here
 };
 
 /**
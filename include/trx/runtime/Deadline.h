@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace trx::runtime {
+
+/**
+ * The time by which a request must be answered, or none. A routine checks it between
+ * statements; SQL statements and HTTP calls are given what is left of it.
+ */
+class Deadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Deadline() = default; // no deadline
+
+    static Deadline at(Clock::time_point when) {
+        Deadline deadline;
+        deadline.when_ = when;
+        deadline.set_ = true;
+        return deadline;
+    }
+    static Deadline after(std::chrono::duration<double> budget) {
+        return at(Clock::now() + std::chrono::duration_cast<Clock::duration>(budget));
+    }
+
+    bool isSet() const { return set_; }
+    bool expired() const { return set_ && Clock::now() >= when_; }
+    Clock::time_point when() const { return when_; }
+
+    // Time left, rounded up and zero once it has passed; only meaningful when isSet()
+    std::chrono::milliseconds remaining() const {
+        return std::max(std::chrono::ceil<std::chrono::milliseconds>(when_ - Clock::now()), std::chrono::milliseconds::zero());
+    }
+
+    // Whichever of the two comes first; an unset deadline never does
+    Deadline earliest(const Deadline &other) const {
+        if (!other.set_) {
+            return *this;
+        }
+        return !set_ || other.when_ < when_ ? other : *this;
+    }
+
+    bool operator==(const Deadline &other) const { return set_ == other.set_ && (!set_ || when_ == other.when_); }
+
+private:
+    Clock::time_point when_{};
+    bool set_{false};
+};
+
+/**
+ * Raised in a routine still running when its deadline passes. It is not a TrxException,
+ * so TRY ... CATCH cannot keep a routine going past its deadline; the server answers
+ * the request with 504 Gateway Timeout.
+ */
+class DeadlineExceeded : public std::runtime_error {
+public:
+    DeadlineExceeded() : std::runtime_error("Deadline exceeded") {}
+};
+
+} // namespace trx::runtime
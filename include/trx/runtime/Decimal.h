@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cmath>
+#include <iterator>
+
+namespace trx::runtime {
+
+/**
+ * |value| rounded to |scale| decimals: the double nearest the exact DECIMAL(p,s) result,
+ * so amounts keep their cents through a sum (0.1 + 0.2 gives 0.3). Numbers are doubles,
+ * so the rounding goes through a scaled integer; a value too large to keep |scale|
+ * decimals in 53 bits, or a scale of 0 or less, leaves |value| as it is.
+ */
+inline double roundToScale(double value, int scale) {
+    static constexpr double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    if (scale <= 0 || scale >= static_cast<int>(std::size(powers))) {
+        return value;
+    }
+    const double scaled = value * powers[scale];
+    if (!(std::fabs(scaled) < 9007199254740992.0)) { // 2^53; also false for NaN
+        return value;
+    }
+    return std::round(scaled) / powers[scale];
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <poll.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * Waits until one of |fds| is ready for its events, as poll() does, or |timeout| passes;
+ * a negative timeout waits as long as it takes. Returns how many descriptors are ready,
+ * with their revents set, or 0 after a timeout. Called from a fiber, it suspends the fiber
+ * and its thread runs other fibers in the meantime; anywhere else it blocks in poll().
+ */
+int waitForIo(std::span<pollfd> fds, std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+// One descriptor: the events it is ready for, or 0 after a timeout
+short waitForIo(int fd, short events, std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+/**
+ * Runs tasks as fibers on the thread that owns the scheduler, each on a stack of its own.
+ * A fiber runs until it finishes or waits in waitForIo(); the thread then carries on with
+ * other fibers, and poll() resumes the waiting one once its descriptors are ready. Fibers
+ * never move between threads, so thread-local state stays where it was, except the current
+ * RequestArena, which each fiber keeps for itself.
+ *
+ * A fiber must not hold a lock while it waits: another fiber on the same thread that
+ * blocks on that lock stops the thread, and the holder with it.
+ */
+class FiberScheduler {
+public:
+    explicit FiberScheduler(std::size_t stackBytes = 1024 * 1024);
+    ~FiberScheduler(); // fibers still waiting are abandoned, not resumed
+
+    FiberScheduler(const FiberScheduler &) = delete;
+    FiberScheduler &operator=(const FiberScheduler &) = delete;
+
+    // Runs |task| in a new fiber until it finishes or first waits; the task must not throw
+    void spawn(std::function<void()> task);
+
+    // Fibers started and not yet finished
+    std::size_t active() const { return active_; }
+
+    // Waits up to |timeout| (negative: no limit) for the descriptors of waiting fibers or
+    // a wake(), then resumes every fiber whose wait is over
+    void poll(std::chrono::milliseconds timeout);
+
+    // Makes a poll() in progress return early; may be called from any thread
+    void wake();
+
+    // Index of the fiber running on the calling thread, below the most fibers its scheduler
+    // has had active at once and unique among those active; npos outside a fiber
+    static std::size_t currentFiberIndex();
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    struct Fiber;
+    struct Context;
+
+private:
+    friend int waitForIo(std::span<pollfd> fds, std::chrono::milliseconds timeout);
+
+    int suspend(Fiber &fiber, std::span<pollfd> fds, std::chrono::milliseconds timeout);
+    void resume(Fiber &fiber);
+    static void entry();
+
+    std::size_t stackBytes_;
+    int epollFd_{-1};
+    int wakeFd_{-1};
+    std::size_t active_{0};
+    std::vector<std::unique_ptr<Fiber>> fibers_; // every fiber created, running or kept for reuse
+    std::vector<Fiber *> idle_;                  // finished fibers whose stacks can be reused
+    std::vector<Fiber *> waiting_;
+    std::vector<std::size_t> freeIndices_;
+    std::size_t nextIndex_{0};
+    std::unique_ptr<Context> context_; // the thread's own context while a fiber runs
+};
+
+} // namespace trx::runtime
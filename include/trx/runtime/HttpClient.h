@@ -0,0 +1,39 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace trx::runtime {
+
+// One outbound request, as described by the configuration object given to http()
+struct HttpCall {
+    std::string method;                         // upper case; only POST, PUT and PATCH send the body
+    std::string url;
+    std::map<std::string, std::string> headers;
+    std::string body;
+    long timeoutMs{30000};
+};
+
+struct HttpReply {
+    long status{0};
+    std::string body;
+    std::string error; // why no response was received; empty when one was
+};
+
+/**
+ * Outbound HTTP on libcurl. Each thread keeps a multi handle, a share handle and a
+ * few idle easy handles, so open connections, resolved names and TLS sessions carry
+ * over from one call to the next on that thread instead of being set up per request.
+ */
+class HttpClient {
+public:
+    // Run one request; throws std::runtime_error when no response was received
+    static HttpReply perform(const HttpCall &call);
+
+    // Run the requests concurrently and return their replies in the same order; a
+    // request that received no response comes back with error set instead of throwing
+    static std::vector<HttpReply> performAll(const std::vector<HttpCall> &calls);
+};
+
+} // namespace trx::runtime
@@ -3,43 +3,166 @@
 #include "trx/ast/Nodes.h"
 #include "trx/runtime/JsonValue.h"
 #include "trx/runtime/DatabaseDriver.h"
+#include "trx/runtime/Tracing.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 #include <map>
+#include <string>
+#include <unordered_map>
+
+class ThreadPool;
 
 namespace trx::runtime {
 
+class JobQueue;
+class NativeLibrary;
+class Profiler;
+struct Program;
+struct RecordLayout;
+
+namespace native {
+struct Routine;
+} // namespace native
+
 class Interpreter {
 public:
+    // Receives each value an EMIT statement produces
+    using EmitSink = std::function<void(const JsonValue &)>;
+
     explicit Interpreter(const ast::Module &module, std::unique_ptr<DatabaseDriver> dbDriver = nullptr);
     ~Interpreter();
 
-    std::optional<JsonValue> execute(const std::string &procedureName, const JsonValue &input);
-    std::optional<JsonValue> execute(const std::string &procedureName, const JsonValue &input, const std::map<std::string, std::string> &pathParams);
-    std::optional<JsonValue> execute(const ast::ProcedureDecl *procedure, const JsonValue &input, const std::map<std::string, std::string> &pathParams = {});
+    // Creates a sibling interpreter for another worker thread. The sibling shares
+    // this interpreter's (read-only) module and resolved declarations, starts from
+    // a copy of the current global variables and owns its own database driver.
+    // Table migrations and module-level statements are not re-run.
+    std::unique_ptr<Interpreter> fork(std::unique_ptr<DatabaseDriver> dbDriver) const;
+
+    // The input is taken by value: pass an rvalue to hand it to the routine without a copy
+    std::optional<JsonValue> execute(const std::string &procedureName, JsonValue input);
+    std::optional<JsonValue> execute(const std::string &procedureName, JsonValue input, const std::map<std::string, std::string> &pathParams);
+    std::optional<JsonValue> execute(const ast::ProcedureDecl *procedure, JsonValue input, const std::map<std::string, std::string> &pathParams = {});
 
     const ast::ProcedureDecl* getRoutine(const std::string &name) const;
     const ast::RecordDecl* getRecord(const std::string &name) const;
+    // Layout shared by values of a TYPE, or null when no such TYPE is declared
+    std::shared_ptr<const RecordShape> recordShape(const std::string &name) const;
+    // How a request body is decoded into a TYPE, or null when no such TYPE is declared
+    std::shared_ptr<const RecordLayout> recordLayout(const std::string &name) const;
+    // Bytecode of a routine of this module, or null when it runs on the tree-walker
+    const Program *programFor(const ast::ProcedureDecl *procedure) const;
+
+    // Runs routines on the code |library| compiled for them ahead of time, where that was
+    // compiled from their current bytecode; the others stay interpreted, and their names
+    // are returned. Null goes back to interpreting everything. Copied by fork().
+    std::vector<std::string> setNativeLibrary(std::shared_ptr<const NativeLibrary> library);
+    // Compiled code a routine runs on, or null when it is interpreted
+    const native::Routine *nativeRoutine(const ast::ProcedureDecl *procedure) const;
+
+    // Where EMIT sends values while a routine streams its response. Without a sink,
+    // execute() answers an emitting routine with the list of values it emitted.
+    void setEmitSink(EmitSink sink) { emitSink_ = std::move(sink); }
+    const EmitSink &emitSink() const { return emitSink_; }
+
+    // Where routines that only read run when no transaction is open, typically a pool of
+    // read replicas; without one they run on the main driver. Not copied by fork().
+    void setReplicaDriver(std::unique_ptr<DatabaseDriver> driver);
+
+    // Times routine calls, statements, SQL and HTTP calls into the profiler while set;
+    // routines then run on the tree-walker. Not copied by fork().
+    void setProfiler(Profiler *profiler) { profiler_ = profiler; }
+    Profiler *profiler() const { return profiler_; }
 
-    // Accessors for SQL operations
+    // Records spans for routine calls, SQL statements and HTTP calls while set. Spans
+    // nest under traceContext(), which the caller sets to the incoming request's context
+    // and which outgoing HTTP calls propagate as `traceparent`. Neither is copied by fork().
+    void setTracer(Tracer *tracer) { tracer_ = tracer; }
+    Tracer *tracer() const { return tracer_; }
+    TraceContext &traceContext() { return traceContext_; }
+
+    // The time by which the running routine must finish; none while unset. A routine past
+    // it raises DeadlineExceeded at its next statement, and SQL statements and HTTP calls
+    // are given only what is left of it. A routine declared with TIMEOUT runs under the
+    // earlier of the two. Not copied by fork().
+    void setDeadline(const Deadline &deadline);
+    const Deadline &deadline() const { return deadline_; }
+    void checkDeadline() const {
+        if (deadline_.expired()) {
+            throw DeadlineExceeded();
+        }
+    }
+
+    // Where BATCH queues jobs; BATCH fails while none is set. Copied by fork().
+    void setJobQueue(JobQueue *queue) { jobQueue_ = queue; }
+    JobQueue *jobQueue() const { return jobQueue_; }
+
+    // Accessors for SQL operations; the replica driver while a read-only routine runs on it
     DatabaseDriver& db() const { return *dbDriver_; }
 
     // Access to global variables
     std::unordered_map<std::string, JsonValue>& globalVariables() { return globalVariables_; }
     const std::unordered_map<std::string, JsonValue>& globalVariables() const { return globalVariables_; }
 
-    // SQLCODE access
-    double getSqlCode() const { return sqlCode_; }
-    void setSqlCode(double code) { sqlCode_ = code; }
+    // SQLCODE access. After a statement the driver queued, reading it waits for the outcome.
+    double getSqlCode() {
+        if (sqlCodeQueued_) {
+            syncSql();
+        }
+        return sqlCode_;
+    }
+    void setSqlCode(double code) {
+        sqlCode_ = code;
+        sqlCodeQueued_ = false;
+    }
+    // SQLCODE is that of the statement just queued on |driver|
+    void setSqlCodeQueued(DatabaseDriver &driver) {
+        queuedDriver_ = &driver;
+        sqlCodeQueued_ = true;
+    }
+    bool sqlCodeQueued() const { return sqlCodeQueued_; }
+
+    // Waits for the statements queued on a driver, before anything else uses it
+    void syncSql();
+    DatabaseDriver *queuedDriver() const { return queuedDriver_; }
+
+    // Whether SQL that may write ran since the routine's transaction began, in which case
+    // other connections cannot see all it has done
+    void noteWrite() { wrote_ = true; }
+    bool wroteInTransaction() const { return wrote_ && dbDriver_->isInTransaction(); }
 
 private:
+    class RoutineScope;
+
+    Interpreter(const Interpreter &prototype, std::unique_ptr<DatabaseDriver> dbDriver);
+
     const ast::Module &module_;
     double sqlCode_{0.0}; // SQL return code
+    bool sqlCodeQueued_{false}; // sqlCode_ waits for queuedDriver_
+    DatabaseDriver *queuedDriver_{nullptr}; // may have statements queued by queueSql
+    bool wrote_{false}; // cleared when RoutineScope begins or ends a transaction
     std::unordered_map<std::string, const ast::ProcedureDecl*> routines_;
     std::unordered_map<std::string, const ast::RecordDecl*> records_;
+    std::unordered_map<std::string, std::shared_ptr<const RecordShape>> shapes_;
+    std::unordered_map<std::string, std::shared_ptr<const RecordLayout>> layouts_;
+    std::unordered_map<const ast::ProcedureDecl*, std::shared_ptr<const Program>> programs_; // bytecode, shared with forks
+    std::shared_ptr<const NativeLibrary> nativeLibrary_; // keeps the code natives_ points into loaded
+    std::unordered_map<const ast::ProcedureDecl*, const native::Routine*> natives_;
     std::unordered_map<std::string, JsonValue> globalVariables_;
     std::unique_ptr<DatabaseDriver> dbDriver_;
+    std::unique_ptr<DatabaseDriver> replicaDriver_; // swapped with dbDriver_ while a routine runs on it
+    bool onReplica_{false};
+    EmitSink emitSink_; // not copied by fork()
+    Profiler *profiler_{nullptr};
+    Tracer *tracer_{nullptr};
+    TraceContext traceContext_;
+    Deadline deadline_;
+    JobQueue *jobQueue_{nullptr};
 };
 
+// Workers shared by every PARALLEL FOR and parallel batch in the process. They run as
+// fibers, so a task waiting on SQL or HTTP leaves its thread to another.
+::ThreadPool &parallelPool();
+
 } // namespace trx::runtime
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "trx/runtime/DatabaseDriver.h"
+#include "trx/runtime/JsonValue.h"
+#include "trx/runtime/LatencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::runtime {
+
+struct JobQueueOptions {
+    std::size_t workers{2};
+    std::size_t maxPending{10000};                     // queued and running jobs beyond which BATCH fails
+    int maxAttempts{5};                                // runs of a failing job before it is marked failed
+    std::chrono::milliseconds retryDelay{1000};        // before the first retry; doubles with every attempt
+    std::chrono::milliseconds maxRetryDelay{300000};
+    std::chrono::milliseconds pollInterval{500};       // idle workers look for due jobs this often
+    std::chrono::milliseconds lease{600000};           // a job still running after this is taken over by another worker
+};
+
+// One row of the job table
+struct JobStatus {
+    std::string id;
+    std::string routine;
+    std::string state; // queued, running, succeeded or failed
+    int attempts{0};
+    JsonValue argument;
+    JsonValue result;      // what the routine returned once it succeeded
+    std::string lastError; // why the latest attempt failed
+    std::int64_t createdAt{0}; // milliseconds since the epoch
+    std::int64_t updatedAt{0};
+    std::int64_t runAfter{0};  // a queued job does not run before this
+
+    JsonValue toJson() const;
+};
+
+/**
+ * Runs routines queued by BATCH on worker threads of their own, off the request path.
+ * Jobs are rows of the `trx_jobs` table: enqueue() inserts one through the caller's
+ * driver, so a job queued inside a transaction only exists once that commits, and every
+ * process serving the database shares the queue. A worker claims a due job with a
+ * conditional UPDATE that only one claimant can win, runs it through the Runner and
+ * records the outcome; a failing job is queued again with an exponential delay until it
+ * has used up its attempts. Each worker keeps a connection of its own for this.
+ */
+class JobQueue {
+public:
+    // Runs |routine| with |argument| on behalf of worker |worker| and returns its result;
+    // throws when the job failed
+    using Runner = std::function<JsonValue(std::size_t worker, const std::string &routine, const JsonValue &argument)>;
+    using DriverFactory = std::function<std::unique_ptr<DatabaseDriver>()>;
+
+    struct Stats {
+        std::uint64_t enqueued{0};  // including jobs whose transaction later rolled back
+        std::uint64_t rejected{0};  // BATCH calls refused because the queue was full
+        std::uint64_t succeeded{0};
+        std::uint64_t retried{0};   // failed attempts queued again
+        std::uint64_t failed{0};    // jobs that used up their attempts
+        std::size_t running{0};
+    };
+
+    // |makeDriver| opens the connections workers and status() use
+    JobQueue(JobQueueOptions options, DriverFactory makeDriver);
+    ~JobQueue(); // stops the workers after the jobs they are running
+
+    JobQueue(const JobQueue &) = delete;
+    JobQueue &operator=(const JobQueue &) = delete;
+
+    // Creates the job table when it is missing; called once before jobs are queued
+    static void createTable(DatabaseDriver &db);
+
+    void start(Runner runner);
+    void stop();
+
+    // Queues |routine| through |db| and returns the job's id; throws when the queue is full
+    std::string enqueue(DatabaseDriver &db, const std::string &routine, const JsonValue &argument);
+
+    // The job with |id|, read on a connection of its own; std::nullopt when there is none
+    std::optional<JobStatus> status(const std::string &id);
+
+    Stats stats() const;
+
+    // How long jobs ran, successful or not, as series 0
+    const LatencyHistogram &runTimes() const { return runTimes_; }
+
+    const JobQueueOptions &options() const { return options_; }
+
+private:
+    struct Claim {
+        std::string id;
+        std::string owner;
+        std::string routine;
+        JsonValue argument;
+        int attempts{0};
+    };
+
+    void work(std::size_t worker);
+    std::optional<Claim> claim(DatabaseDriver &db);
+    void finish(DatabaseDriver &db, const Claim &job, const std::optional<JsonValue> &result, const std::string &error);
+    std::chrono::milliseconds retryDelay(int attempts) const;
+
+    JobQueueOptions options_;
+    DriverFactory makeDriver_;
+    Runner runner_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_{false};
+    std::vector<std::thread> workers_;
+    LatencyHistogram runTimes_;
+    std::atomic<std::uint64_t> enqueued_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    std::atomic<std::uint64_t> succeeded_{0};
+    std::atomic<std::uint64_t> retried_{0};
+    std::atomic<std::uint64_t> failed_{0};
+    std::atomic<std::size_t> running_{0};
+};
+
+} // namespace trx::runtime
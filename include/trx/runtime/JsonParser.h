@@ -0,0 +1,82 @@
+#pragma once
+
+#include "trx/runtime/JsonValue.h"
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace trx::runtime {
+
+struct JsonParseError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * How a declared TYPE is read from a request body: which JSON key fills each field
+ * of the record and what kind of value it must hold. Built once per TYPE by the
+ * interpreter; nested TYPEs point at each other's layouts.
+ */
+struct RecordLayout {
+    enum class Kind { Any, Number, String, Boolean, Record };
+
+    struct Field {
+        std::string key;                     // lowercased JSON name
+        Kind kind{Kind::Any};
+        bool list{false};                    // a JSON array of values of that kind
+        const RecordLayout *record{nullptr}; // layout of a nested TYPE when kind is Record
+    };
+
+    std::shared_ptr<const RecordShape> shape;
+    std::vector<Field> fields; // in shape order
+};
+
+/**
+ * Parser for request bodies. Strings and whitespace are scanned 16 bytes at a time
+ * where SSE2 is available, and unescaped runs are copied in one piece. Object keys
+ * are lowercased so field lookups are case-insensitive. Containers are allocated
+ * from |resource|, normally the request arena.
+ */
+class JsonParser {
+public:
+    explicit JsonParser(std::string_view text, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    // Any JSON value
+    JsonValue parse();
+
+    // An object decoded straight into a record of |layout|. Keys without a field are
+    // skipped without building their values; a value of the wrong kind is reported
+    // with its path, e.g. "Field 'lines[2].qty' must be a number".
+    JsonValue parse(const RecordLayout &layout);
+
+private:
+    struct Path;
+
+    JsonValue parseValue(std::size_t depth);
+    JsonValue parseObject(std::size_t depth);
+    JsonValue parseArray(std::size_t depth);
+    JsonValue parseRecord(const RecordLayout &layout, const Path *path, std::size_t depth);
+    JsonValue parseField(const RecordLayout::Field &field, const Path *path, std::size_t depth);
+    JsonValue parseKind(const RecordLayout::Field &field, const Path *path, std::size_t depth);
+    JsonValue parseNumber();
+    std::string parseString();
+    std::string_view parseKey(std::string &scratch);
+    void skipValue(std::size_t depth);
+    void skipString();
+    void skipWhitespace();
+    void expect(char expected);
+    char peek() const;
+    bool consumeLiteral(std::string_view literal);
+    void decodeEscape(std::string &output);
+    [[noreturn]] void kindError(const RecordLayout::Field &field, const Path *path) const;
+
+    const char *position_;
+    const char *end_;
+    std::pmr::memory_resource *resource_;
+};
+
+} // namespace trx::runtime
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
 #include <ostream>
 #include <string>
 #include <unordered_map>
@@ -9,10 +11,34 @@
 
 namespace trx::runtime {
 
+/**
+ * Field layout of one TYPE declaration, shared by every record value of that type.
+ */
+struct RecordShape {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::string name;
+    std::vector<std::string> keys; // lowercased field names in declaration order
+
+    std::size_t indexOf(const std::string &key) const;
+};
+
 struct JsonValue {
-    using Object = std::unordered_map<std::string, JsonValue>;
-    using Array = std::vector<JsonValue>;
-    using Storage = std::variant<std::nullptr_t, bool, double, std::string, Object, Array>;
+    /**
+     * A value of a declared TYPE: its fields in shape order. Behaves as a JSON object;
+     * it becomes an Object when a field outside the shape is added or asObject() is
+     * called on a mutable value.
+     */
+    struct Record {
+        std::shared_ptr<const RecordShape> shape;
+        std::vector<JsonValue> fields;
+    };
+
+    // Containers take a memory resource so a request can build its values in an arena
+    // (see RequestArena); copies always allocate from the default resource.
+    using Object = std::pmr::unordered_map<std::string, JsonValue>;
+    using Array = std::pmr::vector<JsonValue>;
+    using Storage = std::variant<std::nullptr_t, bool, double, std::string, Object, Array, Record>;
 
     Storage data;
 
@@ -24,6 +50,7 @@ struct JsonValue {
     JsonValue(const char *value);
     explicit JsonValue(Object value);
     explicit JsonValue(Array value);
+    explicit JsonValue(Record value);
 
     JsonValue(const JsonValue &) = default;
     JsonValue(JsonValue &&) = default;
@@ -32,11 +59,40 @@ struct JsonValue {
 
     static JsonValue object();
     static JsonValue array();
+    // A record with every field of the shape set to null
+    static JsonValue record(std::shared_ptr<const RecordShape> shape);
 
+    // True for both object representations, Object and Record
     bool isObject() const;
+    // Converts a Record to an Object in place
     Object &asObject();
+    // Requires the Object representation
     const Object &asObject() const;
 
+    bool isRecord() const;
+    Record &asRecord();
+    const Record &asRecord() const;
+
+    /**
+     * Field lookup on either object representation; nullptr when the field is missing
+     * or this is not an object.
+     * @param hint Expected index of the field in a record's shape, checked before searching
+     */
+    const JsonValue *findField(const std::string &key, std::size_t hint = RecordShape::npos) const;
+    JsonValue *findField(const std::string &key, std::size_t hint = RecordShape::npos);
+
+    /**
+     * Field of an object, inserted as null when missing. Adding a field a record's
+     * shape does not have converts the record to an Object first.
+     */
+    JsonValue &field(const std::string &key, std::size_t hint = RecordShape::npos);
+
+    /**
+     * Calls fn(key, value) for each field of an object: shape order for a record,
+     * unspecified for an Object. Does nothing for other values.
+     */
+    template<class Fn> void forEachField(Fn &&fn) const;
+
     bool isArray() const;
     Array &asArray();
     const Array &asArray() const;
@@ -53,6 +109,19 @@ struct JsonValue {
 
 bool operator==(const JsonValue &lhs, const JsonValue &rhs);
 bool operator!=(const JsonValue &lhs, const JsonValue &rhs);
+bool operator==(const JsonValue::Record &lhs, const JsonValue::Record &rhs);
+
+template<class Fn> void JsonValue::forEachField(Fn &&fn) const {
+    if (const auto *record = std::get_if<Record>(&data)) {
+        for (std::size_t i = 0; i < record->fields.size(); ++i) {
+            fn(record->shape->keys[i], record->fields[i]);
+        }
+    } else if (const auto *object = std::get_if<Object>(&data)) {
+        for (const auto &[key, value] : *object) {
+            fn(key, value);
+        }
+    }
+}
 
 template<class... Ts> struct Overloaded : Ts... { using Ts::operator()...; };
 template<class... Ts> Overloaded(Ts...) -> Overloaded<Ts...>;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "trx/runtime/JsonValue.h"
+
+#include <string>
+#include <string_view>
+
+namespace trx::runtime {
+
+/**
+ * Appends JSON text to a caller-owned buffer. Runs of characters that need no
+ * escaping are copied in one piece and numbers are formatted with std::to_chars,
+ * so a value is written without temporary strings; clearing the buffer between
+ * uses keeps its capacity.
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string &out) : out_{out} {}
+
+    void write(const JsonValue &value);
+
+    // A quoted, escaped string
+    void writeString(std::string_view text);
+
+    // Up to 15 significant digits; non-finite numbers have no JSON form and are written as null
+    void writeNumber(double number);
+
+    static std::string toString(const JsonValue &value);
+
+private:
+    std::string &out_;
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * Fixed-bucket latency histograms in the Prometheus model, one per series index.
+ * Observations go to a per-thread shard with relaxed atomic increments only, so
+ * recording never takes a lock; snapshot() merges the shards at scrape time.
+ * A series' counters are allocated by the first observation that needs them.
+ */
+class LatencyHistogram {
+public:
+    // Upper bounds in seconds; a final +Inf bucket catches everything above
+    static constexpr std::array<double, 14> bucketBounds{
+        0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+
+    struct Snapshot {
+        std::array<std::uint64_t, bucketBounds.size() + 1> buckets{}; // cumulative counts, last is +Inf
+        std::uint64_t count{0};
+        double sum{0.0}; // seconds
+    };
+
+    LatencyHistogram(std::size_t seriesCount, std::size_t shardCount);
+    ~LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    std::size_t seriesCount() const { return seriesCount_; }
+
+    /**
+     * Record one duration. Shards are meant to be written by a single thread each,
+     * but sharing one between threads is safe.
+     * @param shard Shard index; values past the last shard use the last one
+     * @param series Series index below seriesCount()
+     * @param seconds Observed duration
+     */
+    void observe(std::size_t shard, std::size_t series, double seconds);
+
+    /**
+     * Totals of one series across all shards.
+     */
+    Snapshot snapshot(std::size_t series) const;
+
+private:
+    struct Counters {
+        std::array<std::atomic<std::uint64_t>, bucketBounds.size() + 1> buckets{}; // per bucket, not cumulative
+        std::atomic<std::uint64_t> sumNanos{0};
+    };
+
+    struct Shard {
+        explicit Shard(std::size_t seriesCount) : series(new std::atomic<Counters *>[seriesCount]) {}
+        std::unique_ptr<std::atomic<Counters *>[]> series;
+    };
+
+    std::size_t seriesCount_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "trx/runtime/JsonValue.h"
+
+#include <cstddef>
+#include <string>
+
+namespace trx::runtime {
+
+// Lists at least this long are aggregated on several threads
+inline constexpr std::size_t parallelAggregateThreshold = 64 * 1024;
+
+// What sum(), min(), max() and avg() report for one numeric field of a list
+struct FieldSummary {
+    std::size_t count{0}; // items holding a number in the field
+    double sum{0.0};
+    double min{0.0};
+    double max{0.0};
+};
+
+/**
+ * Summarize the numbers in |field| across |items|. |field| is a dotted path, as for
+ * index_by(); an empty path reads the items themselves. The field is gathered into one
+ * contiguous buffer and reduced in a single pass. Items where it is missing or null are
+ * skipped; any other value that is not a number is an error.
+ */
+FieldSummary summarizeField(const JsonValue::Array &items, const std::string &field,
+                            std::size_t parallelThreshold = parallelAggregateThreshold);
+
+// count_if(list, "field", value): how many items hold |value| in |field|; a null |value|
+// counts the items where the field is missing or null
+std::size_t countMatching(const JsonValue::Array &items, const std::string &field, const JsonValue &value,
+                          std::size_t parallelThreshold = parallelAggregateThreshold);
+
+} // namespace trx::runtime
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "trx/runtime/JsonValue.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace trx::runtime {
+
+// A dotted field path ("owner.id"), matched lowercased as variable paths are, read from
+// item after item; records sharing a shape reuse the field positions. An empty path reads
+// the item itself.
+class FieldPath {
+public:
+    explicit FieldPath(const std::string &field);
+
+    // The value at the path, or nullptr when it is missing or null
+    const JsonValue *read(const JsonValue &item);
+
+private:
+    std::vector<std::string> segments_;
+    std::vector<const RecordShape *> shapes_;
+    std::vector<std::size_t> hints_;
+};
+
+// Text under which an item is filed and found again: a string as it is, any other
+// value as JSON writes it, so the number 7 and the string "7" share a key
+std::string indexKey(const JsonValue &value);
+
+/**
+ * index_by(list, "field"): an object mapping the key of each item's field to the item,
+ * so lookup() finds an item without scanning the list. The first item with a key wins.
+ * |field| may be a dotted path through nested values; items where it is missing or
+ * null are left out. Field names are matched lowercased, as variable paths are.
+ */
+JsonValue indexBy(const JsonValue::Array &items, const std::string &field);
+JsonValue indexBy(JsonValue::Array &&items, const std::string &field);
+
+// group_by(list, "field"): as indexBy(), but each key maps to the list of every item
+// that has it, in list order
+JsonValue groupBy(const JsonValue::Array &items, const std::string &field);
+JsonValue groupBy(JsonValue::Array &&items, const std::string &field);
+
+// lookup(index, key): what indexBy() or groupBy() filed under |key|, or nullptr when nothing was
+const JsonValue *lookup(const JsonValue &index, const JsonValue &key);
+
+} // namespace trx::runtime
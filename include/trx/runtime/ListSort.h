@@ -0,0 +1,24 @@
+#pragma once
+
+#include "trx/ast/Statements.h"
+#include "trx/runtime/JsonValue.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace trx::runtime {
+
+// Lists at least this long are sorted on several threads
+inline constexpr std::size_t parallelSortThreshold = 32 * 1024;
+
+/**
+ * Sort the items of a list by the fields named in |keys|, the first key deciding
+ * first. Each key is read once per item before sorting, so comparisons never look
+ * up a field. Numbers sort before strings; items whose field is missing or holds
+ * anything else sort last in either direction. Items that compare equal on every
+ * key keep their original order.
+ */
+void sortByKeys(JsonValue::Array &items, const std::vector<trx::ast::SortKey> &keys,
+                std::size_t parallelThreshold = parallelSortThreshold);
+
+} // namespace trx::runtime
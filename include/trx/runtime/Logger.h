@@ -0,0 +1,141 @@
+#pragma once
+
+#include "trx/runtime/JsonValue.h"
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace trx::runtime {
+
+enum class LogLevel : std::uint8_t { Debug, Info, Warn, Error, Off };
+
+// "debug", "info", "warn", "error" or "off"
+std::optional<LogLevel> parseLogLevel(std::string_view name);
+const char *logLevelName(LogLevel level);
+
+/**
+ * One key/value pair of a log record. A field only refers to its value; nothing is
+ * copied or formatted unless the record's level is enabled. Keys must outlive the
+ * logger, which in practice means string literals.
+ */
+struct LogField {
+    enum class Kind : std::uint8_t { Text, Integer, Number, Boolean, Json };
+
+    LogField(const char *key, std::string_view value) : key{key}, kind{Kind::Text}, text{value} {}
+    LogField(const char *key, const std::string &value) : key{key}, kind{Kind::Text}, text{value} {}
+    LogField(const char *key, const char *value) : key{key}, kind{Kind::Text}, text{value} {}
+    template <std::integral T>
+        requires(!std::same_as<T, bool>)
+    LogField(const char *key, T value) : key{key}, kind{Kind::Integer}, integer{static_cast<std::int64_t>(value)} {}
+    LogField(const char *key, double value) : key{key}, kind{Kind::Number}, number{value} {}
+    LogField(const char *key, bool value) : key{key}, kind{Kind::Boolean}, boolean{value} {}
+    LogField(const char *key, const JsonValue &value) : key{key}, kind{Kind::Json}, json{&value} {}
+
+    const char *key;
+    Kind kind;
+    std::string_view text;
+    std::int64_t integer{0};
+    double number{0.0};
+    bool boolean{false};
+    const JsonValue *json{nullptr};
+};
+
+/**
+ * Process-wide structured logger writing one JSON object per line. Each thread copies
+ * its records into a fixed-size ring buffer of its own, without locks or allocation
+ * once the ring exists, and a background thread formats and writes them in batches.
+ * When a thread's ring is full its new records are dropped and counted rather than
+ * blocking the caller.
+ *
+ * The level comes from TRX_LOG_LEVEL, or "debug" when DEBUG=true, and is "info"
+ * otherwise; checking it is one relaxed atomic load.
+ */
+class Logger {
+public:
+    // Receives batches of complete lines; standard error when unset
+    using Sink = std::function<void(std::string_view lines)>;
+
+    static Logger &instance();
+
+    static bool enabled(LogLevel level) noexcept {
+        return level >= threshold_.load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogLevel level) noexcept { threshold_.store(level, std::memory_order_relaxed); }
+    static LogLevel level() noexcept { return threshold_.load(std::memory_order_relaxed); }
+
+    // Records are written whether or not |level| is enabled; use the log*() helpers below
+    void write(LogLevel level, std::string_view message, std::initializer_list<LogField> fields = {});
+
+    // Writes every record queued so far before returning
+    void flush();
+
+    void setSink(Sink sink);
+
+    // Records lost to full ring buffers
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    struct Ring;
+
+private:
+    Logger();
+
+    Ring &threadRing();
+    void run();
+    void drain();
+
+    static void prepareFork();
+    static void parentAfterFork();
+    static void childAfterFork();
+
+    static std::atomic<LogLevel> threshold_;
+
+    std::mutex registryMutex_; // rings_, generation_ and starting the writer
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::uint64_t generation_{0}; // bumped in a forked child, whose rings start over
+    unsigned nextThread_{0};
+    bool writerStarted_{false};
+
+    std::mutex drainMutex_; // one drain at a time, and the sink with it
+    Sink sink_;
+    std::string lines_;
+
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+inline void logDebug(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    if (Logger::enabled(LogLevel::Debug)) {
+        Logger::instance().write(LogLevel::Debug, message, fields);
+    }
+}
+
+inline void logInfo(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    if (Logger::enabled(LogLevel::Info)) {
+        Logger::instance().write(LogLevel::Info, message, fields);
+    }
+}
+
+inline void logWarn(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    if (Logger::enabled(LogLevel::Warn)) {
+        Logger::instance().write(LogLevel::Warn, message, fields);
+    }
+}
+
+inline void logError(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    if (Logger::enabled(LogLevel::Error)) {
+        Logger::instance().write(LogLevel::Error, message, fields);
+    }
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "trx/runtime/Bytecode.h"
+#include "trx/runtime/Decimal.h"
+#include "trx/runtime/JsonValue.h"
+#include "trx/runtime/TrxException.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vector>
+
+/**
+ * What routines compiled ahead of time by `trx compile` are built against. The compiler
+ * translates a routine's bytecode (see Bytecode.h) into a C++ function that keeps its
+ * registers in locals, jumps with goto and does number arithmetic inline; everything
+ * else the instructions do is asked of the interpreter through a Frame, so a compiled
+ * routine behaves exactly as its bytecode would.
+ */
+namespace trx::runtime::native {
+
+// Raised whenever Frame, Routine or Module change; libraries built for another version are refused
+inline constexpr int abiVersion = 1;
+
+// Name of the function a library exports to list its routines
+inline constexpr const char *moduleSymbol = "trx_native_module";
+
+enum class Result { Normal, Returned, Thrown };
+
+// How a statement run by the interpreter finished: carry on, continue at the CATCH the
+// pc was set to, or leave the routine
+enum class Step { Next, Resume, Returned, Thrown };
+
+// A TRY block being run: where its CATCH binds the exception (noOperand for none) and resumes
+struct Handler {
+    std::uint32_t catchVariable;
+    std::uint32_t resumeAt;
+};
+
+/**
+ * One call of a compiled routine. Operands are those of the instructions the code was
+ * compiled from: variable, expression and statement numbers index the pools of the
+ * routine's current program, whose fingerprint the library was checked against.
+ */
+class Frame {
+public:
+    Frame(std::vector<std::optional<JsonValue>> &slots, std::optional<JsonValue> &returnValue,
+          const std::vector<JsonValue> &constants, const std::vector<std::string> &keys, int loopLimit)
+        : slots{slots}, returnValue{returnValue}, constants{constants}, keys{keys}, loopLimit{loopLimit} {}
+    virtual ~Frame() = default;
+
+    Frame(const Frame &) = delete;
+    Frame &operator=(const Frame &) = delete;
+
+    std::vector<std::optional<JsonValue>> &slots; // the routine's locals; unbound ones fall back to load() and store()
+    std::optional<JsonValue> &returnValue;
+    const std::vector<JsonValue> &constants;
+    const std::vector<std::string> &keys;
+    const int loopLimit; // iterations a WHILE may run
+    std::vector<Handler> handlers;
+
+    JsonValue *slot(std::uint32_t index) { return index < slots.size() && slots[index] ? &*slots[index] : nullptr; }
+
+    virtual JsonValue load(std::uint32_t variable) = 0;
+    virtual void store(std::uint32_t variable, JsonValue value) = 0;
+    virtual double sqlCode() = 0;
+    virtual JsonValue unary(OpCode op, const JsonValue &operand) = 0;
+    virtual JsonValue binary(OpCode op, const JsonValue &lhs, const JsonValue &rhs) = 0;
+    virtual JsonValue builtin(std::uint32_t expression) = 0;
+    virtual JsonValue eval(std::uint32_t expression) = 0;
+    [[noreturn]] virtual void loopExceeded() = 0;
+
+    // FOR loops, with the operands of ForInit, ForNext, ForInitVar and ForNextVar
+    virtual void forInit(JsonValue &items, JsonValue &index) = 0;
+    virtual bool forNext(const JsonValue &items, JsonValue &index, std::uint32_t variable) = 0;
+    virtual void forInitVar(std::uint32_t variable, JsonValue &size, JsonValue &index) = 0;
+    virtual bool forNextVar(const JsonValue &size, JsonValue &index, std::uint32_t variable) = 0;
+
+    // Hands |e| to the innermost handler and sets |pc| to its CATCH; false when there is none
+    virtual bool unwind(const TrxException &e, std::uint32_t &pc) = 0;
+    // THROW: as unwind(), but without a handler the value is kept for the caller
+    virtual bool raise(JsonValue value, std::uint32_t &pc) = 0;
+
+    virtual void execSql(std::uint32_t statement) = 0;
+    virtual Step exec(std::uint32_t statement, std::uint32_t &pc) = 0;
+};
+
+using Function = Result (*)(Frame &frame);
+
+struct Routine {
+    const char *name;
+    const char *fingerprint; // of the program the code was compiled from
+    Function run;
+};
+
+struct Module {
+    int abiVersion;
+    std::size_t valueSize; // sizeof(JsonValue) where the library was built
+    std::size_t count;
+    const Routine *routines;
+};
+
+} // namespace trx::runtime::native
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "trx/runtime/Native.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trx::runtime {
+
+struct NativeSource {
+    std::string name; // the routine's name, as Interpreter::getRoutine() finds it
+    const Program *program;
+};
+
+/**
+ * C++ source of a library with one function per routine, exporting them through
+ * native::moduleSymbol. Build it as a shared library against the runtime's headers.
+ */
+std::string translateRoutines(const std::vector<NativeSource> &routines);
+
+/**
+ * Routines compiled ahead of time, loaded from a shared library built from
+ * translateRoutines() output. Unloaded with the last reference.
+ */
+class NativeLibrary {
+public:
+    // Throws std::runtime_error when the library cannot be loaded or was built for another runtime
+    static std::shared_ptr<const NativeLibrary> open(const std::filesystem::path &path);
+
+    // Routines linked into the process; checked as open() checks a library's
+    explicit NativeLibrary(const native::Module &module, void *handle = nullptr);
+    ~NativeLibrary();
+
+    NativeLibrary(const NativeLibrary &) = delete;
+    NativeLibrary &operator=(const NativeLibrary &) = delete;
+
+    // Code compiled for routine |name|, or null when the library has none
+    const native::Routine *find(const std::string &name) const;
+
+    std::size_t size() const { return routines_.size(); }
+
+private:
+    void *handle_;
+    std::unordered_map<std::string, const native::Routine *> routines_;
+};
+
+} // namespace trx::runtime
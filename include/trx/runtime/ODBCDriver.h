@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace trx::runtime {
 
@@ -22,7 +23,9 @@ public:
 
     void initialize() override;
     void executeSql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    std::vector<std::size_t> executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) override;
     std::vector<std::vector<SqlValue>> querySql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) override;
     void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
     void openDeclaredCursor(const std::string& name) override;
     void openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params = {}) override;
@@ -35,6 +38,8 @@ public:
     void commitTransaction() override;
     void rollbackTransaction() override;
     bool isInTransaction() override;
+    void setDeadline(const Deadline& deadline) override;
+    StatementCacheStats statementCacheStats() const override;
 
 private:
     DatabaseConfig config_;
@@ -52,6 +57,31 @@ private:
         std::vector<SQLLEN> indicators;
     };
     std::unordered_map<std::string, ParamStorage> paramStorage_;
+
+    // Column-wise bound rowset for block cursors (SQL_ATTR_ROW_ARRAY_SIZE)
+    struct RowBlock {
+        SQLULEN arraySize{1};
+        SQLULEN rowsFetched{0};
+        SQLULEN currentRow{0}; // 1-based row within the rowset; 0 before the first fetch
+        SQLSMALLINT columns{0};
+        std::vector<char> data;       // columns x arraySize cells of columnWidth bytes
+        std::vector<SQLLEN> indicators;
+        std::vector<SQLUSMALLINT> rowStatus;
+    };
+    static constexpr SQLLEN columnWidth = 1024;
+    std::unordered_map<std::string, RowBlock> blocks_;
+
+    void prepareRowBlock(const std::string& name, SQLHSTMT stmt);
+    void bindRowBlock(RowBlock& block, SQLHSTMT stmt);
+    StatementCache<SQLHSTMT> preparedStatements_; // Reused handles for executeSql/querySql
+
+    Deadline deadline_;
+
+    SQLHSTMT acquireStatement(const std::string& sql);
+    void releaseStatement(SQLHSTMT stmt);
+    // SQLExecute, given what is left of the deadline as its query timeout
+    SQLRETURN execute(SQLHSTMT stmt);
+    void bindParameters(SQLHSTMT stmt, const std::vector<SqlParameter>& params, ParamStorage& storage);
 };
 
 } // namespace trx::runtime
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace trx::runtime {
 
@@ -20,8 +22,13 @@ public:
 
     void initialize() override;
     void executeSql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    std::vector<std::size_t> executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) override;
+    bool queueSql(const std::string& sql, const std::vector<SqlParameter>& params) override;
+    bool syncQueued() override;
     std::vector<std::vector<SqlValue>> querySql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) override;
     void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
     void openDeclaredCursor(const std::string& name) override;
     void openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params = {}) override;
     bool cursorNext(const std::string& name) override;
@@ -29,10 +36,14 @@ public:
     void closeCursor(const std::string& name) override;
     void createOrMigrateTable(const std::string& tableName, const std::vector<TableColumn>& columns) override;
     std::vector<TableColumn> getTableSchema(const std::string& tableName) override;
+    std::optional<std::string> schemaVersion() override;
     void beginTransaction() override;
+    void beginReadOnlyTransaction() override;
     void commitTransaction() override;
     void rollbackTransaction() override;
     bool isInTransaction() override;
+    void setDeadline(const Deadline& deadline) override;
+    StatementCacheStats statementCacheStats() const override;
 
 private:
     DatabaseConfig config_;
@@ -40,6 +51,50 @@ private:
     std::unordered_map<std::string, bool> cursors_; // Just track if cursor is declared
     std::unordered_map<std::string, std::string> cursorSql_; // Store original DECLARE SQL
     std::unordered_map<std::string, std::vector<SqlValue>> currentRows_;
+    std::unordered_set<std::string> positionedCursors_; // WHERE CURRENT OF targets: never prefetched
+
+    // Rows prefetched by one FETCH <n>; cursorNext serves from here before going back to the server
+    struct CursorBatch {
+        PGresult* rows{nullptr};
+        int nextRow{0};
+        int fetchSize{1};
+        bool exhausted{false}; // Last FETCH came back short: the server cursor is past the end
+        std::vector<Oid> columnTypes; // From the first FETCH
+        bool binaryResults{false};    // Every column has a binary decoder, so later FETCHes ask for binary
+    };
+    std::unordered_map<std::string, CursorBatch> batches_;
+
+    // A server-side prepared statement. Its column types are learned from its first result;
+    // from then on it asks for binary results when every column has a binary decoder.
+    struct PreparedStatement {
+        std::string name;
+        std::vector<Oid> columnTypes;
+        bool described{false};
+        bool binaryResults{false};
+    };
+    StatementCache<PreparedStatement> statements_; // SQL text -> prepared statement
+    std::vector<std::string> pendingDeallocations_; // Evicted while the transaction was aborted
+    std::size_t nextStatementId_{0};
+    std::size_t queued_{0}; // statements sent in pipeline mode whose results are unread
+    bool lastQueuedFailed_{false};
+    Deadline deadline_;
+
+    // What a statement sent now is bounded by: past the deadline only clean-up is sent
+    // (ROLLBACK, closing cursors), which is left to finish
+    Deadline statementDeadline() const;
+    // BEGIN, with a statement_timeout of what is left of the deadline
+    void begin(const char* command);
+
+    PreparedStatement* preparedStatement(const std::string& sql);
+    static void learnColumnTypes(PreparedStatement& statement, PGresult* res);
+    bool retryPrepared(const std::string& sql, PGresult* res, int attempt);
+    PGresult* execParams(const std::string& sql, const std::vector<SqlParameter>& params);
+    void declareCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params,
+                       const char* operation);
+    void deallocateStatement(const std::string& name);
+    void flushPendingDeallocations();
+    void clearBatch(const std::string& name);
+    void drainQueued();
 };
 
 } // namespace trx::runtime
\ No newline at end of file
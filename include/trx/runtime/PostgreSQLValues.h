@@ -0,0 +1,38 @@
+#pragma once
+
+#include "trx/runtime/DatabaseDriver.h"
+
+#include <cstdint>
+
+namespace trx::runtime::postgres {
+
+// Decoders of PostgreSQL binary result cells. They need nothing from libpq, so they are
+// built whether or not the PostgreSQL driver is.
+
+/**
+ * Big-endian integer of |bytes| bytes, the byte order binary values arrive in.
+ */
+std::uint64_t readBigEndian(const char* data, int bytes);
+
+inline std::int16_t readInt16(const char* data) { return static_cast<std::int16_t>(readBigEndian(data, 2)); }
+inline std::int32_t readInt32(const char* data) { return static_cast<std::int32_t>(readBigEndian(data, 4)); }
+inline std::int64_t readInt64(const char* data) { return static_cast<std::int64_t>(readBigEndian(data, 8)); }
+
+/**
+ * numeric as the nearest double; NaN and the infinities as themselves.
+ * @return SqlValue(nullptr), as for a NULL cell, when the value is cut short
+ */
+SqlValue numericValue(const char* data, int length);
+
+/**
+ * date as the text the server prints with DateStyle ISO, e.g. 2024-01-15 or 0044-03-15 BC.
+ */
+SqlValue dateValue(const char* data, int length);
+
+/**
+ * timestamp, or timestamptz when |withZone|, as the text the server prints with DateStyle
+ * ISO and TimeZone UTC, e.g. 2024-01-15 09:30:00.25 or 2024-01-15 09:30:00+00.
+ */
+SqlValue timestampValue(const char* data, int length, bool withZone);
+
+} // namespace trx::runtime::postgres
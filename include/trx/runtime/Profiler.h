@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace trx::ast {
+struct Statement;
+} // namespace trx::ast
+
+namespace trx::runtime {
+
+/**
+ * Instrumenting profiler for one interpreter thread. The interpreter opens a frame
+ * per routine call and per statement (named by its file:line), plus "[sql]" and
+ * "[http]" frames around database and HTTP calls, so time spent waiting on I/O is
+ * split out from the statement that issued it.
+ *
+ * Each frame's self time, wall clock and thread CPU, is added to the stack it ran
+ * under; folded() prints those totals in the folded-stack format flamegraph.pl and
+ * speedscope read. A profiler is not thread-safe: give each thread its own.
+ */
+class Profiler {
+public:
+    enum class Metric { Wall, Cpu };
+
+    // Opens a frame for its lifetime; does nothing without a profiler
+    class Scope {
+    public:
+        Scope(Profiler *profiler, std::string_view name) : profiler_{profiler} {
+            if (profiler_) {
+                profiler_->enter(name);
+            }
+        }
+        Scope(Profiler *profiler, const ast::Statement &statement) : profiler_{profiler} {
+            if (profiler_) {
+                profiler_->enter(profiler_->frameName(statement));
+            }
+        }
+        ~Scope() {
+            if (profiler_) {
+                profiler_->leave();
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Profiler *profiler_;
+    };
+
+    void enter(std::string_view name);
+    void leave();
+
+    /**
+     * One line per stack: the frames joined by ';', a space, and the self time spent
+     * there in microseconds. Stacks that rounded down to zero are left out.
+     */
+    std::string folded(Metric metric = Metric::Wall) const;
+
+    // Wall time spent in outermost frames, in microseconds
+    std::uint64_t totalMicros() const;
+
+    // "file:line KIND" for a statement, cached per statement
+    const std::string &frameName(const ast::Statement &statement);
+
+private:
+    struct Totals {
+        std::uint64_t wallNanos{0};
+        std::uint64_t cpuNanos{0};
+    };
+
+    struct Frame {
+        std::size_t pathLength; // length of path_ before this frame was pushed
+        std::uint64_t wallStart;
+        std::uint64_t cpuStart;
+        std::uint64_t childWall{0};
+        std::uint64_t childCpu{0};
+    };
+
+    std::string path_;
+    std::vector<Frame> frames_;
+    std::map<std::string, Totals> stacks_;
+    std::unordered_map<const ast::Statement *, std::string> names_;
+    std::uint64_t totalWallNanos_{0};
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace trx::runtime {
+
+/**
+ * Monotonic memory for the values one request builds. A worker keeps one arena and
+ * every request reuses its first block; release() hands back whatever the request
+ * took beyond that block in one step. Anything that must outlive the request has to
+ * be copied out, which JsonValue containers do onto the default resource.
+ */
+class RequestArena {
+public:
+    struct Stats {
+        std::uint64_t requests{0};      // releases, one per request
+        std::uint64_t bytes{0};         // bytes handed out to requests
+        std::uint64_t heapBytes{0};     // bytes taken from the heap beyond the reused block
+        std::uint64_t peakBytes{0};     // most bytes a single request used
+    };
+
+    explicit RequestArena(std::size_t initialBytes = 64 * 1024);
+    ~RequestArena();
+
+    RequestArena(const RequestArena &) = delete;
+    RequestArena &operator=(const RequestArena &) = delete;
+
+    std::pmr::memory_resource *resource() { return &counting_; }
+
+    // Bytes handed out since the last release
+    std::size_t bytesInUse() const { return requestBytes_; }
+
+    // Frees everything allocated since the last release and counts one request
+    void release();
+
+    // Arena of the request the calling thread is serving, or null outside of one
+    static RequestArena *current();
+
+    // Replaces the calling thread's current arena and returns the one it replaced, for
+    // schedulers that switch between requests on one thread
+    static RequestArena *exchangeCurrent(RequestArena *arena);
+
+    // Totals over every arena in the process
+    static Stats stats();
+
+    // Makes an arena current for the calling thread and releases it when the request ends
+    class Scope {
+    public:
+        explicit Scope(RequestArena &arena);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        RequestArena &arena_;
+        RequestArena *previous_;
+    };
+
+private:
+    // Counts what the monotonic resource takes from the heap once the first block is used up
+    class HeapResource : public std::pmr::memory_resource {
+    public:
+        explicit HeapResource(std::size_t &bytes) : bytes_{bytes} {}
+
+    private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+        std::size_t &bytes_;
+    };
+
+    // Counts what the request allocates from the monotonic resource
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        CountingResource(std::pmr::memory_resource &arena, std::size_t &bytes) : arena_{arena}, bytes_{bytes} {}
+
+    private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void *, std::size_t, std::size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+        std::pmr::memory_resource &arena_;
+        std::size_t &bytes_;
+    };
+
+    std::size_t requestBytes_{0};
+    std::size_t requestHeapBytes_{0};
+    std::unique_ptr<std::byte[]> block_;
+    HeapResource heap_;
+    std::pmr::monotonic_buffer_resource monotonic_;
+    CountingResource counting_;
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * In-process cache of response bodies, split into shards that each keep their own LRU
+ * list under their own lock. Entries expire after their TTL and are never served once a
+ * table they were built from has been written: every table has a generation counter,
+ * an entry remembers the generations it saw before its routine ran, and a write bumps
+ * the counters instead of searching the shards for entries to drop.
+ */
+class ResponseCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Value {
+        int status{200};
+        std::string contentType;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+    };
+
+    struct Stats {
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+        std::uint64_t invalidations{0}; // entries dropped because a table they read was written
+        std::uint64_t evictions{0};     // entries dropped to stay within the size limit
+        std::size_t entries{0};
+    };
+
+    // Generation counters of a set of tables, resolved once per routine
+    struct Tables {
+        std::vector<std::atomic<std::uint64_t> *> generations;
+    };
+
+    explicit ResponseCache(std::size_t maxEntries = 4096, std::size_t shardCount = 16);
+
+    ResponseCache(const ResponseCache &) = delete;
+    ResponseCache &operator=(const ResponseCache &) = delete;
+
+    // Counters for |names|, created on first use and kept for the life of the cache
+    Tables tables(const std::vector<std::string> &names);
+
+    // Current generations of |tables|, taken before running the routine whose result is stored
+    std::vector<std::uint64_t> snapshot(const Tables &tables) const;
+
+    // The entry for |key| unless it expired or one of |tables| was written since it was built
+    std::optional<Value> find(const std::string &key, const Tables &tables);
+
+    void store(std::string key, Value value, Clock::duration ttl, std::vector<std::uint64_t> snapshot);
+
+    // Marks every entry built from one of |tables| as stale
+    void invalidate(const Tables &tables);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        Value value;
+        Clock::time_point expires;
+        std::vector<std::uint64_t> generations;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries; // most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    Shard &shardFor(const std::string &key);
+
+    std::size_t maxEntriesPerShard_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::mutex tablesMutex_;
+    std::unordered_map<std::string, std::unique_ptr<std::atomic<std::uint64_t>>> generations_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+};
+
+} // namespace trx::runtime
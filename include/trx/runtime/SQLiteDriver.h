@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace trx::runtime {
 
@@ -19,7 +20,9 @@ public:
 
     void initialize() override;
     void executeSql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    std::vector<std::size_t> executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) override;
     std::vector<std::vector<SqlValue>> querySql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) override;
     void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
     void openDeclaredCursor(const std::string& name) override;
     void openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params = {}) override;
@@ -28,17 +31,27 @@ public:
     void closeCursor(const std::string& name) override;
     void createOrMigrateTable(const std::string& tableName, const std::vector<TableColumn>& columns) override;
     std::vector<TableColumn> getTableSchema(const std::string& tableName) override;
+    std::optional<std::string> schemaVersion() override;
     void beginTransaction() override;
+    void beginReadOnlyTransaction() override;
     void commitTransaction() override;
     void rollbackTransaction() override;
     bool isInTransaction() override;
+    void setDeadline(const Deadline& deadline) override;
+    StatementCacheStats statementCacheStats() const override;
 
 private:
     DatabaseConfig config_;
     sqlite3* db_;
     std::unordered_map<std::string, sqlite3_stmt*> cursors_;
     std::unordered_map<std::string, std::string> cursorSql_; // Store original cursor SQL
-    
+    std::vector<sqlite3_stmt*> evictedBusy_; // Evicted from the cache while still being stepped
+    StatementCache<sqlite3_stmt*> statements_; // Prepared statements for executeSql/querySql
+    Deadline deadline_;
+
+    sqlite3_stmt* acquireStatement(const std::string& sql, bool& cached);
+    void releaseStatement(sqlite3_stmt* stmt, bool cached);
+    void finalizeCachedStatement(sqlite3_stmt* stmt);
     void bindParameters(sqlite3_stmt* stmt, const std::vector<SqlParameter>& params);
 };
 
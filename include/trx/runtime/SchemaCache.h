@@ -0,0 +1,38 @@
+#pragma once
+
+#include "trx/runtime/DatabaseDriver.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * Columns of `TYPE ... FROM TABLE` records kept on disk between starts, so a warm
+ * start resolves them without one schema query per table. The file records the
+ * database's schema version it was filled under and is ignored once that changes.
+ */
+class SchemaCache {
+public:
+    // Loads |file| when it exists and was written under |version|; otherwise starts empty
+    SchemaCache(std::filesystem::path file, std::string version);
+
+    // Columns stored for |table|, or null
+    const std::vector<TableColumn> *find(const std::string &table) const;
+
+    void store(const std::string &table, std::vector<TableColumn> columns);
+
+    // Writes the file again if anything was stored. The cache only saves time, so a
+    // file that cannot be written is reported through the return value and otherwise ignored.
+    bool save() const;
+
+private:
+    std::filesystem::path file_;
+    std::string version_;
+    std::unordered_map<std::string, std::vector<TableColumn>> tables_;
+    bool dirty_{false};
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "trx/runtime/DatabaseDriver.h"
+#include "trx/runtime/LatencyHistogram.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace trx::runtime {
+
+/**
+ * Latency, row and error counts per SQL statement, shared by every connection that
+ * InstrumentedDriver wraps. Statements are grouped by their normalized text, with
+ * literals replaced by '?', so the same query with different constants counts once.
+ * Statements that take longer than the slow-query threshold are logged with their
+ * literals and bind parameters redacted.
+ */
+class SqlStatistics {
+public:
+    struct Options {
+        std::chrono::microseconds slowQueryThreshold{0}; // 0 logs nothing
+        std::size_t maxStatements{1000};                  // distinct texts tracked; the rest count as "(other)"
+        std::function<void(const std::string &)> log;     // where slow queries go; standard error by default
+    };
+
+    struct StatementStats {
+        std::string statement;
+        std::uint64_t calls{0};
+        std::uint64_t errors{0};
+        std::uint64_t rows{0}; // rows returned to the caller
+        double totalSeconds{0.0};
+        double maxSeconds{0.0};
+        // Per LatencyHistogram::bucketBounds, not cumulative; the last bucket is +Inf
+        std::array<std::uint64_t, LatencyHistogram::bucketBounds.size() + 1> buckets{};
+        std::string lastError;
+
+        // Upper bound, in seconds, of the bucket where quantile |q| falls; infinity past the last bound
+        double quantile(double q) const;
+    };
+
+    struct Entry;
+
+    explicit SqlStatistics(Options options);
+    SqlStatistics();
+    ~SqlStatistics();
+
+    SqlStatistics(const SqlStatistics &) = delete;
+    SqlStatistics &operator=(const SqlStatistics &) = delete;
+
+    // The counters of a statement, created on first use; stays valid as long as this object
+    Entry &statement(std::string_view sql);
+
+    /**
+     * Add one timed driver call to a statement.
+     * @param newCall False for work that continues an earlier call, such as fetching from a cursor
+     * @param error Message of the exception the driver threw, or null
+     * @param params Bind parameters, described by name and type only in the slow-query log
+     */
+    void record(Entry &entry, std::chrono::nanoseconds elapsed, std::size_t rows, bool newCall,
+                const char *error = nullptr, const std::vector<SqlParameter> *params = nullptr);
+
+    // The |count| statements with the most total time, slowest first
+    std::vector<StatementStats> top(std::size_t count) const;
+
+    // Whitespace collapsed, string and number literals replaced by '?' and IN lists by "IN (...)"
+    static std::string normalize(std::string_view sql);
+
+private:
+    Options options_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries_;
+    std::unique_ptr<Entry> other_;
+};
+
+/**
+ * Driver decorator that times every call of the driver it wraps and records it in a
+ * SqlStatistics. createDatabaseDriver() adds it when DatabaseConfig::sqlStatistics is set.
+ */
+class InstrumentedDriver : public DatabaseDriver {
+public:
+    InstrumentedDriver(std::unique_ptr<DatabaseDriver> driver, std::shared_ptr<SqlStatistics> statistics);
+
+    void initialize() override;
+    void executeSql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    std::vector<std::size_t> executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) override;
+    bool queueSql(const std::string& sql, const std::vector<SqlParameter>& params) override;
+    bool syncQueued() override;
+    std::vector<std::vector<SqlValue>> querySql(const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) override;
+    void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params = {}) override;
+    void openDeclaredCursor(const std::string& name) override;
+    void openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params = {}) override;
+    bool cursorNext(const std::string& name) override;
+    std::vector<SqlValue> cursorGetRow(const std::string& name) override;
+    void closeCursor(const std::string& name) override;
+    void createOrMigrateTable(const std::string& tableName, const std::vector<TableColumn>& columns) override;
+    std::vector<TableColumn> getTableSchema(const std::string& tableName) override;
+    std::optional<std::string> schemaVersion() override;
+    void beginTransaction() override;
+    void beginReadOnlyTransaction() override;
+    void commitTransaction() override;
+    void rollbackTransaction() override;
+    bool isInTransaction() override;
+    bool ping() override;
+    void setDeadline(const Deadline& deadline) override;
+    StatementCacheStats statementCacheStats() const override;
+    std::unique_ptr<DatabaseDriver> openSibling() override;
+
+private:
+    void openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params, bool positioned);
+
+    std::unique_ptr<DatabaseDriver> driver_;
+    std::shared_ptr<SqlStatistics> statistics_;
+    std::unordered_map<std::string, SqlStatistics::Entry *> cursors_; // statement each open cursor runs
+    SqlStatistics::Entry *begin_;
+    SqlStatistics::Entry *commit_;
+    SqlStatistics::Entry *rollback_;
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace trx::runtime {
+
+/**
+ * Hit/miss counters of a prepared-statement cache.
+ */
+struct StatementCacheStats {
+    std::size_t hits{0};
+    std::size_t misses{0};
+    std::size_t evictions{0};
+    std::size_t size{0};
+    std::size_t capacity{0};
+};
+
+/**
+ * Bounded LRU cache of prepared statement handles keyed by SQL text.
+ * Each driver connection owns one; it is not thread-safe. Evicted handles are
+ * passed to the finalizer, as are all remaining handles on clear() or destruction.
+ */
+template <typename Handle>
+class StatementCache {
+public:
+    using Finalizer = std::function<void(Handle &)>;
+
+    StatementCache(std::size_t capacity, Finalizer finalizer)
+        : capacity_(capacity), finalizer_(std::move(finalizer)) {}
+
+    ~StatementCache() { clear(); }
+
+    StatementCache(const StatementCache &) = delete;
+    StatementCache &operator=(const StatementCache &) = delete;
+
+    bool enabled() const { return capacity_ > 0; }
+
+    /**
+     * Look up a prepared handle and mark it most recently used.
+     * @return Pointer to the cached handle, or nullptr on a miss
+     */
+    Handle *find(const std::string &sql) {
+        auto it = index_.find(sql);
+        if (it == index_.end()) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        ++stats_.hits;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->second;
+    }
+
+    /**
+     * Add a freshly prepared handle, evicting the least recently used entry when full.
+     * @return Reference to the stored handle
+     */
+    Handle &insert(const std::string &sql, Handle handle) {
+        erase(sql);
+        while (!entries_.empty() && entries_.size() >= capacity_) {
+            auto &victim = entries_.back();
+            finalizer_(victim.second);
+            index_.erase(victim.first);
+            entries_.pop_back();
+            ++stats_.evictions;
+        }
+        entries_.emplace_front(sql, std::move(handle));
+        index_[sql] = entries_.begin();
+        return entries_.front().second;
+    }
+
+    /**
+     * Drop and finalize the handle for the given SQL, if cached.
+     */
+    void erase(const std::string &sql) {
+        auto it = index_.find(sql);
+        if (it == index_.end()) {
+            return;
+        }
+        finalizer_(it->second->second);
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    void clear() {
+        for (auto &entry : entries_) {
+            finalizer_(entry.second);
+        }
+        entries_.clear();
+        index_.clear();
+    }
+
+    StatementCacheStats stats() const {
+        auto result = stats_;
+        result.size = entries_.size();
+        result.capacity = capacity_;
+        return result;
+    }
+
+private:
+    using Entry = std::pair<std::string, Handle>;
+
+    std::size_t capacity_;
+    Finalizer finalizer_;
+    std::list<Entry> entries_; // Most recently used first
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+    StatementCacheStats stats_;
+};
+
+} // namespace trx::runtime
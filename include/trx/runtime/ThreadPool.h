@@ -1,35 +1,113 @@
-
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
-#include <vector>
-#include <queue>
-#include <thread>
-#include <mutex>
+#include "trx/runtime/LatencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trx::runtime {
+class FiberScheduler;
+}
 
+// Workers with one task deque each. Tasks submitted from outside the pool are spread
+// over the deques round-robin, a task submitted by a worker goes to its own deque, and
+// a worker whose deque is empty takes the oldest task of the next non-empty one, so
+// submitters and workers rarely meet on the same lock.
+//
+// With more than one fiber per worker, each worker runs up to that many tasks at once as
+// fibers (see trx/runtime/Fiber.h): while one waits for I/O in waitForIo(), its worker
+// starts or resumes another instead of sitting idle.
 class ThreadPool {
 public:
-    ThreadPool(size_t);
+    struct Stats {
+        size_t queued{0};      // tasks waiting for a worker
+        uint64_t rejected{0};  // tryEnqueueTask() calls turned away by the queue limit
+        uint64_t stolen{0};    // tasks run by a worker other than the one they were queued for
+    };
+
+    // @param threads Number of workers, at least one
+    // @param maxQueued Most tasks tryEnqueueTask() lets wait at once; 0 for no limit
+    // @param fibersPerWorker Most tasks a worker runs at once; 1 runs them one after another without fibers
+    explicit ThreadPool(size_t threads, size_t maxQueued = 0, size_t fibersPerWorker = 1);
     ~ThreadPool();
 
+    size_t size() const { return workers.size(); }
+
+    // Index of the pool worker running the calling thread, or npos when the
+    // caller is not a pool worker. Lets callers keep per-worker state.
+    static size_t currentWorkerIndex();
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Index, below size() * fibersPerWorker, that no other task running at the same time
+    // has; npos when the caller is not a pool task. Lets tasks keep per-task state when
+    // several share a worker thread.
+    static size_t currentTaskSlot();
+
+    // Queues the task whatever the queue limit
     template <class F>
     void enqueueTask(F&& f) {
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            tasks.emplace(std::forward<F>(f));
-        }
-        condition.notify_one();
+        push(std::function<void()>(std::forward<F>(f)), false);
+    }
+
+    // Queues the task unless maxQueued tasks are already waiting
+    // @return false when the task was rejected
+    template <class F>
+    bool tryEnqueueTask(F&& f) {
+        return push(std::function<void()>(std::forward<F>(f)), true);
     }
 
+    Stats stats() const;
+
+    // Seconds each task waited between being queued and starting, one shard per worker
+    const trx::runtime::LatencyHistogram &waitTimes() const { return waitTimes_; }
+
 private:
+    struct Task {
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // A worker running fibers; push() wakes one with room when its fibers are all waiting
+    struct FiberWorker {
+        std::atomic<bool> hasRoom{false};
+        trx::runtime::FiberScheduler *scheduler{nullptr};
+    };
+
+    bool push(std::function<void()> run, bool bounded);
+    bool take(size_t worker, Task &task);
+    void runTasks(size_t worker);
+    void runFibers(size_t worker);
+    void observeWait(size_t worker, const Task &task);
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    size_t maxQueued;
+    size_t fibersPerWorker;
+    std::vector<std::unique_ptr<FiberWorker>> fiberWorkers;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> stolen{0};
+    trx::runtime::LatencyHistogram waitTimes_;
 
-    std::mutex queueMutex;
+    std::mutex sleepMutex;
     std::condition_variable condition;
     bool stop;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace trx::runtime {
+
+// W3C trace context: the trace and the span that new spans are children of
+struct TraceContext {
+    std::array<std::uint8_t, 16> traceId{};
+    std::array<std::uint8_t, 8> spanId{};
+    bool sampled{false};
+
+    bool valid() const;
+
+    // A `traceparent` header value; std::nullopt when it is malformed
+    static std::optional<TraceContext> parse(std::string_view traceparent);
+    // "00-<trace id>-<span id>-<flags>"
+    std::string traceparent() const;
+};
+
+enum class SpanKind { Internal = 1, Server = 2, Client = 3 };
+
+using SpanAttribute = std::pair<std::string, std::variant<std::string, std::int64_t>>;
+
+// A finished span, as handed to the exporter
+struct SpanData {
+    TraceContext context;
+    std::array<std::uint8_t, 8> parentSpanId{}; // all zero for a root span
+    std::string name;
+    SpanKind kind{SpanKind::Internal};
+    std::uint64_t startUnixNanos{0};
+    std::uint64_t endUnixNanos{0};
+    std::vector<SpanAttribute> attributes;
+    std::optional<std::string> error; // status ERROR with this message
+};
+
+struct TracerOptions {
+    std::string endpoint;             // OTLP/HTTP traces URL, e.g. http://collector:4318/v1/traces
+    std::string serviceName{"trx"};
+    double sampleRatio{1.0};          // share of new traces recorded; incoming ones follow their sampled flag
+    std::size_t maxQueuedSpans{8192}; // spans finished beyond this while the exporter is behind are dropped
+    std::size_t maxBatchSize{512};
+    std::chrono::milliseconds exportInterval{1000};
+};
+
+/**
+ * Collects finished spans and exports them in OTLP/HTTP JSON batches from a background
+ * thread. submit() only appends to a bounded queue, so a slow or unreachable collector
+ * costs requests nothing but the spans it drops. A batch goes out once it is full or the
+ * export interval has passed; the destructor sends what is left.
+ */
+class Tracer {
+public:
+    // Sends one encoded batch; returns whether the collector accepted it
+    using Exporter = std::function<bool(const std::string &body)>;
+
+    explicit Tracer(TracerOptions options, Exporter exporter = nullptr);
+    ~Tracer();
+
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+    void submit(SpanData span);
+
+    // Whether a new trace, with no sampled parent to follow, is recorded
+    bool sampleRoot();
+
+    std::uint64_t exportedSpans() const { return exported_.load(std::memory_order_relaxed); }
+    std::uint64_t droppedSpans() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // An ExportTraceServiceRequest in the OTLP JSON encoding
+    static std::string encode(const std::string &serviceName, const std::vector<SpanData> &spans);
+
+private:
+    void run();
+
+    TracerOptions options_;
+    Exporter exporter_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<SpanData> queue_;
+    bool stopping_{false};
+    std::atomic<std::uint64_t> exported_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::thread thread_;
+};
+
+/**
+ * One span, recorded while it is in scope. It starts as a child of |current| and
+ * becomes the current context until it ends, so spans opened meanwhile nest under it.
+ * Without a tracer, or when the trace is not sampled, nothing is recorded and
+ * |current| is left alone for propagation.
+ */
+class Span {
+public:
+    Span(Tracer *tracer, TraceContext &current, std::string name, SpanKind kind = SpanKind::Internal);
+    ~Span();
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+    bool recording() const { return tracer_ != nullptr; }
+
+    void setAttribute(std::string key, std::string value);
+    void setAttribute(std::string key, std::int64_t value);
+    void setError(std::string message);
+
+private:
+    Tracer *tracer_{nullptr};
+    TraceContext *current_{nullptr};
+    TraceContext previous_;
+    SpanData data_;
+};
+
+} // namespace trx::runtime
@@ -0,0 +1,46 @@
+#include "trx/ast/Arena.h"
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace trx::ast {
+
+namespace {
+thread_local std::shared_ptr<NodeArena> currentArena;
+} // namespace
+
+NodeArena::~NodeArena() {
+    for (auto *chunk : chunks_) {
+        ::operator delete(chunk);
+    }
+}
+
+void *NodeArena::allocate(std::size_t size, std::size_t alignment) {
+    auto address = reinterpret_cast<std::uintptr_t>(next_);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+    if (next_ == nullptr || padding + size > static_cast<std::size_t>(end_ - next_)) {
+        // A node larger than a chunk gets a chunk of its own; operator new aligns for any node
+        const std::size_t capacity = size > chunkSize ? size : chunkSize;
+        chunks_.push_back(static_cast<std::byte *>(::operator new(capacity)));
+        next_ = chunks_.back();
+        end_ = next_ + capacity;
+        padding = 0;
+    }
+    void *result = next_ + padding;
+    next_ += padding + size;
+    used_ += padding + size;
+    return result;
+}
+
+const std::shared_ptr<NodeArena> &NodeArena::current() noexcept {
+    return currentArena;
+}
+
+NodeArena::Scope::Scope(std::shared_ptr<NodeArena> arena) : previous_{std::exchange(currentArena, std::move(arena))} {}
+
+NodeArena::Scope::~Scope() {
+    currentArena = std::move(previous_);
+}
+
+} // namespace trx::ast
@@ -1,15 +1,44 @@
 #include "trx/ast/Expressions.h"
 
+#include "trx/ast/Arena.h"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <mutex>
+#include <set>
 #include <utility>
 
 namespace trx::ast {
 
 namespace {
 ExpressionPtr make(Expression::Node node) {
-    return std::make_shared<Expression>(Expression{.node = std::move(node)});
+    return makeExpression(Expression{.node = std::move(node)});
 }
 } // namespace
 
+Symbol Symbol::of(std::string_view identifier) {
+    std::string folded(identifier);
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    // Symbols are kept in nodes that outlive any parse, so they are never released
+    static std::mutex mutex;
+    static std::set<std::string, std::less<>> symbols;
+    std::lock_guard lock(mutex);
+    return Symbol{&*symbols.insert(std::move(folded)).first};
+}
+
+const std::string &Symbol::str() const noexcept {
+    static const std::string none;
+    return text_ ? *text_ : none;
+}
+
+ExpressionPtr makeExpression(Expression expression) {
+    if (const auto &arena = NodeArena::current()) {
+        return std::allocate_shared<Expression>(ArenaAllocator<Expression>(arena), std::move(expression));
+    }
+    return std::make_shared<Expression>(std::move(expression));
+}
+
 ExpressionPtr makeNumericLiteral(double value) {
     return make(LiteralExpression{.value = value});
 }
@@ -1,5 +1,961 @@
 #include "trx/ast/Nodes.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace trx::ast {
-// Intentionally empty translation unit to anchor AST types in the library.
+
+namespace {
+
+template<class... Ts> struct Overloaded : Ts... { using Ts::operator()...; };
+template<class... Ts> Overloaded(Ts...) -> Overloaded<Ts...>;
+
+std::string toLowerCopy(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return value;
+}
+
+// Adds the names of |from| missing from |into|; true when any were added
+bool merge(std::vector<std::string> &into, const std::vector<std::string> &from) {
+    bool added = false;
+    for (const auto &name : from) {
+        if (std::find(into.begin(), into.end(), name) == into.end()) {
+            into.push_back(name);
+            added = true;
+        }
+    }
+    return added;
+}
+
+// Most decimals an exact number keeps; roundToScale() goes no further
+constexpr short maxScale = 9;
+
+// The static type of a value declared as |typeName|; a DECIMAL is only exact with a scale
+StaticType staticType(const std::string &typeName, std::optional<short> scale) {
+    using Kind = StaticType::Kind;
+    if (typeName == "INTEGER" || typeName == "SMALLINT") {
+        return {Kind::Number, 0};
+    }
+    if (typeName == "DECIMAL") {
+        return {Kind::Number, scale && *scale >= 0 && *scale <= maxScale ? *scale : short{-1}};
+    }
+    if (typeName == "DOUBLE") {
+        return {Kind::Number};
+    }
+    if (typeName == "BOOLEAN") {
+        return {Kind::Boolean};
+    }
+    if (typeName == "CHAR" || typeName.starts_with("_CHAR")) {
+        return {Kind::String};
+    }
+    return {};
+}
+
+// Walks one routine body, handing every variable reference and local declaration to Derived.
+// Variables the body assigns go through target(), calls, BATCH, SQL and EMIT statements and every expression
+// once its operands are walked are handed over too, and enter() sees each expression pointer
+// before its operands; Derived may leave those hooks out.
+template<class Derived>
+class BodyWalker {
+public:
+    void target(VariableExpression &variable) { self().variable(variable); }
+    void call(FunctionCallExpression &) {}
+    void batch(BatchStatement &) {}
+    void sql(SqlStatement &) {}
+    void emit(EmitStatement &) {}
+    void enter(ExpressionPtr &) {}
+    void after(Expression &) {}
+
+    void expression(ExpressionPtr &expression) {
+        if (!expression) {
+            return;
+        }
+        self().enter(expression);
+        std::visit(
+            Overloaded{
+                [](LiteralExpression &) {},
+                [&](ObjectLiteralExpression &object) {
+                    for (auto &[key, value] : object.properties) {
+                        this->expression(value);
+                    }
+                },
+                [&](ArrayLiteralExpression &array) { expressions(array.elements); },
+                [&](VariableExpression &var) { self().variable(var); },
+                [&](UnaryExpression &unary) { this->expression(unary.operand); },
+                [&](BinaryExpression &binary) {
+                    this->expression(binary.lhs);
+                    this->expression(binary.rhs);
+                },
+                [&](FunctionCallExpression &call) {
+                    self().call(call);
+                    expressions(call.arguments);
+                },
+                [&](MethodCallExpression &call) {
+                    this->expression(call.object);
+                    expressions(call.arguments);
+                },
+                [&](BuiltinExpression &builtin) { expressions(builtin.arguments); },
+                [&](SqlFragmentExpression &sql) {
+                    for (auto &fragment : sql.fragments) {
+                        if (auto *var = std::get_if<VariableExpression>(&fragment.value)) {
+                            self().variable(*var);
+                        }
+                    }
+                }
+            },
+            expression->node);
+        self().after(*expression);
+    }
+
+    void statements(StatementList &statements) {
+        for (auto &statement : statements) {
+            this->statement(statement);
+        }
+    }
+
+private:
+    Derived &self() { return static_cast<Derived &>(*this); }
+
+    void expressions(std::vector<ExpressionPtr> &expressions) {
+        for (auto &expression : expressions) {
+            this->expression(expression);
+        }
+    }
+
+    void variables(std::vector<VariableExpression> &variables) {
+        for (auto &var : variables) {
+            self().variable(var);
+        }
+    }
+
+    void statement(Statement &statement) {
+        std::visit(
+            Overloaded{
+                [&](TraceStatement &trace) { expression(trace.value); },
+                [&](ExpressionStatement &exprStmt) { expression(exprStmt.expression); },
+                [&](ValidateStatement &validate) {
+                    self().variable(validate.variable);
+                    expression(validate.rule);
+                },
+                [&](ReturnStatement &returnStmt) { expression(returnStmt.value); },
+                [&](SystemStatement &system) { expression(system.command); },
+                [&](AssignmentStatement &assignment) {
+                    self().target(assignment.target);
+                    expression(assignment.value);
+                },
+                [&](VariableDeclarationStatement &varDecl) {
+                    if (varDecl.initializer) {
+                        expression(*varDecl.initializer);
+                    }
+                    self().declaration(varDecl);
+                },
+                [&](BatchStatement &batch) {
+                    self().batch(batch);
+                    if (batch.argument) {
+                        self().variable(*batch.argument);
+                    }
+                    if (batch.jobId) {
+                        self().target(*batch.jobId);
+                    }
+                },
+                [&](ThrowStatement &throwStmt) { expression(throwStmt.value); },
+                [&](EmitStatement &emitStmt) {
+                    self().emit(emitStmt);
+                    expression(emitStmt.value);
+                },
+                [&](TryCatchStatement &tryCatch) {
+                    statements(tryCatch.tryBlock);
+                    if (tryCatch.exceptionVar) {
+                        self().target(*tryCatch.exceptionVar);
+                    }
+                    statements(tryCatch.catchBlock);
+                },
+                [&](SqlStatement &sql) {
+                    self().sql(sql);
+                    const bool fetches = sql.kind == SqlStatementKind::FetchCursor || sql.kind == SqlStatementKind::SelectInto;
+                    // INTO LIST only assigns the list; a LIMIT or WHERE variable is read
+                    const auto targets = sql.compiled.intoList ? sql.compiled.intoCount : sql.hostVariables.size();
+                    for (std::size_t i = 0; i < sql.hostVariables.size(); ++i) {
+                        auto &var = sql.hostVariables[i];
+                        if (fetches && i < targets) {
+                            self().target(var);
+                        } else {
+                            self().variable(var);
+                        }
+                    }
+                    variables(sql.openParameters);
+                },
+                [&](IfStatement &ifStmt) {
+                    expression(ifStmt.condition);
+                    statements(ifStmt.thenBranch);
+                    statements(ifStmt.elseBranch);
+                },
+                [&](WhileStatement &whileStmt) {
+                    expression(whileStmt.condition);
+                    statements(whileStmt.body);
+                },
+                [&](SwitchStatement &switchStmt) {
+                    expression(switchStmt.selector);
+                    for (auto &switchCase : switchStmt.cases) {
+                        expression(switchCase.match);
+                        statements(switchCase.body);
+                    }
+                    if (switchStmt.defaultBranch) {
+                        statements(*switchStmt.defaultBranch);
+                    }
+                },
+                [&](SortStatement &sort) { self().variable(sort.array); },
+                [&](BlockStatement &block) { statements(block.statements); },
+                [&](ForStatement &forStmt) {
+                    self().loop(forStmt);
+                    expression(forStmt.collection);
+                    expression(forStmt.maxParallel);
+                    statements(forStmt.body);
+                }
+            },
+            statement.node);
+    }
+};
+
+// Every name that could be bound locally gets a slot: the body may create a local by
+// assigning to or fetching into an undeclared name, so each variable root is placed, and
+// the interpreter falls back to globals while a slot is still unbound.
+class FrameResolver : public BodyWalker<FrameResolver> {
+public:
+    explicit FrameResolver(std::vector<std::string> &slots) : slots_{slots} {}
+
+    std::size_t slotFor(const std::string &name) {
+        auto key = toLowerCopy(name);
+        const auto it = std::find(slots_.begin(), slots_.end(), key);
+        if (it != slots_.end()) {
+            return static_cast<std::size_t>(it - slots_.begin());
+        }
+        slots_.push_back(std::move(key));
+        return slots_.size() - 1;
+    }
+
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            segment.key = Symbol::of(segment.identifier);
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+        if (variable.path.empty()) {
+            return;
+        }
+        const auto &root = variable.path.front().key;
+        if (root != "input" && root != "output") { // rejected at runtime, never a local
+            variable.slot = slotFor(root.str());
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &varDecl) { varDecl.slot = slotFor(varDecl.name.name); }
+
+    void loop(ForStatement &forStmt) { variable(forStmt.loopVar); }
+
+private:
+    std::vector<std::string> &slots_;
+};
+
+// Types each frame slot by the first declaration of its name (argument, VAR or loop
+// variable over a typed list) and stamps field indexes along paths through record types.
+// The interpreter checks every index against the record it reads, so a stale guess only
+// costs a search. Each variable is stamped with the static type of its path too, unless
+// its name is declared with more than one type.
+class FieldResolver : public BodyWalker<FieldResolver> {
+public:
+    FieldResolver(const std::unordered_map<std::string, const RecordDecl *> &records, const ProcedureDecl &procedure)
+        : records_{records}, slotTypes_(procedure.frameSlots.size()), slotScales_(procedure.frameSlots.size()),
+          ambiguous_(procedure.frameSlots.size()) {
+        for (const auto &parameter : procedure.name.pathParameters) {
+            type(parameter.slot, parameter.type.name);
+        }
+        if (procedure.input) {
+            type(procedure.input->slot, procedure.input->type.name);
+        }
+    }
+
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+        if (!variable.path.empty() && variable.slot < slotTypes_.size()) {
+            const RecordField *field = nullptr;
+            const auto typeName = resolve(variable, slotTypes_[variable.slot], true, &field);
+            const bool root = variable.path.size() == 1 && !variable.path.front().subscript;
+            variable.type = ambiguous_[variable.slot] ? StaticType{}
+                                                      : staticType(typeName, field ? field->scale : root ? slotScales_[variable.slot] : std::nullopt);
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &varDecl) { type(varDecl.slot, varDecl.typeName, varDecl.scale); }
+
+    // True once a name turned out to be declared with two types; uses walked before that
+    // still carry the first one until the body is walked again
+    bool ambiguous() const { return std::find(ambiguous_.begin(), ambiguous_.end(), true) != ambiguous_.end(); }
+
+    // Rows read INTO LIST are built as records of the list's element TYPE
+    void sql(SqlStatement &sql) {
+        if (!sql.compiled.intoList || sql.hostVariables.empty()) {
+            return;
+        }
+        auto &target = sql.hostVariables.front();
+        if (!target.path.empty() && target.slot < slotTypes_.size()) {
+            sql.listType = elementType(resolve(target, slotTypes_[target.slot], false));
+        }
+    }
+
+    void loop(ForStatement &forStmt) {
+        auto *collection = forStmt.collection ? std::get_if<VariableExpression>(&forStmt.collection->node) : nullptr;
+        if (collection) {
+            if (!collection->path.empty() && collection->slot < slotTypes_.size()) {
+                type(forStmt.loopVar.slot, elementType(resolve(*collection, slotTypes_[collection->slot], false)));
+            }
+        }
+        variable(forStmt.loopVar);
+    }
+
+private:
+    void type(std::size_t slot, std::string typeName, std::optional<short> scale = std::nullopt) {
+        if (slot >= slotTypes_.size() || typeName.empty()) {
+            return;
+        }
+        if (slotTypes_[slot].empty()) {
+            slotTypes_[slot] = std::move(typeName);
+            slotScales_[slot] = scale;
+        } else if (slotTypes_[slot] != typeName || slotScales_[slot] != scale) {
+            ambiguous_[slot] = true;
+        }
+    }
+
+    static std::string elementType(const std::string &typeName) {
+        if (typeName.size() > 6 && typeName.compare(0, 5, "LIST(") == 0 && typeName.back() == ')') {
+            return typeName.substr(5, typeName.size() - 6);
+        }
+        return {};
+    }
+
+    // Type of the whole path, or empty once it leaves statically known records. Mirrors the
+    // interpreter: a subscripted segment indexes the current value, any other one past the
+    // root reads a field of it. |last| is set to the field the path ends on, if any.
+    std::string resolve(VariableExpression &variable, std::string typeName, bool stamp, const RecordField **last = nullptr) {
+        for (std::size_t i = 0; i < variable.path.size() && !typeName.empty(); ++i) {
+            auto &segment = variable.path[i];
+            if (last) {
+                *last = nullptr;
+            }
+            if (segment.subscript) {
+                typeName = elementType(typeName);
+                continue;
+            }
+            if (i == 0) {
+                continue;
+            }
+            const auto record = records_.find(typeName);
+            if (record == records_.end()) {
+                return {};
+            }
+            const auto &fields = record->second->fields;
+            const auto key = segment.key.empty() ? toLowerCopy(segment.identifier) : segment.key.str();
+            const auto field = std::find_if(fields.begin(), fields.end(), [&](const RecordField &candidate) {
+                return toLowerCopy(candidate.name.name) == key;
+            });
+            if (field == fields.end()) {
+                return {};
+            }
+            if (stamp) {
+                segment.field = static_cast<std::size_t>(field - fields.begin());
+            }
+            if (last) {
+                *last = &*field;
+            }
+            typeName = field->typeName;
+        }
+        return typeName;
+    }
+
+    const std::unordered_map<std::string, const RecordDecl *> &records_;
+    std::vector<std::string> slotTypes_;
+    std::vector<std::optional<short>> slotScales_;
+    std::vector<bool> ambiguous_;
+};
+
+// Replaces every expression pointer by a copy of its node, so the walked code no longer
+// shares nodes with the code it was copied from
+class ExpressionCopier : public BodyWalker<ExpressionCopier> {
+public:
+    void enter(ExpressionPtr &expression) { expression = makeExpression(*expression); }
+
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &) {}
+
+    void loop(ForStatement &forStmt) { variable(forStmt.loopVar); }
+};
+
+// Module-level code outside routines: global initializers, expression declarations and
+// the top-level statements
+template<class Walker>
+void walkGlobals(Module &module, Walker &walker) {
+    for (auto &decl : module.declarations) {
+        if (auto *varDecl = std::get_if<VariableDeclarationStatement>(&decl)) {
+            if (varDecl->initializer) {
+                walker.expression(*varDecl->initializer);
+            }
+            walker.declaration(*varDecl);
+        } else if (auto *exprStmt = std::get_if<ExpressionStatement>(&decl)) {
+            walker.expression(exprStmt->expression);
+        }
+    }
+    walker.statements(module.statements);
+}
+
+const std::unordered_map<std::string, BuiltinFunction> &builtinFunctions() {
+    static const std::unordered_map<std::string, BuiltinFunction> functions{
+        {"length", BuiltinFunction::Length},
+        {"len", BuiltinFunction::Length},
+        {"append", BuiltinFunction::Append},
+        {"substr", BuiltinFunction::Substr},
+        {"debug", BuiltinFunction::Debug},
+        {"info", BuiltinFunction::Info},
+        {"error", BuiltinFunction::Error},
+        {"trace", BuiltinFunction::Trace},
+        {"http", BuiltinFunction::Http},
+        {"http_all", BuiltinFunction::HttpAll},
+        {"index_by", BuiltinFunction::IndexBy},
+        {"group_by", BuiltinFunction::GroupBy},
+        {"lookup", BuiltinFunction::Lookup},
+        {"sum", BuiltinFunction::Sum},
+        {"min", BuiltinFunction::Min},
+        {"max", BuiltinFunction::Max},
+        {"avg", BuiltinFunction::Avg},
+        {"count_if", BuiltinFunction::CountIf},
+    };
+    return functions;
+}
+
+// Binds calls to the builtins or user routines they name and notes whether the body runs SQL or EMITs itself
+class CallResolver : public BodyWalker<CallResolver> {
+public:
+    CallResolver(const std::unordered_map<std::string, const ProcedureDecl *> &routines, std::string where, std::vector<std::string> &unknown)
+        : routines_{routines}, where_{std::move(where)}, unknown_{unknown} {}
+
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &) {}
+
+    void loop(ForStatement &forStmt) {
+        if (forStmt.parallel) {
+            parallelLoops.push_back(&forStmt);
+        }
+    }
+
+    void call(FunctionCallExpression &call) {
+        const auto builtin = builtinFunctions().find(call.functionName);
+        call.builtin = builtin != builtinFunctions().end() ? builtin->second : BuiltinFunction::None;
+        const auto routine = routines_.find(call.functionName);
+        call.routine = routine != routines_.end() ? routine->second : nullptr;
+        if (call.builtin != BuiltinFunction::None) {
+            return;
+        }
+        if (call.routine) {
+            callees.push_back(call.routine);
+        } else {
+            unknown_.push_back("Unknown function '" + call.functionName + "' called " + where_);
+        }
+    }
+
+    // The job is a row of the job table, written in the caller's transaction
+    void batch(BatchStatement &batch) {
+        const auto routine = routines_.find(batch.name);
+        batch.routine = routine != routines_.end() ? routine->second : nullptr;
+        if (!batch.routine) {
+            unknown_.push_back("Unknown routine '" + batch.name + "' queued by BATCH " + where_);
+        }
+        runsSql = true;
+        writesSql = true;
+        merge(writesTables, {"trx_jobs"});
+    }
+
+    void sql(SqlStatement &sql) {
+        runsSql = true;
+        writesSql = writesSql || !sql.compiled.readOnly;
+        usesCursors = usesCursors || sql.kind == SqlStatementKind::DeclareCursor || sql.kind == SqlStatementKind::OpenCursor;
+        merge(readsTables, sql.compiled.readsTables);
+        merge(writesTables, sql.compiled.writesTables);
+        if (sql.kind == SqlStatementKind::DeclareCursor) {
+            declares.push_back(&sql);
+        } else if (!sql.compiled.currentOfCursor.empty()) {
+            currentOf.push_back(toLowerCopy(sql.compiled.currentOfCursor));
+        }
+    }
+
+    void emit(EmitStatement &) { emits = true; }
+
+    std::vector<const ProcedureDecl *> callees;
+    bool runsSql{false};
+    bool writesSql{false};
+    bool usesCursors{false};
+    bool emits{false};
+    std::vector<std::string> readsTables;
+    std::vector<std::string> writesTables;
+    std::vector<SqlStatement *> declares;  // DECLARE CURSOR statements
+    std::vector<std::string> currentOf;    // lowercased cursors named by WHERE CURRENT OF
+    std::vector<ForStatement *> parallelLoops;
+
+private:
+    const std::unordered_map<std::string, const ProcedureDecl *> &routines_;
+    std::string where_;
+    std::vector<std::string> &unknown_;
+};
+
+// Notes whether a body, once its calls are bound and the routines' readOnly flags settled,
+// writes: through SQL, a BATCH job row, or a routine it calls
+class WriteFinder : public BodyWalker<WriteFinder> {
+public:
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &) {}
+
+    void loop(ForStatement &) {}
+
+    void call(FunctionCallExpression &call) { writes = writes || (call.routine && !call.routine->readOnly); }
+
+    void batch(BatchStatement &) { writes = true; }
+
+    void sql(SqlStatement &sql) { writes = writes || !sql.compiled.readOnly; }
+
+    bool writes{false};
+};
+
+// Collects the names module code binds: declarations, assignment and FETCH/INTO targets,
+// loop and CATCH variables, and routine arguments
+class BindingCollector : public BodyWalker<BindingCollector> {
+public:
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+    }
+
+    void target(VariableExpression &variable) {
+        if (!variable.path.empty()) {
+            names.insert(toLowerCopy(variable.path.front().identifier));
+        }
+        this->variable(variable);
+    }
+
+    void declaration(VariableDeclarationStatement &varDecl) { names.insert(toLowerCopy(varDecl.name.name)); }
+
+    void loop(ForStatement &forStmt) { target(forStmt.loopVar); }
+
+    std::unordered_set<std::string> names;
+};
+
+// Replaces CONSTANT reads by their literal and folds operators over literals, innermost first
+class ConstantFolding : public BodyWalker<ConstantFolding> {
+public:
+    ConstantFolding(const std::unordered_map<std::string, LiteralExpression> &constants, const ConstantFolder &folder)
+        : constants_{constants}, folder_{folder} {}
+
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &) {}
+
+    void loop(ForStatement &forStmt) { variable(forStmt.loopVar); }
+
+    void after(Expression &expression) {
+        if (const auto *var = std::get_if<VariableExpression>(&expression.node)) {
+            if (var->path.size() == 1 && !var->path.front().subscript) {
+                const auto constant = constants_.find(toLowerCopy(var->path.front().identifier));
+                if (constant != constants_.end()) {
+                    expression.node = constant->second;
+                }
+            }
+        } else if (const auto *unary = std::get_if<UnaryExpression>(&expression.node)) {
+            const auto *operand = literal(unary->operand);
+            if (operand && folder_.unary) {
+                if (auto folded = folder_.unary(unary->op, *operand)) {
+                    expression.node = std::move(*folded);
+                }
+            }
+        } else if (const auto *binary = std::get_if<BinaryExpression>(&expression.node)) {
+            const auto *lhs = literal(binary->lhs);
+            const auto *rhs = literal(binary->rhs);
+            if (lhs && rhs && folder_.binary) {
+                if (auto folded = folder_.binary(*binary, *lhs, *rhs)) {
+                    expression.node = std::move(*folded);
+                }
+            }
+        }
+    }
+
+private:
+    static const LiteralExpression *literal(const ExpressionPtr &expression) {
+        return expression ? std::get_if<LiteralExpression>(&expression->node) : nullptr;
+    }
+
+    const std::unordered_map<std::string, LiteralExpression> &constants_;
+    const ConstantFolder &folder_;
+};
+
+// Decimals a number literal is written with, as far as its double shows; -1 past maxScale
+short literalScale(double value) {
+    double power = 1.0;
+    for (short scale = 0; scale <= maxScale; ++scale, power *= 10.0) {
+        if (std::round(value * power) / power == value) {
+            return scale;
+        }
+    }
+    return -1;
+}
+
+// Infers the type of every expression from its operands, innermost first, and marks the
+// operators applied to numbers. A literal or an operator result is certain to have its
+// type; a variable only has the one it was declared with, which nothing enforces. So an
+// operator is only reported when an operand it cannot take is certain.
+class TypeChecker : public BodyWalker<TypeChecker> {
+public:
+    TypeChecker(std::string where, std::vector<std::string> &errors) : where_{std::move(where)}, errors_{errors} {}
+
+    void variable(VariableExpression &variable) {
+        for (auto &segment : variable.path) {
+            if (segment.subscript) {
+                expression(*segment.subscript);
+            }
+        }
+    }
+
+    void declaration(VariableDeclarationStatement &) {}
+
+    void loop(ForStatement &forStmt) { variable(forStmt.loopVar); }
+
+    void after(Expression &expression) { inferred_[&expression] = infer(expression); }
+
+private:
+    using Kind = StaticType::Kind;
+
+    struct Inferred {
+        StaticType type;
+        bool certain{false};
+    };
+
+    Inferred operand(const ExpressionPtr &expression) const {
+        const auto it = expression ? inferred_.find(expression.get()) : inferred_.end();
+        return it != inferred_.end() ? it->second : Inferred{};
+    }
+
+    // Certain to be of a kind other than |kind|
+    static bool notA(const Inferred &value, Kind kind) { return value.certain && value.type.kind != Kind::Unknown && value.type.kind != kind; }
+
+    void error(const std::string &message) { errors_.push_back(message + " " + where_); }
+
+    Inferred infer(Expression &expression) {
+        if (const auto *literal = std::get_if<LiteralExpression>(&expression.node)) {
+            if (const auto *number = std::get_if<double>(&literal->value)) {
+                return {{Kind::Number, literalScale(*number)}, true};
+            }
+            return {{std::holds_alternative<bool>(literal->value) ? Kind::Boolean : Kind::String}, true};
+        }
+        if (const auto *variable = std::get_if<VariableExpression>(&expression.node)) {
+            return {variable->type, false};
+        }
+        if (const auto *unary = std::get_if<UnaryExpression>(&expression.node)) {
+            const auto value = operand(unary->operand);
+            if (unary->op == UnaryOperator::Not) {
+                if (notA(value, Kind::Boolean)) {
+                    error("Not operator requires boolean operand");
+                }
+                return {{Kind::Boolean}, true};
+            }
+            if (notA(value, Kind::Number)) {
+                error(std::string(unary->op == UnaryOperator::Negate ? "Negate" : "Positive") + " operator requires numeric operand");
+            }
+            return {{Kind::Number, value.type.kind == Kind::Number ? value.type.scale : short{-1}}, true};
+        }
+        if (auto *binary = std::get_if<BinaryExpression>(&expression.node)) {
+            return infer(*binary);
+        }
+        return {};
+    }
+
+    Inferred infer(BinaryExpression &binary) {
+        const auto lhs = operand(binary.lhs);
+        const auto rhs = operand(binary.rhs);
+        binary.numeric = lhs.type.kind == Kind::Number && rhs.type.kind == Kind::Number;
+        const bool exact = binary.numeric && lhs.type.scale >= 0 && rhs.type.scale >= 0;
+        switch (binary.op) {
+            case BinaryOperator::Add:
+                // Adding to a string concatenates whatever the other operand is
+                if ((lhs.certain && lhs.type.kind == Kind::String) || (rhs.certain && rhs.type.kind == Kind::String)) {
+                    return {{Kind::String}, true};
+                }
+                if ((notA(lhs, Kind::Number) && notA(rhs, Kind::String)) || (notA(rhs, Kind::Number) && notA(lhs, Kind::String))) {
+                    error("Add operator requires compatible operands");
+                }
+                binary.scale = exact ? std::max(lhs.type.scale, rhs.type.scale) : short{-1};
+                return {{binary.numeric ? Kind::Number : Kind::Unknown, binary.scale}, binary.numeric && lhs.certain && rhs.certain};
+            case BinaryOperator::Subtract:
+            case BinaryOperator::Multiply:
+            case BinaryOperator::Divide:
+            case BinaryOperator::Modulo:
+                if (notA(lhs, Kind::Number) || notA(rhs, Kind::Number)) {
+                    error(std::string(operatorName(binary.op)) + " operator requires numeric operands");
+                }
+                if (binary.op == BinaryOperator::Subtract) {
+                    binary.scale = exact ? std::max(lhs.type.scale, rhs.type.scale) : short{-1};
+                } else if (binary.op == BinaryOperator::Multiply) {
+                    binary.scale = exact && lhs.type.scale + rhs.type.scale <= maxScale ? static_cast<short>(lhs.type.scale + rhs.type.scale) : short{-1};
+                }
+                return {{Kind::Number, binary.scale}, true};
+            case BinaryOperator::Equal:
+            case BinaryOperator::NotEqual:
+                return {{Kind::Boolean}, true};
+            case BinaryOperator::Less:
+            case BinaryOperator::LessEqual:
+            case BinaryOperator::Greater:
+            case BinaryOperator::GreaterEqual:
+                // Numbers compare with numbers and strings with strings
+                if (notA(lhs, Kind::Number) && notA(lhs, Kind::String)) {
+                    error(std::string(operatorName(binary.op)) + " operator requires comparable operands");
+                } else if (notA(rhs, Kind::Number) && notA(rhs, Kind::String)) {
+                    error(std::string(operatorName(binary.op)) + " operator requires comparable operands");
+                } else if (lhs.certain && rhs.certain && lhs.type.kind != rhs.type.kind) {
+                    error(std::string(operatorName(binary.op)) + " operator requires comparable operands");
+                }
+                return {{Kind::Boolean}, true};
+            case BinaryOperator::And:
+            case BinaryOperator::Or:
+                if (notA(lhs, Kind::Boolean) || notA(rhs, Kind::Boolean)) {
+                    error(std::string(operatorName(binary.op)) + " operator requires boolean operands");
+                }
+                return {{Kind::Boolean}, true};
+        }
+        return {};
+    }
+
+    static const char *operatorName(BinaryOperator op) {
+        switch (op) {
+            case BinaryOperator::Add: return "Add";
+            case BinaryOperator::Subtract: return "Subtract";
+            case BinaryOperator::Multiply: return "Multiply";
+            case BinaryOperator::Divide: return "Divide";
+            case BinaryOperator::Modulo: return "Modulo";
+            case BinaryOperator::Equal: return "Equal";
+            case BinaryOperator::NotEqual: return "NotEqual";
+            case BinaryOperator::Less: return "Less";
+            case BinaryOperator::LessEqual: return "LessEqual";
+            case BinaryOperator::Greater: return "Greater";
+            case BinaryOperator::GreaterEqual: return "GreaterEqual";
+            case BinaryOperator::And: return "And";
+            case BinaryOperator::Or: return "Or";
+        }
+        return "Unknown";
+    }
+
+    std::string where_;
+    std::vector<std::string> &errors_;
+    std::unordered_map<const Expression *, Inferred> inferred_;
+};
+
+} // namespace
+
+void resolveFrameSlots(ProcedureDecl &procedure) {
+    procedure.frameSlots.clear();
+    FrameResolver resolver{procedure.frameSlots};
+    for (auto &parameter : procedure.name.pathParameters) {
+        parameter.slot = resolver.slotFor(parameter.name.name);
+    }
+    if (procedure.input) {
+        procedure.input->slot = resolver.slotFor(procedure.input->name.name);
+    }
+    resolver.statements(procedure.body);
 }
+
+void resolveRecordFields(Module &module) {
+    std::unordered_map<std::string, const RecordDecl *> records;
+    for (const auto &decl : module.declarations) {
+        if (const auto *record = std::get_if<RecordDecl>(&decl)) {
+            records[record->name.name] = record;
+        }
+    }
+    for (auto &decl : module.declarations) {
+        if (auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            FieldResolver resolver{records, *procedure};
+            resolver.statements(procedure->body);
+            if (resolver.ambiguous()) {
+                resolver.statements(procedure->body);
+            }
+        }
+    }
+}
+
+std::vector<std::string> resolveCalls(Module &module) {
+    std::unordered_map<std::string, const ProcedureDecl *> routines;
+    for (const auto &decl : module.declarations) {
+        if (const auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            routines[procedure->name.baseName] = procedure;
+        }
+    }
+    std::vector<std::string> unknown;
+    CallResolver globals{routines, "at module level", unknown};
+    walkGlobals(module, globals);
+    std::vector<SqlStatement *> declares = std::move(globals.declares);
+    std::unordered_set<std::string> currentOf(globals.currentOf.begin(), globals.currentOf.end());
+    std::vector<ForStatement *> parallelLoops = std::move(globals.parallelLoops);
+    std::unordered_map<ProcedureDecl *, std::vector<const ProcedureDecl *>> callees;
+    for (auto &decl : module.declarations) {
+        if (auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            CallResolver resolver{routines, "in routine '" + procedure->name.baseName + "'", unknown};
+            resolver.statements(procedure->body);
+            declares.insert(declares.end(), resolver.declares.begin(), resolver.declares.end());
+            currentOf.insert(resolver.currentOf.begin(), resolver.currentOf.end());
+            parallelLoops.insert(parallelLoops.end(), resolver.parallelLoops.begin(), resolver.parallelLoops.end());
+            procedure->runsSql = resolver.runsSql;
+            procedure->emits = resolver.emits;
+            procedure->readOnly = !resolver.writesSql;
+            procedure->usesCursors = resolver.usesCursors;
+            procedure->readsTables = std::move(resolver.readsTables);
+            procedure->writesTables = std::move(resolver.writesTables);
+            callees[procedure] = std::move(resolver.callees);
+        }
+    }
+    // A cursor is open on the connection rather than in a routine, so a positioned UPDATE or
+    // DELETE in any routine may target a cursor another one declared
+    for (auto *declare : declares) {
+        declare->compiled.positioned = currentOf.contains(toLowerCopy(declare->identifier));
+    }
+    // A routine runs SQL, writes, uses cursors, EMITs or touches a table when anything it calls does;
+    // spread that until nothing changes
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto &[procedure, called] : callees) {
+            if (!procedure->runsSql && std::any_of(called.begin(), called.end(), [](const ProcedureDecl *callee) { return callee->runsSql; })) {
+                procedure->runsSql = true;
+                changed = true;
+            }
+            if (!procedure->emits && std::any_of(called.begin(), called.end(), [](const ProcedureDecl *callee) { return callee->emits; })) {
+                procedure->emits = true;
+                changed = true;
+            }
+            if (procedure->readOnly && std::any_of(called.begin(), called.end(), [](const ProcedureDecl *callee) { return !callee->readOnly; })) {
+                procedure->readOnly = false;
+                changed = true;
+            }
+            if (!procedure->usesCursors && std::any_of(called.begin(), called.end(), [](const ProcedureDecl *callee) { return callee->usesCursors; })) {
+                procedure->usesCursors = true;
+                changed = true;
+            }
+            for (const auto *callee : called) {
+                if (merge(procedure->readsTables, callee->readsTables) || merge(procedure->writesTables, callee->writesTables)) {
+                    changed = true;
+                }
+            }
+        }
+    }
+    // PARALLEL FOR iterations run on other connections, outside the routine's transaction, so
+    // only a body that writes nothing may run that way
+    for (auto *loop : parallelLoops) {
+        WriteFinder finder;
+        finder.statements(loop->body);
+        loop->readOnlyBody = !finder.writes;
+    }
+    return unknown;
+}
+
+std::vector<std::string> checkTypes(Module &module) {
+    std::vector<std::string> errors;
+    TypeChecker globals{"at module level", errors};
+    walkGlobals(module, globals);
+    for (auto &decl : module.declarations) {
+        if (auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            TypeChecker checker{"in routine '" + procedure->name.baseName + "'", errors};
+            checker.statements(procedure->body);
+        }
+    }
+    return errors;
+}
+
+Module copyModule(const Module &module) {
+    Module copy = module;
+    // The copy may be resolved on another thread than the original, so it gets nodes
+    // and an arena of its own
+    copy.arena = std::make_shared<NodeArena>();
+    NodeArena::Scope scope(copy.arena);
+    ExpressionCopier copier;
+    walkGlobals(copy, copier);
+    for (auto &decl : copy.declarations) {
+        if (auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            copier.statements(procedure->body);
+        }
+    }
+    return copy;
+}
+
+void foldConstants(Module &module, const ConstantFolder &folder) {
+    // A CONSTANT is only inlined while no code binds a variable of the same name
+    BindingCollector bindings;
+    walkGlobals(module, bindings);
+    for (auto &decl : module.declarations) {
+        if (auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            for (const auto &parameter : procedure->name.pathParameters) {
+                bindings.names.insert(toLowerCopy(parameter.name.name));
+            }
+            if (procedure->input) {
+                bindings.names.insert(toLowerCopy(procedure->input->name.name));
+            }
+            bindings.statements(procedure->body);
+        }
+    }
+    std::unordered_map<std::string, LiteralExpression> constants;
+    for (const auto &decl : module.declarations) {
+        if (const auto *constant = std::get_if<ConstantDecl>(&decl)) {
+            auto key = toLowerCopy(constant->name.name);
+            if (!bindings.names.contains(key)) {
+                constants[std::move(key)] = std::visit([](const auto &value) { return LiteralExpression{value}; }, constant->value);
+            }
+        }
+    }
+
+    ConstantFolding folding{constants, folder};
+    walkGlobals(module, folding);
+    for (auto &decl : module.declarations) {
+        if (auto *procedure = std::get_if<ProcedureDecl>(&decl)) {
+            folding.statements(procedure->body);
+        }
+    }
+}
+
+} // namespace trx::ast
@@ -0,0 +1,285 @@
+#include "trx/ast/Statements.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+namespace trx::ast {
+
+namespace {
+std::string toUpperCopy(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::toupper(ch));
+    });
+    return value;
+}
+
+// DECLARE name CURSOR FOR <select> -> <select>
+std::string extractSelectFromDeclare(const std::string &declareSql, const std::string &upper) {
+    const auto cursorForPos = upper.find("CURSOR FOR");
+    if (cursorForPos == std::string::npos) {
+        return declareSql;
+    }
+    auto selectPos = cursorForPos + 10; // length of "CURSOR FOR"
+    while (selectPos < declareSql.size() && std::isspace(static_cast<unsigned char>(declareSql[selectPos]))) {
+        ++selectPos;
+    }
+    return declareSql.substr(selectPos);
+}
+
+void compileUpdateCurrentOf(const std::string &sql, const std::string &upper, CompiledSql &compiled) {
+    const auto setPos = upper.find(" SET ");
+    const auto wherePos = upper.find(" WHERE CURRENT OF ");
+    if (setPos == std::string::npos || wherePos == std::string::npos) {
+        return;
+    }
+    const auto setClause = sql.substr(setPos + 5, wherePos - (setPos + 5));
+
+    std::size_t pos = 0;
+    while (pos < setClause.size()) {
+        const auto commaPos = setClause.find(',', pos);
+        if (commaPos == std::string::npos) {
+            compiled.setAssignments.push_back(setClause.substr(pos));
+            break;
+        }
+        compiled.setAssignments.push_back(setClause.substr(pos, commaPos - pos));
+        pos = commaPos + 1;
+        while (pos < setClause.size() && std::isspace(static_cast<unsigned char>(setClause[pos]))) {
+            ++pos;
+        }
+    }
+    if (compiled.setAssignments.empty()) {
+        return;
+    }
+
+    compiled.updatePrefix = upper.substr(0, setPos + 5);
+    compiled.currentOfClause = sql.substr(wherePos);
+    compiled.text = compiled.updatePrefix;
+    for (std::size_t i = 0; i < compiled.setAssignments.size(); ++i) {
+        if (i > 0) {
+            compiled.text += ", ";
+        }
+        compiled.text += compiled.setAssignments[i];
+    }
+    compiled.text += compiled.currentOfClause;
+}
+
+// Words, quoted names and punctuation of upper-cased SQL; string literals are dropped
+std::vector<std::string> sqlTokens(const std::string &upper) {
+    std::vector<std::string> tokens;
+    for (std::size_t i = 0; i < upper.size();) {
+        const unsigned char c = static_cast<unsigned char>(upper[i]);
+        if (std::isspace(c)) {
+            ++i;
+        } else if (c == '\'') {
+            const auto end = upper.find('\'', i + 1);
+            i = end == std::string::npos ? upper.size() : end + 1;
+        } else if (c == '"' || c == '`') {
+            const auto end = upper.find(static_cast<char>(c), i + 1);
+            const auto stop = end == std::string::npos ? upper.size() : end;
+            tokens.push_back(upper.substr(i + 1, stop - i - 1));
+            i = stop + 1;
+        } else if (std::isalnum(c) || c == '_') {
+            std::size_t end = i;
+            while (end < upper.size() && (std::isalnum(static_cast<unsigned char>(upper[end])) || upper[end] == '_' || upper[end] == '.')) {
+                ++end;
+            }
+            tokens.push_back(upper.substr(i, end - i));
+            i = end;
+        } else {
+            tokens.emplace_back(1, static_cast<char>(c));
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+bool isTableName(const std::string &token) {
+    static constexpr std::string_view keywords[] = {"SELECT", "SET", "WHERE", "VALUES", "OF", "NOWAIT", "ONLY", "LATERAL", "IF", "EXISTS", "NOT"};
+    return !token.empty() && (std::isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_') &&
+           std::find(std::begin(keywords), std::end(keywords), token) == std::end(keywords);
+}
+
+void addTable(std::vector<std::string> &tables, std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    if (std::find(tables.begin(), tables.end(), name) == tables.end()) {
+        tables.push_back(std::move(name));
+    }
+}
+
+// Tables a statement reads and writes, for invalidating cached responses. Table names
+// are recognised after FROM, JOIN, INTO, UPDATE and TABLE; anything the scan cannot
+// place (a table reached only through a view or a function) is not seen.
+void collectTables(const std::vector<std::string> &tokens, CompiledSql &compiled) {
+    const auto at = [&](std::size_t i) -> const std::string & {
+        static const std::string none;
+        return i < tokens.size() ? tokens[i] : none;
+    };
+    const auto skipIfExists = [&](std::size_t i) {
+        if (at(i) == "IF" && at(i + 1) == "NOT" && at(i + 2) == "EXISTS") {
+            return i + 3;
+        }
+        return at(i) == "IF" && at(i + 1) == "EXISTS" ? i + 2 : i;
+    };
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const auto &token = tokens[i];
+        if (token == "INTO" && (at(i - 1) == "INSERT" || at(i - 1) == "REPLACE" || at(i - 2) == "INSERT")) {
+            if (isTableName(at(i + 1))) {
+                addTable(compiled.writesTables, at(i + 1));
+            }
+        } else if (token == "UPDATE" && at(i - 1) != "FOR" && at(i - 1) != "DO") {
+            if (isTableName(at(i + 1))) {
+                addTable(compiled.writesTables, at(i + 1));
+            }
+        } else if (token == "FROM" && at(i - 1) == "DELETE") {
+            if (isTableName(at(i + 1))) {
+                addTable(compiled.writesTables, at(i + 1));
+            }
+        } else if (token == "TABLE" || (token == "TRUNCATE" && at(i + 1) != "TABLE")) {
+            const auto name = skipIfExists(i + 1);
+            if (isTableName(at(name)) && at(i - 1) != "FROM") {
+                addTable(compiled.writesTables, at(name));
+            }
+        } else if (token == "FROM" || token == "JOIN") {
+            // FROM a, b x, c AS y
+            for (std::size_t j = i + 1; isTableName(at(j)); ++j) {
+                addTable(compiled.readsTables, at(j));
+                if (at(j + 1) == "AS") {
+                    ++j;
+                }
+                if (isTableName(at(j + 1)) && at(j + 2) == ",") {
+                    ++j;
+                }
+                if (at(j + 1) != ",") {
+                    break;
+                }
+                ++j;
+            }
+        }
+    }
+}
+
+// Whether a statement only reads: a query, or a step of a cursor over one, that names no
+// table it writes, creates nothing with SELECT INTO and locks no rows. The scan has the
+// limits of collectTables(); a query calling a function that writes is not seen.
+bool readsOnly(SqlStatementKind kind, const std::vector<std::string> &tokens, const CompiledSql &compiled) {
+    switch (kind) {
+        case SqlStatementKind::OpenCursor:
+        case SqlStatementKind::FetchCursor:
+        case SqlStatementKind::CloseCursor:
+            return true; // the cursor's DECLARE is classified by itself
+        case SqlStatementKind::SelectForUpdate:
+            return false;
+        default:
+            break;
+    }
+    if (!compiled.writesTables.empty()) {
+        return false;
+    }
+    std::size_t start = 0;
+    if (kind == SqlStatementKind::DeclareCursor) {
+        while (start + 1 < tokens.size() && !(tokens[start] == "CURSOR" && tokens[start + 1] == "FOR")) {
+            ++start;
+        }
+        start += 2;
+    }
+    if (start >= tokens.size() || (tokens[start] != "SELECT" && tokens[start] != "WITH" && tokens[start] != "VALUES")) {
+        return false;
+    }
+    for (std::size_t i = start; i < tokens.size(); ++i) {
+        if (tokens[i] == "INTO" && kind != SqlStatementKind::SelectInto) {
+            return false;
+        }
+        // FOR UPDATE, FOR NO KEY UPDATE, FOR SHARE, FOR KEY SHARE
+        if (tokens[i] == "FOR" && i + 1 < tokens.size() &&
+            (tokens[i + 1] == "UPDATE" || tokens[i + 1] == "SHARE" || tokens[i + 1] == "NO" || tokens[i + 1] == "KEY")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void compileSelectInto(const std::string &upper, const std::vector<VariableExpression> &hostVariables, CompiledSql &compiled) {
+    const auto intoPos = upper.find(" INTO ");
+    if (intoPos == std::string::npos) {
+        return;
+    }
+    const auto fromPos = upper.find(" FROM ", intoPos);
+    if (fromPos == std::string::npos) {
+        return;
+    }
+    const auto intoCount = static_cast<std::size_t>(
+        std::count(upper.begin() + static_cast<std::ptrdiff_t>(intoPos + 6), upper.begin() + static_cast<std::ptrdiff_t>(fromPos), '?'));
+    compiled.intoCount = std::min(intoCount, hostVariables.size());
+    compiled.text = upper.substr(0, intoPos) + upper.substr(fromPos);
+
+    // SELECT ... INTO LIST :rows FROM ...
+    auto listPos = intoPos + 6;
+    while (listPos < fromPos && std::isspace(static_cast<unsigned char>(upper[listPos]))) {
+        ++listPos;
+    }
+    if (upper.compare(listPos, 4, "LIST") == 0 && listPos + 4 < fromPos && std::isspace(static_cast<unsigned char>(upper[listPos + 4]))) {
+        compiled.intoList = true;
+        compiled.intoCount = std::min<std::size_t>(compiled.intoCount, 1);
+    }
+}
+
+// FETCH cursor INTO LIST ? [LIMIT n | LIMIT ?]
+void compileFetchList(const std::vector<std::string> &tokens, const std::vector<VariableExpression> &hostVariables, CompiledSql &compiled) {
+    const auto into = std::find(tokens.begin(), tokens.end(), "INTO");
+    if (into == tokens.end() || into + 1 == tokens.end() || into[1] != "LIST") {
+        return;
+    }
+    compiled.intoList = true;
+    compiled.intoCount = std::min<std::size_t>(hostVariables.size(), 1);
+    const auto limit = std::find(into + 2, tokens.end(), "LIMIT");
+    if (limit == tokens.end() || limit + 1 == tokens.end()) {
+        return;
+    }
+    if (limit[1] == "?") {
+        compiled.limitVariable = hostVariables.size() > 1;
+    } else if (limit[1].size() <= 9 && std::all_of(limit[1].begin(), limit[1].end(), [](unsigned char c) { return std::isdigit(c); })) {
+        compiled.fetchLimit = std::stoul(limit[1]);
+    }
+}
+} // namespace
+
+void compileSqlStatement(SqlStatement &statement) {
+    CompiledSql compiled;
+    compiled.text = statement.sql;
+    const auto upper = toUpperCopy(statement.sql);
+    const auto tokens = sqlTokens(upper);
+
+    switch (statement.kind) {
+        case SqlStatementKind::ExecImmediate:
+            if (upper.rfind("UPDATE", 0) == 0 && upper.find("WHERE CURRENT OF") != std::string::npos) {
+                compileUpdateCurrentOf(statement.sql, upper, compiled);
+            }
+            for (std::size_t i = 0; i + 3 < tokens.size(); ++i) {
+                if (tokens[i] == "WHERE" && tokens[i + 1] == "CURRENT" && tokens[i + 2] == "OF") {
+                    compiled.currentOfCursor = tokens[i + 3];
+                    break;
+                }
+            }
+            compiled.batchable = (upper.rfind("INSERT", 0) == 0 || upper.rfind("UPDATE", 0) == 0 || upper.rfind("DELETE", 0) == 0) &&
+                                 upper.find("CURRENT OF") == std::string::npos;
+            break;
+        case SqlStatementKind::DeclareCursor:
+            compiled.text = extractSelectFromDeclare(statement.sql, upper);
+            break;
+        case SqlStatementKind::FetchCursor:
+            compileFetchList(tokens, statement.hostVariables, compiled);
+            break;
+        case SqlStatementKind::SelectInto:
+            compileSelectInto(upper, statement.hostVariables, compiled);
+            break;
+        default:
+            break;
+    }
+
+    collectTables(tokens, compiled);
+    compiled.readOnly = readsOnly(statement.kind, tokens, compiled);
+    statement.compiled = std::move(compiled);
+}
+
+} // namespace trx::ast
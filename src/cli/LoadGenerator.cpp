@@ -0,0 +1,779 @@
+#include "LoadGenerator.h"
+#include "Server.h"
+
+#include "trx/runtime/JsonValue.h"
+#include "trx/runtime/JsonWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+
+namespace trx::cli {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Latencies in microseconds to three significant digits, in the HdrHistogram layout:
+// values below 2048 get a bucket each, larger ones 1024 buckets per power of two
+class LatencyRecorder {
+public:
+    LatencyRecorder() : counts_(subBucketCount + (64 - subBucketBits) * halfCount) {}
+
+    void record(std::uint64_t micros) {
+        ++counts_[indexOf(micros)];
+        ++count_;
+        sum_ += micros;
+        max_ = std::max(max_, micros);
+    }
+
+    void merge(const LatencyRecorder &other) {
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+    // The value |fraction| of the recordings are at or below, reported as the top of its bucket
+    std::uint64_t percentile(double fraction) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(highestInBucket(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static constexpr unsigned subBucketBits = 11;
+    static constexpr std::uint64_t subBucketCount = std::uint64_t{1} << subBucketBits;
+    static constexpr std::uint64_t halfCount = subBucketCount / 2;
+
+    static std::size_t indexOf(std::uint64_t value) {
+        if (value < subBucketCount) {
+            return static_cast<std::size_t>(value);
+        }
+        const auto shift = static_cast<unsigned>(std::bit_width(value)) - subBucketBits;
+        return static_cast<std::size_t>(subBucketCount + (shift - 1) * halfCount + ((value >> shift) - halfCount));
+    }
+
+    static std::uint64_t highestInBucket(std::size_t index) {
+        if (index < subBucketCount) {
+            return index;
+        }
+        const auto shift = (index - subBucketCount) / halfCount + 1;
+        const auto mantissa = (index - subBucketCount) % halfCount + halfCount;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t count_{0};
+    std::uint64_t sum_{0};
+    std::uint64_t max_{0};
+};
+
+// A routine to call: complete HTTP requests with different payloads, sent in turn
+struct Target {
+    std::string name;
+    bool head{false}; // HEAD responses carry a Content-Length but no body
+    std::vector<std::string> requests;
+};
+
+// Random values for path parameters and request bodies, shaped by the declared types
+class PayloadGenerator {
+public:
+    PayloadGenerator(const std::vector<const trx::ast::RecordDecl *> &records, std::uint64_t seed) : random_(seed) {
+        for (const auto *record : records) {
+            records_.emplace(record->name.name, record);
+        }
+    }
+
+    // A request body for an input of |typeName|: a record of that TYPE, or an empty object
+    std::string body(const std::string &typeName) {
+        const auto record = records_.find(typeName);
+        return trx::runtime::JsonWriter::toString(record != records_.end() ? recordValue(*record->second, 0)
+                                                                           : trx::runtime::JsonValue::object());
+    }
+
+    std::string pathValue(const std::string &typeName) {
+        const auto value = scalar(typeName, 0);
+        return value.isString() ? value.asString() : trx::runtime::JsonWriter::toString(value);
+    }
+
+private:
+    // Records nested deeper than this are sent empty, which also ends recursive TYPEs
+    static constexpr int maxDepth = 4;
+
+    trx::runtime::JsonValue recordValue(const trx::ast::RecordDecl &record, int depth) {
+        auto value = trx::runtime::JsonValue::object();
+        if (depth >= maxDepth) {
+            return value;
+        }
+        for (const auto &field : record.fields) {
+            auto &slot = value.field(field.jsonName.empty() ? field.name.name : field.jsonName);
+            if (field.dimension > 1) {
+                auto list = trx::runtime::JsonValue::array();
+                const auto items = std::min<int>(field.dimension, 3);
+                for (int i = 0; i < items; ++i) {
+                    list.asArray().push_back(fieldValue(field, depth));
+                }
+                slot = std::move(list);
+            } else {
+                slot = fieldValue(field, depth);
+            }
+        }
+        return value;
+    }
+
+    trx::runtime::JsonValue fieldValue(const trx::ast::RecordField &field, int depth) {
+        const auto record = records_.find(field.typeName);
+        if (record != records_.end()) {
+            return recordValue(*record->second, depth + 1);
+        }
+        return scalar(field.typeName, field.length, field.scale.value_or(2));
+    }
+
+    trx::runtime::JsonValue scalar(std::string typeName, long length, int scale = 2) {
+        if (!typeName.empty() && typeName.front() == '_') {
+            typeName.erase(0, 1);
+        }
+        if (typeName == "INTEGER" || typeName == "SMALLINT") {
+            return trx::runtime::JsonValue(static_cast<double>(uniform(1, typeName == "SMALLINT" ? 100 : 1000)));
+        }
+        if (typeName == "DECIMAL" || typeName == "DOUBLE") {
+            const double factor = std::pow(10.0, std::clamp(scale, 0, 6));
+            return trx::runtime::JsonValue(static_cast<double>(uniform(0, 100000)) / factor);
+        }
+        if (typeName == "BOOLEAN") {
+            return trx::runtime::JsonValue(uniform(0, 1) == 1);
+        }
+        if (typeName == "DATE") {
+            char text[11];
+            std::snprintf(text, sizeof(text), "2024-%02d-%02d", uniform(1, 12), uniform(1, 28));
+            return trx::runtime::JsonValue(std::string(text));
+        }
+        if (typeName == "TIME") {
+            char text[9];
+            std::snprintf(text, sizeof(text), "%02d:%02d:%02d", uniform(0, 23), uniform(0, 59), uniform(0, 59));
+            return trx::runtime::JsonValue(std::string(text));
+        }
+        if (typeName == "JSON") {
+            return trx::runtime::JsonValue::object();
+        }
+        // CHAR, STRING and anything else the server reads as text, within the declared length
+        static constexpr std::string_view alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        const auto size = uniform(1, static_cast<int>(length > 0 ? std::min<long>(length, 12) : 12));
+        std::string text;
+        for (int i = 0; i < size; ++i) {
+            text += alphabet[static_cast<std::size_t>(uniform(0, static_cast<int>(alphabet.size()) - 1))];
+        }
+        return trx::runtime::JsonValue(std::move(text));
+    }
+
+    int uniform(int low, int high) { return std::uniform_int_distribution<int>(low, high)(random_); }
+
+    std::map<std::string, const trx::ast::RecordDecl *> records_;
+    std::mt19937_64 random_;
+};
+
+// Requests generated for each routine, so the hot loop only copies bytes to a socket
+constexpr std::size_t variantsPerRoutine = 64;
+
+std::vector<Target> buildTargets(const RoutineCatalog &catalog, const LoadOptions &options) {
+    PayloadGenerator generator(catalog.records, options.seed);
+    const std::string host = "Host: " + options.host + ":" + std::to_string(options.port) + "\r\n";
+    std::vector<Target> targets;
+    for (const auto &[key, procedure] : catalog.routineLookup) {
+        if (!options.routines.empty() &&
+            std::find(options.routines.begin(), options.routines.end(), procedure->name.baseName) == options.routines.end()) {
+            continue;
+        }
+        const auto method = key.substr(key.rfind('|') + 1);
+        const bool hasBody = method != "GET" && method != "HEAD" && method != "DELETE";
+        Target target;
+        target.name = method + " " + procedure->name.pathTemplate;
+        target.head = method == "HEAD";
+        for (std::size_t variant = 0; variant < variantsPerRoutine; ++variant) {
+            // Fill the {param} segments in order, as the router binds them
+            std::string path;
+            std::size_t param = 0;
+            std::string_view rest = procedure->name.pathTemplate;
+            while (!rest.empty()) {
+                const auto open = rest.find('{');
+                const auto close = open == std::string_view::npos ? std::string_view::npos : rest.find('}', open);
+                if (close == std::string_view::npos) {
+                    path += rest;
+                    break;
+                }
+                path += rest.substr(0, open);
+                const auto &params = procedure->name.pathParameters;
+                path += generator.pathValue(param < params.size() ? params[param].type.name : "CHAR");
+                ++param;
+                rest.remove_prefix(close + 1);
+            }
+
+            std::string request = method + " /api/" + path + " HTTP/1.1\r\n" + host;
+            if (hasBody) {
+                const auto body = generator.body(procedure->input ? procedure->input->type.name : "JSON");
+                request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            } else {
+                request += "\r\n";
+            }
+            target.requests.push_back(std::move(request));
+        }
+        targets.push_back(std::move(target));
+    }
+    return targets;
+}
+
+bool equalsIgnoreCase(std::string_view left, std::string_view right) {
+    return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin(), [](char a, char b) {
+               return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+           });
+}
+
+// Where a response starts and ends in a connection's read buffer
+struct ResponseFrame {
+    enum class State { Incomplete, Complete, UntilClose, Invalid } state{State::Incomplete};
+    std::size_t length{0};
+    int status{0};
+    bool keepAlive{true};
+};
+
+ResponseFrame frameResponse(std::string_view buffer, bool head) {
+    ResponseFrame frame;
+    const auto headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) {
+        return frame;
+    }
+    const auto statusStart = buffer.find(' ');
+    if (!buffer.starts_with("HTTP/1.") || statusStart == std::string_view::npos ||
+        std::from_chars(buffer.data() + statusStart + 1, buffer.data() + headerEnd, frame.status).ec != std::errc()) {
+        frame.state = ResponseFrame::State::Invalid;
+        return frame;
+    }
+    frame.keepAlive = !buffer.starts_with("HTTP/1.0");
+
+    std::optional<std::size_t> contentLength;
+    bool chunked = false;
+    auto lines = buffer.substr(0, headerEnd);
+    lines.remove_prefix(std::min(lines.size(), lines.find("\r\n")));
+    while (!lines.empty()) {
+        lines.remove_prefix(2);
+        const auto end = std::min(lines.size(), lines.find("\r\n"));
+        const auto line = lines.substr(0, end);
+        lines.remove_prefix(end);
+        const auto colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        const auto name = line.substr(0, colon);
+        auto value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ') {
+            value.remove_prefix(1);
+        }
+        if (equalsIgnoreCase(name, "Content-Length")) {
+            std::size_t length = 0;
+            std::from_chars(value.data(), value.data() + value.size(), length);
+            contentLength = length;
+        } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked = equalsIgnoreCase(value, "chunked");
+        } else if (equalsIgnoreCase(name, "Connection")) {
+            frame.keepAlive = !equalsIgnoreCase(value, "close");
+        }
+    }
+
+    const std::size_t bodyStart = headerEnd + 4;
+    if (head || frame.status == 204 || frame.status == 304 || frame.status < 200) {
+        frame.state = ResponseFrame::State::Complete;
+        frame.length = bodyStart;
+    } else if (chunked) {
+        // Streamed responses: hex size lines until the zero-length chunk
+        std::size_t position = bodyStart;
+        while (true) {
+            const auto lineEnd = buffer.find("\r\n", position);
+            if (lineEnd == std::string_view::npos) {
+                return frame;
+            }
+            std::size_t size = 0;
+            std::from_chars(buffer.data() + position, buffer.data() + lineEnd, size, 16);
+            if (size == 0) {
+                const auto trailerEnd = buffer.find("\r\n", lineEnd + 2);
+                if (trailerEnd == std::string_view::npos) {
+                    return frame;
+                }
+                frame.state = ResponseFrame::State::Complete;
+                frame.length = trailerEnd + 2;
+                break;
+            }
+            position = lineEnd + 2 + size + 2;
+            if (position > buffer.size()) {
+                return frame;
+            }
+        }
+    } else if (contentLength) {
+        if (buffer.size() >= bodyStart + *contentLength) {
+            frame.state = ResponseFrame::State::Complete;
+            frame.length = bodyStart + *contentLength;
+        }
+    } else {
+        frame.state = ResponseFrame::State::UntilClose;
+        frame.keepAlive = false;
+    }
+    return frame;
+}
+
+struct LoadResults {
+    LatencyRecorder latency;
+    std::array<std::uint64_t, 6> statusClasses{}; // index 2 counts 2xx, and so on; 0 for anything else
+    std::uint64_t sent{0};
+    std::uint64_t errors{0};   // requests lost to a failed connection or an unreadable response
+    std::uint64_t unsent{0};   // scheduled but still waiting for a connection when the run ended
+    std::uint64_t timedOut{0}; // still running when the timeout after the run expired
+    std::uint64_t reconnects{0};
+
+    void merge(const LoadResults &other) {
+        latency.merge(other.latency);
+        for (std::size_t i = 0; i < statusClasses.size(); ++i) {
+            statusClasses[i] += other.statusClasses[i];
+        }
+        sent += other.sent;
+        errors += other.errors;
+        unsent += other.unsent;
+        timedOut += other.timedOut;
+        reconnects += other.reconnects;
+    }
+};
+
+// One load thread: its own epoll loop, connections and share of the request rate
+class LoadWorker {
+public:
+    struct Schedule {
+        Clock::time_point first;    // when this worker sends its first request
+        Clock::duration interval;   // between its requests
+        Clock::time_point end;      // no request is scheduled from here on
+        Clock::duration timeout;    // how long requests in flight may run past |end|
+    };
+
+    LoadWorker(const addrinfo &address, const std::vector<Target> &targets, std::size_t connections, std::size_t firstTarget,
+               Schedule schedule)
+        : address_{address}, targets_{targets}, connections_(connections), nextTarget_{firstTarget}, schedule_{schedule} {}
+
+    LoadResults run() {
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        timerFd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (epollFd_ < 0 || timerFd_ < 0) {
+            std::cerr << "Failed to set up a load thread: " << std::strerror(errno) << "\n";
+            return std::move(results_);
+        }
+        epoll_event timerEvent{};
+        timerEvent.events = EPOLLIN;
+        timerEvent.data.u64 = timerToken;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &timerEvent);
+        for (std::size_t index = 0; index < connections_.size(); ++index) {
+            open(index);
+        }
+
+        auto next = schedule_.first;
+        const auto deadline = schedule_.end + schedule_.timeout;
+        std::array<epoll_event, 64> events;
+        while (true) {
+            const auto now = Clock::now();
+            for (; next <= now && next < schedule_.end; next += schedule_.interval) {
+                backlog_.push_back(next);
+            }
+            for (std::size_t index = 0; index < connections_.size(); ++index) {
+                if (connections_[index].state == Connection::State::Closed && connections_[index].retryAt <= now) {
+                    open(index);
+                }
+            }
+            dispatch();
+
+            if (now >= schedule_.end && (busy_ == 0 || now >= deadline)) {
+                break;
+            }
+            arm(next < schedule_.end ? next : (busy_ == 0 ? schedule_.end : deadline));
+
+            const int count = ::epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0 && errno != EINTR) {
+                std::cerr << "Load thread stopped: " << std::strerror(errno) << "\n";
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                if (events[static_cast<std::size_t>(i)].data.u64 == timerToken) {
+                    std::uint64_t expirations = 0;
+                    [[maybe_unused]] const auto ignored = ::read(timerFd_, &expirations, sizeof(expirations));
+                    continue;
+                }
+                handle(static_cast<std::size_t>(events[static_cast<std::size_t>(i)].data.u64), events[static_cast<std::size_t>(i)].events);
+            }
+        }
+
+        results_.unsent += backlog_.size();
+        results_.timedOut += busy_;
+        for (auto &connection : connections_) {
+            if (connection.fd >= 0) {
+                ::close(connection.fd);
+            }
+        }
+        ::close(timerFd_);
+        ::close(epollFd_);
+        return std::move(results_);
+    }
+
+private:
+    static constexpr std::uint64_t timerToken = ~std::uint64_t{0};
+    static constexpr auto retryDelay = std::chrono::milliseconds(100);
+
+    struct Connection {
+        enum class State { Closed, Connecting, Idle, Busy };
+        int fd{-1};
+        State state{State::Closed};
+        Clock::time_point retryAt{};
+        Clock::time_point scheduled{}; // when the request in flight was due
+        std::string_view request;      // its unsent bytes
+        bool head{false};
+        std::string response;
+    };
+
+    void open(std::size_t index) {
+        auto &connection = connections_[index];
+        connection.fd = ::socket(address_.ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (connection.fd < 0) {
+            connection.retryAt = Clock::now() + retryDelay;
+            return;
+        }
+        const int one = 1;
+        ::setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (::connect(connection.fd, address_.ai_addr, address_.ai_addrlen) < 0 && errno != EINPROGRESS) {
+            ::close(connection.fd);
+            connection.fd = -1;
+            connection.retryAt = Clock::now() + retryDelay;
+            return;
+        }
+        connection.state = Connection::State::Connecting;
+        connection.response.clear();
+        epoll_event event{};
+        event.events = EPOLLOUT;
+        event.data.u64 = index;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, connection.fd, &event);
+    }
+
+    // Drops a connection; a request it was running counts as an error unless |clean|
+    void close(std::size_t index, bool clean) {
+        auto &connection = connections_[index];
+        if (connection.state == Connection::State::Busy) {
+            --busy_;
+            if (!clean) {
+                ++results_.errors;
+            }
+        }
+        std::erase(idle_, index);
+        ::close(connection.fd);
+        connection.fd = -1;
+        connection.state = Connection::State::Closed;
+        connection.retryAt = Clock::now() + (clean ? Clock::duration::zero() : Clock::duration(retryDelay));
+        ++results_.reconnects;
+    }
+
+    void watch(std::size_t index, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = index;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, connections_[index].fd, &event);
+    }
+
+    // Sends due requests, oldest first, on the connections that are free
+    void dispatch() {
+        while (!backlog_.empty() && !idle_.empty()) {
+            const auto index = idle_.back();
+            idle_.pop_back();
+            auto &connection = connections_[index];
+            const auto &target = targets_[nextTarget_ % targets_.size()];
+            connection.request = target.requests[(nextTarget_ / targets_.size()) % target.requests.size()];
+            connection.head = target.head;
+            connection.scheduled = backlog_.front();
+            connection.state = Connection::State::Busy;
+            backlog_.pop_front();
+            ++nextTarget_;
+            ++busy_;
+            ++results_.sent;
+            write(index);
+        }
+    }
+
+    void write(std::size_t index) {
+        auto &connection = connections_[index];
+        while (!connection.request.empty()) {
+            const auto sent = ::send(connection.fd, connection.request.data(), connection.request.size(), MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    watch(index, EPOLLIN | EPOLLOUT);
+                    return;
+                }
+                close(index, false);
+                return;
+            }
+            connection.request.remove_prefix(static_cast<std::size_t>(sent));
+        }
+        watch(index, EPOLLIN);
+    }
+
+    void handle(std::size_t index, std::uint32_t events) {
+        auto &connection = connections_[index];
+        if (connection.fd < 0) {
+            return;
+        }
+        if (connection.state == Connection::State::Connecting) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            ::getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+                close(index, false);
+                return;
+            }
+            connection.state = Connection::State::Idle;
+            idle_.push_back(index);
+            watch(index, EPOLLIN);
+            dispatch();
+            return;
+        }
+        if ((events & EPOLLOUT) && connection.state == Connection::State::Busy && !connection.request.empty()) {
+            write(index);
+            if (connection.fd < 0) {
+                return;
+            }
+        }
+        if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            read(index);
+        }
+    }
+
+    void read(std::size_t index) {
+        auto &connection = connections_[index];
+        std::array<char, 16 * 1024> buffer;
+        bool closed = false;
+        while (true) {
+            const auto received = ::recv(connection.fd, buffer.data(), buffer.size(), 0);
+            if (received > 0) {
+                connection.response.append(buffer.data(), static_cast<std::size_t>(received));
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            closed = true;
+            break;
+        }
+
+        if (connection.state != Connection::State::Busy) {
+            // The server closed an idle keep-alive connection; open another
+            if (closed) {
+                close(index, true);
+            }
+            return;
+        }
+
+        const auto frame = frameResponse(connection.response, connection.head);
+        using State = ResponseFrame::State;
+        if (frame.state == State::Invalid || (closed && frame.state == State::Incomplete)) {
+            close(index, false);
+            return;
+        }
+        if (frame.state == State::Incomplete || (frame.state == State::UntilClose && !closed)) {
+            return;
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - connection.scheduled);
+        results_.latency.record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, elapsed.count())));
+        const auto statusClass = static_cast<std::size_t>(frame.status / 100);
+        ++results_.statusClasses[statusClass < results_.statusClasses.size() ? statusClass : 0];
+        --busy_;
+        connection.state = Connection::State::Idle;
+        if (closed || !frame.keepAlive) {
+            close(index, true);
+            return;
+        }
+        connection.response.erase(0, frame.length);
+        idle_.push_back(index);
+        dispatch();
+    }
+
+    void arm(Clock::time_point when) {
+        const auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(since / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(since % 1000000000);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1; // all zeroes would disarm the timer
+        }
+        ::timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    const addrinfo &address_;
+    const std::vector<Target> &targets_;
+    std::vector<Connection> connections_;
+    std::vector<std::size_t> idle_;
+    std::deque<Clock::time_point> backlog_; // due times of requests waiting for a free connection
+    std::size_t busy_{0};
+    std::size_t nextTarget_;
+    Schedule schedule_;
+    int epollFd_{-1};
+    int timerFd_{-1};
+    LoadResults results_;
+};
+
+std::string formatMicros(std::uint64_t micros) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(micros < 1000 ? 0 : 2);
+    if (micros < 1000) {
+        out << micros << "us";
+    } else if (micros < 1000000) {
+        out << static_cast<double>(micros) / 1e3 << "ms";
+    } else {
+        out << static_cast<double>(micros) / 1e6 << "s";
+    }
+    return out.str();
+}
+
+void printReport(const LoadResults &results, const LoadOptions &options, double elapsedSeconds) {
+    const auto completed = results.latency.count();
+    std::cout << "Requests: " << results.sent << " sent, " << completed << " completed, " << results.errors << " errors, "
+              << results.timedOut << " timed out, " << results.unsent << " not sent\n";
+    std::cout << std::fixed << std::setprecision(1) << "Throughput: " << static_cast<double>(completed) / elapsedSeconds
+              << " requests/s (target " << options.rate << ")\n";
+    std::cout << "Responses:";
+    for (std::size_t statusClass = 1; statusClass < results.statusClasses.size(); ++statusClass) {
+        if (results.statusClasses[statusClass] > 0) {
+            std::cout << ' ' << statusClass << "xx " << results.statusClasses[statusClass];
+        }
+    }
+    if (results.statusClasses[0] > 0) {
+        std::cout << " other " << results.statusClasses[0];
+    }
+    std::cout << "\nReconnects: " << results.reconnects << "\n";
+    if (results.unsent > 0) {
+        std::cout << "Warning: the server fell behind the schedule; the requests not sent were never measured\n";
+    }
+
+    std::cout << "Latency from the scheduled send time (mean " << formatMicros(static_cast<std::uint64_t>(results.latency.mean()))
+              << ", max " << formatMicros(results.latency.max()) << "):\n";
+    for (const double percentile : {50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0}) {
+        std::cout << "  " << std::setw(8) << std::setprecision(3) << percentile << "%  "
+                  << formatMicros(results.latency.percentile(percentile / 100.0)) << "\n";
+    }
+}
+
+} // namespace
+
+int runLoadGenerator(const std::vector<std::filesystem::path> &sourcePaths, const LoadOptions &options) {
+    const auto catalog = loadRoutineCatalog(sourcePaths);
+    if (!catalog) {
+        return 1;
+    }
+    const auto targets = buildTargets(*catalog, options);
+    if (targets.empty()) {
+        std::cerr << "None of the requested routines is exported by these sources\n";
+        return 1;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *resolved = nullptr;
+    if (const int error = ::getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &resolved); error != 0) {
+        std::cerr << "Cannot resolve " << options.host << ": " << ::gai_strerror(error) << "\n";
+        return 1;
+    }
+    const std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)> address(resolved, &::freeaddrinfo);
+
+    // Fail early rather than report a run of connection errors
+    {
+        const int probe = ::socket(address->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const bool reachable = probe >= 0 && ::connect(probe, address->ai_addr, address->ai_addrlen) == 0;
+        const int error = errno;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (!reachable) {
+            std::cerr << "Cannot connect to " << options.host << ":" << options.port << ": " << std::strerror(error) << "\n";
+            return 1;
+        }
+    }
+
+    const std::size_t connectionCount = std::max<std::size_t>(1, options.connections);
+    const std::size_t threadCount = std::clamp<std::size_t>(options.threadCount, 1, connectionCount);
+    std::cout << "Sending " << options.rate << " requests/s for " << options.durationSeconds << "s to " << options.host << ":"
+              << options.port << " over " << connectionCount << " connections and " << threadCount << " threads\n";
+    std::cout << "Routines:";
+    for (const auto &target : targets) {
+        std::cout << ' ' << target.name;
+    }
+    std::cout << "\n";
+
+    // Each thread sends every threadCount-th request of the overall schedule
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.rate));
+    const auto start = Clock::now() + std::chrono::milliseconds(100); // let the connections open first
+    LoadWorker::Schedule schedule;
+    schedule.interval = interval * static_cast<Clock::rep>(threadCount);
+    schedule.end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.durationSeconds));
+    schedule.timeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.timeoutSeconds));
+
+    std::vector<LoadResults> results(threadCount);
+    std::vector<std::thread> threads;
+    for (std::size_t thread = 0; thread < threadCount; ++thread) {
+        const std::size_t connections = connectionCount / threadCount + (thread < connectionCount % threadCount ? 1 : 0);
+        schedule.first = start + interval * static_cast<Clock::rep>(thread);
+        threads.emplace_back([&, thread, connections, schedule] {
+            results[thread] = LoadWorker(*address, targets, connections, thread, schedule).run();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const double elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LoadResults total;
+    for (const auto &result : results) {
+        total.merge(result);
+    }
+    printReport(total, options, elapsedSeconds);
+    return total.errors > 0 || total.timedOut > 0 ? 2 : 0;
+}
+
+} // namespace trx::cli
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::cli {
+
+struct LoadOptions {
+    std::string host{"127.0.0.1"};
+    int port{8080};
+    double rate{1000.0};             // requests per second over all connections
+    double durationSeconds{10.0};
+    std::size_t connections{64};     // keep-alive connections, spread over the threads
+    std::size_t threadCount{std::thread::hardware_concurrency()};
+    double timeoutSeconds{5.0};      // wait for requests still running once the duration is over
+    std::vector<std::string> routines; // names to call; empty for every routine /swagger.json lists
+    std::uint64_t seed{1};           // payloads are generated from it, so runs send the same requests
+};
+
+/**
+ * `trx bench-http`: drives a running `trx serve` at a fixed request rate. The routines
+ * and their payload TYPEs come from the same sources the server loaded; each routine
+ * gets a set of requests generated up front, with random path parameters and bodies
+ * filled in field by field from its input TYPE.
+ *
+ * The load is open-loop: every thread sends on a fixed schedule, whatever the server's
+ * latency, over its own keep-alive connections. A request's latency is measured from
+ * the time it was scheduled, not the time a connection became free to send it, so
+ * time spent queued behind slow responses is counted (no coordinated omission). The
+ * report gives HdrHistogram-style percentiles to three significant digits.
+ */
+int runLoadGenerator(const std::vector<std::filesystem::path> &sourcePaths, const LoadOptions &options);
+
+} // namespace trx::cli
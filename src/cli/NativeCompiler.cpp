@@ -0,0 +1,100 @@
+#include "NativeCompiler.h"
+#include "Server.h"
+
+#include "trx/runtime/Bytecode.h"
+#include "trx/runtime/Interpreter.h"
+#include "trx/runtime/NativeLibrary.h"
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+extern char **environ;
+
+namespace trx::cli {
+namespace {
+
+// Runs |arguments| without a shell and waits for it; true when it exits with status 0
+bool runCommand(const std::vector<std::string> &arguments) {
+    std::vector<char *> argv;
+    for (const auto &argument : arguments) {
+        argv.push_back(const_cast<char *>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+    pid_t pid = 0;
+    if (const int error = ::posix_spawnp(&pid, argv.front(), nullptr, nullptr, argv.data(), environ); error != 0) {
+        std::cerr << "Unable to run " << arguments.front() << ": " << std::strerror(error) << "\n";
+        return false;
+    }
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+int runCompile(const std::vector<std::filesystem::path> &sourcePaths, const CompileOptions &options) {
+    const auto catalog = loadRoutineCatalog(sourcePaths);
+    if (!catalog) {
+        return 1;
+    }
+
+    // The interpreter resolves and folds the module as serve will, so the bytecode
+    // translated here is the bytecode the library is later checked against
+    std::unique_ptr<trx::runtime::Interpreter> interpreter;
+    try {
+        interpreter = std::make_unique<trx::runtime::Interpreter>(catalog->module, trx::runtime::createDatabaseDriver(options.dbConfig));
+    } catch (const std::exception &error) {
+        std::cerr << "Failed to load the module: " << error.what() << "\n";
+        return 1;
+    }
+    std::vector<trx::runtime::NativeSource> routines;
+    for (const auto &decl : catalog->module.declarations) {
+        const auto *procedure = std::get_if<trx::ast::ProcedureDecl>(&decl);
+        // A later routine of the same name replaces an earlier one, in serve as here
+        if (!procedure || interpreter->getRoutine(procedure->name.baseName) != procedure) {
+            continue;
+        }
+        if (const auto *program = interpreter->programFor(procedure)) {
+            routines.push_back({procedure->name.baseName, program});
+        }
+    }
+
+    const auto cppPath = options.cppOutput ? *options.cppOutput : std::filesystem::path(options.output.string() + ".cpp");
+    {
+        std::ofstream out(cppPath);
+        out << trx::runtime::translateRoutines(routines);
+        if (!out) {
+            std::cerr << "Unable to write " << cppPath.string() << "\n";
+            return 1;
+        }
+    }
+
+    const char *compiler = std::getenv("CXX");
+    const char *includeDir = std::getenv("TRX_INCLUDE_DIR");
+    const bool built = runCommand({compiler && *compiler ? compiler : "c++", "-std=c++20", "-O2", "-shared", "-fPIC",
+                                   std::string("-I") + (includeDir && *includeDir ? includeDir : TRX_INCLUDE_DIR), "-o",
+                                   options.output.string(), cppPath.string()});
+    if (!options.cppOutput) {
+        std::error_code ignored;
+        std::filesystem::remove(cppPath, ignored);
+    }
+    if (!built) {
+        std::cerr << "Failed to build " << options.output.string() << "\n";
+        return 1;
+    }
+    std::cout << "Compiled " << routines.size() << " routine(s) into " << options.output.string() << "\n";
+    return 0;
+}
+
+} // namespace trx::cli
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "trx/runtime/DatabaseDriver.h"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace trx::cli {
+
+struct CompileOptions {
+    std::filesystem::path output{"trx_native.so"};
+    std::optional<std::filesystem::path> cppOutput; // keep the generated C++ here
+    trx::runtime::DatabaseConfig dbConfig;          // tables are created in it while the module loads
+};
+
+/**
+ * `trx compile`: loads the sources the way serve does, translates the bytecode of each
+ * routine into C++ (see NativeLibrary.h) and builds that into a shared library with
+ * $CXX (default c++) against the runtime's headers. `trx serve --native` runs routines
+ * on it; routines whose bytecode has changed since are interpreted as before.
+ */
+int runCompile(const std::vector<std::filesystem::path> &sourcePaths, const CompileOptions &options);
+
+} // namespace trx::cli
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "trx/ast/Nodes.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace trx::cli {
+
+// Exported routines compiled once into a trie of path segments, one per HTTP method.
+// Lookup walks the request path segment by segment without allocating; {param}
+// segments only match values their declared type can be converted from.
+class RouteTable {
+public:
+    static constexpr std::size_t maxParams = 16;
+
+    struct Match {
+        const trx::ast::ProcedureDecl *procedure{nullptr};
+        std::array<std::string_view, maxParams> values; // path parameter values, in template order
+        std::size_t count{0};
+
+        std::map<std::string, std::string> parameters() const {
+            std::map<std::string, std::string> params;
+            for (std::size_t i = 0; i < count && i < procedure->name.pathParameters.size(); ++i) {
+                params.emplace(procedure->name.pathParameters[i].name.name, std::string(values[i]));
+            }
+            return params;
+        }
+    };
+
+    void add(const std::string &method, const trx::ast::ProcedureDecl *procedure) {
+        Node *node = &root(method);
+        std::size_t paramIndex = 0;
+        forEachSegment(procedure->name.pathTemplate, [&](std::string_view segment) {
+            if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}') {
+                const auto &params = procedure->name.pathParameters;
+                const auto kind = paramIndex < params.size() ? kindOf(params[paramIndex].type.name) : ParamKind::Text;
+                ++paramIndex;
+                auto &child = node->params[static_cast<std::size_t>(kind)];
+                if (!child) {
+                    child = std::make_unique<Node>();
+                }
+                node = child.get();
+                return;
+            }
+            auto it = std::lower_bound(node->literals.begin(), node->literals.end(), segment,
+                                       [](const auto &entry, std::string_view value) { return entry.first < value; });
+            if (it == node->literals.end() || it->first != segment) {
+                it = node->literals.emplace(it, std::string(segment), std::make_unique<Node>());
+            }
+            node = it->second.get();
+        });
+        node->procedure = procedure;
+    }
+
+    bool match(std::string_view method, std::string_view path, Match &result) const {
+        if (!path.empty() && path.front() == '/') {
+            path.remove_prefix(1);
+        }
+        if (path.starts_with("api/")) {
+            path.remove_prefix(4);
+        }
+        for (const auto &[candidate, node] : methods_) {
+            if (candidate == method) {
+                return matchNode(*node, path, 0, result);
+            }
+        }
+        return false;
+    }
+
+private:
+    // Tried in this order, so /{id: INTEGER} wins over /{name: CHAR} for numeric segments
+    enum class ParamKind { Integer, Decimal, Boolean, Text, Count };
+
+    struct Node {
+        std::vector<std::pair<std::string, std::unique_ptr<Node>>> literals; // sorted by segment
+        std::array<std::unique_ptr<Node>, static_cast<std::size_t>(ParamKind::Count)> params;
+        const trx::ast::ProcedureDecl *procedure{nullptr};
+    };
+
+    static ParamKind kindOf(const std::string &typeName) {
+        // Same conversions as the interpreter applies to path parameters
+        if (typeName == "INTEGER") {
+            return ParamKind::Integer;
+        }
+        if (typeName == "DECIMAL" || typeName == "DOUBLE") {
+            return ParamKind::Decimal;
+        }
+        if (typeName == "BOOLEAN") {
+            return ParamKind::Boolean;
+        }
+        return ParamKind::Text;
+    }
+
+    static bool accepts(ParamKind kind, std::string_view value) {
+        if (value.empty()) {
+            return false;
+        }
+        switch (kind) {
+        case ParamKind::Integer:
+        case ParamKind::Decimal: {
+            std::size_t i = value.front() == '-' ? 1 : 0;
+            bool digits = false;
+            bool point = false;
+            for (; i < value.size(); ++i) {
+                if (std::isdigit(static_cast<unsigned char>(value[i]))) {
+                    digits = true;
+                } else if (value[i] == '.' && kind == ParamKind::Decimal && !point) {
+                    point = true;
+                } else {
+                    return false;
+                }
+            }
+            return digits;
+        }
+        case ParamKind::Boolean:
+            return value == "true" || value == "false" || value == "1" || value == "0";
+        default:
+            return true;
+        }
+    }
+
+    template <typename Fn>
+    static void forEachSegment(std::string_view path, Fn &&fn) {
+        while (true) {
+            const auto slash = path.find('/');
+            fn(path.substr(0, slash));
+            if (slash == std::string_view::npos) {
+                return;
+            }
+            path.remove_prefix(slash + 1);
+        }
+    }
+
+    Node &root(const std::string &method) {
+        for (auto &[candidate, node] : methods_) {
+            if (candidate == method) {
+                return *node;
+            }
+        }
+        methods_.emplace_back(method, std::make_unique<Node>());
+        return *methods_.back().second;
+    }
+
+    // Literal segments are preferred; a parameter branch is only taken when the
+    // rest of the path also matches beneath it
+    static bool matchNode(const Node &node, std::string_view rest, std::size_t paramIndex, Match &result) {
+        const auto slash = rest.find('/');
+        const std::string_view segment = rest.substr(0, slash);
+        const bool last = slash == std::string_view::npos;
+        const std::string_view tail = last ? std::string_view() : rest.substr(slash + 1);
+
+        const auto descend = [&](const Node &child, std::size_t nextParam) {
+            if (last) {
+                if (!child.procedure) {
+                    return false;
+                }
+                result.procedure = child.procedure;
+                result.count = nextParam;
+                return true;
+            }
+            return matchNode(child, tail, nextParam, result);
+        };
+
+        auto it = std::lower_bound(node.literals.begin(), node.literals.end(), segment,
+                                   [](const auto &entry, std::string_view value) { return entry.first < value; });
+        if (it != node.literals.end() && it->first == segment && descend(*it->second, paramIndex)) {
+            return true;
+        }
+        if (paramIndex >= maxParams) {
+            return false;
+        }
+        for (std::size_t kind = 0; kind < node.params.size(); ++kind) {
+            if (node.params[kind] && accepts(static_cast<ParamKind>(kind), segment)) {
+                result.values[paramIndex] = segment;
+                if (descend(*node.params[kind], paramIndex + 1)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::pair<std::string, std::unique_ptr<Node>>> methods_;
+};
+
+} // namespace trx::cli
@@ -1,133 +1,180 @@
 #include "Server.h"
+#include "RouteTable.h"
+#include "WorkerProcesses.h"
 
 #include "trx/ast/Nodes.h"
 #include "trx/ast/Statements.h"
 #include "trx/parsing/ParserDriver.h"
+#include "trx/runtime/ConnectionPool.h"
+#include "trx/runtime/Fiber.h"
 #include "trx/runtime/Interpreter.h"
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/JsonWriter.h"
+#include "trx/runtime/JobQueue.h"
+#include "trx/runtime/LatencyHistogram.h"
+#include "trx/runtime/NativeLibrary.h"
+#include "trx/runtime/Logger.h"
+#include "trx/runtime/Profiler.h"
+#include "trx/runtime/RequestArena.h"
+#include "trx/runtime/ResponseCache.h"
+#include "trx/runtime/SqlStatistics.h"
 #include "trx/runtime/ThreadPool.h"
+#include "trx/runtime/Tracing.h"
 #include "trx/runtime/TrxException.h"
 #include "trx/diagnostics/DiagnosticEngine.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <arpa/inet.h>
 #include <cerrno>
 #include <cctype>
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <csignal>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <set>
 #include <optional>
-#include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <thread>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace trx::cli {
 namespace {
 
-// Helper function to match path against template and extract parameters
-std::optional<std::pair<const trx::ast::ProcedureDecl *, std::map<std::string, std::string>>> matchPathTemplate(
-    const std::string &requestPath, 
-    const std::string &requestMethod,
-    const std::map<std::string, const trx::ast::ProcedureDecl *> &routineLookup) {
-    std::string path = requestPath;
-    if (!path.empty() && path[0] == '/') {
-        path = path.substr(1);
+struct Metrics {
+    std::atomic<size_t> totalRequests{0};
+    std::atomic<size_t> activeRequests{0};
+    std::atomic<size_t> errorRequests{0};
+};
+
+Metrics g_metrics;
+
+// Request durations by routine and status code, published as the
+// trx_request_duration_seconds histogram. Every series is known at startup, so
+// recording is an index computation plus relaxed atomic increments.
+class RequestLatency {
+public:
+    static constexpr std::size_t unmatched = 0; // requests that matched no route
+    static constexpr std::size_t builtin = 1;   // swagger, /procedures, /metrics and OPTIONS
+
+    RequestLatency(const std::vector<const trx::ast::ProcedureDecl *> &procedures, std::size_t shardCount)
+        : labels_{"_unmatched", "_builtin"}, histogram_(seriesFor(procedures, labels_, routineIndex_), shardCount) {}
+
+    std::size_t routineIndex(const trx::ast::ProcedureDecl *procedure) const {
+        const auto it = routineIndex_.find(procedure);
+        return it != routineIndex_.end() ? it->second : unmatched;
     }
-    if (path.starts_with("api/")) {
-        path = path.substr(4);
+
+    void observe(std::size_t routine, int status, double seconds) {
+        histogram_.observe(ThreadPool::currentWorkerIndex(), routine * statuses.size() + statusSlot(status), seconds);
     }
-    
-    for (const auto &[key, proc] : routineLookup) {
-        const std::string &templatePath = proc->name.pathTemplate;
-        
-        // Check HTTP method first
-        std::string defaultMethod = proc->input ? "POST" : "GET";
-        std::string expectedMethod = proc->httpMethod.value_or(defaultMethod);
-        if (requestMethod != expectedMethod) {
-            continue; // Method doesn't match, skip this routine
-        }
-        
-        // Simple exact match for now (backward compatibility)
-        if (path == templatePath) {
-            return std::make_pair(proc, std::map<std::string, std::string>{});
-        }
-        
-        // Check if template has parameters
-        if (!proc->name.pathParameters.empty()) {
-            // Build regex pattern from template
-            std::string pattern = templatePath;
-            // Escape special regex characters except {
-            std::string escaped;
-            for (char c : pattern) {
-                if (c == '{' || c == '}') {
-                    escaped += c;
-                } else if (std::string(".*+?^$()[]{}|\\").find(c) != std::string::npos) {
-                    escaped += '\\';
-                    escaped += c;
-                } else {
-                    escaped += c;
-                }
+
+    void write(std::ostream &out) const {
+        trx::runtime::LatencyHistogram::Snapshot total;
+        std::ostringstream series;
+        for (std::size_t index = 0; index < histogram_.seriesCount(); ++index) {
+            const auto snapshot = histogram_.snapshot(index);
+            if (snapshot.count == 0) {
+                continue;
             }
-            // Replace {param} with regex capture group
-            size_t pos = 0;
-            while ((pos = escaped.find("{", pos)) != std::string::npos) {
-                size_t endPos = escaped.find("}", pos);
-                if (endPos != std::string::npos) {
-                    std::string paramName = escaped.substr(pos + 1, endPos - pos - 1);
-                    escaped.replace(pos, endPos - pos + 1, "([^/]+)");
-                    pos += std::string("([^/]+)").length();
-                } else {
-                    break;
-                }
+            total.count += snapshot.count;
+            total.sum += snapshot.sum;
+
+            const std::size_t slot = index % statuses.size();
+            const std::string labels = "routine=\"" + labels_[index / statuses.size()] + "\",status=\"" +
+                                       (statuses[slot] != 0 ? std::to_string(statuses[slot]) : std::string("other")) + "\"";
+            const auto &bounds = trx::runtime::LatencyHistogram::bucketBounds;
+            for (std::size_t b = 0; b < bounds.size(); ++b) {
+                series << "trx_request_duration_seconds_bucket{" << labels << ",le=\"" << bounds[b] << "\"} " << snapshot.buckets[b] << "\n";
             }
-            
-            std::regex pathRegex("^" + escaped + "$");
-            std::smatch matches;
-            if (std::regex_match(path, matches, pathRegex)) {
-                std::map<std::string, std::string> params;
-                // matches[0] is the full match, captures start from matches[1]
-                for (size_t i = 1; i < matches.size() && i - 1 < proc->name.pathParameters.size(); ++i) {
-                    params[proc->name.pathParameters[i - 1].name.name] = matches[i].str();
-                }
-                return std::make_pair(proc, params);
+            series << "trx_request_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << snapshot.count << "\n";
+            series << "trx_request_duration_seconds_sum{" << labels << "} " << snapshot.sum << "\n";
+            series << "trx_request_duration_seconds_count{" << labels << "} " << snapshot.count << "\n";
+        }
+
+        out << "# HELP trx_average_duration_ms Average request duration in milliseconds since startup\n";
+        out << "# TYPE trx_average_duration_ms gauge\n";
+        out << "trx_average_duration_ms " << (total.count > 0 ? total.sum * 1000.0 / static_cast<double>(total.count) : 0.0) << "\n\n";
+
+        out << "# HELP trx_request_duration_seconds Request duration by routine and HTTP status\n";
+        out << "# TYPE trx_request_duration_seconds histogram\n";
+        out << series.str();
+    }
+
+private:
+    // Status codes the server produces; anything else is counted as "other" (0)
+    static constexpr std::array<int, 10> statuses{200, 201, 204, 400, 404, 405, 413, 500, 504, 0};
+
+    static std::size_t statusSlot(int status) {
+        for (std::size_t i = 0; i + 1 < statuses.size(); ++i) {
+            if (statuses[i] == status) {
+                return i;
             }
         }
+        return statuses.size() - 1;
     }
-    
-    return std::nullopt;
-}
 
-struct Metrics {
-    std::atomic<size_t> totalRequests{0};
-    std::atomic<size_t> activeRequests{0};
-    std::atomic<size_t> errorRequests{0};
-    std::mutex durationMutex;
-    std::vector<double> requestDurations; // in milliseconds
-    double averageDuration = 0.0;
+    // One label per routine name; routines sharing a name under different methods share it
+    static std::size_t seriesFor(const std::vector<const trx::ast::ProcedureDecl *> &procedures, std::vector<std::string> &labels,
+                                 std::unordered_map<const trx::ast::ProcedureDecl *, std::size_t> &index) {
+        for (const auto *procedure : procedures) {
+            auto existing = std::find(labels.begin(), labels.end(), procedure->name.baseName);
+            index[procedure] = static_cast<std::size_t>(existing - labels.begin());
+            if (existing == labels.end()) {
+                labels.push_back(procedure->name.baseName);
+            }
+        }
+        return labels.size() * statuses.size();
+    }
+
+    std::vector<std::string> labels_;
+    std::unordered_map<const trx::ast::ProcedureDecl *, std::size_t> routineIndex_;
+    trx::runtime::LatencyHistogram histogram_;
 };
 
-Metrics g_metrics;
+// Interpreter owned by a pool worker, or by one of its fibers. The mutex is only
+// contended when several workers share a slot (single-connection databases).
+struct WorkerSlot {
+    std::unique_ptr<trx::runtime::Interpreter> interpreter;
+    std::mutex mutex;
+    trx::runtime::RequestArena arena; // the parsed payload lives here until the response is built
+};
 
 std::atomic<bool> g_stopServer{false};
+std::atomic<bool> g_reloadSources{false};
 
 void handleSignal(int signum) {
-    if (signum == SIGINT) {
+    if (signum == SIGINT || signum == SIGTERM) {
         g_stopServer.store(true);
+    } else if (signum == SIGHUP) {
+        g_reloadSources.store(true);
     }
 }
 
@@ -190,8 +237,10 @@ std::vector<std::filesystem::path> collectSourceFiles(const std::filesystem::pat
 struct HttpRequest {
     std::string method;
     std::string path;
+    std::string version;
     std::map<std::string, std::string> headers;
     std::string body;
+    bool keepAlive{false}; // HTTP/1.1 unless "Connection: close"; HTTP/1.0 only with "Connection: keep-alive"
 };
 
 struct HttpResponse {
@@ -204,378 +253,270 @@ struct HttpResponse {
 std::string statusMessage(int status) {
     switch (status) {
     case 200: return "OK";
+    case 201: return "Created";
     case 204: return "No Content";
     case 400: return "Bad Request";
     case 404: return "Not Found";
     case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 424: return "Failed Dependency";
     case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
     default: return "Unknown";
     }
 }
 
-void sendHttpResponse(int clientFd, const HttpResponse &response) {
-    std::ostringstream stream;
-    stream << "HTTP/1.1 " << response.status << ' ' << statusMessage(response.status) << "\r\n";
-    stream << "Content-Type: " << response.contentType << "\r\n";
-    stream << "Access-Control-Allow-Origin: *\r\n";
-    for (const auto &header : response.extraHeaders) {
-        stream << header.first << ": " << header.second << "\r\n";
-    }
+// A response ready for the socket. The body is moved in as the handler built it and
+// sent behind the head in the same sendmsg call rather than copied after it.
+struct SerializedResponse {
+    std::string head;
+    std::string body;
 
-    const std::string &body = response.body;
-    stream << "Content-Length: " << body.size() << "\r\n";
-    stream << "Connection: close\r\n\r\n";
-    stream << body;
+    std::size_t size() const { return head.size() + body.size(); }
+};
 
-    const std::string data = stream.str();
-    std::size_t sent = 0;
-    while (sent < data.size()) {
-        const ssize_t written = ::send(clientFd, data.data() + sent, data.size() - sent, 0);
-        if (written <= 0) {
-            break;
-        }
-        sent += static_cast<std::size_t>(written);
-    }
+void appendDecimal(std::string &out, long long value) {
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
 }
 
-bool readHttpRequest(int clientFd, HttpRequest &request) {
-    std::string buffer;
-    buffer.reserve(4096);
-
-    std::string headers;
-    std::string body;
-
-    std::optional<std::size_t> contentLength;
-    while (true) {
-        char chunk[2048];
-        const ssize_t received = ::recv(clientFd, chunk, sizeof(chunk), 0);
-        if (received <= 0) {
-            return false;
-        }
-        buffer.append(chunk, static_cast<std::size_t>(received));
+// Status line and headers; without a content length the body follows in chunks
+std::string serializeHttpHead(const HttpResponse &response, std::optional<std::size_t> contentLength, bool keepAlive,
+                              std::chrono::seconds keepAliveTimeout) {
+    std::string head;
+    head.reserve(256);
+    head.append("HTTP/1.1 ");
+    appendDecimal(head, response.status);
+    head.push_back(' ');
+    head.append(statusMessage(response.status));
+    head.append("\r\nContent-Type: ");
+    head.append(response.contentType);
+    head.append("\r\nAccess-Control-Allow-Origin: *\r\n");
+    for (const auto &header : response.extraHeaders) {
+        head.append(header.first);
+        head.append(": ");
+        head.append(header.second);
+        head.append("\r\n");
+    }
+    if (contentLength) {
+        head.append("Content-Length: ");
+        appendDecimal(head, static_cast<long long>(*contentLength));
+    } else {
+        head.append("Transfer-Encoding: chunked");
+    }
+    if (keepAlive) {
+        head.append("\r\nConnection: keep-alive\r\nKeep-Alive: timeout=");
+        appendDecimal(head, keepAliveTimeout.count());
+        head.append("\r\n\r\n");
+    } else {
+        head.append("\r\nConnection: close\r\n\r\n");
+    }
+    return head;
+}
 
-        const auto headerEnd = buffer.find("\r\n\r\n");
-        if (!contentLength.has_value() && headerEnd != std::string::npos) {
-            headers = buffer.substr(0, headerEnd);
-            body = buffer.substr(headerEnd + 4);
+SerializedResponse serializeHttpResponse(HttpResponse response, bool keepAlive, std::chrono::seconds keepAliveTimeout) {
+    SerializedResponse serialized;
+    serialized.head = serializeHttpHead(response, response.body.size(), keepAlive, keepAliveTimeout);
+    serialized.body = std::move(response.body);
+    return serialized;
+}
 
-            std::istringstream headerStream(headers);
-            std::string requestLine;
-            if (!std::getline(headerStream, requestLine)) {
-                return false;
-            }
-            if (!requestLine.empty() && requestLine.back() == '\r') {
-                requestLine.pop_back();
-            }
-            std::istringstream lineStream(requestLine);
-            std::string version;
-            if (!(lineStream >> request.method >> request.path >> version)) {
-                return false;
-            }
+/**
+ * Body of a response sent while its routine runs, as HTTP/1.1 chunks. The event loop
+ * leaves a connection alone while a worker holds its request, so the worker writes to
+ * the socket itself; when the client reads slower than rows are produced the routine
+ * waits, and no more than one chunk is ever buffered. Nothing is written before the
+ * first chunk fills, so a routine that fails early still gets a plain error response.
+ */
+class ResponseStream {
+public:
+    static constexpr std::size_t kChunkBytes = 16 * 1024;
+    static constexpr int kWriteTimeoutMs = 30000;
 
-            std::string headerLine;
-            while (std::getline(headerStream, headerLine)) {
-                if (!headerLine.empty() && headerLine.back() == '\r') {
-                    headerLine.pop_back();
-                }
-                if (headerLine.empty()) {
-                    continue;
-                }
-                const auto colonPos = headerLine.find(':');
-                if (colonPos == std::string::npos) {
-                    continue;
-                }
-                std::string key = headerLine.substr(0, colonPos);
-                std::string value = headerLine.substr(colonPos + 1);
-                while (!value.empty() && value.front() == ' ') {
-                    value.erase(value.begin());
-                }
-                // normalize header names to lowercase for lookups
-                std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-                request.headers.emplace(std::move(key), std::move(value));
-            }
+    ResponseStream(int fd, bool keepAlive, std::chrono::seconds keepAliveTimeout)
+        : fd_{fd}, keepAlive_{keepAlive}, keepAliveTimeout_{keepAliveTimeout} {}
 
-            auto contentLengthIt = request.headers.find("content-length");
-            if (contentLengthIt != request.headers.end()) {
-                try {
-                    contentLength = static_cast<std::size_t>(std::stoul(contentLengthIt->second));
-                } catch (const std::exception &) {
-                    return false;
-                }
-            } else {
-                contentLength = body.size();
-            }
-        }
+    // Sends the status line and headers of |head|; its body is not used
+    void begin(const HttpResponse &head) {
+        buffer_ = serializeHttpHead(head, std::nullopt, keepAlive_, keepAliveTimeout_);
+        headBytes_ = buffer_.size();
+        started_ = true;
+    }
 
-        if (contentLength.has_value() && body.size() >= contentLength.value()) {
-            break;
-        }
+    // Body bytes are appended here, then sent by flushIfFull() or finish()
+    std::string &buffer() { return buffer_; }
 
-        if (contentLength.has_value() && body.size() < contentLength.value()) {
-            const std::size_t missing = contentLength.value() - body.size();
-            if (missing > 0) {
-                continue;
-            }
+    void flushIfFull() {
+        if (buffer_.size() - headBytes_ >= kChunkBytes) {
+            flush();
         }
     }
 
-    if (!contentLength.has_value()) {
-        contentLength = 0;
+    // Sends what is buffered and the terminating chunk
+    void finish() {
+        flush();
+        send("0\r\n\r\n");
+        finished_ = true;
     }
 
-    const auto headerEnd = buffer.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        return false;
-    }
-    headers = buffer.substr(0, headerEnd);
-    body = buffer.substr(headerEnd + 4);
-    if (body.size() > contentLength.value()) {
-        body.resize(contentLength.value());
-    }
+    bool started() const { return started_; }
+    // Bytes reached the socket, so the handler's own response can no longer be sent
+    bool committed() const { return committed_; }
+    bool finished() const { return finished_; }
 
-    // trim query string from path
-    if (const auto question = request.path.find('?'); question != std::string::npos) {
-        request.path.erase(question);
+private:
+    void flush() {
+        const std::size_t bodyBytes = buffer_.size() - headBytes_;
+        if (bodyBytes == 0) {
+            send(buffer_);
+        } else {
+            char size[24];
+            auto *end = std::to_chars(size, size + sizeof(size) - 2, bodyBytes, 16).ptr;
+            *end++ = '\r';
+            *end++ = '\n';
+            buffer_.insert(headBytes_, size, static_cast<std::size_t>(end - size));
+            buffer_.append("\r\n");
+            send(buffer_);
+        }
+        buffer_.clear();
+        headBytes_ = 0;
     }
 
-    request.body = std::move(body);
-    return true;
-}
+    // Blocks until everything is written. Throwing stops the routine: a client that went
+    // away or stopped reading will not take the rest of the response.
+    void send(std::string_view data) {
+        committed_ = true;
+        while (!data.empty()) {
+            const ssize_t written = ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+            if (written > 0) {
+                data.remove_prefix(static_cast<std::size_t>(written));
+                continue;
+            }
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                const short writable = trx::runtime::waitForIo(fd_, POLLOUT, std::chrono::milliseconds(kWriteTimeoutMs));
+                if (writable != 0 && !(writable & (POLLERR | POLLHUP))) {
+                    continue;
+                }
+            }
+            throw std::runtime_error("Client stopped reading the streamed response");
+        }
+    }
 
-struct JsonParseError : std::runtime_error {
-    using std::runtime_error::runtime_error;
+    int fd_;
+    bool keepAlive_;
+    std::chrono::seconds keepAliveTimeout_;
+    std::string buffer_;
+    std::size_t headBytes_{0}; // head bytes at the front of buffer_ until the first chunk goes out
+    bool started_{false};
+    bool committed_{false};
+    bool finished_{false};
 };
 
-class JsonParser {
-public:
-    explicit JsonParser(std::string_view text) : text_(text) {}
+enum class ParseStatus {
+    Incomplete,
+    Complete,
+    Invalid,
+    TooLarge
+};
 
-    trx::runtime::JsonValue parse() {
-        skipWhitespace();
-        auto value = parseValue();
-        skipWhitespace();
-        if (position_ != text_.size()) {
-            throw JsonParseError("Unexpected trailing data in JSON payload");
-        }
-        return value;
-    }
+constexpr std::size_t kMaxHeaderBytes = 64 * 1024;
+constexpr std::size_t kMaxBodyBytes = 32 * 1024 * 1024;
 
-private:
-    std::string_view text_;
-    std::size_t position_{0};
+std::string toLowerCopy(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
 
-    bool eof() const {
-        return position_ >= text_.size();
+// Parse one request from the front of buffer. The bytes of a complete request are
+// erased; anything after it (a pipelined request) stays in the buffer for the next call.
+ParseStatus parseHttpRequest(std::string &buffer, HttpRequest &request) {
+    const auto headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return buffer.size() > kMaxHeaderBytes ? ParseStatus::TooLarge : ParseStatus::Incomplete;
     }
-
-    char peek() const {
-        if (eof()) {
-            return '\0';
-        }
-        return text_[position_];
+    if (headerEnd > kMaxHeaderBytes) {
+        return ParseStatus::TooLarge;
     }
 
-    char consume() {
-        if (eof()) {
-            throw JsonParseError("Unexpected end of JSON payload");
-        }
-        return text_[position_++];
+    request = HttpRequest{};
+    std::istringstream headerStream(buffer.substr(0, headerEnd));
+    std::string requestLine;
+    if (!std::getline(headerStream, requestLine)) {
+        return ParseStatus::Invalid;
     }
-
-    void expect(char expected) {
-        const char actual = consume();
-        if (actual != expected) {
-            throw JsonParseError("Unexpected character in JSON payload");
-        }
+    if (!requestLine.empty() && requestLine.back() == '\r') {
+        requestLine.pop_back();
     }
-
-    void skipWhitespace() {
-        while (!eof()) {
-            const char c = peek();
-            if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
-                ++position_;
-            } else {
-                break;
-            }
-        }
+    std::istringstream lineStream(requestLine);
+    if (!(lineStream >> request.method >> request.path >> request.version) || request.version.rfind("HTTP/", 0) != 0) {
+        return ParseStatus::Invalid;
     }
 
-    trx::runtime::JsonValue parseValue() {
-        if (eof()) {
-            throw JsonParseError("Unexpected end of JSON payload");
-        }
-        const char c = peek();
-        if (c == '"') {
-            return trx::runtime::JsonValue(parseString());
-        }
-        if (c == '{') {
-            return parseObject();
-        }
-        if (startsWithRemaining("true")) {
-            position_ += 4;
-            return trx::runtime::JsonValue(true);
+    std::string headerLine;
+    while (std::getline(headerStream, headerLine)) {
+        if (!headerLine.empty() && headerLine.back() == '\r') {
+            headerLine.pop_back();
         }
-        if (startsWithRemaining("false")) {
-            position_ += 5;
-            return trx::runtime::JsonValue(false);
+        if (headerLine.empty()) {
+            continue;
         }
-        if (startsWithRemaining("null")) {
-            position_ += 4;
-            return trx::runtime::JsonValue();
+        const auto colonPos = headerLine.find(':');
+        if (colonPos == std::string::npos) {
+            continue;
         }
-        if (c == '-' || (c >= '0' && c <= '9')) {
-            return parseNumber();
+        std::string key = headerLine.substr(0, colonPos);
+        std::string value = headerLine.substr(colonPos + 1);
+        while (!value.empty() && value.front() == ' ') {
+            value.erase(value.begin());
         }
-        throw JsonParseError("Unsupported JSON token encountered");
+        // normalize header names to lowercase for lookups
+        request.headers.emplace(toLowerCopy(std::move(key)), std::move(value));
     }
 
-    bool startsWithRemaining(std::string_view literal) const {
-        if (text_.size() - position_ < literal.size()) {
-            return false;
-        }
-        return text_.substr(position_, literal.size()) == literal;
+    // Without Content-Length the end of a chunked body cannot be found, and guessing
+    // would desynchronise every request pipelined behind it
+    if (request.headers.count("transfer-encoding")) {
+        return ParseStatus::Invalid;
     }
-
-    std::string parseString() {
-        expect('"');
-        std::string result;
-        while (true) {
-            if (eof()) {
-                throw JsonParseError("Unterminated string literal");
-            }
-            char c = consume();
-            if (c == '"') {
-                break;
-            }
-            if (c == '\\') {
-                if (eof()) {
-                    throw JsonParseError("Invalid escape sequence");
-                }
-                c = consume();
-                switch (c) {
-                case '"': result.push_back('"'); break;
-                case '\\': result.push_back('\\'); break;
-                case '/': result.push_back('/'); break;
-                case 'b': result.push_back('\b'); break;
-                case 'f': result.push_back('\f'); break;
-                case 'n': result.push_back('\n'); break;
-                case 'r': result.push_back('\r'); break;
-                case 't': result.push_back('\t'); break;
-                case 'u': {
-                    unsigned int codepoint = 0;
-                    for (int i = 0; i < 4; ++i) {
-                        if (eof()) {
-                            throw JsonParseError("Invalid Unicode escape");
-                        }
-                        const char hex = consume();
-                        codepoint <<= 4;
-                        if (hex >= '0' && hex <= '9') {
-                            codepoint |= static_cast<unsigned int>(hex - '0');
-                        } else if (hex >= 'a' && hex <= 'f') {
-                            codepoint |= static_cast<unsigned int>(hex - 'a' + 10);
-                        } else if (hex >= 'A' && hex <= 'F') {
-                            codepoint |= static_cast<unsigned int>(hex - 'A' + 10);
-                        } else {
-                            throw JsonParseError("Invalid Unicode escape");
-                        }
-                    }
-                    appendCodepoint(result, codepoint);
-                    break;
-                }
-                default:
-                    throw JsonParseError("Invalid escape sequence");
-                }
-            } else {
-                result.push_back(c);
-            }
+    std::size_t contentLength = 0;
+    auto contentLengthIt = request.headers.find("content-length");
+    if (contentLengthIt != request.headers.end()) {
+        try {
+            contentLength = static_cast<std::size_t>(std::stoul(contentLengthIt->second));
+        } catch (const std::exception &) {
+            return ParseStatus::Invalid;
         }
-        return result;
     }
-
-    static void appendCodepoint(std::string &output, unsigned int codepoint) {
-        if (codepoint <= 0x7F) {
-            output.push_back(static_cast<char>(codepoint));
-        } else if (codepoint <= 0x7FF) {
-            output.push_back(static_cast<char>(0xC0 | ((codepoint >> 6) & 0x1F)));
-            output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F))); 
-        } else if (codepoint <= 0xFFFF) {
-            output.push_back(static_cast<char>(0xE0 | ((codepoint >> 12) & 0x0F)));
-            output.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
-            output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
-        } else {
-            output.push_back(static_cast<char>(0xF0 | ((codepoint >> 18) & 0x07)));
-            output.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
-            output.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
-            output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
-        }
+    if (contentLength > kMaxBodyBytes) {
+        return ParseStatus::TooLarge;
+    }
+    const std::size_t bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < contentLength) {
+        return ParseStatus::Incomplete;
     }
 
-    trx::runtime::JsonValue parseNumber() {
-        const std::size_t start = position_;
-        if (peek() == '-') {
-            ++position_;
-        }
-        while (!eof() && std::isdigit(static_cast<unsigned char>(peek()))) {
-            ++position_;
-        }
-        if (!eof() && peek() == '.') {
-            ++position_;
-            while (!eof() && std::isdigit(static_cast<unsigned char>(peek()))) {
-                ++position_;
-            }
-        }
-        if (!eof() && (peek() == 'e' || peek() == 'E')) {
-            ++position_;
-            if (!eof() && (peek() == '+' || peek() == '-')) {
-                ++position_;
-            }
-            while (!eof() && std::isdigit(static_cast<unsigned char>(peek()))) {
-                ++position_;
-            }
-        }
-        const std::string number{text_.substr(start, position_ - start)};
-        try {
-            const double numeric = std::stod(number);
-            return trx::runtime::JsonValue(numeric);
-        } catch (const std::exception &) {
-            throw JsonParseError("Invalid numeric literal in JSON payload");
-        }
+    request.body = buffer.substr(bodyStart, contentLength);
+    buffer.erase(0, bodyStart + contentLength);
+
+    const auto connectionIt = request.headers.find("connection");
+    const std::string connection = connectionIt != request.headers.end() ? toLowerCopy(connectionIt->second) : std::string();
+    if (request.version == "HTTP/1.0") {
+        request.keepAlive = connection.find("keep-alive") != std::string::npos;
+    } else {
+        request.keepAlive = connection.find("close") == std::string::npos;
     }
 
-    trx::runtime::JsonValue parseObject() {
-        expect('{');
-        trx::runtime::JsonValue::Object object;
-        skipWhitespace();
-        if (peek() == '}') {
-            consume();
-            return trx::runtime::JsonValue(std::move(object));
-        }
-        while (true) {
-            skipWhitespace();
-            if (peek() != '"') {
-                throw JsonParseError("Object keys must be strings");
-            }
-            std::string key = parseString();
-            // Convert key to lowercase for case-insensitive matching
-            std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-            skipWhitespace();
-            expect(':');
-            skipWhitespace();
-            trx::runtime::JsonValue value = parseValue();
-            object.emplace(std::move(key), std::move(value));
-            skipWhitespace();
-            const char delimiter = consume();
-            if (delimiter == '}') {
-                break;
-            }
-            if (delimiter != ',') {
-                throw JsonParseError("Expected comma in object literal");
-            }
-            skipWhitespace();
-        }
-        return trx::runtime::JsonValue(std::move(object));
+    // trim query string from path
+    if (const auto question = request.path.find('?'); question != std::string::npos) {
+        request.path.erase(question);
     }
-};
+    return ParseStatus::Complete;
+}
 
 std::string escapeJsonString(std::string_view input) {
     std::string result;
@@ -603,65 +544,6 @@ std::string escapeJsonString(std::string_view input) {
     return result;
 }
 
-std::string serializeJsonValue(const trx::runtime::JsonValue &value);
-
-std::string serializeObject(const trx::runtime::JsonValue::Object &object) {
-    std::string result{"{"};
-    bool first = true;
-    for (const auto &entry : object) {
-        if (!first) {
-            result.push_back(',');
-        }
-        first = false;
-        result.push_back('"');
-        result.append(escapeJsonString(entry.first));
-        result.append("\":");
-        result.append(serializeJsonValue(entry.second));
-    }
-    result.push_back('}');
-    return result;
-}
-
-std::string serializeJsonValue(const trx::runtime::JsonValue &value) {
-    if (std::holds_alternative<std::nullptr_t>(value.data)) {
-        return "null";
-    }
-    if (std::holds_alternative<bool>(value.data)) {
-        return std::get<bool>(value.data) ? "true" : "false";
-    }
-    if (std::holds_alternative<double>(value.data)) {
-        std::ostringstream stream;
-        stream.setf(std::ios::fmtflags(0), std::ios::floatfield);
-        stream.precision(15);
-        stream << std::get<double>(value.data);
-        return stream.str();
-    }
-    if (std::holds_alternative<std::string>(value.data)) {
-        std::string result = "\"";
-        result.append(escapeJsonString(std::get<std::string>(value.data)));
-        result.push_back('"');
-        return result;
-    }
-    if (std::holds_alternative<trx::runtime::JsonValue::Array>(value.data)) {
-        const auto& array = std::get<trx::runtime::JsonValue::Array>(value.data);
-        std::string result{"["};
-        bool first = true;
-        for (const auto& item : array) {
-            if (!first) {
-                result.push_back(',');
-            }
-            first = false;
-            result.append(serializeJsonValue(item));
-        }
-        result.push_back(']');
-        return result;
-    }
-    if (std::holds_alternative<trx::runtime::JsonValue::Object>(value.data)) {
-        return serializeObject(std::get<trx::runtime::JsonValue::Object>(value.data));
-    }
-    throw std::runtime_error("Unsupported JsonValue variant");
-}
-
 // Helper function to map TRX types to OpenAPI types
 std::string mapTrxTypeToOpenApi(const std::string &trxType) {
     if (trxType == "CHAR" || trxType == "_CHAR" || trxType == "STRING" || trxType == "_STRING") {
@@ -929,10 +811,146 @@ int getSuccessStatusCode(const std::string& method) {
     }
 }
 
+// Responses of routines declared with CACHE, and the tables each routine's requests write.
+// Only GET routines that return their answer are cached; entries are keyed by request
+// path, which holds the path parameters (the server does not pass query strings on).
+// Every loaded version of the module has its own RoutineCache over one shared
+// ResponseCache: a write made by either version invalidates the readers of both, and
+// the key prefix keeps a version from serving responses built by another.
+class RoutineCache {
+public:
+    struct Plan {
+        std::chrono::steady_clock::duration ttl{};  // zero when responses are not cached
+        trx::runtime::ResponseCache::Tables reads;  // tables a cached response is built from
+        trx::runtime::ResponseCache::Tables writes; // tables whose cached readers a request invalidates
+    };
+
+    RoutineCache(const std::vector<const trx::ast::ProcedureDecl *> &procedures,
+                 std::shared_ptr<trx::runtime::ResponseCache> cache, std::string keyPrefix)
+        : cache_(std::move(cache)), keyPrefix_(std::move(keyPrefix)) {
+        for (const auto *procedure : procedures) {
+            Plan plan;
+            if (procedure->cacheSeconds > 0) {
+                const auto method = procedure->httpMethod.value_or(procedure->input ? "POST" : "GET");
+                if (method != "GET" || procedure->emits) {
+                    std::cerr << "Warning: CACHE ignored on routine '" << procedure->name.baseName
+                              << "'; only GET routines that return their response are cached\n";
+                } else {
+                    plan.ttl = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(procedure->cacheSeconds));
+                    plan.reads = cache_->tables(procedure->readsTables);
+                }
+            }
+            plan.writes = cache_->tables(procedure->writesTables);
+            if (plan.ttl.count() > 0 || !plan.writes.generations.empty()) {
+                plans_.emplace(procedure, std::move(plan));
+            }
+        }
+    }
+
+    const Plan *plan(const trx::ast::ProcedureDecl *procedure) const {
+        const auto it = plans_.find(procedure);
+        return it != plans_.end() ? &it->second : nullptr;
+    }
+
+    std::optional<HttpResponse> find(const Plan &plan, const HttpRequest &request) {
+        if (plan.ttl.count() == 0) {
+            return std::nullopt;
+        }
+        auto value = cache_->find(keyPrefix_ + request.path, plan.reads);
+        if (!value) {
+            return std::nullopt;
+        }
+        HttpResponse response;
+        response.status = value->status;
+        response.contentType = std::move(value->contentType);
+        response.extraHeaders = std::move(value->headers);
+        response.body = std::move(value->body);
+        return response;
+    }
+
+    // Generations to store a response under; taken before the routine runs
+    std::vector<std::uint64_t> snapshot(const Plan &plan) const { return cache_->snapshot(plan.reads); }
+
+    // Called once the routine's transaction has ended
+    void finished(const Plan &plan, const HttpRequest &request, const HttpResponse &response, std::vector<std::uint64_t> generations) {
+        cache_->invalidate(plan.writes);
+        if (plan.ttl.count() > 0 && response.status >= 200 && response.status < 300) {
+            cache_->store(keyPrefix_ + request.path, {response.status, response.contentType, response.extraHeaders, response.body}, plan.ttl,
+                         std::move(generations));
+        }
+    }
+
+    trx::runtime::ResponseCache::Stats stats() const { return cache_->stats(); }
+
+private:
+    std::shared_ptr<trx::runtime::ResponseCache> cache_;
+    std::string keyPrefix_;
+    std::unordered_map<const trx::ast::ProcedureDecl *, Plan> plans_;
+};
+
+// Runs a routine that EMITs, sending each value as it is produced: a JSON array by default,
+// one value per line when the client accepts application/x-ndjson. The head goes out with
+// the first chunk, so a routine that fails before filling one still gets an error response;
+// one that fails later can only cut the stream short, which the client sees as a missing
+// terminating chunk.
+HttpResponse streamProcedure(const HttpRequest &request,
+                             const trx::ast::ProcedureDecl *procedure,
+                             trx::runtime::Interpreter &interpreter,
+                             trx::runtime::JsonValue input,
+                             const std::map<std::string, std::string> &pathParams,
+                             ResponseStream &stream) {
+    const auto accept = request.headers.find("accept");
+    const bool ndjson = accept != request.headers.end() && accept->second.find("application/x-ndjson") != std::string::npos;
+
+    HttpResponse head;
+    const int status = getSuccessStatusCode(request.method);
+    head.status = status == 204 ? 200 : status; // the stream always has a body
+    head.contentType = ndjson ? "application/x-ndjson" : "application/json";
+    head.extraHeaders.emplace_back("Access-Control-Allow-Methods", "GET, POST, PUT, PATCH, DELETE, HEAD, OPTIONS");
+    head.extraHeaders.emplace_back("Access-Control-Allow-Headers", "Content-Type");
+
+    bool first = true;
+    const auto open = [&]() {
+        if (!stream.started()) {
+            stream.begin(head);
+            if (!ndjson) {
+                stream.buffer().push_back('[');
+            }
+        }
+    };
+    interpreter.setEmitSink([&](const trx::runtime::JsonValue &value) {
+        open();
+        auto &out = stream.buffer();
+        if (!ndjson && !first) {
+            out.push_back(',');
+        }
+        first = false;
+        trx::runtime::JsonWriter(out).write(value);
+        if (ndjson) {
+            out.push_back('\n');
+        }
+        stream.flushIfFull();
+    });
+    struct SinkReset {
+        trx::runtime::Interpreter &interpreter;
+        ~SinkReset() { interpreter.setEmitSink(nullptr); }
+    } sinkReset{interpreter};
+
+    interpreter.execute(procedure, std::move(input), pathParams);
+    open();
+    if (!ndjson) {
+        stream.buffer().push_back(']');
+    }
+    stream.finish();
+    return head;
+}
+
 HttpResponse handleExecuteProcedure(const HttpRequest &request,
                                    const trx::ast::ProcedureDecl *procedure,
                                    trx::runtime::Interpreter &interpreter,
-                                   const std::map<std::string, std::string> &pathParams = {}) {
+                                   const std::map<std::string, std::string> &pathParams = {},
+                                   ResponseStream *stream = nullptr) {
     // Check HTTP method - use custom method if specified, otherwise default based on input
     std::string defaultMethod = procedure->input ? "POST" : "GET";
     std::string expectedMethod = procedure->httpMethod.value_or(defaultMethod);
@@ -955,9 +973,12 @@ HttpResponse handleExecuteProcedure(const HttpRequest &request,
             if (request.body.empty()) {
                 input = trx::runtime::JsonValue::object();
             } else {
-                JsonParser parser(request.body);
-                input = parser.parse();
-                if (!std::holds_alternative<trx::runtime::JsonValue::Object>(input.data)) {
+                auto *arena = trx::runtime::RequestArena::current();
+                trx::runtime::JsonParser parser(request.body, arena ? arena->resource() : std::pmr::get_default_resource());
+                // A TYPE input is decoded straight into its record; anything else is read as plain JSON
+                const auto layout = procedure->input ? interpreter.recordLayout(procedure->input->type.name) : nullptr;
+                input = layout ? parser.parse(*layout) : parser.parse();
+                if (!input.isObject()) {
                     return makeErrorResponse(400, "Request payload must be a JSON object");
                 }
             }
@@ -966,18 +987,22 @@ HttpResponse handleExecuteProcedure(const HttpRequest &request,
             input = trx::runtime::JsonValue::object();
         }
 
+        if (procedure->emits && stream) {
+            return streamProcedure(request, procedure, interpreter, std::move(input), pathParams, *stream);
+        }
+
         // Execute the procedure using the procedure pointer
-        std::optional<trx::runtime::JsonValue> outputOpt = interpreter.execute(procedure, input, pathParams);
+        std::optional<trx::runtime::JsonValue> outputOpt = interpreter.execute(procedure, std::move(input), pathParams);
         if (procedure->output) {
             if (!outputOpt) {
                 return makeErrorResponse(500, "Function does not return a value");
             }
-            const trx::runtime::JsonValue output = *outputOpt;
+            const trx::runtime::JsonValue &output = *outputOpt;
 
             HttpResponse response;
             response.status = getSuccessStatusCode(expectedMethod);
             response.contentType = "application/json";
-            response.body = serializeJsonValue(output);
+            trx::runtime::JsonWriter(response.body).write(output);
             response.extraHeaders.emplace_back("Access-Control-Allow-Origin", "*");
             response.extraHeaders.emplace_back("Access-Control-Allow-Methods", "GET, POST, PUT, PATCH, DELETE, HEAD, OPTIONS");
             response.extraHeaders.emplace_back("Access-Control-Allow-Headers", "Content-Type");
@@ -993,8 +1018,10 @@ HttpResponse handleExecuteProcedure(const HttpRequest &request,
             response.extraHeaders.emplace_back("Access-Control-Allow-Headers", "Content-Type");
             return response;
         }
-    } catch (const JsonParseError &error) {
+    } catch (const trx::runtime::JsonParseError &error) {
         return makeErrorResponse(400, error.what());
+    } catch (const trx::runtime::DeadlineExceeded &error) {
+        return makeErrorResponse(504, error.what());
     } catch (const trx::runtime::TrxException &error) {
         // Check if it's a TrxThrowException to get the actual thrown value
         if (const trx::runtime::TrxThrowException* throwEx = dynamic_cast<const trx::runtime::TrxThrowException*>(&error)) {
@@ -1032,118 +1059,1214 @@ HttpResponse handleOptions(const HttpRequest &) {
     return response;
 }
 
-} // anonymous namespace
-
-int runServer(const std::vector<std::filesystem::path> &sourcePaths, ServeOptions options) {
-
-    std::vector<std::filesystem::path> allSourceFiles;
-    for (const auto &sourcePath : sourcePaths) {
-        std::cout << "[DEBUG] Resolving source path: " << sourcePath << std::endl;
-        std::error_code fsError;
-        const auto sourceFiles = collectSourceFiles(sourcePath, fsError);
-        std::cout << "[DEBUG] collectSourceFiles found " << sourceFiles.size() << " .trx files from " << sourcePath << std::endl;
-        if (fsError) {
-            std::cerr << "Unable to load TRX sources from " << sourcePath << ": " << fsError.message() << "\n";
-            return 1;
+// /debug/sql: the statements with the most total time as a JSON array, slowest first.
+// Percentiles are the upper bounds of the histogram buckets they fall in.
+HttpResponse renderSqlStatistics(const trx::runtime::SqlStatistics &statistics, std::size_t count) {
+    const auto millis = [](double seconds) {
+        return std::isinf(seconds) ? trx::runtime::JsonValue() : trx::runtime::JsonValue(seconds * 1000.0);
+    };
+    trx::runtime::JsonValue::Array statements;
+    for (const auto &stats : statistics.top(count)) {
+        trx::runtime::JsonValue::Object entry;
+        entry["statement"] = trx::runtime::JsonValue(stats.statement);
+        entry["calls"] = trx::runtime::JsonValue(static_cast<double>(stats.calls));
+        entry["errors"] = trx::runtime::JsonValue(static_cast<double>(stats.errors));
+        entry["rows"] = trx::runtime::JsonValue(static_cast<double>(stats.rows));
+        entry["total_ms"] = millis(stats.totalSeconds);
+        entry["mean_ms"] = millis(stats.calls > 0 ? stats.totalSeconds / static_cast<double>(stats.calls) : 0.0);
+        entry["max_ms"] = millis(stats.maxSeconds);
+        entry["p50_ms"] = millis(stats.quantile(0.50));
+        entry["p95_ms"] = millis(stats.quantile(0.95));
+        entry["p99_ms"] = millis(stats.quantile(0.99));
+        if (!stats.lastError.empty()) {
+            entry["last_error"] = trx::runtime::JsonValue(stats.lastError);
         }
-        allSourceFiles.insert(allSourceFiles.end(), sourceFiles.begin(), sourceFiles.end());
+        statements.push_back(trx::runtime::JsonValue(std::move(entry)));
     }
+    HttpResponse response;
+    response.status = 200;
+    response.contentType = "application/json";
+    response.body = trx::runtime::JsonWriter::toString(trx::runtime::JsonValue(std::move(statements)));
+    return response;
+}
 
-    if (allSourceFiles.empty()) {
-        std::cerr << "No TRX files found in the specified paths\n";
-        return 1;
+// GET /jobs/<id>: where a job BATCH queued stands
+HttpResponse renderJobStatus(trx::runtime::JobQueue &jobs, const std::string &id) {
+    std::optional<trx::runtime::JobStatus> status;
+    try {
+        status = jobs.status(id);
+    } catch (const std::exception &error) {
+        return makeErrorResponse(500, error.what());
+    }
+    if (!status) {
+        return makeErrorResponse(404, "Job not found");
     }
+    HttpResponse response;
+    response.status = 200;
+    response.contentType = "application/json";
+    response.body = trx::runtime::JsonWriter::toString(status->toJson());
+    return response;
+}
 
-    std::sort(allSourceFiles.begin(), allSourceFiles.end());
-    auto last = std::unique(allSourceFiles.begin(), allSourceFiles.end());
-    allSourceFiles.erase(last, allSourceFiles.end()); // Remove duplicates
+// Spans of a request nest under the caller's traceparent, or start a new trace
+trx::runtime::TraceContext incomingTrace(const HttpRequest &request) {
+    const auto traceparent = request.headers.find("traceparent");
+    return traceparent != request.headers.end() ? trx::runtime::TraceContext::parse(traceparent->second).value_or(trx::runtime::TraceContext{})
+                                                : trx::runtime::TraceContext{};
+}
 
-    std::cout << "[DEBUG] Total unique .trx files: " << allSourceFiles.size() << std::endl;
+// X-TRX-Timeout: how many seconds, counted from when the request arrived, the caller waits
+// for the answer; no deadline without the header or with a value that is not positive
+trx::runtime::Deadline requestDeadline(const HttpRequest &request, std::chrono::steady_clock::time_point arrived) {
+    const auto header = request.headers.find("x-trx-timeout");
+    if (header == request.headers.end()) {
+        return {};
+    }
+    char *end = nullptr;
+    const double seconds = std::strtod(header->second.c_str(), &end);
+    if (end == header->second.c_str() || !std::isfinite(seconds) || seconds <= 0) {
+        return {};
+    }
+    return trx::runtime::Deadline::at(arrived + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                    std::chrono::duration<double>(seconds)));
+}
 
-    // Parse all files with separate drivers to avoid context conflicts
-    std::vector<trx::ast::Module> modules;
-    for (const auto &file : allSourceFiles) {
-        trx::parsing::ParserDriver driver;
-        if (!driver.parseFile(file)) {
-            std::cerr << "Failed to parse " << file << "\n";
-            const auto &diagnostics = driver.diagnostics().messages();
-            for (const auto &diag : diagnostics) {
-                std::cerr << "  - ";
-                if (!diag.location.file.empty()) {
-                    std::cerr << diag.location.file;
-                    if (diag.location.line != 0) {
-                        std::cerr << ':' << diag.location.line;
-                        if (diag.location.column != 0) {
-                            std::cerr << ':' << diag.location.column;
-                        }
-                    }
-                    std::cerr << ' ';
-                }
-                std::cerr << diag.message << "\n";
-            }
-            return 1;
+// Saves the folded stacks of a profiled request as <routine>-<time>-<pid>-<n>.folded under
+// |directory| and returns the file name, or an empty string when it cannot be written
+std::string writeRequestProfile(const std::filesystem::path &directory, const std::string &routineName,
+                                const trx::runtime::Profiler &profiler, trx::runtime::Profiler::Metric metric) {
+    static std::atomic<std::uint64_t> sequence{0};
+    const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::string fileName = routineName + "-" + std::to_string(millis) + "-" + std::to_string(::getpid()) + "-" +
+                                 std::to_string(sequence.fetch_add(1, std::memory_order_relaxed)) + ".folded";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::ofstream out(directory / fileName);
+    out << profiler.folded(metric);
+    if (!out) {
+        std::cerr << "Unable to write profile to " << (directory / fileName).string() << std::endl;
+        return {};
+    }
+    return fileName;
+}
+
+// The parsed sources, one module per file, so a reload parses only the files that were
+// added or changed since the last load. Files are recognised as changed by their
+// modification time and size.
+class SourceSet {
+public:
+    explicit SourceSet(std::vector<std::filesystem::path> roots) : roots_(std::move(roots)) {}
+
+    // Collects the files under the roots again and parses the new and changed ones. Returns
+    // how many were parsed, or std::nullopt after printing why the sources cannot be loaded;
+    // the set is then left as it was.
+    std::optional<std::size_t> refresh() {
+        std::vector<std::filesystem::path> allSourceFiles;
+        for (const auto &sourcePath : roots_) {
+            std::error_code fsError;
+            const auto sourceFiles = collectSourceFiles(sourcePath, fsError);
+            trx::runtime::logDebug("Collected sources", {{"path", sourcePath.string()}, {"files", sourceFiles.size()}});
+            if (fsError) {
+                std::cerr << "Unable to load TRX sources from " << sourcePath << ": " << fsError.message() << "\n";
+                return std::nullopt;
+            }
+            allSourceFiles.insert(allSourceFiles.end(), sourceFiles.begin(), sourceFiles.end());
         }
 
-        // Print warnings even if parsing succeeded
-        const auto &diagnostics = driver.diagnostics().messages();
-        for (const auto &diag : diagnostics) {
-            if (diag.level == trx::diagnostics::Diagnostic::Level::Warning) {
-                std::cerr << "Warning in " << file.string() << ": " << diag.message << "\n";
+        if (allSourceFiles.empty()) {
+            std::cerr << "No TRX files found in the specified paths\n";
+            return std::nullopt;
+        }
+
+        std::sort(allSourceFiles.begin(), allSourceFiles.end());
+        auto last = std::unique(allSourceFiles.begin(), allSourceFiles.end());
+        allSourceFiles.erase(last, allSourceFiles.end()); // Remove duplicates
+
+        trx::runtime::logDebug("Unique sources", {{"files", allSourceFiles.size()}});
+
+        std::map<std::filesystem::path, File> files;
+        std::vector<std::filesystem::path> changed;
+        for (const auto &path : allSourceFiles) {
+            std::error_code fsError;
+            File file;
+            file.modified = std::filesystem::last_write_time(path, fsError);
+            file.size = fsError ? 0 : std::filesystem::file_size(path, fsError);
+            const auto known = files_.find(path);
+            if (!fsError && known != files_.end() && known->second.modified == file.modified && known->second.size == file.size) {
+                file.module = known->second.module;
+            } else {
+                changed.push_back(path);
             }
+            files.emplace(path, std::move(file));
         }
 
-        modules.push_back(driver.context().module());
+        // Parse the files with separate drivers to avoid context conflicts. The parser is
+        // reentrant, so files are spread over one thread per core; diagnostics are reported
+        // in file order afterwards so the output does not depend on scheduling.
+        std::vector<std::unique_ptr<trx::parsing::ParserDriver>> drivers(changed.size());
+        std::vector<char> parsed(changed.size(), 0);
+        {
+            std::atomic<std::size_t> next{0};
+            const auto parseFiles = [&]() {
+                for (std::size_t index = next++; index < changed.size(); index = next++) {
+                    drivers[index] = std::make_unique<trx::parsing::ParserDriver>();
+                    parsed[index] = drivers[index]->parseFile(changed[index]);
+                }
+            };
+            const std::size_t parserCount = std::min<std::size_t>(changed.size(), std::max(1u, std::thread::hardware_concurrency()));
+            std::vector<std::thread> parsers;
+            for (std::size_t i = 1; i < parserCount; ++i) {
+                parsers.emplace_back(parseFiles);
+            }
+            parseFiles();
+            for (auto &parser : parsers) {
+                parser.join();
+            }
+        }
+
+        for (std::size_t index = 0; index < changed.size(); ++index) {
+            const auto &file = changed[index];
+            auto &driver = *drivers[index];
+            if (!parsed[index]) {
+                std::cerr << "Failed to parse " << file << "\n";
+                const auto &diagnostics = driver.diagnostics().messages();
+                for (const auto &diag : diagnostics) {
+                    std::cerr << "  - ";
+                    if (!diag.location.file.empty()) {
+                        std::cerr << diag.location.file;
+                        if (diag.location.line != 0) {
+                            std::cerr << ':' << diag.location.line;
+                            if (diag.location.column != 0) {
+                                std::cerr << ':' << diag.location.column;
+                            }
+                        }
+                        std::cerr << ' ';
+                    }
+                    std::cerr << diag.message << "\n";
+                }
+                return std::nullopt;
+            }
+
+            // Print warnings even if parsing succeeded
+            const auto &diagnostics = driver.diagnostics().messages();
+            for (const auto &diag : diagnostics) {
+                if (diag.level == trx::diagnostics::Diagnostic::Level::Warning) {
+                    std::cerr << "Warning in " << file.string() << ": " << diag.message << "\n";
+                }
+            }
+
+            files.at(file).module = std::move(driver.context().module());
+        }
+
+        files_ = std::move(files);
+        return changed.size();
     }
 
-    // Merge modules
-    trx::ast::Module combinedModule;
-    for (const auto &module : modules) {
-        combinedModule.declarations.insert(combinedModule.declarations.end(), module.declarations.begin(), module.declarations.end());
+    std::vector<std::filesystem::path> paths() const {
+        std::vector<std::filesystem::path> paths;
+        for (const auto &[path, file] : files_) {
+            paths.push_back(path);
+        }
+        return paths;
     }
 
-    const auto callableProcedures = collectCallableProcedures(combinedModule);
-    const auto records = collectRecords(combinedModule);
-    if (callableProcedures.empty()) {
-        if (allSourceFiles.size() == 1) {
-            std::cerr << "No callable procedures (with matching input/output) were found in " << allSourceFiles.front() << "\n";
-        } else {
-            std::cerr << "No callable procedures (with matching input/output) were found across " << allSourceFiles.size() << " TRX files in the specified paths\n";
+    // The declarations of every file merged into one module that shares no nodes with the
+    // parsed ones; loading it resolves and folds the copy in place
+    trx::ast::Module combine() const {
+        trx::ast::Module combinedModule;
+        for (const auto &[path, file] : files_) {
+            auto module = trx::ast::copyModule(file.module);
+            combinedModule.declarations.insert(combinedModule.declarations.end(), std::make_move_iterator(module.declarations.begin()),
+                                               std::make_move_iterator(module.declarations.end()));
         }
-        return 1;
+        return combinedModule;
     }
 
+private:
+    struct File {
+        std::filesystem::file_time_type modified{};
+        std::uintmax_t size{0};
+        trx::ast::Module module;
+    };
+
+    std::vector<std::filesystem::path> roots_;
+    std::map<std::filesystem::path, File> files_;
+};
+
+// One loaded version of the sources: the module, its routes and the interpreters that
+// run it. A request holds the version it started on, so a reload can swap in the next
+// one while requests in flight finish on the old, which is freed after the last of them.
+struct ServedModule {
+    trx::ast::Module module; // declared first so it outlives the interpreters reading it
+    std::vector<const trx::ast::ProcedureDecl *> callableProcedures;
     std::vector<std::string> routineNames;
-    routineNames.reserve(callableProcedures.size());
     std::map<std::string, const trx::ast::ProcedureDecl *> routineLookup;
-    for (const auto *procedure : callableProcedures) {
-        // Use pathTemplate + httpMethod as key to handle multiple routines with same path but different methods
-        std::string defaultMethod = procedure->input ? "POST" : "GET";
-        std::string httpMethod = procedure->httpMethod.value_or(defaultMethod);
-        std::string key = procedure->name.pathTemplate + "|" + httpMethod;
-        auto [_, inserted] = routineLookup.insert_or_assign(key, procedure);
+    std::string defaultRoutine;
+    RouteTable routes;
+
+    // Filled in by startModule()
+    std::vector<WorkerSlot> workerSlots;
+    std::unordered_map<std::string, trx::runtime::JsonValue> initialGlobals;
+    std::string swaggerSpec;
+    std::string proceduresPayload;
+    std::optional<RequestLatency> latency;
+    std::optional<RoutineCache> routineCache;
+    std::vector<std::string> interpretedRoutines; // not run on the native library, when one is loaded
+};
+
+// Routes the callable routines of |sources|; throws std::runtime_error when they cannot be served
+// Use pathTemplate + httpMethod as key to handle multiple routines with same path but different methods
+std::string routineKey(const trx::ast::ProcedureDecl &procedure) {
+    const std::string defaultMethod = procedure.input ? "POST" : "GET";
+    return procedure.name.pathTemplate + "|" + procedure.httpMethod.value_or(defaultMethod);
+}
+
+std::shared_ptr<ServedModule> routeModule(const SourceSet &sources, const ServeOptions &options) {
+    auto served = std::make_shared<ServedModule>();
+    served->module = sources.combine();
+    served->callableProcedures = collectCallableProcedures(served->module);
+    if (served->callableProcedures.empty()) {
+        const auto paths = sources.paths();
+        std::ostringstream message;
+        if (paths.size() == 1) {
+            message << "No callable procedures (with matching input/output) were found in " << paths.front();
+        } else {
+            message << "No callable procedures (with matching input/output) were found across " << paths.size() << " TRX files in the specified paths";
+        }
+        throw std::runtime_error(message.str());
+    }
+
+    for (const auto *procedure : served->callableProcedures) {
+        auto [_, inserted] = served->routineLookup.insert_or_assign(routineKey(*procedure), procedure);
         if (inserted) {
-            routineNames.push_back(procedure->name.baseName);
+            served->routineNames.push_back(procedure->name.baseName);
+        }
+    }
+
+    for (const auto &[key, procedure] : served->routineLookup) {
+        if (procedure->name.pathParameters.size() > RouteTable::maxParams) {
+            throw std::runtime_error("Routine '" + procedure->name.baseName + "' has more than " + std::to_string(RouteTable::maxParams) + " path parameters");
         }
+        served->routes.add(key.substr(key.rfind('|') + 1), procedure);
     }
 
-    std::string defaultRoutine = routineNames.front();
+    served->defaultRoutine = served->routineNames.front();
     if (options.routine) {
-        const auto it = routineLookup.find(*options.routine);
-        if (it == routineLookup.end()) {
-            std::cerr << "Routine '" << *options.routine << "' not found in module\n";
+        if (served->routineLookup.find(*options.routine) == served->routineLookup.end()) {
+            throw std::runtime_error("Routine '" + *options.routine + "' not found in module");
+        }
+        served->defaultRoutine = *options.routine;
+    }
+    return served;
+}
+
+// Connections a parallel batch uses when it does not say how many, and the most it may
+// ask for: each is taken from the pool the workers share for as long as the batch runs
+constexpr std::size_t defaultBatchParallelism = 4;
+constexpr std::size_t maxBatchParallelism = 8;
+
+/**
+ * POST /api/_batch: many routine calls in one request. The body is a JSON array of
+ * {"method", "path", "body"} calls, each routed and answered as if it had been sent on
+ * its own, and the response lists {"status", "body"} for each call in the same order.
+ * Wrapped as {"calls": [...], "transaction": true} the calls share one transaction: the
+ * first that fails rolls it back and the rest are answered 424 without running. With
+ * {"calls": [...], "parallel": n} they run on up to n connections at once instead, n being
+ * a whole number no larger than maxBatchParallelism.
+ */
+HttpResponse handleBatch(const HttpRequest &request, ServedModule &served, trx::runtime::Interpreter &interpreter) {
+    using trx::runtime::JsonValue;
+    if (request.method != "POST") {
+        return makeErrorResponse(405, "Method " + request.method + " not allowed. Expected POST");
+    }
+
+    JsonValue payload;
+    try {
+        payload = trx::runtime::JsonParser(request.body).parse();
+    } catch (const trx::runtime::JsonParseError &error) {
+        return makeErrorResponse(400, error.what());
+    }
+    const JsonValue *calls = &payload;
+    bool transaction = false;
+    std::size_t parallel = 1;
+    if (payload.isObject()) {
+        const auto &options = payload.asObject();
+        const auto found = options.find("calls");
+        calls = found != options.end() ? &found->second : nullptr;
+        if (const auto it = options.find("transaction"); it != options.end()) {
+            transaction = it->second.isBool() && it->second.asBool();
+        }
+        if (const auto it = options.find("parallel"); it != options.end()) {
+            const auto &value = it->second;
+            if (value.isBool()) {
+                parallel = value.asBool() ? defaultBatchParallelism : 1;
+            } else if (value.isNumber() && value.asNumber() >= 1 && value.asNumber() <= static_cast<double>(maxBatchParallelism) &&
+                       std::trunc(value.asNumber()) == value.asNumber()) {
+                parallel = static_cast<std::size_t>(value.asNumber());
+            } else {
+                return makeErrorResponse(400, "parallel must be true, false or a whole number from 1 to " + std::to_string(maxBatchParallelism));
+            }
+        }
+    }
+    if (!calls || !calls->isArray()) {
+        return makeErrorResponse(400, "Batch payload must be a JSON array of calls");
+    }
+    if (transaction && parallel > 1) {
+        return makeErrorResponse(400, "A batch runs either in one transaction or in parallel");
+    }
+
+    const auto &list = calls->asArray();
+    std::vector<HttpRequest> requests(list.size());
+    std::vector<const trx::ast::ProcedureDecl *> procedures(list.size(), nullptr);
+    std::vector<std::map<std::string, std::string>> parameters(list.size());
+    std::vector<HttpResponse> responses(list.size());
+    for (std::size_t i = 0; i < list.size(); ++i) {
+        const auto &call = list[i];
+        const auto *method = call.isObject() ? call.findField("method") : nullptr;
+        const auto *path = call.isObject() ? call.findField("path") : nullptr;
+        if (!method || !method->isString() || !path || !path->isString()) {
+            responses[i] = makeErrorResponse(400, "Each call needs a method and a path");
+            continue;
+        }
+        auto &sub = requests[i];
+        sub.method = method->asString();
+        std::transform(sub.method.begin(), sub.method.end(), sub.method.begin(), [](unsigned char c) { return std::toupper(c); });
+        sub.path = path->asString();
+        sub.version = request.version;
+        sub.headers.emplace("content-type", "application/json");
+        if (const auto *body = call.findField("body")) {
+            sub.body = trx::runtime::JsonWriter::toString(*body);
+        }
+        RouteTable::Match match;
+        if (!served.routes.match(sub.method, sub.path, match)) {
+            responses[i] = makeErrorResponse(404, "Route not found");
+            continue;
+        }
+        procedures[i] = match.procedure;
+        parameters[i] = match.parameters();
+    }
+
+    // Cached responses are only reused and stored outside a shared transaction, whose
+    // writes count once it has committed
+    auto &routineCache = *served.routineCache;
+    std::vector<std::vector<std::uint64_t>> generations(list.size());
+    const auto run = [&](std::size_t i, trx::runtime::Interpreter &runner) {
+        const auto *plan = routineCache.plan(procedures[i]);
+        if (auto cached = plan && !transaction ? routineCache.find(*plan, requests[i]) : std::nullopt) {
+            responses[i] = std::move(*cached);
+            return;
+        }
+        if (plan) {
+            generations[i] = routineCache.snapshot(*plan);
+        }
+        responses[i] = handleExecuteProcedure(requests[i], procedures[i], runner, parameters[i]);
+        if (plan && !transaction) {
+            routineCache.finished(*plan, requests[i], responses[i], std::move(generations[i]));
+        }
+    };
+
+    if (transaction) {
+        auto &db = interpreter.db();
+        db.beginTransaction();
+        bool failed = false;
+        for (std::size_t i = 0; i < list.size(); ++i) {
+            if (failed) {
+                responses[i] = makeErrorResponse(424, "Not run: an earlier call in the batch failed");
+                continue;
+            }
+            if (procedures[i]) {
+                run(i, interpreter);
+            }
+            failed = responses[i].status >= 400;
+        }
+        try {
+            interpreter.syncSql();
+            if (failed) {
+                db.rollbackTransaction();
+            } else {
+                db.commitTransaction();
+            }
+        } catch (const std::exception &error) {
+            if (db.isInTransaction()) {
+                db.rollbackTransaction();
+            }
+            return makeErrorResponse(500, std::string("Batch transaction failed: ") + error.what());
+        }
+        for (std::size_t i = 0; i < list.size() && !failed; ++i) {
+            if (const auto *plan = procedures[i] ? routineCache.plan(procedures[i]) : nullptr) {
+                routineCache.finished(*plan, requests[i], responses[i], std::move(generations[i]));
+            }
+        }
+    } else {
+        // Extra connections come from the same pool, each driven by a fork of the interpreter
+        std::vector<std::unique_ptr<trx::runtime::Interpreter>> forks;
+        const auto unrouted = static_cast<std::size_t>(std::count(procedures.begin(), procedures.end(), nullptr));
+        const std::size_t width = std::min(parallel, list.size() - unrouted);
+        for (std::size_t k = 1; k < width; ++k) {
+            auto sibling = interpreter.db().openSibling();
+            if (!sibling) {
+                break;
+            }
+            auto &fork = forks.emplace_back(interpreter.fork(std::move(sibling)));
+            fork->setTracer(interpreter.tracer());
+            fork->traceContext() = interpreter.traceContext();
+            fork->setDeadline(interpreter.deadline());
+        }
+        // A call that throws is answered 500 on its own, so every fork finishes its share
+        std::atomic<std::size_t> next{0};
+        const auto work = [&](trx::runtime::Interpreter &runner) {
+            for (std::size_t i; (i = next.fetch_add(1)) < list.size();) {
+                if (!procedures[i]) {
+                    continue;
+                }
+                try {
+                    run(i, runner);
+                } catch (const std::exception &error) {
+                    responses[i] = makeErrorResponse(500, error.what());
+                }
+            }
+        };
+        // The forks run on the PARALLEL FOR workers. Each adds one to doneFd when it is done,
+        // and this fiber waits for all of them without holding its thread.
+        const int doneFd = forks.empty() ? -1 : ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (doneFd < 0) {
+            forks.clear();
+        }
+        std::size_t started = 0;
+        try {
+            for (auto &fork : forks) {
+                trx::runtime::parallelPool().enqueueTask([&work, &runner = *fork, doneFd] {
+                    work(runner);
+                    const std::uint64_t one = 1;
+                    [[maybe_unused]] const auto written = ::write(doneFd, &one, sizeof(one));
+                });
+                ++started;
+            }
+        } catch (const std::exception &) {
+            // The calls the forks would have taken are left to this one
+        }
+        work(interpreter);
+        for (std::uint64_t done = 0; done < started;) {
+            trx::runtime::waitForIo(doneFd, POLLIN);
+            std::uint64_t count = 0;
+            if (::read(doneFd, &count, sizeof(count)) == sizeof(count)) {
+                done += count;
+            }
+        }
+        if (doneFd >= 0) {
+            ::close(doneFd);
+        }
+    }
+
+    HttpResponse response;
+    response.status = 200;
+    response.contentType = "application/json";
+    response.body.push_back('[');
+    for (std::size_t i = 0; i < responses.size(); ++i) {
+        if (i > 0) {
+            response.body.push_back(',');
+        }
+        response.body.append("{\"status\":");
+        response.body.append(std::to_string(responses[i].status));
+        response.body.append(",\"body\":");
+        response.body.append(responses[i].body.empty() ? "null" : responses[i].body);
+        response.body.push_back('}');
+    }
+    response.body.push_back(']');
+    response.extraHeaders.emplace_back("Access-Control-Allow-Origin", "*");
+    response.extraHeaders.emplace_back("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    response.extraHeaders.emplace_back("Access-Control-Allow-Headers", "Content-Type");
+    return response;
+}
+
+using DriverFactory = std::function<std::unique_ptr<trx::runtime::DatabaseDriver>()>;
+
+void reportNativeRoutines(const ServedModule &served) {
+    std::size_t total = 0;
+    for (const auto &decl : served.module.declarations) {
+        total += std::holds_alternative<trx::ast::ProcedureDecl>(decl) ? 1 : 0;
+    }
+    std::cout << "Running " << total - served.interpretedRoutines.size() << " of " << total << " routine(s) natively";
+    for (std::size_t i = 0; i < served.interpretedRoutines.size(); ++i) {
+        std::cout << (i == 0 ? "; interpreting " : ", ") << served.interpretedRoutines[i];
+    }
+    std::cout << std::endl;
+}
+
+// Creates the interpreters of a routed module: the first migrates tables, resolves TYPE
+// FROM TABLE records and runs module-level statements; the others are forked from it, so
+// the module is read-only once this returns. With |makeReplicaDriver| set, every interpreter
+// also gets a replica driver for read-only routines. Throws when the module fails to load.
+void startModule(ServedModule &served, std::size_t slotCount, std::size_t workerCount, int port,
+                 const DriverFactory &makeDriver, const DriverFactory &makeReplicaDriver,
+                 const std::shared_ptr<trx::runtime::ResponseCache> &responseCache, trx::runtime::JobQueue *jobQueue,
+                 const std::shared_ptr<const trx::runtime::NativeLibrary> &nativeLibrary, std::uint64_t version) {
+    served.workerSlots = std::vector<WorkerSlot>(slotCount);
+    served.workerSlots.front().interpreter = std::make_unique<trx::runtime::Interpreter>(served.module, makeDriver());
+    served.workerSlots.front().interpreter->setJobQueue(jobQueue); // the forks below take it over, and the native library
+    if (nativeLibrary) {
+        served.interpretedRoutines = served.workerSlots.front().interpreter->setNativeLibrary(nativeLibrary);
+    }
+    for (std::size_t i = 1; i < served.workerSlots.size(); ++i) {
+        served.workerSlots[i].interpreter = served.workerSlots.front().interpreter->fork(makeDriver());
+    }
+    if (makeReplicaDriver) {
+        for (auto &slot : served.workerSlots) {
+            slot.interpreter->setReplicaDriver(makeReplicaDriver());
+        }
+    }
+
+    // Globals are reset to their post-initialisation values before every request, so
+    // a routine sees the same globals no matter which worker serves it.
+    served.initialGlobals = served.workerSlots.front().interpreter->globalVariables();
+    served.swaggerSpec = buildSwaggerSpec(served.routineLookup, collectRecords(served.module), port);
+    served.proceduresPayload = buildProceduresPayload(served.routineNames, served.defaultRoutine);
+    served.latency.emplace(served.callableProcedures, workerCount + 1); // one shard per worker, plus one for other threads
+    served.routineCache.emplace(served.callableProcedures, responseCache, std::to_string(version) + ":");
+}
+
+// Event-driven HTTP/1.1 front end. One thread owns every socket through epoll:
+// it accepts, reads into per-connection buffers, parses requests and writes
+// responses. Each parsed request is handed to the thread pool; the worker posts
+// the serialized response back through an eventfd. A connection has at most one
+// request with a worker at a time, so pipelined requests are answered in order.
+class HttpEventLoop {
+public:
+    // A handler either returns its response or sends it through the stream itself
+    using Handler = std::function<HttpResponse(const HttpRequest &, ResponseStream &)>;
+
+    HttpEventLoop(int listenFd, ThreadPool &workers, Handler handler, std::chrono::seconds keepAliveTimeout)
+        : listenFd_(listenFd), workers_(workers), handler_(std::move(handler)), keepAliveTimeout_(keepAliveTimeout) {}
+
+    ~HttpEventLoop() {
+        for (const auto &[fd, connection] : connections_) {
+            ::close(fd);
+        }
+        if (wakeFd_ >= 0) {
+            ::close(wakeFd_);
+        }
+        if (epollFd_ >= 0) {
+            ::close(epollFd_);
+        }
+    }
+
+    HttpEventLoop(const HttpEventLoop &) = delete;
+    HttpEventLoop &operator=(const HttpEventLoop &) = delete;
+
+    bool initialize() {
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd_ < 0 || wakeFd_ < 0 || !setNonBlocking(listenFd_)) {
+            return false;
+        }
+        return watch(EPOLL_CTL_ADD, listenFd_, EPOLLIN) && watch(EPOLL_CTL_ADD, wakeFd_, EPOLLIN);
+    }
+
+    // Serve until stop is set, then finish the requests workers are still running
+    void run(const std::atomic<bool> &stop) {
+        constexpr int maxEvents = 256;
+        epoll_event events[maxEvents];
+        while (!stopping_ || inFlight_ > 0) {
+            if (!stopping_ && stop.load()) {
+                stopping_ = true;
+                ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, listenFd_, nullptr);
+                closeIdleConnections(true);
+            }
+            const int ready = ::epoll_wait(epollFd_, events, maxEvents, 1000);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+                // Workers post back into this loop; wait for them before it goes away
+                while (inFlight_ > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    collectResponses();
+                }
+                return;
+            }
+            for (int i = 0; i < ready; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == listenFd_) {
+                    acceptConnections();
+                } else if (fd == wakeFd_) {
+                    collectResponses();
+                } else {
+                    handleEvent(fd, events[i].events);
+                }
+            }
+            closeIdleConnections(stopping_);
+        }
+    }
+
+private:
+    struct Connection {
+        std::string readBuffer;
+        SerializedResponse pending; // response being written
+        std::size_t writeOffset{0}; // bytes of it already sent, head first
+        bool busy{false};       // a worker is handling the current request
+        bool keepAlive{true};   // keep the connection open once the pending response is written
+        bool peerClosed{false};
+        uint32_t interest{0};
+        std::chrono::steady_clock::time_point lastActivity;
+
+        bool writing() const { return writeOffset < pending.size(); }
+    };
+
+    struct CompletedResponse {
+        int fd;
+        SerializedResponse data; // empty when the worker streamed the response itself
+        bool broken{false};
+    };
+
+    static bool setNonBlocking(int fd) {
+        const int flags = ::fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    bool watch(int op, int fd, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        return ::epoll_ctl(epollFd_, op, fd, &event) == 0;
+    }
+
+    void acceptConnections() {
+        while (true) {
+            const int clientFd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (clientFd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cerr << "Accept failed: " << std::strerror(errno) << "\n";
+                }
+                return;
+            }
+            // Responses are written in one piece; don't hold them back waiting for ACKs
+            const int noDelay = 1;
+            ::setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+            auto &connection = connections_[clientFd];
+            connection = Connection{};
+            connection.lastActivity = std::chrono::steady_clock::now();
+            connection.interest = EPOLLIN | EPOLLRDHUP;
+            if (!watch(EPOLL_CTL_ADD, clientFd, connection.interest)) {
+                connections_.erase(clientFd);
+                ::close(clientFd);
+            }
+        }
+    }
+
+    void handleEvent(int fd, uint32_t events) {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+            return;
+        }
+        auto &connection = it->second;
+        connection.lastActivity = std::chrono::steady_clock::now();
+
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            readFrom(fd, connection);
+        }
+        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            // Half-closed peers still get answers to the requests already buffered
+            connection.peerClosed = true;
+        }
+        if (events & (EPOLLHUP | EPOLLERR)) {
+            connection.keepAlive = false;
+            connection.pending = {};
+            connection.writeOffset = 0;
+        }
+        if ((events & EPOLLOUT) && !flushWrites(fd, connection)) {
+            return;
+        }
+        dispatchNext(fd, connection);
+    }
+
+    void readFrom(int fd, Connection &connection) {
+        char chunk[16384];
+        // A queued request is not parsed until the current one is answered; stop
+        // reading once enough is buffered so a fast sender cannot grow it without bound
+        while (connection.readBuffer.size() < kMaxHeaderBytes + kMaxBodyBytes) {
+            const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received > 0) {
+                connection.readBuffer.append(chunk, static_cast<std::size_t>(received));
+                continue;
+            }
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                connection.peerClosed = true;
+            }
+            return;
+        }
+    }
+
+    // Start the next buffered request unless one is in progress; closes the
+    // connection once nothing more can happen on it
+    void dispatchNext(int fd, Connection &connection) {
+        if (connection.busy || connection.writing()) {
+            updateInterest(fd, connection);
+            return;
+        }
+        if (!connection.keepAlive) {
+            closeConnection(fd);
+            return;
+        }
+
+        HttpRequest request;
+        const ParseStatus status = parseHttpRequest(connection.readBuffer, request);
+        if (status == ParseStatus::Incomplete) {
+            if (connection.peerClosed) {
+                closeConnection(fd);
+            } else {
+                updateInterest(fd, connection);
+            }
+            return;
+        }
+        if (status != ParseStatus::Complete) {
+            // The stream cannot be resynchronised after a malformed request
+            connection.keepAlive = false;
+            const auto response = status == ParseStatus::TooLarge ? makeErrorResponse(413, "Request too large")
+                                                                  : makeErrorResponse(400, "Malformed HTTP request");
+            connection.pending = serializeHttpResponse(response, false, keepAliveTimeout_);
+            connection.writeOffset = 0;
+            if (flushWrites(fd, connection)) {
+                updateInterest(fd, connection);
+            }
+            return;
+        }
+
+        connection.busy = true;
+        connection.keepAlive = request.keepAlive && keepAliveTimeout_.count() > 0 && !stopping_;
+        ++inFlight_;
+        const bool keepAlive = connection.keepAlive;
+        const bool queued = workers_.tryEnqueueTask([this, fd, keepAlive, request = std::move(request)]() {
+            ResponseStream stream(fd, keepAlive, keepAliveTimeout_);
+            SerializedResponse data;
+            try {
+                auto response = handler_(request, stream);
+                if (!stream.committed()) {
+                    data = serializeHttpResponse(std::move(response), keepAlive, keepAliveTimeout_);
+                }
+            } catch (const std::exception &error) {
+                if (!stream.committed()) {
+                    data = serializeHttpResponse(makeErrorResponse(500, error.what()), keepAlive, keepAliveTimeout_);
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(completedMutex_);
+                // A stream that was cut short leaves nothing to write and the connection unusable
+                completed_.push_back({fd, std::move(data), stream.committed() && !stream.finished()});
+            }
+            const uint64_t one = 1;
+            [[maybe_unused]] const auto written = ::write(wakeFd_, &one, sizeof(one));
+        });
+        if (!queued) {
+            // Shed the connection: the request is answered at once and the client retries
+            // elsewhere or later instead of waiting in a queue it would time out in
+            --inFlight_;
+            connection.busy = false;
+            connection.keepAlive = false;
+            auto response = makeErrorResponse(503, "Server is busy");
+            response.extraHeaders.emplace_back("Retry-After", "1");
+            connection.pending = serializeHttpResponse(std::move(response), false, keepAliveTimeout_);
+            connection.writeOffset = 0;
+            if (flushWrites(fd, connection)) {
+                updateInterest(fd, connection);
+            }
+            return;
+        }
+        updateInterest(fd, connection);
+    }
+
+    void collectResponses() {
+        uint64_t count = 0;
+        [[maybe_unused]] const auto drained = ::read(wakeFd_, &count, sizeof(count));
+        std::vector<CompletedResponse> completed;
+        {
+            std::lock_guard<std::mutex> lock(completedMutex_);
+            completed.swap(completed_);
+        }
+        for (auto &response : completed) {
+            --inFlight_;
+            // The descriptor stays open while its request is with a worker, so it still names this connection
+            auto it = connections_.find(response.fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            auto &connection = it->second;
+            connection.busy = false;
+            connection.lastActivity = std::chrono::steady_clock::now();
+            if (response.broken) {
+                connection.keepAlive = false;
+            }
+            connection.pending = std::move(response.data);
+            connection.writeOffset = 0;
+            if (flushWrites(response.fd, connection)) {
+                dispatchNext(response.fd, connection);
+            }
+        }
+    }
+
+    // Write as much of the pending response as the socket takes.
+    // @return false when the connection was closed
+    bool flushWrites(int fd, Connection &connection) {
+        auto &pending = connection.pending;
+        while (connection.writing()) {
+            iovec parts[2];
+            std::size_t count = 0;
+            std::size_t offset = connection.writeOffset;
+            if (offset < pending.head.size()) {
+                parts[count++] = {pending.head.data() + offset, pending.head.size() - offset};
+                offset = 0;
+            } else {
+                offset -= pending.head.size();
+            }
+            if (offset < pending.body.size()) {
+                parts[count++] = {pending.body.data() + offset, pending.body.size() - offset};
+            }
+            msghdr message{};
+            message.msg_iov = parts;
+            message.msg_iovlen = count;
+            // sendmsg rather than writev: MSG_NOSIGNAL keeps a reset peer from raising SIGPIPE
+            const ssize_t written = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+            if (written > 0) {
+                connection.writeOffset += static_cast<std::size_t>(written);
+                continue;
+            }
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            closeConnection(fd);
+            return false;
+        }
+        pending = {};
+        connection.writeOffset = 0;
+        if (!connection.keepAlive) {
+            closeConnection(fd);
+            return false;
+        }
+        return true;
+    }
+
+    // Interest is level-triggered, so a closed peer is taken out of the read set (or out
+    // of epoll altogether while its request is with a worker) instead of waking every wait
+    void updateInterest(int fd, Connection &connection) {
+        uint32_t interest = 0;
+        if (!connection.peerClosed) {
+            interest = EPOLLRDHUP;
+            if (connection.readBuffer.size() < kMaxHeaderBytes + kMaxBodyBytes) {
+                interest |= EPOLLIN;
+            }
+        }
+        if (connection.writing()) {
+            interest |= EPOLLOUT;
+        }
+        if (interest == connection.interest) {
+            return;
+        }
+        if (interest == 0) {
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        } else {
+            watch(connection.interest == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, interest);
+        }
+        connection.interest = interest;
+    }
+
+    void closeConnection(int fd) {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+            return;
+        }
+        // A worker still holds the request; close once its response comes back
+        if (it->second.busy) {
+            it->second.keepAlive = false;
+            it->second.peerClosed = true;
+            updateInterest(fd, it->second);
+            return;
+        }
+        if (it->second.interest != 0) {
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        }
+        ::close(fd);
+        connections_.erase(it);
+    }
+
+    // Keep-alive connections without a request in progress are closed after the
+    // timeout, or all of them when the server is stopping
+    void closeIdleConnections(bool all) {
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<int> idle;
+        for (const auto &[fd, connection] : connections_) {
+            if (connection.busy || connection.writing()) {
+                continue;
+            }
+            if (all || now - connection.lastActivity >= std::max(keepAliveTimeout_, std::chrono::seconds(1))) {
+                idle.push_back(fd);
+            }
+        }
+        for (const int fd : idle) {
+            closeConnection(fd);
+        }
+    }
+
+    int listenFd_;
+    int epollFd_{-1};
+    int wakeFd_{-1};
+    ThreadPool &workers_;
+    Handler handler_;
+    std::chrono::seconds keepAliveTimeout_;
+    std::unordered_map<int, Connection> connections_;
+    std::size_t inFlight_{0}; // requests handed to workers and not yet collected
+    bool stopping_{false};
+    std::mutex completedMutex_;
+    std::vector<CompletedResponse> completed_;
+};
+
+} // anonymous namespace
+
+std::unique_ptr<RoutineCatalog> loadRoutineCatalog(const std::vector<std::filesystem::path> &sourcePaths) {
+    SourceSet sources(sourcePaths);
+    if (!sources.refresh()) {
+        return nullptr;
+    }
+    auto catalog = std::make_unique<RoutineCatalog>();
+    catalog->module = sources.combine();
+    for (const auto *procedure : collectCallableProcedures(catalog->module)) {
+        catalog->routineLookup.insert_or_assign(routineKey(*procedure), procedure);
+    }
+    if (catalog->routineLookup.empty()) {
+        std::cerr << "No exported routines were found in the specified paths\n";
+        return nullptr;
+    }
+    catalog->records = collectRecords(catalog->module);
+    return catalog;
+}
+
+int runServer(const std::vector<std::filesystem::path> &sourcePaths, ServeOptions options) {
+
+    SourceSet sources(sourcePaths);
+    if (!sources.refresh()) {
+        return 1;
+    }
+
+    std::shared_ptr<ServedModule> served;
+    try {
+        served = routeModule(sources, options);
+    } catch (const std::runtime_error &error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+
+    // Loaded once; each version of the sources runs the routines it still matches on it
+    std::shared_ptr<const trx::runtime::NativeLibrary> nativeLibrary;
+    if (options.nativeLibrary) {
+        try {
+            nativeLibrary = trx::runtime::NativeLibrary::open(*options.nativeLibrary);
+        } catch (const std::runtime_error &error) {
+            std::cerr << error.what() << "\n";
             return 1;
         }
-        defaultRoutine = *options.routine;
     }
 
-    trx::runtime::Interpreter interpreter(combinedModule, trx::runtime::createDatabaseDriver(options.dbConfig));
-    const std::string swaggerSpec = buildSwaggerSpec(routineLookup, records, options.port);
+    // Each pool worker gets its own interpreter so requests run in parallel. The
+    // interpreters borrow connections from a shared pool for the duration of a
+    // transaction. An in-memory SQLite database cannot be shared between connections,
+    // so it keeps a single interpreter with a dedicated connection that the workers
+    // take turns on.
+    const std::size_t workerCount = std::max<std::size_t>(1, options.threadCount);
+    const bool sharedConnection = options.dbConfig.type == trx::runtime::DatabaseType::SQLITE &&
+                                  (options.dbConfig.databasePath.empty() || options.dbConfig.databasePath == ":memory:");
+    // With --fibers each worker interleaves requests that wait on the database or on HTTP,
+    // and every fiber gets an interpreter slot of its own. Fibers on one thread must never
+    // wait on each other's locks, so the single shared slot rules them out.
+    std::size_t fibersPerThread = std::max<std::size_t>(1, options.fibersPerThread);
+    if (fibersPerThread > 1 && sharedConnection) {
+        std::cerr << "Warning: --fibers ignored; an in-memory SQLite database is served from one connection\n";
+        fibersPerThread = 1;
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::signal(SIGHUP, handleSignal);
+
+    // With --workers the supervisor stops here; each worker process carries on from
+    // this point and opens its own connections and thread pool
+    std::optional<WorkerProcesses> processes;
+    if (options.processCount > 1) {
+        if (sharedConnection) {
+            std::cerr << "--workers needs a database the processes can share, not an in-memory SQLite database\n";
+            return 1;
+        }
+        processes.emplace(options.processCount);
+        const auto exitCode = processes->supervise(g_stopServer, g_reloadSources, [&]() {
+            std::cout << "Loaded " << served->routineNames.size() << " routine(s) from " << sources.paths().size() << " source file(s)." << std::endl;
+            std::cout << "Serving with " << options.processCount << " worker processes" << std::endl;
+            std::cout << "Swagger playground available at http://localhost:" << options.port << "/" << std::endl;
+            std::cout << "Press Ctrl+C to stop the server" << std::endl;
+        });
+        if (exitCode) {
+            std::cout << "Server stopped" << std::endl;
+            return *exitCode;
+        }
+        // A process restarted after a reload starts from the sources as they are now
+        if (const auto parsed = sources.refresh(); parsed && *parsed > 0) {
+            try {
+                served = routeModule(sources, options);
+            } catch (const std::runtime_error &error) {
+                std::cerr << error.what() << "\n";
+                return 1;
+            }
+        }
+    }
+
+    // SQLite in WAL mode writes through a single connection, so writers queue for it
+    // instead of retrying on SQLITE_BUSY, and reads through read-only connections sized
+    // like the pool would be otherwise. Fibers still get a writer connection each, and
+    // wait on SQLite's busy timeout instead.
+    const bool sqliteWal = options.dbConfig.type == trx::runtime::DatabaseType::SQLITE && options.dbConfig.sqliteWal;
+    std::shared_ptr<trx::runtime::ConnectionPool> connectionPool;
+    trx::runtime::ConnectionPoolConfig poolConfig;
+    if (!sharedConnection) {
+        // A fiber waiting for a pooled connection would block the fibers holding them, so
+        // every fiber can hold one at once
+        const std::size_t fiberCount = workerCount * fibersPerThread;
+        poolConfig.maxConnections = options.poolMaxConnections > 0 ? options.poolMaxConnections : fiberCount;
+        if (fibersPerThread > 1 && poolConfig.maxConnections < fiberCount) {
+            std::cerr << "Warning: --pool-max raised to " << fiberCount << ", one connection per fiber\n";
+            poolConfig.maxConnections = fiberCount;
+        }
+        poolConfig.minConnections = std::min(options.poolMinConnections, poolConfig.maxConnections);
+        auto writerConfig = poolConfig;
+        if (sqliteWal && fibersPerThread == 1) {
+            writerConfig.maxConnections = 1;
+            writerConfig.minConnections = std::min<std::size_t>(writerConfig.minConnections, 1);
+        }
+        connectionPool = std::make_shared<trx::runtime::ConnectionPool>(options.dbConfig, writerConfig);
+    }
+    const DriverFactory makeDriver = [&]() -> std::unique_ptr<trx::runtime::DatabaseDriver> {
+        if (connectionPool) {
+            return std::make_unique<trx::runtime::PooledDatabaseDriver>(connectionPool);
+        }
+        return trx::runtime::createDatabaseDriver(options.dbConfig);
+    };
+
+    // Read-only routines go to the replicas through a pool of their own, which opens its
+    // connections across the replicas in turn. SQLite in WAL mode without replicas reads
+    // the database itself through read-only connections.
+    std::shared_ptr<trx::runtime::ConnectionPool> replicaPool;
+    DriverFactory makeReplicaDriver;
+    auto replicas = options.dbConfig.replicas;
+    if (replicas.empty() && sqliteWal && connectionPool) {
+        replicas.push_back(options.dbConfig.databasePath);
+    }
+    if (!replicas.empty() && connectionPool) {
+        auto nextReplica = std::make_shared<std::atomic<std::size_t>>(0);
+        replicaPool = std::make_shared<trx::runtime::ConnectionPool>(
+            [config = options.dbConfig, replicas, nextReplica]() {
+                auto replicaConfig = config;
+                const auto &replica = replicas[nextReplica->fetch_add(1) % replicas.size()];
+                if (config.type == trx::runtime::DatabaseType::SQLITE) {
+                    replicaConfig.databasePath = replica;
+                    replicaConfig.readOnly = config.sqliteWal;
+                } else {
+                    replicaConfig.connectionString = replica;
+                }
+                replicaConfig.replicas.clear();
+                return trx::runtime::createDatabaseDriver(replicaConfig);
+            },
+            poolConfig);
+        makeReplicaDriver = [&replicaPool]() -> std::unique_ptr<trx::runtime::DatabaseDriver> {
+            return std::make_unique<trx::runtime::PooledDatabaseDriver>(replicaPool);
+        };
+    } else if (!options.dbConfig.replicas.empty()) {
+        std::cerr << "Warning: read replicas ignored; an in-memory SQLite database is served from one connection\n";
+    }
+
+    // BATCH jobs run on threads of their own, with connections of their own: each job worker
+    // needs one to claim and record jobs and one for the routine it runs
+    std::shared_ptr<trx::runtime::ConnectionPool> jobPool;
+    std::unique_ptr<trx::runtime::JobQueue> jobQueue;
+    DriverFactory makeJobDriver;
+    if (options.jobs.workers > 0 && connectionPool) {
+        trx::runtime::ConnectionPoolConfig jobPoolConfig;
+        jobPoolConfig.minConnections = 0;
+        jobPoolConfig.maxConnections = options.jobs.workers * 2 + 1; // and one for /jobs lookups
+        jobPool = std::make_shared<trx::runtime::ConnectionPool>(options.dbConfig, jobPoolConfig);
+        makeJobDriver = [&jobPool]() -> std::unique_ptr<trx::runtime::DatabaseDriver> {
+            return std::make_unique<trx::runtime::PooledDatabaseDriver>(jobPool);
+        };
+        jobQueue = std::make_unique<trx::runtime::JobQueue>(options.jobs, makeJobDriver);
+        try {
+            auto db = makeJobDriver();
+            db->initialize();
+            trx::runtime::JobQueue::createTable(*db);
+        } catch (const std::exception &error) {
+            std::cerr << "Failed to create the job table: " << error.what() << "\n";
+            return 1;
+        }
+    }
+
+    const std::size_t slotCount = sharedConnection ? 1 : workerCount * fibersPerThread;
+    const auto responseCache = std::make_shared<trx::runtime::ResponseCache>();
+    std::uint64_t version = 1;
+    startModule(*served, slotCount, workerCount, options.port, makeDriver, makeReplicaDriver, responseCache, jobQueue.get(), nativeLibrary,
+                version);
     const std::string swaggerIndex = buildSwaggerIndexPage();
-    const std::string proceduresPayload = buildProceduresPayload(routineNames, defaultRoutine);
 
-    std::cout << "Loaded " << routineNames.size() << " routine(s) from " << allSourceFiles.size() << " source file(s)." << std::endl;
+    if (!processes) {
+        std::cout << "Loaded " << served->routineNames.size() << " routine(s) from " << sources.paths().size() << " source file(s)." << std::endl;
+        if (nativeLibrary) {
+            reportNativeRoutines(*served);
+        }
+    }
 
-    std::signal(SIGINT, handleSignal);
+    // The version requests start on. Each request takes its own reference, so the version
+    // a reload replaces stays alive until the requests already running on it are done.
+    std::atomic<std::shared_ptr<ServedModule>> current{std::move(served)};
+    std::atomic<std::uint64_t> reloads{0};
+    std::atomic<std::uint64_t> failedReloads{0};
+
+    // Runs on the reload thread while the current version keeps serving; a version that
+    // fails to parse, route or load is reported and the current one stays in place
+    const auto reload = [&]() {
+        if (sharedConnection) {
+            std::cerr << "Reload ignored: an in-memory SQLite database cannot be reopened for a new version of the sources\n";
+            failedReloads++;
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const auto parsed = sources.refresh();
+        if (!parsed) {
+            std::cerr << "Reload failed; still serving the previous version of the sources\n";
+            failedReloads++;
+            return;
+        }
+        try {
+            auto next = routeModule(sources, options);
+            startModule(*next, slotCount, workerCount, options.port, makeDriver, makeReplicaDriver, responseCache, jobQueue.get(),
+                        nativeLibrary, version + 1);
+            const auto routineCount = next->routineNames.size();
+            if (nativeLibrary) {
+                reportNativeRoutines(*next);
+            }
+            current.store(std::move(next));
+            version++;
+            reloads++;
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            std::cout << "Reloaded " << routineCount << " routine(s); parsed " << *parsed << " of " << sources.paths().size()
+                      << " source file(s) in " << elapsed.count() << " ms" << std::endl;
+        } catch (const std::exception &error) {
+            std::cerr << "Reload failed: " << error.what() << "; still serving the previous version of the sources\n";
+            failedReloads++;
+        }
+    };
 
     const int serverFd = ::socket(AF_INET, SOCK_STREAM, 0);
     if (serverFd < 0) {
@@ -1153,6 +2276,12 @@ int runServer(const std::vector<std::filesystem::path> &sourcePaths, ServeOption
 
     const int reuse = 1;
     ::setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    // Every worker process binds the port; the kernel spreads new connections across them
+    if (processes && ::setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+        std::cerr << "Failed to enable SO_REUSEPORT: " << std::strerror(errno) << "\n";
+        ::close(serverFd);
+        return 1;
+    }
 
     sockaddr_in address{};
     address.sin_family = AF_INET;
@@ -1170,108 +2299,376 @@ int runServer(const std::vector<std::filesystem::path> &sourcePaths, ServeOption
         return 1;
     }
 
-    std::cout << "Swagger playground available at http://localhost:" << options.port << "/" << std::endl;
-    std::cout << "Press Ctrl+C to stop the server" << std::endl;
+    if (!processes) {
+        std::cout << "Swagger playground available at http://localhost:" << options.port << "/" << std::endl;
+        std::cout << "Press Ctrl+C to stop the server" << std::endl;
+    }
 
-    ThreadPool threadPool(options.threadCount);
-    std::mutex interpreterMutex;
+    // Created after the fork so every worker process exports from its own thread; it
+    // outlives the thread pool, whose workers may still be finishing spans
+    std::unique_ptr<trx::runtime::Tracer> tracer;
+    if (options.tracing) {
+        tracer = std::make_unique<trx::runtime::Tracer>(*options.tracing);
+    }
 
-    while (!g_stopServer.load()) {
-        sockaddr_in clientAddr{};
-        socklen_t clientLen = sizeof(clientAddr);
-        const int clientFd = ::accept(serverFd, reinterpret_cast<sockaddr *>(&clientAddr), &clientLen);
-        if (clientFd < 0) {
-            if (errno == EINTR) {
-                continue;
-            }
-            std::cerr << "Accept failed: " << std::strerror(errno) << "\n";
-            break;
+    ThreadPool threadPool(workerCount, options.maxQueuedRequests, fibersPerThread);
+
+    // This process's metrics; with --workers, /metrics adds up those of every process
+    // Request durations are those of the current version, so they start over after a reload
+    const auto renderMetrics = [&current, &reloads, &failedReloads, &responseCache, &threadPool, &connectionPool, &replicaPool, &tracer, &jobQueue]() {
+        const auto served = current.load();
+        std::ostringstream oss;
+        oss << "# HELP trx_total_requests Total number of requests processed\n";
+        oss << "# TYPE trx_total_requests counter\n";
+        oss << "trx_total_requests " << g_metrics.totalRequests.load() << "\n\n";
+
+        oss << "# HELP trx_active_requests Number of currently active requests\n";
+        oss << "# TYPE trx_active_requests gauge\n";
+        oss << "trx_active_requests " << g_metrics.activeRequests.load() << "\n\n";
+
+        oss << "# HELP trx_error_requests Number of requests that resulted in errors\n";
+        oss << "# TYPE trx_error_requests counter\n";
+        oss << "trx_error_requests " << g_metrics.errorRequests.load() << "\n\n";
+
+        served->latency->write(oss);
+
+        oss << "\n# HELP trx_reloads_total Reloads of the TRX sources, by whether the new version was swapped in\n";
+        oss << "# TYPE trx_reloads_total counter\n";
+        oss << "trx_reloads_total{result=\"ok\"} " << reloads.load() << "\n";
+        oss << "trx_reloads_total{result=\"failed\"} " << failedReloads.load() << "\n";
+
+        const auto queueStats = threadPool.stats();
+        oss << "\n# HELP trx_worker_queue_depth Requests waiting for a worker thread\n";
+        oss << "# TYPE trx_worker_queue_depth gauge\n";
+        oss << "trx_worker_queue_depth " << queueStats.queued << "\n\n";
+
+        oss << "# HELP trx_worker_queue_rejected_total Requests answered with 503 because the worker queue was full\n";
+        oss << "# TYPE trx_worker_queue_rejected_total counter\n";
+        oss << "trx_worker_queue_rejected_total " << queueStats.rejected << "\n\n";
+
+        oss << "# HELP trx_worker_queue_stolen_total Requests run by a worker other than the one they were queued for\n";
+        oss << "# TYPE trx_worker_queue_stolen_total counter\n";
+        oss << "trx_worker_queue_stolen_total " << queueStats.stolen << "\n\n";
+
+        const auto waits = threadPool.waitTimes().snapshot(0);
+        const auto &bounds = trx::runtime::LatencyHistogram::bucketBounds;
+        oss << "# HELP trx_worker_queue_wait_seconds Time requests waited for a worker thread\n";
+        oss << "# TYPE trx_worker_queue_wait_seconds histogram\n";
+        for (std::size_t b = 0; b < bounds.size(); ++b) {
+            oss << "trx_worker_queue_wait_seconds_bucket{le=\"" << bounds[b] << "\"} " << waits.buckets[b] << "\n";
+        }
+        oss << "trx_worker_queue_wait_seconds_bucket{le=\"+Inf\"} " << waits.count << "\n";
+        oss << "trx_worker_queue_wait_seconds_sum " << waits.sum << "\n";
+        oss << "trx_worker_queue_wait_seconds_count " << waits.count << "\n";
+
+        if (connectionPool) {
+            const auto poolStats = connectionPool->stats();
+            oss << "\n# HELP trx_db_pool_connections Database connections in the pool by state\n";
+            oss << "# TYPE trx_db_pool_connections gauge\n";
+            oss << "trx_db_pool_connections{state=\"idle\"} " << poolStats.idle << "\n";
+            oss << "trx_db_pool_connections{state=\"in_use\"} " << poolStats.inUse << "\n\n";
+
+            oss << "# HELP trx_db_pool_waits_total Checkouts that had to wait for a free connection\n";
+            oss << "# TYPE trx_db_pool_waits_total counter\n";
+            oss << "trx_db_pool_waits_total " << poolStats.waits << "\n\n";
+
+            oss << "# HELP trx_db_pool_discarded_total Connections closed because they were idle or broken\n";
+            oss << "# TYPE trx_db_pool_discarded_total counter\n";
+            oss << "trx_db_pool_discarded_total " << poolStats.discarded << "\n\n";
+
+            const auto statementStats = connectionPool->statementCacheStats();
+            oss << "# HELP trx_db_statement_cache_hits_total Statements run from a pooled connection's prepared statement cache\n";
+            oss << "# TYPE trx_db_statement_cache_hits_total counter\n";
+            oss << "trx_db_statement_cache_hits_total " << statementStats.hits << "\n\n";
+
+            oss << "# HELP trx_db_statement_cache_misses_total Statements a pooled connection had to prepare\n";
+            oss << "# TYPE trx_db_statement_cache_misses_total counter\n";
+            oss << "trx_db_statement_cache_misses_total " << statementStats.misses << "\n";
         }
 
-        threadPool.enqueueTask([clientFd, &routineLookup, &interpreter, &interpreterMutex, &swaggerIndex, &swaggerSpec, &proceduresPayload]() {
-            auto start = std::chrono::high_resolution_clock::now();
-            g_metrics.activeRequests++;
-            g_metrics.totalRequests++;
+        if (replicaPool) {
+            const auto poolStats = replicaPool->stats();
+            oss << "\n# HELP trx_db_replica_pool_connections Read replica connections in the pool by state\n";
+            oss << "# TYPE trx_db_replica_pool_connections gauge\n";
+            oss << "trx_db_replica_pool_connections{state=\"idle\"} " << poolStats.idle << "\n";
+            oss << "trx_db_replica_pool_connections{state=\"in_use\"} " << poolStats.inUse << "\n\n";
 
-            HttpRequest request;
-            if (!readHttpRequest(clientFd, request)) {
-                g_metrics.activeRequests--;
-                ::close(clientFd);
-                return;
-            }
+            oss << "# HELP trx_db_replica_pool_waits_total Replica checkouts that had to wait for a free connection\n";
+            oss << "# TYPE trx_db_replica_pool_waits_total counter\n";
+            oss << "trx_db_replica_pool_waits_total " << poolStats.waits << "\n";
+        }
 
-            HttpResponse response;
-            if (request.method == "OPTIONS") {
-                response = handleOptions(request);
-            } else if (request.path == "/") {
-                response.status = 200;
-                response.contentType = "text/html; charset=utf-8";
-                response.body = swaggerIndex;
-            } else if (request.path == "/swagger.json") {
-                response.status = 200;
-                response.contentType = "application/json";
-                response.body = swaggerSpec;
-            } else if (request.path == "/procedures") {
-                response.status = 200;
-                response.contentType = "application/json";
-                response.body = proceduresPayload;
-            } else if (request.path == "/metrics") {
-                response.status = 200;
-                response.contentType = "text/plain; version=0.0.4; charset=utf-8";
-                std::ostringstream oss;
-                oss << "# HELP trx_total_requests Total number of requests processed\n";
-                oss << "# TYPE trx_total_requests counter\n";
-                oss << "trx_total_requests " << g_metrics.totalRequests.load() << "\n\n";
-
-                oss << "# HELP trx_active_requests Number of currently active requests\n";
-                oss << "# TYPE trx_active_requests gauge\n";
-                oss << "trx_active_requests " << g_metrics.activeRequests.load() << "\n\n";
-
-                oss << "# HELP trx_error_requests Number of requests that resulted in errors\n";
-                oss << "# TYPE trx_error_requests counter\n";
-                oss << "trx_error_requests " << g_metrics.errorRequests.load() << "\n\n";
-
-                oss << "# HELP trx_average_duration_ms Average request duration in milliseconds\n";
-                oss << "# TYPE trx_average_duration_ms gauge\n";
-                oss << "trx_average_duration_ms " << g_metrics.averageDuration << "\n";
-                response.body = oss.str();
-            } else {
-                // Check if path matches a procedure
-                auto matchResult = matchPathTemplate(request.path, request.method, routineLookup);
-                if (matchResult) {
-                    const auto &[procedure, pathParams] = *matchResult;
-                    std::lock_guard<std::mutex> lock(interpreterMutex);
-                    response = handleExecuteProcedure(request, procedure, interpreter, pathParams);
-                } else {
-                    response = makeErrorResponse(404, "Route not found");
-                }
+        const auto arenaStats = trx::runtime::RequestArena::stats();
+        oss << "\n# HELP trx_request_arena_requests_total Requests whose payload was built in a request arena\n";
+        oss << "# TYPE trx_request_arena_requests_total counter\n";
+        oss << "trx_request_arena_requests_total " << arenaStats.requests << "\n\n";
+
+        oss << "# HELP trx_request_arena_bytes_total Bytes allocated from request arenas\n";
+        oss << "# TYPE trx_request_arena_bytes_total counter\n";
+        oss << "trx_request_arena_bytes_total " << arenaStats.bytes << "\n\n";
+
+        oss << "# HELP trx_request_arena_heap_bytes_total Bytes request arenas took from the heap beyond their reused block\n";
+        oss << "# TYPE trx_request_arena_heap_bytes_total counter\n";
+        oss << "trx_request_arena_heap_bytes_total " << arenaStats.heapBytes << "\n\n";
+
+        oss << "# HELP trx_request_arena_peak_bytes Most bytes a single request allocated from its arena\n";
+        oss << "# TYPE trx_request_arena_peak_bytes gauge\n";
+        oss << "trx_request_arena_peak_bytes " << arenaStats.peakBytes << "\n";
+
+        const auto cacheStats = responseCache->stats();
+        oss << "\n# HELP trx_response_cache_hits_total Requests to CACHE routines answered from the response cache\n";
+        oss << "# TYPE trx_response_cache_hits_total counter\n";
+        oss << "trx_response_cache_hits_total " << cacheStats.hits << "\n\n";
+
+        oss << "# HELP trx_response_cache_misses_total Requests to CACHE routines that ran the routine\n";
+        oss << "# TYPE trx_response_cache_misses_total counter\n";
+        oss << "trx_response_cache_misses_total " << cacheStats.misses << "\n\n";
+
+        oss << "# HELP trx_response_cache_invalidations_total Cached responses dropped because a table they read was written\n";
+        oss << "# TYPE trx_response_cache_invalidations_total counter\n";
+        oss << "trx_response_cache_invalidations_total " << cacheStats.invalidations << "\n\n";
+
+        oss << "# HELP trx_response_cache_evictions_total Cached responses dropped to stay within the size limit\n";
+        oss << "# TYPE trx_response_cache_evictions_total counter\n";
+        oss << "trx_response_cache_evictions_total " << cacheStats.evictions << "\n\n";
+
+        oss << "# HELP trx_response_cache_entries Responses held in the response cache\n";
+        oss << "# TYPE trx_response_cache_entries gauge\n";
+        oss << "trx_response_cache_entries " << cacheStats.entries << "\n";
+
+        if (jobQueue) {
+            const auto jobStats = jobQueue->stats();
+            oss << "\n# HELP trx_jobs_total Jobs queued by BATCH, by what became of them in this process\n";
+            oss << "# TYPE trx_jobs_total counter\n";
+            oss << "trx_jobs_total{outcome=\"enqueued\"} " << jobStats.enqueued << "\n";
+            oss << "trx_jobs_total{outcome=\"rejected\"} " << jobStats.rejected << "\n";
+            oss << "trx_jobs_total{outcome=\"succeeded\"} " << jobStats.succeeded << "\n";
+            oss << "trx_jobs_total{outcome=\"retried\"} " << jobStats.retried << "\n";
+            oss << "trx_jobs_total{outcome=\"failed\"} " << jobStats.failed << "\n\n";
+
+            oss << "# HELP trx_jobs_running Jobs this process's job workers are running\n";
+            oss << "# TYPE trx_jobs_running gauge\n";
+            oss << "trx_jobs_running " << jobStats.running << "\n\n";
+
+            const auto runs = jobQueue->runTimes().snapshot(0);
+            oss << "# HELP trx_job_duration_seconds Time jobs ran, successful or not\n";
+            oss << "# TYPE trx_job_duration_seconds histogram\n";
+            for (std::size_t b = 0; b < bounds.size(); ++b) {
+                oss << "trx_job_duration_seconds_bucket{le=\"" << bounds[b] << "\"} " << runs.buckets[b] << "\n";
             }
+            oss << "trx_job_duration_seconds_bucket{le=\"+Inf\"} " << runs.count << "\n";
+            oss << "trx_job_duration_seconds_sum " << runs.sum << "\n";
+            oss << "trx_job_duration_seconds_count " << runs.count << "\n";
+        }
 
-            if (response.status >= 400) {
-                g_metrics.errorRequests++;
-            }
+        if (tracer) {
+            oss << "\n# HELP trx_trace_spans_exported_total Spans the OTLP collector accepted\n";
+            oss << "# TYPE trx_trace_spans_exported_total counter\n";
+            oss << "trx_trace_spans_exported_total " << tracer->exportedSpans() << "\n\n";
 
-            auto end = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            oss << "# HELP trx_trace_spans_dropped_total Spans dropped because the export queue was full or the collector failed\n";
+            oss << "# TYPE trx_trace_spans_dropped_total counter\n";
+            oss << "trx_trace_spans_dropped_total " << tracer->droppedSpans() << "\n";
+        }
+        return oss.str();
+    };
+
+    const auto &profileDirectory = options.profileDirectory;
+    const auto &sqlStatistics = options.dbConfig.sqlStatistics;
+    const auto handleRequest = [&current, &processes, &renderMetrics, &swaggerIndex, &profileDirectory, &tracer, &sqlStatistics, &jobQueue](const HttpRequest &request, ResponseStream &stream) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto served = current.load(); // the version this request runs on to the end
+        g_metrics.activeRequests++;
+        g_metrics.totalRequests++;
+
+        HttpResponse response;
+        std::size_t routine = RequestLatency::builtin;
+        if (request.method == "OPTIONS") {
+            response = handleOptions(request);
+        } else if (request.path == "/") {
+            response.status = 200;
+            response.contentType = "text/html; charset=utf-8";
+            response.body = swaggerIndex;
+        } else if (request.path == "/swagger.json") {
+            response.status = 200;
+            response.contentType = "application/json";
+            response.body = served->swaggerSpec;
+        } else if (request.path == "/procedures") {
+            response.status = 200;
+            response.contentType = "application/json";
+            response.body = served->proceduresPayload;
+        } else if (request.path == "/metrics") {
+            response.status = 200;
+            response.contentType = "text/plain; version=0.0.4; charset=utf-8";
+            response.body = processes ? processes->collectMetrics(renderMetrics()) : renderMetrics();
+        } else if (request.path == "/debug/sql" || request.path.starts_with("/debug/sql/")) {
+            // /debug/sql/<n> lists the top n statements
+            std::size_t count = 50;
+            if (request.path.size() > 11) {
+                const auto digits = std::string_view(request.path).substr(11);
+                std::from_chars(digits.data(), digits.data() + digits.size(), count);
+            }
+            response = sqlStatistics ? renderSqlStatistics(*sqlStatistics, count)
+                                     : makeErrorResponse(404, "SQL statistics are off; start the server with --sql-stats");
+        } else if (request.method == "GET" && request.path.starts_with("/jobs/")) {
+            response = jobQueue ? renderJobStatus(*jobQueue, request.path.substr(6))
+                                : makeErrorResponse(404, "No job queue is running; start the server with --job-workers");
+        } else if (request.path == "/api/_batch") {
+            auto &slot = served->workerSlots[ThreadPool::currentTaskSlot() % served->workerSlots.size()];
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.interpreter->globalVariables() = served->initialGlobals;
+            trx::runtime::RequestArena::Scope arenaScope(slot.arena);
+            auto &trace = slot.interpreter->traceContext();
+            trace = incomingTrace(request);
+            slot.interpreter->setTracer(tracer.get());
+            slot.interpreter->setDeadline(requestDeadline(request, start));
             {
-                std::lock_guard<std::mutex> lock(g_metrics.durationMutex);
-                g_metrics.requestDurations.push_back(duration);
-                if (g_metrics.requestDurations.size() > 1000) {
-                    g_metrics.requestDurations.erase(g_metrics.requestDurations.begin());
+                trx::runtime::Span span(tracer.get(), trace, request.method + " /api/_batch", trx::runtime::SpanKind::Server);
+                span.setAttribute("http.request.method", request.method);
+                span.setAttribute("http.route", std::string("/api/_batch"));
+                try {
+                    response = handleBatch(request, *served, *slot.interpreter);
+                } catch (const std::exception &error) {
+                    response = makeErrorResponse(500, error.what());
+                }
+                span.setAttribute("http.response.status_code", static_cast<std::int64_t>(response.status));
+                if (response.status >= 500) {
+                    span.setError(response.body);
+                }
+            }
+            trace = {};
+            slot.interpreter->setDeadline({});
+        } else {
+            // Check if path matches a procedure
+            RouteTable::Match match;
+            if (served->routes.match(request.method, request.path, match)) {
+                auto &routineCache = *served->routineCache;
+                routine = served->latency->routineIndex(match.procedure);
+                const auto *plan = routineCache.plan(match.procedure);
+                // X-TRX-Profile: cpu counts thread CPU time, any other value wall time
+                const auto profileHeader = profileDirectory ? request.headers.find("x-trx-profile") : request.headers.end();
+                const bool profiled = profileHeader != request.headers.end();
+                if (auto cached = plan && !profiled ? routineCache.find(*plan, request) : std::nullopt) {
+                    response = std::move(*cached);
+                } else {
+                    auto generations = plan ? routineCache.snapshot(*plan) : std::vector<std::uint64_t>{};
+                    std::optional<trx::runtime::Profiler> profiler;
+                    if (profiled) {
+                        profiler.emplace();
+                    }
+                    {
+                        auto &slot = served->workerSlots[ThreadPool::currentTaskSlot() % served->workerSlots.size()];
+                        std::lock_guard<std::mutex> lock(slot.mutex);
+                        slot.interpreter->globalVariables() = served->initialGlobals;
+                        trx::runtime::RequestArena::Scope arenaScope(slot.arena);
+                        slot.interpreter->setProfiler(profiler ? &*profiler : nullptr);
+                        auto &trace = slot.interpreter->traceContext();
+                        trace = incomingTrace(request);
+                        slot.interpreter->setTracer(tracer.get());
+                        slot.interpreter->setDeadline(requestDeadline(request, start));
+                        {
+                            const auto &route = match.procedure->name.pathTemplate;
+                            const std::string routePath = route.starts_with('/') ? route : "/" + route;
+                            trx::runtime::Span span(tracer.get(), trace, request.method + " " + routePath, trx::runtime::SpanKind::Server);
+                            span.setAttribute("http.request.method", request.method);
+                            span.setAttribute("http.route", routePath);
+                            span.setAttribute("url.path", request.path);
+                            response = handleExecuteProcedure(request, match.procedure, *slot.interpreter, match.parameters(), &stream);
+                            span.setAttribute("http.response.status_code", static_cast<std::int64_t>(response.status));
+                            if (response.status >= 500) {
+                                span.setError(response.body);
+                            }
+                        }
+                        trace = {};
+                        slot.interpreter->setDeadline({});
+                        slot.interpreter->setProfiler(nullptr);
+                    }
+                    if (plan) {
+                        routineCache.finished(*plan, request, response, std::move(generations));
+                    }
+                    if (profiler) {
+                        const auto metric = toLowerCopy(profileHeader->second) == "cpu" ? trx::runtime::Profiler::Metric::Cpu
+                                                                                          : trx::runtime::Profiler::Metric::Wall;
+                        const auto fileName = writeRequestProfile(*profileDirectory, match.procedure->name.baseName, *profiler, metric);
+                        if (!fileName.empty()) {
+                            response.extraHeaders.emplace_back("X-TRX-Profile", fileName);
+                        }
+                    }
                 }
-                double sum = 0.0;
-                for (auto d : g_metrics.requestDurations) sum += d;
-                g_metrics.averageDuration = sum / g_metrics.requestDurations.size();
+            } else {
+                routine = RequestLatency::unmatched;
+                response = makeErrorResponse(404, "Route not found");
             }
+        }
+
+        if (response.status >= 400) {
+            g_metrics.errorRequests++;
+        }
+
+        served->latency->observe(routine, response.status, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        g_metrics.activeRequests--;
+        return response;
+    };
+
+    HttpEventLoop eventLoop(serverFd, threadPool, handleRequest, std::chrono::seconds(options.keepAliveTimeoutSeconds));
+    if (!eventLoop.initialize()) {
+        std::cerr << "Failed to set up the event loop: " << std::strerror(errno) << "\n";
+        ::close(serverFd);
+        return 1;
+    }
+    if (processes) {
+        processes->ready(renderMetrics);
+    }
 
-            sendHttpResponse(clientFd, response);
-            g_metrics.activeRequests--;
-            ::close(clientFd);
+    // Each job worker runs jobs on an interpreter of its own, forked again from the current
+    // version of the sources after a reload
+    struct JobInterpreter {
+        std::shared_ptr<ServedModule> version;
+        std::unique_ptr<trx::runtime::Interpreter> interpreter;
+    };
+    std::vector<JobInterpreter> jobInterpreters(jobQueue ? options.jobs.workers : 0);
+    if (jobQueue) {
+        jobQueue->start([&](std::size_t worker, const std::string &routine, const trx::runtime::JsonValue &argument) {
+            auto &job = jobInterpreters[worker];
+            const auto served = current.load();
+            if (job.version != served) {
+                auto &prototype = served->workerSlots.front();
+                std::lock_guard<std::mutex> lock(prototype.mutex);
+                job.interpreter = prototype.interpreter->fork(makeJobDriver());
+                job.version = served;
+            }
+            const auto *procedure = job.interpreter->getRoutine(routine);
+            if (!procedure) {
+                throw std::runtime_error("Routine '" + routine + "' not found");
+            }
+            job.interpreter->globalVariables() = served->initialGlobals;
+            auto result = job.interpreter->execute(procedure, argument);
+            // Cached responses read from the tables the job wrote are stale now
+            responseCache->invalidate(responseCache->tables(procedure->writesTables));
+            return result ? std::move(*result) : trx::runtime::JsonValue();
         });
     }
 
+    // SIGHUP loads the sources again; the new version is built here, off the event loop
+    std::thread reloader([&]() {
+        while (!g_stopServer.load()) {
+            if (g_reloadSources.exchange(false)) {
+                reload();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+    eventLoop.run(g_stopServer);
+    reloader.join();
+    if (jobQueue) {
+        jobQueue->stop(); // before the versions its interpreters run on go away
+    }
+
     ::close(serverFd);
-    std::cout << "Server stopped" << std::endl;
+    if (!processes) {
+        std::cout << "Server stopped" << std::endl;
+    }
     return 0;
 }
 
@@ -1,11 +1,17 @@
 #pragma once
 
 #include <filesystem>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "trx/ast/Nodes.h"
 #include "trx/runtime/DatabaseDriver.h"
+#include "trx/runtime/JobQueue.h"
+#include "trx/runtime/Tracing.h"
 
 namespace trx::cli {
 
@@ -14,8 +20,28 @@ struct ServeOptions {
     std::optional<std::string> routine;
     trx::runtime::DatabaseConfig dbConfig;
     size_t threadCount{std::thread::hardware_concurrency()};
+    size_t poolMinConnections{1};
+    size_t poolMaxConnections{0}; // 0 = one connection per worker thread
+    int keepAliveTimeoutSeconds{5}; // Idle time before a keep-alive connection is closed; 0 disables keep-alive
+    size_t maxQueuedRequests{1024}; // Requests waiting for a worker before new ones get 503; 0 = no limit
+    size_t processCount{1}; // Processes sharing the port with SO_REUSEPORT, each with its own threads; 1 = serve in this process
+    size_t fibersPerThread{1}; // Requests a worker thread interleaves while they wait on SQL or HTTP; 1 = one at a time
+    std::optional<std::filesystem::path> profileDirectory; // where requests with an X-TRX-Profile header write folded stacks
+    std::optional<trx::runtime::TracerOptions> tracing; // export OTLP spans for requests when set
+    trx::runtime::JobQueueOptions jobs; // workers running BATCH jobs; none turns BATCH off
+    std::optional<std::filesystem::path> nativeLibrary; // routines compiled by trx compile
 };
 
 int runServer(const std::vector<std::filesystem::path> &sourcePaths, ServeOptions options);
 
+// The routines serve exposes and the TYPEs of their payloads, as /swagger.json lists them
+struct RoutineCatalog {
+    trx::ast::Module module; // the routines and records point into it
+    std::map<std::string, const trx::ast::ProcedureDecl *> routineLookup; // by "pathTemplate|METHOD"
+    std::vector<const trx::ast::RecordDecl *> records;
+};
+
+// Parses |sourcePaths| the way serve does; prints why and returns null when they cannot be loaded
+std::unique_ptr<RoutineCatalog> loadRoutineCatalog(const std::vector<std::filesystem::path> &sourcePaths);
+
 } // namespace trx::cli
@@ -0,0 +1,433 @@
+#include "WorkerProcesses.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <list>
+#include <new>
+#include <poll.h>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace trx::cli {
+namespace {
+
+constexpr auto kPollInterval = std::chrono::milliseconds(100);
+constexpr auto kRestartBackoff = std::chrono::seconds(1); // a process that dies sooner than this waits before it is started again
+constexpr auto kStopTimeout = std::chrono::seconds(10);   // SIGTERM grace period before SIGKILL
+constexpr int kScrapeTimeoutMs = 1000;
+
+socklen_t abstractAddress(const std::string &name, sockaddr_un &address) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    // A leading NUL puts the name in the abstract namespace: no file to clean up after a crash
+    const std::size_t length = std::min(name.size(), sizeof(address.sun_path) - 2);
+    std::memcpy(address.sun_path + 1, name.data(), length);
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + length);
+}
+
+std::string describeExit(int status) {
+    if (WIFSIGNALED(status)) {
+        return "was killed by signal " + std::to_string(WTERMSIG(status));
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+void appendNumber(std::string &out, double value) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+} // namespace
+
+WorkerProcesses::WorkerProcesses(std::size_t count) : count_{count}, processes_(count), supervisor_{::getpid()} {
+    void *memory = ::mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Failed to map memory shared with worker processes");
+    }
+    shared_ = new (memory) Shared;
+}
+
+WorkerProcesses::~WorkerProcesses() {
+    if (metricsThread_.joinable()) {
+        // Wakes the blocked accept()
+        ::shutdown(metricsFd_, SHUT_RDWR);
+        metricsThread_.join();
+    }
+    if (metricsFd_ >= 0) {
+        ::close(metricsFd_);
+    }
+    if (readyFd_ >= 0) {
+        ::close(readyFd_);
+    }
+    ::munmap(shared_, sizeof(Shared));
+}
+
+std::optional<int> WorkerProcesses::supervise(const std::atomic<bool> &stop, std::atomic<bool> &reload, const std::function<void()> &started) {
+    for (std::size_t slot = 0; slot < processes_.size(); ++slot) {
+        if (stop.load()) {
+            stopAll();
+            return 0;
+        }
+        const pid_t pid = start(slot);
+        if (pid == 0) {
+            return std::nullopt;
+        }
+        if (pid < 0) {
+            stopAll();
+            return 1;
+        }
+    }
+    started();
+
+    // Slots whose process crashed, with the time it may be started again
+    std::unordered_map<std::size_t, std::chrono::steady_clock::time_point> restartAt;
+    while (!stop.load()) {
+        if (reload.exchange(false)) {
+            for (const auto &process : processes_) {
+                if (process.pid != 0) {
+                    ::kill(process.pid, SIGHUP);
+                }
+            }
+        }
+
+        int status = 0;
+        pid_t exited = 0;
+        while ((exited = ::waitpid(-1, &status, WNOHANG)) > 0) {
+            for (std::size_t slot = 0; slot < processes_.size(); ++slot) {
+                auto &process = processes_[slot];
+                if (process.pid != exited) {
+                    continue;
+                }
+                process.pid = 0;
+                // Exiting with 0 means the process was told to stop, so it stays stopped
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                    std::cerr << "Worker process " << slot << " (pid " << exited << ") stopped\n";
+                    break;
+                }
+                std::cerr << "Worker process " << slot << " (pid " << exited << ") " << describeExit(status) << "; restarting\n";
+                restartAt[slot] = process.startedAt + kRestartBackoff;
+                break;
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = restartAt.begin(); it != restartAt.end() && !stop.load();) {
+            if (now < it->second) {
+                ++it;
+                continue;
+            }
+            const pid_t pid = start(it->first);
+            if (pid == 0) {
+                return std::nullopt;
+            }
+            if (pid < 0) {
+                it->second = now + kRestartBackoff;
+                ++it;
+                continue;
+            }
+            shared_->restarts.fetch_add(1, std::memory_order_relaxed);
+            it = restartAt.erase(it);
+        }
+
+        if (restartAt.empty() && std::none_of(processes_.begin(), processes_.end(), [](const Process &process) { return process.pid != 0; })) {
+            std::cerr << "All worker processes have stopped\n";
+            return 0;
+        }
+        std::this_thread::sleep_for(kPollInterval);
+    }
+
+    stopAll();
+    return 0;
+}
+
+pid_t WorkerProcesses::start(std::size_t slot) {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) < 0) {
+        std::cerr << "Failed to start worker process " << slot << ": " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    // Buffered output would otherwise be written again by the child
+    std::cout.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        std::cerr << "Failed to start worker process " << slot << ": " << std::strerror(errno) << "\n";
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        ::close(fds[0]);
+        // Stop with the supervisor, including when it is killed outright
+        ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (::getppid() != supervisor_) {
+            ::_exit(1);
+        }
+        slot_ = slot;
+        readyFd_ = fds[1];
+        processes_.clear();
+        return 0;
+    }
+    ::close(fds[1]);
+    processes_[slot] = {pid, std::chrono::steady_clock::now()};
+
+    // Wait until the process is serving; the pipe closes without a byte if it fails to start
+    char byte = 0;
+    ssize_t received = -1;
+    while (received < 0) {
+        pollfd readyPoll{fds[0], POLLIN, 0};
+        const int polled = ::poll(&readyPoll, 1, static_cast<int>(kPollInterval.count()));
+        if (polled > 0) {
+            received = ::read(fds[0], &byte, 1);
+            if (received < 0 && errno != EINTR) {
+                received = 0;
+            }
+        } else if (polled < 0 && errno != EINTR) {
+            received = 0;
+        }
+    }
+    ::close(fds[0]);
+    if (received == 1) {
+        return pid;
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    processes_[slot].pid = 0;
+    std::cerr << "Worker process " << slot << " (pid " << pid << ") " << describeExit(status) << " before it started serving\n";
+    return -1;
+}
+
+void WorkerProcesses::stopAll() {
+    for (const auto &process : processes_) {
+        if (process.pid != 0) {
+            ::kill(process.pid, SIGTERM);
+        }
+    }
+    const auto deadline = std::chrono::steady_clock::now() + kStopTimeout;
+    for (auto &process : processes_) {
+        if (process.pid == 0) {
+            continue;
+        }
+        int status = 0;
+        while (::waitpid(process.pid, &status, WNOHANG) == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                ::kill(process.pid, SIGKILL);
+                ::waitpid(process.pid, &status, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        process.pid = 0;
+    }
+}
+
+void WorkerProcesses::ready(std::function<std::string()> render) {
+    render_ = std::move(render);
+    metricsFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address;
+    const socklen_t length = abstractAddress(socketName(slot_), address);
+    if (metricsFd_ < 0 || ::bind(metricsFd_, reinterpret_cast<sockaddr *>(&address), length) < 0 || ::listen(metricsFd_, 16) < 0) {
+        std::cerr << "Worker process " << slot_ << " cannot share its metrics: " << std::strerror(errno) << "\n";
+    } else {
+        metricsThread_ = std::thread([this]() { serveMetrics(); });
+    }
+
+    const char byte = 1;
+    if (::write(readyFd_, &byte, 1) < 0) {
+        std::cerr << "Worker process " << slot_ << " could not report that it is ready: " << std::strerror(errno) << "\n";
+    }
+    ::close(readyFd_);
+    readyFd_ = -1;
+}
+
+std::string WorkerProcesses::socketName(std::size_t slot) const {
+    return "trx-serve-" + std::to_string(supervisor_) + "-" + std::to_string(slot);
+}
+
+void WorkerProcesses::serveMetrics() {
+    while (true) {
+        const int fd = ::accept4(metricsFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;
+        }
+        const std::string text = render_();
+        std::size_t offset = 0;
+        while (offset < text.size()) {
+            const ssize_t written = ::send(fd, text.data() + offset, text.size() - offset, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                break;
+            }
+            offset += static_cast<std::size_t>(written);
+        }
+        ::close(fd);
+    }
+}
+
+std::string WorkerProcesses::collectMetrics(const std::string &local) const {
+    std::vector<std::string> expositions{local};
+    for (std::size_t slot = 0; slot < count_; ++slot) {
+        if (slot == slot_) {
+            continue;
+        }
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            continue;
+        }
+        timeval timeout{kScrapeTimeoutMs / 1000, (kScrapeTimeoutMs % 1000) * 1000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        sockaddr_un address;
+        const socklen_t length = abstractAddress(socketName(slot), address);
+        std::string text;
+        bool complete = false;
+        if (::connect(fd, reinterpret_cast<sockaddr *>(&address), length) == 0) {
+            char buffer[16 * 1024];
+            while (true) {
+                const ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+                if (received > 0) {
+                    text.append(buffer, static_cast<std::size_t>(received));
+                    continue;
+                }
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                complete = received == 0;
+                break;
+            }
+        }
+        ::close(fd);
+        // A process that is restarting, or too slow to answer, is left out of this scrape
+        if (complete) {
+            expositions.push_back(std::move(text));
+        }
+    }
+
+    std::string merged = mergeMetrics(expositions);
+    merged += "\n# HELP trx_worker_processes Server processes included in this scrape\n";
+    merged += "# TYPE trx_worker_processes gauge\n";
+    merged += "trx_worker_processes ";
+    appendNumber(merged, static_cast<double>(expositions.size()));
+    merged += "\n\n# HELP trx_worker_process_restarts_total Server processes started again after they crashed\n";
+    merged += "# TYPE trx_worker_process_restarts_total counter\n";
+    merged += "trx_worker_process_restarts_total ";
+    appendNumber(merged, static_cast<double>(shared_->restarts.load(std::memory_order_relaxed)));
+    merged += "\n";
+    return merged;
+}
+
+std::string mergeMetrics(const std::vector<std::string> &expositions) {
+    // Gauges that report a high-water mark rather than an amount
+    static const std::unordered_set<std::string_view> maximums{"trx_request_arena_peak_bytes"};
+    constexpr std::string_view average = "trx_average_duration_ms";
+    constexpr std::string_view duration = "trx_request_duration_seconds";
+
+    struct Line {
+        std::string text;   // comment or blank line, or the sample's name and labels
+        std::string family; // metric the line belongs to, from the preceding HELP or TYPE
+        bool sample{false};
+        double value{0};
+    };
+    std::list<Line> lines;
+    std::unordered_map<std::string, std::list<Line>::iterator> samples;
+    std::unordered_map<std::string, std::list<Line>::iterator> lastOfFamily;
+
+    for (std::size_t index = 0; index < expositions.size(); ++index) {
+        std::string family;
+        std::unordered_set<std::string> added; // metrics this exposition introduced
+        std::string_view text = expositions[index];
+        while (!text.empty()) {
+            const std::size_t end = std::min(text.find('\n'), text.size());
+            const std::string_view line = text.substr(0, end);
+            text.remove_prefix(std::min(end + 1, text.size()));
+
+            if (line.empty() || line.front() == '#') {
+                if (line.starts_with("# HELP ") || line.starts_with("# TYPE ")) {
+                    const std::string_view rest = line.substr(7);
+                    family = std::string(rest.substr(0, rest.find(' ')));
+                }
+                // Later processes only contribute the comments of metrics not seen before
+                if (index > 0 && (line.empty() || (lastOfFamily.contains(family) && !added.contains(family)))) {
+                    continue;
+                }
+                lines.push_back({std::string(line), family});
+                if (!line.empty()) {
+                    lastOfFamily[family] = std::prev(lines.end());
+                    if (index > 0) {
+                        added.insert(family);
+                    }
+                }
+                continue;
+            }
+
+            const std::size_t space = line.rfind(' ');
+            if (space == std::string_view::npos) {
+                continue;
+            }
+            std::string key(line.substr(0, space));
+            const std::string_view number = line.substr(space + 1);
+            double value = 0;
+            std::from_chars(number.data(), number.data() + number.size(), value);
+
+            if (const auto existing = samples.find(key); existing != samples.end()) {
+                auto &merged = existing->second->value;
+                merged = maximums.contains(family) ? std::max(merged, value) : merged + value;
+                continue;
+            }
+            // A series only this process has goes after the other samples of its metric
+            auto position = lines.end();
+            if (const auto last = lastOfFamily.find(family); last != lastOfFamily.end()) {
+                position = std::next(last->second);
+            }
+            const auto inserted = lines.insert(position, {key, family, true, value});
+            samples.emplace(std::move(key), inserted);
+            lastOfFamily[family] = inserted;
+        }
+    }
+
+    // An average of averages is meaningless; take it from the merged histogram instead
+    double durationSum = 0;
+    double durationCount = 0;
+    for (const auto &line : lines) {
+        if (line.sample && line.family == duration) {
+            if (line.text.starts_with("trx_request_duration_seconds_sum")) {
+                durationSum += line.value;
+            } else if (line.text.starts_with("trx_request_duration_seconds_count")) {
+                durationCount += line.value;
+            }
+        }
+    }
+
+    std::string out;
+    for (const auto &line : lines) {
+        out += line.text;
+        if (line.sample) {
+            out += ' ';
+            appendNumber(out, line.family == average ? (durationCount > 0 ? durationSum * 1000.0 / durationCount : 0.0) : line.value);
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+} // namespace trx::cli
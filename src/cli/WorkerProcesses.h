@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+namespace trx::cli {
+
+/**
+ * Prefork serving for `trx serve --workers N`. The sources are parsed once, then the
+ * supervisor forks one process per slot; each binds the port with SO_REUSEPORT and
+ * runs its own thread pool, interpreters and database connections. Processes start
+ * one at a time so table migrations never race. A process that crashes is started
+ * again; SIGINT or SIGTERM stops them all, and SIGHUP is passed on to each of them.
+ *
+ * Every process also answers its siblings' metrics requests on an abstract Unix
+ * socket, so /metrics served by any of them covers the whole server.
+ */
+class WorkerProcesses {
+public:
+    explicit WorkerProcesses(std::size_t count);
+    ~WorkerProcesses();
+
+    WorkerProcesses(const WorkerProcesses &) = delete;
+    WorkerProcesses &operator=(const WorkerProcesses &) = delete;
+
+    // Forks the processes and, in the supervisor, restarts them until |stop| is set;
+    // |started| runs once they are all serving. Each time |reload| is set the supervisor
+    // clears it and sends SIGHUP to every running process. Returns the supervisor's exit
+    // code, or std::nullopt in a worker process, which goes on to serve.
+    std::optional<int> supervise(const std::atomic<bool> &stop, std::atomic<bool> &reload, const std::function<void()> &started);
+
+    // Worker side. Call once the port is bound and the event loop is set up: this
+    // process starts answering metrics requests through |render| and the supervisor
+    // moves on to the next slot.
+    void ready(std::function<std::string()> render);
+
+    std::size_t slot() const { return slot_; }
+
+    // |local| summed with the metrics of every sibling that answers, plus the
+    // supervisor's own counters
+    std::string collectMetrics(const std::string &local) const;
+
+private:
+    struct Shared {
+        std::atomic<std::uint64_t> restarts{0};
+    };
+
+    struct Process {
+        pid_t pid{0};
+        std::chrono::steady_clock::time_point startedAt;
+    };
+
+    // fork()-like: the child's pid in the supervisor, 0 in the child, -1 when it failed to start
+    pid_t start(std::size_t slot);
+    void stopAll();
+    std::string socketName(std::size_t slot) const;
+    void serveMetrics();
+
+    std::size_t count_;
+    std::vector<Process> processes_; // supervisor only
+    Shared *shared_{nullptr};
+    pid_t supervisor_;
+    std::size_t slot_{0};
+    int readyFd_{-1};
+    int metricsFd_{-1};
+    std::function<std::string()> render_;
+    std::thread metricsThread_;
+};
+
+// Prometheus text expositions of several processes merged into one: samples with the
+// same name and labels are added up, except gauges that hold a maximum, and the
+// average duration is recomputed from the merged histogram.
+std::string mergeMetrics(const std::vector<std::string> &expositions);
+
+} // namespace trx::cli
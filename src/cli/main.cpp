@@ -1,10 +1,18 @@
+#include "LoadGenerator.h"
+#include "NativeCompiler.h"
 #include "Server.h"
 #include "trx/parsing/ParserDriver.h"
 #include "trx/runtime/Interpreter.h"
+#include "trx/runtime/Profiler.h"
+#include "trx/runtime/SqlStatistics.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <optional>
 #include <string>
 
@@ -13,16 +21,54 @@ namespace {
 void printUsage() {
     std::cerr << "Usage:\n";
     std::cerr << "  trx <source.trx>\n";
-    std::cerr << "  trx [--routine <name>] [--db-type <type>] [--db-connection <conn>] <source.trx>\n";
-    std::cerr << "  trx serve [--port <port>] [--threads <count>] [--routine <name>] [--db-type <type>] [--db-connection <conn>] [source paths...]\n";
+    std::cerr << "  trx [--routine <name>] [--profile <file>] [--profile-metric wall|cpu] [--db-type <type>] [--db-connection <conn>] <source.trx>\n";
+    std::cerr << "  trx serve [--port <port>] [--workers <count>] [--threads <count>] [--fibers <count>] [--pool-min <count>] [--pool-max <count>] [--keep-alive <seconds>] [--max-queue <count>] [--job-workers <count>] [--max-jobs <count>] [--profile <dir>] [--otlp-endpoint <url>] [--trace-sample <ratio>] [--routine <name>] [--db-type <type>] [--db-connection <conn>] [--db-replica <conn>...] [--db-pipeline] [--sqlite-wal] [--sqlite-busy-timeout <ms>] [--sqlite-mmap <MiB>] [--sqlite-cache <MiB>] [--sql-stats] [--slow-query <ms>] [--native <library>] [source paths...]\n";
+    std::cerr << "  trx compile [--output <library>] [--emit-cpp <file>] [source paths...]\n";
+    std::cerr << "  trx bench-http [--host <host>] [--port <port>] [--rate <requests/s>] [--duration <seconds>] [--connections <count>] [--threads <count>] [--timeout <seconds>] [--seed <number>] [--routine <name>...] [source paths...]\n";
     std::cerr << "  trx list <source.trx>\n";
-    std::cerr << "    If no source paths are provided for serve, all .trx files in the current directory are used.\n";
+    std::cerr << "    If no source paths are provided for serve, compile or bench-http, all .trx files in the current directory are used.\n";
     std::cerr << "\nDatabase options:\n";
     std::cerr << "  --db-type <type>        Database type: sqlite, postgresql, odbc (default: sqlite)\n";
     std::cerr << "  --db-connection <conn>  Database connection string/path (default: :memory: for sqlite)\n";
+    std::cerr << "  --db-replica <conn>     Read replica for routines that only read, in serve mode; repeat for more\n";
+    std::cerr << "  --db-pipeline           PostgreSQL: send INSERT/UPDATE/DELETE without waiting until a result or SQLCODE is needed\n";
+    std::cerr << "  --sqlite-wal            SQLite: WAL journal; serve writes through one connection and reads through read-only ones\n";
+    std::cerr << "  --sqlite-busy-timeout <ms>  SQLite: wait this long for a competing writer (default: 5000)\n";
+    std::cerr << "  --sqlite-mmap <MiB>     SQLite: read up to this much of the database file through mmap (default: 0)\n";
+    std::cerr << "  --sqlite-cache <MiB>    SQLite: page cache per connection (default: SQLite's, about 2 MiB)\n";
+    std::cerr << "  --sql-stats             Record latency, rows and errors per SQL statement; serve lists them on /debug/sql\n";
+    std::cerr << "  --slow-query <ms>       Log statements slower than this, with literals and parameters redacted (implies --sql-stats)\n";
+    std::cerr << "\nProfiling options:\n";
+    std::cerr << "  --profile <path>        Write folded stacks for flamegraph.pl or speedscope: to this file for --routine,\n";
+    std::cerr << "                          or in serve mode to this directory, for requests with an X-TRX-Profile header\n";
+    std::cerr << "  --profile-metric <m>    Time the --routine profile counts: wall or cpu (default: wall)\n";
+    std::cerr << "\nTracing options (serve):\n";
+    std::cerr << "  --otlp-endpoint <url>   Export spans over OTLP/HTTP to this traces URL, e.g. http://localhost:4318/v1/traces\n";
+    std::cerr << "                          (default: $OTEL_EXPORTER_OTLP_TRACES_ENDPOINT, or $OTEL_EXPORTER_OTLP_ENDPOINT/v1/traces)\n";
+    std::cerr << "  --trace-sample <ratio>  Share of new traces recorded, 0 to 1; requests with a traceparent follow its flag (default: 1)\n";
     std::cerr << "\nServer options:\n";
     std::cerr << "  --port <port>           Port to listen on (default: 8080)\n";
+    std::cerr << "  --workers <count>       Server processes sharing the port, restarted if they crash (default: 1)\n";
     std::cerr << "  --threads <count>       Number of worker threads (default: hardware concurrency)\n";
+    std::cerr << "  --fibers <count>        Requests each worker thread interleaves while they wait on SQL or HTTP (default: 1)\n";
+    std::cerr << "  --pool-min <count>      Database connections kept open (default: 1)\n";
+    std::cerr << "  --pool-max <count>      Maximum database connections (default: one per worker thread, or per fiber)\n";
+    std::cerr << "  --keep-alive <seconds>  Idle timeout for keep-alive connections, 0 to disable (default: 5)\n";
+    std::cerr << "  --max-queue <count>     Requests waiting for a worker before new ones get 503, 0 for no limit (default: 1024)\n";
+    std::cerr << "  --native <library>      Run routines on code trx compile built; routines changed since stay interpreted\n";
+    std::cerr << "  --job-workers <count>   Threads running the jobs BATCH queues, 0 to turn BATCH off (default: 2)\n";
+    std::cerr << "  --max-jobs <count>      Queued and running jobs beyond which BATCH fails, 0 for no limit (default: 10000)\n";
+    std::cerr << "\nCompile options:\n";
+    std::cerr << "  --output <library>      Shared library to build, with $CXX (default: trx_native.so)\n";
+    std::cerr << "  --emit-cpp <file>       Keep the C++ the routines were translated into\n";
+    std::cerr << "\nLoad generator options (bench-http):\n";
+    std::cerr << "  --host <host>           Server to load (default: 127.0.0.1); --port and --threads apply as well\n";
+    std::cerr << "  --rate <requests/s>     Requests sent per second, whatever the server's latency (default: 1000)\n";
+    std::cerr << "  --duration <seconds>    How long to send (default: 10)\n";
+    std::cerr << "  --connections <count>   Keep-alive connections spread over the threads (default: 64)\n";
+    std::cerr << "  --timeout <seconds>     Wait for requests still running after the duration (default: 5)\n";
+    std::cerr << "  --seed <number>         Seed for the generated payloads (default: 1)\n";
+    std::cerr << "  --routine <name>        Only call this routine; repeat for more (default: every exported routine)\n";
 }
 
 void printDiagnostic(const trx::diagnostics::Diagnostic &diagnostic, const std::filesystem::path &filePath) {
@@ -59,9 +105,17 @@ int main(int argc, char *argv[]) {
 
     bool serveMode = false;
     bool listMode = false;
+    bool loadMode = false;
+    bool compileMode = false;
+    trx::cli::CompileOptions compileOptions;
     trx::cli::ServeOptions serveOptions;
+    trx::cli::LoadOptions loadOptions;
     std::vector<std::filesystem::path> sourcePaths;
     std::optional<std::string> routineToExecute;
+    std::optional<std::filesystem::path> profilePath;
+    auto profileMetric = trx::runtime::Profiler::Metric::Wall;
+    trx::runtime::TracerOptions tracing;
+    std::optional<trx::runtime::SqlStatistics::Options> sqlStatistics;
     trx::runtime::DatabaseConfig dbConfig;
     dbConfig.type = trx::runtime::DatabaseType::SQLITE;
     dbConfig.databasePath = ":memory:";
@@ -80,6 +134,63 @@ int main(int argc, char *argv[]) {
             listMode = true;
             continue;
         }
+        if (argument == "bench-http") {
+            loadMode = true;
+            continue;
+        }
+        if (argument == "compile") {
+            compileMode = true;
+            continue;
+        }
+        if ((argument == "--output" || argument == "-o") && index + 1 < argc) {
+            compileOptions.output = argv[++index];
+            continue;
+        }
+        if (argument == "--emit-cpp" && index + 1 < argc) {
+            compileOptions.cppOutput = std::filesystem::path{argv[++index]};
+            continue;
+        }
+        if (argument == "--native" && index + 1 < argc) {
+            serveOptions.nativeLibrary = std::filesystem::path{argv[++index]};
+            continue;
+        }
+        if (argument == "--host" && index + 1 < argc) {
+            loadOptions.host = argv[++index];
+            continue;
+        }
+        if ((argument == "--rate" || argument == "--duration" || argument == "--timeout") && index + 1 < argc) {
+            double value = 0.0;
+            try {
+                value = std::stod(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid " << argument.substr(2) << " value\n";
+                return 1;
+            }
+            if (value < 0.0 || (value == 0.0 && argument != "--timeout")) {
+                std::cerr << "The " << argument.substr(2) << " must be positive\n";
+                return 1;
+            }
+            (argument == "--rate" ? loadOptions.rate : argument == "--duration" ? loadOptions.durationSeconds : loadOptions.timeoutSeconds) = value;
+            continue;
+        }
+        if ((argument == "--connections" || argument == "--seed") && index + 1 < argc) {
+            std::uint64_t value = 0;
+            try {
+                value = std::stoull(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid " << argument.substr(2) << " value\n";
+                return 1;
+            }
+            if (argument == "--seed") {
+                loadOptions.seed = value;
+            } else if (value == 0) {
+                std::cerr << "Connection count must be at least 1\n";
+                return 1;
+            } else {
+                loadOptions.connections = value;
+            }
+            continue;
+        }
         if ((argument == "--port" || argument == "-p") && index + 1 < argc) {
             try {
                 serveOptions.port = std::stoi(argv[++index]);
@@ -95,7 +206,9 @@ int main(int argc, char *argv[]) {
         }
         if ((argument == "--routine" || argument == "-r") && index + 1 < argc) {
             std::string routineName = argv[++index];
-            if (serveMode) {
+            if (loadMode) {
+                loadOptions.routines.push_back(routineName);
+            } else if (serveMode) {
                 serveOptions.routine = routineName;
             } else {
                 routineToExecute = routineName;
@@ -115,6 +228,87 @@ int main(int argc, char *argv[]) {
             }
             continue;
         }
+        if (argument == "--fibers" && index + 1 < argc) {
+            try {
+                serveOptions.fibersPerThread = std::stoul(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid fiber count\n";
+                return 1;
+            }
+            if (serveOptions.fibersPerThread == 0) {
+                std::cerr << "Fiber count must be at least 1\n";
+                return 1;
+            }
+            continue;
+        }
+        if (argument == "--workers" && index + 1 < argc) {
+            try {
+                serveOptions.processCount = std::stoul(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid worker process count\n";
+                return 1;
+            }
+            if (serveOptions.processCount == 0) {
+                std::cerr << "Worker process count must be at least 1\n";
+                return 1;
+            }
+            continue;
+        }
+        if ((argument == "--pool-min" || argument == "--pool-max") && index + 1 < argc) {
+            std::size_t value = 0;
+            try {
+                value = std::stoul(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid connection pool size\n";
+                return 1;
+            }
+            if (argument == "--pool-min") {
+                serveOptions.poolMinConnections = value;
+            } else if (value == 0) {
+                std::cerr << "Connection pool maximum must be at least 1\n";
+                return 1;
+            } else {
+                serveOptions.poolMaxConnections = value;
+            }
+            continue;
+        }
+        if (argument == "--keep-alive" && index + 1 < argc) {
+            try {
+                serveOptions.keepAliveTimeoutSeconds = std::stoi(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid keep-alive timeout\n";
+                return 1;
+            }
+            if (serveOptions.keepAliveTimeoutSeconds < 0) {
+                std::cerr << "Keep-alive timeout cannot be negative\n";
+                return 1;
+            }
+            continue;
+        }
+        if ((argument == "--job-workers" || argument == "--max-jobs") && index + 1 < argc) {
+            std::size_t value = 0;
+            try {
+                value = std::stoul(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << (argument == "--job-workers" ? "Invalid job worker count\n" : "Invalid job limit\n");
+                return 1;
+            }
+            if (argument == "--job-workers") {
+                serveOptions.jobs.workers = value;
+            } else {
+                serveOptions.jobs.maxPending = value;
+            }
+            continue;
+        }
+        if (argument == "--max-queue" && index + 1 < argc) {
+            try {
+                serveOptions.maxQueuedRequests = std::stoul(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid queue limit\n";
+                return 1;
+            }
+            continue;
+        }
         if ((argument == "--db-type" || argument == "-t") && index + 1 < argc) {
             std::string dbType = argv[++index];
             if (dbType == "sqlite") {
@@ -140,6 +334,88 @@ int main(int argc, char *argv[]) {
             }
             continue;
         }
+        if (argument == "--profile" && index + 1 < argc) {
+            profilePath = argv[++index];
+            continue;
+        }
+        if (argument == "--profile-metric" && index + 1 < argc) {
+            const std::string metric{argv[++index]};
+            if (metric != "wall" && metric != "cpu") {
+                std::cerr << "Invalid profile metric: " << metric << " (expected wall or cpu)\n";
+                return 1;
+            }
+            profileMetric = metric == "cpu" ? trx::runtime::Profiler::Metric::Cpu : trx::runtime::Profiler::Metric::Wall;
+            continue;
+        }
+        if (argument == "--otlp-endpoint" && index + 1 < argc) {
+            tracing.endpoint = argv[++index];
+            continue;
+        }
+        if (argument == "--trace-sample" && index + 1 < argc) {
+            const std::string value{argv[++index]};
+            try {
+                tracing.sampleRatio = std::stod(value);
+            } catch (const std::exception &) {
+                tracing.sampleRatio = -1.0;
+            }
+            if (tracing.sampleRatio < 0.0 || tracing.sampleRatio > 1.0) {
+                std::cerr << "Invalid trace sample ratio: " << value << "\n";
+                return 1;
+            }
+            continue;
+        }
+        if (argument == "--sql-stats") {
+            if (!sqlStatistics) {
+                sqlStatistics.emplace();
+            }
+            continue;
+        }
+        if (argument == "--slow-query" && index + 1 < argc) {
+            const std::string value{argv[++index]};
+            double millis = -1.0;
+            try {
+                millis = std::stod(value);
+            } catch (const std::exception &) {
+            }
+            if (millis <= 0.0) {
+                std::cerr << "Invalid slow query threshold: " << value << " (expected milliseconds above 0)\n";
+                return 1;
+            }
+            if (!sqlStatistics) {
+                sqlStatistics.emplace();
+            }
+            sqlStatistics->slowQueryThreshold = std::chrono::microseconds(static_cast<std::int64_t>(millis * 1000.0));
+            continue;
+        }
+        if (argument == "--db-pipeline") {
+            dbConfig.pipelineWrites = true;
+            continue;
+        }
+        if (argument == "--sqlite-wal") {
+            dbConfig.sqliteWal = true;
+            continue;
+        }
+        if ((argument == "--sqlite-busy-timeout" || argument == "--sqlite-mmap" || argument == "--sqlite-cache") && index + 1 < argc) {
+            std::size_t value = 0;
+            try {
+                value = std::stoul(argv[++index]);
+            } catch (const std::exception &) {
+                std::cerr << "Invalid value for " << argument << "\n";
+                return 1;
+            }
+            if (argument == "--sqlite-busy-timeout") {
+                dbConfig.sqliteBusyTimeoutMs = static_cast<int>(std::min<std::size_t>(value, std::numeric_limits<int>::max()));
+            } else if (argument == "--sqlite-mmap") {
+                dbConfig.sqliteMmapSize = value * 1024 * 1024;
+            } else {
+                dbConfig.sqliteCacheSize = value * 1024;
+            }
+            continue;
+        }
+        if (argument == "--db-replica" && index + 1 < argc) {
+            dbConfig.replicas.emplace_back(argv[++index]);
+            continue;
+        }
         if (argument.starts_with('-')) {
             std::cerr << "Unexpected argument: " << argument << "\n";
             return 1;
@@ -168,6 +444,10 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (sqlStatistics) {
+        dbConfig.sqlStatistics = std::make_shared<trx::runtime::SqlStatistics>(*sqlStatistics);
+    }
+
     if (listMode) {
         if (sourcePaths.empty()) {
             std::cerr << "Missing TRX source file for list\n";
@@ -204,6 +484,23 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    if (compileMode) {
+        if (sourcePaths.empty()) {
+            sourcePaths.push_back(".");
+        }
+        compileOptions.dbConfig = dbConfig;
+        return trx::cli::runCompile(sourcePaths, compileOptions);
+    }
+
+    if (loadMode) {
+        if (sourcePaths.empty()) {
+            sourcePaths.push_back(".");
+        }
+        loadOptions.port = serveOptions.port;
+        loadOptions.threadCount = serveOptions.threadCount;
+        return trx::cli::runLoadGenerator(sourcePaths, loadOptions);
+    }
+
     if (serveMode) {
         if (sourcePaths.empty()) {
             sourcePaths.push_back(".");
@@ -211,6 +508,25 @@ int main(int argc, char *argv[]) {
         // Use a file-based database for the server so data persists between requests
         dbConfig.databasePath = "trx_server.db";
         serveOptions.dbConfig = dbConfig;
+        serveOptions.profileDirectory = profilePath;
+        // The standard OpenTelemetry variables apply when no endpoint is given
+        if (tracing.endpoint.empty()) {
+            if (const char *endpoint = std::getenv("OTEL_EXPORTER_OTLP_TRACES_ENDPOINT")) {
+                tracing.endpoint = endpoint;
+            } else if (const char *base = std::getenv("OTEL_EXPORTER_OTLP_ENDPOINT")) {
+                std::string url = base;
+                if (url.ends_with('/')) {
+                    url.pop_back();
+                }
+                tracing.endpoint = url + "/v1/traces";
+            }
+        }
+        if (const char *serviceName = std::getenv("OTEL_SERVICE_NAME")) {
+            tracing.serviceName = serviceName;
+        }
+        if (!tracing.endpoint.empty()) {
+            serveOptions.tracing = tracing;
+        }
         return trx::cli::runServer(sourcePaths, serveOptions);
     }
 
@@ -245,6 +561,22 @@ int main(int argc, char *argv[]) {
     if (routineToExecute) {
         auto dbDriver = trx::runtime::createDatabaseDriver(dbConfig);
         trx::runtime::Interpreter interpreter{driver.context().module(), std::move(dbDriver)};
+        trx::runtime::Profiler profiler;
+        if (profilePath) {
+            interpreter.setProfiler(&profiler);
+        }
+        const auto writeProfile = [&] {
+            if (!profilePath) {
+                return true;
+            }
+            std::ofstream out(*profilePath);
+            out << profiler.folded(profileMetric);
+            if (!out) {
+                std::cerr << "Unable to write profile to " << profilePath->string() << "\n";
+                return false;
+            }
+            return true;
+        };
         try {
             trx::runtime::JsonValue input = trx::runtime::JsonValue::object(); // For now, empty input
             auto result = interpreter.execute(*routineToExecute, input);
@@ -254,8 +586,15 @@ int main(int argc, char *argv[]) {
             }
         } catch (const std::exception &e) {
             std::cerr << "Error executing routine '" << *routineToExecute << "': " << e.what() << "\n";
+            writeProfile();
+            return 1;
+        }
+        if (!writeProfile()) {
             return 1;
         }
+    } else if (profilePath) {
+        std::cerr << "--profile needs --routine, or serve mode\n";
+        return 1;
     }
 
     return 0;
@@ -3,6 +3,9 @@
 #include "trx/diagnostics/DiagnosticEngine.h"
 
 #include <fstream>
+#include <functional>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -52,7 +55,16 @@ const diagnostics::DiagnosticEngine &ParserDriver::diagnostics() const noexcept
 }
 
 void ParserDriver::setCurrentFile(std::string_view fileName) {
-    currentFile_.assign(fileName.begin(), fileName.end());
+    // SourceLocation keeps a view of the file name, and the module outlives its driver,
+    // so names are interned for the life of the process
+    static std::mutex mutex;
+    static std::set<std::string, std::less<>> names;
+    std::lock_guard lock(mutex);
+    auto it = names.find(fileName);
+    if (it == names.end()) {
+        it = names.emplace(fileName).first;
+    }
+    currentFile_ = *it;
 }
 
 std::string_view ParserDriver::currentFile() const noexcept {
@@ -73,6 +85,7 @@ bool ParserDriver::parseImpl(std::string_view content, std::string_view fileName
 
     YY_BUFFER_STATE buffer = yy_scan_bytes(content.data(), static_cast<int>(content.size()), scanner);
 
+    ast::NodeArena::Scope arena(context_.module().arena);
     const int result = yyparse(*this, scanner);
 
     context_.finalize();
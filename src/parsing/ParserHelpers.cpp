@@ -34,6 +34,11 @@ void ParserContext::addConstant(std::string name, std::string value, const ast::
     module_.declarations.emplace_back(std::move(decl));
 }
 
+void ParserContext::addConstant(std::string name, bool value, const ast::SourceLocation &location) {
+    ast::ConstantDecl decl{.name = {.name = std::move(name), .location = location}, .value = value};
+    module_.declarations.emplace_back(std::move(decl));
+}
+
 void ParserContext::addRecord(ast::RecordDecl record) {
     const std::string recordName = record.name.name;
     const auto [it, inserted] = recordIndex_.emplace(recordName, record.name.location);
@@ -80,6 +85,7 @@ void ParserContext::addRecord(ast::RecordDecl record) {
 }
 
 void ParserContext::addProcedure(ast::ProcedureDecl procedure) {
+    ast::resolveFrameSlots(procedure);
     module_.declarations.emplace_back(std::move(procedure));
 }
 
@@ -0,0 +1,390 @@
+#include "trx/runtime/Bytecode.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace trx::runtime {
+
+namespace {
+
+static_assert(static_cast<int>(OpCode::Or) - static_cast<int>(OpCode::Add) ==
+                  static_cast<int>(ast::BinaryOperator::Or) - static_cast<int>(ast::BinaryOperator::Add),
+              "binary opcodes must follow the order of ast::BinaryOperator");
+
+class Compiler {
+public:
+    explicit Compiler(const ast::ProcedureDecl &procedure) : procedure_{procedure}, program_{std::make_shared<Program>()} {}
+
+    std::shared_ptr<const Program> compile() {
+        statements(procedure_.body);
+        return program_;
+    }
+
+private:
+    const ast::ProcedureDecl &procedure_;
+    std::shared_ptr<Program> program_;
+    std::uint32_t nextRegister_{0};
+
+    // Registers are handed out as a stack: an expression's temporaries are released
+    // once its value has been consumed
+    std::uint32_t allocate(std::uint32_t count = 1) {
+        const auto first = nextRegister_;
+        nextRegister_ += count;
+        program_->registerCount = std::max(program_->registerCount, nextRegister_);
+        return first;
+    }
+
+    void release(std::uint32_t first) { nextRegister_ = first; }
+
+    std::uint32_t emit(OpCode op, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0) {
+        program_->code.push_back(Instruction{op, a, b, c});
+        return static_cast<std::uint32_t>(program_->code.size() - 1);
+    }
+
+    std::uint32_t here() const { return static_cast<std::uint32_t>(program_->code.size()); }
+
+    template <typename T>
+    static std::uint32_t add(std::vector<T> &pool, T value) {
+        pool.push_back(std::move(value));
+        return static_cast<std::uint32_t>(pool.size() - 1);
+    }
+
+    std::uint32_t constant(JsonValue value) { return add(program_->constants, std::move(value)); }
+    std::uint32_t variable(const ast::VariableExpression &var) { return add(program_->variables, &var); }
+    std::uint32_t tree(const ast::ExpressionPtr &expression) { return add(program_->expressions, expression); }
+    std::uint32_t statementIndex(const ast::Statement &statement) { return add(program_->statements, &statement); }
+
+    static bool isSlotAccess(const ast::VariableExpression &var) {
+        return var.path.size() == 1 && !var.path.front().subscript && var.slot != ast::unresolvedSlot;
+    }
+
+    static std::uint32_t slotOperand(std::size_t slot) { return static_cast<std::uint32_t>(slot); }
+
+    void expression(const ast::ExpressionPtr &expr, std::uint32_t dst) {
+        if (!expr) {
+            emit(OpCode::EvalTree, dst, tree(expr)); // raises the tree-walker's empty-expression error
+            return;
+        }
+        std::visit(
+            Overloaded{
+                [&](const ast::LiteralExpression &literal) {
+                    JsonValue value = std::visit([](const auto &v) { return JsonValue(v); }, literal.value);
+                    emit(OpCode::LoadConst, dst, constant(std::move(value)));
+                },
+                [&](const ast::ObjectLiteralExpression &object) {
+                    emit(OpCode::NewObject, dst);
+                    for (const auto &[key, value] : object.properties) {
+                        const auto tmp = allocate();
+                        expression(value, tmp);
+                        emit(OpCode::SetField, dst, add(program_->keys, key), tmp);
+                        release(tmp);
+                    }
+                },
+                [&](const ast::ArrayLiteralExpression &array) {
+                    emit(OpCode::NewArray, dst);
+                    for (const auto &element : array.elements) {
+                        const auto tmp = allocate();
+                        expression(element, tmp);
+                        emit(OpCode::Push, dst, tmp);
+                        release(tmp);
+                    }
+                },
+                [&](const ast::VariableExpression &var) {
+                    if (isSlotAccess(var)) {
+                        emit(OpCode::LoadSlot, dst, slotOperand(var.slot), variable(var));
+                    } else {
+                        emit(OpCode::LoadVar, dst, variable(var));
+                    }
+                },
+                [&](const ast::UnaryExpression &unary) {
+                    expression(unary.operand, dst);
+                    switch (unary.op) {
+                        case ast::UnaryOperator::Positive: emit(OpCode::Positive, dst, dst); break;
+                        case ast::UnaryOperator::Negate: emit(OpCode::Negate, dst, dst); break;
+                        case ast::UnaryOperator::Not: emit(OpCode::Not, dst, dst); break;
+                    }
+                },
+                [&](const ast::BinaryExpression &binary) {
+                    expression(binary.lhs, dst);
+                    const auto rhs = allocate();
+                    expression(binary.rhs, rhs);
+                    emit(static_cast<OpCode>(static_cast<int>(OpCode::Add) + static_cast<int>(binary.op)), dst, dst, rhs);
+                    release(rhs);
+                    if (binary.scale > 0) {
+                        emit(OpCode::RoundScale, dst, static_cast<std::uint32_t>(binary.scale));
+                    }
+                },
+                [&](const ast::BuiltinExpression &builtin) {
+                    if (builtin.value == ast::BuiltinValue::SqlCode) {
+                        emit(OpCode::LoadSqlCode, dst);
+                    } else {
+                        emit(OpCode::Builtin, dst, tree(expr));
+                    }
+                },
+                [&](const auto &) {
+                    // Calls and SQL fragments: argument handling lives with the tree-walker
+                    emit(OpCode::EvalTree, dst, tree(expr));
+                }
+            },
+            expr->node);
+    }
+
+    void statements(const ast::StatementList &list) {
+        for (const auto &statement : list) {
+            this->statement(statement);
+        }
+    }
+
+    void delegate(const ast::Statement &statement) { emit(OpCode::ExecStatement, statementIndex(statement)); }
+
+    void statement(const ast::Statement &statement) {
+        std::visit(
+            Overloaded{
+                [&](const ast::ExpressionStatement &exprStmt) {
+                    const auto tmp = allocate();
+                    expression(exprStmt.expression, tmp);
+                    release(tmp);
+                },
+                [&](const ast::AssignmentStatement &assignment) {
+                    const auto value = allocate();
+                    expression(assignment.value, value);
+                    if (isSlotAccess(assignment.target)) {
+                        emit(OpCode::StoreSlot, value, slotOperand(assignment.target.slot), variable(assignment.target));
+                    } else {
+                        emit(OpCode::StoreVar, value, variable(assignment.target));
+                    }
+                    release(value);
+                },
+                [&](const ast::VariableDeclarationStatement &varDecl) {
+                    if (!varDecl.initializer || varDecl.slot == ast::unresolvedSlot) {
+                        delegate(statement); // default values depend on the declared type
+                        return;
+                    }
+                    const auto value = allocate();
+                    expression(*varDecl.initializer, value);
+                    emit(OpCode::BindSlot, value, slotOperand(varDecl.slot));
+                    release(value);
+                },
+                [&](const ast::IfStatement &ifStmt) {
+                    const auto cond = allocate();
+                    expression(ifStmt.condition, cond);
+                    const auto toElse = emit(OpCode::JumpIfNotTrue, cond);
+                    release(cond);
+                    statements(ifStmt.thenBranch);
+                    if (ifStmt.elseBranch.empty()) {
+                        program_->code[toElse].b = here();
+                        return;
+                    }
+                    const auto toEnd = emit(OpCode::Jump);
+                    program_->code[toElse].b = here();
+                    statements(ifStmt.elseBranch);
+                    program_->code[toEnd].a = here();
+                },
+                [&](const ast::WhileStatement &whileStmt) {
+                    const auto counter = allocate();
+                    emit(OpCode::LoadConst, counter, constant(JsonValue(0.0)));
+                    const auto top = emit(OpCode::LoopGuard, counter);
+                    const auto cond = allocate();
+                    expression(whileStmt.condition, cond);
+                    const auto exit = emit(OpCode::JumpIfNotTrue, cond);
+                    release(cond);
+                    statements(whileStmt.body);
+                    emit(OpCode::Jump, top);
+                    program_->code[exit].b = here();
+                    release(counter);
+                },
+                [&](const ast::ForStatement &forStmt) {
+                    if (isBatchedFor(forStmt) || forStmt.parallel) {
+                        delegate(statement); // one executeBatch call, or iterations on other threads
+                        return;
+                    }
+                    const auto items = allocate(2); // collection (or its size), then the index
+                    std::uint32_t top;
+                    if (const auto *source = forStmt.collection ? std::get_if<ast::VariableExpression>(&forStmt.collection->node) : nullptr) {
+                        // A stored list is iterated where it lives instead of being copied into a register
+                        const auto loopVar = variable(forStmt.loopVar);
+                        emit(OpCode::ForInitVar, items, variable(*source)); // lands at loopVar + 1
+                        top = emit(OpCode::ForNextVar, items, loopVar);
+                    } else {
+                        expression(forStmt.collection, items);
+                        emit(OpCode::ForInit, items);
+                        top = emit(OpCode::ForNext, items, variable(forStmt.loopVar));
+                    }
+                    statements(forStmt.body);
+                    emit(OpCode::Jump, top);
+                    program_->code[top].c = here();
+                    release(items);
+                },
+                [&](const ast::SwitchStatement &switchStmt) {
+                    const auto selector = allocate();
+                    expression(switchStmt.selector, selector);
+                    std::vector<std::uint32_t> toCase;
+                    for (const auto &switchCase : switchStmt.cases) {
+                        const auto match = allocate();
+                        expression(switchCase.match, match);
+                        toCase.push_back(emit(OpCode::JumpIfEqual, selector, match));
+                        release(match);
+                    }
+                    release(selector);
+                    std::vector<std::uint32_t> toEnd;
+                    if (switchStmt.defaultBranch) {
+                        statements(*switchStmt.defaultBranch);
+                    }
+                    toEnd.push_back(emit(OpCode::Jump));
+                    for (std::size_t i = 0; i < switchStmt.cases.size(); ++i) {
+                        program_->code[toCase[i]].c = here();
+                        statements(switchStmt.cases[i].body);
+                        toEnd.push_back(emit(OpCode::Jump));
+                    }
+                    for (const auto jump : toEnd) {
+                        program_->code[jump].a = here();
+                    }
+                },
+                [&](const ast::TryCatchStatement &tryCatch) {
+                    const auto catchVar = tryCatch.exceptionVar ? variable(*tryCatch.exceptionVar) : noOperand;
+                    const auto begin = emit(OpCode::TryBegin, catchVar);
+                    statements(tryCatch.tryBlock);
+                    emit(OpCode::TryEnd);
+                    const auto toEnd = emit(OpCode::Jump);
+                    program_->code[begin].b = here();
+                    statements(tryCatch.catchBlock);
+                    program_->code[toEnd].a = here();
+                },
+                [&](const ast::ReturnStatement &returnStmt) {
+                    // Misplaced RETURNs raise the tree-walker's error, before any value is evaluated
+                    if (procedure_.isFunction != static_cast<bool>(returnStmt.value)) {
+                        delegate(statement);
+                        return;
+                    }
+                    if (!returnStmt.value) {
+                        emit(OpCode::Return, noOperand);
+                        return;
+                    }
+                    const auto *var = std::get_if<ast::VariableExpression>(&returnStmt.value->node);
+                    if (var && isSlotAccess(*var)) {
+                        emit(OpCode::ReturnSlot, slotOperand(var->slot), variable(*var));
+                        return;
+                    }
+                    const auto value = allocate();
+                    expression(returnStmt.value, value);
+                    emit(OpCode::Return, value);
+                    release(value);
+                },
+                [&](const ast::ThrowStatement &throwStmt) {
+                    const auto value = allocate();
+                    expression(throwStmt.value, value);
+                    emit(OpCode::Throw, value);
+                    release(value);
+                },
+                [&](const ast::BlockStatement &block) { statements(block.statements); },
+                [&](const ast::SqlStatement &) { emit(OpCode::ExecSql, statementIndex(statement)); },
+                [&](const auto &) { delegate(statement); }
+            },
+            statement.node);
+    }
+
+    static bool isBatchedFor(const ast::ForStatement &forStmt) {
+        if (forStmt.body.size() != 1) {
+            return false;
+        }
+        const auto *sql = std::get_if<ast::SqlStatement>(&forStmt.body.front().node);
+        return sql && sql->kind == ast::SqlStatementKind::ExecImmediate && sql->compiled.batchable;
+    }
+};
+
+const char *opName(OpCode op) {
+    switch (op) {
+        case OpCode::LoadConst: return "LOAD_CONST";
+        case OpCode::LoadSlot: return "LOAD_SLOT";
+        case OpCode::LoadVar: return "LOAD_VAR";
+        case OpCode::LoadSqlCode: return "LOAD_SQLCODE";
+        case OpCode::StoreSlot: return "STORE_SLOT";
+        case OpCode::StoreVar: return "STORE_VAR";
+        case OpCode::BindSlot: return "BIND_SLOT";
+        case OpCode::Positive: return "POS";
+        case OpCode::Negate: return "NEG";
+        case OpCode::Not: return "NOT";
+        case OpCode::Add: return "ADD";
+        case OpCode::Subtract: return "SUB";
+        case OpCode::Multiply: return "MUL";
+        case OpCode::Divide: return "DIV";
+        case OpCode::Modulo: return "MOD";
+        case OpCode::Equal: return "EQ";
+        case OpCode::NotEqual: return "NE";
+        case OpCode::Less: return "LT";
+        case OpCode::LessEqual: return "LE";
+        case OpCode::Greater: return "GT";
+        case OpCode::GreaterEqual: return "GE";
+        case OpCode::And: return "AND";
+        case OpCode::Or: return "OR";
+        case OpCode::RoundScale: return "ROUND_SCALE";
+        case OpCode::NewObject: return "NEW_OBJECT";
+        case OpCode::SetField: return "SET_FIELD";
+        case OpCode::NewArray: return "NEW_ARRAY";
+        case OpCode::Push: return "PUSH";
+        case OpCode::Builtin: return "BUILTIN";
+        case OpCode::EvalTree: return "EVAL_TREE";
+        case OpCode::Jump: return "JUMP";
+        case OpCode::JumpIfNotTrue: return "JUMP_IF_NOT_TRUE";
+        case OpCode::JumpIfEqual: return "JUMP_IF_EQUAL";
+        case OpCode::LoopGuard: return "LOOP_GUARD";
+        case OpCode::ForInit: return "FOR_INIT";
+        case OpCode::ForNext: return "FOR_NEXT";
+        case OpCode::ForInitVar: return "FOR_INIT_VAR";
+        case OpCode::ForNextVar: return "FOR_NEXT_VAR";
+        case OpCode::TryBegin: return "TRY_BEGIN";
+        case OpCode::TryEnd: return "TRY_END";
+        case OpCode::Throw: return "THROW";
+        case OpCode::Return: return "RETURN";
+        case OpCode::ReturnSlot: return "RETURN_SLOT";
+        case OpCode::ExecSql: return "EXEC_SQL";
+        case OpCode::ExecStatement: return "EXEC_STATEMENT";
+    }
+    return "?";
+}
+
+} // namespace
+
+std::shared_ptr<const Program> compileProcedure(const ast::ProcedureDecl &procedure) {
+    return Compiler{procedure}.compile();
+}
+
+std::string disassemble(const Program &program) {
+    std::ostringstream out;
+    for (std::size_t pc = 0; pc < program.code.size(); ++pc) {
+        const auto &instruction = program.code[pc];
+        out << pc << '\t' << opName(instruction.op) << ' ' << instruction.a << ' ' << instruction.b << ' ' << instruction.c << '\n';
+    }
+    return out.str();
+}
+
+std::string fingerprint(const Program &program) {
+    std::ostringstream canonical;
+    canonical << disassemble(program) << "registers " << program.registerCount << '\n';
+    for (const auto &constant : program.constants) {
+        if (const auto *number = std::get_if<double>(&constant.data)) {
+            canonical << "number " << std::hexfloat << *number << std::defaultfloat << '\n';
+        } else if (const auto *text = std::get_if<std::string>(&constant.data)) {
+            canonical << "string " << text->size() << ' ' << *text << '\n';
+        } else if (const auto *flag = std::get_if<bool>(&constant.data)) {
+            canonical << "bool " << *flag << '\n';
+        } else {
+            canonical << "value " << constant << '\n';
+        }
+    }
+    for (const auto &key : program.keys) {
+        canonical << "key " << key.size() << ' ' << key << '\n';
+    }
+
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char c : canonical.str()) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return out.str();
+}
+
+} // namespace trx::runtime
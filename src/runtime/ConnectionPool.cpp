@@ -0,0 +1,420 @@
+#include "trx/runtime/ConnectionPool.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+namespace trx::runtime {
+
+ConnectionPool::ConnectionPool(DatabaseConfig config, ConnectionPoolConfig poolConfig)
+    : ConnectionPool([config = std::move(config)]() { return createDatabaseDriver(config); }, poolConfig) {}
+
+ConnectionPool::ConnectionPool(ConnectionFactory factory, ConnectionPoolConfig poolConfig)
+    : factory_(std::move(factory)), poolConfig_(poolConfig) {
+    if (poolConfig_.maxConnections == 0) {
+        poolConfig_.maxConnections = 1;
+    }
+    if (poolConfig_.minConnections > poolConfig_.maxConnections) {
+        poolConfig_.minConnections = poolConfig_.maxConnections;
+    }
+}
+
+ConnectionPool::~ConnectionPool() = default;
+
+std::unique_ptr<DatabaseDriver> ConnectionPool::openConnection() {
+    auto connection = factory_();
+    if (!connection) {
+        throw std::runtime_error("Connection factory returned no driver");
+    }
+    connection->initialize();
+    return connection;
+}
+
+void ConnectionPool::initialize() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (initialized_) {
+        return;
+    }
+    initialized_ = true;
+    while (open_ < poolConfig_.minConnections) {
+        ++open_;
+        lock.unlock();
+        std::unique_ptr<DatabaseDriver> connection;
+        try {
+            connection = openConnection();
+        } catch (...) {
+            lock.lock();
+            --open_;
+            initialized_ = false;
+            throw;
+        }
+        lock.lock();
+        ++created_;
+        idle_.push_back(IdleConnection{std::move(connection), Clock::now()});
+    }
+    available_.notify_all();
+}
+
+std::unique_ptr<DatabaseDriver> ConnectionPool::checkout() {
+    std::vector<std::unique_ptr<DatabaseDriver>> closed;
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto deadline = Clock::now() + poolConfig_.checkoutTimeout;
+    pruneIdleLocked(Clock::now(), closed);
+
+    for (;;) {
+        if (!idle_.empty()) {
+            auto entry = std::move(idle_.back());
+            idle_.pop_back();
+            ++inUse_;
+            lock.unlock();
+
+            const bool stale = Clock::now() - entry.lastUsed >= poolConfig_.healthCheckInterval;
+            if (!stale || entry.driver->ping()) {
+                return std::move(entry.driver);
+            }
+
+            // Broken connection: close it and try again with the freed slot
+            const auto *broken = entry.driver.get();
+            entry.driver.reset();
+            lock.lock();
+            reportedStatementCaches_.erase(broken);
+            --inUse_;
+            --open_;
+            ++discarded_;
+            continue;
+        }
+
+        if (open_ < poolConfig_.maxConnections) {
+            ++open_;
+            ++inUse_;
+            lock.unlock();
+            try {
+                auto connection = openConnection();
+                lock.lock();
+                ++created_;
+                return connection;
+            } catch (...) {
+                lock.lock();
+                --open_;
+                --inUse_;
+                available_.notify_one();
+                throw;
+            }
+        }
+
+        ++waits_;
+        if (available_.wait_until(lock, deadline) == std::cv_status::timeout &&
+            idle_.empty() && open_ >= poolConfig_.maxConnections) {
+            throw std::runtime_error("Timed out waiting for a database connection");
+        }
+    }
+}
+
+void ConnectionPool::checkin(std::unique_ptr<DatabaseDriver> connection, bool reusable) {
+    std::vector<std::unique_ptr<DatabaseDriver>> closed;
+    // Read while this thread still owns the connection; drivers are not thread-safe
+    const auto cacheStats = connection ? connection->statementCacheStats() : StatementCacheStats{};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --inUse_;
+        if (connection) {
+            recordStatementCacheStatsLocked(connection.get(), cacheStats);
+        }
+        if (reusable && connection) {
+            idle_.push_back(IdleConnection{std::move(connection), Clock::now()});
+        } else {
+            --open_;
+            ++discarded_;
+            reportedStatementCaches_.erase(connection.get());
+            closed.push_back(std::move(connection));
+        }
+        pruneIdleLocked(Clock::now(), closed);
+    }
+    available_.notify_one();
+    // Connections in 'closed' are torn down here, outside the lock
+}
+
+void ConnectionPool::pruneIdleLocked(Clock::time_point now, std::vector<std::unique_ptr<DatabaseDriver>> &closed) {
+    // Oldest entries sit at the front; connections above the minimum that have
+    // been idle for longer than the timeout are closed.
+    while (!idle_.empty() && open_ > poolConfig_.minConnections &&
+           now - idle_.front().lastUsed >= poolConfig_.idleTimeout) {
+        reportedStatementCaches_.erase(idle_.front().driver.get());
+        closed.push_back(std::move(idle_.front().driver));
+        idle_.pop_front();
+        --open_;
+        ++discarded_;
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{.open = open_, .idle = idle_.size(), .inUse = inUse_, .created = created_, .discarded = discarded_, .waits = waits_};
+}
+
+void ConnectionPool::recordStatementCacheStatsLocked(const DatabaseDriver *connection, const StatementCacheStats &current) {
+    // Counters only grow on a connection, so the difference since the last report is new work
+    auto &reported = reportedStatementCaches_[connection];
+    const auto grown = [](std::size_t now, std::size_t before) { return now >= before ? now - before : now; };
+    statementCache_.hits += grown(current.hits, reported.hits);
+    statementCache_.misses += grown(current.misses, reported.misses);
+    statementCache_.evictions += grown(current.evictions, reported.evictions);
+    reported = current;
+}
+
+void ConnectionPool::recordStatementCacheStats(const DatabaseDriver &connection) {
+    const auto current = connection.statementCacheStats();
+    std::lock_guard<std::mutex> lock(mutex_);
+    recordStatementCacheStatsLocked(&connection, current);
+}
+
+StatementCacheStats ConnectionPool::statementCacheStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto result = statementCache_;
+    for (const auto &[connection, reported] : reportedStatementCaches_) {
+        result.size += reported.size;
+        result.capacity += reported.capacity;
+    }
+    return result;
+}
+
+PooledDatabaseDriver::PooledDatabaseDriver(std::shared_ptr<ConnectionPool> pool)
+    : pool_(std::move(pool)) {
+    if (!pool_) {
+        throw std::runtime_error("PooledDatabaseDriver requires a connection pool");
+    }
+}
+
+PooledDatabaseDriver::~PooledDatabaseDriver() {
+    if (!connection_) {
+        return;
+    }
+    bool reusable = true;
+    if (queued_) {
+        try {
+            connection_->syncQueued();
+        } catch (...) {
+            reusable = false;
+        }
+    }
+    if (inTransaction_) {
+        try {
+            connection_->rollbackTransaction();
+        } catch (...) {
+            reusable = false;
+        }
+    }
+    for (const auto &name : openCursors_) {
+        try {
+            connection_->closeCursor(name);
+        } catch (...) {
+            reusable = false;
+        }
+    }
+    release(reusable);
+}
+
+DatabaseDriver &PooledDatabaseDriver::connection() {
+    if (!connection_) {
+        connection_ = pool_->checkout();
+        connection_->setDeadline(deadline_);
+    }
+    return *connection_;
+}
+
+void PooledDatabaseDriver::release(bool reusable) {
+    // The next borrower brings its own deadline
+    connection_->setDeadline({});
+    pool_->checkin(std::move(connection_), reusable);
+}
+
+void PooledDatabaseDriver::releaseIfIdle() {
+    if (connection_ && !inTransaction_ && openCursors_.empty() && !queued_) {
+        release(true);
+    }
+}
+
+void PooledDatabaseDriver::discardConnection() {
+    if (connection_) {
+        release(false);
+    }
+    openCursors_.clear();
+    inTransaction_ = false;
+    queued_ = false;
+}
+
+template <typename Fn>
+auto PooledDatabaseDriver::withConnection(Fn &&fn) -> decltype(fn(std::declval<DatabaseDriver &>())) {
+    auto &conn = connection();
+    try {
+        if constexpr (std::is_void_v<decltype(fn(conn))>) {
+            fn(conn);
+            releaseIfIdle();
+        } else {
+            auto result = fn(conn);
+            releaseIfIdle();
+            return result;
+        }
+    } catch (...) {
+        releaseIfIdle();
+        throw;
+    }
+}
+
+void PooledDatabaseDriver::initialize() {
+    pool_->initialize();
+}
+
+void PooledDatabaseDriver::executeSql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    withConnection([&](DatabaseDriver &conn) { conn.executeSql(sql, params); });
+}
+
+std::vector<std::size_t> PooledDatabaseDriver::executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) {
+    return withConnection([&](DatabaseDriver &conn) { return conn.executeBatch(sql, paramSets); });
+}
+
+bool PooledDatabaseDriver::queueSql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    return withConnection([&](DatabaseDriver &conn) {
+        const bool queued = conn.queueSql(sql, params);
+        queued_ = queued_ || queued;
+        return queued;
+    });
+}
+
+bool PooledDatabaseDriver::syncQueued() {
+    if (!connection_) {
+        return true;
+    }
+    return withConnection([&](DatabaseDriver &conn) {
+        queued_ = false;
+        return conn.syncQueued();
+    });
+}
+
+std::vector<std::vector<SqlValue>> PooledDatabaseDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    return withConnection([&](DatabaseDriver &conn) { return conn.querySql(sql, params); });
+}
+
+void PooledDatabaseDriver::queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) {
+    withConnection([&](DatabaseDriver &conn) { conn.queryRows(sql, params, onRow); });
+}
+
+void PooledDatabaseDriver::openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.openCursor(name, sql, params);
+        openCursors_.insert(name);
+    });
+}
+
+void PooledDatabaseDriver::openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.openPositionedCursor(name, sql, params);
+        openCursors_.insert(name);
+    });
+}
+
+void PooledDatabaseDriver::openDeclaredCursor(const std::string& name) {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.openDeclaredCursor(name);
+        openCursors_.insert(name);
+    });
+}
+
+void PooledDatabaseDriver::openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params) {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.openDeclaredCursorWithParams(name, params);
+        openCursors_.insert(name);
+    });
+}
+
+bool PooledDatabaseDriver::cursorNext(const std::string& name) {
+    return withConnection([&](DatabaseDriver &conn) { return conn.cursorNext(name); });
+}
+
+std::vector<SqlValue> PooledDatabaseDriver::cursorGetRow(const std::string& name) {
+    return withConnection([&](DatabaseDriver &conn) { return conn.cursorGetRow(name); });
+}
+
+void PooledDatabaseDriver::closeCursor(const std::string& name) {
+    withConnection([&](DatabaseDriver &conn) {
+        openCursors_.erase(name);
+        conn.closeCursor(name);
+    });
+}
+
+void PooledDatabaseDriver::createOrMigrateTable(const std::string& tableName, const std::vector<TableColumn>& columns) {
+    withConnection([&](DatabaseDriver &conn) { conn.createOrMigrateTable(tableName, columns); });
+}
+
+std::vector<TableColumn> PooledDatabaseDriver::getTableSchema(const std::string& tableName) {
+    return withConnection([&](DatabaseDriver &conn) { return conn.getTableSchema(tableName); });
+}
+
+std::optional<std::string> PooledDatabaseDriver::schemaVersion() {
+    return withConnection([](DatabaseDriver &conn) { return conn.schemaVersion(); });
+}
+
+void PooledDatabaseDriver::beginTransaction() {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.beginTransaction();
+        inTransaction_ = true;
+    });
+}
+
+void PooledDatabaseDriver::beginReadOnlyTransaction() {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.beginReadOnlyTransaction();
+        inTransaction_ = true;
+    });
+}
+
+void PooledDatabaseDriver::commitTransaction() {
+    withConnection([&](DatabaseDriver &conn) {
+        conn.commitTransaction();
+        inTransaction_ = false;
+    });
+}
+
+void PooledDatabaseDriver::rollbackTransaction() {
+    if (!connection_) {
+        inTransaction_ = false;
+        return;
+    }
+    try {
+        inTransaction_ = false;
+        connection_->rollbackTransaction();
+    } catch (...) {
+        // A connection that cannot roll back is in an unknown state
+        discardConnection();
+        throw;
+    }
+    releaseIfIdle();
+}
+
+bool PooledDatabaseDriver::isInTransaction() {
+    return connection_ && connection_->isInTransaction();
+}
+
+bool PooledDatabaseDriver::ping() {
+    return withConnection([&](DatabaseDriver &conn) { return conn.ping(); });
+}
+
+void PooledDatabaseDriver::setDeadline(const Deadline& deadline) {
+    deadline_ = deadline;
+    if (connection_) {
+        connection_->setDeadline(deadline_);
+    }
+}
+
+StatementCacheStats PooledDatabaseDriver::statementCacheStats() const {
+    // Each pooled connection keeps its own cache; report them all, including the pinned one
+    if (connection_) {
+        pool_->recordStatementCacheStats(*connection_);
+    }
+    return pool_->statementCacheStats();
+}
+
+std::unique_ptr<DatabaseDriver> PooledDatabaseDriver::openSibling() {
+    return std::make_unique<PooledDatabaseDriver>(pool_);
+}
+
+} // namespace trx::runtime
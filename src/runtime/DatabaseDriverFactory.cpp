@@ -1,5 +1,6 @@
 #include "trx/runtime/DatabaseDriver.h"
 #include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/SqlStatistics.h"
 #ifdef HAVE_POSTGRESQL
 #include "trx/runtime/PostgreSQLDriver.h"
 #endif
@@ -9,7 +10,9 @@
 
 namespace trx::runtime {
 
-std::unique_ptr<DatabaseDriver> createDatabaseDriver(const DatabaseConfig& config) {
+namespace {
+
+std::unique_ptr<DatabaseDriver> createBackendDriver(const DatabaseConfig& config) {
     switch (config.type) {
         case DatabaseType::SQLITE:
             return std::make_unique<SQLiteDriver>(config);
@@ -36,4 +39,14 @@ std::unique_ptr<DatabaseDriver> createDatabaseDriver(const DatabaseConfig& confi
     }
 }
 
+} // namespace
+
+std::unique_ptr<DatabaseDriver> createDatabaseDriver(const DatabaseConfig& config) {
+    auto driver = createBackendDriver(config);
+    if (config.sqlStatistics) {
+        return std::make_unique<InstrumentedDriver>(std::move(driver), config.sqlStatistics);
+    }
+    return driver;
+}
+
 } // namespace trx::runtime
\ No newline at end of file
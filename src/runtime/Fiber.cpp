@@ -0,0 +1,300 @@
+#include "trx/runtime/Fiber.h"
+
+#include "trx/runtime/RequestArena.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <system_error>
+
+namespace trx::runtime {
+
+struct FiberScheduler::Context {
+    ucontext_t context;
+};
+
+struct FiberScheduler::Fiber {
+    ucontext_t context;
+    void *mapping{nullptr}; // guard page, then the stack
+    std::size_t mappedBytes{0};
+    std::size_t guardBytes{0};
+    std::function<void()> task;
+    std::size_t index{0};
+    bool finished{false};
+    bool ready{false}; // a descriptor it waits for became ready
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    RequestArena *arena{nullptr}; // current arena while the fiber is switched out
+
+    ~Fiber() {
+        if (mapping) {
+            ::munmap(mapping, mappedBytes);
+        }
+    }
+};
+
+namespace {
+
+constexpr std::size_t maxIdleFibers = 64;
+constexpr int maxEvents = 64;
+
+thread_local FiberScheduler *runningScheduler = nullptr;
+thread_local FiberScheduler::Fiber *runningFiber = nullptr;
+
+// One descriptor a fiber waits for; lives on the waiting fiber's stack
+struct Registration {
+    FiberScheduler::Fiber *fiber{nullptr};
+    pollfd *fd{nullptr};
+    bool added{false};
+};
+
+std::uint32_t toEpoll(short events) {
+    std::uint32_t result = 0;
+    if (events & POLLIN) result |= EPOLLIN;
+    if (events & POLLOUT) result |= EPOLLOUT;
+    if (events & POLLPRI) result |= EPOLLPRI;
+    return result; // EPOLLERR and EPOLLHUP are always reported
+}
+
+short fromEpoll(std::uint32_t events) {
+    short result = 0;
+    if (events & EPOLLIN) result |= POLLIN;
+    if (events & EPOLLOUT) result |= POLLOUT;
+    if (events & EPOLLPRI) result |= POLLPRI;
+    if (events & EPOLLERR) result |= POLLERR;
+    if (events & EPOLLHUP) result |= POLLHUP;
+    return result;
+}
+
+int remainingMillis(std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::time_point now) {
+    if (deadline <= now) {
+        return 0;
+    }
+    // Rounded up, so a wait never ends just before its deadline and spins
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+}
+
+int countReady(std::span<pollfd> fds) {
+    return static_cast<int>(std::count_if(fds.begin(), fds.end(), [](const pollfd &fd) { return fd.revents != 0; }));
+}
+
+int blockingPoll(std::span<pollfd> fds, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    int wait = static_cast<int>(timeout.count());
+    for (;;) {
+        const int ready = ::poll(fds.data(), fds.size(), wait);
+        if (ready >= 0 || errno != EINTR) {
+            return ready;
+        }
+        if (timeout.count() >= 0) {
+            wait = remainingMillis(deadline, std::chrono::steady_clock::now());
+        }
+    }
+}
+
+} // namespace
+
+int waitForIo(std::span<pollfd> fds, std::chrono::milliseconds timeout) {
+    if (runningFiber) {
+        return runningScheduler->suspend(*runningFiber, fds, timeout);
+    }
+    return blockingPoll(fds, timeout);
+}
+
+short waitForIo(int fd, short events, std::chrono::milliseconds timeout) {
+    pollfd descriptor{fd, events, 0};
+    const int ready = waitForIo(std::span<pollfd>(&descriptor, 1), timeout);
+    // A failed wait reads as an error on the descriptor, which the caller's next call reports
+    return ready < 0 ? static_cast<short>(POLLERR) : ready == 0 ? static_cast<short>(0) : descriptor.revents;
+}
+
+FiberScheduler::FiberScheduler(std::size_t stackBytes)
+    : stackBytes_{stackBytes}, context_{std::make_unique<Context>()} {
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr; // the wake descriptor; every other one carries its Registration
+    if (epollFd_ < 0 || wakeFd_ < 0 || ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event) != 0) {
+        const int error = errno;
+        if (epollFd_ >= 0) ::close(epollFd_);
+        if (wakeFd_ >= 0) ::close(wakeFd_);
+        throw std::system_error(error, std::generic_category(), "Failed to create a fiber scheduler");
+    }
+}
+
+FiberScheduler::~FiberScheduler() {
+    ::close(epollFd_);
+    ::close(wakeFd_);
+}
+
+std::size_t FiberScheduler::currentFiberIndex() {
+    return runningFiber ? runningFiber->index : npos;
+}
+
+void FiberScheduler::spawn(std::function<void()> task) {
+    Fiber *fiber = nullptr;
+    if (!idle_.empty()) {
+        fiber = idle_.back();
+        idle_.pop_back();
+    } else {
+        auto created = std::make_unique<Fiber>();
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        created->guardBytes = page;
+        created->mappedBytes = (stackBytes_ + page - 1) / page * page + page;
+        void *mapping = ::mmap(nullptr, created->mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Failed to allocate a fiber stack");
+        }
+        created->mapping = mapping;
+        // Stacks grow down: overflowing one faults on the guard page instead of corrupting its neighbour
+        ::mprotect(mapping, page, PROT_NONE);
+        fiber = created.get();
+        fibers_.push_back(std::move(created));
+    }
+
+    fiber->task = std::move(task);
+    fiber->finished = false;
+    fiber->arena = nullptr;
+    if (freeIndices_.empty()) {
+        fiber->index = nextIndex_++;
+    } else {
+        fiber->index = freeIndices_.back();
+        freeIndices_.pop_back();
+    }
+    ::getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = static_cast<char *>(fiber->mapping) + fiber->guardBytes;
+    fiber->context.uc_stack.ss_size = fiber->mappedBytes - fiber->guardBytes;
+    fiber->context.uc_link = &context_->context; // where entry() returns to
+    ::makecontext(&fiber->context, &FiberScheduler::entry, 0);
+    ++active_;
+    resume(*fiber);
+}
+
+void FiberScheduler::entry() {
+    Fiber *fiber = runningFiber;
+    try {
+        fiber->task();
+    } catch (...) {
+        // Nothing above this frame can catch it
+        std::terminate();
+    }
+    fiber->task = nullptr; // captures are destroyed on the fiber's own stack
+    fiber->finished = true;
+}
+
+void FiberScheduler::resume(Fiber &fiber) {
+    runningScheduler = this;
+    runningFiber = &fiber;
+    RequestArena *own = RequestArena::exchangeCurrent(fiber.arena);
+    ::swapcontext(&context_->context, &fiber.context);
+    fiber.arena = RequestArena::exchangeCurrent(own);
+    runningFiber = nullptr;
+    runningScheduler = nullptr;
+
+    if (!fiber.finished) {
+        return;
+    }
+    --active_;
+    freeIndices_.push_back(fiber.index);
+    if (idle_.size() < maxIdleFibers) {
+        idle_.push_back(&fiber);
+    } else {
+        fibers_.erase(std::find_if(fibers_.begin(), fibers_.end(), [&fiber](const auto &owned) { return owned.get() == &fiber; }));
+    }
+}
+
+int FiberScheduler::suspend(Fiber &fiber, std::span<pollfd> fds, std::chrono::milliseconds timeout) {
+    std::vector<Registration> registrations(fds.size());
+    bool readyNow = false;
+    for (std::size_t i = 0; i < fds.size(); ++i) {
+        auto &fd = fds[i];
+        fd.revents = 0;
+        if (fd.fd < 0) {
+            continue; // ignored, as poll() does
+        }
+        registrations[i].fiber = &fiber;
+        registrations[i].fd = &fd;
+        epoll_event event{};
+        event.events = toEpoll(fd.events);
+        event.data.ptr = &registrations[i];
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd.fd, &event) == 0) {
+            registrations[i].added = true;
+            continue;
+        }
+        // Regular files cannot be watched and are always ready, as poll() reports them; a
+        // descriptor something else already watches is reported ready and the caller retries
+        fd.revents = errno == EBADF ? static_cast<short>(POLLNVAL) : static_cast<short>(fd.events & (POLLIN | POLLOUT));
+        readyNow = true;
+    }
+
+    if (!readyNow && timeout.count() != 0) {
+        fiber.ready = false;
+        fiber.deadline.reset();
+        if (timeout.count() > 0) {
+            fiber.deadline = std::chrono::steady_clock::now() + timeout;
+        }
+        waiting_.push_back(&fiber);
+        ::swapcontext(&fiber.context, &context_->context);
+        // poll() resumed us: our descriptors are ready or the deadline passed
+    }
+
+    for (const auto &registration : registrations) {
+        if (registration.added) {
+            ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, registration.fd->fd, nullptr);
+        }
+    }
+    return countReady(fds);
+}
+
+void FiberScheduler::poll(std::chrono::milliseconds timeout) {
+    auto now = std::chrono::steady_clock::now();
+    int wait = static_cast<int>(timeout.count());
+    for (const Fiber *fiber : waiting_) {
+        if (fiber->deadline) {
+            const int remaining = remainingMillis(*fiber->deadline, now);
+            wait = wait < 0 ? remaining : std::min(wait, remaining);
+        }
+    }
+
+    epoll_event events[maxEvents];
+    const int count = ::epoll_wait(epollFd_, events, maxEvents, wait);
+    for (int i = 0; i < count; ++i) {
+        if (!events[i].data.ptr) {
+            std::uint64_t wakes = 0;
+            [[maybe_unused]] const auto drained = ::read(wakeFd_, &wakes, sizeof(wakes));
+            continue;
+        }
+        auto *registration = static_cast<Registration *>(events[i].data.ptr);
+        registration->fd->revents |= fromEpoll(events[i].events);
+        registration->fiber->ready = true;
+    }
+
+    // Fibers are resumed after all events are in, since a resumed fiber changes waiting_
+    now = std::chrono::steady_clock::now();
+    std::vector<Fiber *> resumable;
+    std::erase_if(waiting_, [&resumable, now](Fiber *fiber) {
+        if (fiber->ready || (fiber->deadline && *fiber->deadline <= now)) {
+            resumable.push_back(fiber);
+            return true;
+        }
+        return false;
+    });
+    for (Fiber *fiber : resumable) {
+        resume(*fiber);
+    }
+}
+
+void FiberScheduler::wake() {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = ::write(wakeFd_, &one, sizeof(one));
+}
+
+} // namespace trx::runtime
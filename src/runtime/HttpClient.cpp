@@ -0,0 +1,333 @@
+#include "trx/runtime/HttpClient.h"
+
+#include "trx/runtime/Fiber.h"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace trx::runtime {
+
+namespace {
+
+constexpr std::size_t maxIdleHandles = 16;
+constexpr std::size_t maxIdleMultis = 4;
+constexpr long fallbackWaitMs = 1000;
+
+std::size_t appendBody(char *contents, std::size_t size, std::size_t count, void *userdata) {
+    static_cast<std::string *>(userdata)->append(contents, size * count);
+    return size * count;
+}
+
+// Handles owned by one thread; connections live in the share handle and outlast each transfer.
+// Each run() takes a multi handle of its own, since fibers on the thread run them interleaved.
+class ThreadHandles {
+public:
+    ThreadHandles() {
+        static std::once_flag initialized;
+        std::call_once(initialized, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+        share_ = curl_share_init();
+        if (!share_) {
+            throw std::runtime_error("Failed to initialize HTTP client");
+        }
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    ~ThreadHandles() {
+        for (CURL *easy : idle_) {
+            curl_easy_cleanup(easy);
+        }
+        for (CURLM *multi : idleMultis_) {
+            curl_multi_cleanup(multi);
+        }
+        curl_share_cleanup(share_);
+    }
+
+    ThreadHandles(const ThreadHandles &) = delete;
+    ThreadHandles &operator=(const ThreadHandles &) = delete;
+
+    CURLM *acquireMulti() {
+        if (!idleMultis_.empty()) {
+            CURLM *multi = idleMultis_.back();
+            idleMultis_.pop_back();
+            return multi;
+        }
+        CURLM *multi = curl_multi_init();
+        if (!multi) {
+            throw std::runtime_error("Failed to initialize HTTP client");
+        }
+        return multi;
+    }
+
+    void releaseMulti(CURLM *multi) {
+        if (idleMultis_.size() < maxIdleMultis) {
+            idleMultis_.push_back(multi);
+        } else {
+            curl_multi_cleanup(multi);
+        }
+    }
+
+    CURL *acquire() {
+        CURL *easy = nullptr;
+        if (!idle_.empty()) {
+            easy = idle_.back();
+            idle_.pop_back();
+            curl_easy_reset(easy);
+        } else {
+            easy = curl_easy_init();
+            if (!easy) {
+                throw std::runtime_error("Failed to initialize HTTP client");
+            }
+        }
+        curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+        return easy;
+    }
+
+    void release(CURL *easy) {
+        if (idle_.size() < maxIdleHandles) {
+            idle_.push_back(easy);
+        } else {
+            curl_easy_cleanup(easy);
+        }
+    }
+
+private:
+    CURLSH *share_{nullptr};
+    std::vector<CURL *> idle_;
+    std::vector<CURLM *> idleMultis_;
+};
+
+ThreadHandles &threadHandles() {
+    thread_local ThreadHandles handles;
+    return handles;
+}
+
+// Sockets and the timeout curl asks a multi handle's owner to wait for
+struct Watch {
+    std::vector<pollfd> fds;
+    long timeoutMs{-1}; // -1: no timeout pending
+};
+
+int watchSocket(CURL *, curl_socket_t socket, int what, void *userdata, void *) {
+    auto &fds = static_cast<Watch *>(userdata)->fds;
+    auto found = std::find_if(fds.begin(), fds.end(), [socket](const pollfd &fd) { return fd.fd == socket; });
+    if (what == CURL_POLL_REMOVE) {
+        if (found != fds.end()) {
+            fds.erase(found);
+        }
+        return 0;
+    }
+    short events = 0;
+    if (what & CURL_POLL_IN) events |= POLLIN;
+    if (what & CURL_POLL_OUT) events |= POLLOUT;
+    if (found == fds.end()) {
+        fds.push_back(pollfd{socket, events, 0});
+    } else {
+        found->events = events;
+    }
+    return 0;
+}
+
+int watchTimer(CURLM *, long timeoutMs, void *userdata) {
+    static_cast<Watch *>(userdata)->timeoutMs = timeoutMs;
+    return 0;
+}
+
+// A multi handle borrowed for one run(), reporting its sockets to |watch|
+class MultiLease {
+public:
+    explicit MultiLease(ThreadHandles &handles) : handles_{handles}, multi_{handles.acquireMulti()} {
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, watchSocket);
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, &watch);
+        curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, watchTimer);
+        curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, &watch);
+    }
+
+    ~MultiLease() {
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, static_cast<curl_socket_callback>(nullptr));
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, static_cast<void *>(nullptr));
+        curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, static_cast<curl_multi_timer_callback>(nullptr));
+        curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, static_cast<void *>(nullptr));
+        handles_.releaseMulti(multi_);
+    }
+
+    MultiLease(const MultiLease &) = delete;
+    MultiLease &operator=(const MultiLease &) = delete;
+
+    CURLM *get() const { return multi_; }
+
+    Watch watch;
+
+private:
+    ThreadHandles &handles_;
+    CURLM *multi_;
+};
+
+// One request in flight; detaches from the multi handle and returns its easy handle when done
+class Transfer {
+public:
+    Transfer(ThreadHandles &handles, CURLM *multi, const HttpCall &call)
+        : handles_{handles}, multi_{multi}, easy_{handles.acquire()} {
+        curl_easy_setopt(easy_, CURLOPT_URL, call.url.c_str());
+        if (call.method == "GET") {
+            curl_easy_setopt(easy_, CURLOPT_HTTPGET, 1L);
+        } else if (call.method == "HEAD") {
+            curl_easy_setopt(easy_, CURLOPT_NOBODY, 1L);
+        } else {
+            if (call.method == "POST" || call.method == "PUT" || call.method == "PATCH") {
+                curl_easy_setopt(easy_, CURLOPT_POSTFIELDS, call.body.c_str());
+            }
+            if (call.method != "POST") {
+                curl_easy_setopt(easy_, CURLOPT_CUSTOMREQUEST, call.method.c_str());
+            }
+        }
+
+        for (const auto &[key, value] : call.headers) {
+            headers_ = curl_slist_append(headers_, (key + ": " + value).c_str());
+        }
+        if (headers_) {
+            curl_easy_setopt(easy_, CURLOPT_HTTPHEADER, headers_);
+        }
+
+        curl_easy_setopt(easy_, CURLOPT_WRITEFUNCTION, appendBody);
+        curl_easy_setopt(easy_, CURLOPT_WRITEDATA, &reply_.body);
+        curl_easy_setopt(easy_, CURLOPT_TIMEOUT_MS, call.timeoutMs);
+        curl_easy_setopt(easy_, CURLOPT_ERRORBUFFER, errorBuffer_);
+        curl_easy_setopt(easy_, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy_, CURLOPT_PRIVATE, this);
+
+        // Don't verify SSL certificates for now (in production, this should be configurable)
+        curl_easy_setopt(easy_, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(easy_, CURLOPT_SSL_VERIFYHOST, 0L);
+
+        if (curl_multi_add_handle(multi_, easy_) != CURLM_OK) {
+            cleanup();
+            throw std::runtime_error("Failed to start HTTP request");
+        }
+        added_ = true;
+    }
+
+    ~Transfer() { cleanup(); }
+
+    Transfer(const Transfer &) = delete;
+    Transfer &operator=(const Transfer &) = delete;
+
+    void finish(CURLcode result) {
+        if (result == CURLE_OK) {
+            curl_easy_getinfo(easy_, CURLINFO_RESPONSE_CODE, &reply_.status);
+        } else {
+            reply_.error = errorBuffer_[0] ? errorBuffer_ : curl_easy_strerror(result);
+        }
+        done_ = true;
+    }
+
+    HttpReply take() {
+        if (!done_) {
+            reply_.error = "HTTP request did not complete";
+        }
+        return std::move(reply_);
+    }
+
+private:
+    void cleanup() {
+        if (!easy_) {
+            return;
+        }
+        if (added_) {
+            curl_multi_remove_handle(multi_, easy_);
+        }
+        if (headers_) {
+            curl_slist_free_all(headers_);
+            headers_ = nullptr;
+        }
+        handles_.release(easy_);
+        easy_ = nullptr;
+    }
+
+    ThreadHandles &handles_;
+    CURLM *multi_;
+    CURL *easy_;
+    curl_slist *headers_{nullptr};
+    bool added_{false};
+    bool done_{false};
+    char errorBuffer_[CURL_ERROR_SIZE]{};
+    HttpReply reply_;
+};
+
+void collectFinished(CURLM *multi) {
+    int queued = 0;
+    while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+        if (message->msg == CURLMSG_DONE) {
+            char *transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            reinterpret_cast<Transfer *>(transfer)->finish(message->data.result);
+        }
+    }
+}
+
+std::vector<HttpReply> run(const HttpCall *calls, std::size_t count) {
+    auto &handles = threadHandles();
+    MultiLease multi(handles); // outlives the transfers, which detach from it
+    std::vector<std::unique_ptr<Transfer>> transfers;
+    transfers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        transfers.push_back(std::make_unique<Transfer>(handles, multi.get(), calls[i]));
+    }
+
+    // Waiting goes through waitForIo, so a fiber gives its thread up while the replies are on their way
+    int running = 0;
+    bool ok = curl_multi_socket_action(multi.get(), CURL_SOCKET_TIMEOUT, 0, &running) == CURLM_OK;
+    collectFinished(multi.get());
+    while (ok && running > 0) {
+        // The callbacks change the watch list during socket_action, so wait on a copy
+        std::vector<pollfd> fds = multi.watch.fds;
+        const long timeoutMs = multi.watch.timeoutMs < 0 ? fallbackWaitMs : multi.watch.timeoutMs;
+        const int ready = waitForIo(fds, std::chrono::milliseconds(timeoutMs));
+        if (ready < 0) {
+            break;
+        }
+        if (ready == 0) {
+            ok = curl_multi_socket_action(multi.get(), CURL_SOCKET_TIMEOUT, 0, &running) == CURLM_OK;
+        }
+        for (const auto &fd : fds) {
+            if (!ok || fd.revents == 0) {
+                continue;
+            }
+            int mask = 0;
+            if (fd.revents & POLLIN) mask |= CURL_CSELECT_IN;
+            if (fd.revents & POLLOUT) mask |= CURL_CSELECT_OUT;
+            if (fd.revents & (POLLERR | POLLHUP | POLLNVAL)) mask |= CURL_CSELECT_ERR;
+            ok = curl_multi_socket_action(multi.get(), fd.fd, mask, &running) == CURLM_OK;
+        }
+        collectFinished(multi.get());
+    }
+
+    std::vector<HttpReply> replies;
+    replies.reserve(count);
+    for (auto &transfer : transfers) {
+        replies.push_back(transfer->take());
+    }
+    return replies;
+}
+
+} // namespace
+
+HttpReply HttpClient::perform(const HttpCall &call) {
+    auto reply = std::move(run(&call, 1).front());
+    if (!reply.error.empty()) {
+        throw std::runtime_error("HTTP request failed: " + reply.error);
+    }
+    return reply;
+}
+
+std::vector<HttpReply> HttpClient::performAll(const std::vector<HttpCall> &calls) {
+    return run(calls.data(), calls.size());
+}
+
+} // namespace trx::runtime
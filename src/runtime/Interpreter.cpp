@@ -6,32 +6,46 @@
 #include "trx/ast/Expressions.h"
 #include "trx/ast/Statements.h"
 
+#include "trx/runtime/Bytecode.h"
 #include "trx/runtime/DatabaseDriver.h"
+#include "trx/runtime/Decimal.h"
+#include "trx/runtime/Fiber.h"
+#include "trx/runtime/HttpClient.h"
+#include "trx/runtime/JobQueue.h"
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/JsonWriter.h"
+#include "trx/runtime/ListAggregate.h"
+#include "trx/runtime/ListIndex.h"
+#include "trx/runtime/ListSort.h"
+#include "trx/runtime/Native.h"
+#include "trx/runtime/NativeLibrary.h"
+#include "trx/runtime/Logger.h"
+#include "trx/runtime/Profiler.h"
 #include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/SchemaCache.h"
+#include "trx/runtime/ThreadPool.h"
+#include "trx/runtime/Tracing.h"
 #include "trx/runtime/TrxException.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include <iostream>
 #include <chrono>
 #include <ctime>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cmath>
 #include <cstdlib>
 #include <string>
-#include <sstream>
-#include <curl/curl.h>
+#include <string_view>
 #include <map>
-
-// Callback function for curl to write response data
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
-
-// Helper function to convert JsonValue to string
-static std::string jsonValueToString(const trx::runtime::JsonValue& value) {
-    std::stringstream ss;
-    ss << value;
-    return ss.str();
-}
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <utility>
 
 namespace trx::runtime {
 
@@ -39,46 +53,159 @@ namespace trx::runtime {
 
 namespace {
 
+// Savepoint of a nested routine call. Opened by the first SQL statement the call (or a
+// routine it calls) runs, so calls that never reach the database cost no round trips.
+struct LazySavepoint {
+    LazySavepoint *parent{nullptr}; // savepoint of the calling routine, null at the top-level call
+    std::size_t depth{0};
+    std::string name{};
+    bool open{false};
+};
+
 struct ExecutionContext {
     Interpreter &interpreter;
-    std::unordered_map<std::string, JsonValue> variables;
+    std::unordered_map<std::string, JsonValue> variables; // locals the resolver did not place, by lowercased name
     bool returned{false};
     std::optional<JsonValue> returnValue;
     bool isGlobal{false};
     bool isFunction{false};
     std::optional<std::string> outputType;
+    const trx::ast::ProcedureDecl *procedure{nullptr};
+    std::vector<std::optional<JsonValue>> frame{}; // procedure locals by slot; empty until first bound
+    std::optional<TrxThrowException> thrown{};       // THROW travelling up to its CATCH
+    LazySavepoint *savepoint{nullptr};              // open on demand before SQL runs
 };
 
-void debugPrint(const std::string& message) {
-    if (getenv("DEBUG") != nullptr && std::string(getenv("DEBUG")) == "true") {
-        std::cout << message << std::endl;
+// How a statement finished. RETURN and THROW travel up through the enclosing statements
+// as this status rather than as C++ exceptions; errors raised by the runtime itself still throw.
+enum class Completion { Normal, Returned, Thrown };
+
+std::string toLowerCopy(std::string_view name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    return lower;
+}
+
+void openSavepoint(DatabaseDriver &db, LazySavepoint &savepoint) {
+    if (savepoint.open) {
+        return;
+    }
+    // Outer calls first: a RELEASE folds the writes into the caller's savepoint, which
+    // must already exist for a later rollback of the caller to undo them
+    if (savepoint.parent) {
+        openSavepoint(db, *savepoint.parent);
+    }
+    savepoint.name = "trx_call_" + std::to_string(savepoint.depth);
+    db.executeSql("SAVEPOINT " + savepoint.name);
+    savepoint.open = true;
+}
+
+// Database handle for a statement about to run SQL
+DatabaseDriver &sqlDriver(ExecutionContext &context) {
+    context.interpreter.syncSql();
+    auto &db = context.interpreter.db();
+    if (context.savepoint) {
+        openSavepoint(db, *context.savepoint);
+    }
+    return db;
+}
+
+void enterFrame(ExecutionContext &context, const trx::ast::ProcedureDecl &procedure) {
+    context.procedure = &procedure;
+    context.frame.resize(procedure.frameSlots.size());
+}
+
+// Slot of a local, looking the name up in the frame layout when the resolver left it unplaced
+std::size_t frameSlot(const ExecutionContext &context, std::size_t slot, std::string_view name) {
+    if (!context.procedure) {
+        return trx::ast::unresolvedSlot;
+    }
+    if (slot == trx::ast::unresolvedSlot) {
+        const auto &slots = context.procedure->frameSlots;
+        const auto it = std::find(slots.begin(), slots.end(), toLowerCopy(name));
+        return it == slots.end() ? trx::ast::unresolvedSlot : static_cast<std::size_t>(it - slots.begin());
+    }
+    return slot;
+}
+
+JsonValue *findLocal(ExecutionContext &context, std::size_t slot, std::string_view name) {
+    slot = frameSlot(context, slot, name);
+    if (slot < context.frame.size()) {
+        auto &cell = context.frame[slot];
+        return cell ? &*cell : nullptr;
+    }
+    const auto it = context.variables.find(toLowerCopy(name));
+    return it == context.variables.end() ? nullptr : &it->second;
+}
+
+JsonValue &bindLocal(ExecutionContext &context, std::size_t slot, std::string_view name) {
+    slot = frameSlot(context, slot, name);
+    if (slot < context.frame.size()) {
+        auto &cell = context.frame[slot];
+        if (!cell) {
+            cell.emplace();
+        }
+        return *cell;
+    }
+    return context.variables[toLowerCopy(name)];
+}
+
+// Lowercased field name; precomputed by the resolver for routine bodies
+const std::string &segmentKey(const trx::ast::VariableSegment &segment, std::string &scratch) {
+    if (!segment.key.empty()) {
+        return segment.key.str();
+    }
+    scratch = toLowerCopy(segment.identifier);
+    return scratch;
+}
+
+JsonValue *findGlobal(ExecutionContext &context, const trx::ast::VariableSegment &root) {
+    std::string scratch;
+    auto &globals = context.interpreter.globalVariables();
+    const auto it = globals.find(segmentKey(root, scratch));
+    return it == globals.end() ? nullptr : &it->second;
+}
+
+// debug(), info(), error() and trace(): a string is the message, anything else a field
+void logBuiltin(LogLevel level, const JsonValue &value) {
+    if (!Logger::enabled(level)) {
+        return;
+    }
+    if (const auto *text = std::get_if<std::string>(&value.data)) {
+        Logger::instance().write(level, *text);
+    } else {
+        Logger::instance().write(level, "", {{"value", value}});
     }
 }
 
 JsonValue evaluateExpression(const trx::ast::ExpressionPtr &expression, ExecutionContext &context);
 JsonValue resolveVariableValue(const trx::ast::VariableExpression &variable, ExecutionContext &context);
+const JsonValue &lookupVariable(const trx::ast::VariableExpression &variable, ExecutionContext &context);
+const JsonValue &evaluateInPlace(const trx::ast::ExpressionPtr &expression, ExecutionContext &context, JsonValue &scratch);
 JsonValue &resolveVariableTarget(const trx::ast::VariableExpression &variable, ExecutionContext &context);
 
-void executeStatements(const trx::ast::StatementList &statements, ExecutionContext &context);
+Completion executeStatements(const trx::ast::StatementList &statements, ExecutionContext &context);
+Completion runBody(const trx::ast::ProcedureDecl &procedure, const Program *program, ExecutionContext &context);
 
-std::vector<JsonValue> resolveHostVariablesFromAst(const std::vector<trx::ast::VariableExpression>& hostVariables, ExecutionContext &context);
+std::vector<JsonValue> resolveHostVariablesFromAst(const std::vector<trx::ast::VariableExpression>& hostVariables, ExecutionContext &context, std::size_t first = 0);
 
-std::vector<SqlParameter> convertHostVarsToParams(const std::vector<JsonValue>& hostVars) {
+std::vector<SqlParameter> convertHostVarsToParams(std::vector<JsonValue> hostVars) {
     std::vector<SqlParameter> params;
+    params.reserve(hostVars.size());
     int index = 1;
-    for (const auto& value : hostVars) {
-        params.push_back({std::to_string(index), value});
+    for (auto& value : hostVars) {
+        params.push_back({std::to_string(index), std::move(value)});
         ++index;
     }
     return params;
 }
 
-std::vector<JsonValue> resolveHostVariablesFromAst(const std::vector<trx::ast::VariableExpression>& hostVariables, ExecutionContext &context) {
+std::vector<JsonValue> resolveHostVariablesFromAst(const std::vector<trx::ast::VariableExpression>& hostVariables, ExecutionContext &context, std::size_t first) {
     std::vector<JsonValue> hostVars;
-    for (const auto& varExpr : hostVariables) {
+    hostVars.reserve(hostVariables.size() > first ? hostVariables.size() - first : 0);
+    for (std::size_t i = first; i < hostVariables.size(); ++i) {
         try {
-            JsonValue value = resolveVariableValue(varExpr, context);
-            hostVars.push_back(value);
+            hostVars.push_back(lookupVariable(hostVariables[i], context));
         } catch (const std::exception& e) {
             std::cerr << "Failed to resolve host variable: " << e.what() << std::endl;
             // Continue with other variables
@@ -104,9 +231,47 @@ JsonValue evaluateLiteral(const trx::ast::LiteralExpression &literal) {
         literal.value);
 }
 
-JsonValue evaluateUnary(const trx::ast::UnaryExpression &unary, ExecutionContext &context) {
-    JsonValue operand = evaluateExpression(unary.operand, context);
-    switch (unary.op) {
+// Literal holding a folded value; objects, arrays and null have no literal form
+std::optional<trx::ast::LiteralExpression> toLiteral(const JsonValue &value) {
+    if (const auto *number = std::get_if<double>(&value.data)) {
+        return trx::ast::LiteralExpression{*number};
+    }
+    if (const auto *text = std::get_if<std::string>(&value.data)) {
+        return trx::ast::LiteralExpression{*text};
+    }
+    if (const auto *flag = std::get_if<bool>(&value.data)) {
+        return trx::ast::LiteralExpression{*flag};
+    }
+    return std::nullopt;
+}
+
+JsonValue applyUnary(trx::ast::UnaryOperator op, const JsonValue &operand);
+JsonValue applyBinary(const trx::ast::BinaryExpression &binary, const JsonValue &lhs, const JsonValue &rhs);
+
+// Folding applies the operators evaluation uses; whatever they reject is left to fail at run time
+const trx::ast::ConstantFolder &constantFolder() {
+    static const trx::ast::ConstantFolder folder{
+        .unary = [](trx::ast::UnaryOperator op, const trx::ast::LiteralExpression &operand) -> std::optional<trx::ast::LiteralExpression> {
+            try {
+                return toLiteral(applyUnary(op, evaluateLiteral(operand)));
+            } catch (const std::exception &) {
+                return std::nullopt;
+            }
+        },
+        .binary = [](const trx::ast::BinaryExpression &binary, const trx::ast::LiteralExpression &lhs,
+                     const trx::ast::LiteralExpression &rhs) -> std::optional<trx::ast::LiteralExpression> {
+            try {
+                return toLiteral(applyBinary(binary, evaluateLiteral(lhs), evaluateLiteral(rhs)));
+            } catch (const std::exception &) {
+                return std::nullopt;
+            }
+        },
+    };
+    return folder;
+}
+
+JsonValue applyUnary(trx::ast::UnaryOperator op, const JsonValue &operand) {
+    switch (op) {
         case trx::ast::UnaryOperator::Positive:
             if (std::holds_alternative<double>(operand.data)) {
                 return operand;
@@ -126,11 +291,8 @@ JsonValue evaluateUnary(const trx::ast::UnaryExpression &unary, ExecutionContext
     throw TrxException("Unknown unary operator");
 }
 
-JsonValue evaluateBinary(const trx::ast::BinaryExpression &binary, ExecutionContext &context) {
-    JsonValue lhs = evaluateExpression(binary.lhs, context);
-    JsonValue rhs = evaluateExpression(binary.rhs, context);
-
-    switch (binary.op) {
+JsonValue applyBinary(trx::ast::BinaryOperator op, const JsonValue &lhs, const JsonValue &rhs) {
+    switch (op) {
         case trx::ast::BinaryOperator::Add:
             if (std::holds_alternative<double>(lhs.data) && std::holds_alternative<double>(rhs.data)) {
                 return JsonValue(std::get<double>(lhs.data) + std::get<double>(rhs.data));
@@ -139,14 +301,10 @@ JsonValue evaluateBinary(const trx::ast::BinaryExpression &binary, ExecutionCont
                 return JsonValue(std::get<std::string>(lhs.data) + std::get<std::string>(rhs.data));
             }
             if (std::holds_alternative<std::string>(lhs.data)) {
-                std::ostringstream oss;
-                oss << rhs;
-                return JsonValue(std::get<std::string>(lhs.data) + oss.str());
+                return JsonValue(std::get<std::string>(lhs.data) + JsonWriter::toString(rhs));
             }
             if (std::holds_alternative<std::string>(rhs.data)) {
-                std::ostringstream oss;
-                oss << lhs;
-                return JsonValue(oss.str() + std::get<std::string>(rhs.data));
+                return JsonValue(JsonWriter::toString(lhs) + std::get<std::string>(rhs.data));
             }
             throw TrxTypeException("Add operator requires compatible operands");
         case trx::ast::BinaryOperator::Subtract:
@@ -172,9 +330,9 @@ JsonValue evaluateBinary(const trx::ast::BinaryExpression &binary, ExecutionCont
             }
             throw TrxTypeException("Modulo operator requires numeric operands");
         case trx::ast::BinaryOperator::Equal:
-            return JsonValue(lhs.data == rhs.data);
+            return JsonValue(lhs == rhs);
         case trx::ast::BinaryOperator::NotEqual:
-            return JsonValue(lhs.data != rhs.data);
+            return JsonValue(lhs != rhs);
         case trx::ast::BinaryOperator::Less:
             if (std::holds_alternative<double>(lhs.data) && std::holds_alternative<double>(rhs.data)) {
                 return JsonValue(std::get<double>(lhs.data) < std::get<double>(rhs.data));
@@ -221,11 +379,206 @@ JsonValue evaluateBinary(const trx::ast::BinaryExpression &binary, ExecutionCont
     throw std::runtime_error("Unknown binary operator");
 }
 
+// An operator checkTypes() found applied to numbers goes straight to the arithmetic while
+// its operands are numbers, and rounds an exact result to its DECIMAL scale; anything
+// else takes the checks of applyBinary()
+JsonValue applyBinary(const trx::ast::BinaryExpression &binary, const JsonValue &lhs, const JsonValue &rhs) {
+    const auto *x = binary.numeric ? std::get_if<double>(&lhs.data) : nullptr;
+    const auto *y = x ? std::get_if<double>(&rhs.data) : nullptr;
+    if (!y) {
+        return applyBinary(binary.op, lhs, rhs);
+    }
+    switch (binary.op) {
+        case trx::ast::BinaryOperator::Add: return JsonValue(roundToScale(*x + *y, binary.scale));
+        case trx::ast::BinaryOperator::Subtract: return JsonValue(roundToScale(*x - *y, binary.scale));
+        case trx::ast::BinaryOperator::Multiply: return JsonValue(roundToScale(*x * *y, binary.scale));
+        case trx::ast::BinaryOperator::Equal: return JsonValue(*x == *y);
+        case trx::ast::BinaryOperator::NotEqual: return JsonValue(*x != *y);
+        case trx::ast::BinaryOperator::Less: return JsonValue(*x < *y);
+        case trx::ast::BinaryOperator::LessEqual: return JsonValue(*x <= *y);
+        case trx::ast::BinaryOperator::Greater: return JsonValue(*x > *y);
+        case trx::ast::BinaryOperator::GreaterEqual: return JsonValue(*x >= *y);
+        default: return applyBinary(binary.op, lhs, rhs); // Divide and Modulo keep their errors there
+    }
+}
+
+JsonValue evaluateUnary(const trx::ast::UnaryExpression &unary, ExecutionContext &context) {
+    return applyUnary(unary.op, evaluateExpression(unary.operand, context));
+}
+
+// A literal or a variable path without subscripts: evaluating it cannot run code
+bool isPlainRead(const trx::ast::ExpressionPtr &expression) {
+    if (!expression) {
+        return false;
+    }
+    if (std::holds_alternative<trx::ast::LiteralExpression>(expression->node)) {
+        return true;
+    }
+    const auto *variable = std::get_if<trx::ast::VariableExpression>(&expression->node);
+    return variable && std::none_of(variable->path.begin(), variable->path.end(),
+                                    [](const trx::ast::VariableSegment &segment) { return segment.subscript.has_value(); });
+}
+
+JsonValue evaluateBinary(const trx::ast::BinaryExpression &binary, ExecutionContext &context) {
+    // The left operand is only borrowed when nothing run for the right one can change it
+    if (isPlainRead(binary.rhs)) {
+        JsonValue lhsScratch;
+        JsonValue rhsScratch;
+        const JsonValue &lhs = evaluateInPlace(binary.lhs, context, lhsScratch);
+        return applyBinary(binary, lhs, evaluateInPlace(binary.rhs, context, rhsScratch));
+    }
+    JsonValue lhs = evaluateExpression(binary.lhs, context);
+    JsonValue rhs = evaluateExpression(binary.rhs, context);
+    return applyBinary(binary, lhs, rhs);
+}
+
+// Runs a routine declared with TIMEOUT under the earlier of its own deadline and the one
+// already set, restoring the latter once the routine is done
+class RoutineDeadline {
+public:
+    RoutineDeadline(Interpreter &interpreter, const trx::ast::ProcedureDecl &routine)
+        : interpreter_{interpreter}, outer_{interpreter.deadline()} {
+        interpreter.checkDeadline();
+        if (routine.timeoutSeconds > 0.0) {
+            interpreter.setDeadline(outer_.earliest(Deadline::after(std::chrono::duration<double>(routine.timeoutSeconds))));
+        }
+    }
+    ~RoutineDeadline() { interpreter_.setDeadline(outer_); }
+
+    RoutineDeadline(const RoutineDeadline &) = delete;
+    RoutineDeadline &operator=(const RoutineDeadline &) = delete;
+
+private:
+    Interpreter &interpreter_;
+    Deadline outer_;
+};
+
+// Run a routine called from an expression. The caller's transaction is already open, so
+// the call gets a savepoint only once it runs SQL, and none at all when it provably never
+// does or only reads.
+JsonValue callRoutine(const trx::ast::ProcedureDecl &routine, JsonValue argument, ExecutionContext &caller) {
+    auto &db = caller.interpreter.db();
+    if (routine.runsSql && !db.isInTransaction()) {
+        // Module statements and global initializers run outside a transaction; let execute() open one
+        return caller.interpreter.execute(routine.name.baseName, std::move(argument)).value_or(JsonValue());
+    }
+
+    Profiler::Scope frame(caller.interpreter.profiler(), routine.name.baseName);
+    Span span(caller.interpreter.tracer(), caller.interpreter.traceContext(), routine.name.baseName);
+    RoutineDeadline deadline(caller.interpreter, routine);
+    ExecutionContext context{caller.interpreter, {}, false, std::nullopt, false, routine.isFunction, std::nullopt};
+    enterFrame(context, routine);
+    if (routine.input) {
+        bindLocal(context, routine.input->slot, routine.input->name.name) = std::move(argument);
+    }
+    LazySavepoint savepoint{caller.savepoint, caller.savepoint ? caller.savepoint->depth + 1 : 0};
+    // A read-only call has nothing to undo, so its reads open no savepoint of its callers either
+    context.savepoint = routine.readOnly ? nullptr : routine.runsSql ? &savepoint : caller.savepoint;
+
+    Completion completion;
+    try {
+        completion = runBody(routine, caller.interpreter.programFor(&routine), context);
+        if (completion == Completion::Thrown) {
+            throw std::move(*context.thrown);
+        }
+        if (completion == Completion::Normal && routine.output) {
+            throw std::runtime_error("Function must return a value");
+        }
+    } catch (...) {
+        if (savepoint.open) {
+            // Released as well, so a caller that catches the error keeps a tidy savepoint stack
+            db.executeSql("ROLLBACK TO SAVEPOINT " + savepoint.name);
+            db.executeSql("RELEASE SAVEPOINT " + savepoint.name);
+        }
+        throw;
+    }
+    if (savepoint.open) {
+        db.executeSql("RELEASE SAVEPOINT " + savepoint.name);
+    }
+
+    if (completion == Completion::Returned) {
+        return routine.output && context.returnValue ? std::move(*context.returnValue) : JsonValue();
+    }
+    if (auto *output = findLocal(context, trx::ast::unresolvedSlot, "output")) {
+        return std::move(*output);
+    }
+    return JsonValue();
+}
+
+// Reads the configuration object of an http() call
+HttpCall httpCallFrom(const JsonValue &config) {
+    if (!config.isObject()) throw std::runtime_error("http argument must be an object");
+    const auto &configObj = config.asObject();
+
+    // Required: method and url
+    if (configObj.find("method") == configObj.end()) throw std::runtime_error("http config must include 'method'");
+    if (configObj.find("url") == configObj.end()) throw std::runtime_error("http config must include 'url'");
+
+    HttpCall call;
+    call.method = configObj.at("method").asString();
+    call.url = configObj.at("url").asString();
+    static const std::set<std::string> methods{"GET", "POST", "PUT", "DELETE", "PATCH", "HEAD", "OPTIONS"};
+    if (!methods.count(call.method)) {
+        throw std::runtime_error("Unsupported HTTP method: " + call.method);
+    }
+
+    // Optional: headers, body, timeout
+    if (configObj.find("headers") != configObj.end() && configObj.at("headers").isObject()) {
+        for (const auto &[key, value] : configObj.at("headers").asObject()) {
+            call.headers[key] = value.asString();
+        }
+    }
+    if (configObj.find("body") != configObj.end()) {
+        call.body = JsonWriter::toString(configObj.at("body"));
+    }
+    if (configObj.find("timeout") != configObj.end()) {
+        call.timeoutMs = static_cast<long>(configObj.at("timeout").asNumber() * 1000.0);
+    }
+    return call;
+}
+
+// Passes the current trace on to the called service, unless the routine set its own traceparent
+void propagateTrace(HttpCall &call, ExecutionContext &context) {
+    const auto &trace = context.interpreter.traceContext();
+    if (trace.valid()) {
+        call.headers.emplace("traceparent", trace.traceparent());
+    }
+}
+
+// Gives the call no longer than what is left of the deadline, and tells the called service
+// how long that is in X-TRX-Timeout; fails once the deadline has passed
+void applyDeadline(HttpCall &call, ExecutionContext &context) {
+    const auto &deadline = context.interpreter.deadline();
+    if (!deadline.isSet()) {
+        return;
+    }
+    context.interpreter.checkDeadline();
+    const long remaining = std::max<long>(static_cast<long>(deadline.remaining().count()), 1);
+    call.timeoutMs = std::min(call.timeoutMs, remaining);
+    call.headers.emplace("X-TRX-Timeout", std::to_string(call.timeoutMs / 1000.0));
+}
+
+// The value an http() call returns; a request that got no response has status 0 and an error
+JsonValue httpResponseValue(HttpReply reply) {
+    JsonValue::Object response;
+    response["status"] = JsonValue(static_cast<double>(reply.status));
+    if (!reply.error.empty()) {
+        response["error"] = JsonValue(std::move(reply.error));
+        response["body"] = JsonValue();
+        return JsonValue(std::move(response));
+    }
+    response["headers"] = JsonValue(JsonValue::Object{{"content-type", JsonValue("application/json")}});
+    // The body is kept as a string; TRX can parse JSON at runtime if needed
+    response["body"] = JsonValue(std::move(reply.body));
+    return JsonValue(std::move(response));
+}
+
 JsonValue evaluateFunctionCall(const trx::ast::FunctionCallExpression &call, ExecutionContext &context) {
-    // For now, implement some built-in functions
-    if (call.functionName == "length" || call.functionName == "len") {
+    // Builtins first: resolveCalls() bound the call to one of them or to a user routine
+    if (call.builtin == trx::ast::BuiltinFunction::Length) {
         if (call.arguments.size() != 1) throw std::runtime_error("length/len function takes 1 argument");
-        JsonValue arg = evaluateExpression(call.arguments[0], context);
+        JsonValue scratch;
+        const JsonValue &arg = evaluateInPlace(call.arguments[0], context, scratch);
         if (std::holds_alternative<std::string>(arg.data)) {
             return JsonValue(static_cast<double>(std::get<std::string>(arg.data).size()));
         }
@@ -234,19 +587,80 @@ JsonValue evaluateFunctionCall(const trx::ast::FunctionCallExpression &call, Exe
         }
         throw std::runtime_error("length/len function requires string or array");
     }
-    if (call.functionName == "append") {
+    if (call.builtin == trx::ast::BuiltinFunction::Append) {
         if (call.arguments.size() != 2) throw std::runtime_error("append function takes 2 arguments");
         if (const auto *var = std::get_if<trx::ast::VariableExpression>(&call.arguments[0]->node)) {
-            JsonValue &list = resolveVariableTarget(*var, context);
             JsonValue item = evaluateExpression(call.arguments[1], context);
+            JsonValue &list = resolveVariableTarget(*var, context);
             if (!list.isArray()) throw std::runtime_error("first argument to append must be an array");
-            list.asArray().push_back(item);
+            list.asArray().push_back(std::move(item));
             return JsonValue(nullptr);
         } else {
             throw std::runtime_error("append first argument must be a variable");
         }
     }
-    if (call.functionName == "substr") {
+    if (call.builtin == trx::ast::BuiltinFunction::IndexBy || call.builtin == trx::ast::BuiltinFunction::GroupBy) {
+        const bool group = call.builtin == trx::ast::BuiltinFunction::GroupBy;
+        const std::string name = group ? "group_by" : "index_by";
+        if (call.arguments.size() != 2) throw std::runtime_error(name + " function takes 2 arguments");
+        JsonValue scratch;
+        const JsonValue &list = evaluateInPlace(call.arguments[0], context, scratch);
+        const JsonValue field = evaluateExpression(call.arguments[1], context);
+        if (!list.isArray() || !std::holds_alternative<std::string>(field.data)) {
+            throw std::runtime_error(name + " arguments must be a list and a field name");
+        }
+        const auto &path = std::get<std::string>(field.data);
+        if (&list == &scratch) {
+            // A list computed for the call is moved into the index rather than copied
+            return group ? groupBy(std::move(scratch.asArray()), path) : indexBy(std::move(scratch.asArray()), path);
+        }
+        return group ? groupBy(list.asArray(), path) : indexBy(list.asArray(), path);
+    }
+    if (call.builtin == trx::ast::BuiltinFunction::Lookup) {
+        if (call.arguments.size() != 2) throw std::runtime_error("lookup function takes 2 arguments");
+        JsonValue scratch;
+        const JsonValue &index = evaluateInPlace(call.arguments[0], context, scratch);
+        if (!std::holds_alternative<JsonValue::Object>(index.data)) {
+            throw std::runtime_error("lookup first argument must be an index made by index_by or group_by");
+        }
+        const auto *found = lookup(index, evaluateExpression(call.arguments[1], context));
+        return found ? *found : JsonValue();
+    }
+    if (call.builtin == trx::ast::BuiltinFunction::Sum || call.builtin == trx::ast::BuiltinFunction::Min ||
+        call.builtin == trx::ast::BuiltinFunction::Max || call.builtin == trx::ast::BuiltinFunction::Avg) {
+        const std::string name = call.functionName;
+        if (call.arguments.empty() || call.arguments.size() > 2) throw std::runtime_error(name + " function takes 1 or 2 arguments");
+        JsonValue scratch;
+        const JsonValue &list = evaluateInPlace(call.arguments[0], context, scratch);
+        const JsonValue field = call.arguments.size() == 2 ? evaluateExpression(call.arguments[1], context) : JsonValue(std::string{});
+        if (!list.isArray() || !std::holds_alternative<std::string>(field.data)) {
+            throw std::runtime_error(name + " arguments must be a list and a field name");
+        }
+        const auto summary = summarizeField(list.asArray(), std::get<std::string>(field.data));
+        if (call.builtin == trx::ast::BuiltinFunction::Sum) {
+            return JsonValue(summary.sum);
+        }
+        // Like SQL, the other aggregates of no numbers are null
+        if (summary.count == 0) {
+            return JsonValue();
+        }
+        if (call.builtin == trx::ast::BuiltinFunction::Avg) {
+            return JsonValue(summary.sum / static_cast<double>(summary.count));
+        }
+        return JsonValue(call.builtin == trx::ast::BuiltinFunction::Min ? summary.min : summary.max);
+    }
+    if (call.builtin == trx::ast::BuiltinFunction::CountIf) {
+        if (call.arguments.size() != 3) throw std::runtime_error("count_if function takes 3 arguments");
+        JsonValue scratch;
+        const JsonValue &list = evaluateInPlace(call.arguments[0], context, scratch);
+        const JsonValue field = evaluateExpression(call.arguments[1], context);
+        if (!list.isArray() || !std::holds_alternative<std::string>(field.data)) {
+            throw std::runtime_error("count_if arguments must be a list, a field name and a value");
+        }
+        const JsonValue value = evaluateExpression(call.arguments[2], context);
+        return JsonValue(static_cast<double>(countMatching(list.asArray(), std::get<std::string>(field.data), value)));
+    }
+    if (call.builtin == trx::ast::BuiltinFunction::Substr) {
         if (call.arguments.size() != 3) throw std::runtime_error("substr function takes 3 arguments");
         JsonValue str = evaluateExpression(call.arguments[0], context);
         JsonValue start = evaluateExpression(call.arguments[1], context);
@@ -260,180 +674,80 @@ JsonValue evaluateFunctionCall(const trx::ast::FunctionCallExpression &call, Exe
         if (pos >= s.size()) return JsonValue("");
         return JsonValue(s.substr(pos, length));
     }
-    if (call.functionName == "debug") {
+    if (call.builtin == trx::ast::BuiltinFunction::Debug) {
         if (call.arguments.size() != 1) throw std::runtime_error("debug function takes 1 argument");
-        JsonValue arg = evaluateExpression(call.arguments[0], context);
-        // std::cout << "DEBUG: " << arg << std::endl;
+        logBuiltin(LogLevel::Debug, evaluateExpression(call.arguments[0], context));
         return JsonValue(nullptr); // Logging functions return null
     }
-    if (call.functionName == "info") {
+    if (call.builtin == trx::ast::BuiltinFunction::Info) {
         if (call.arguments.size() != 1) throw std::runtime_error("info function takes 1 argument");
-        JsonValue arg = evaluateExpression(call.arguments[0], context);
-        // std::cout << "INFO: " << arg << std::endl;
+        logBuiltin(LogLevel::Info, evaluateExpression(call.arguments[0], context));
         return JsonValue(nullptr); // Logging functions return null
     }
-    if (call.functionName == "error") {
+    if (call.builtin == trx::ast::BuiltinFunction::Error) {
         if (call.arguments.size() != 1) throw std::runtime_error("error function takes 1 argument");
-        JsonValue arg = evaluateExpression(call.arguments[0], context);
-        // std::cerr << "ERROR: " << arg << std::endl;
+        logBuiltin(LogLevel::Error, evaluateExpression(call.arguments[0], context));
         return JsonValue(nullptr); // Logging functions return null
     }
-    if (call.functionName == "trace") {
+    if (call.builtin == trx::ast::BuiltinFunction::Trace) {
         if (call.arguments.size() != 1) throw std::runtime_error("trace function takes 1 argument");
-        JsonValue arg = evaluateExpression(call.arguments[0], context);
-        // std::cout << "TRACE: " << arg << std::endl;
+        logBuiltin(LogLevel::Debug, evaluateExpression(call.arguments[0], context));
         return JsonValue(nullptr); // Logging functions return null
     }
-    if (call.functionName == "http") {
+    if (call.builtin == trx::ast::BuiltinFunction::Http) {
         if (call.arguments.size() != 1) throw std::runtime_error("http function takes 1 argument");
         JsonValue config = evaluateExpression(call.arguments[0], context);
-        if (!config.isObject()) throw std::runtime_error("http argument must be an object");
-
-        // Extract configuration
-        const auto& configObj = config.asObject();
-        
-        // Required: method and url
-        if (configObj.find("method") == configObj.end()) throw std::runtime_error("http config must include 'method'");
-        if (configObj.find("url") == configObj.end()) throw std::runtime_error("http config must include 'url'");
-        
-        std::string method = configObj.at("method").asString();
-        std::string url = configObj.at("url").asString();
-        
-        // Optional: headers, body, timeout
-        std::map<std::string, std::string> headers;
-        std::string requestBody;
-        long timeout = 30L; // default 30 seconds
-        
-        if (configObj.find("headers") != configObj.end() && configObj.at("headers").isObject()) {
-            const auto& headersObj = configObj.at("headers").asObject();
-            for (const auto& [key, value] : headersObj) {
-                headers[key] = value.asString();
-            }
+        auto call = httpCallFrom(config);
+        Profiler::Scope frame(context.interpreter.profiler(), "[http]");
+        Span span(context.interpreter.tracer(), context.interpreter.traceContext(), call.method, SpanKind::Client);
+        span.setAttribute("http.request.method", call.method);
+        span.setAttribute("url.full", call.url);
+        propagateTrace(call, context);
+        applyDeadline(call, context);
+        try {
+            auto reply = HttpClient::perform(call);
+            span.setAttribute("http.response.status_code", static_cast<std::int64_t>(reply.status));
+            if (reply.status >= 400) {
+                span.setError("HTTP " + std::to_string(reply.status));
+            }
+            return httpResponseValue(std::move(reply));
+        } catch (const std::exception &e) {
+            span.setError(e.what());
+            throw;
         }
-        
-        if (configObj.find("body") != configObj.end()) {
-            requestBody = jsonValueToString(configObj.at("body"));
+    }
+    if (call.builtin == trx::ast::BuiltinFunction::HttpAll) {
+        if (call.arguments.size() != 1) throw std::runtime_error("http_all function takes 1 argument");
+        JsonValue configs = evaluateExpression(call.arguments[0], context);
+        if (!configs.isArray()) throw std::runtime_error("http_all argument must be a list");
+        std::vector<HttpCall> calls;
+        calls.reserve(configs.asArray().size());
+        for (const auto &config : configs.asArray()) {
+            calls.push_back(httpCallFrom(config));
         }
-        
-        if (configObj.find("timeout") != configObj.end()) {
-            timeout = static_cast<long>(configObj.at("timeout").asNumber());
+        JsonValue::Array responses;
+        responses.reserve(calls.size());
+        Profiler::Scope frame(context.interpreter.profiler(), "[http]");
+        // The calls run together, so they share one span
+        Span span(context.interpreter.tracer(), context.interpreter.traceContext(), "http_all", SpanKind::Client);
+        span.setAttribute("trx.http.calls", static_cast<std::int64_t>(calls.size()));
+        for (auto &call : calls) {
+            propagateTrace(call, context);
+            applyDeadline(call, context);
         }
-
-        // Initialize curl
-        CURL* curl = curl_easy_init();
-        if (!curl) throw std::runtime_error("Failed to initialize HTTP client");
-
-        std::string responseBody;
-        std::string responseHeaders;
-        long responseCode = 0;
-        char errorBuffer[CURL_ERROR_SIZE];
-        errorBuffer[0] = 0;
-
-        try {
-            // Set URL
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            
-            // Set method
-            if (method == "GET") {
-                curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-            } else if (method == "POST") {
-                curl_easy_setopt(curl, CURLOPT_POST, 1L);
-                if (!requestBody.empty()) {
-                    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, requestBody.c_str());
-                }
-            } else if (method == "PUT") {
-                curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-                if (!requestBody.empty()) {
-                    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, requestBody.c_str());
-                }
-            } else if (method == "DELETE") {
-                curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-            } else if (method == "PATCH") {
-                curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH");
-                if (!requestBody.empty()) {
-                    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, requestBody.c_str());
-                }
-            } else if (method == "HEAD") {
-                curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
-            } else if (method == "OPTIONS") {
-                curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "OPTIONS");
-            } else {
-                curl_easy_cleanup(curl);
-                throw std::runtime_error("Unsupported HTTP method: " + method);
-            }
-
-            // Set headers
-            struct curl_slist* headerList = nullptr;
-            for (const auto& [key, value] : headers) {
-                std::string header = key + ": " + value;
-                headerList = curl_slist_append(headerList, header.c_str());
-            }
-            if (headerList) {
-                curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
-            }
-
-            // Set callbacks
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
-            
-            // Set timeout
-            curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout);
-            
-            // Set error buffer
-            curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errorBuffer);
-            
-            // Don't verify SSL certificates for now (in production, this should be configurable)
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-
-            // Perform request
-            CURLcode res = curl_easy_perform(curl);
-            
-            if (res != CURLE_OK) {
-                std::string errorMsg = errorBuffer[0] ? errorBuffer : curl_easy_strerror(res);
-                curl_easy_cleanup(curl);
-                if (headerList) curl_slist_free_all(headerList);
-                throw std::runtime_error("HTTP request failed: " + errorMsg);
-            }
-
-            // Get response code
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
-
-            // Cleanup
-            curl_easy_cleanup(curl);
-            if (headerList) curl_slist_free_all(headerList);
-
-            // Parse response body as JSON if possible
-            JsonValue responseBodyJson;
-            if (!responseBody.empty() && (responseBody[0] == '{' || responseBody[0] == '[')) {
-                try {
-                    // For now, store as string - TRX can parse JSON at runtime if needed
-                    responseBodyJson = JsonValue(responseBody);
-                } catch (...) {
-                    // If anything fails, treat as string
-                    responseBodyJson = JsonValue(responseBody);
-                }
-            } else {
-                // Not JSON, treat as string
-                responseBodyJson = JsonValue(responseBody);
-            }
-
-            // Build response
-            JsonValue::Object response;
-            response["status"] = JsonValue(static_cast<double>(responseCode));
-            response["headers"] = JsonValue(JsonValue::Object{{"content-type", JsonValue("application/json")}});
-            response["body"] = responseBodyJson;
-            
-            return JsonValue(response);
-            
-        } catch (...) {
-            curl_easy_cleanup(curl);
-            throw;
+        std::int64_t failures = 0;
+        for (auto &reply : HttpClient::performAll(calls)) {
+            failures += !reply.error.empty() || reply.status >= 400;
+            responses.push_back(httpResponseValue(std::move(reply)));
         }
+        if (failures > 0) {
+            span.setAttribute("trx.http.failures", failures);
+            span.setError(std::to_string(failures) + " of " + std::to_string(calls.size()) + " calls failed");
+        }
+        return JsonValue(std::move(responses));
     }
     // For user-defined routines
-    const auto *proc = context.interpreter.getRoutine(call.functionName);
-    if (proc) {
+    if (const auto *proc = call.routine) {
         // if (!proc->output) {
         //     throw std::runtime_error("Routine calls cannot be used in expressions");
         // }
@@ -441,28 +755,37 @@ JsonValue evaluateFunctionCall(const trx::ast::FunctionCallExpression &call, Exe
         if (hasInput) {
             if (call.arguments.size() != 1) throw std::runtime_error("Function call expects 1 argument");
             JsonValue arg = evaluateExpression(call.arguments[0], context);
-            auto result = context.interpreter.execute(call.functionName, arg);
-            return result.value_or(JsonValue(nullptr));
+            return callRoutine(*proc, std::move(arg), context);
         } else {
             if (call.arguments.size() != 0) throw std::runtime_error("Function call expects no arguments");
-            auto result = context.interpreter.execute(call.functionName, JsonValue(nullptr));
-            return result.value_or(JsonValue(nullptr));
+            return callRoutine(*proc, JsonValue(nullptr), context);
         }
     }
     throw std::runtime_error("Function not supported: " + call.functionName);
 }
 
 JsonValue evaluateMethodCall(const trx::ast::MethodCallExpression &call, ExecutionContext &context) {
-    JsonValue object = evaluateExpression(call.object, context);
     std::vector<JsonValue> args;
     for (const auto &arg : call.arguments) {
         args.push_back(evaluateExpression(arg, context));
     }
-    
+
+    // Modifying methods work on the variable itself, everything else reads the receiver in place
+    const auto *variable = call.object ? std::get_if<trx::ast::VariableExpression>(&call.object->node) : nullptr;
+    if (call.methodName == "append" && variable) {
+        JsonValue &list = resolveVariableTarget(*variable, context);
+        if (list.isArray()) {
+            if (args.size() != 1) throw std::runtime_error("append method takes 1 argument");
+            list.asArray().push_back(std::move(args[0]));
+            return JsonValue(nullptr); // Methods that modify return null
+        }
+    }
+    JsonValue scratch;
+    const JsonValue &object = evaluateInPlace(call.object, context, scratch);
+
     if (object.isArray()) {
         if (call.methodName == "append") {
             if (args.size() != 1) throw std::runtime_error("append method takes 1 argument");
-            object.asArray().push_back(args[0]);
             return JsonValue(nullptr); // Methods that modify return null
         }
         if (call.methodName == "length") {
@@ -609,7 +932,38 @@ JsonValue evaluateExpression(const trx::ast::ExpressionPtr &expression, Executio
     return std::visit(ExpressionEvaluator{context}, expression->node);
 }
 
+// Reads a variable where it is stored instead of copying it; any other expression is
+// evaluated into scratch
+const JsonValue &evaluateInPlace(const trx::ast::ExpressionPtr &expression, ExecutionContext &context, JsonValue &scratch) {
+    if (expression) {
+        if (const auto *variable = std::get_if<trx::ast::VariableExpression>(&expression->node)) {
+            return lookupVariable(*variable, context);
+        }
+    }
+    scratch = evaluateExpression(expression, context);
+    return scratch;
+}
+
+// The local a RETURN names by itself, which can be moved out since its frame is about to go
+JsonValue *returnedLocal(const trx::ast::ExpressionPtr &expression, ExecutionContext &context) {
+    const auto *variable = expression ? std::get_if<trx::ast::VariableExpression>(&expression->node) : nullptr;
+    if (!variable || variable->path.size() != 1 || variable->path.front().subscript) {
+        return nullptr;
+    }
+    const auto &name = variable->path.front().identifier;
+    if (name == "input" || name == "output") {
+        return nullptr; // left to resolveVariableValue to reject
+    }
+    return findLocal(context, variable->slot, name);
+}
+
 JsonValue resolveVariableValue(const trx::ast::VariableExpression &variable, ExecutionContext &context) {
+    return lookupVariable(variable, context);
+}
+
+// The stored value a variable path names. The reference is only good until the next write
+// to that variable or anything containing it
+const JsonValue &lookupVariable(const trx::ast::VariableExpression &variable, ExecutionContext &context) {
     if (variable.path.empty()) {
         throw std::runtime_error("Variable expression is empty");
     }
@@ -620,19 +974,15 @@ JsonValue resolveVariableValue(const trx::ast::VariableExpression &variable, Exe
         throw std::runtime_error("Implicit '" + rootVar + "' variable is not allowed. Declare variables explicitly.");
     }
 
-    const JsonValue *current = nullptr;
-    std::string rootVarLower = variable.path.front().identifier;
-    std::transform(rootVarLower.begin(), rootVarLower.end(), rootVarLower.begin(), [](unsigned char c) { return std::tolower(c); });
-    auto rootIt = context.variables.find(rootVarLower);
-    if (rootIt == context.variables.end()) {
-        // Check global variables
-        auto globalIt = context.interpreter.globalVariables().find(rootVarLower);
-        if (globalIt != context.interpreter.globalVariables().end()) {
-            current = &globalIt->second;
-        }
-    } else {
-        current = &rootIt->second;
+    const JsonValue *current = findLocal(context, variable.slot, rootVar);
+    if (!current) {
+        current = findGlobal(context, variable.path.front());
     }
+    if (!current) {
+        throw std::runtime_error("Unknown variable: " + rootVar);
+    }
+
+    std::string scratch;
 
     for (std::size_t i = 0; i < variable.path.size(); ++i) {
         const auto &segment = variable.path[i];
@@ -655,14 +1005,11 @@ JsonValue resolveVariableValue(const trx::ast::VariableExpression &variable, Exe
                 if (!current->isObject()) {
                     throw std::runtime_error("Attempted to access field on non-object value");
                 }
-                const auto &object = current->asObject();
-                std::string fieldLower = segment.identifier;
-                std::transform(fieldLower.begin(), fieldLower.end(), fieldLower.begin(), [](unsigned char c) { return std::tolower(c); });
-                const auto childIt = object.find(fieldLower);
-                if (childIt == object.end()) {
+                const JsonValue *child = current->findField(segmentKey(segment, scratch), segment.field);
+                if (!child) {
                     throw std::runtime_error("Unknown field: " + segment.identifier);
                 }
-                current = &childIt->second;
+                current = child;
             }
         }
     }
@@ -681,23 +1028,15 @@ JsonValue &resolveVariableTarget(const trx::ast::VariableExpression &variable, E
         throw std::runtime_error("Implicit '" + rootVar + "' variable is not allowed. Declare variables explicitly.");
     }
 
-    JsonValue *current = nullptr;
-    JsonValue *root = nullptr;
-    std::string rootVarLower = variable.path.front().identifier;
-    std::transform(rootVarLower.begin(), rootVarLower.end(), rootVarLower.begin(), [](unsigned char c) { return std::tolower(c); });
-    auto localIt = context.variables.find(rootVarLower);
-    if (localIt != context.variables.end()) {
-        root = &localIt->second;
-    } else {
-        auto globalIt = context.interpreter.globalVariables().find(rootVarLower);
-        if (globalIt != context.interpreter.globalVariables().end()) {
-            root = &globalIt->second;
-        } else {
-            // Create in local variables
-            root = &context.variables[rootVarLower];
-        }
+    JsonValue *current = findLocal(context, variable.slot, rootVar);
+    if (!current) {
+        current = findGlobal(context, variable.path.front());
+    }
+    if (!current) {
+        current = &bindLocal(context, variable.slot, rootVar); // Create in local variables
     }
-    current = root;
+
+    std::string scratch;
 
     for (std::size_t i = 0; i < variable.path.size(); ++i) {
         const auto &segment = variable.path[i];
@@ -720,10 +1059,7 @@ JsonValue &resolveVariableTarget(const trx::ast::VariableExpression &variable, E
                 if (!current->isObject()) {
                     *current = JsonValue::object();
                 }
-                auto &object = current->asObject();
-                std::string fieldLower = segment.identifier;
-                std::transform(fieldLower.begin(), fieldLower.end(), fieldLower.begin(), [](unsigned char c) { return std::tolower(c); });
-                current = &object[fieldLower];
+                current = &current->field(segmentKey(segment, scratch), segment.field);
             }
         }
     }
@@ -732,14 +1068,9 @@ JsonValue &resolveVariableTarget(const trx::ast::VariableExpression &variable, E
 }
 
 void executeAssignment(const trx::ast::AssignmentStatement &assignment, ExecutionContext &context) {
-    debugPrint("ASSIGNMENT: evaluating value for assignment");
     JsonValue value = evaluateExpression(assignment.value, context);
-    debugPrint("ASSIGNMENT: value evaluated to " + jsonValueToString(value));
-    debugPrint("ASSIGNMENT: resolving target");
-    JsonValue &target = resolveVariableTarget(assignment.target, context);
-    debugPrint("ASSIGNMENT: target resolved, assigning");
-    target = std::move(value);
-    debugPrint("ASSIGNMENT: assignment complete");
+    logDebug("ASSIGNMENT", {{"value", value}});
+    resolveVariableTarget(assignment.target, context) = std::move(value);
 }
 
 void executeVariableDeclaration(const trx::ast::VariableDeclarationStatement &varDecl, ExecutionContext &context) {
@@ -766,13 +1097,9 @@ void executeVariableDeclaration(const trx::ast::VariableDeclarationStatement &va
         } else if (varDecl.typeName == "JSON") {
             // Initialize JSON variables as null
             initialValue = JsonValue(nullptr);
-        } else if (auto record = context.interpreter.getRecord(varDecl.typeName)) {
+        } else if (auto shape = context.interpreter.recordShape(varDecl.typeName)) {
             // Initialize record variables with fields set to null
-            JsonValue::Object obj;
-            for (const auto& field : record->fields) {
-                obj[field.name.name] = JsonValue(nullptr);
-            }
-            initialValue = JsonValue(obj);
+            initialValue = JsonValue::record(std::move(shape));
         }
     } else if (varDecl.tableName.has_value()) {
         // Initialize table-based variables from database schema
@@ -786,49 +1113,65 @@ void executeVariableDeclaration(const trx::ast::VariableDeclarationStatement &va
     if (context.isGlobal) {
         context.interpreter.globalVariables()[varDecl.name.name] = initialValue;
     } else {
-        context.variables[varDecl.name.name] = initialValue;
+        bindLocal(context, varDecl.slot, varDecl.name.name) = std::move(initialValue);
     }
 }
 
-void executeIf(const trx::ast::IfStatement &ifStmt, ExecutionContext &context) {
+Completion executeIf(const trx::ast::IfStatement &ifStmt, ExecutionContext &context) {
     JsonValue cond = evaluateExpression(ifStmt.condition, context);
     if (std::holds_alternative<bool>(cond.data) && std::get<bool>(cond.data)) {
-        executeStatements(ifStmt.thenBranch, context);
-    } else {
-        executeStatements(ifStmt.elseBranch, context);
+        return executeStatements(ifStmt.thenBranch, context);
     }
+    return executeStatements(ifStmt.elseBranch, context);
 }
 
-void executeThrow(const trx::ast::ThrowStatement &throwStmt, ExecutionContext &context) {
+Completion executeThrow(const trx::ast::ThrowStatement &throwStmt, ExecutionContext &context) {
     JsonValue value = evaluateExpression(throwStmt.value, context);
-    throw TrxThrowException(value, std::nullopt);
+    context.thrown.emplace(value, std::nullopt);
+    return Completion::Thrown;
+}
+
+// Value bound to a CATCH variable
+void bindException(const trx::ast::VariableExpression &exceptionVar, const TrxException &e, ExecutionContext &context) {
+    JsonValue exceptionValue = JsonValue::object();
+    exceptionValue.asObject()["type"] = e.getErrorType();
+    exceptionValue.asObject()["message"] = std::string(e.what());
+    if (e.getSourceLocation()) {
+        exceptionValue.asObject()["location"] = *e.getSourceLocation();
+    }
+
+    // If it's a TrxThrowException, include the thrown value
+    if (const TrxThrowException* throwEx = dynamic_cast<const TrxThrowException*>(&e)) {
+        exceptionValue.asObject()["value"] = throwEx->getThrownValue();
+    }
+
+    bindLocal(context, exceptionVar.slot, exceptionVar.path.front().identifier) = std::move(exceptionValue);
+}
+
+Completion executeCatch(const trx::ast::TryCatchStatement &tryCatchStmt, const TrxException &e, ExecutionContext &context) {
+    // Bind the exception to the catch variable if specified
+    if (tryCatchStmt.exceptionVar) {
+        bindException(*tryCatchStmt.exceptionVar, e, context);
+    }
+    return executeStatements(tryCatchStmt.catchBlock, context);
 }
 
-void executeTryCatch(const trx::ast::TryCatchStatement &tryCatchStmt, ExecutionContext &context) {
+Completion executeTryCatch(const trx::ast::TryCatchStatement &tryCatchStmt, ExecutionContext &context) {
+    Completion completion;
     try {
-        executeStatements(tryCatchStmt.tryBlock, context);
+        completion = executeStatements(tryCatchStmt.tryBlock, context);
     } catch (const TrxException &e) {
-        // Bind the exception to the catch variable if specified
-        if (tryCatchStmt.exceptionVar) {
-            JsonValue exceptionValue = JsonValue::object();
-            exceptionValue.asObject()["type"] = e.getErrorType();
-            exceptionValue.asObject()["message"] = std::string(e.what());
-            if (e.getSourceLocation()) {
-                exceptionValue.asObject()["location"] = *e.getSourceLocation();
-            }
-            
-            // If it's a TrxThrowException, include the thrown value
-            if (const TrxThrowException* throwEx = dynamic_cast<const TrxThrowException*>(&e)) {
-                exceptionValue.asObject()["value"] = throwEx->getThrownValue();
-            }
-            
-            context.variables[tryCatchStmt.exceptionVar->path.back().identifier] = exceptionValue;
-        }
-        executeStatements(tryCatchStmt.catchBlock, context);
+        return executeCatch(tryCatchStmt, e, context);
+    }
+    if (completion != Completion::Thrown) {
+        return completion;
     }
+    const TrxThrowException thrown = std::move(*context.thrown);
+    context.thrown.reset();
+    return executeCatch(tryCatchStmt, thrown, context);
 }
 
-void executeWhile(const trx::ast::WhileStatement &whileStmt, ExecutionContext &context) {
+int whileIterationLimit() {
     static const int MAX_ITERATIONS = []() {
         const char* env = std::getenv("TRX_WHILE_MAX_ITERATIONS");
         if (env) {
@@ -841,7 +1184,11 @@ void executeWhile(const trx::ast::WhileStatement &whileStmt, ExecutionContext &c
         }
         return 10000;
     }();
-    
+    return MAX_ITERATIONS;
+}
+
+Completion executeWhile(const trx::ast::WhileStatement &whileStmt, ExecutionContext &context) {
+    const int MAX_ITERATIONS = whileIterationLimit();
     int iterations = 0;
     while (true) {
         if (++iterations > MAX_ITERATIONS) {
@@ -850,79 +1197,345 @@ void executeWhile(const trx::ast::WhileStatement &whileStmt, ExecutionContext &c
         
         JsonValue cond = evaluateExpression(whileStmt.condition, context);
         if (!std::holds_alternative<bool>(cond.data) || !std::get<bool>(cond.data)) break;
-        executeStatements(whileStmt.body, context);
+        if (const auto completion = executeStatements(whileStmt.body, context); completion != Completion::Normal) {
+            return completion;
+        }
     }
+    return Completion::Normal;
 }
 
-void executeFor(const trx::ast::ForStatement &forStmt, ExecutionContext &context) {
-    JsonValue collection = evaluateExpression(forStmt.collection, context);
-    if (!std::holds_alternative<std::vector<JsonValue>>(collection.data)) {
-        throw std::runtime_error("FOR loop collection must be an array");
+// FOR item IN items { EXEC SQL INSERT ... :item.x; } sends the whole list through one
+// executeBatch call per chunk instead of one executeSql per item. The body has no other
+// statements, so the loop variable is the only thing that changes between items.
+bool executeForBatched(const trx::ast::ForStatement &forStmt, const JsonValue::Array &items, ExecutionContext &context) {
+    if (forStmt.body.size() != 1 || items.size() < 2) {
+        return false;
     }
-    const auto& arr = std::get<std::vector<JsonValue>>(collection.data);
-    for (const auto& item : arr) {
-        resolveVariableTarget(forStmt.loopVar, context) = item;
-        executeStatements(forStmt.body, context);
+    const auto *sqlStmt = std::get_if<trx::ast::SqlStatement>(&forStmt.body.front().node);
+    if (!sqlStmt || sqlStmt->kind != trx::ast::SqlStatementKind::ExecImmediate || !sqlStmt->compiled.batchable) {
+        return false;
     }
-}
 
-void executeBlock(const trx::ast::BlockStatement &block, ExecutionContext &context) {
-    executeStatements(block.statements, context);
-}
+    constexpr std::size_t chunkSize = 1000;
+    std::vector<std::vector<SqlParameter>> paramSets;
+    paramSets.reserve(std::min(chunkSize, items.size()));
+    for (std::size_t start = 0; start < items.size(); start += chunkSize) {
+        const auto end = std::min(start + chunkSize, items.size());
+        paramSets.clear();
+        for (std::size_t i = start; i < end; ++i) {
+            resolveVariableTarget(forStmt.loopVar, context) = items[i];
+            paramSets.push_back(convertHostVarsToParams(resolveHostVariablesFromAst(sqlStmt->hostVariables, context)));
+        }
 
-void executeSwitch(const trx::ast::SwitchStatement &switchStmt, ExecutionContext &context) {
-    JsonValue selector = evaluateExpression(switchStmt.selector, context);
-    for (const auto &case_ : switchStmt.cases) {
-        JsonValue match = evaluateExpression(case_.match, context);
-        if (selector.data == match.data) {
-            executeStatements(case_.body, context);
-            return;
+        // SQLCODE ends up as it would after the last item's own execution
+        try {
+            Profiler::Scope frame(context.interpreter.profiler(), "[sql]");
+            Span span(context.interpreter.tracer(), context.interpreter.traceContext(), "EXEC SQL batch", SpanKind::Client);
+            span.setAttribute("db.statement", sqlStmt->compiled.text);
+            span.setAttribute("trx.batch_size", static_cast<std::int64_t>(paramSets.size()));
+            if (!sqlStmt->compiled.readOnly) {
+                context.interpreter.noteWrite();
+            }
+            const auto failed = sqlDriver(context).executeBatch(sqlStmt->compiled.text, paramSets);
+            span.setAttribute("trx.batch_failures", static_cast<std::int64_t>(failed.size()));
+            context.interpreter.setSqlCode(!failed.empty() && failed.back() == paramSets.size() - 1 ? -1.0 : 0.0);
+            logDebug("SQL EXEC BATCH", {{"sql", sqlStmt->sql}, {"rows", paramSets.size()}, {"failed", failed.size()}});
+        } catch (const std::exception &) {
+            context.interpreter.setSqlCode(-1.0); // Error
         }
     }
-    if (switchStmt.defaultBranch) {
-        executeStatements(*switchStmt.defaultBranch, context);
-    }
+    return true;
 }
 
-void executeSort(const trx::ast::SortStatement &sortStmt, ExecutionContext &context) {
-    JsonValue &arrayValue = resolveVariableTarget(sortStmt.array, context);
-    if (!arrayValue.isArray()) {
-        throw std::runtime_error("Sort target must be an array");
-    }
-    auto &array = arrayValue.asArray();
-    if (sortStmt.keys.empty()) return; // No sort
-    // For simplicity, sort by first key ascending
-    const auto key = sortStmt.keys.front();
-    std::sort(array.begin(), array.end(), [key](const JsonValue &a, const JsonValue &b) {
-        if (!a.isObject() || !b.isObject()) return false;
-        const auto &objA = a.asObject();
-        const auto &objB = b.asObject();
-        auto itA = objA.find(key.fieldName);
-        auto itB = objB.find(key.fieldName);
-        if (itA == objA.end() || itB == objB.end()) return false;
-        // Compare based on type
-        if (std::holds_alternative<double>(itA->second.data) && std::holds_alternative<double>(itB->second.data)) {
-            double valA = std::get<double>(itA->second.data);
-            double valB = std::get<double>(itB->second.data);
-            return key.order > 0 ? valA < valB : valA > valB;
-        }
-        if (std::holds_alternative<std::string>(itA->second.data) && std::holds_alternative<std::string>(itB->second.data)) {
-            const std::string &valA = std::get<std::string>(itA->second.data);
-            const std::string &valB = std::get<std::string>(itB->second.data);
-            return key.order > 0 ? valA < valB : valA > valB;
+// Iterations of one PARALLEL FOR. Workers, the routine's own thread among them, take items
+// in order until none are left or one has failed. A worker that starts after the loop has
+// ended leaves without touching it, so the routine only waits for those still running.
+class ParallelLoop {
+public:
+    ParallelLoop(const trx::ast::ForStatement &statement, const JsonValue::Array &items, const ExecutionContext &outer)
+        : statement_{statement}, items_{items}, outer_{outer}, results_(items.size()) {
+        doneFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (doneFd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to start a PARALLEL FOR loop");
         }
-        return false;
-    });
-}
+    }
 
-void executeTrace(const trx::ast::TraceStatement &trace, ExecutionContext &context) {
-    JsonValue val = evaluateExpression(trace.value, context);
-    debugPrint("TRACE: " + jsonValueToString(val));
-}
+    ~ParallelLoop() { ::close(doneFd_); }
 
-void executeExpression(const trx::ast::ExpressionStatement &exprStmt, ExecutionContext &context) {
-    // Evaluate the expression and discard the result
-    evaluateExpression(exprStmt.expression, context);
+    ParallelLoop(const ParallelLoop &) = delete;
+    ParallelLoop &operator=(const ParallelLoop &) = delete;
+
+    // One per worker; none when the driver has no connections to spare or the loop must stay
+    // in the routine's transaction, and the routine's own interpreter runs every iteration
+    std::vector<std::unique_ptr<Interpreter>> interpreters;
+
+    void work(Interpreter &interpreter) {
+        {
+            std::lock_guard lock(mutex_);
+            if (closed_) {
+                return;
+            }
+            ++active_;
+        }
+        for (;;) {
+            std::size_t index = 0;
+            {
+                std::lock_guard lock(mutex_);
+                if (failedIndex_ != npos || next_ >= items_.size()) {
+                    break;
+                }
+                index = next_++;
+            }
+            try {
+                runIteration(interpreter, index);
+            } catch (...) {
+                std::lock_guard lock(mutex_);
+                if (index < failedIndex_) {
+                    failedIndex_ = index;
+                    error_ = std::current_exception();
+                }
+            }
+        }
+        std::lock_guard lock(mutex_);
+        if (--active_ == 0 && closed_) {
+            const std::uint64_t one = 1;
+            [[maybe_unused]] const auto written = ::write(doneFd_, &one, sizeof(one));
+        }
+    }
+
+    // Called once the routine's own worker is done; waits without holding its thread
+    void finish() {
+        std::unique_lock lock(mutex_);
+        closed_ = true;
+        while (active_ > 0) {
+            lock.unlock();
+            waitForIo(doneFd_, POLLIN);
+            std::uint64_t wakes = 0;
+            [[maybe_unused]] const auto drained = ::read(doneFd_, &wakes, sizeof(wakes));
+            lock.lock();
+        }
+    }
+
+    // The failure of the earliest item that failed, if any
+    std::exception_ptr error() const { return error_; }
+
+    // Values the loop variable ended with, in item order
+    JsonValue::Array takeResults() {
+        JsonValue::Array list;
+        list.reserve(results_.size());
+        for (auto &value : results_) {
+            list.push_back(std::move(value));
+        }
+        return list;
+    }
+
+private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Each item starts from the routine's locals as they were when the loop began
+    void runIteration(Interpreter &interpreter, std::size_t index) {
+        ExecutionContext context{interpreter, {}, false, std::nullopt, false, false, std::nullopt};
+        context.variables = outer_.variables;
+        context.isGlobal = outer_.isGlobal;
+        context.isFunction = outer_.isFunction;
+        context.outputType = outer_.outputType;
+        context.procedure = outer_.procedure;
+        context.frame = outer_.frame;
+        if (&interpreter == &outer_.interpreter) {
+            context.savepoint = outer_.savepoint; // on the routine's own connection, inside its transaction
+        }
+        resolveVariableTarget(statement_.loopVar, context) = items_[index];
+        switch (executeStatements(statement_.body, context)) {
+            case Completion::Normal:
+                results_[index] = std::move(resolveVariableTarget(statement_.loopVar, context));
+                break;
+            case Completion::Returned:
+                throw std::runtime_error("RETURN is not allowed inside PARALLEL FOR");
+            case Completion::Thrown:
+                throw std::move(*context.thrown);
+        }
+    }
+
+    const trx::ast::ForStatement &statement_;
+    const JsonValue::Array &items_;
+    const ExecutionContext &outer_;
+    std::vector<JsonValue> results_; // one per item, written by whichever worker ran it
+
+    std::mutex mutex_;
+    std::size_t next_{0};
+    std::size_t active_{0};
+    bool closed_{false};
+    std::size_t failedIndex_{npos};
+    std::exception_ptr error_;
+    int doneFd_{-1};
+};
+
+constexpr std::size_t defaultParallelism = 8;
+
+// PARALLEL FOR item IN items [MAX n] { ... } runs up to n iterations at once, each in a
+// context and on database connections of its own. When the collection is a variable, it
+// is replaced by the values the loop variable ended with, in the original order.
+// Each running loop borrows up to n connections (8 without MAX) on top of the one the
+// request holds, so a pool sized to the worker count can run short under load; the loop
+// then uses fewer. Those connections are outside the routine's transaction: a body that
+// may write, or a loop after the transaction has written, runs its iterations one after
+// another on the routine's own connection instead.
+Completion executeParallelFor(const trx::ast::ForStatement &forStmt, ExecutionContext &context) {
+    const auto *source = forStmt.collection ? std::get_if<trx::ast::VariableExpression>(&forStmt.collection->node) : nullptr;
+    JsonValue evaluated;
+    if (!source) {
+        evaluated = evaluateExpression(forStmt.collection, context);
+    }
+    const JsonValue &collection = source ? lookupVariable(*source, context) : evaluated;
+    if (!collection.isArray()) {
+        throw std::runtime_error("FOR loop collection must be an array");
+    }
+    const auto &items = collection.asArray();
+    std::size_t width = std::min(defaultParallelism, items.size());
+    if (forStmt.maxParallel) {
+        const JsonValue limit = evaluateExpression(forStmt.maxParallel, context);
+        const auto *number = std::get_if<double>(&limit.data);
+        if (!number || !(*number >= 1)) {
+            throw std::runtime_error("PARALLEL FOR MAX must be a positive number");
+        }
+        width = static_cast<std::size_t>(std::min(*number, static_cast<double>(items.size())));
+    }
+    if (width == 0) {
+        return Completion::Normal;
+    }
+
+    // Statements this connection still has queued run before any iteration does
+    context.interpreter.syncSql();
+    auto loop = std::make_shared<ParallelLoop>(forStmt, items, context);
+    const bool isolated = !forStmt.readOnlyBody || context.interpreter.wroteInTransaction();
+    for (std::size_t i = 0; i < width && !isolated; ++i) {
+        auto sibling = context.interpreter.db().openSibling();
+        if (!sibling) {
+            break;
+        }
+        auto &worker = loop->interpreters.emplace_back(context.interpreter.fork(std::move(sibling)));
+        worker->setTracer(context.interpreter.tracer());
+        worker->traceContext() = context.interpreter.traceContext();
+        worker->setDeadline(context.interpreter.deadline());
+    }
+
+    if (loop->interpreters.empty()) {
+        loop->work(context.interpreter);
+    } else {
+        try {
+            for (std::size_t i = 1; i < loop->interpreters.size(); ++i) {
+                parallelPool().enqueueTask([loop, i] { loop->work(*loop->interpreters[i]); });
+            }
+        } catch (...) {
+            loop->finish();
+            throw;
+        }
+        loop->work(*loop->interpreters.front());
+    }
+    loop->finish();
+
+    if (const auto error = loop->error()) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const TrxThrowException &thrown) {
+            context.thrown.emplace(thrown);
+            return Completion::Thrown;
+        }
+    }
+    if (source) {
+        resolveVariableTarget(*source, context) = JsonValue(loop->takeResults());
+    }
+    return Completion::Normal;
+}
+
+Completion executeFor(const trx::ast::ForStatement &forStmt, ExecutionContext &context) {
+    if (forStmt.parallel) {
+        return executeParallelFor(forStmt, context);
+    }
+    if (const auto *source = forStmt.collection ? std::get_if<trx::ast::VariableExpression>(&forStmt.collection->node) : nullptr) {
+        // Items are copied straight out of the stored list. The body may reassign or grow it,
+        // so the list is looked up again for every item, and the loop still covers at most the
+        // items it had when the loop started
+        const JsonValue &initial = lookupVariable(*source, context);
+        if (!initial.isArray()) {
+            throw std::runtime_error("FOR loop collection must be an array");
+        }
+        if (executeForBatched(forStmt, initial.asArray(), context)) {
+            return Completion::Normal;
+        }
+        const auto count = initial.asArray().size();
+        for (std::size_t i = 0; i < count; ++i) {
+            JsonValue &target = resolveVariableTarget(forStmt.loopVar, context);
+            const JsonValue &collection = lookupVariable(*source, context);
+            if (!collection.isArray() || i >= collection.asArray().size()) {
+                break;
+            }
+            target = collection.asArray()[i];
+            if (const auto completion = executeStatements(forStmt.body, context); completion != Completion::Normal) {
+                return completion;
+            }
+        }
+        return Completion::Normal;
+    }
+    JsonValue collection = evaluateExpression(forStmt.collection, context);
+    if (!std::holds_alternative<JsonValue::Array>(collection.data)) {
+        throw std::runtime_error("FOR loop collection must be an array");
+    }
+    const auto& arr = std::get<JsonValue::Array>(collection.data);
+    if (executeForBatched(forStmt, arr, context)) {
+        return Completion::Normal;
+    }
+    for (const auto& item : arr) {
+        resolveVariableTarget(forStmt.loopVar, context) = item;
+        if (const auto completion = executeStatements(forStmt.body, context); completion != Completion::Normal) {
+            return completion;
+        }
+    }
+    return Completion::Normal;
+}
+
+Completion executeBlock(const trx::ast::BlockStatement &block, ExecutionContext &context) {
+    return executeStatements(block.statements, context);
+}
+
+Completion executeSwitch(const trx::ast::SwitchStatement &switchStmt, ExecutionContext &context) {
+    JsonValue selector = evaluateExpression(switchStmt.selector, context);
+    for (const auto &case_ : switchStmt.cases) {
+        JsonValue match = evaluateExpression(case_.match, context);
+        if (selector == match) {
+            return executeStatements(case_.body, context);
+        }
+    }
+    if (switchStmt.defaultBranch) {
+        return executeStatements(*switchStmt.defaultBranch, context);
+    }
+    return Completion::Normal;
+}
+
+void executeSort(const trx::ast::SortStatement &sortStmt, ExecutionContext &context) {
+    JsonValue &arrayValue = resolveVariableTarget(sortStmt.array, context);
+    if (!arrayValue.isArray()) {
+        throw std::runtime_error("Sort target must be an array");
+    }
+    sortByKeys(arrayValue.asArray(), sortStmt.keys);
+}
+
+void executeEmit(const trx::ast::EmitStatement &emitStmt, ExecutionContext &context) {
+    const auto &sink = context.interpreter.emitSink();
+    if (!sink) {
+        throw std::runtime_error("EMIT can only be used inside a routine");
+    }
+    sink(evaluateExpression(emitStmt.value, context));
+}
+
+void executeTrace(const trx::ast::TraceStatement &trace, ExecutionContext &context) {
+    JsonValue val = evaluateExpression(trace.value, context);
+    logDebug("TRACE", {{"value", val}});
+}
+
+void executeExpression(const trx::ast::ExpressionStatement &exprStmt, ExecutionContext &context) {
+    // Evaluate the expression and discard the result
+    evaluateExpression(exprStmt.expression, context);
 }
 
 void executeSystem(const trx::ast::SystemStatement &systemStmt, ExecutionContext &context) {
@@ -937,39 +1550,38 @@ void executeSystem(const trx::ast::SystemStatement &systemStmt, ExecutionContext
 }
 
 void executeBatch(const trx::ast::BatchStatement &batchStmt, ExecutionContext &context) {
-    // For now, just print that batch is called
-    std::string msg = "BATCH: " + batchStmt.name;
-    if (batchStmt.argument) {
-        JsonValue arg = resolveVariableValue(*batchStmt.argument, context);
-        msg += " with argument: " + jsonValueToString(arg);
+    auto *queue = context.interpreter.jobQueue();
+    if (!queue) {
+        throw std::runtime_error("BATCH " + batchStmt.name + ": no job queue is running");
+    }
+    const JsonValue argument = batchStmt.argument ? resolveVariableValue(*batchStmt.argument, context) : JsonValue();
+    // Queued on the caller's connection, so the job only exists once its transaction commits
+    context.interpreter.noteWrite();
+    auto id = queue->enqueue(sqlDriver(context), batchStmt.name, argument);
+    logDebug("BATCH", {{"name", batchStmt.name}, {"job", id}});
+    if (batchStmt.jobId) {
+        resolveVariableTarget(*batchStmt.jobId, context) = JsonValue(std::move(id));
     }
-    debugPrint(msg);
-    // In a real implementation, this would execute the batch process
 }
 
-struct ReturnException : std::exception {
-    JsonValue value;
-    ReturnException(JsonValue v) : value(std::move(v)) {}
-};
-
-void executeReturn(const trx::ast::ReturnStatement &returnStmt, ExecutionContext &context) {
+Completion executeReturn(const trx::ast::ReturnStatement &returnStmt, ExecutionContext &context) {
     if (context.isFunction) {
         // Functions must return a value
         if (!returnStmt.value) {
             throw std::runtime_error("Function must return a value");
         }
         // For functions, evaluate the return expression
-        JsonValue val = evaluateExpression(returnStmt.value, context);
-        throw ReturnException(val);
-    } else {
-        // Routines can have RETURN but without a value
-        if (returnStmt.value) {
-            throw std::runtime_error("Routines cannot return values. Use RETURN without a value.");
+        if (auto *local = returnedLocal(returnStmt.value, context)) {
+            context.returnValue = std::move(*local);
+        } else {
+            context.returnValue = evaluateExpression(returnStmt.value, context);
         }
-        // Just mark that we returned (for routines, this ends execution)
-        context.returned = true;
-        throw ReturnException(JsonValue(nullptr));  // Use null to indicate procedure return
+    } else if (returnStmt.value) {
+        // Routines can have RETURN but without a value
+        throw std::runtime_error("Routines cannot return values. Use RETURN without a value.");
     }
+    context.returned = true;
+    return Completion::Returned;
 }
 
 void executeValidate(const trx::ast::ValidateStatement &validateStmt, ExecutionContext &context) {
@@ -978,94 +1590,122 @@ void executeValidate(const trx::ast::ValidateStatement &validateStmt, ExecutionC
     // Assume ruleResult is boolean
     bool valid = std::holds_alternative<bool>(ruleResult.data) && std::get<bool>(ruleResult.data);
     const trx::ast::ValidationOutcome &outcome = valid ? validateStmt.success : validateStmt.failure;
-    // For now, just print
-    debugPrint("VALIDATE: " + std::string(valid ? "SUCCESS" : "FAILURE") + " code=" + std::to_string(outcome.code) + " message=\"" + outcome.message + "\"");
+    // For now, just log
+    logDebug("VALIDATE", {{"valid", valid}, {"code", outcome.code}, {"message", outcome.message}});
     // Set final outcome
     // Perhaps set a variable, but for now, ignore
 }
 
 
-std::string extractSelectFromDeclare(const std::string &declareSql) {
-    debugPrint("DEBUG extractSelectFromDeclare: Input: '" + declareSql + "'");
-    std::string upper = declareSql;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-    
-    // Find "CURSOR FOR"
-    size_t cursorForPos = upper.find("CURSOR FOR");
-    if (cursorForPos == std::string::npos) {
-        return declareSql; // Fallback
+
+// One row read INTO LIST: a record of the list's element TYPE, its columns taken as the
+// fields in declaration order; without a TYPE, the value of a single column or an array
+// of the columns
+JsonValue listRow(std::vector<SqlValue> row, const std::shared_ptr<const RecordShape> &shape) {
+    if (shape) {
+        row.resize(shape->keys.size());
+        return JsonValue(JsonValue::Record{shape, std::move(row)});
     }
-    
-    // Skip "CURSOR FOR" and whitespace
-    size_t selectPos = cursorForPos + 10; // length of "CURSOR FOR"
-    while (selectPos < declareSql.size() && std::isspace(declareSql[selectPos])) {
-        ++selectPos;
+    if (row.size() == 1) {
+        return std::move(row.front());
     }
-    
-    std::string result = declareSql.substr(selectPos);
-    return result;
+    return JsonValue(JsonValue::Array(std::make_move_iterator(row.begin()), std::make_move_iterator(row.end())));
 }
+
+// FETCH cursor INTO LIST :rows [LIMIT n]: reads up to n rows, or the rest of the cursor,
+// straight into a new list. SQLCODE is 100 once a fetch finds no row.
+void fetchIntoList(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context) {
+    const auto &compiled = sqlStmt.compiled;
+    std::size_t limit = compiled.fetchLimit;
+    if (compiled.limitVariable) {
+        const auto value = lookupVariable(sqlStmt.hostVariables[1], context);
+        const auto *number = std::get_if<double>(&value.data);
+        if (!number || *number < 1) {
+            throw std::runtime_error("FETCH " + sqlStmt.identifier + " INTO LIST: LIMIT must be a positive number");
+        }
+        limit = static_cast<std::size_t>(*number);
+    }
+    const auto shape = sqlStmt.listType.empty() ? nullptr : context.interpreter.recordShape(sqlStmt.listType);
+    auto &db = sqlDriver(context);
+    JsonValue::Array rows;
+    if (limit > 0) {
+        rows.reserve(std::min<std::size_t>(limit, 4096));
+    }
+    while ((limit == 0 || rows.size() < limit) && db.cursorNext(sqlStmt.identifier)) {
+        rows.push_back(listRow(db.cursorGetRow(sqlStmt.identifier), shape));
+    }
+    const auto count = rows.size();
+    resolveVariableTarget(sqlStmt.hostVariables.front(), context) = JsonValue(std::move(rows));
+    context.interpreter.setSqlCode(count > 0 ? 0.0 : 100.0);
+    logDebug("SQL FETCH CURSOR", {{"cursor", sqlStmt.identifier}, {"rows", count}});
+}
+
+// SELECT ... INTO LIST :rows FROM ...: every row of the query, streamed from the driver
+void selectIntoList(const trx::ast::SqlStatement &sqlStmt, const std::vector<SqlParameter> &params, ExecutionContext &context) {
+    const auto &compiled = sqlStmt.compiled;
+    const auto shape = sqlStmt.listType.empty() ? nullptr : context.interpreter.recordShape(sqlStmt.listType);
+    JsonValue::Array rows;
+    sqlDriver(context).queryRows(compiled.text, params, [&](const std::vector<SqlValue> &row) {
+        rows.push_back(listRow(row, shape));
+        return true;
+    });
+    const auto count = rows.size();
+    resolveVariableTarget(sqlStmt.hostVariables.front(), context) = JsonValue(std::move(rows));
+    context.interpreter.setSqlCode(count > 0 ? 0.0 : 100.0);
+    logDebug("SQL SELECT INTO", {{"sql", sqlStmt.sql}, {"rows", count}});
+}
+
 void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context) {
+    context.interpreter.checkDeadline();
     switch (sqlStmt.kind) {
         case trx::ast::SqlStatementKind::ExecImmediate: {
-            std::string sql = sqlStmt.sql;
+            const auto &compiled = sqlStmt.compiled;
+            const std::string *sql = &compiled.text;
+            std::string rebuiltSql;
             // Extract host variables from AST
             std::vector<JsonValue> hostVars = resolveHostVariablesFromAst(sqlStmt.hostVariables, context);
 
-            // Special handling for UPDATE WHERE CURRENT OF: rebuild SQL and params for only resolved variables
-            std::string upperSql = sql;
-            std::transform(upperSql.begin(), upperSql.end(), upperSql.begin(), ::toupper);
-            if (upperSql.find("UPDATE") == 0 && upperSql.find("WHERE CURRENT OF") != std::string::npos) {
-                // Parse the UPDATE statement
-                size_t setPos = upperSql.find(" SET ");
-                size_t wherePos = upperSql.find(" WHERE CURRENT OF ");
-                if (setPos != std::string::npos && wherePos != std::string::npos) {
-                    std::string setClause = sql.substr(setPos + 5, wherePos - (setPos + 5));
-                    std::string whereClause = sql.substr(wherePos);
-                    
-                    // Parse assignments in SET clause
-                    std::vector<std::string> assignments;
-                    size_t pos = 0;
-                    while (pos < setClause.size()) {
-                        size_t commaPos = setClause.find(',', pos);
-                        if (commaPos == std::string::npos) {
-                            assignments.push_back(setClause.substr(pos));
-                            break;
-                        }
-                        assignments.push_back(setClause.substr(pos, commaPos - pos));
-                        pos = commaPos + 1;
-                        while (pos < setClause.size() && std::isspace(setClause[pos])) ++pos;
-                    }
-                    
-                    // Rebuild SET clause with only resolved variables
-                    std::string newSetClause;
-                    std::vector<JsonValue> newHostVars;
-                    size_t varIndex = 0;
-                    for (size_t i = 0; i < assignments.size(); ++i) {
-                        if (varIndex < hostVars.size()) {
-                            if (newSetClause.empty()) {
-                                newSetClause = assignments[i];
-                            } else {
-                                newSetClause += ", " + assignments[i];
+            // UPDATE WHERE CURRENT OF binds one host variable per SET item; drop the
+            // assignments whose variables could not be resolved
+            const auto &assignments = compiled.setAssignments;
+            if (!assignments.empty()) {
+                if (hostVars.size() < assignments.size()) {
+                    if (hostVars.empty()) {
+                        sql = &sqlStmt.sql;
+                    } else {
+                        rebuiltSql = compiled.updatePrefix;
+                        for (size_t i = 0; i < hostVars.size(); ++i) {
+                            if (i > 0) {
+                                rebuiltSql += ", ";
                             }
-                            newHostVars.push_back(hostVars[varIndex]);
+                            rebuiltSql += assignments[i];
                         }
-                        ++varIndex;
-                    }
-                    
-                    if (!newSetClause.empty()) {
-                        sql = upperSql.substr(0, setPos + 5) + newSetClause + whereClause;
+                        rebuiltSql += compiled.currentOfClause;
+                        sql = &rebuiltSql;
                     }
-                    hostVars = newHostVars;
+                } else {
+                    hostVars.resize(assignments.size());
                 }
             }
 
-            // Execute using database driver
-            auto params = convertHostVarsToParams(hostVars);
+            // Execute using database driver. A driver in pipeline mode may queue the statement
+            // and send the next one without waiting; SQLCODE then waits until it is read.
+            auto params = convertHostVarsToParams(std::move(hostVars));
+            if (!compiled.readOnly) {
+                context.interpreter.noteWrite();
+            }
             try {
-                context.interpreter.db().executeSql(sql, params);
+                auto &interpreter = context.interpreter;
+                const bool savepointOpen = !context.savepoint || context.savepoint->open;
+                if (savepointOpen && (!interpreter.queuedDriver() || interpreter.queuedDriver() == &interpreter.db()) &&
+                    interpreter.db().queueSql(*sql, params)) {
+                    interpreter.setSqlCodeQueued(interpreter.db());
+                    logDebug("SQL QUEUE", {{"sql", sqlStmt.sql}});
+                    break;
+                }
+                sqlDriver(context).executeSql(*sql, params);
                 context.interpreter.setSqlCode(0.0); // Success
-                debugPrint("SQL EXEC: " + sqlStmt.sql);
+                logDebug("SQL EXEC", {{"sql", sqlStmt.sql}});
             } catch (const std::exception& e) {
                 context.interpreter.setSqlCode(-1.0); // Error
                 // std::cerr << "SQL execution failed: " << e.what() << std::endl;
@@ -1074,13 +1714,17 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
         }
         
         case trx::ast::SqlStatementKind::DeclareCursor: {
-            std::string selectSql = extractSelectFromDeclare(sqlStmt.sql);
+            const std::string &selectSql = sqlStmt.compiled.text;
             std::vector<JsonValue> hostVars = resolveHostVariablesFromAst(sqlStmt.hostVariables, context);
 
             try {
-                context.interpreter.db().openCursor(sqlStmt.identifier, selectSql, convertHostVarsToParams(hostVars));
+                if (sqlStmt.compiled.positioned) {
+                    sqlDriver(context).openPositionedCursor(sqlStmt.identifier, selectSql, convertHostVarsToParams(std::move(hostVars)));
+                } else {
+                    sqlDriver(context).openCursor(sqlStmt.identifier, selectSql, convertHostVarsToParams(std::move(hostVars)));
+                }
                 context.interpreter.setSqlCode(0.0); // Success
-                debugPrint("SQL DECLARE CURSOR: " + sqlStmt.identifier + " AS " + selectSql);
+                logDebug("SQL DECLARE CURSOR", {{"cursor", sqlStmt.identifier}, {"sql", selectSql}});
             } catch (const std::exception& e) {
                 context.interpreter.setSqlCode(-1.0); // Error
                 // std::cerr << "SQL cursor declare failed: " << e.what() << std::endl;
@@ -1093,22 +1737,22 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
                 // This is OPEN cursor USING parameters
                 std::vector<JsonValue> openParams = resolveHostVariablesFromAst(sqlStmt.openParameters, context);
                 try {
-                    context.interpreter.db().openDeclaredCursorWithParams(sqlStmt.identifier, convertHostVarsToParams(openParams));
+                    sqlDriver(context).openDeclaredCursorWithParams(sqlStmt.identifier, convertHostVarsToParams(std::move(openParams)));
                     context.interpreter.setSqlCode(0.0); // Success
-                    debugPrint("SQL OPEN CURSOR WITH PARAMS: " + sqlStmt.identifier);
+                    logDebug("SQL OPEN CURSOR", {{"cursor", sqlStmt.identifier}, {"params", sqlStmt.openParameters.size()}});
                 } catch (const std::exception& e) {
                     context.interpreter.setSqlCode(-1.0); // Error
-                    debugPrint("SQL OPEN CURSOR WITH PARAMS failed: " + std::string(e.what()));
+                    logDebug("SQL OPEN CURSOR failed", {{"cursor", sqlStmt.identifier}, {"error", e.what()}});
                 }
             } else {
                 // Regular OPEN cursor
                 try {
-                    context.interpreter.db().openDeclaredCursor(sqlStmt.identifier);
+                    sqlDriver(context).openDeclaredCursor(sqlStmt.identifier);
                     context.interpreter.setSqlCode(0.0); // Success
-                    debugPrint("SQL OPEN CURSOR: " + sqlStmt.identifier);
+                    logDebug("SQL OPEN CURSOR", {{"cursor", sqlStmt.identifier}});
                 } catch (const std::exception& e) {
                     context.interpreter.setSqlCode(-1.0); // Error
-                    debugPrint("SQL OPEN CURSOR failed: " + std::string(e.what()));
+                    logDebug("SQL OPEN CURSOR failed", {{"cursor", sqlStmt.identifier}, {"error", e.what()}});
                 }
             }
             break;
@@ -1116,11 +1760,11 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
 
         case trx::ast::SqlStatementKind::FetchCursor: {
             try {
-                debugPrint("FETCH: calling cursorNext for " + sqlStmt.identifier);
-                if (context.interpreter.db().cursorNext(sqlStmt.identifier)) {
+                if (sqlStmt.compiled.intoList && !sqlStmt.hostVariables.empty()) {
+                    fetchIntoList(sqlStmt, context);
+                } else if (sqlDriver(context).cursorNext(sqlStmt.identifier)) {
                     // std::cout << "FETCH: cursorNext returned true, calling cursorGetRow" << std::endl;
-                    auto row = context.interpreter.db().cursorGetRow(sqlStmt.identifier);
-                    debugPrint("FETCH: cursorGetRow returned row with " + std::to_string(row.size()) + " columns");
+                    auto row = sqlDriver(context).cursorGetRow(sqlStmt.identifier);
                     // Bind results to host variables
                     size_t i = 0;
                     for (const auto& var : sqlStmt.hostVariables) {
@@ -1132,16 +1776,15 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
                         ++i;
                     }
                     context.interpreter.setSqlCode(0.0); // Success - row found
-                    debugPrint("SQL FETCH CURSOR: " + sqlStmt.identifier + " - row found");
+                    logDebug("SQL FETCH CURSOR", {{"cursor", sqlStmt.identifier}, {"columns", row.size()}});
                 } else {
-                    debugPrint("FETCH: cursorNext returned false, no more rows");
                     // std::cout << "FETCH: cursorNext returned false, no more rows" << std::endl;
                     // No more rows - set host variables to null
                     for (const auto& var : sqlStmt.hostVariables) {
                         resolveVariableTarget(var, context) = JsonValue(nullptr);
                     }
                     context.interpreter.setSqlCode(100.0); // No data found
-                    debugPrint("SQL FETCH CURSOR: " + sqlStmt.identifier + " - no more rows");
+                    logDebug("SQL FETCH CURSOR", {{"cursor", sqlStmt.identifier}, {"found", false}});
                 }
             } catch (const std::runtime_error& e) {
                 context.interpreter.setSqlCode(-1.0); // Error
@@ -1152,9 +1795,9 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
 
         case trx::ast::SqlStatementKind::CloseCursor: {
             try {
-                context.interpreter.db().closeCursor(sqlStmt.identifier);
+                sqlDriver(context).closeCursor(sqlStmt.identifier);
                 context.interpreter.setSqlCode(0.0); // Success
-                debugPrint("SQL CLOSE CURSOR: " + sqlStmt.identifier);
+                logDebug("SQL CLOSE CURSOR", {{"cursor", sqlStmt.identifier}});
             } catch (const std::exception& e) {
                 context.interpreter.setSqlCode(-1.0); // Error
                 // std::cerr << "SQL cursor close failed: " << e.what() << std::endl;
@@ -1163,16 +1806,17 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
         }
 
         case trx::ast::SqlStatementKind::SelectForUpdate: {
-            std::string sql = sqlStmt.sql;
+            const std::string &sql = sqlStmt.compiled.text;
             std::vector<JsonValue> hostVars = resolveHostVariablesFromAst(sqlStmt.hostVariables, context);
 
             // Execute the SELECT statement (FOR UPDATE is mainly a hint for locking in other databases)
-            auto params = convertHostVarsToParams(hostVars);
+            auto params = convertHostVarsToParams(std::move(hostVars));
             try {
-                auto results = context.interpreter.db().querySql(sql, params);
-                if (!results.empty()) {
+                // Only the first row is used; the driver stops reading after it
+                auto first = sqlDriver(context).queryFirstRow(sql, params);
+                if (first) {
                     // Bind first row results to host variables if specified
-                    const auto& row = results[0];
+                    const auto& row = *first;
                     size_t i = 0;
                     for (const auto& var : sqlStmt.hostVariables) {
                         if (i < row.size()) {
@@ -1198,53 +1842,39 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
         }
 
         case trx::ast::SqlStatementKind::SelectInto: {
-            std::string sql = sqlStmt.sql;
-
-            // For SELECT INTO, parse the SQL to separate INTO variables from WHERE parameters
-            std::string upperSql = sql;
-            std::transform(upperSql.begin(), upperSql.end(), upperSql.begin(), ::toupper);
-            std::string::size_type intoPos = upperSql.find(" INTO ");
-            size_t intoCount = 0;
-            if (intoPos != std::string::npos) {
-                std::string::size_type fromPos = upperSql.find(" FROM ", intoPos);
-                if (fromPos != std::string::npos) {
-                    std::string intoPart = upperSql.substr(intoPos + 6, fromPos - (intoPos + 6));
-                    size_t pos = 0;
-                    while ((pos = intoPart.find('?', pos)) != std::string::npos) {
-                        ++intoCount;
-                        ++pos;
-                    }
-                    // Remove INTO clause from SQL
-                    sql = upperSql.substr(0, intoPos) + upperSql.substr(fromPos);
-                }
-            }
+            // INTO targets and the INTO-less SQL were split off at parse time
+            const std::string &sql = sqlStmt.compiled.text;
+            const size_t intoCount = sqlStmt.compiled.intoCount;
 
             // Resolve only the input host variables (after INTO)
-            std::vector<trx::ast::VariableExpression> inputVars(sqlStmt.hostVariables.begin() + intoCount, sqlStmt.hostVariables.end());
-            std::vector<JsonValue> inputHostVars = resolveHostVariablesFromAst(inputVars, context);
+            std::vector<JsonValue> inputHostVars = resolveHostVariablesFromAst(sqlStmt.hostVariables, context, intoCount);
 
             // Parameters are the input host variables
-            auto params = convertHostVarsToParams(inputHostVars);
+            auto params = convertHostVarsToParams(std::move(inputHostVars));
 
             // Execute the SELECT statement and fetch single row into host variables
             try {
-                auto results = context.interpreter.db().querySql(sql, params);
-                if (!results.empty()) {
+                if (sqlStmt.compiled.intoList && intoCount > 0) {
+                    selectIntoList(sqlStmt, params, context);
+                    break;
+                }
+                auto first = sqlDriver(context).queryFirstRow(sql, params);
+                if (first) {
                     // Bind first row results to INTO host variables
-                    const auto& row = results[0];
+                    const auto& row = *first;
                     size_t i = 0;
                     for (size_t j = 0; j < intoCount && i < row.size(); ++j) {
                         resolveVariableTarget(sqlStmt.hostVariables[j], context) = row[i++];
                     }
                     context.interpreter.setSqlCode(0.0); // Success
-                    debugPrint("SQL SELECT INTO: " + sqlStmt.sql);
+                    logDebug("SQL SELECT INTO", {{"sql", sqlStmt.sql}});
                 } else {
                     // No rows found - set INTO host variables to null
                     for (size_t j = 0; j < intoCount; ++j) {
                         resolveVariableTarget(sqlStmt.hostVariables[j], context) = JsonValue(nullptr);
                     }
                     context.interpreter.setSqlCode(100.0); // No data found
-                    debugPrint("SQL SELECT INTO: " + sqlStmt.sql + " - no rows found");
+                    logDebug("SQL SELECT INTO", {{"sql", sqlStmt.sql}, {"found", false}});
                 }
             } catch (const std::exception& e) {
                 context.interpreter.setSqlCode(-1.0); // Error
@@ -1255,26 +1885,83 @@ void executeSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context
     }
 }
 
-void executeStatement(const trx::ast::Statement &statement, ExecutionContext &context) {
-    std::visit(
+// executeSql() inside a client span carrying the statement, its outcome and the rows it returned
+void executeTracedSql(const trx::ast::SqlStatement &sqlStmt, ExecutionContext &context) {
+    using Kind = trx::ast::SqlStatementKind;
+    std::string operation;
+    switch (sqlStmt.kind) {
+        case Kind::DeclareCursor: operation = "DECLARE CURSOR"; break;
+        case Kind::OpenCursor: operation = "OPEN CURSOR"; break;
+        case Kind::FetchCursor: operation = "FETCH"; break;
+        case Kind::CloseCursor: operation = "CLOSE CURSOR"; break;
+        default: {
+            // The statement's leading keyword: SELECT, INSERT, WITH, ...
+            const auto &text = sqlStmt.compiled.text;
+            const auto begin = text.find_first_not_of(" \t\r\n");
+            const auto end = begin == std::string::npos ? begin : text.find_first_of(" \t\r\n(", begin);
+            operation = begin == std::string::npos ? "SQL" : text.substr(begin, end - begin);
+            std::transform(operation.begin(), operation.end(), operation.begin(), [](unsigned char c) { return std::toupper(c); });
+        }
+    }
+    Span span(context.interpreter.tracer(), context.interpreter.traceContext(), operation, SpanKind::Client);
+    span.setAttribute("db.operation", operation);
+    if (!sqlStmt.identifier.empty()) {
+        span.setAttribute("db.cursor", sqlStmt.identifier);
+    }
+    if (!sqlStmt.compiled.text.empty()) {
+        span.setAttribute("db.statement", sqlStmt.compiled.text);
+    }
+
+    executeSql(sqlStmt, context);
+
+    // Reading SQLCODE here would wait for a queued statement and undo the pipelining
+    if (context.interpreter.sqlCodeQueued()) {
+        return;
+    }
+    const double sqlCode = context.interpreter.getSqlCode();
+    span.setAttribute("trx.sqlcode", static_cast<std::int64_t>(sqlCode));
+    if (sqlCode < 0) {
+        span.setError("SQL statement failed");
+    } else if (sqlStmt.compiled.intoList && sqlCode == 0 && !sqlStmt.hostVariables.empty()) {
+        const auto &rows = resolveVariableTarget(sqlStmt.hostVariables.front(), context);
+        const auto *list = std::get_if<JsonValue::Array>(&rows.data);
+        span.setAttribute("db.rows", static_cast<std::int64_t>(list ? list->size() : 0));
+    } else if (sqlStmt.kind == Kind::FetchCursor || sqlStmt.kind == Kind::SelectInto || sqlStmt.kind == Kind::SelectForUpdate) {
+        span.setAttribute("db.rows", static_cast<std::int64_t>(sqlCode == 0 ? 1 : 0));
+    }
+}
+
+Completion executeStatement(const trx::ast::Statement &statement, ExecutionContext &context) {
+    context.interpreter.checkDeadline();
+    Profiler::Scope frame(context.interpreter.profiler(), statement);
+    return std::visit(
         Overloaded{
-            [&](const trx::ast::AssignmentStatement &assignment) { executeAssignment(assignment, context); },
-            [&](const trx::ast::VariableDeclarationStatement &varDecl) { executeVariableDeclaration(varDecl, context); },
-            [&](const trx::ast::ThrowStatement &throwStmt) { executeThrow(throwStmt, context); },
-            [&](const trx::ast::TryCatchStatement &tryCatchStmt) { executeTryCatch(tryCatchStmt, context); },
-            [&](const trx::ast::IfStatement &ifStmt) { executeIf(ifStmt, context); },
-            [&](const trx::ast::WhileStatement &whileStmt) { executeWhile(whileStmt, context); },
-            [&](const trx::ast::ForStatement &forStmt) { executeFor(forStmt, context); },
-            [&](const trx::ast::BlockStatement &block) { executeBlock(block, context); },
-            [&](const trx::ast::SwitchStatement &switchStmt) { executeSwitch(switchStmt, context); },
-            [&](const trx::ast::SortStatement &sortStmt) { executeSort(sortStmt, context); },
-            [&](const trx::ast::TraceStatement &trace) { executeTrace(trace, context); },
-            [&](const trx::ast::ExpressionStatement &exprStmt) { executeExpression(exprStmt, context); },
-            [&](const trx::ast::SystemStatement &systemStmt) { executeSystem(systemStmt, context); },
-            [&](const trx::ast::BatchStatement &batchStmt) { executeBatch(batchStmt, context); },
-            [&](const trx::ast::ReturnStatement &returnStmt) { executeReturn(returnStmt, context); },
-            [&](const trx::ast::ValidateStatement &validateStmt) { executeValidate(validateStmt, context); },
-            [&](const trx::ast::SqlStatement &sqlStmt) { executeSql(sqlStmt, context); },
+            [&](const trx::ast::AssignmentStatement &assignment) { executeAssignment(assignment, context); return Completion::Normal; },
+            [&](const trx::ast::VariableDeclarationStatement &varDecl) { executeVariableDeclaration(varDecl, context); return Completion::Normal; },
+            [&](const trx::ast::ThrowStatement &throwStmt) { return executeThrow(throwStmt, context); },
+            [&](const trx::ast::TryCatchStatement &tryCatchStmt) { return executeTryCatch(tryCatchStmt, context); },
+            [&](const trx::ast::IfStatement &ifStmt) { return executeIf(ifStmt, context); },
+            [&](const trx::ast::WhileStatement &whileStmt) { return executeWhile(whileStmt, context); },
+            [&](const trx::ast::ForStatement &forStmt) { return executeFor(forStmt, context); },
+            [&](const trx::ast::BlockStatement &block) { return executeBlock(block, context); },
+            [&](const trx::ast::SwitchStatement &switchStmt) { return executeSwitch(switchStmt, context); },
+            [&](const trx::ast::SortStatement &sortStmt) { executeSort(sortStmt, context); return Completion::Normal; },
+            [&](const trx::ast::TraceStatement &trace) { executeTrace(trace, context); return Completion::Normal; },
+            [&](const trx::ast::EmitStatement &emitStmt) { executeEmit(emitStmt, context); return Completion::Normal; },
+            [&](const trx::ast::ExpressionStatement &exprStmt) { executeExpression(exprStmt, context); return Completion::Normal; },
+            [&](const trx::ast::SystemStatement &systemStmt) { executeSystem(systemStmt, context); return Completion::Normal; },
+            [&](const trx::ast::BatchStatement &batchStmt) { executeBatch(batchStmt, context); return Completion::Normal; },
+            [&](const trx::ast::ReturnStatement &returnStmt) { return executeReturn(returnStmt, context); },
+            [&](const trx::ast::ValidateStatement &validateStmt) { executeValidate(validateStmt, context); return Completion::Normal; },
+            [&](const trx::ast::SqlStatement &sqlStmt) {
+                Profiler::Scope sqlFrame(context.interpreter.profiler(), "[sql]");
+                if (context.interpreter.tracer()) {
+                    executeTracedSql(sqlStmt, context);
+                } else {
+                    executeSql(sqlStmt, context);
+                }
+                return Completion::Normal;
+            },
             [&](const auto &) {
                 throw std::runtime_error("Statement type not supported by interpreter yet");
             }
@@ -1282,14 +1969,540 @@ void executeStatement(const trx::ast::Statement &statement, ExecutionContext &co
         statement.node);
 }
 
-void executeStatements(const trx::ast::StatementList &statements, ExecutionContext &context) {
+Completion executeStatements(const trx::ast::StatementList &statements, ExecutionContext &context) {
     for (const auto &statement : statements) {
-        executeStatement(statement, context);
+        if (const auto completion = executeStatement(statement, context); completion != Completion::Normal) {
+            return completion;
+        }
+    }
+    return Completion::Normal;
+}
+
+bool bytecodeEnabled() {
+    // TRX_BYTECODE=0 selects the tree-walker; so does debug logging, whose records are written there
+    static const bool enabled = [] {
+        const char *env = std::getenv("TRX_BYTECODE");
+        const bool disabled = env && (std::string(env) == "0" || std::string(env) == "false");
+        return !disabled && !Logger::enabled(LogLevel::Debug);
+    }();
+    return enabled;
+}
+
+bool isTrue(const JsonValue &value) {
+    const auto *flag = std::get_if<bool>(&value.data);
+    return flag && *flag;
+}
+
+// Typed fast paths for number/number and bool operands; everything else goes through applyBinary
+bool tryNumericBinary(OpCode op, const JsonValue &lhs, const JsonValue &rhs, JsonValue &result) {
+    const auto *x = std::get_if<double>(&lhs.data);
+    const auto *y = std::get_if<double>(&rhs.data);
+    if (!x || !y) {
+        return false;
+    }
+    switch (op) {
+        case OpCode::Add: result.data = *x + *y; return true;
+        case OpCode::Subtract: result.data = *x - *y; return true;
+        case OpCode::Multiply: result.data = *x * *y; return true;
+        case OpCode::Less: result.data = *x < *y; return true;
+        case OpCode::LessEqual: result.data = *x <= *y; return true;
+        case OpCode::Greater: result.data = *x > *y; return true;
+        case OpCode::GreaterEqual: result.data = *x >= *y; return true;
+        case OpCode::Equal: result.data = *x == *y; return true;
+        case OpCode::NotEqual: result.data = *x != *y; return true;
+        default: return false; // Divide and Modulo keep their error handling in applyBinary
+    }
+}
+
+const JsonValue *boundSlot(ExecutionContext &context, std::uint32_t slot) {
+    if (slot < context.frame.size() && context.frame[slot]) {
+        return &*context.frame[slot];
+    }
+    return nullptr;
+}
+
+// FOR loop and TRY steps, shared by runProgram and routines compiled ahead of time (NativeFrame)
+void forInit(JsonValue &items, JsonValue &index) {
+    if (!items.isArray()) {
+        throw std::runtime_error("FOR loop collection must be an array");
+    }
+    index.data = 0.0;
+}
+
+bool forNext(const Program &program, ExecutionContext &context, const JsonValue &items, JsonValue &index, std::uint32_t variable) {
+    const auto &list = items.asArray();
+    auto &position = std::get<double>(index.data);
+    const auto next = static_cast<std::size_t>(position);
+    if (next >= list.size()) {
+        return false;
     }
+    context.interpreter.checkDeadline();
+    position += 1.0;
+    resolveVariableTarget(*program.variables[variable], context) = list[next];
+    return true;
 }
 
+void forInitVar(const Program &program, ExecutionContext &context, std::uint32_t variable, JsonValue &size, JsonValue &index) {
+    const auto &items = lookupVariable(*program.variables[variable], context);
+    if (!items.isArray()) {
+        throw std::runtime_error("FOR loop collection must be an array");
+    }
+    size.data = static_cast<double>(items.asArray().size());
+    index.data = 0.0;
+}
+
+bool forNextVar(const Program &program, ExecutionContext &context, const JsonValue &size, JsonValue &index, std::uint32_t variable) {
+    // Looked up again every item: the body may have reassigned or grown the list
+    auto &position = std::get<double>(index.data);
+    const auto next = static_cast<std::size_t>(position);
+    if (position >= std::get<double>(size.data)) {
+        return false;
+    }
+    JsonValue &target = resolveVariableTarget(*program.variables[variable], context);
+    const auto &items = lookupVariable(*program.variables[variable + 1], context);
+    if (!items.isArray() || next >= items.asArray().size()) {
+        return false;
+    }
+    context.interpreter.checkDeadline();
+    position += 1.0;
+    target = items.asArray()[next];
+    return true;
+}
+
+// Unwind to the innermost handler and set |pc| to its CATCH; false when there is none
+bool unwindTo(const Program &program, std::vector<native::Handler> &handlers, const TrxException &e, ExecutionContext &context,
+              std::uint32_t &pc) {
+    if (handlers.empty()) {
+        return false;
+    }
+    const auto handler = handlers.back();
+    handlers.pop_back();
+    if (handler.catchVariable != noOperand) {
+        bindException(*program.variables[handler.catchVariable], e, context);
+    }
+    pc = handler.resumeAt;
+    return true;
+}
+
+// THROW: as unwindTo(), but a value no handler catches is kept for the caller
+bool throwValue(const Program &program, std::vector<native::Handler> &handlers, JsonValue value, ExecutionContext &context,
+                std::uint32_t &pc) {
+    TrxThrowException thrown(std::move(value), std::nullopt);
+    if (unwindTo(program, handlers, thrown, context, pc)) {
+        return true;
+    }
+    context.thrown.emplace(std::move(thrown));
+    return false;
+}
+
+// A statement the bytecode hands to the tree-walker; a THROW escaping it unwinds as above
+native::Step delegateStatement(const Program &program, std::uint32_t statement, std::vector<native::Handler> &handlers,
+                               ExecutionContext &context, std::uint32_t &pc) {
+    switch (executeStatement(*program.statements[statement], context)) {
+        case Completion::Normal:
+            return native::Step::Next;
+        case Completion::Returned:
+            return native::Step::Returned;
+        case Completion::Thrown: {
+            const TrxThrowException thrown = std::move(*context.thrown);
+            context.thrown.reset();
+            if (!unwindTo(program, handlers, thrown, context, pc)) {
+                context.thrown.emplace(thrown);
+                return native::Step::Thrown;
+            }
+            return native::Step::Resume;
+        }
+    }
+    return native::Step::Next;
+}
+
+// Execute a compiled routine body. TRY handlers are kept on a stack; a THROW or a
+// TrxException raised by the runtime unwinds to the innermost one, exactly as nested
+// executeTryCatch calls would. A THROW with no handler left is handed back to the caller.
+Completion runProgram(const Program &program, ExecutionContext &context) {
+    std::vector<JsonValue> r(program.registerCount);
+    std::vector<native::Handler> handlers;
+    const auto &code = program.code;
+    std::uint32_t pc = 0;
+
+    while (true) {
+        try {
+            while (pc < code.size()) {
+                const auto &ins = code[pc++];
+                switch (ins.op) {
+                    case OpCode::LoadConst:
+                        r[ins.a] = program.constants[ins.b];
+                        break;
+                    case OpCode::LoadSlot:
+                        if (const auto *value = boundSlot(context, ins.b)) {
+                            r[ins.a] = *value;
+                        } else {
+                            r[ins.a] = resolveVariableValue(*program.variables[ins.c], context);
+                        }
+                        break;
+                    case OpCode::LoadVar:
+                        r[ins.a] = resolveVariableValue(*program.variables[ins.b], context);
+                        break;
+                    case OpCode::LoadSqlCode:
+                        r[ins.a].data = context.interpreter.getSqlCode();
+                        break;
+                    case OpCode::StoreSlot:
+                        if (boundSlot(context, ins.b)) {
+                            *context.frame[ins.b] = std::move(r[ins.a]);
+                        } else {
+                            resolveVariableTarget(*program.variables[ins.c], context) = std::move(r[ins.a]);
+                        }
+                        break;
+                    case OpCode::StoreVar:
+                        resolveVariableTarget(*program.variables[ins.b], context) = std::move(r[ins.a]);
+                        break;
+                    case OpCode::BindSlot:
+                        context.frame[ins.b] = std::move(r[ins.a]);
+                        break;
+                    case OpCode::Positive:
+                        r[ins.a] = applyUnary(trx::ast::UnaryOperator::Positive, r[ins.b]);
+                        break;
+                    case OpCode::Negate:
+                        if (auto *number = std::get_if<double>(&r[ins.b].data)) {
+                            r[ins.a].data = -*number;
+                        } else {
+                            r[ins.a] = applyUnary(trx::ast::UnaryOperator::Negate, r[ins.b]);
+                        }
+                        break;
+                    case OpCode::Not:
+                        if (auto *flag = std::get_if<bool>(&r[ins.b].data)) {
+                            r[ins.a].data = !*flag;
+                        } else {
+                            r[ins.a] = applyUnary(trx::ast::UnaryOperator::Not, r[ins.b]);
+                        }
+                        break;
+                    case OpCode::Add:
+                    case OpCode::Subtract:
+                    case OpCode::Multiply:
+                    case OpCode::Divide:
+                    case OpCode::Modulo:
+                    case OpCode::Equal:
+                    case OpCode::NotEqual:
+                    case OpCode::Less:
+                    case OpCode::LessEqual:
+                    case OpCode::Greater:
+                    case OpCode::GreaterEqual:
+                    case OpCode::And:
+                    case OpCode::Or:
+                        if (!tryNumericBinary(ins.op, r[ins.b], r[ins.c], r[ins.a])) {
+                            const auto op = static_cast<trx::ast::BinaryOperator>(static_cast<int>(ins.op) - static_cast<int>(OpCode::Add));
+                            r[ins.a] = applyBinary(op, r[ins.b], r[ins.c]);
+                        }
+                        break;
+                    case OpCode::RoundScale:
+                        if (auto *number = std::get_if<double>(&r[ins.a].data)) {
+                            *number = roundToScale(*number, static_cast<int>(ins.b));
+                        }
+                        break;
+                    case OpCode::NewObject:
+                        r[ins.a] = JsonValue::object();
+                        break;
+                    case OpCode::SetField:
+                        r[ins.a].asObject()[program.keys[ins.b]] = std::move(r[ins.c]);
+                        break;
+                    case OpCode::NewArray:
+                        r[ins.a] = JsonValue::array();
+                        break;
+                    case OpCode::Push:
+                        r[ins.a].asArray().push_back(std::move(r[ins.b]));
+                        break;
+                    case OpCode::Builtin:
+                        r[ins.a] = evaluateBuiltin(std::get<trx::ast::BuiltinExpression>(program.expressions[ins.b]->node), context);
+                        break;
+                    case OpCode::EvalTree:
+                        r[ins.a] = evaluateExpression(program.expressions[ins.b], context);
+                        break;
+                    case OpCode::Jump:
+                        pc = ins.a;
+                        break;
+                    case OpCode::JumpIfNotTrue:
+                        if (!isTrue(r[ins.a])) {
+                            pc = ins.b;
+                        }
+                        break;
+                    case OpCode::JumpIfEqual:
+                        if (r[ins.a] == r[ins.b]) {
+                            pc = ins.c;
+                        }
+                        break;
+                    case OpCode::LoopGuard: {
+                        auto &iterations = std::get<double>(r[ins.a].data);
+                        if (++iterations > whileIterationLimit()) {
+                            throw std::runtime_error("WHILE loop exceeded maximum iterations (" + std::to_string(whileIterationLimit()) + ")");
+                        }
+                        context.interpreter.checkDeadline();
+                        break;
+                    }
+                    case OpCode::ForInit:
+                        forInit(r[ins.a], r[ins.a + 1]);
+                        break;
+                    case OpCode::ForNext:
+                        if (!forNext(program, context, r[ins.a], r[ins.a + 1], ins.b)) {
+                            pc = ins.c;
+                        }
+                        break;
+                    case OpCode::ForInitVar:
+                        forInitVar(program, context, ins.b, r[ins.a], r[ins.a + 1]);
+                        break;
+                    case OpCode::ForNextVar:
+                        if (!forNextVar(program, context, r[ins.a], r[ins.a + 1], ins.b)) {
+                            pc = ins.c;
+                        }
+                        break;
+                    case OpCode::TryBegin:
+                        handlers.push_back({ins.a, ins.b});
+                        break;
+                    case OpCode::TryEnd:
+                        handlers.pop_back();
+                        break;
+                    case OpCode::Throw:
+                        if (!throwValue(program, handlers, std::move(r[ins.a]), context, pc)) {
+                            return Completion::Thrown;
+                        }
+                        break;
+                    case OpCode::Return:
+                        if (ins.a != noOperand) {
+                            context.returnValue = std::move(r[ins.a]);
+                        }
+                        context.returned = true;
+                        return Completion::Returned;
+                    case OpCode::ReturnSlot:
+                        if (boundSlot(context, ins.a)) {
+                            context.returnValue = std::move(*context.frame[ins.a]);
+                        } else {
+                            context.returnValue = resolveVariableValue(*program.variables[ins.b], context);
+                        }
+                        context.returned = true;
+                        return Completion::Returned;
+                    case OpCode::ExecSql:
+                        executeSql(std::get<trx::ast::SqlStatement>(program.statements[ins.a]->node), context);
+                        break;
+                    case OpCode::ExecStatement:
+                        switch (delegateStatement(program, ins.a, handlers, context, pc)) {
+                            case native::Step::Next:
+                            case native::Step::Resume:
+                                break;
+                            case native::Step::Returned:
+                                return Completion::Returned;
+                            case native::Step::Thrown:
+                                return Completion::Thrown;
+                        }
+                        break;
+                }
+            }
+            return Completion::Normal;
+        } catch (const TrxException &e) {
+            if (!unwindTo(program, handlers, e, context, pc)) {
+                throw;
+            }
+        }
+    }
+}
+
+// What the code of a routine compiled ahead of time calls back into: the steps of
+// runProgram that are not inlined, over the routine's program and context
+class NativeFrame final : public native::Frame {
+public:
+    NativeFrame(const Program &program, ExecutionContext &context)
+        : Frame(context.frame, context.returnValue, program.constants, program.keys, whileIterationLimit()),
+          program_{program},
+          context_{context} {}
+
+    JsonValue load(std::uint32_t variable) override { return resolveVariableValue(*program_.variables[variable], context_); }
+    void store(std::uint32_t variable, JsonValue value) override {
+        resolveVariableTarget(*program_.variables[variable], context_) = std::move(value);
+    }
+    double sqlCode() override { return context_.interpreter.getSqlCode(); }
+
+    JsonValue unary(OpCode op, const JsonValue &operand) override {
+        switch (op) {
+            case OpCode::Negate: return applyUnary(trx::ast::UnaryOperator::Negate, operand);
+            case OpCode::Not: return applyUnary(trx::ast::UnaryOperator::Not, operand);
+            default: return applyUnary(trx::ast::UnaryOperator::Positive, operand);
+        }
+    }
+    JsonValue binary(OpCode op, const JsonValue &lhs, const JsonValue &rhs) override {
+        return applyBinary(static_cast<trx::ast::BinaryOperator>(static_cast<int>(op) - static_cast<int>(OpCode::Add)), lhs, rhs);
+    }
+    JsonValue builtin(std::uint32_t expression) override {
+        return evaluateBuiltin(std::get<trx::ast::BuiltinExpression>(program_.expressions[expression]->node), context_);
+    }
+    JsonValue eval(std::uint32_t expression) override { return evaluateExpression(program_.expressions[expression], context_); }
+    [[noreturn]] void loopExceeded() override {
+        throw std::runtime_error("WHILE loop exceeded maximum iterations (" + std::to_string(loopLimit) + ")");
+    }
+
+    void forInit(JsonValue &items, JsonValue &index) override { runtime::forInit(items, index); }
+    bool forNext(const JsonValue &items, JsonValue &index, std::uint32_t variable) override {
+        return runtime::forNext(program_, context_, items, index, variable);
+    }
+    void forInitVar(std::uint32_t variable, JsonValue &size, JsonValue &index) override {
+        runtime::forInitVar(program_, context_, variable, size, index);
+    }
+    bool forNextVar(const JsonValue &size, JsonValue &index, std::uint32_t variable) override {
+        return runtime::forNextVar(program_, context_, size, index, variable);
+    }
+
+    bool unwind(const TrxException &e, std::uint32_t &pc) override { return unwindTo(program_, handlers, e, context_, pc); }
+    bool raise(JsonValue value, std::uint32_t &pc) override { return throwValue(program_, handlers, std::move(value), context_, pc); }
+
+    void execSql(std::uint32_t statement) override {
+        executeSql(std::get<trx::ast::SqlStatement>(program_.statements[statement]->node), context_);
+    }
+    native::Step exec(std::uint32_t statement, std::uint32_t &pc) override {
+        return delegateStatement(program_, statement, handlers, context_, pc);
+    }
+
+private:
+    const Program &program_;
+    ExecutionContext &context_;
+};
+
+Completion runNative(const native::Routine &routine, const Program &program, ExecutionContext &context) {
+    NativeFrame frame(program, context);
+    switch (routine.run(frame)) {
+        case native::Result::Normal:
+            break;
+        case native::Result::Returned:
+            context.returned = true;
+            return Completion::Returned;
+        case native::Result::Thrown:
+            return Completion::Thrown;
+    }
+    return Completion::Normal;
+}
+
+Completion runBody(const trx::ast::ProcedureDecl &procedure, const Program *program, ExecutionContext &context) {
+    // A profiled run stays on the tree-walker, which has a frame per statement
+    if (program && bytecodeEnabled() && !context.interpreter.profiler()) {
+        if (const auto *routine = context.interpreter.nativeRoutine(&procedure)) {
+            return runNative(*routine, *program, context);
+        }
+        return runProgram(*program, context);
+    }
+    return executeStatements(procedure.body, context);
+}
+
+
+// How one field of a TYPE is read from a request body; fixed-size arrays are taken as they come
+RecordLayout::Field layoutField(const trx::ast::RecordField &field, const std::unordered_map<std::string, std::shared_ptr<RecordLayout>> &layouts) {
+    RecordLayout::Field result;
+    result.key = toLowerCopy(field.jsonName.empty() ? field.name.name : field.jsonName);
+    if (field.dimension > 1) {
+        return result;
+    }
+    std::string type = field.typeName;
+    if (type.rfind("LIST(", 0) == 0 && type.back() == ')') {
+        result.list = true;
+        type = type.substr(5, type.size() - 6);
+    }
+    if (type == "INTEGER" || type == "SMALLINT" || type == "DECIMAL") {
+        result.kind = RecordLayout::Kind::Number;
+    } else if (type == "CHAR" || type == "DATE" || type == "TIME") {
+        result.kind = RecordLayout::Kind::String;
+    } else if (type == "BOOLEAN") {
+        result.kind = RecordLayout::Kind::Boolean;
+    } else if (const auto it = layouts.find(type); it != layouts.end()) {
+        result.kind = RecordLayout::Kind::Record;
+        result.record = it->second.get();
+    }
+    return result;
+}
+
+// An INTEGER path parameter, read as a 64-bit integer rather than through std::stoi, which
+// stops at 32 bits; 0 when it is not one
+JsonValue integerParameter(const std::string &text) {
+    std::int64_t value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return JsonValue(static_cast<double>(value));
+}
 } // namespace
 
+::ThreadPool &parallelPool() {
+    static ThreadPool pool(std::clamp(std::thread::hardware_concurrency(), 2u, 16u), 0, 16);
+    return pool;
+}
+
+// What execute() runs a routine in. A routine that may write gets a transaction, or a
+// savepoint inside the caller's. A read-only routine has nothing to undo: it runs in
+// autocommit, or in a read-only transaction when it needs one to keep cursors open, and
+// outside a transaction it goes to the replica driver when the interpreter has one.
+class Interpreter::RoutineScope {
+public:
+    RoutineScope(Interpreter &interpreter, const ast::ProcedureDecl &procedure) : interpreter_{interpreter} {
+        auto &db = interpreter.dbDriver_;
+        if (procedure.readOnly && interpreter.replicaDriver_ && !interpreter.onReplica_ && !db->isInTransaction()) {
+            std::swap(db, interpreter.replicaDriver_);
+            interpreter.onReplica_ = replica_ = true;
+        }
+        try {
+            const bool inTransaction = db->isInTransaction();
+            if (!procedure.readOnly && inTransaction) {
+                savepoint_ = "trx_savepoint_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+                db->executeSql("SAVEPOINT " + savepoint_);
+            } else if (!procedure.readOnly) {
+                db->beginTransaction();
+                transaction_ = true;
+                interpreter.wrote_ = false;
+            } else if (!inTransaction && procedure.usesCursors) {
+                db->beginReadOnlyTransaction();
+                transaction_ = true;
+                interpreter.wrote_ = false;
+            }
+        } catch (...) {
+            leaveReplica();
+            throw;
+        }
+    }
+
+    ~RoutineScope() { leaveReplica(); }
+
+    RoutineScope(const RoutineScope &) = delete;
+    RoutineScope &operator=(const RoutineScope &) = delete;
+
+    void commit() {
+        interpreter_.syncSql();
+        if (!savepoint_.empty()) {
+            interpreter_.dbDriver_->executeSql("RELEASE SAVEPOINT " + savepoint_);
+        } else if (transaction_) {
+            interpreter_.dbDriver_->commitTransaction();
+            interpreter_.wrote_ = false;
+        }
+    }
+
+    void rollback() {
+        interpreter_.syncSql();
+        if (!savepoint_.empty()) {
+            interpreter_.dbDriver_->executeSql("ROLLBACK TO SAVEPOINT " + savepoint_);
+        } else if (transaction_) {
+            interpreter_.wrote_ = false;
+            try {
+                interpreter_.dbDriver_->rollbackTransaction();
+            } catch (...) {
+                // Ignore rollback errors
+            }
+        }
+    }
+
+private:
+    void leaveReplica() {
+        if (replica_) {
+            std::swap(interpreter_.dbDriver_, interpreter_.replicaDriver_);
+            interpreter_.onReplica_ = replica_ = false;
+        }
+    }
+
+    Interpreter &interpreter_;
+    std::string savepoint_;
+    bool transaction_{false};
+    bool replica_{false};
+};
+
 Interpreter::Interpreter(const trx::ast::Module &module, std::unique_ptr<DatabaseDriver> dbDriver)
     : module_{module}, dbDriver_{std::move(dbDriver)} {
     for (const auto &decl : module.declarations) {
@@ -1344,13 +2557,31 @@ Interpreter::Interpreter(const trx::ast::Module &module, std::unique_ptr<Databas
 
     dbDriver_->initialize();
 
-    // Resolve TYPE FROM TABLE declarations
+    // Resolve TYPE FROM TABLE declarations. With TRX_SCHEMA_CACHE set to a file, columns
+    // read under the database's current schema version come from there instead.
+    std::optional<SchemaCache> schemaCache;
+    const char *schemaCachePath = std::getenv("TRX_SCHEMA_CACHE");
     for (auto &decl : const_cast<trx::ast::Module&>(module_).declarations) {
         if (std::holds_alternative<ast::RecordDecl>(decl)) {
             auto &record = std::get<ast::RecordDecl>(decl);
             if (record.tableName && record.fields.empty()) {
+                if (schemaCachePath && *schemaCachePath) {
+                    // Drivers without a schema version are always asked for the columns
+                    if (auto version = dbDriver_->schemaVersion()) {
+                        schemaCache.emplace(schemaCachePath, std::move(*version));
+                    }
+                    schemaCachePath = nullptr;
+                }
                 // Resolve from database schema
-                auto columns = dbDriver_->getTableSchema(*record.tableName);
+                std::vector<TableColumn> columns;
+                if (const auto *cached = schemaCache ? schemaCache->find(*record.tableName) : nullptr) {
+                    columns = *cached;
+                } else {
+                    columns = dbDriver_->getTableSchema(*record.tableName);
+                    if (schemaCache) {
+                        schemaCache->store(*record.tableName, columns);
+                    }
+                }
                 for (const auto& col : columns) {
                     ast::RecordField field;
                     field.name = {.name = col.name, .location = record.name.location};
@@ -1366,6 +2597,53 @@ Interpreter::Interpreter(const trx::ast::Module &module, std::unique_ptr<Databas
             }
         }
     }
+    if (schemaCache && !schemaCache->save()) {
+        std::cerr << "Warning: could not write the schema cache to " << std::getenv("TRX_SCHEMA_CACHE") << "\n";
+    }
+
+    // Record layouts are final once table-backed types have their columns
+    for (const auto &[name, record] : records_) {
+        auto shape = std::make_shared<RecordShape>();
+        shape->name = name;
+        for (const auto &field : record->fields) {
+            shape->keys.push_back(toLowerCopy(field.name.name));
+        }
+        shapes_[name] = std::move(shape);
+    }
+    // Created before they are filled in so nested TYPEs can point at each other
+    std::unordered_map<std::string, std::shared_ptr<RecordLayout>> layouts;
+    for (const auto &[name, shape] : shapes_) {
+        layouts[name] = std::make_shared<RecordLayout>(RecordLayout{.shape = shape, .fields = {}});
+    }
+    for (const auto &[name, record] : records_) {
+        for (const auto &field : record->fields) {
+            layouts[name]->fields.push_back(layoutField(field, layouts));
+        }
+    }
+    layouts_.insert(layouts.begin(), layouts.end());
+    auto &resolved = const_cast<trx::ast::Module&>(module_);
+    const auto refuse = [](const std::vector<std::string> &errors) {
+        std::string message = errors.front();
+        for (std::size_t i = 1; i < errors.size(); ++i) {
+            message += "; " + errors[i];
+        }
+        throw std::runtime_error(message);
+    };
+    ast::resolveRecordFields(resolved);
+    if (const auto unknown = ast::resolveCalls(resolved); !unknown.empty()) {
+        refuse(unknown);
+    }
+    if (const auto mistyped = ast::checkTypes(resolved); !mistyped.empty()) {
+        refuse(mistyped);
+    }
+    ast::foldConstants(resolved, constantFolder());
+
+    // Compiled last so the bytecode sees bound calls and folded literals
+    for (const auto &decl : module_.declarations) {
+        if (const auto *proc = std::get_if<ast::ProcedureDecl>(&decl)) {
+            programs_[proc] = compileProcedure(*proc);
+        }
+    }
 
     // Execute global statements (variable declarations and function calls)
     ExecutionContext globalContext{*this, {}, false, std::nullopt, true, false, std::nullopt};
@@ -1380,8 +2658,9 @@ Interpreter::Interpreter(const trx::ast::Module &module, std::unique_ptr<Databas
             // Handle table declarations if needed
         } else if (std::holds_alternative<ast::RecordDecl>(decl)) {
             // Handle record declarations if needed
-        } else if (std::holds_alternative<ast::ConstantDecl>(decl)) {
-            // Handle constant declarations if needed
+        } else if (const auto *constant = std::get_if<ast::ConstantDecl>(&decl)) {
+            // Reads foldConstants() could not inline find the value here
+            globalVariables_[toLowerCopy(constant->name.name)] = std::visit([](const auto &value) { return JsonValue(value); }, constant->value);
         } else if (std::holds_alternative<ast::IncludeDecl>(decl)) {
             // Handle include declarations if needed
         } else if (std::holds_alternative<ast::ExternalProcedureDecl>(decl)) {
@@ -1390,8 +2669,109 @@ Interpreter::Interpreter(const trx::ast::Module &module, std::unique_ptr<Databas
     }
 }
 
+Interpreter::Interpreter(const Interpreter &prototype, std::unique_ptr<DatabaseDriver> dbDriver)
+    : module_{prototype.module_},
+      routines_{prototype.routines_},
+      records_{prototype.records_},
+      shapes_{prototype.shapes_},
+      layouts_{prototype.layouts_},
+      programs_{prototype.programs_},
+      nativeLibrary_{prototype.nativeLibrary_},
+      natives_{prototype.natives_},
+      globalVariables_{prototype.globalVariables_},
+      dbDriver_{std::move(dbDriver)},
+      jobQueue_{prototype.jobQueue_} {
+    if (!dbDriver_) {
+        throw std::runtime_error("A database driver is required for a forked interpreter");
+    }
+    dbDriver_->initialize();
+}
+
 Interpreter::~Interpreter() = default;
 
+void Interpreter::syncSql() {
+    if (!queuedDriver_) {
+        return;
+    }
+    auto *driver = std::exchange(queuedDriver_, nullptr);
+    const bool waiting = std::exchange(sqlCodeQueued_, false);
+    bool succeeded = false;
+    try {
+        succeeded = driver->syncQueued();
+    } catch (const std::exception &) {
+        // A connection lost with statements in flight fails the last of them
+    }
+    if (waiting) {
+        sqlCode_ = succeeded ? 0.0 : -1.0;
+    }
+}
+
+std::unique_ptr<Interpreter> Interpreter::fork(std::unique_ptr<DatabaseDriver> dbDriver) const {
+    return std::unique_ptr<Interpreter>(new Interpreter(*this, std::move(dbDriver)));
+}
+
+void Interpreter::setReplicaDriver(std::unique_ptr<DatabaseDriver> driver) {
+    if (driver) {
+        driver->initialize();
+        driver->setDeadline(deadline_);
+    }
+    replicaDriver_ = std::move(driver);
+}
+
+void Interpreter::setDeadline(const Deadline &deadline) {
+    if (deadline == deadline_) {
+        return;
+    }
+    deadline_ = deadline;
+    dbDriver_->setDeadline(deadline_);
+    if (replicaDriver_) {
+        replicaDriver_->setDeadline(deadline_);
+    }
+}
+
+std::shared_ptr<const RecordLayout> Interpreter::recordLayout(const std::string &name) const {
+    auto it = layouts_.find(name);
+    return it != layouts_.end() ? it->second : nullptr;
+}
+
+const Program *Interpreter::programFor(const ast::ProcedureDecl *procedure) const {
+    const auto it = programs_.find(procedure);
+    return it != programs_.end() ? it->second.get() : nullptr;
+}
+
+std::vector<std::string> Interpreter::setNativeLibrary(std::shared_ptr<const NativeLibrary> library) {
+    natives_.clear();
+    nativeLibrary_ = std::move(library);
+    std::vector<std::string> interpreted;
+    if (!nativeLibrary_) {
+        return interpreted;
+    }
+    // A routine changed since the library was compiled has different bytecode, whose
+    // pools the compiled code would misread: it keeps running on the interpreter
+    for (const auto &decl : module_.declarations) {
+        const auto *proc = std::get_if<ast::ProcedureDecl>(&decl);
+        if (!proc) {
+            continue;
+        }
+        const auto *program = programFor(proc);
+        const auto *routine = nativeLibrary_->find(proc->name.baseName);
+        if (program && routine && routine->fingerprint == fingerprint(*program)) {
+            natives_[proc] = routine;
+        } else {
+            interpreted.push_back(proc->name.baseName);
+        }
+    }
+    return interpreted;
+}
+
+const native::Routine *Interpreter::nativeRoutine(const ast::ProcedureDecl *procedure) const {
+    if (natives_.empty()) {
+        return nullptr;
+    }
+    const auto it = natives_.find(procedure);
+    return it != natives_.end() ? it->second : nullptr;
+}
+
 const trx::ast::ProcedureDecl* Interpreter::getRoutine(const std::string &name) const {
     auto it = routines_.find(name);
     return it != routines_.end() ? it->second : nullptr;
@@ -1402,11 +2782,16 @@ const trx::ast::RecordDecl* Interpreter::getRecord(const std::string &name) cons
     return it != records_.end() ? it->second : nullptr;
 }
 
-std::optional<JsonValue> Interpreter::execute(const std::string &procedureName, const JsonValue &input) {
-    return execute(procedureName, input, {});
+std::shared_ptr<const RecordShape> Interpreter::recordShape(const std::string &name) const {
+    auto it = shapes_.find(name);
+    return it != shapes_.end() ? it->second : nullptr;
 }
 
-std::optional<JsonValue> Interpreter::execute(const std::string &procedureName, const JsonValue &input, const std::map<std::string, std::string> &pathParams) {
+std::optional<JsonValue> Interpreter::execute(const std::string &procedureName, JsonValue input) {
+    return execute(procedureName, std::move(input), {});
+}
+
+std::optional<JsonValue> Interpreter::execute(const std::string &procedureName, JsonValue input, const std::map<std::string, std::string> &pathParams) {
     // std::cout << "DEBUG execute: Executing procedure '" << procedureName << "' with " << pathParams.size() << " path parameters" << std::endl;
     // for (const auto& [key, value] : pathParams) {
     //     std::cout << "DEBUG execute: Path param '" << key << "' = '" << value << "'" << std::endl;
@@ -1414,21 +2799,12 @@ std::optional<JsonValue> Interpreter::execute(const std::string &procedureName,
     if (procedureName.empty()) {
         // Execute module statements
         ExecutionContext ctx{*this, {}, false, {}, false, true, "JSON"};
-        try {
-            for (const auto &stmt : module_.statements) {
-                executeStatement(stmt, ctx);
-                if (ctx.returned) break;
-            }
-        } catch (const ReturnException &e) {
-            if (ctx.isFunction) {
-                ctx.returnValue = e.value;
-                ctx.returned = true;
-            } else {
-                throw TrxException("Procedures cannot return values. Use RETURN without a value.");
-            }
+        const auto completion = executeStatements(module_.statements, ctx);
+        if (completion == Completion::Thrown) {
+            throw std::move(*ctx.thrown);
         }
-        if (ctx.returned) {
-            return ctx.returnValue;
+        if (completion == Completion::Returned) {
+            return std::move(ctx.returnValue);
         }
         return {};
     }
@@ -1437,23 +2813,19 @@ std::optional<JsonValue> Interpreter::execute(const std::string &procedureName,
         throw TrxException("Procedure not found: " + procedureName);
     }
     const auto *procedure = it->second;
-
-    // Check if we're already in a transaction
-    bool alreadyInTransaction = dbDriver_->isInTransaction();
-    std::string savepointName;
-    
-    if (alreadyInTransaction) {
-        // Use a savepoint for nested transaction
-        savepointName = "trx_savepoint_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
-        dbDriver_->executeSql("SAVEPOINT " + savepointName);
-    } else {
-        // Begin a new transaction
-        dbDriver_->beginTransaction();
+    if (procedure->emits && !emitSink_) {
+        return execute(procedure, std::move(input), pathParams);
     }
 
+    Profiler::Scope frame(profiler_, procedure->name.baseName);
+    Span span(tracer_, traceContext_, procedure->name.baseName);
+    RoutineDeadline deadline(*this, *procedure);
+    RoutineScope scope(*this, *procedure);
+
     // Create execution context
     ExecutionContext context{*this, {}, false, std::nullopt, false, false, std::nullopt};
     context.isFunction = procedure->isFunction;
+    enterFrame(context, *procedure);
 
     // Automatically instantiate path parameters as local variables
     for (size_t i = 0; i < procedure->name.pathParameters.size(); ++i) {
@@ -1471,11 +2843,7 @@ std::optional<JsonValue> Interpreter::execute(const std::string &procedureName,
             
             // Convert string value to appropriate type based on parameter type
             if (paramType == "INTEGER") {
-                try {
-                    paramValue = JsonValue(std::stoi(valueStr));
-                } catch (...) {
-                    paramValue = JsonValue(0); // Default to 0 on conversion error
-                }
+                paramValue = integerParameter(valueStr);
             } else if (paramType == "DECIMAL" || paramType == "DOUBLE") {
                 try {
                     paramValue = JsonValue(std::stod(valueStr));
@@ -1493,17 +2861,12 @@ std::optional<JsonValue> Interpreter::execute(const std::string &procedureName,
                 // std::cout << "DEBUG execute: Using as string: '" << std::get<std::string>(paramValue.data) << "'" << std::endl;
             }
             
-            context.variables[paramName] = paramValue;
+            bindLocal(context, paramDecl.slot, paramName) = paramValue;
         } else {
             // std::cout << "DEBUG execute: Path parameter '" << paramName << "' not found in pathParams" << std::endl;
         }
     }
     
-    // Set the input parameter as a local variable
-    if (procedure->input) {
-        context.variables[procedure->input->name.name] = input;
-    }
-    
     // Bind path parameters to explicit function parameters
     if (procedure->input && !pathParams.empty()) {
         // For functions with path parameters, bind path params to explicit params
@@ -1516,94 +2879,73 @@ std::optional<JsonValue> Interpreter::execute(const std::string &procedureName,
         }
         
         // Copy any body parameters
-        if (std::holds_alternative<JsonValue::Object>(input.data)) {
-            const auto &inputObj = std::get<JsonValue::Object>(input.data);
-            for (const auto &[key, value] : inputObj) {
-                obj[key] = value;
-            }
-        }
+        input.forEachField([&](const std::string &key, const JsonValue &value) { obj[key] = value; });
         
-        context.variables[procedure->input->name.name] = paramInput;
+        bindLocal(context, procedure->input->slot, procedure->input->name.name) = std::move(paramInput);
     } else if (procedure->input) {
         // For functions without path parameters, use the input as-is
-        context.variables[procedure->input->name.name] = input;
+        bindLocal(context, procedure->input->slot, procedure->input->name.name) = std::move(input);
     }
 
     try {
-        executeStatements(procedure->body, context);
+        const auto completion = runBody(*procedure, programFor(procedure), context);
+        // An uncaught THROW leaves as an exception so the catch below rolls back
+        if (completion == Completion::Thrown) {
+            throw std::move(*context.thrown);
+        }
         // For functions, execution without return is an error
-        if (procedure->output) {
+        if (completion == Completion::Normal && procedure->output) {
             throw std::runtime_error("Function must return a value");
         }
-        // Commit on successful completion
-        if (alreadyInTransaction) {
-            dbDriver_->executeSql("RELEASE SAVEPOINT " + savepointName);
-        } else {
-            dbDriver_->commitTransaction();
-        }
-    } catch (const ReturnException &ret) {
-        // For functions, return the value
-        if (procedure->output) {
-            // The return validation is already done in executeReturn
-            // Commit on successful completion (even with return)
-            if (alreadyInTransaction) {
-                dbDriver_->executeSql("RELEASE SAVEPOINT " + savepointName);
-            } else {
-                dbDriver_->commitTransaction();
-            }
-            return ret.value;
-        } else {
+        // Commit on successful completion, unless the caller has stopped waiting for it
+        checkDeadline();
+        scope.commit();
+        if (completion == Completion::Returned) {
             // For procedures, RETURN just ends execution (no value returned)
-            if (alreadyInTransaction) {
-                dbDriver_->executeSql("RELEASE SAVEPOINT " + savepointName);
-            } else {
-                dbDriver_->commitTransaction();
-            }
-            return std::nullopt;  // Procedures don't return values
+            return procedure->output ? std::optional<JsonValue>(std::move(context.returnValue)) : std::nullopt;
         }
     } catch (...) {
         // Rollback on any exception
-        if (alreadyInTransaction) {
-            dbDriver_->executeSql("ROLLBACK TO SAVEPOINT " + savepointName);
-        } else {
-            try {
-                dbDriver_->rollbackTransaction();
-            } catch (...) {
-                // Ignore rollback errors
-            }
-        }
+        scope.rollback();
         throw;
     }
 
-    if (procedure->output || context.variables.count("output")) {
-        const auto outIt = context.variables.find("output");
-        if (outIt == context.variables.end()) {
+    auto *output = findLocal(context, trx::ast::unresolvedSlot, "output");
+    if (procedure->output || output) {
+        if (!output) {
             throw std::runtime_error("Function execution did not produce output");
         }
-        return outIt->second;
+        return std::move(*output);
     } else {
         return std::nullopt;
     }
 }
 
-std::optional<JsonValue> Interpreter::execute(const ast::ProcedureDecl *procedure, const JsonValue &input, const std::map<std::string, std::string> &pathParams) {
-    // Check if we're already in a transaction
-    bool alreadyInTransaction = dbDriver_->isInTransaction();
-    std::string savepointName;
-    
-    if (alreadyInTransaction) {
-        // Use a savepoint for nested transaction
-        savepointName = "trx_savepoint_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
-        dbDriver_->executeSql("SAVEPOINT " + savepointName);
-    } else {
-        // Begin a new transaction
-        dbDriver_->beginTransaction();
+std::optional<JsonValue> Interpreter::execute(const ast::ProcedureDecl *procedure, JsonValue input, const std::map<std::string, std::string> &pathParams) {
+    // With nowhere to stream to, an emitting routine answers with everything it emitted
+    if (procedure->emits && !emitSink_) {
+        JsonValue::Array emitted;
+        emitSink_ = [&emitted](const JsonValue &value) { emitted.push_back(value); };
+        try {
+            execute(procedure, std::move(input), pathParams);
+        } catch (...) {
+            emitSink_ = nullptr;
+            throw;
+        }
+        emitSink_ = nullptr;
+        return JsonValue(std::move(emitted));
     }
 
+    Profiler::Scope frame(profiler_, procedure->name.baseName);
+    Span span(tracer_, traceContext_, procedure->name.baseName);
+    RoutineDeadline deadline(*this, *procedure);
+    RoutineScope scope(*this, *procedure);
+
     try {
         // Create execution context
         ExecutionContext context{*this, {}, false, std::nullopt, false, false, std::nullopt};
         context.isFunction = procedure->isFunction;
+        enterFrame(context, *procedure);
         
         // Automatically instantiate path parameters as local variables
         for (size_t i = 0; i < procedure->name.pathParameters.size(); ++i) {
@@ -1619,11 +2961,7 @@ std::optional<JsonValue> Interpreter::execute(const ast::ProcedureDecl *procedur
                 
                 // Convert string value to appropriate type based on parameter type
                 if (paramType == "INTEGER") {
-                    try {
-                        paramValue = JsonValue(std::stoi(valueStr));
-                    } catch (...) {
-                        paramValue = JsonValue(0); // Default to 0 on conversion error
-                    }
+                    paramValue = integerParameter(valueStr);
                 } else if (paramType == "DECIMAL" || paramType == "DOUBLE") {
                     try {
                         paramValue = JsonValue(std::stod(valueStr));
@@ -1637,71 +2975,44 @@ std::optional<JsonValue> Interpreter::execute(const ast::ProcedureDecl *procedur
                     paramValue = JsonValue(valueStr);
                 }
                 
-                context.variables[paramName] = paramValue;
+                bindLocal(context, paramDecl.slot, paramName) = paramValue;
             }
         }
         
         // Bind input parameters
         if (procedure->input) {
-            if (!std::holds_alternative<JsonValue::Object>(input.data)) {
+            if (!input.isObject()) {
                 throw std::runtime_error("Input must be a JSON object");
             }
-            context.variables[procedure->input->name.name] = input;
+            bindLocal(context, procedure->input->slot, procedure->input->name.name) = std::move(input);
         }
         
         // Execute the procedure body
-        for (const auto &stmt : procedure->body) {
-            executeStatement(stmt, context);
-            if (context.returned) {
-                break;
-            }
-        }
+        const auto completion = runBody(*procedure, programFor(procedure), context);
         
-        if (procedure->output) {
+        // An uncaught THROW leaves as an exception so the catch below rolls back
+        if (completion == Completion::Thrown) {
+            throw std::move(*context.thrown);
+        }
+        // For functions, execution without return is an error
+        if (completion == Completion::Normal && procedure->output) {
             throw std::runtime_error("Function must return a value");
         }
-        // Commit on successful completion
-        if (alreadyInTransaction) {
-            dbDriver_->executeSql("RELEASE SAVEPOINT " + savepointName);
-        } else {
-            dbDriver_->commitTransaction();
-        }
-    } catch (const ReturnException &ret) {
-        // For functions, return the value
-        if (procedure->output) {
-            // The return validation is already done in executeReturn
-            // Commit on successful completion (even with return)
-            if (alreadyInTransaction) {
-                dbDriver_->executeSql("RELEASE SAVEPOINT " + savepointName);
-            } else {
-                dbDriver_->commitTransaction();
-            }
-            return ret.value;
-        } else {
+        // Commit on successful completion, unless the caller has stopped waiting for it
+        checkDeadline();
+        scope.commit();
+        if (completion == Completion::Returned) {
             // For procedures, RETURN just ends execution (no value returned)
-            if (alreadyInTransaction) {
-                dbDriver_->executeSql("RELEASE SAVEPOINT " + savepointName);
-            } else {
-                dbDriver_->commitTransaction();
-            }
-            return std::nullopt;  // Procedures don't return values
+            return procedure->output ? std::optional<JsonValue>(std::move(context.returnValue)) : std::nullopt;
         }
     } catch (...) {
         // Rollback on any exception
-        if (alreadyInTransaction) {
-            dbDriver_->executeSql("ROLLBACK TO SAVEPOINT " + savepointName);
-        } else {
-            try {
-                dbDriver_->rollbackTransaction();
-            } catch (...) {
-                // Ignore rollback errors
-            }
-        }
+        scope.rollback();
         throw;
     }
 
     if (procedure->output) {
-        // This should not happen - functions should return via ReturnException
+        // This should not happen - a function body completes Returned or throws
         throw std::runtime_error("Function did not return a value");
     }
     return std::nullopt;
@@ -0,0 +1,320 @@
+#include "trx/runtime/JobQueue.h"
+
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/JsonWriter.h"
+#include "trx/runtime/Logger.h"
+#include "trx/runtime/TrxException.h"
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <random>
+#include <stdexcept>
+
+namespace trx::runtime {
+
+namespace {
+
+// Due jobs a worker reads at once; it claims the first one nobody else took
+constexpr int claimCandidates = 8;
+
+std::int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string randomId() {
+    thread_local std::mt19937_64 engine{[] {
+        std::random_device device;
+        return (static_cast<std::uint64_t>(device()) << 32) ^ device() ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+    }()};
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string id(32, '0');
+    for (std::size_t i = 0; i < id.size(); i += 16) {
+        auto bits = engine();
+        for (std::size_t j = 0; j < 16; ++j, bits >>= 4) {
+            id[i + j] = digits[bits & 0xf];
+        }
+    }
+    return id;
+}
+
+SqlParameter param(const char *name, JsonValue value) {
+    return {name, std::move(value)};
+}
+
+SqlParameter param(const char *name, std::int64_t value) {
+    return {name, JsonValue(static_cast<double>(value))};
+}
+
+// Drivers return integers as numbers or, without type information, as text
+std::int64_t toInteger(const JsonValue &value) {
+    if (value.isNumber()) {
+        return static_cast<std::int64_t>(value.asNumber());
+    }
+    std::int64_t result = 0;
+    if (value.isString()) {
+        const auto &text = value.asString();
+        std::from_chars(text.data(), text.data() + text.size(), result);
+    }
+    return result;
+}
+
+std::string toText(const JsonValue &value) {
+    return value.isString() ? value.asString() : std::string{};
+}
+
+JsonValue parseStored(const JsonValue &value) {
+    if (!value.isString() || value.asString().empty()) {
+        return JsonValue();
+    }
+    try {
+        return JsonParser(value.asString()).parse();
+    } catch (const std::exception &) {
+        return value; // not JSON after all; hand back the text
+    }
+}
+
+} // namespace
+
+JsonValue JobStatus::toJson() const {
+    JsonValue::Object object;
+    object["id"] = JsonValue(id);
+    object["routine"] = JsonValue(routine);
+    object["status"] = JsonValue(state);
+    object["attempts"] = JsonValue(static_cast<double>(attempts));
+    object["argument"] = argument;
+    object["result"] = result;
+    object["error"] = lastError.empty() ? JsonValue() : JsonValue(lastError);
+    object["createdAt"] = JsonValue(static_cast<double>(createdAt));
+    object["updatedAt"] = JsonValue(static_cast<double>(updatedAt));
+    object["runAfter"] = JsonValue(static_cast<double>(runAfter));
+    return JsonValue(std::move(object));
+}
+
+JobQueue::JobQueue(JobQueueOptions options, DriverFactory makeDriver)
+    : options_{std::move(options)}, makeDriver_{std::move(makeDriver)}, runTimes_{1, std::max<std::size_t>(1, options_.workers) + 1} {
+    options_.maxAttempts = std::max(1, options_.maxAttempts);
+}
+
+JobQueue::~JobQueue() {
+    stop();
+}
+
+void JobQueue::createTable(DatabaseDriver &db) {
+    if (!db.getTableSchema("trx_jobs").empty()) {
+        return;
+    }
+    try {
+        db.executeSql("CREATE TABLE trx_jobs (id VARCHAR(32) NOT NULL PRIMARY KEY, routine VARCHAR(255) NOT NULL, argument TEXT, "
+                      "status VARCHAR(16) NOT NULL, attempts INTEGER NOT NULL, run_after BIGINT NOT NULL, lease_until BIGINT, "
+                      "owner VARCHAR(32), last_error TEXT, result TEXT, created_at BIGINT NOT NULL, updated_at BIGINT NOT NULL)");
+        db.executeSql("CREATE INDEX trx_jobs_due ON trx_jobs (status, run_after)");
+    } catch (const std::exception &) {
+        // Another process may have created it in the meantime
+        if (db.getTableSchema("trx_jobs").empty()) {
+            throw;
+        }
+    }
+}
+
+void JobQueue::start(Runner runner) {
+    runner_ = std::move(runner);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+    for (std::size_t i = 0; i < options_.workers; ++i) {
+        workers_.emplace_back([this, i] { work(i); });
+    }
+}
+
+void JobQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+std::string JobQueue::enqueue(DatabaseDriver &db, const std::string &routine, const JsonValue &argument) {
+    if (options_.maxPending > 0) {
+        const auto pending = db.queryFirstRow("SELECT COUNT(*) FROM trx_jobs WHERE status IN ('queued', 'running')");
+        if (pending && !pending->empty() && toInteger(pending->front()) >= static_cast<std::int64_t>(options_.maxPending)) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            throw std::runtime_error("Job queue is full: " + std::to_string(options_.maxPending) + " jobs are waiting");
+        }
+    }
+
+    auto id = randomId();
+    const auto now = nowMillis();
+    db.executeSql("INSERT INTO trx_jobs (id, routine, argument, status, attempts, run_after, created_at, updated_at) "
+                  "VALUES (?, ?, ?, 'queued', 0, ?, ?, ?)",
+                  {param("id", JsonValue(id)), param("routine", JsonValue(routine)), param("argument", JsonValue(JsonWriter::toString(argument))),
+                   param("run_after", now), param("created_at", now), param("updated_at", now)});
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+    // The row may not be committed yet; a worker that misses it finds it on its next poll
+    wake_.notify_one();
+    return id;
+}
+
+std::optional<JobStatus> JobQueue::status(const std::string &id) {
+    auto db = makeDriver_();
+    db->initialize();
+    const auto row = db->queryFirstRow("SELECT id, routine, status, attempts, argument, result, last_error, created_at, updated_at, run_after "
+                                       "FROM trx_jobs WHERE id = ?",
+                                       {param("id", JsonValue(id))});
+    if (!row || row->size() < 10) {
+        return std::nullopt;
+    }
+    const auto &columns = *row;
+    JobStatus status;
+    status.id = toText(columns[0]);
+    status.routine = toText(columns[1]);
+    status.state = toText(columns[2]);
+    status.attempts = static_cast<int>(toInteger(columns[3]));
+    status.argument = parseStored(columns[4]);
+    status.result = parseStored(columns[5]);
+    status.lastError = toText(columns[6]);
+    status.createdAt = toInteger(columns[7]);
+    status.updatedAt = toInteger(columns[8]);
+    status.runAfter = toInteger(columns[9]);
+    return status;
+}
+
+JobQueue::Stats JobQueue::stats() const {
+    Stats stats;
+    stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.succeeded = succeeded_.load(std::memory_order_relaxed);
+    stats.retried = retried_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    stats.running = running_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::chrono::milliseconds JobQueue::retryDelay(int attempts) const {
+    auto delay = options_.retryDelay;
+    for (int i = 1; i < attempts && delay < options_.maxRetryDelay; ++i) {
+        delay *= 2;
+    }
+    return std::min(delay, options_.maxRetryDelay);
+}
+
+void JobQueue::work(std::size_t worker) {
+    std::unique_ptr<DatabaseDriver> db;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+        }
+
+        std::optional<Claim> job;
+        try {
+            if (!db) {
+                db = makeDriver_();
+                db->initialize();
+            }
+            job = claim(*db);
+        } catch (const std::exception &error) {
+            logError("Job queue worker could not read the job table", {{"worker", worker}, {"error", error.what()}});
+            db.reset(); // reconnect on the next round
+        }
+
+        if (!job) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, options_.pollInterval, [this] { return stopping_; });
+            continue;
+        }
+
+        running_.fetch_add(1, std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        std::optional<JsonValue> result;
+        std::string error;
+        try {
+            result = runner_(worker, job->routine, job->argument);
+        } catch (const TrxThrowException &thrown) {
+            // What the routine threw
+            const auto &value = thrown.getThrownValue();
+            error = value.isString() ? value.asString() : JsonWriter::toString(value);
+        } catch (const std::exception &failure) {
+            error = failure.what();
+        } catch (...) {
+            error = "unknown error";
+        }
+        runTimes_.observe(worker, 0, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        running_.fetch_sub(1, std::memory_order_relaxed);
+
+        try {
+            finish(*db, *job, result, error);
+        } catch (const std::exception &failure) {
+            // The lease runs out and another worker runs the job again
+            logError("Job queue worker could not record a job's outcome", {{"job", job->id}, {"error", failure.what()}});
+            db.reset();
+        }
+    }
+}
+
+std::optional<JobQueue::Claim> JobQueue::claim(DatabaseDriver &db) {
+    const auto now = nowMillis();
+    std::vector<std::vector<SqlValue>> candidates;
+    db.queryRows("SELECT id, routine, argument, attempts FROM trx_jobs "
+                 "WHERE (status = 'queued' AND run_after <= ?) OR (status = 'running' AND lease_until < ?) ORDER BY run_after",
+                 {param("now", now), param("expired", now)}, [&candidates](const std::vector<SqlValue> &row) {
+                     candidates.push_back(row);
+                     return candidates.size() < claimCandidates;
+                 });
+
+    for (const auto &row : candidates) {
+        Claim job;
+        job.id = toText(row[0]);
+        job.owner = randomId();
+        // Only one claimant's UPDATE still finds the job due; the others change nothing
+        db.executeSql("UPDATE trx_jobs SET status = 'running', owner = ?, lease_until = ?, attempts = attempts + 1, updated_at = ? "
+                      "WHERE id = ? AND ((status = 'queued' AND run_after <= ?) OR (status = 'running' AND lease_until < ?))",
+                      {param("owner", JsonValue(job.owner)), param("lease_until", now + options_.lease.count()), param("updated_at", now),
+                       param("id", JsonValue(job.id)), param("now", now), param("expired", now)});
+        const auto owner = db.queryFirstRow("SELECT owner, attempts FROM trx_jobs WHERE id = ?", {param("id", JsonValue(job.id))});
+        if (!owner || toText((*owner)[0]) != job.owner) {
+            continue;
+        }
+        job.routine = toText(row[1]);
+        job.argument = parseStored(row[2]);
+        job.attempts = static_cast<int>(toInteger((*owner)[1]));
+        return job;
+    }
+    return std::nullopt;
+}
+
+void JobQueue::finish(DatabaseDriver &db, const Claim &job, const std::optional<JsonValue> &result, const std::string &error) {
+    const auto now = nowMillis();
+    // A worker whose lease ran out no longer owns the job and leaves it to the one that took over
+    if (result) {
+        db.executeSql("UPDATE trx_jobs SET status = 'succeeded', result = ?, last_error = NULL, lease_until = NULL, updated_at = ? "
+                      "WHERE id = ? AND owner = ?",
+                      {param("result", JsonValue(JsonWriter::toString(*result))), param("updated_at", now), param("id", JsonValue(job.id)),
+                       param("owner", JsonValue(job.owner))});
+        succeeded_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (job.attempts < options_.maxAttempts) {
+        const auto delay = retryDelay(job.attempts);
+        db.executeSql("UPDATE trx_jobs SET status = 'queued', last_error = ?, run_after = ?, lease_until = NULL, updated_at = ? "
+                      "WHERE id = ? AND owner = ?",
+                      {param("last_error", JsonValue(error)), param("run_after", now + delay.count()), param("updated_at", now),
+                       param("id", JsonValue(job.id)), param("owner", JsonValue(job.owner))});
+        retried_.fetch_add(1, std::memory_order_relaxed);
+        logWarn("Job failed; retrying", {{"job", job.id}, {"routine", job.routine}, {"attempt", job.attempts}, {"error", error}});
+        return;
+    }
+    db.executeSql("UPDATE trx_jobs SET status = 'failed', last_error = ?, lease_until = NULL, updated_at = ? WHERE id = ? AND owner = ?",
+                  {param("last_error", JsonValue(error)), param("updated_at", now), param("id", JsonValue(job.id)),
+                   param("owner", JsonValue(job.owner))});
+    failed_.fetch_add(1, std::memory_order_relaxed);
+    logError("Job failed", {{"job", job.id}, {"routine", job.routine}, {"attempts", job.attempts}, {"error", error}});
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,586 @@
+#include "trx/runtime/JsonParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace trx::runtime {
+
+namespace {
+
+// Deeper payloads are rejected before they can exhaust the stack
+constexpr std::size_t maxDepth = 512;
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// First '"' or '\\' in [p, end), or end
+const char *findQuoteOrEscape(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+// First byte in [p, end) that is not JSON whitespace, or end
+const char *findNonSpace(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - p >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                                           _mm_or_si128(_mm_cmpeq_epi8(chunk, carriageReturn), _mm_cmpeq_epi8(chunk, tab)));
+        const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(blank)) & 0xFFFFu;
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && isSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+bool equalsLowercase(std::string_view key, const std::string &lowercase) {
+    return key.size() == lowercase.size() &&
+           std::equal(key.begin(), key.end(), lowercase.begin(),
+                      [](char a, char b) { return static_cast<char>(std::tolower(static_cast<unsigned char>(a))) == b; });
+}
+
+void appendCodepoint(std::string &output, unsigned int codepoint) {
+    if (codepoint <= 0x7F) {
+        output.push_back(static_cast<char>(codepoint));
+    } else if (codepoint <= 0x7FF) {
+        output.push_back(static_cast<char>(0xC0 | ((codepoint >> 6) & 0x1F)));
+        output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint <= 0xFFFF) {
+        output.push_back(static_cast<char>(0xE0 | ((codepoint >> 12) & 0x0F)));
+        output.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        output.push_back(static_cast<char>(0xF0 | ((codepoint >> 18) & 0x07)));
+        output.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+} // namespace
+
+// Where a record field sits in the payload, kept on the stack and only spelled out for errors
+struct JsonParser::Path {
+    const Path *parent;
+    std::string_view key; // empty for a list item
+    std::size_t index;
+
+    std::string describe() const {
+        std::string prefix = parent ? parent->describe() : std::string{};
+        if (key.empty()) {
+            return prefix + "[" + std::to_string(index) + "]";
+        }
+        return prefix.empty() ? std::string(key) : prefix + "." + std::string(key);
+    }
+};
+
+JsonParser::JsonParser(std::string_view text, std::pmr::memory_resource *resource)
+    : position_{text.data()}, end_{text.data() + text.size()}, resource_{resource} {}
+
+JsonValue JsonParser::parse() {
+    skipWhitespace();
+    auto value = parseValue(0);
+    skipWhitespace();
+    if (position_ != end_) {
+        throw JsonParseError("Unexpected trailing data in JSON payload");
+    }
+    return value;
+}
+
+JsonValue JsonParser::parse(const RecordLayout &layout) {
+    skipWhitespace();
+    if (peek() != '{') {
+        throw JsonParseError("Request payload must be a JSON object");
+    }
+    auto value = parseRecord(layout, nullptr, 0);
+    skipWhitespace();
+    if (position_ != end_) {
+        throw JsonParseError("Unexpected trailing data in JSON payload");
+    }
+    return value;
+}
+
+char JsonParser::peek() const {
+    return position_ < end_ ? *position_ : '\0';
+}
+
+void JsonParser::expect(char expected) {
+    if (position_ == end_) {
+        throw JsonParseError("Unexpected end of JSON payload");
+    }
+    if (*position_++ != expected) {
+        throw JsonParseError("Unexpected character in JSON payload");
+    }
+}
+
+void JsonParser::skipWhitespace() {
+    // Tokens are mostly adjacent or one space apart; only longer runs are worth a vector scan
+    if (position_ < end_ && isSpace(*position_)) {
+        position_ = findNonSpace(position_ + 1, end_);
+    }
+}
+
+bool JsonParser::consumeLiteral(std::string_view literal) {
+    if (static_cast<std::size_t>(end_ - position_) < literal.size() || std::string_view(position_, literal.size()) != literal) {
+        return false;
+    }
+    position_ += literal.size();
+    return true;
+}
+
+JsonValue JsonParser::parseValue(std::size_t depth) {
+    if (position_ == end_) {
+        throw JsonParseError("Unexpected end of JSON payload");
+    }
+    const char c = *position_;
+    if (c == '"') {
+        return JsonValue(parseString());
+    }
+    if (c == '{') {
+        return parseObject(depth + 1);
+    }
+    if (c == '[') {
+        return parseArray(depth + 1);
+    }
+    if (consumeLiteral("true")) {
+        return JsonValue(true);
+    }
+    if (consumeLiteral("false")) {
+        return JsonValue(false);
+    }
+    if (consumeLiteral("null")) {
+        return JsonValue();
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        return parseNumber();
+    }
+    throw JsonParseError("Unsupported JSON token encountered");
+}
+
+JsonValue JsonParser::parseObject(std::size_t depth) {
+    if (depth > maxDepth) {
+        throw JsonParseError("JSON payload is nested too deeply");
+    }
+    expect('{');
+    JsonValue::Object object(resource_);
+    skipWhitespace();
+    if (peek() == '}') {
+        ++position_;
+        return JsonValue(std::move(object));
+    }
+    std::string scratch;
+    while (true) {
+        skipWhitespace();
+        if (peek() != '"') {
+            throw JsonParseError("Object keys must be strings");
+        }
+        std::string key(parseKey(scratch));
+        // Convert key to lowercase for case-insensitive matching
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        skipWhitespace();
+        expect(':');
+        skipWhitespace();
+        object.insert_or_assign(std::move(key), parseValue(depth));
+        skipWhitespace();
+        if (position_ == end_) {
+            throw JsonParseError("Unexpected end of JSON payload");
+        }
+        const char delimiter = *position_++;
+        if (delimiter == '}') {
+            break;
+        }
+        if (delimiter != ',') {
+            throw JsonParseError("Expected comma in object literal");
+        }
+    }
+    return JsonValue(std::move(object));
+}
+
+JsonValue JsonParser::parseArray(std::size_t depth) {
+    if (depth > maxDepth) {
+        throw JsonParseError("JSON payload is nested too deeply");
+    }
+    expect('[');
+    JsonValue::Array array(resource_);
+    skipWhitespace();
+    if (peek() == ']') {
+        ++position_;
+        return JsonValue(std::move(array));
+    }
+    while (true) {
+        skipWhitespace();
+        array.push_back(parseValue(depth));
+        skipWhitespace();
+        if (position_ == end_) {
+            throw JsonParseError("Unexpected end of JSON payload");
+        }
+        const char delimiter = *position_++;
+        if (delimiter == ']') {
+            break;
+        }
+        if (delimiter != ',') {
+            throw JsonParseError("Expected comma in array literal");
+        }
+    }
+    return JsonValue(std::move(array));
+}
+
+JsonValue JsonParser::parseRecord(const RecordLayout &layout, const Path *path, std::size_t depth) {
+    if (depth > maxDepth) {
+        throw JsonParseError("JSON payload is nested too deeply");
+    }
+    expect('{');
+    JsonValue value = JsonValue::record(layout.shape);
+    auto &fields = std::get<JsonValue::Record>(value.data).fields;
+    skipWhitespace();
+    if (peek() == '}') {
+        ++position_;
+        return value;
+    }
+    std::string scratch;
+    std::size_t next = 0; // fields usually arrive in declaration order
+    while (true) {
+        skipWhitespace();
+        if (peek() != '"') {
+            throw JsonParseError("Object keys must be strings");
+        }
+        const std::string_view key = parseKey(scratch);
+        skipWhitespace();
+        expect(':');
+        skipWhitespace();
+
+        std::size_t index = next < layout.fields.size() && equalsLowercase(key, layout.fields[next].key) ? next : layout.fields.size();
+        for (std::size_t i = 0; index == layout.fields.size() && i < layout.fields.size(); ++i) {
+            if (equalsLowercase(key, layout.fields[i].key)) {
+                index = i;
+            }
+        }
+        if (index < layout.fields.size()) {
+            const auto &field = layout.fields[index];
+            const Path child{path, field.key, 0};
+            fields[index] = parseField(field, &child, depth + 1);
+            next = index + 1;
+        } else {
+            skipValue(depth + 1);
+        }
+
+        skipWhitespace();
+        if (position_ == end_) {
+            throw JsonParseError("Unexpected end of JSON payload");
+        }
+        const char delimiter = *position_++;
+        if (delimiter == '}') {
+            break;
+        }
+        if (delimiter != ',') {
+            throw JsonParseError("Expected comma in object literal");
+        }
+    }
+    return value;
+}
+
+JsonValue JsonParser::parseField(const RecordLayout::Field &field, const Path *path, std::size_t depth) {
+    if (!field.list) {
+        return parseKind(field, path, depth);
+    }
+    if (consumeLiteral("null")) {
+        return JsonValue();
+    }
+    if (peek() != '[') {
+        throw JsonParseError("Field '" + path->describe() + "' must be a list");
+    }
+    if (depth > maxDepth) {
+        throw JsonParseError("JSON payload is nested too deeply");
+    }
+    ++position_;
+    JsonValue::Array items(resource_);
+    skipWhitespace();
+    if (peek() == ']') {
+        ++position_;
+        return JsonValue(std::move(items));
+    }
+    while (true) {
+        skipWhitespace();
+        const Path item{path, {}, items.size()};
+        items.push_back(parseKind(field, &item, depth + 1));
+        skipWhitespace();
+        if (position_ == end_) {
+            throw JsonParseError("Unexpected end of JSON payload");
+        }
+        const char delimiter = *position_++;
+        if (delimiter == ']') {
+            break;
+        }
+        if (delimiter != ',') {
+            throw JsonParseError("Expected comma in array literal");
+        }
+    }
+    return JsonValue(std::move(items));
+}
+
+JsonValue JsonParser::parseKind(const RecordLayout::Field &field, const Path *path, std::size_t depth) {
+    if (consumeLiteral("null")) {
+        return JsonValue();
+    }
+    const char c = peek();
+    switch (field.kind) {
+    case RecordLayout::Kind::Any:
+        return parseValue(depth);
+    case RecordLayout::Kind::Number:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            return parseNumber();
+        }
+        break;
+    case RecordLayout::Kind::String:
+        if (c == '"') {
+            return JsonValue(parseString());
+        }
+        break;
+    case RecordLayout::Kind::Boolean:
+        if (consumeLiteral("true")) {
+            return JsonValue(true);
+        }
+        if (consumeLiteral("false")) {
+            return JsonValue(false);
+        }
+        break;
+    case RecordLayout::Kind::Record:
+        if (c == '{') {
+            return parseRecord(*field.record, path, depth);
+        }
+        break;
+    }
+    kindError(field, path);
+}
+
+void JsonParser::kindError(const RecordLayout::Field &field, const Path *path) const {
+    const char *expected = "a value";
+    switch (field.kind) {
+    case RecordLayout::Kind::Number: expected = "a number"; break;
+    case RecordLayout::Kind::String: expected = "a string"; break;
+    case RecordLayout::Kind::Boolean: expected = "a boolean"; break;
+    case RecordLayout::Kind::Record: expected = "an object"; break;
+    case RecordLayout::Kind::Any: break;
+    }
+    throw JsonParseError("Field '" + path->describe() + "' must be " + expected);
+}
+
+JsonValue JsonParser::parseNumber() {
+    const char *start = position_;
+    if (peek() == '-') {
+        ++position_;
+    }
+    while (position_ < end_ && std::isdigit(static_cast<unsigned char>(*position_))) {
+        ++position_;
+    }
+    if (peek() == '.') {
+        ++position_;
+        while (position_ < end_ && std::isdigit(static_cast<unsigned char>(*position_))) {
+            ++position_;
+        }
+    }
+    if (peek() == 'e' || peek() == 'E') {
+        ++position_;
+        if (peek() == '+' || peek() == '-') {
+            ++position_;
+        }
+        while (position_ < end_ && std::isdigit(static_cast<unsigned char>(*position_))) {
+            ++position_;
+        }
+    }
+    double numeric = 0.0;
+    const auto [end, error] = std::from_chars(start, position_, numeric);
+    if (error != std::errc{} || end != position_) {
+        throw JsonParseError("Invalid numeric literal in JSON payload");
+    }
+    return JsonValue(numeric);
+}
+
+std::string JsonParser::parseString() {
+    expect('"');
+    std::string result;
+    while (true) {
+        const char *stop = findQuoteOrEscape(position_, end_);
+        result.append(position_, stop);
+        position_ = stop;
+        if (position_ == end_) {
+            throw JsonParseError("Unterminated string literal");
+        }
+        if (*position_++ == '"') {
+            return result;
+        }
+        decodeEscape(result);
+    }
+}
+
+std::string_view JsonParser::parseKey(std::string &scratch) {
+    expect('"');
+    const char *start = position_;
+    const char *stop = findQuoteOrEscape(position_, end_);
+    if (stop < end_ && *stop == '"') {
+        // No escapes: the key is read where it lies
+        position_ = stop + 1;
+        return std::string_view(start, static_cast<std::size_t>(stop - start));
+    }
+    --position_;
+    scratch = parseString();
+    return scratch;
+}
+
+void JsonParser::decodeEscape(std::string &output) {
+    if (position_ == end_) {
+        throw JsonParseError("Invalid escape sequence");
+    }
+    const char c = *position_++;
+    switch (c) {
+    case '"': output.push_back('"'); return;
+    case '\\': output.push_back('\\'); return;
+    case '/': output.push_back('/'); return;
+    case 'b': output.push_back('\b'); return;
+    case 'f': output.push_back('\f'); return;
+    case 'n': output.push_back('\n'); return;
+    case 'r': output.push_back('\r'); return;
+    case 't': output.push_back('\t'); return;
+    case 'u': break;
+    default:
+        throw JsonParseError("Invalid escape sequence");
+    }
+
+    const auto readHex = [this]() {
+        if (end_ - position_ < 4) {
+            throw JsonParseError("Invalid Unicode escape");
+        }
+        unsigned int codepoint = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char hex = *position_++;
+            codepoint <<= 4;
+            if (hex >= '0' && hex <= '9') {
+                codepoint |= static_cast<unsigned int>(hex - '0');
+            } else if (hex >= 'a' && hex <= 'f') {
+                codepoint |= static_cast<unsigned int>(hex - 'a' + 10);
+            } else if (hex >= 'A' && hex <= 'F') {
+                codepoint |= static_cast<unsigned int>(hex - 'A' + 10);
+            } else {
+                throw JsonParseError("Invalid Unicode escape");
+            }
+        }
+        return codepoint;
+    };
+    unsigned int codepoint = readHex();
+    // A high surrogate followed by a low one encodes a single code point beyond U+FFFF
+    if (codepoint >= 0xD800 && codepoint <= 0xDBFF && end_ - position_ >= 6 && position_[0] == '\\' && position_[1] == 'u') {
+        const char *resume = position_;
+        position_ += 2;
+        const unsigned int low = readHex();
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+        } else {
+            position_ = resume;
+        }
+    }
+    appendCodepoint(output, codepoint);
+}
+
+void JsonParser::skipString() {
+    expect('"');
+    while (true) {
+        position_ = findQuoteOrEscape(position_, end_);
+        if (position_ == end_) {
+            throw JsonParseError("Unterminated string literal");
+        }
+        if (*position_++ == '"') {
+            return;
+        }
+        if (position_ == end_) {
+            throw JsonParseError("Invalid escape sequence");
+        }
+        ++position_;
+    }
+}
+
+void JsonParser::skipValue(std::size_t depth) {
+    if (depth > maxDepth) {
+        throw JsonParseError("JSON payload is nested too deeply");
+    }
+    const char c = peek();
+    if (c == '"') {
+        skipString();
+        return;
+    }
+    if (c == '{' || c == '[') {
+        const char close = c == '{' ? '}' : ']';
+        ++position_;
+        skipWhitespace();
+        if (peek() == close) {
+            ++position_;
+            return;
+        }
+        while (true) {
+            skipWhitespace();
+            if (c == '{') {
+                if (peek() != '"') {
+                    throw JsonParseError("Object keys must be strings");
+                }
+                skipString();
+                skipWhitespace();
+                expect(':');
+                skipWhitespace();
+            }
+            skipValue(depth + 1);
+            skipWhitespace();
+            if (position_ == end_) {
+                throw JsonParseError("Unexpected end of JSON payload");
+            }
+            const char delimiter = *position_++;
+            if (delimiter == close) {
+                return;
+            }
+            if (delimiter != ',') {
+                throw JsonParseError(c == '{' ? "Expected comma in object literal" : "Expected comma in array literal");
+            }
+        }
+    }
+    if (consumeLiteral("true") || consumeLiteral("false") || consumeLiteral("null")) {
+        return;
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        parseNumber();
+        return;
+    }
+    if (position_ == end_) {
+        throw JsonParseError("Unexpected end of JSON payload");
+    }
+    throw JsonParseError("Unsupported JSON token encountered");
+}
+
+} // namespace trx::runtime
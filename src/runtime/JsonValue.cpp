@@ -1,9 +1,17 @@
 #include "trx/runtime/JsonValue.h"
+#include "trx/runtime/JsonWriter.h"
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 namespace trx::runtime {
 
+std::size_t RecordShape::indexOf(const std::string &key) const {
+    const auto it = std::find(keys.begin(), keys.end(), key);
+    return it == keys.end() ? npos : static_cast<std::size_t>(it - keys.begin());
+}
+
 JsonValue::JsonValue() : data(std::nullptr_t{}) {}
 JsonValue::JsonValue(bool value) : data(value) {}
 JsonValue::JsonValue(double value) : data(value) {}
@@ -12,6 +20,7 @@ JsonValue::JsonValue(std::string value) : data(std::move(value)) {}
 JsonValue::JsonValue(const char *value) : data(value ? std::string(value) : std::string{}) {}
 JsonValue::JsonValue(Object value) : data(std::move(value)) {}
 JsonValue::JsonValue(Array value) : data(std::move(value)) {}
+JsonValue::JsonValue(Record value) : data(std::move(value)) {}
 
 JsonValue JsonValue::object() {
     return JsonValue(Object{});
@@ -21,11 +30,25 @@ JsonValue JsonValue::array() {
     return JsonValue(Array{});
 }
 
+JsonValue JsonValue::record(std::shared_ptr<const RecordShape> shape) {
+    Record record{std::move(shape), {}};
+    record.fields.resize(record.shape->keys.size());
+    return JsonValue(std::move(record));
+}
+
 bool JsonValue::isObject() const {
-    return std::holds_alternative<Object>(data);
+    return std::holds_alternative<Object>(data) || std::holds_alternative<Record>(data);
 }
 
 JsonValue::Object &JsonValue::asObject() {
+    if (auto *record = std::get_if<Record>(&data)) {
+        Object object;
+        object.reserve(record->fields.size());
+        for (std::size_t i = 0; i < record->fields.size(); ++i) {
+            object.emplace(record->shape->keys[i], std::move(record->fields[i]));
+        }
+        data = std::move(object);
+    }
     return std::get<Object>(data);
 }
 
@@ -33,6 +56,44 @@ const JsonValue::Object &JsonValue::asObject() const {
     return std::get<Object>(data);
 }
 
+bool JsonValue::isRecord() const {
+    return std::holds_alternative<Record>(data);
+}
+
+JsonValue::Record &JsonValue::asRecord() {
+    return std::get<Record>(data);
+}
+
+const JsonValue::Record &JsonValue::asRecord() const {
+    return std::get<Record>(data);
+}
+
+const JsonValue *JsonValue::findField(const std::string &key, std::size_t hint) const {
+    if (const auto *record = std::get_if<Record>(&data)) {
+        const auto &keys = record->shape->keys;
+        if (hint >= keys.size() || keys[hint] != key) {
+            hint = record->shape->indexOf(key);
+        }
+        return hint == RecordShape::npos ? nullptr : &record->fields[hint];
+    }
+    if (const auto *object = std::get_if<Object>(&data)) {
+        const auto it = object->find(key);
+        return it == object->end() ? nullptr : &it->second;
+    }
+    return nullptr;
+}
+
+JsonValue *JsonValue::findField(const std::string &key, std::size_t hint) {
+    return const_cast<JsonValue *>(std::as_const(*this).findField(key, hint));
+}
+
+JsonValue &JsonValue::field(const std::string &key, std::size_t hint) {
+    if (auto *existing = findField(key, hint)) {
+        return *existing;
+    }
+    return asObject()[key];
+}
+
 bool JsonValue::isArray() const {
     return std::holds_alternative<Array>(data);
 }
@@ -74,7 +135,27 @@ const std::string& JsonValue::asString() const {
 }
 
 bool operator==(const JsonValue &lhs, const JsonValue &rhs) {
-    return lhs.data == rhs.data;
+    if (!lhs.isRecord() && !rhs.isRecord()) {
+        return lhs.data == rhs.data;
+    }
+    // A record equals any object with the same fields, whichever representation it has
+    if (!lhs.isObject() || !rhs.isObject()) {
+        return false;
+    }
+    std::size_t lhsCount = 0;
+    std::size_t rhsCount = 0;
+    bool equal = true;
+    lhs.forEachField([&](const std::string &key, const JsonValue &value) {
+        ++lhsCount;
+        const auto *other = equal ? rhs.findField(key) : nullptr;
+        equal = other && *other == value;
+    });
+    rhs.forEachField([&](const std::string &, const JsonValue &) { ++rhsCount; });
+    return equal && lhsCount == rhsCount;
+}
+
+bool operator==(const JsonValue::Record &lhs, const JsonValue::Record &rhs) {
+    return lhs.shape->keys == rhs.shape->keys && lhs.fields == rhs.fields;
 }
 
 bool operator!=(const JsonValue &lhs, const JsonValue &rhs) {
@@ -82,35 +163,7 @@ bool operator!=(const JsonValue &lhs, const JsonValue &rhs) {
 }
 
 std::ostream &operator<<(std::ostream &os, const JsonValue &value) {
-    std::visit(
-        Overloaded{
-            [&](std::nullptr_t) { os << "null"; },
-            [&](bool b) { os << (b ? "true" : "false"); },
-            [&](double d) { os << d; },
-            [&](const std::string &s) { os << '"' << s << '"'; },
-            [&](const JsonValue::Object &obj) {
-                os << '{';
-                bool first = true;
-                for (const auto &[key, val] : obj) {
-                    if (!first) os << ',';
-                    os << '"' << key << "\":" << val;
-                    first = false;
-                }
-                os << '}';
-            },
-            [&](const JsonValue::Array &arr) {
-                os << '[';
-                bool first = true;
-                for (const auto &val : arr) {
-                    if (!first) os << ',';
-                    os << val;
-                    first = false;
-                }
-                os << ']';
-            }
-        },
-        value.data);
-    return os;
+    return os << JsonWriter::toString(value);
 }
 
 } // namespace trx::runtime
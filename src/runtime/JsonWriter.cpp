@@ -0,0 +1,109 @@
+#include "trx/runtime/JsonWriter.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace trx::runtime {
+
+namespace {
+
+bool needsEscape(unsigned char c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+} // namespace
+
+void JsonWriter::write(const JsonValue &value) {
+    if (std::holds_alternative<std::nullptr_t>(value.data)) {
+        out_.append("null");
+    } else if (const auto *flag = std::get_if<bool>(&value.data)) {
+        out_.append(*flag ? "true" : "false");
+    } else if (const auto *number = std::get_if<double>(&value.data)) {
+        writeNumber(*number);
+    } else if (const auto *text = std::get_if<std::string>(&value.data)) {
+        writeString(*text);
+    } else if (const auto *array = std::get_if<JsonValue::Array>(&value.data)) {
+        out_.push_back('[');
+        bool first = true;
+        for (const auto &item : *array) {
+            if (!first) {
+                out_.push_back(',');
+            }
+            first = false;
+            write(item);
+        }
+        out_.push_back(']');
+    } else if (const auto *object = std::get_if<JsonValue::Object>(&value.data)) {
+        out_.push_back('{');
+        bool first = true;
+        for (const auto &[key, item] : *object) {
+            if (!first) {
+                out_.push_back(',');
+            }
+            first = false;
+            writeString(key);
+            out_.push_back(':');
+            write(item);
+        }
+        out_.push_back('}');
+    } else if (const auto *record = std::get_if<JsonValue::Record>(&value.data)) {
+        out_.push_back('{');
+        for (std::size_t i = 0; i < record->fields.size(); ++i) {
+            if (i > 0) {
+                out_.push_back(',');
+            }
+            writeString(record->shape->keys[i]);
+            out_.push_back(':');
+            write(record->fields[i]);
+        }
+        out_.push_back('}');
+    }
+}
+
+void JsonWriter::writeString(std::string_view text) {
+    static constexpr char hex[] = "0123456789ABCDEF";
+    out_.push_back('"');
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (!needsEscape(c)) {
+            continue;
+        }
+        out_.append(text.data() + start, i - start);
+        start = i + 1;
+        switch (c) {
+        case '"': out_.append("\\\""); break;
+        case '\\': out_.append("\\\\"); break;
+        case '\b': out_.append("\\b"); break;
+        case '\f': out_.append("\\f"); break;
+        case '\n': out_.append("\\n"); break;
+        case '\r': out_.append("\\r"); break;
+        case '\t': out_.append("\\t"); break;
+        default: {
+            const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            out_.append(escaped, sizeof(escaped));
+            break;
+        }
+        }
+    }
+    out_.append(text.data() + start, text.size() - start);
+    out_.push_back('"');
+}
+
+void JsonWriter::writeNumber(double number) {
+    if (!std::isfinite(number)) {
+        out_.append("null");
+        return;
+    }
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), number, std::chars_format::general, 15);
+    out_.append(buffer, result.ptr);
+}
+
+std::string JsonWriter::toString(const JsonValue &value) {
+    std::string out;
+    JsonWriter(out).write(value);
+    return out;
+}
+
+} // namespace trx::runtime
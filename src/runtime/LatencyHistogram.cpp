@@ -0,0 +1,74 @@
+#include "trx/runtime/LatencyHistogram.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace trx::runtime {
+
+LatencyHistogram::LatencyHistogram(std::size_t seriesCount, std::size_t shardCount)
+    : seriesCount_(seriesCount) {
+    shards_.reserve(std::max<std::size_t>(1, shardCount));
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, shardCount); ++i) {
+        auto shard = std::make_unique<Shard>(seriesCount);
+        for (std::size_t s = 0; s < seriesCount; ++s) {
+            shard->series[s].store(nullptr, std::memory_order_relaxed);
+        }
+        shards_.push_back(std::move(shard));
+    }
+}
+
+LatencyHistogram::~LatencyHistogram() {
+    for (auto &shard : shards_) {
+        for (std::size_t s = 0; s < seriesCount_; ++s) {
+            delete shard->series[s].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void LatencyHistogram::observe(std::size_t shard, std::size_t series, double seconds) {
+    if (series >= seriesCount_) {
+        throw std::out_of_range("LatencyHistogram series index out of range");
+    }
+    auto &slot = shards_[std::min(shard, shards_.size() - 1)]->series[series];
+    Counters *counters = slot.load(std::memory_order_acquire);
+    if (!counters) {
+        auto *fresh = new Counters();
+        if (slot.compare_exchange_strong(counters, fresh, std::memory_order_acq_rel)) {
+            counters = fresh;
+        } else {
+            delete fresh; // Another thread sharing the shard got there first
+        }
+    }
+
+    seconds = std::max(seconds, 0.0);
+    const auto bucket = static_cast<std::size_t>(
+        std::lower_bound(bucketBounds.begin(), bucketBounds.end(), seconds) - bucketBounds.begin());
+    counters->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    counters->sumNanos.fetch_add(static_cast<std::uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot(std::size_t series) const {
+    Snapshot result;
+    if (series >= seriesCount_) {
+        return result;
+    }
+    std::uint64_t sumNanos = 0;
+    for (const auto &shard : shards_) {
+        const Counters *counters = shard->series[series].load(std::memory_order_acquire);
+        if (!counters) {
+            continue;
+        }
+        for (std::size_t b = 0; b < result.buckets.size(); ++b) {
+            result.buckets[b] += counters->buckets[b].load(std::memory_order_relaxed);
+        }
+        sumNanos += counters->sumNanos.load(std::memory_order_relaxed);
+    }
+    for (std::size_t b = 1; b < result.buckets.size(); ++b) {
+        result.buckets[b] += result.buckets[b - 1];
+    }
+    result.count = result.buckets.back();
+    result.sum = static_cast<double>(sumNanos) / 1e9;
+    return result;
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,169 @@
+#include "trx/runtime/ListAggregate.h"
+
+#include "trx/runtime/ListIndex.h"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace trx::runtime {
+
+namespace {
+
+// Independent accumulators per lane let the compiler keep the loop in vector registers
+constexpr std::size_t lanes = 8;
+
+FieldSummary reduce(const double *values, std::size_t count) {
+    double sums[lanes] = {};
+    double lows[lanes];
+    double highs[lanes];
+    std::fill(std::begin(lows), std::end(lows), std::numeric_limits<double>::infinity());
+    std::fill(std::begin(highs), std::end(highs), -std::numeric_limits<double>::infinity());
+    const std::size_t whole = count - count % lanes;
+    for (std::size_t i = 0; i < whole; i += lanes) {
+        for (std::size_t l = 0; l < lanes; ++l) {
+            const double value = values[i + l];
+            sums[l] += value;
+            lows[l] = value < lows[l] ? value : lows[l];
+            highs[l] = value > highs[l] ? value : highs[l];
+        }
+    }
+    for (std::size_t i = whole; i < count; ++i) {
+        sums[0] += values[i];
+        lows[0] = std::min(lows[0], values[i]);
+        highs[0] = std::max(highs[0], values[i]);
+    }
+    FieldSummary summary{.count = count};
+    for (std::size_t l = 0; l < lanes; ++l) {
+        summary.sum += sums[l];
+    }
+    summary.min = *std::min_element(std::begin(lows), std::end(lows));
+    summary.max = *std::max_element(std::begin(highs), std::end(highs));
+    return summary;
+}
+
+// Counts are kept as doubles, exact up to 2^53, so compare and add stay in the same registers
+std::size_t countEqual(const double *values, std::size_t count, double target) {
+    double counts[lanes] = {};
+    const std::size_t whole = count - count % lanes;
+    for (std::size_t i = 0; i < whole; i += lanes) {
+        for (std::size_t l = 0; l < lanes; ++l) {
+            counts[l] += values[i + l] == target ? 1.0 : 0.0;
+        }
+    }
+    std::size_t total = 0;
+    for (std::size_t i = whole; i < count; ++i) {
+        total += values[i] == target ? 1 : 0;
+    }
+    for (std::size_t l = 0; l < lanes; ++l) {
+        total += static_cast<std::size_t>(counts[l]);
+    }
+    return total;
+}
+
+/**
+ * Run |work|(first, last) over the runs of [0, count): one run below |parallelThreshold|,
+ * otherwise one per thread, like sortByKeys(). Returns the result of each run in order;
+ * an exception thrown on any thread is rethrown here.
+ */
+template <typename Work>
+auto forEachRun(std::size_t count, std::size_t parallelThreshold, Work work) {
+    using Result = decltype(work(std::size_t{0}, std::size_t{0}));
+    const std::size_t threads = count >= parallelThreshold ? std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), 8) : 1;
+    std::vector<Result> results(threads);
+    if (threads < 2) {
+        results[0] = work(0, count);
+        return results;
+    }
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            try {
+                results[t] = work(count * t / threads, count * (t + 1) / threads);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return results;
+}
+
+} // namespace
+
+FieldSummary summarizeField(const JsonValue::Array &items, const std::string &field, std::size_t parallelThreshold) {
+    // Each run gathers its numbers into its own stretch of one buffer, then reduces that stretch
+    std::vector<double> buffer(items.size());
+    const auto parts = forEachRun(items.size(), parallelThreshold, [&](std::size_t first, std::size_t last) {
+        FieldPath path(field);
+        double *out = buffer.data() + first;
+        std::size_t gathered = 0;
+        for (std::size_t i = first; i < last; ++i) {
+            const JsonValue *value = path.read(items[i]);
+            if (!value) {
+                continue;
+            }
+            const auto *number = std::get_if<double>(&value->data);
+            if (!number) {
+                throw std::runtime_error("field '" + field + "' holds a value that is not a number");
+            }
+            out[gathered++] = *number;
+        }
+        return reduce(out, gathered);
+    });
+
+    FieldSummary total;
+    for (const auto &part : parts) {
+        if (part.count == 0) {
+            continue;
+        }
+        total.min = total.count == 0 ? part.min : std::min(total.min, part.min);
+        total.max = total.count == 0 ? part.max : std::max(total.max, part.max);
+        total.count += part.count;
+        total.sum += part.sum;
+    }
+    return total;
+}
+
+std::size_t countMatching(const JsonValue::Array &items, const std::string &field, const JsonValue &value, std::size_t parallelThreshold) {
+    const auto *target = std::get_if<double>(&value.data);
+    std::vector<double> buffer(target ? items.size() : 0);
+    const auto parts = forEachRun(items.size(), parallelThreshold, [&](std::size_t first, std::size_t last) {
+        FieldPath path(field);
+        if (target) {
+            // Anything but a number gathers as NaN, which equals nothing
+            double *out = buffer.data() + first;
+            for (std::size_t i = first; i < last; ++i) {
+                const JsonValue *found = path.read(items[i]);
+                const auto *number = found ? std::get_if<double>(&found->data) : nullptr;
+                out[i - first] = number ? *number : std::numeric_limits<double>::quiet_NaN();
+            }
+            return countEqual(out, last - first, *target);
+        }
+        std::size_t matched = 0;
+        for (std::size_t i = first; i < last; ++i) {
+            const JsonValue *found = path.read(items[i]);
+            matched += found ? (*found == value ? 1 : 0) : (value.isNull() ? 1 : 0);
+        }
+        return matched;
+    });
+
+    std::size_t total = 0;
+    for (const auto part : parts) {
+        total += part;
+    }
+    return total;
+}
+
+} // namespace trx::runtime
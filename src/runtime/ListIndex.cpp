@@ -0,0 +1,106 @@
+#include "trx/runtime/ListIndex.h"
+
+#include "trx/runtime/JsonWriter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <type_traits>
+#include <utility>
+
+namespace trx::runtime {
+
+FieldPath::FieldPath(const std::string &field) {
+    std::size_t start = 0;
+    while (!field.empty() && start <= field.size()) {
+        auto end = field.find('.', start);
+        if (end == std::string::npos) {
+            end = field.size();
+        }
+        std::string segment = field.substr(start, end - start);
+        std::transform(segment.begin(), segment.end(), segment.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        segments_.push_back(std::move(segment));
+        start = end + 1;
+    }
+    shapes_.assign(segments_.size(), nullptr);
+    hints_.assign(segments_.size(), RecordShape::npos);
+}
+
+const JsonValue *FieldPath::read(const JsonValue &item) {
+    const JsonValue *current = &item;
+    for (std::size_t i = 0; i < segments_.size() && current; ++i) {
+        if (const auto *record = std::get_if<JsonValue::Record>(&current->data); record && record->shape.get() != shapes_[i]) {
+            shapes_[i] = record->shape.get();
+            hints_[i] = shapes_[i]->indexOf(segments_[i]);
+        }
+        current = current->findField(segments_[i], hints_[i]);
+    }
+    return current && !current->isNull() ? current : nullptr;
+}
+
+namespace {
+
+// Items of a list the caller gives up are moved into the index instead of copied
+template <typename Items>
+JsonValue build(Items &&items, const std::string &field, bool group) {
+    constexpr bool consume = !std::is_const_v<std::remove_reference_t<Items>>;
+    FieldPath path(field);
+    JsonValue::Object index;
+    index.reserve(items.size());
+    for (auto &item : items) {
+        const auto *key = path.read(item);
+        if (!key) {
+            continue;
+        }
+        auto text = indexKey(*key);
+        if (group) {
+            auto &members = index.try_emplace(std::move(text), JsonValue::Array{}).first->second.asArray();
+            if constexpr (consume) {
+                members.push_back(std::move(item));
+            } else {
+                members.push_back(item);
+            }
+        } else if constexpr (consume) {
+            index.try_emplace(std::move(text), std::move(item));
+        } else {
+            index.try_emplace(std::move(text), item);
+        }
+    }
+    return JsonValue(std::move(index));
+}
+
+} // namespace
+
+std::string indexKey(const JsonValue &value) {
+    if (const auto *text = std::get_if<std::string>(&value.data)) {
+        return *text;
+    }
+    return JsonWriter::toString(value);
+}
+
+JsonValue indexBy(const JsonValue::Array &items, const std::string &field) {
+    return build(items, field, false);
+}
+
+JsonValue indexBy(JsonValue::Array &&items, const std::string &field) {
+    return build(items, field, false);
+}
+
+JsonValue groupBy(const JsonValue::Array &items, const std::string &field) {
+    return build(items, field, true);
+}
+
+JsonValue groupBy(JsonValue::Array &&items, const std::string &field) {
+    return build(items, field, true);
+}
+
+const JsonValue *lookup(const JsonValue &index, const JsonValue &key) {
+    const auto *object = std::get_if<JsonValue::Object>(&index.data);
+    if (!object) {
+        return nullptr;
+    }
+    const auto *text = std::get_if<std::string>(&key.data);
+    const auto it = text ? object->find(*text) : object->find(indexKey(key));
+    return it == object->end() ? nullptr : &it->second;
+}
+
+} // namespace trx::runtime
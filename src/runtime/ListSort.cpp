@@ -0,0 +1,136 @@
+#include "trx/runtime/ListSort.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace trx::runtime {
+
+namespace {
+
+// Ranks between kinds; they do not flip for descending keys
+enum class KeyKind : std::uint8_t { Number, String, Other };
+
+struct KeyValue {
+    KeyKind kind{KeyKind::Other};
+    double number{0.0};
+    const std::string *text{nullptr};
+};
+
+KeyValue keyValue(const JsonValue *field) {
+    if (field) {
+        if (const auto *number = std::get_if<double>(&field->data)) {
+            return KeyValue{.kind = KeyKind::Number, .number = *number};
+        }
+        if (const auto *text = std::get_if<std::string>(&field->data)) {
+            return KeyValue{.kind = KeyKind::String, .text = text};
+        }
+    }
+    return KeyValue{};
+}
+
+int compareKeys(const KeyValue &a, const KeyValue &b, double order) {
+    if (a.kind != b.kind) {
+        return a.kind < b.kind ? -1 : 1;
+    }
+    int result = 0;
+    if (a.kind == KeyKind::Number) {
+        result = a.number < b.number ? -1 : (b.number < a.number ? 1 : 0);
+    } else if (a.kind == KeyKind::String) {
+        const int compared = a.text->compare(*b.text);
+        result = compared < 0 ? -1 : (compared > 0 ? 1 : 0);
+    }
+    return order < 0 ? -result : result;
+}
+
+} // namespace
+
+void sortByKeys(JsonValue::Array &items, const std::vector<trx::ast::SortKey> &keys, std::size_t parallelThreshold) {
+    const std::size_t count = items.size();
+    const std::size_t width = keys.size();
+    if (count < 2 || width == 0) {
+        return;
+    }
+
+    // Read every key once; records sharing a shape reuse the field positions
+    std::vector<KeyValue> table(count * width);
+    std::vector<std::size_t> hints(width, RecordShape::npos);
+    const RecordShape *shape = nullptr;
+    for (std::size_t i = 0; i < count; ++i) {
+        const JsonValue &item = items[i];
+        if (const auto *record = std::get_if<JsonValue::Record>(&item.data); record && record->shape.get() != shape) {
+            shape = record->shape.get();
+            for (std::size_t k = 0; k < width; ++k) {
+                hints[k] = shape->indexOf(keys[k].fieldName);
+            }
+        }
+        for (std::size_t k = 0; k < width; ++k) {
+            table[i * width + k] = keyValue(item.findField(keys[k].fieldName, hints[k]));
+        }
+    }
+
+    // Ties fall back to the original position, which makes the order total and the sort stable
+    const auto less = [&](std::size_t a, std::size_t b) {
+        const KeyValue *rowA = &table[a * width];
+        const KeyValue *rowB = &table[b * width];
+        for (std::size_t k = 0; k < width; ++k) {
+            if (const int compared = compareKeys(rowA[k], rowB[k], keys[k].order); compared != 0) {
+                return compared < 0;
+            }
+        }
+        return a < b;
+    };
+
+    std::vector<std::size_t> order(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+
+    const std::size_t threads = count >= parallelThreshold ? std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), 8) : 1;
+    if (threads < 2) {
+        std::sort(order.begin(), order.end(), less);
+    } else {
+        // Sort one run per thread, then merge neighbouring runs pairwise until one is left
+        std::vector<std::size_t> bounds;
+        for (std::size_t t = 0; t <= threads; ++t) {
+            bounds.push_back(count * t / threads);
+        }
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] { std::sort(order.begin() + bounds[t], order.begin() + bounds[t + 1], less); });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        while (bounds.size() > 2) {
+            std::vector<std::size_t> merged{bounds.front()};
+            workers.clear();
+            for (std::size_t r = 0; r + 2 < bounds.size(); r += 2) {
+                const auto first = bounds[r];
+                const auto middle = bounds[r + 1];
+                const auto last = bounds[r + 2];
+                workers.emplace_back([&, first, middle, last] {
+                    std::inplace_merge(order.begin() + first, order.begin() + middle, order.begin() + last, less);
+                });
+                merged.push_back(last);
+            }
+            if (bounds.size() % 2 == 0) {
+                merged.push_back(bounds.back());
+            }
+            for (auto &worker : workers) {
+                worker.join();
+            }
+            bounds = std::move(merged);
+        }
+    }
+
+    JsonValue::Array sorted(items.get_allocator());
+    sorted.reserve(count);
+    for (const std::size_t index : order) {
+        sorted.push_back(std::move(items[index]));
+    }
+    items = std::move(sorted);
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,328 @@
+#include "trx/runtime/Logger.h"
+
+#include "trx/runtime/JsonWriter.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+namespace trx::runtime {
+
+namespace {
+
+constexpr std::size_t ringCapacity = 256; // records per thread; a power of two
+constexpr std::size_t maxFields = 8;
+constexpr std::size_t textCapacity = 896; // message and field text of one record
+constexpr auto drainInterval = std::chrono::milliseconds(50);
+
+struct StoredField {
+    const char *key;
+    LogField::Kind kind;
+    std::uint16_t offset;
+    std::uint16_t length;
+    union {
+        std::int64_t integer;
+        double number;
+        bool boolean;
+    };
+};
+
+struct Record {
+    std::int64_t unixMicros;
+    LogLevel level;
+    bool truncated;
+    std::uint8_t fieldCount;
+    std::uint16_t messageLength; // the message starts the text
+    std::array<StoredField, maxFields> fields;
+    std::array<char, textCapacity> text;
+};
+
+LogLevel levelFromEnvironment() {
+    if (const char *name = std::getenv("TRX_LOG_LEVEL")) {
+        if (const auto level = parseLogLevel(name)) {
+            return *level;
+        }
+    }
+    const char *debug = std::getenv("DEBUG");
+    return debug && std::string_view(debug) == "true" ? LogLevel::Debug : LogLevel::Info;
+}
+
+void appendTimestamp(std::string &out, std::int64_t unixMicros) {
+    const std::time_t seconds = static_cast<std::time_t>(unixMicros / 1000000);
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ", utc.tm_year + 1900,
+                                     utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec,
+                                     static_cast<int>(unixMicros % 1000000));
+    out.append(buffer, static_cast<std::size_t>(length));
+}
+
+void appendLine(std::string &out, const Record &record, unsigned thread) {
+    JsonWriter writer(out);
+    out += R"({"time":")";
+    appendTimestamp(out, record.unixMicros);
+    out += R"(","level":")";
+    out += logLevelName(record.level);
+    out += R"(","thread":)";
+    out += std::to_string(thread);
+    out += R"(,"msg":)";
+    writer.writeString(std::string_view(record.text.data(), record.messageLength));
+    for (std::size_t i = 0; i < record.fieldCount; ++i) {
+        const auto &field = record.fields[i];
+        out += ',';
+        writer.writeString(field.key);
+        out += ':';
+        const std::string_view text(record.text.data() + field.offset, field.length);
+        switch (field.kind) {
+        case LogField::Kind::Text:
+            writer.writeString(text);
+            break;
+        case LogField::Kind::Integer:
+            out += std::to_string(field.integer);
+            break;
+        case LogField::Kind::Number:
+            writer.writeNumber(field.number);
+            break;
+        case LogField::Kind::Boolean:
+            out += field.boolean ? "true" : "false";
+            break;
+        case LogField::Kind::Json:
+            out += text; // already JSON
+            break;
+        }
+    }
+    if (record.truncated) {
+        out += R"(,"truncated":true)";
+    }
+    out += "}\n";
+}
+
+} // namespace
+
+struct Logger::Ring {
+    std::array<Record, ringCapacity> records;
+    alignas(64) std::atomic<std::size_t> head{0}; // next record the owning thread fills
+    alignas(64) std::atomic<std::size_t> tail{0}; // next record the writer formats
+    std::atomic<bool> closed{false};              // the owning thread has exited
+    unsigned thread{0};
+};
+
+namespace {
+
+struct ThreadRing {
+    std::shared_ptr<Logger::Ring> ring;
+    std::uint64_t generation{0};
+
+    ~ThreadRing() {
+        if (ring) {
+            ring->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing currentRing;
+
+} // namespace
+
+std::atomic<LogLevel> Logger::threshold_{levelFromEnvironment()};
+
+std::optional<LogLevel> parseLogLevel(std::string_view name) {
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warn") return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off") return LogLevel::Off;
+    return std::nullopt;
+}
+
+const char *logLevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Info: return "info";
+    case LogLevel::Warn: return "warn";
+    case LogLevel::Error: return "error";
+    case LogLevel::Off: return "off";
+    }
+    return "off";
+}
+
+Logger &Logger::instance() {
+    // Never destroyed, so threads still logging during exit find it intact
+    static Logger *logger = [] {
+        auto *created = new Logger();
+        pthread_atfork(&Logger::prepareFork, &Logger::parentAfterFork, &Logger::childAfterFork);
+        std::atexit([] { Logger::instance().flush(); });
+        return created;
+    }();
+    return *logger;
+}
+
+Logger::Logger() = default;
+
+void Logger::setSink(Sink sink) {
+    std::lock_guard lock(drainMutex_);
+    sink_ = std::move(sink);
+}
+
+Logger::Ring &Logger::threadRing() {
+    auto &current = currentRing;
+    if (current.ring) {
+        // Unlocked read: generation_ only changes in a forked child, before any other thread runs
+        if (current.generation == generation_) {
+            return *current.ring;
+        }
+        current.ring.reset();
+    }
+    auto ring = std::make_shared<Ring>();
+    std::lock_guard lock(registryMutex_);
+    ring->thread = ++nextThread_;
+    rings_.push_back(ring);
+    current.ring = std::move(ring);
+    current.generation = generation_;
+    if (!writerStarted_) {
+        writerStarted_ = true;
+        std::thread([this] { run(); }).detach();
+    }
+    return *current.ring;
+}
+
+void Logger::write(LogLevel level, std::string_view message, std::initializer_list<LogField> fields) {
+    thread_local std::string json; // keeps its capacity between records
+    Ring &ring = threadRing();
+    const auto head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) == ringCapacity) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record &record = ring.records[head & (ringCapacity - 1)];
+    record.unixMicros =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    record.level = level;
+    record.truncated = false;
+    std::size_t used = 0;
+    const auto copy = [&record, &used](std::string_view text) {
+        const auto length = std::min(text.size(), textCapacity - used);
+        record.truncated = record.truncated || length < text.size();
+        std::memcpy(record.text.data() + used, text.data(), length);
+        used += length;
+        return static_cast<std::uint16_t>(length);
+    };
+    record.messageLength = copy(message);
+    record.fieldCount = 0;
+    for (const auto &field : fields) {
+        if (record.fieldCount == maxFields) {
+            record.truncated = true;
+            break;
+        }
+        auto &stored = record.fields[record.fieldCount++];
+        stored.key = field.key;
+        stored.kind = field.kind;
+        stored.offset = static_cast<std::uint16_t>(used);
+        stored.length = 0;
+        switch (field.kind) {
+        case LogField::Kind::Text:
+            stored.length = copy(field.text);
+            break;
+        case LogField::Kind::Integer:
+            stored.integer = field.integer;
+            break;
+        case LogField::Kind::Number:
+            stored.number = field.number;
+            break;
+        case LogField::Kind::Boolean:
+            stored.boolean = field.boolean;
+            break;
+        case LogField::Kind::Json:
+            // Formatted here, while the value still exists; cut short it is kept as a string
+            json.clear();
+            JsonWriter(json).write(*field.json);
+            if (json.size() > textCapacity - used) {
+                stored.kind = LogField::Kind::Text;
+            }
+            stored.length = copy(json);
+            break;
+        }
+    }
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Logger::run() {
+    for (;;) {
+        std::this_thread::sleep_for(drainInterval);
+        drain();
+    }
+}
+
+void Logger::flush() {
+    drain();
+}
+
+void Logger::drain() {
+    std::lock_guard drainLock(drainMutex_);
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard lock(registryMutex_);
+        rings = rings_;
+    }
+
+    for (const auto &ring : rings) {
+        // Read closed first: a ring closed before its last records were seen is drained once more
+        const bool closed = ring->closed.load(std::memory_order_acquire);
+        auto tail = ring->tail.load(std::memory_order_relaxed);
+        const auto head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            appendLine(lines_, ring->records[tail & (ringCapacity - 1)], ring->thread);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        if (closed) {
+            std::lock_guard lock(registryMutex_);
+            rings_.erase(std::remove(rings_.begin(), rings_.end(), ring), rings_.end());
+        }
+    }
+
+    if (lines_.empty()) {
+        return;
+    }
+    if (sink_) {
+        sink_(lines_);
+    } else {
+        std::fwrite(lines_.data(), 1, lines_.size(), stderr);
+        std::fflush(stderr);
+    }
+    lines_.clear();
+}
+
+// The mutexes are held across fork() so the child gets them unlocked and consistent
+void Logger::prepareFork() {
+    auto &logger = instance();
+    logger.drainMutex_.lock();
+    logger.registryMutex_.lock();
+}
+
+void Logger::parentAfterFork() {
+    auto &logger = instance();
+    logger.registryMutex_.unlock();
+    logger.drainMutex_.unlock();
+}
+
+// The parent's other threads and its writer do not exist in the child, so the rings start over
+void Logger::childAfterFork() {
+    auto &logger = instance();
+    logger.rings_.clear();
+    ++logger.generation_;
+    logger.writerStarted_ = false;
+    logger.lines_.clear();
+    logger.registryMutex_.unlock();
+    logger.drainMutex_.unlock();
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,372 @@
+#include "trx/runtime/NativeLibrary.h"
+
+#include <dlfcn.h>
+
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace trx::runtime {
+
+namespace {
+
+// C++ string literal for |text|
+std::string quoted(const std::string &text) {
+    std::string literal = "\"";
+    for (const unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+            literal += static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\%03o", c);
+            literal += escaped;
+        } else {
+            literal += static_cast<char>(c);
+        }
+    }
+    return literal + "\"";
+}
+
+std::string operand(std::uint32_t value) {
+    return value == noOperand ? "trx::runtime::noOperand" : std::to_string(value) + "u";
+}
+
+// Writes the function for one program. Each instruction becomes a block of its own so
+// the gotos of jumps never cross an initialisation; instructions a CATCH resumes at also
+// get a case of the dispatch switch, which a caught exception re-enters with the pc set.
+class Translator {
+public:
+    Translator(const Program &program, std::ostringstream &out) : program_{program}, out_{out} {
+        for (const auto &ins : program.code) {
+            switch (ins.op) {
+                case OpCode::Jump: jumpTargets_.insert(ins.a); break;
+                case OpCode::JumpIfNotTrue: jumpTargets_.insert(ins.b); break;
+                case OpCode::JumpIfEqual:
+                case OpCode::ForNext:
+                case OpCode::ForNextVar: jumpTargets_.insert(ins.c); break;
+                case OpCode::TryBegin: resumePoints_.insert(ins.b); break;
+                default: break;
+            }
+        }
+    }
+
+    void function(const std::string &name) {
+        out_ << "Result " << name << "(Frame &f) {\n"
+             << "    [[maybe_unused]] std::vector<JsonValue> r(" << program_.registerCount << ");\n"
+             << "    std::uint32_t pc = 0;\n"
+             << "    for (;;) {\n"
+             << "        try {\n"
+             << "            switch (pc) {\n"
+             << "            case 0:\n";
+        for (std::uint32_t pc = 0; pc < program_.code.size(); ++pc) {
+            labels(pc);
+            instruction(program_.code[pc]);
+        }
+        if (labels(static_cast<std::uint32_t>(program_.code.size()))) {
+            line("break;");
+        }
+        out_ << "            }\n"
+             << "            return Result::Normal;\n"
+             << "        } catch (const TrxException &e) {\n"
+             << "            if (!f.unwind(e, pc)) {\n"
+             << "                throw;\n"
+             << "            }\n"
+             << "        }\n"
+             << "    }\n"
+             << "}\n\n";
+    }
+
+private:
+    const Program &program_;
+    std::ostringstream &out_;
+    std::set<std::uint32_t> jumpTargets_;
+    std::set<std::uint32_t> resumePoints_;
+
+    bool labels(std::uint32_t pc) {
+        bool labelled = false;
+        if (jumpTargets_.count(pc)) {
+            out_ << "            L" << pc << ":\n";
+            labelled = true;
+        }
+        if (pc != 0 && resumePoints_.count(pc)) {
+            out_ << "            case " << pc << ":\n";
+            labelled = true;
+        }
+        return labelled;
+    }
+
+    void line(const std::string &code) { out_ << "                " << code << "\n"; }
+
+    static std::string r(std::uint32_t index) { return "r[" + std::to_string(index) + "]"; }
+    static std::string jump(std::uint32_t target) { return "goto L" + std::to_string(target) + ";"; }
+
+    void constant(const Instruction &ins) {
+        const auto &value = program_.constants[ins.b];
+        if (const auto *number = std::get_if<double>(&value.data); number && std::isfinite(*number)) {
+            char literal[64];
+            std::snprintf(literal, sizeof(literal), "%a", *number);
+            line("{ " + r(ins.a) + ".data = " + literal + "; }");
+        } else if (const auto *flag = std::get_if<bool>(&value.data)) {
+            line("{ " + r(ins.a) + ".data = " + (*flag ? "true" : "false") + "; }");
+        } else {
+            line("{ " + r(ins.a) + " = f.constants[" + std::to_string(ins.b) + "]; }");
+        }
+    }
+
+    // Number operands are computed inline; anything else goes to the interpreter's operators
+    void binary(const Instruction &ins, const char *name, const char *symbol) {
+        const auto call = r(ins.a) + " = f.binary(OpCode::" + name + ", " + r(ins.b) + ", " + r(ins.c) + ");";
+        if (!symbol) {
+            line("{ " + call + " }");
+            return;
+        }
+        line("{");
+        line("    const auto *x = std::get_if<double>(&" + r(ins.b) + ".data);");
+        line("    const auto *y = std::get_if<double>(&" + r(ins.c) + ".data);");
+        line("    if (x && y) {");
+        line("        " + r(ins.a) + ".data = *x " + symbol + " *y;");
+        line("    } else {");
+        line("        " + call);
+        line("    }");
+        line("}");
+    }
+
+    void instruction(const Instruction &ins) {
+        switch (ins.op) {
+            case OpCode::LoadConst:
+                constant(ins);
+                break;
+            case OpCode::LoadSlot:
+                line("if (const auto *value = f.slot(" + operand(ins.b) + ")) {");
+                line("    " + r(ins.a) + " = *value;");
+                line("} else {");
+                line("    " + r(ins.a) + " = f.load(" + operand(ins.c) + ");");
+                line("}");
+                break;
+            case OpCode::LoadVar:
+                line("{ " + r(ins.a) + " = f.load(" + operand(ins.b) + "); }");
+                break;
+            case OpCode::LoadSqlCode:
+                line("{ " + r(ins.a) + ".data = f.sqlCode(); }");
+                break;
+            case OpCode::StoreSlot:
+                line("if (auto *value = f.slot(" + operand(ins.b) + ")) {");
+                line("    *value = std::move(" + r(ins.a) + ");");
+                line("} else {");
+                line("    f.store(" + operand(ins.c) + ", std::move(" + r(ins.a) + "));");
+                line("}");
+                break;
+            case OpCode::StoreVar:
+                line("{ f.store(" + operand(ins.b) + ", std::move(" + r(ins.a) + ")); }");
+                break;
+            case OpCode::BindSlot:
+                line("{ f.slots[" + std::to_string(ins.b) + "] = std::move(" + r(ins.a) + "); }");
+                break;
+            case OpCode::Positive:
+                line("{ " + r(ins.a) + " = f.unary(OpCode::Positive, " + r(ins.b) + "); }");
+                break;
+            case OpCode::Negate:
+                line("if (const auto *x = std::get_if<double>(&" + r(ins.b) + ".data)) {");
+                line("    " + r(ins.a) + ".data = -*x;");
+                line("} else {");
+                line("    " + r(ins.a) + " = f.unary(OpCode::Negate, " + r(ins.b) + ");");
+                line("}");
+                break;
+            case OpCode::Not:
+                line("if (const auto *x = std::get_if<bool>(&" + r(ins.b) + ".data)) {");
+                line("    " + r(ins.a) + ".data = !*x;");
+                line("} else {");
+                line("    " + r(ins.a) + " = f.unary(OpCode::Not, " + r(ins.b) + ");");
+                line("}");
+                break;
+            case OpCode::Add: binary(ins, "Add", "+"); break;
+            case OpCode::Subtract: binary(ins, "Subtract", "-"); break;
+            case OpCode::Multiply: binary(ins, "Multiply", "*"); break;
+            case OpCode::Divide: binary(ins, "Divide", nullptr); break; // division by zero is the interpreter's error
+            case OpCode::Modulo: binary(ins, "Modulo", nullptr); break;
+            case OpCode::Equal: binary(ins, "Equal", "=="); break;
+            case OpCode::NotEqual: binary(ins, "NotEqual", "!="); break;
+            case OpCode::Less: binary(ins, "Less", "<"); break;
+            case OpCode::LessEqual: binary(ins, "LessEqual", "<="); break;
+            case OpCode::Greater: binary(ins, "Greater", ">"); break;
+            case OpCode::GreaterEqual: binary(ins, "GreaterEqual", ">="); break;
+            case OpCode::And: binary(ins, "And", nullptr); break;
+            case OpCode::Or: binary(ins, "Or", nullptr); break;
+            case OpCode::RoundScale:
+                line("if (auto *x = std::get_if<double>(&" + r(ins.a) + ".data)) {");
+                line("    *x = trx::runtime::roundToScale(*x, " + std::to_string(ins.b) + ");");
+                line("}");
+                break;
+            case OpCode::NewObject:
+                line("{ " + r(ins.a) + " = JsonValue::object(); }");
+                break;
+            case OpCode::SetField:
+                line("{ " + r(ins.a) + ".asObject()[f.keys[" + std::to_string(ins.b) + "]] = std::move(" + r(ins.c) + "); }");
+                break;
+            case OpCode::NewArray:
+                line("{ " + r(ins.a) + " = JsonValue::array(); }");
+                break;
+            case OpCode::Push:
+                line("{ " + r(ins.a) + ".asArray().push_back(std::move(" + r(ins.b) + ")); }");
+                break;
+            case OpCode::Builtin:
+                line("{ " + r(ins.a) + " = f.builtin(" + operand(ins.b) + "); }");
+                break;
+            case OpCode::EvalTree:
+                line("{ " + r(ins.a) + " = f.eval(" + operand(ins.b) + "); }");
+                break;
+            case OpCode::Jump:
+                line(jump(ins.a));
+                break;
+            case OpCode::JumpIfNotTrue:
+                line("if (const auto *flag = std::get_if<bool>(&" + r(ins.a) + ".data); !flag || !*flag) {");
+                line("    " + jump(ins.b));
+                line("}");
+                break;
+            case OpCode::JumpIfEqual:
+                line("if (" + r(ins.a) + " == " + r(ins.b) + ") {");
+                line("    " + jump(ins.c));
+                line("}");
+                break;
+            case OpCode::LoopGuard:
+                line("if (++std::get<double>(" + r(ins.a) + ".data) > f.loopLimit) {");
+                line("    f.loopExceeded();");
+                line("}");
+                break;
+            case OpCode::ForInit:
+                line("{ f.forInit(" + r(ins.a) + ", " + r(ins.a + 1) + "); }");
+                break;
+            case OpCode::ForNext:
+                line("if (!f.forNext(" + r(ins.a) + ", " + r(ins.a + 1) + ", " + operand(ins.b) + ")) {");
+                line("    " + jump(ins.c));
+                line("}");
+                break;
+            case OpCode::ForInitVar:
+                line("{ f.forInitVar(" + operand(ins.b) + ", " + r(ins.a) + ", " + r(ins.a + 1) + "); }");
+                break;
+            case OpCode::ForNextVar:
+                line("if (!f.forNextVar(" + r(ins.a) + ", " + r(ins.a + 1) + ", " + operand(ins.b) + ")) {");
+                line("    " + jump(ins.c));
+                line("}");
+                break;
+            case OpCode::TryBegin:
+                line("{ f.handlers.push_back(Handler{" + operand(ins.a) + ", " + operand(ins.b) + "}); }");
+                break;
+            case OpCode::TryEnd:
+                line("{ f.handlers.pop_back(); }");
+                break;
+            case OpCode::Throw:
+                line("if (!f.raise(std::move(" + r(ins.a) + "), pc)) {");
+                line("    return Result::Thrown;");
+                line("} else {");
+                line("    continue;");
+                line("}");
+                break;
+            case OpCode::Return:
+                if (ins.a != noOperand) {
+                    line("{ f.returnValue = std::move(" + r(ins.a) + "); }");
+                }
+                line("return Result::Returned;");
+                break;
+            case OpCode::ReturnSlot:
+                line("if (auto *value = f.slot(" + operand(ins.a) + ")) {");
+                line("    f.returnValue = std::move(*value);");
+                line("} else {");
+                line("    f.returnValue = f.load(" + operand(ins.b) + ");");
+                line("}");
+                line("return Result::Returned;");
+                break;
+            case OpCode::ExecSql:
+                line("{ f.execSql(" + operand(ins.a) + "); }");
+                break;
+            case OpCode::ExecStatement:
+                line("switch (f.exec(" + operand(ins.a) + ", pc)) {");
+                line("    case Step::Next: break;");
+                line("    case Step::Resume: continue;");
+                line("    case Step::Returned: return Result::Returned;");
+                line("    case Step::Thrown: return Result::Thrown;");
+                line("}");
+                break;
+        }
+    }
+};
+
+} // namespace
+
+std::string translateRoutines(const std::vector<NativeSource> &routines) {
+    std::ostringstream out;
+    out << "// Generated by trx compile; do not edit. Build it as a shared library against the\n"
+        << "// headers of the trx that loads it.\n"
+        << "#include \"trx/runtime/Native.h\"\n\n"
+        << "using trx::runtime::JsonValue;\n"
+        << "using trx::runtime::OpCode;\n"
+        << "using trx::runtime::TrxException;\n"
+        << "using namespace trx::runtime::native;\n\n"
+        << "namespace {\n\n";
+    for (std::size_t i = 0; i < routines.size(); ++i) {
+        out << "// " << routines[i].name << "\n";
+        Translator(*routines[i].program, out).function("routine" + std::to_string(i));
+    }
+    out << "} // namespace\n\n"
+        << "extern \"C\" const Module *" << native::moduleSymbol << "() {\n";
+    if (routines.empty()) {
+        out << "    static const Module module{abiVersion, sizeof(JsonValue), 0, nullptr};\n";
+    } else {
+        out << "    static const Routine routines[] = {\n";
+        for (std::size_t i = 0; i < routines.size(); ++i) {
+            out << "        {" << quoted(routines[i].name) << ", " << quoted(fingerprint(*routines[i].program)) << ", routine" << i << "},\n";
+        }
+        out << "    };\n"
+            << "    static const Module module{abiVersion, sizeof(JsonValue), sizeof(routines) / sizeof(routines[0]), routines};\n";
+    }
+    out << "    return &module;\n"
+        << "}\n";
+    return out.str();
+}
+
+std::shared_ptr<const NativeLibrary> NativeLibrary::open(const std::filesystem::path &path) {
+    // A bare file name would be looked up on the library search path instead
+    const auto absolute = std::filesystem::absolute(path);
+    void *handle = dlopen(absolute.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        throw std::runtime_error("Unable to load native routines from " + path.string() + ": " + dlerror());
+    }
+    using ModuleFunction = const native::Module *(*)();
+    const auto moduleOf = reinterpret_cast<ModuleFunction>(dlsym(handle, native::moduleSymbol));
+    if (!moduleOf) {
+        dlclose(handle);
+        throw std::runtime_error(path.string() + " was not built by trx compile");
+    }
+    try {
+        return std::make_shared<NativeLibrary>(*moduleOf(), handle);
+    } catch (...) {
+        dlclose(handle);
+        throw;
+    }
+}
+
+NativeLibrary::NativeLibrary(const native::Module &module, void *handle) : handle_{nullptr} {
+    if (module.abiVersion != native::abiVersion || module.valueSize != sizeof(JsonValue)) {
+        throw std::runtime_error("Native routines were compiled for another version of trx; run trx compile again");
+    }
+    for (std::size_t i = 0; i < module.count; ++i) {
+        routines_.emplace(module.routines[i].name, &module.routines[i]);
+    }
+    handle_ = handle; // only owned once the module is accepted
+}
+
+NativeLibrary::~NativeLibrary() {
+    if (handle_) {
+        dlclose(handle_);
+    }
+}
+
+const native::Routine *NativeLibrary::find(const std::string &name) const {
+    const auto it = routines_.find(name);
+    return it == routines_.end() ? nullptr : it->second;
+}
+
+} // namespace trx::runtime
@@ -4,6 +4,9 @@
 #include <sqlext.h>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstring>
 
 namespace trx::runtime {
@@ -37,7 +40,8 @@ void checkODBC(SQLRETURN ret, SQLHANDLE handle, SQLSMALLINT type, const std::str
 } // namespace
 
 ODBCDriver::ODBCDriver(const DatabaseConfig& config)
-    : config_(config), env_(nullptr), connection_(nullptr) {}
+    : config_(config), env_(nullptr), connection_(nullptr),
+      preparedStatements_(config.statementCacheSize, [](SQLHSTMT& stmt) { SQLFreeHandle(SQL_HANDLE_STMT, stmt); }) {}
 
 ODBCDriver::~ODBCDriver() {
     // Clean up cursors
@@ -49,6 +53,7 @@ ODBCDriver::~ODBCDriver() {
     statements_.clear();
     cursorSql_.clear();
     executed_.clear();
+    preparedStatements_.clear();
 
     if (connection_) {
         SQLDisconnect(connection_);
@@ -87,85 +92,181 @@ void ODBCDriver::initialize() {
 }
 
 void ODBCDriver::executeSql(const std::string& sql, const std::vector<SqlParameter>& params) {
-    SQLHSTMT stmt;
-    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, connection_, &stmt);
-    checkODBC(ret, connection_, SQL_HANDLE_DBC, "SQLAllocHandle(STMT)");
+    SQLHSTMT stmt = acquireStatement(sql);
+    ParamStorage storage;
 
     try {
-        // Prepare statement
-        ret = SQLPrepare(stmt, reinterpret_cast<SQLCHAR*>(const_cast<char*>(sql.c_str())), SQL_NTS);
-        checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLPrepare");
-
-        // Bind parameters
-        for (size_t i = 0; i < params.size(); ++i) {
-            const auto& param = params[i];
-            SQLLEN indicator = SQL_NTS;
-
-            if (std::holds_alternative<double>(param.value.data)) {
-                double val = std::get<double>(param.value.data);
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_DOUBLE, 0, 0, &val, 0, &indicator);
-            } else if (std::holds_alternative<std::string>(param.value.data)) {
-                const std::string& val = std::get<std::string>(param.value.data);
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, val.size(), 0,
-                                     const_cast<char*>(val.c_str()), val.size(), &indicator);
-            } else if (std::holds_alternative<bool>(param.value.data)) {
-                bool val = std::get<bool>(param.value.data);
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_BIT, SQL_BIT, 0, 0, &val, 0, &indicator);
-            } else {
-                indicator = SQL_NULL_DATA;
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, 0, 0, nullptr, 0, &indicator);
-            }
-            checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLBindParameter");
-        }
+        bindParameters(stmt, params, storage);
 
         // Execute
-        ret = SQLExecute(stmt);
+        SQLRETURN ret = execute(stmt);
         checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLExecute");
 
     } catch (...) {
-        SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+        releaseStatement(stmt);
         throw;
     }
 
-    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    releaseStatement(stmt);
 }
 
-std::vector<std::vector<SqlValue>> ODBCDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
-    SQLHSTMT stmt;
-    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, connection_, &stmt);
-    checkODBC(ret, connection_, SQL_HANDLE_DBC, "SQLAllocHandle(STMT)");
+std::vector<std::size_t> ODBCDriver::executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) {
+    if (paramSets.size() < 2) {
+        return DatabaseDriver::executeBatch(sql, paramSets);
+    }
 
-    std::vector<std::vector<SqlValue>> results;
+    // Column-wise parameter arrays need one C type per parameter across all sets;
+    // ragged or mixed-type batches run set by set instead
+    struct ParamColumn {
+        SQLSMALLINT cType{SQL_C_CHAR};
+        SQLSMALLINT sqlType{SQL_VARCHAR};
+        SQLLEN width{1};
+        std::vector<char> data;       // paramSets.size() cells of width bytes
+        std::vector<SQLLEN> indicators;
+    };
+    const std::size_t count = paramSets.size();
+    const std::size_t paramCount = paramSets.front().size();
+    std::vector<ParamColumn> columns(paramCount);
+    // Bound like bindParameters: anything but numbers, strings and booleans goes in as NULL
+    const auto cTypeOf = [](const SqlValue& value) -> SQLSMALLINT {
+        if (std::holds_alternative<double>(value.data)) {
+            return SQL_C_DOUBLE;
+        }
+        if (std::holds_alternative<std::string>(value.data)) {
+            return SQL_C_CHAR;
+        }
+        if (std::holds_alternative<bool>(value.data)) {
+            return SQL_C_LONG;
+        }
+        return 0;
+    };
+    for (std::size_t col = 0; col < paramCount; ++col) {
+        auto& column = columns[col];
+        SQLSMALLINT cType = 0;
+        for (const auto& params : paramSets) {
+            if (params.size() != paramCount) {
+                return DatabaseDriver::executeBatch(sql, paramSets);
+            }
+            const SQLSMALLINT type = cTypeOf(params[col].value);
+            if (type == 0) {
+                continue;
+            }
+            if (cType != 0 && cType != type) {
+                return DatabaseDriver::executeBatch(sql, paramSets);
+            }
+            cType = type;
+            if (type == SQL_C_CHAR) {
+                column.width = std::max<SQLLEN>(column.width, params[col].value.asString().size() + 1);
+            }
+        }
 
-    try {
-        // Prepare statement
-        ret = SQLPrepare(stmt, reinterpret_cast<SQLCHAR*>(const_cast<char*>(sql.c_str())), SQL_NTS);
-        checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLPrepare");
+        if (cType == SQL_C_DOUBLE) {
+            column.cType = SQL_C_DOUBLE;
+            column.sqlType = SQL_DOUBLE;
+            column.width = sizeof(double);
+        } else if (cType == SQL_C_LONG) {
+            column.cType = SQL_C_LONG;
+            column.sqlType = SQL_INTEGER;
+            column.width = sizeof(long);
+        }
+        column.data.assign(count * column.width, '\0');
+        column.indicators.assign(count, SQL_NULL_DATA);
+        for (std::size_t row = 0; row < count; ++row) {
+            const auto& data = paramSets[row][col].value.data;
+            char* cell = &column.data[row * column.width];
+            if (std::holds_alternative<double>(data)) {
+                const double value = std::get<double>(data);
+                std::memcpy(cell, &value, sizeof(value));
+                column.indicators[row] = 0;
+            } else if (std::holds_alternative<bool>(data)) {
+                const long value = std::get<bool>(data) ? 1 : 0;
+                std::memcpy(cell, &value, sizeof(value));
+                column.indicators[row] = 0;
+            } else if (std::holds_alternative<std::string>(data)) {
+                const auto& value = std::get<std::string>(data);
+                std::memcpy(cell, value.c_str(), value.size() + 1);
+                column.indicators[row] = SQL_NTS;
+            }
+        }
+    }
 
-        // Bind parameters
-        for (size_t i = 0; i < params.size(); ++i) {
-            const auto& param = params[i];
-            SQLLEN indicator = SQL_NTS;
+    SQLHSTMT stmt = acquireStatement(sql);
+    std::vector<SQLUSMALLINT> status(count, SQL_PARAM_UNUSED);
+    SQLULEN processed = 0;
+    SQLRETURN ret = SQLSetStmtAttr(stmt, SQL_ATTR_PARAM_BIND_TYPE, reinterpret_cast<SQLPOINTER>(SQL_PARAM_BIND_BY_COLUMN), 0);
+    if (ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
+        ret = SQLSetStmtAttr(stmt, SQL_ATTR_PARAMSET_SIZE, reinterpret_cast<SQLPOINTER>(count), 0);
+    }
+    const auto resetParamArrays = [&]() {
+        // The handle goes back to the statement cache; later executions bind single sets
+        SQLSetStmtAttr(stmt, SQL_ATTR_PARAMSET_SIZE, reinterpret_cast<SQLPOINTER>(1), 0);
+        SQLSetStmtAttr(stmt, SQL_ATTR_PARAM_STATUS_PTR, nullptr, 0);
+        SQLSetStmtAttr(stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, 0);
+        releaseStatement(stmt);
+    };
+    if (ret != SQL_SUCCESS) {
+        // Driver without parameter arrays, or one that lowered the set size
+        resetParamArrays();
+        return DatabaseDriver::executeBatch(sql, paramSets);
+    }
+    SQLSetStmtAttr(stmt, SQL_ATTR_PARAM_STATUS_PTR, status.data(), 0);
+    SQLSetStmtAttr(stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &processed, 0);
 
-            if (std::holds_alternative<double>(param.value.data)) {
-                double val = std::get<double>(param.value.data);
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_DOUBLE, 0, 0, &val, 0, &indicator);
-            } else if (std::holds_alternative<std::string>(param.value.data)) {
-                const std::string& val = std::get<std::string>(param.value.data);
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, val.size(), 0, 
-                                     const_cast<char*>(val.c_str()), val.size(), &indicator);
-            } else if (std::holds_alternative<bool>(param.value.data)) {
-                bool val = std::get<bool>(param.value.data);
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_BIT, SQL_BIT, 0, 0, &val, 0, &indicator);
-            } else {
-                indicator = SQL_NULL_DATA;
-                ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, 0, 0, nullptr, 0, &indicator);
-            }
+    try {
+        for (std::size_t col = 0; col < paramCount; ++col) {
+            auto& column = columns[col];
+            const SQLULEN columnSize = column.cType == SQL_C_CHAR ? column.width - 1 : 0;
+            ret = SQLBindParameter(stmt, col + 1, SQL_PARAM_INPUT, column.cType, column.sqlType, columnSize, 0,
+                                   column.data.data(), column.width, column.indicators.data());
             checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLBindParameter");
         }
+        ret = execute(stmt);
+    } catch (...) {
+        resetParamArrays();
+        throw;
+    }
+    resetParamArrays();
+
+    std::vector<std::size_t> failed;
+    if (ret == SQL_SUCCESS || ret == SQL_NO_DATA) {
+        return failed;
+    }
+    // Drivers differ in whether they continue past a failing set; anything
+    // left unprocessed is executed on its own
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i < processed && status[i] != SQL_PARAM_UNUSED) {
+            if (status[i] == SQL_PARAM_ERROR || status[i] == SQL_PARAM_DIAG_UNAVAILABLE) {
+                failed.push_back(i);
+            }
+            continue;
+        }
+        try {
+            executeSql(sql, paramSets[i]);
+        } catch (const std::exception&) {
+            failed.push_back(i);
+        }
+    }
+    return failed;
+}
+
+std::vector<std::vector<SqlValue>> ODBCDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    std::vector<std::vector<SqlValue>> results;
+    queryRows(sql, params, [&](const std::vector<SqlValue>& row) {
+        results.push_back(row);
+        return true;
+    });
+    return results;
+}
+
+void ODBCDriver::queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) {
+    SQLHSTMT stmt = acquireStatement(sql);
+    ParamStorage storage;
+
+    try {
+        bindParameters(stmt, params, storage);
 
         // Execute
-        ret = SQLExecute(stmt);
+        SQLRETURN ret = execute(stmt);
         checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLExecute");
 
         // Get column count
@@ -173,37 +274,37 @@ std::vector<std::vector<SqlValue>> ODBCDriver::querySql(const std::string& sql,
         ret = SQLNumResultCols(stmt, &numCols);
         checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLNumResultCols");
 
-        // Fetch rows
-        while ((ret = SQLFetch(stmt)) == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
-            std::vector<SqlValue> row;
+        // Fetch rows; releaseStatement closes the result set if the callback stops early
+        std::vector<SqlValue> row(numCols); // Reused for every row
+        bool wanted = true;
+        while (wanted && ((ret = SQLFetch(stmt)) == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO)) {
             for (SQLSMALLINT i = 1; i <= numCols; ++i) {
                 SQLLEN indicator;
                 char buffer[1024];
                 ret = SQLGetData(stmt, i, SQL_C_CHAR, buffer, sizeof(buffer), &indicator);
                 if (ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
                     if (indicator == SQL_NULL_DATA) {
-                        row.emplace_back(nullptr);
+                        row[i - 1] = SqlValue(nullptr);
                     } else {
-                        row.emplace_back(std::string(buffer));
+                        row[i - 1] = SqlValue(std::string(buffer));
                     }
                 } else {
                     checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLGetData");
                 }
             }
-            results.push_back(std::move(row));
+            wanted = onRow(row);
         }
 
-        if (ret != SQL_NO_DATA) {
+        if (wanted && ret != SQL_NO_DATA) {
             checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLFetch");
         }
 
     } catch (...) {
-        SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+        releaseStatement(stmt);
         throw;
     }
 
-    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
-    return results;
+    releaseStatement(stmt);
 }
 
 void ODBCDriver::openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
@@ -378,13 +479,32 @@ bool ODBCDriver::cursorNext(const std::string& name) {
     }
 
     if (!executed_[name]) {
-        SQLRETURN ret = SQLExecute(it->second);
+        prepareRowBlock(name, it->second);
+        SQLRETURN ret = execute(it->second);
         checkODBC(ret, it->second, SQL_HANDLE_STMT, "SQLExecute");
         executed_[name] = true;
     }
 
+    auto blockIt = blocks_.find(name);
+    if (blockIt != blocks_.end()) {
+        RowBlock& block = blockIt->second;
+        if (block.columns == 0) {
+            bindRowBlock(block, it->second);
+        }
+        // Serve the next row of the current rowset before going back to the driver
+        if (block.currentRow < block.rowsFetched) {
+            ++block.currentRow;
+            // Keep positioned updates pointing at the row the program sees
+            SQLSetPos(it->second, static_cast<SQLSETPOSIROW>(block.currentRow), SQL_POSITION, SQL_LOCK_NO_CHANGE);
+            return true;
+        }
+    }
+
     SQLRETURN ret = SQLFetch(it->second);
     if (ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
+        if (blockIt != blocks_.end()) {
+            blockIt->second.currentRow = 1;
+        }
         return true;
     } else if (ret == SQL_NO_DATA) {
         return false;
@@ -402,6 +522,23 @@ std::vector<SqlValue> ODBCDriver::cursorGetRow(const std::string& name) {
 
     SQLHSTMT stmt = it->second;
 
+    auto blockIt = blocks_.find(name);
+    if (blockIt != blocks_.end() && blockIt->second.currentRow > 0) {
+        const RowBlock& block = blockIt->second;
+        const SQLULEN row = block.currentRow - 1;
+        std::vector<SqlValue> values;
+        values.reserve(block.columns);
+        for (SQLSMALLINT col = 0; col < block.columns; ++col) {
+            const SQLULEN cell = static_cast<SQLULEN>(col) * block.arraySize + row;
+            if (block.indicators[cell] == SQL_NULL_DATA) {
+                values.emplace_back(nullptr);
+            } else {
+                values.emplace_back(std::string(&block.data[cell * columnWidth]));
+            }
+        }
+        return values;
+    }
+
     // Get column count
     SQLSMALLINT numCols;
     SQLRETURN ret = SQLNumResultCols(stmt, &numCols);
@@ -426,6 +563,61 @@ std::vector<SqlValue> ODBCDriver::cursorGetRow(const std::string& name) {
     return row;
 }
 
+void ODBCDriver::prepareRowBlock(const std::string& name, SQLHSTMT stmt) {
+    blocks_.erase(name);
+    if (config_.cursorFetchSize <= 1) {
+        return;
+    }
+    // Positioned updates through FOR UPDATE cursors stay on single-row fetches
+    auto sqlIt = cursorSql_.find(name);
+    if (sqlIt != cursorSql_.end()) {
+        std::string upper = sqlIt->second;
+        std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char ch) {
+            return static_cast<char>(std::toupper(ch));
+        });
+        if (upper.find("FOR UPDATE") != std::string::npos) {
+            return;
+        }
+    }
+
+    RowBlock& block = blocks_[name];
+    block.arraySize = config_.cursorFetchSize;
+    block.rowStatus.resize(block.arraySize);
+    SQLRETURN ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_BIND_TYPE, reinterpret_cast<SQLPOINTER>(SQL_BIND_BY_COLUMN), 0);
+    if (ret == SQL_SUCCESS || ret == SQL_SUCCESS_WITH_INFO) {
+        ret = SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE, reinterpret_cast<SQLPOINTER>(block.arraySize), 0);
+    }
+    if (ret != SQL_SUCCESS && ret != SQL_SUCCESS_WITH_INFO) {
+        // Driver without block cursor support: fall back to SQLGetData per row
+        SQLSetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE, reinterpret_cast<SQLPOINTER>(1), 0);
+        blocks_.erase(name);
+        return;
+    }
+    // A driver may lower the requested size (SQL_SUCCESS_WITH_INFO); size buffers to what it uses
+    SQLULEN actual = block.arraySize;
+    if (SQLGetStmtAttr(stmt, SQL_ATTR_ROW_ARRAY_SIZE, &actual, 0, nullptr) == SQL_SUCCESS && actual > 0) {
+        block.arraySize = actual;
+        block.rowStatus.resize(actual);
+    }
+    SQLSetStmtAttr(stmt, SQL_ATTR_ROWS_FETCHED_PTR, &block.rowsFetched, 0);
+    SQLSetStmtAttr(stmt, SQL_ATTR_ROW_STATUS_PTR, block.rowStatus.data(), 0);
+}
+
+void ODBCDriver::bindRowBlock(RowBlock& block, SQLHSTMT stmt) {
+    SQLSMALLINT numCols;
+    SQLRETURN ret = SQLNumResultCols(stmt, &numCols);
+    checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLNumResultCols");
+
+    block.columns = numCols;
+    block.data.assign(static_cast<size_t>(numCols) * block.arraySize * columnWidth, '\0');
+    block.indicators.assign(static_cast<size_t>(numCols) * block.arraySize, 0);
+    for (SQLSMALLINT col = 0; col < numCols; ++col) {
+        const size_t first = static_cast<size_t>(col) * block.arraySize;
+        ret = SQLBindCol(stmt, col + 1, SQL_C_CHAR, &block.data[first * columnWidth], columnWidth, &block.indicators[first]);
+        checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLBindCol");
+    }
+}
+
 void ODBCDriver::closeCursor(const std::string& name) {
     auto it = statements_.find(name);
     if (it != statements_.end()) {
@@ -433,6 +625,7 @@ void ODBCDriver::closeCursor(const std::string& name) {
         statements_.erase(it);
     }
     executed_.erase(name);
+    blocks_.erase(name);
     // Don't erase cursorSql_ - we need it for reopening with OPEN USING
     // cursorSql_.erase(name);
     paramStorage_.erase(name);
@@ -506,6 +699,99 @@ void ODBCDriver::rollbackTransaction() {
     checkODBC(ret, connection_, SQL_HANDLE_DBC, "SQLSetConnectAttr");
 }
 
+void ODBCDriver::setDeadline(const Deadline& deadline) {
+    deadline_ = deadline;
+}
+
+SQLRETURN ODBCDriver::execute(SQLHSTMT stmt) {
+    // SQL_ATTR_QUERY_TIMEOUT counts whole seconds, so what is left is rounded up; past the
+    // deadline only clean-up runs, which is left without a timeout
+    SQLULEN seconds = 0;
+    if (deadline_.isSet() && !deadline_.expired()) {
+        seconds = static_cast<SQLULEN>(std::chrono::ceil<std::chrono::seconds>(deadline_.remaining()).count());
+    }
+    SQLSetStmtAttr(stmt, SQL_ATTR_QUERY_TIMEOUT, reinterpret_cast<SQLPOINTER>(seconds), 0);
+    return SQLExecute(stmt);
+}
+
+StatementCacheStats ODBCDriver::statementCacheStats() const {
+    return preparedStatements_.stats();
+}
+
+SQLHSTMT ODBCDriver::acquireStatement(const std::string& sql) {
+    if (preparedStatements_.enabled()) {
+        if (auto* cached = preparedStatements_.find(sql)) {
+            return *cached;
+        }
+    }
+
+    SQLHSTMT stmt;
+    SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, connection_, &stmt);
+    checkODBC(ret, connection_, SQL_HANDLE_DBC, "SQLAllocHandle(STMT)");
+
+    try {
+        ret = SQLPrepare(stmt, reinterpret_cast<SQLCHAR*>(const_cast<char*>(sql.c_str())), SQL_NTS);
+        checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLPrepare");
+    } catch (...) {
+        SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+        throw;
+    }
+
+    if (preparedStatements_.enabled()) {
+        preparedStatements_.insert(sql, stmt);
+    }
+    return stmt;
+}
+
+void ODBCDriver::releaseStatement(SQLHSTMT stmt) {
+    if (preparedStatements_.enabled()) {
+        // Close the result set and drop bindings to the caller's ParamStorage;
+        // the prepared plan stays on the handle for the next execution.
+        SQLFreeStmt(stmt, SQL_CLOSE);
+        SQLFreeStmt(stmt, SQL_RESET_PARAMS);
+    } else {
+        SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    }
+}
+
+void ODBCDriver::bindParameters(SQLHSTMT stmt, const std::vector<SqlParameter>& params, ParamStorage& storage) {
+    // Bound buffers must stay put until SQLExecute, so reserve up front
+    storage.doubles.reserve(params.size());
+    storage.strings.reserve(params.size());
+    storage.bools.reserve(params.size());
+    storage.indicators.reserve(params.size());
+
+    for (size_t i = 0; i < params.size(); ++i) {
+        const auto& param = params[i];
+        SQLRETURN ret;
+
+        if (std::holds_alternative<double>(param.value.data)) {
+            storage.doubles.push_back(std::get<double>(param.value.data));
+            storage.indicators.push_back(0);
+            ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_DOUBLE, 0, 0,
+                                 &storage.doubles.back(), 0, &storage.indicators.back());
+        } else if (std::holds_alternative<std::string>(param.value.data)) {
+            storage.strings.push_back(std::get<std::string>(param.value.data));
+            storage.indicators.push_back(SQL_NTS);
+            ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR,
+                                 storage.strings.back().size(), 0,
+                                 const_cast<char*>(storage.strings.back().c_str()),
+                                 storage.strings.back().size(),
+                                 &storage.indicators.back());
+        } else if (std::holds_alternative<bool>(param.value.data)) {
+            storage.bools.push_back(std::get<bool>(param.value.data) ? 1 : 0);
+            storage.indicators.push_back(0);
+            ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_LONG, SQL_INTEGER, 0, 0,
+                                 &storage.bools.back(), 0, &storage.indicators.back());
+        } else {
+            storage.indicators.push_back(SQL_NULL_DATA);
+            ret = SQLBindParameter(stmt, i + 1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, 0, 0,
+                                 nullptr, 0, &storage.indicators.back());
+        }
+        checkODBC(ret, stmt, SQL_HANDLE_STMT, "SQLBindParameter");
+    }
+}
+
 std::vector<TableColumn> ODBCDriver::getTableSchema(const std::string& tableName) {
     SQLHSTMT stmt;
     SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_STMT, connection_, &stmt);
@@ -1,14 +1,33 @@
 #include "trx/runtime/PostgreSQLDriver.h"
+#include "trx/runtime/Fiber.h"
+#include "trx/runtime/PostgreSQLValues.h"
 
 #include <postgresql/libpq-fe.h>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <limits>
+#include <optional>
 
 namespace trx::runtime {
 
 namespace {
 
+using postgres::dateValue;
+using postgres::numericValue;
+using postgres::readBigEndian;
+using postgres::readInt16;
+using postgres::readInt32;
+using postgres::readInt64;
+using postgres::timestampValue;
+
 // Helper function to check PostgreSQL result
 void checkPGresult(PGresult* res, PGconn* conn, const std::string& operation) {
     if (!res || (PQresultStatus(res) != PGRES_COMMAND_OK && PQresultStatus(res) != PGRES_TUPLES_OK)) {
@@ -19,10 +38,290 @@ void checkPGresult(PGresult* res, PGconn* conn, const std::string& operation) {
     }
 }
 
+// Asks the server to stop the statement running on |conn|; if the request does not get
+// through, the statement runs on until the transaction's statement_timeout
+void cancelStatement(PGconn* conn) {
+    if (PGcancel* cancel = PQgetCancel(conn)) {
+        char error[256];
+        PQcancel(cancel, error, sizeof(error));
+        PQfreeCancel(cancel);
+    }
+}
+
+// The next result, waiting for the server through waitForIo so that a fiber gives its
+// thread up meanwhile; PQgetResult itself then has nothing left to block on. Should
+// |deadline| pass first, the statement is cancelled and the deadline cleared: the server
+// then ends the statement with an error, which is waited for like any other result.
+PGresult* nextResult(PGconn* conn, Deadline& deadline) {
+    while (PQisBusy(conn)) {
+        if (!deadline.isSet()) {
+            waitForIo(PQsocket(conn), POLLIN);
+        } else if (!waitForIo(PQsocket(conn), POLLIN, deadline.remaining())) {
+            cancelStatement(conn);
+            deadline = {};
+            continue;
+        }
+        if (!PQconsumeInput(conn)) {
+            break; // PQgetResult reports the broken connection
+        }
+    }
+    return PQgetResult(conn);
+}
+
+// What PQexec would return for the command just sent: the first error, else the last result
+PGresult* awaitResult(PGconn* conn, Deadline deadline) {
+    PGresult* kept = nullptr;
+    while (PGresult* res = nextResult(conn, deadline)) {
+        const ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_COPY_IN || status == PGRES_COPY_OUT || status == PGRES_COPY_BOTH) {
+            PQclear(kept);
+            return res;
+        }
+        const ExecStatusType keptStatus = kept ? PQresultStatus(kept) : PGRES_EMPTY_QUERY;
+        if (keptStatus == PGRES_FATAL_ERROR || keptStatus == PGRES_BAD_RESPONSE) {
+            PQclear(res);
+            continue;
+        }
+        PQclear(kept);
+        kept = res;
+    }
+    return kept;
+}
+
+// PQexec, waiting through waitForIo; null when the command could not be sent
+PGresult* execQuery(PGconn* conn, const char* sql, const Deadline& deadline) {
+    return PQsendQuery(conn, sql) ? awaitResult(conn, deadline) : nullptr;
+}
+
+// std::stod without the exception: a leading number, or nothing when there is none
+std::optional<double> parseNumber(const char* text) {
+    char* end = nullptr;
+    errno = 0;
+    const double value = std::strtod(text, &end);
+    if (end == text || errno == ERANGE) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Type OIDs from pg_type.h, which libpq does not install
+constexpr Oid boolOid = 16;
+constexpr Oid nameOid = 19;
+constexpr Oid int8Oid = 20;
+constexpr Oid int2Oid = 21;
+constexpr Oid int4Oid = 23;
+constexpr Oid textOid = 25;
+constexpr Oid oidOid = 26;
+constexpr Oid float4Oid = 700;
+constexpr Oid float8Oid = 701;
+constexpr Oid bpcharOid = 1042;
+constexpr Oid varcharOid = 1043;
+constexpr Oid dateOid = 1082;
+constexpr Oid timestampOid = 1114;
+constexpr Oid timestampTzOid = 1184;
+constexpr Oid numericOid = 1700;
+
+// Whether cellValue can read a column of this type in binary format
+bool hasBinaryDecoder(Oid type) {
+    switch (type) {
+        case boolOid: case nameOid: case int8Oid: case int2Oid: case int4Oid: case textOid: case oidOid:
+        case float4Oid: case float8Oid: case bpcharOid: case varcharOid: case dateOid: case timestampOid:
+        case timestampTzOid: case numericOid:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// A text cell of a type without a decoder of its own: t/f become booleans, numeric text a number
+SqlValue guessedValue(const char* text) {
+    if ((text[0] == 't' || text[0] == 'f') && text[1] == '\0') {
+        return SqlValue(text[0] == 't');
+    }
+    if (auto number = parseNumber(text)) {
+        return SqlValue(*number);
+    }
+    return SqlValue(std::string(text));
+}
+
+SqlValue binaryValue(const char* data, int length, Oid type) {
+    switch (type) {
+        case boolOid:
+            return length == 1 ? SqlValue(data[0] != 0) : SqlValue(nullptr);
+        case int2Oid:
+            return length == 2 ? SqlValue(static_cast<double>(readInt16(data))) : SqlValue(nullptr);
+        case int4Oid:
+            return length == 4 ? SqlValue(static_cast<double>(readInt32(data))) : SqlValue(nullptr);
+        case oidOid:
+            return length == 4 ? SqlValue(static_cast<double>(readBigEndian(data, 4))) : SqlValue(nullptr);
+        case int8Oid:
+            return length == 8 ? SqlValue(static_cast<double>(readInt64(data))) : SqlValue(nullptr);
+        case float4Oid: {
+            if (length != 4) {
+                return SqlValue(nullptr);
+            }
+            const auto bits = static_cast<std::uint32_t>(readBigEndian(data, 4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return SqlValue(static_cast<double>(value));
+        }
+        case float8Oid: {
+            if (length != 8) {
+                return SqlValue(nullptr);
+            }
+            const std::uint64_t bits = readBigEndian(data, 8);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return SqlValue(value);
+        }
+        case numericOid:
+            return numericValue(data, length);
+        case dateOid:
+            return dateValue(data, length);
+        case timestampOid:
+        case timestampTzOid:
+            return timestampValue(data, length, type == timestampTzOid);
+        default:
+            return SqlValue(std::string(data, length)); // text, varchar, bpchar and name are sent as is
+    }
+}
+
+// Convert a result cell by its column's type: numbers become doubles, bool a boolean,
+// character types, dates and timestamps strings. Binary cells come from prepared statements
+// whose columns all have a decoder; other types arrive as text and are guessed at. Text dates
+// and timestamps match the decoded ones because initialize() pins DateStyle and TimeZone.
+SqlValue cellValue(PGresult* res, int row, int column, Oid type) {
+    if (PQgetisnull(res, row, column)) {
+        return SqlValue(nullptr);
+    }
+    const char* data = PQgetvalue(res, row, column);
+    if (PQfformat(res, column) == 1) {
+        return binaryValue(data, PQgetlength(res, row, column), type);
+    }
+    switch (type) {
+        case boolOid:
+            return SqlValue(data[0] == 't');
+        case int2Oid: case int4Oid: case int8Oid: case oidOid: case float4Oid: case float8Oid: case numericOid:
+            if (auto number = parseNumber(data)) {
+                return SqlValue(*number);
+            }
+            return SqlValue(std::string(data));
+        case textOid: case varcharOid: case bpcharOid: case nameOid: case dateOid: case timestampOid: case timestampTzOid:
+            return SqlValue(std::string(data));
+        default:
+            return guessedValue(data);
+    }
+}
+
+// The type of every column of a result, looked up once rather than per cell
+std::vector<Oid> columnTypes(PGresult* res) {
+    std::vector<Oid> types(PQnfields(res));
+    for (int j = 0; j < static_cast<int>(types.size()); ++j) {
+        types[j] = PQftype(res, j);
+    }
+    return types;
+}
+
+// Text-format parameter arrays for PQsendQueryParams/PQsendQueryPrepared
+struct TextParams {
+    std::vector<std::string> strings;
+    std::vector<const char*> values;
+    std::vector<int> lengths;
+    std::vector<int> formats;
+};
+
+TextParams buildTextParams(const std::vector<SqlParameter>& params) {
+    TextParams text;
+    text.strings.reserve(params.size()); // prevent reallocation that invalidates c_str()
+    text.values.reserve(params.size());
+    text.lengths.reserve(params.size());
+    text.formats.reserve(params.size());
+    for (const auto& param : params) {
+        if (std::holds_alternative<std::string>(param.value.data)) {
+            text.strings.push_back(std::get<std::string>(param.value.data));
+            text.values.push_back(text.strings.back().c_str());
+        } else if (std::holds_alternative<double>(param.value.data)) {
+            double num = std::get<double>(param.value.data);
+            // Check if it's a whole number (integer)
+            if (num == static_cast<long long>(num)) {
+                // Format as integer
+                text.strings.push_back(std::to_string(static_cast<long long>(num)));
+            } else {
+                // Format as decimal
+                text.strings.push_back(std::to_string(num));
+            }
+            text.values.push_back(text.strings.back().c_str());
+        } else if (std::holds_alternative<bool>(param.value.data)) {
+            text.strings.push_back(std::get<bool>(param.value.data) ? "true" : "false");
+            text.values.push_back(text.strings.back().c_str());
+        } else {
+            text.values.push_back(nullptr);
+        }
+        text.lengths.push_back(0); // 0 for text format (null-terminated)
+        text.formats.push_back(0); // text format
+    }
+    return text;
+}
+
+// Convert ? placeholders to $1, $2, etc. for PostgreSQL
+std::string convertPlaceholders(const std::string& sql) {
+    std::string convertedSql = sql;
+    size_t pos = 0;
+    int paramIndex = 1;
+    while ((pos = convertedSql.find('?', pos)) != std::string::npos) {
+        std::string replacement = "$" + std::to_string(paramIndex++);
+        convertedSql.replace(pos, 1, replacement);
+        pos += replacement.length();
+    }
+    return convertedSql;
+}
+
+// First word of a statement, upper-cased
+std::string leadingKeyword(const std::string& sql) {
+    size_t start = sql.find_first_not_of(" \t\n\r(");
+    if (start == std::string::npos) {
+        return {};
+    }
+    size_t end = start;
+    while (end < sql.size() && std::isalpha(static_cast<unsigned char>(sql[end]))) {
+        ++end;
+    }
+    std::string keyword = sql.substr(start, end - start);
+    for (auto& c : keyword) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return keyword;
+}
+
+// Only plannable DML is worth a server-side prepared statement; utility commands
+// (BEGIN, SAVEPOINT, DDL, ...) cannot benefit and some cannot be prepared at all.
+// DECLARE ... CURSOR is the exception: its query is parsed and analyzed when it is
+// prepared, and takes the values bound when it is executed.
+bool isPreparable(const std::string& sql) {
+    const std::string keyword = leadingKeyword(sql);
+    return keyword == "SELECT" || keyword == "INSERT" || keyword == "UPDATE" ||
+           keyword == "DELETE" || keyword == "WITH" || keyword == "VALUES" || keyword == "DECLARE";
+}
+
+std::string toUpperCopy(std::string value) {
+    for (auto& c : value) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return value;
+}
+
+// Writes whose outcome only feeds SQLCODE, which pipeline mode may send ahead
+bool isQueueable(const std::string& sql) {
+    const std::string keyword = leadingKeyword(sql);
+    return (keyword == "INSERT" || keyword == "UPDATE" || keyword == "DELETE") &&
+           toUpperCopy(sql).find("CURRENT OF") == std::string::npos;
+}
+
 } // namespace
 
 PostgreSQLDriver::PostgreSQLDriver(const DatabaseConfig& config)
-    : config_(config), conn_(nullptr) {}
+    : config_(config), conn_(nullptr),
+      statements_(config.statementCacheSize, [this](PreparedStatement& statement) { deallocateStatement(statement.name); }) {}
 
 PostgreSQLDriver::~PostgreSQLDriver() {
     // Clean up cursors - close any open cursors
@@ -38,8 +337,13 @@ PostgreSQLDriver::~PostgreSQLDriver() {
     cursors_.clear();
     cursorSql_.clear();
     currentRows_.clear();
+    for (auto& [name, batch] : batches_) {
+        PQclear(batch.rows);
+    }
+    batches_.clear();
 
     if (conn_) {
+        // Prepared statements live in the session and go away with it
         PQfinish(conn_);
         conn_ = nullptr;
     }
@@ -56,7 +360,15 @@ void PostgreSQLDriver::initialize() {
                    " dbname=" + config_.databaseName + " user=" + config_.username +
                    " password=" + config_.password;
     }
-    conn_ = PQconnectdb(conninfo.c_str());
+    // Polled rather than PQconnectdb, so a fiber gives its thread up during the handshake
+    conn_ = PQconnectStart(conninfo.c_str());
+    if (conn_ && PQstatus(conn_) != CONNECTION_BAD) {
+        PostgresPollingStatusType polling = PGRES_POLLING_WRITING;
+        while (polling != PGRES_POLLING_OK && polling != PGRES_POLLING_FAILED) {
+            waitForIo(PQsocket(conn_), polling == PGRES_POLLING_READING ? POLLIN : POLLOUT);
+            polling = PQconnectPoll(conn_);
+        }
+    }
     if (PQstatus(conn_) != CONNECTION_OK) {
         std::stringstream ss;
         ss << "PostgreSQL connection failed: " << PQerrorMessage(conn_);
@@ -64,10 +376,25 @@ void PostgreSQLDriver::initialize() {
         conn_ = nullptr;
         throw std::runtime_error(ss.str());
     }
+
+    // Binary dates and timestamps are decoded to ISO text in UTC. Text results (a statement's
+    // first run, a cursor's first batch) are printed by the server in the session's style,
+    // so pin it to the same one, whichever format a cell arrives in
+    PGresult* res = execQuery(conn_, "SET TimeZone = 'UTC'; SET DateStyle = 'ISO, YMD'", Deadline{});
+    if (!res || PQresultStatus(res) != PGRES_COMMAND_OK) {
+        std::string error = PQerrorMessage(conn_);
+        PQclear(res);
+        PQfinish(conn_);
+        conn_ = nullptr;
+        throw std::runtime_error("PostgreSQL connection setup failed: " + error);
+    }
+    PQclear(res);
     std::cout << "PostgreSQLDriver: Connected to database" << std::endl;
 }
 
 void PostgreSQLDriver::executeSql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    drainQueued();
+
     // Check transaction state and handle error conditions
     PGTransactionStatusType txStatus = PQtransactionStatus(conn_);
     
@@ -84,7 +411,7 @@ void PostgreSQLDriver::executeSql(const std::string& sql, const std::vector<SqlP
             savepointName = savepointName.substr(firstNonSpace);
         }
         std::string rollbackSql = "ROLLBACK TO SAVEPOINT " + savepointName;
-        PGresult* res = PQexec(conn_, rollbackSql.c_str());
+        PGresult* res = execQuery(conn_, rollbackSql.c_str(), statementDeadline());
         if (!res || (PQresultStatus(res) != PGRES_COMMAND_OK)) {
             std::string error = PQerrorMessage(conn_);
             PQclear(res);
@@ -100,341 +427,357 @@ void PostgreSQLDriver::executeSql(const std::string& sql, const std::vector<SqlP
     // 2. ROLLBACK (to end the transaction)
     // The Interpreter's exception handling will decide which is appropriate.
     
-    // Convert ? placeholders to $1, $2, etc. for PostgreSQL
-    std::string convertedSql = sql;
-    size_t pos = 0;
-    int paramIndex = 1;
-    while ((pos = convertedSql.find('?', pos)) != std::string::npos) {
-        std::string replacement = "$" + std::to_string(paramIndex++);
-        convertedSql.replace(pos, 1, replacement);
-        pos += replacement.length();
+    PGresult* res = execParams(sql, params);
+    checkPGresult(res, conn_, "executeSql");
+    PQclear(res);
+}
+
+std::vector<std::size_t> PostgreSQLDriver::executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) {
+    drainQueued();
+    // Savepoint handling and cursor positioning live in executeSql; they are never batched
+    if (paramSets.size() < 2 || !isPreparable(sql) || PQtransactionStatus(conn_) == PQTRANS_INERROR ||
+        toUpperCopy(sql).find("CURRENT OF") != std::string::npos) {
+        return DatabaseDriver::executeBatch(sql, paramSets);
     }
 
-    std::vector<std::string> paramStrings;
-    std::vector<const char*> paramValues;
-    std::vector<int> paramLengths;
-    std::vector<int> paramFormats;
-    paramStrings.reserve(params.size()); // prevent reallocation that invalidates c_str()
-    paramValues.reserve(params.size());
-    paramLengths.reserve(params.size());
-    paramFormats.reserve(params.size());
-    for (const auto& param : params) {
-        if (std::holds_alternative<std::string>(param.value.data)) {
-            std::string str = std::get<std::string>(param.value.data);
-            paramStrings.push_back(str);
-            paramValues.push_back(paramStrings.back().c_str());
-            paramLengths.push_back(0); // 0 for text format (null-terminated)
-            paramFormats.push_back(0); // text format
-        } else if (std::holds_alternative<double>(param.value.data)) {
-            double num = std::get<double>(param.value.data);
-            // Check if it's a whole number (integer)
-            if (num == static_cast<long long>(num)) {
-                // Format as integer
-                paramStrings.push_back(std::to_string(static_cast<long long>(num)));
-            } else {
-                // Format as decimal
-                paramStrings.push_back(std::to_string(num));
+    // Prepared before entering pipeline mode, where synchronous calls are not allowed
+    const PreparedStatement* prepared = preparedStatement(sql);
+    std::string name = prepared ? prepared->name : std::string();
+    std::string converted = prepared ? std::string() : convertPlaceholders(sql);
+
+    // Results are only read after a whole chunk has been sent; the depth bounds
+    // what the server has to buffer before the client starts reading.
+    constexpr std::size_t pipelineDepth = 256;
+    std::vector<std::size_t> failed;
+    for (std::size_t start = 0; start < paramSets.size(); start += pipelineDepth) {
+        const std::size_t end = std::min(start + pipelineDepth, paramSets.size());
+        if (deadline_.expired()) {
+            // Out of time: the sets not sent yet fail without reaching the server
+            for (std::size_t i = start; i < paramSets.size(); ++i) {
+                failed.push_back(i);
             }
-            paramValues.push_back(paramStrings.back().c_str());
-            paramLengths.push_back(0); // 0 for text format (null-terminated)
-            paramFormats.push_back(0);
-        } else if (std::holds_alternative<bool>(param.value.data)) {
-            paramStrings.push_back(std::get<bool>(param.value.data) ? "true" : "false");
-            paramValues.push_back(paramStrings.back().c_str());
-            paramLengths.push_back(0); // 0 for text format (null-terminated)
-            paramFormats.push_back(0);
-        } else {
-            paramValues.push_back(nullptr);
-            paramLengths.push_back(0);
-            paramFormats.push_back(0);
+            break;
+        }
+        if (!PQenterPipelineMode(conn_)) {
+            throw std::runtime_error("PostgreSQL executeBatch failed: " + std::string(PQerrorMessage(conn_)));
         }
-    }
 
-    PGresult* res = PQexecParams(conn_, convertedSql.c_str(), params.size(),
-                                 nullptr, paramValues.data(), paramLengths.data(),
-                                 paramFormats.data(), 0);
-    checkPGresult(res, conn_, "executeSql");
-    PQclear(res);
+        // A sync after every set mirrors one executeSql call per set: in autocommit mode
+        // each gets its own implicit transaction, and a failing set does not abort the rest
+        std::size_t sent = start;
+        for (; sent < end; ++sent) {
+            const auto& params = paramSets[sent];
+            auto text = buildTextParams(params);
+            int ok = !name.empty()
+                ? PQsendQueryPrepared(conn_, name.c_str(), params.size(),
+                                      text.values.data(), text.lengths.data(), text.formats.data(), 0)
+                : PQsendQueryParams(conn_, converted.c_str(), params.size(),
+                                    nullptr, text.values.data(), text.lengths.data(), text.formats.data(), 0);
+            if (!ok || !PQpipelineSync(conn_)) {
+                break;
+            }
+        }
+
+        bool planChanged = false;
+        Deadline deadline = statementDeadline();
+        for (std::size_t i = start; i < sent; ++i) {
+            bool ok = true;
+            while (PGresult* res = nextResult(conn_, deadline)) {
+                ExecStatusType status = PQresultStatus(res);
+                if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
+                    ok = false;
+                    const char* sqlState = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+                    planChanged = planChanged || (sqlState && std::strcmp(sqlState, "0A000") == 0);
+                }
+                PQclear(res);
+            }
+            PQclear(nextResult(conn_, deadline)); // PGRES_PIPELINE_SYNC
+            if (!ok) {
+                failed.push_back(i);
+            }
+        }
+        std::string error = sent < end ? PQerrorMessage(conn_) : "";
+        PQexitPipelineMode(conn_);
+        if (!error.empty()) {
+            throw std::runtime_error("PostgreSQL executeBatch failed: " + error);
+        }
+
+        // The table changed under the prepared statement; the rest of the batch runs unprepared
+        if (planChanged && !name.empty()) {
+            statements_.erase(sql);
+            name.clear();
+            converted = convertPlaceholders(sql);
+        }
+    }
+    return failed;
 }
 
-std::vector<std::vector<SqlValue>> PostgreSQLDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
-    // Convert ? placeholders to $1, $2, etc. for PostgreSQL
-    std::string convertedSql = sql;
-    size_t pos = 0;
-    int paramIndex = 1;
-    while ((pos = convertedSql.find('?', pos)) != std::string::npos) {
-        std::string replacement = "$" + std::to_string(paramIndex++);
-        convertedSql.replace(pos, 1, replacement);
-        pos += replacement.length();
+bool PostgreSQLDriver::queueSql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    if (!config_.pipelineWrites || !isQueueable(sql)) {
+        return false;
+    }
+    // Unread results pile up on the server as well; past this many, wait for them first
+    constexpr std::size_t maxQueued = 256;
+    if (queued_ >= maxQueued) {
+        drainQueued();
+    }
+    if (PQpipelineStatus(conn_) == PQ_PIPELINE_OFF && !PQenterPipelineMode(conn_)) {
+        return false;
     }
 
-    std::vector<std::string> paramStrings;
-    std::vector<const char*> paramValues;
-    std::vector<int> paramLengths;
-    std::vector<int> paramFormats;
-    paramStrings.reserve(params.size()); // prevent reallocation that invalidates c_str()
-    paramValues.reserve(params.size());
-    paramLengths.reserve(params.size());
-    paramFormats.reserve(params.size());
-    for (const auto& param : params) {
-        if (std::holds_alternative<std::string>(param.value.data)) {
-            paramStrings.push_back(std::get<std::string>(param.value.data));
-            paramValues.push_back(paramStrings.back().c_str());
-            paramLengths.push_back(0); // 0 for text format (null-terminated)
-            paramFormats.push_back(0); // text
-        } else if (std::holds_alternative<double>(param.value.data)) {
-            double num = std::get<double>(param.value.data);
-            // Check if it's a whole number (integer)
-            if (num == static_cast<long long>(num)) {
-                // Format as integer
-                paramStrings.push_back(std::to_string(static_cast<long long>(num)));
-            } else {
-                // Format as decimal
-                paramStrings.push_back(std::to_string(num));
-            }
-            paramValues.push_back(paramStrings.back().c_str());
-            paramLengths.push_back(0); // 0 for text format (null-terminated)
-            paramFormats.push_back(0);
-        } else if (std::holds_alternative<bool>(param.value.data)) {
-            paramStrings.push_back(std::get<bool>(param.value.data) ? "true" : "false");
-            paramValues.push_back(paramStrings.back().c_str());
-            paramLengths.push_back(0); // 0 for text format (null-terminated)
-            paramFormats.push_back(0);
-        } else {
-            paramValues.push_back(nullptr);
-            paramLengths.push_back(0);
-            paramFormats.push_back(0);
+    // Sent unprepared: a prepared statement whose table changed fails with 0A000, which
+    // executeSql retries but a statement already sent ahead of others cannot. A sync after
+    // each statement gives it the implicit transaction executeSql would, so outside a
+    // transaction a failure does not abort the statements queued after it.
+    auto text = buildTextParams(params);
+    if (!PQsendQueryParams(conn_, convertPlaceholders(sql).c_str(), params.size(),
+                           nullptr, text.values.data(), text.lengths.data(), text.formats.data(), 0) ||
+        !PQpipelineSync(conn_)) {
+        const std::string error = PQerrorMessage(conn_);
+        drainQueued();
+        throw std::runtime_error("PostgreSQL queueSql failed: " + error);
+    }
+    ++queued_;
+    return true;
+}
+
+bool PostgreSQLDriver::syncQueued() {
+    drainQueued();
+    return !lastQueuedFailed_;
+}
+
+void PostgreSQLDriver::drainQueued() {
+    if (PQpipelineStatus(conn_) == PQ_PIPELINE_OFF) {
+        return;
+    }
+    // Each statement's result is followed by a null, then by its PGRES_PIPELINE_SYNC
+    Deadline deadline = statementDeadline();
+    for (; queued_ > 0; --queued_) {
+        bool failed = true; // until a result says otherwise; a broken connection has none
+        while (PGresult* res = nextResult(conn_, deadline)) {
+            const ExecStatusType status = PQresultStatus(res);
+            failed = status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK;
+            PQclear(res);
         }
+        PQclear(nextResult(conn_, deadline));
+        lastQueuedFailed_ = failed;
     }
+    PQexitPipelineMode(conn_);
+}
 
-    PGresult* res = PQexecParams(conn_, convertedSql.c_str(), params.size(),
-                                 nullptr, paramValues.data(), paramLengths.data(),
-                                 paramFormats.data(), 0);
+std::vector<std::vector<SqlValue>> PostgreSQLDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    drainQueued();
+    PGresult* res = execParams(sql, params);
     checkPGresult(res, conn_, "querySql");
 
     std::vector<std::vector<SqlValue>> results;
     int nrows = PQntuples(res);
     int ncols = PQnfields(res);
+    const std::vector<Oid> types = columnTypes(res);
+    results.reserve(nrows);
     for (int i = 0; i < nrows; ++i) {
         std::vector<SqlValue> row;
+        row.reserve(ncols);
         for (int j = 0; j < ncols; ++j) {
-            if (PQgetisnull(res, i, j)) {
-                row.emplace_back(SqlValue(nullptr));
-            } else {
-                std::string val = PQgetvalue(res, i, j);
-                // Try to parse as number or bool
-                if (val == "t" || val == "f") {
-                    row.emplace_back(SqlValue(val == "t"));
-                } else {
+            row.push_back(cellValue(res, i, j, types[j]));
+        }
+        results.push_back(std::move(row));
+    }
+    PQclear(res);
+    return results;
+}
+
+void PostgreSQLDriver::queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) {
+    drainQueued();
+    auto text = buildTextParams(params);
+    for (int attempt = 0;; ++attempt) {
+        PreparedStatement* prepared = preparedStatement(sql);
+        int sent = prepared
+            ? PQsendQueryPrepared(conn_, prepared->name.c_str(), params.size(),
+                                  text.values.data(), text.lengths.data(), text.formats.data(),
+                                  prepared->binaryResults ? 1 : 0)
+            : PQsendQueryParams(conn_, convertPlaceholders(sql).c_str(), params.size(),
+                                nullptr, text.values.data(), text.lengths.data(), text.formats.data(), 0);
+        if (!sent) {
+            throw std::runtime_error("PostgreSQL queryRows failed: " + std::string(PQerrorMessage(conn_)));
+        }
+        // Single-row mode hands over one PGresult per row instead of buffering the whole set
+        PQsetSingleRowMode(conn_);
+        const bool wasPrepared = prepared != nullptr;
+
+        // Every result must be consumed before the connection accepts the next
+        // command, so rows after an early stop are drained and discarded.
+        std::vector<SqlValue> row; // Reused for every row
+        std::vector<Oid> types;
+        bool wanted = true;
+        bool retry = false;
+        std::string error;
+        std::exception_ptr callbackError;
+        Deadline deadline = statementDeadline();
+        while (PGresult* res = nextResult(conn_, deadline)) {
+            ExecStatusType status = PQresultStatus(res);
+            if (status == PGRES_SINGLE_TUPLE) {
+                if (types.empty()) {
+                    types = columnTypes(res);
+                    if (prepared) {
+                        learnColumnTypes(*prepared, res); // before the callback can run SQL that evicts it
+                        prepared = nullptr;
+                    }
+                }
+                if (wanted) {
+                    int ncols = PQnfields(res);
+                    row.resize(ncols);
+                    for (int j = 0; j < ncols; ++j) {
+                        row[j] = cellValue(res, 0, j, types[j]);
+                    }
                     try {
-                        double num = std::stod(val);
-                        row.emplace_back(SqlValue(num));
+                        wanted = onRow(row);
                     } catch (...) {
-                        row.emplace_back(SqlValue(val));
+                        callbackError = std::current_exception();
+                        wanted = false;
                     }
                 }
+            } else if (status == PGRES_TUPLES_OK && prepared) {
+                learnColumnTypes(*prepared, res); // no rows, but the columns are described all the same
+                prepared = nullptr;
+            } else if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK && error.empty() && !retry) {
+                if (wasPrepared && retryPrepared(sql, res, attempt)) {
+                    retry = true;
+                } else {
+                    error = PQresultErrorMessage(res);
+                }
             }
+            PQclear(res);
+        }
+
+        if (callbackError) {
+            std::rethrow_exception(callbackError);
+        }
+        if (!error.empty()) {
+            throw std::runtime_error("PostgreSQL queryRows failed: " + error);
+        }
+        if (!retry) {
+            return;
         }
-        results.push_back(std::move(row));
     }
-    PQclear(res);
-    return results;
 }
 
 void PostgreSQLDriver::openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
+    drainQueued();
     closeCursor(name); // Close if already exists
 
-    // Check if SQL contains placeholders
-    bool hasPlaceholders = (sql.find('?') != std::string::npos);
-    
     // Store the original SQL for potential reopening with different parameters
     cursorSql_[name] = sql;
-    
+    positionedCursors_.erase(name);
+
     // If there are placeholders but no parameters provided, don't execute yet
     // This handles the pattern: DECLARE cursor ... WHERE x = ?; OPEN cursor USING :param;
-    if (hasPlaceholders && params.empty()) {
+    if (sql.find('?') != std::string::npos && params.empty()) {
         return;  // Just store the SQL, don't execute DECLARE yet
     }
-    
-    // If we have parameters, substitute them into the query
-    std::string query = sql;
-    if (!params.empty()) {
-        // Replace ? with actual values for DECLARE
-        size_t paramIdx = 0;
-        size_t pos = 0;
-        while ((pos = query.find('?', pos)) != std::string::npos && paramIdx < params.size()) {
-            const auto& param = params[paramIdx++];
-            std::string value;
-            if (std::holds_alternative<std::string>(param.value.data)) {
-                // Quote string values and escape single quotes
-                std::string str = std::get<std::string>(param.value.data);
-                std::string escaped;
-                for (char c : str) {
-                    if (c == '\'') {
-                        escaped += "''";  // Escape single quotes
-                    } else {
-                        escaped += c;
-                    }
-                }
-                value = "'" + escaped + "'";
-            } else if (std::holds_alternative<double>(param.value.data)) {
-                double num = std::get<double>(param.value.data);
-                if (num == static_cast<long long>(num)) {
-                    value = std::to_string(static_cast<long long>(num));
-                } else {
-                    value = std::to_string(num);
-                }
-            } else if (std::holds_alternative<bool>(param.value.data)) {
-                value = std::get<bool>(param.value.data) ? "TRUE" : "FALSE";
-            } else {
-                value = "NULL";
-            }
-            query.replace(pos, 1, value);
-            pos += value.length();
-        }
-    }
+    declareCursor(name, sql, params, "openCursor");
+}
 
-    std::string declareSql = "DECLARE " + name + " CURSOR FOR " + query;
-    
-    // Execute DECLARE directly without parameter binding
-    PGresult* res = PQexec(conn_, declareSql.c_str());
-    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::string error = PQerrorMessage(conn_);
-        PQclear(res);
-        throw std::runtime_error("PostgreSQL openCursor failed: " + error);
-    }
-    PQclear(res);
-    
-    // In PostgreSQL, DECLARE ... CURSOR FOR ... automatically opens the cursor
-    // No separate OPEN statement needed
-    cursors_[name] = true;
+void PostgreSQLDriver::openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
+    openCursor(name, sql, params);
+    positionedCursors_.insert(name);
 }
 
 void PostgreSQLDriver::openDeclaredCursor(const std::string& name) {
+    drainQueued();
     auto sqlIt = cursorSql_.find(name);
-    if (sqlIt != cursorSql_.end()) {
-        closeCursor(name);
-        // Note: sqlIt->second may contain ? placeholders, but for openDeclaredCursor
-        // without params, we should have already substituted them or it's an error
-        std::string declareSql = "DECLARE " + name + " CURSOR FOR " + sqlIt->second;
-        
-        // Execute DECLARE directly without parameter binding
-        PGresult* res = PQexec(conn_, declareSql.c_str());
-        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-            std::string error = PQerrorMessage(conn_);
-            PQclear(res);
-            throw std::runtime_error("PostgreSQL openDeclaredCursor failed: " + error);
-        }
-        PQclear(res);
-        
-        // In PostgreSQL, DECLARE automatically opens the cursor
-        cursors_[name] = true;
-    } else {
+    if (sqlIt == cursorSql_.end()) {
         throw std::runtime_error("Cursor not declared: " + name);
     }
+    closeCursor(name);
+    declareCursor(name, sqlIt->second, {}, "openDeclaredCursor");
 }
 
 void PostgreSQLDriver::openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params) {
+    drainQueued();
     auto sqlIt = cursorSql_.find(name);
     if (sqlIt == cursorSql_.end()) {
         throw std::runtime_error("Cursor not declared with USING support: " + name);
     }
-    
-    // Close existing cursor if open
     closeCursor(name);
-    
-    std::string query = sqlIt->second;
-    // Replace ? with actual values
-    size_t paramIdx = 0;
-    size_t pos = 0;
-    while ((pos = query.find('?', pos)) != std::string::npos && paramIdx < params.size()) {
-        const auto& param = params[paramIdx++];
-        std::string value;
-        if (std::holds_alternative<std::string>(param.value.data)) {
-            // Quote string values and escape single quotes
-            std::string str = std::get<std::string>(param.value.data);
-            std::string escaped;
-            for (char c : str) {
-                if (c == '\'') {
-                    escaped += "''";  // Escape single quotes
-                } else {
-                    escaped += c;
-                }
-            }
-            value = "'" + escaped + "'";
-        } else if (std::holds_alternative<double>(param.value.data)) {
-            double num = std::get<double>(param.value.data);
-            if (num == static_cast<long long>(num)) {
-                value = std::to_string(static_cast<long long>(num));
-            } else {
-                value = std::to_string(num);
-            }
-        } else if (std::holds_alternative<bool>(param.value.data)) {
-            value = std::get<bool>(param.value.data) ? "TRUE" : "FALSE";
-        } else {
-            value = "NULL";
-        }
-        query.replace(pos, 1, value);
-        pos += value.length();
-    }
-    
-    // Re-declare the cursor with new parameters
-    std::string declareSql = "DECLARE " + name + " CURSOR FOR " + query;
-    
-    // Execute DECLARE directly without parameter binding
-    PGresult* res = PQexec(conn_, declareSql.c_str());
+    declareCursor(name, sqlIt->second, params, "openDeclaredCursorWithParams");
+}
+
+void PostgreSQLDriver::declareCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params,
+                                     const char* operation) {
+    // The values are bound rather than written into the text, so every OPEN of the cursor
+    // sends the same DECLARE, prepared once per connection like any other statement
+    PGresult* res = execParams("DECLARE " + name + " CURSOR FOR " + sql, params);
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         std::string error = PQerrorMessage(conn_);
         PQclear(res);
-        throw std::runtime_error("PostgreSQL openDeclaredCursorWithParams failed: " + error);
+        throw std::runtime_error(std::string("PostgreSQL ") + operation + " failed: " + error);
     }
     PQclear(res);
-    
-    // In PostgreSQL, DECLARE automatically opens the cursor
-    
+
+    // In PostgreSQL, DECLARE ... CURSOR FOR ... automatically opens the cursor
+    // No separate OPEN statement needed
     cursors_[name] = true;
 }
 
 bool PostgreSQLDriver::cursorNext(const std::string& name) {
+    drainQueued();
     auto it = cursors_.find(name);
     if (it == cursors_.end() || !it->second) {
         throw std::runtime_error("Cursor not found: " + name);
     }
 
-    std::string fetchSql = "FETCH NEXT FROM " + name;
-    PGresult* res = PQexec(conn_, fetchSql.c_str());
-    checkPGresult(res, conn_, "cursorNext");
+    auto batchIt = batches_.find(name);
+    if (batchIt == batches_.end()) {
+        CursorBatch batch;
+        // Positioned updates need the server cursor on the current row, so FOR UPDATE
+        // cursors and those a WHERE CURRENT OF names keep fetching one row at a time
+        auto sqlIt = cursorSql_.find(name);
+        bool forUpdate = sqlIt != cursorSql_.end() && toUpperCopy(sqlIt->second).find("FOR UPDATE") != std::string::npos;
+        bool positioned = forUpdate || positionedCursors_.contains(name);
+        batch.fetchSize = positioned ? 1 : static_cast<int>(std::max<std::size_t>(config_.cursorFetchSize, 1));
+        batchIt = batches_.emplace(name, batch).first;
+    }
+    CursorBatch& batch = batchIt->second;
 
-    int nrows = PQntuples(res);
-    if (nrows > 0) {
-        // Extract the row
-        int ncols = PQnfields(res);
-        std::vector<SqlValue> row;
-        for (int j = 0; j < ncols; ++j) {
-            if (PQgetisnull(res, 0, j)) {
-                row.emplace_back(SqlValue(nullptr));
-            } else {
-                std::string val = PQgetvalue(res, 0, j);
-                // Parse value
-                if (val == "t" || val == "f") {
-                    row.emplace_back(SqlValue(val == "t"));
-                } else {
-                    try {
-                        double num = std::stod(val);
-                        row.emplace_back(SqlValue(num));
-                    } catch (...) {
-                        row.emplace_back(SqlValue(val));
-                    }
-                }
-            }
+    if (!batch.rows || batch.nextRow >= PQntuples(batch.rows)) {
+        if (batch.exhausted) {
+            return false;
+        }
+        PQclear(batch.rows);
+        batch.rows = nullptr;
+        batch.nextRow = 0;
+
+        std::string fetchSql = batch.fetchSize == 1 ? "FETCH NEXT FROM " + name
+                                                    : "FETCH " + std::to_string(batch.fetchSize) + " FROM " + name;
+        // Binary results need the extended protocol, which the first FETCH can skip
+        PGresult* res = !batch.binaryResults ? execQuery(conn_, fetchSql.c_str(), statementDeadline())
+            : PQsendQueryParams(conn_, fetchSql.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1) ? awaitResult(conn_, statementDeadline())
+            : nullptr;
+        checkPGresult(res, conn_, "cursorNext");
+        batch.rows = res;
+        if (batch.columnTypes.empty()) {
+            batch.columnTypes = columnTypes(res);
+            batch.binaryResults = std::all_of(batch.columnTypes.begin(), batch.columnTypes.end(), hasBinaryDecoder);
+        }
+        if (PQntuples(res) < batch.fetchSize) {
+            batch.exhausted = true;
+        }
+        if (PQntuples(res) == 0) {
+            return false;
         }
-        currentRows_[name] = std::move(row);
-        PQclear(res);
-        return true;
-    } else {
-        PQclear(res);
-        return false;
     }
+
+    // Extract the row
+    int ncols = PQnfields(batch.rows);
+    std::vector<SqlValue> row;
+    row.reserve(ncols);
+    for (int j = 0; j < ncols; ++j) {
+        row.push_back(cellValue(batch.rows, batch.nextRow, j, batch.columnTypes[j]));
+    }
+    ++batch.nextRow;
+    currentRows_[name] = std::move(row);
+    return true;
 }
 
 std::vector<SqlValue> PostgreSQLDriver::cursorGetRow(const std::string& name) {
@@ -446,6 +789,7 @@ std::vector<SqlValue> PostgreSQLDriver::cursorGetRow(const std::string& name) {
 }
 
 void PostgreSQLDriver::closeCursor(const std::string& name) {
+    drainQueued();
     auto it = cursors_.find(name);
     if (it != cursors_.end()) {
         std::string closeSql = "CLOSE " + name;
@@ -456,6 +800,7 @@ void PostgreSQLDriver::closeCursor(const std::string& name) {
         }
         cursors_.erase(it);
         currentRows_.erase(name);
+        clearBatch(name);
         // Keep cursorSql_ for potential reopening
     }
 }
@@ -498,10 +843,30 @@ void PostgreSQLDriver::createOrMigrateTable(const std::string& tableName, const
 }
 
 void PostgreSQLDriver::beginTransaction() {
-    executeSql("BEGIN", {});
+    begin("BEGIN");
+}
+
+void PostgreSQLDriver::beginReadOnlyTransaction() {
+    begin("BEGIN READ ONLY");
+}
+
+void PostgreSQLDriver::begin(const char* command) {
+    const Deadline deadline = statementDeadline();
+    if (!deadline.isSet()) {
+        executeSql(command, {});
+        return;
+    }
+    // The server stops the transaction's statements by itself as well, should a cancel
+    // request not get through; sent with BEGIN, it costs no round trip of its own
+    drainQueued();
+    const std::string sql = std::string(command) + "; SET LOCAL statement_timeout = " + std::to_string(deadline.remaining().count());
+    PGresult* res = execQuery(conn_, sql.c_str(), deadline);
+    checkPGresult(res, conn_, "beginTransaction");
+    PQclear(res);
 }
 
 bool PostgreSQLDriver::isInTransaction() {
+    drainQueued(); // the server reports the transaction state with each result
     return PQtransactionStatus(conn_) == PQTRANS_INTRANS || PQtransactionStatus(conn_) == PQTRANS_INERROR;
 }
 
@@ -513,6 +878,114 @@ void PostgreSQLDriver::rollbackTransaction() {
     executeSql("ROLLBACK", {});
 }
 
+void PostgreSQLDriver::clearBatch(const std::string& name) {
+    auto it = batches_.find(name);
+    if (it != batches_.end()) {
+        PQclear(it->second.rows);
+        batches_.erase(it);
+    }
+}
+
+void PostgreSQLDriver::setDeadline(const Deadline& deadline) {
+    deadline_ = deadline;
+}
+
+Deadline PostgreSQLDriver::statementDeadline() const {
+    return deadline_.expired() ? Deadline{} : deadline_;
+}
+
+StatementCacheStats PostgreSQLDriver::statementCacheStats() const {
+    return statements_.stats();
+}
+
+PostgreSQLDriver::PreparedStatement* PostgreSQLDriver::preparedStatement(const std::string& sql) {
+    if (!statements_.enabled() || !isPreparable(sql)) {
+        return nullptr;
+    }
+    flushPendingDeallocations();
+    if (PreparedStatement* statement = statements_.find(sql)) {
+        return statement;
+    }
+    std::string newName = "trx_ps_" + std::to_string(nextStatementId_++);
+    PGresult* prepared = PQsendPrepare(conn_, newName.c_str(), convertPlaceholders(sql).c_str(), 0, nullptr)
+        ? awaitResult(conn_, statementDeadline()) : nullptr;
+    checkPGresult(prepared, conn_, "prepare");
+    PQclear(prepared);
+    PreparedStatement statement;
+    statement.name = newName;
+    return &statements_.insert(sql, std::move(statement));
+}
+
+void PostgreSQLDriver::learnColumnTypes(PreparedStatement& statement, PGresult* res) {
+    if (statement.described) {
+        return;
+    }
+    // The first execution still comes back as text; it tells which columns the rest can get in binary
+    statement.columnTypes = columnTypes(res);
+    statement.binaryResults = std::all_of(statement.columnTypes.begin(), statement.columnTypes.end(), hasBinaryDecoder);
+    statement.described = true;
+}
+
+bool PostgreSQLDriver::retryPrepared(const std::string& sql, PGresult* res, int attempt) {
+    const char* sqlState = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : nullptr;
+    if (!sqlState || std::strcmp(sqlState, "0A000") != 0) {
+        return false;
+    }
+    // "cached plan must not change result type": the table changed under the
+    // prepared statement. Drop it; outside a transaction it is safe to re-prepare once.
+    statements_.erase(sql);
+    return attempt == 0 && PQtransactionStatus(conn_) == PQTRANS_IDLE;
+}
+
+PGresult* PostgreSQLDriver::execParams(const std::string& sql, const std::vector<SqlParameter>& params) {
+    auto text = buildTextParams(params);
+    for (int attempt = 0;; ++attempt) {
+        PreparedStatement* prepared = preparedStatement(sql);
+        if (!prepared) {
+            return PQsendQueryParams(conn_, convertPlaceholders(sql).c_str(), params.size(),
+                                     nullptr, text.values.data(), text.lengths.data(),
+                                     text.formats.data(), 0)
+                ? awaitResult(conn_, statementDeadline()) : nullptr;
+        }
+
+        PGresult* res = PQsendQueryPrepared(conn_, prepared->name.c_str(), params.size(),
+                                            text.values.data(), text.lengths.data(),
+                                            text.formats.data(), prepared->binaryResults ? 1 : 0)
+            ? awaitResult(conn_, statementDeadline()) : nullptr;
+        if (res && PQresultStatus(res) == PGRES_TUPLES_OK) {
+            learnColumnTypes(*prepared, res);
+        }
+        if (!retryPrepared(sql, res, attempt)) {
+            return res;
+        }
+        PQclear(res);
+    }
+}
+
+void PostgreSQLDriver::deallocateStatement(const std::string& name) {
+    if (!conn_) {
+        return;
+    }
+    // Nothing but ROLLBACK runs in an aborted transaction; retry once it has ended
+    if (PQtransactionStatus(conn_) == PQTRANS_INERROR) {
+        pendingDeallocations_.push_back(name);
+        return;
+    }
+    std::string deallocateSql = "DEALLOCATE " + name;
+    PQclear(execQuery(conn_, deallocateSql.c_str(), statementDeadline()));
+}
+
+void PostgreSQLDriver::flushPendingDeallocations() {
+    if (pendingDeallocations_.empty() || PQtransactionStatus(conn_) == PQTRANS_INERROR) {
+        return;
+    }
+    auto names = std::move(pendingDeallocations_);
+    pendingDeallocations_.clear();
+    for (const auto& name : names) {
+        deallocateStatement(name);
+    }
+}
+
 std::vector<TableColumn> PostgreSQLDriver::getTableSchema(const std::string& tableName) {
     // Query information_schema for column details
     std::string sql = R"(
@@ -564,4 +1037,20 @@ std::vector<TableColumn> PostgreSQLDriver::getTableSchema(const std::string& tab
     return columns;
 }
 
+std::optional<std::string> PostgreSQLDriver::schemaVersion() {
+    // Covers every column getTableSchema reads, so any ALTER TABLE changes it
+    auto results = querySql(R"(
+        SELECT md5(coalesce(string_agg(concat_ws(':', table_schema, table_name, column_name, data_type,
+                                                 character_maximum_length, numeric_precision, numeric_scale,
+                                                 is_nullable, column_default),
+                                       ';' ORDER BY table_schema, table_name, ordinal_position), ''))
+        FROM information_schema.columns
+        WHERE table_schema NOT IN ('pg_catalog', 'information_schema')
+    )");
+    if (results.empty() || results.front().empty() || results.front().front().isNull()) {
+        return std::nullopt;
+    }
+    return "postgresql:" + results.front().front().asString();
+}
+
 } // namespace trx::runtime
\ No newline at end of file
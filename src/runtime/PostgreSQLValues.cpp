@@ -0,0 +1,143 @@
+#include "trx/runtime/PostgreSQLValues.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+namespace trx::runtime::postgres {
+
+namespace {
+
+// Days since 1970-01-01 to a proleptic Gregorian date
+void civilFromDays(std::int64_t days, std::int64_t& year, int& month, int& day) {
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned shiftedMonth = (5 * dayOfYear + 2) / 153;
+    day = static_cast<int>(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+    month = static_cast<int>(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    year = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+// Binary dates and timestamps count from 2000-01-01; the text they become is what the
+// server prints with DateStyle ISO, e.g. 2024-01-15 or 2024-01-15 09:30:00.25
+constexpr std::int64_t postgresEpochDays = 10957; // 2000-01-01 - 1970-01-01
+
+std::string formatDate(std::int64_t days, const char* time = nullptr) {
+    std::int64_t year;
+    int month, day;
+    civilFromDays(days + postgresEpochDays, year, month, day);
+    const bool bc = year <= 0; // there is no year 0: 1 BC comes before 1 AD
+    char text[64];
+    std::snprintf(text, sizeof(text), "%04lld-%02d-%02d%s%s%s", static_cast<long long>(bc ? 1 - year : year), month, day,
+                  time ? " " : "", time ? time : "", bc ? " BC" : "");
+    return text;
+}
+
+} // namespace
+
+std::uint64_t readBigEndian(const char* data, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+}
+
+// numeric: digit count, weight of the first base-10000 digit, sign, display scale, digits
+SqlValue numericValue(const char* data, int length) {
+    if (length < 8) {
+        return SqlValue(nullptr);
+    }
+    const int ndigits = readInt16(data);
+    const int weight = readInt16(data + 2);
+    const auto sign = static_cast<std::uint16_t>(readInt16(data + 4));
+    if (sign == 0xC000) {
+        return SqlValue(std::numeric_limits<double>::quiet_NaN());
+    }
+    if (sign == 0xD000 || sign == 0xF000) {
+        return SqlValue(sign == 0xD000 ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity());
+    }
+    if (length < 8 + 2 * ndigits) {
+        return SqlValue(nullptr);
+    }
+
+    // Exact digits and a power of ten that a double holds exactly need one rounding,
+    // the same one strtod would make; anything else goes through strtod itself
+    static constexpr double powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                             1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    constexpr std::uint64_t exactLimit = std::uint64_t{1} << 53;
+    const int exponent = 4 * (weight - ndigits + 1);
+    std::uint64_t mantissa = 0;
+    bool exact = exponent >= -22 && exponent <= 22;
+    for (int i = 0; i < ndigits && exact; ++i) {
+        const auto digit = static_cast<std::uint64_t>(readInt16(data + 8 + 2 * i));
+        exact = mantissa < (exactLimit - digit) / 10000;
+        mantissa = mantissa * 10000 + digit;
+    }
+    double value;
+    if (exact) {
+        value = exponent >= 0 ? static_cast<double>(mantissa) * powersOfTen[exponent]
+                              : static_cast<double>(mantissa) / powersOfTen[-exponent];
+    } else {
+        std::string digits;
+        digits.reserve(4 * ndigits + 8);
+        char group[8];
+        for (int i = 0; i < ndigits; ++i) {
+            std::snprintf(group, sizeof(group), "%04d", readInt16(data + 8 + 2 * i));
+            digits += group;
+        }
+        digits += "e" + std::to_string(exponent);
+        value = std::strtod(digits.c_str(), nullptr);
+    }
+    return SqlValue(sign == 0x4000 && value != 0 ? -value : value);
+}
+
+SqlValue dateValue(const char* data, int length) {
+    if (length != 4) {
+        return SqlValue(nullptr);
+    }
+    const std::int32_t days = readInt32(data);
+    if (days == std::numeric_limits<std::int32_t>::max() || days == std::numeric_limits<std::int32_t>::min()) {
+        return SqlValue(std::string(days > 0 ? "infinity" : "-infinity"));
+    }
+    return SqlValue(formatDate(days));
+}
+
+// timestamptz is sent in UTC, and written with a +00 offset
+SqlValue timestampValue(const char* data, int length, bool withZone) {
+    if (length != 8) {
+        return SqlValue(nullptr);
+    }
+    const std::int64_t micros = readInt64(data);
+    if (micros == std::numeric_limits<std::int64_t>::max() || micros == std::numeric_limits<std::int64_t>::min()) {
+        return SqlValue(std::string(micros > 0 ? "infinity" : "-infinity"));
+    }
+    constexpr std::int64_t microsPerDay = 86400000000LL;
+    std::int64_t days = micros / microsPerDay;
+    std::int64_t ofDay = micros % microsPerDay;
+    if (ofDay < 0) {
+        ofDay += microsPerDay;
+        --days;
+    }
+    const std::int64_t seconds = ofDay / 1000000;
+    const auto fraction = static_cast<int>(ofDay % 1000000);
+    char time[32];
+    int written = std::snprintf(time, sizeof(time), "%02d:%02d:%02d", static_cast<int>(seconds / 3600),
+                                static_cast<int>(seconds / 60 % 60), static_cast<int>(seconds % 60));
+    if (fraction != 0) {
+        written += std::snprintf(time + written, sizeof(time) - written, ".%06d", fraction);
+        while (time[written - 1] == '0') {
+            time[--written] = '\0';
+        }
+    }
+    if (withZone) {
+        std::snprintf(time + written, sizeof(time) - written, "+00");
+    }
+    return SqlValue(formatDate(days, time));
+}
+
+} // namespace trx::runtime::postgres
@@ -0,0 +1,101 @@
+#include "trx/runtime/Profiler.h"
+
+#include "trx/ast/Statements.h"
+
+#include <chrono>
+#include <ctime>
+#include <iterator>
+#include <sstream>
+
+namespace trx::runtime {
+
+namespace {
+
+std::uint64_t wallNow() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::uint64_t cpuNow() {
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1'000'000'000ull + static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+const char *statementKind(const ast::Statement::Node &node) {
+    static constexpr const char *kinds[] = {
+        "TRACE", "expression", "VALIDATE", "RETURN", "SYSTEM", "assignment", "var", "BATCH", "THROW",
+        "EMIT", "TRY", "EXEC SQL", "IF", "WHILE", "SWITCH", "SORT", "block", "FOR"};
+    static_assert(std::size(kinds) == std::variant_size_v<ast::Statement::Node>, "one kind per statement type");
+    return kinds[node.index()];
+}
+
+} // namespace
+
+void Profiler::enter(std::string_view name) {
+    frames_.push_back({path_.size(), wallNow(), cpuNow()});
+    if (!path_.empty()) {
+        path_ += ';';
+    }
+    // ';' separates frames in folded output
+    for (const char c : name) {
+        path_ += c == ';' ? ',' : c;
+    }
+}
+
+void Profiler::leave() {
+    if (frames_.empty()) {
+        return;
+    }
+    const Frame frame = frames_.back();
+    frames_.pop_back();
+    const std::uint64_t wall = wallNow() - frame.wallStart;
+    const std::uint64_t cpu = cpuNow() - frame.cpuStart;
+
+    auto &totals = stacks_[path_];
+    totals.wallNanos += wall > frame.childWall ? wall - frame.childWall : 0;
+    totals.cpuNanos += cpu > frame.childCpu ? cpu - frame.childCpu : 0;
+    path_.resize(frame.pathLength);
+
+    if (frames_.empty()) {
+        totalWallNanos_ += wall;
+    } else {
+        frames_.back().childWall += wall;
+        frames_.back().childCpu += cpu;
+    }
+}
+
+std::string Profiler::folded(Metric metric) const {
+    std::ostringstream out;
+    for (const auto &[stack, totals] : stacks_) {
+        const std::uint64_t micros = (metric == Metric::Wall ? totals.wallNanos : totals.cpuNanos) / 1000;
+        if (micros > 0) {
+            out << stack << ' ' << micros << '\n';
+        }
+    }
+    return out.str();
+}
+
+std::uint64_t Profiler::totalMicros() const {
+    return totalWallNanos_ / 1000;
+}
+
+const std::string &Profiler::frameName(const ast::Statement &statement) {
+    auto it = names_.find(&statement);
+    if (it != names_.end()) {
+        return it->second;
+    }
+    std::string name;
+    if (statement.location.line > 0) {
+        const std::string_view file = statement.location.file;
+        const auto slash = file.find_last_of('/');
+        name.append(slash == std::string_view::npos ? file : file.substr(slash + 1));
+        name += ':';
+        name += std::to_string(statement.location.line);
+        name += ' ';
+    }
+    name += statementKind(statement.node);
+    return names_.emplace(&statement, std::move(name)).first->second;
+}
+
+} // namespace trx::runtime
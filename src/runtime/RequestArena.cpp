@@ -0,0 +1,85 @@
+#include "trx/runtime/RequestArena.h"
+
+#include <atomic>
+#include <utility>
+
+namespace trx::runtime {
+
+namespace {
+
+std::atomic<std::uint64_t> totalRequests{0};
+std::atomic<std::uint64_t> totalBytes{0};
+std::atomic<std::uint64_t> totalHeapBytes{0};
+std::atomic<std::uint64_t> peakRequestBytes{0};
+
+thread_local RequestArena *currentArena = nullptr;
+
+} // namespace
+
+void *RequestArena::HeapResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void *p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    bytes_ += bytes;
+    return p;
+}
+
+void RequestArena::HeapResource::do_deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+void *RequestArena::CountingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void *p = arena_.allocate(bytes, alignment);
+    bytes_ += bytes;
+    return p;
+}
+
+RequestArena::RequestArena(std::size_t initialBytes)
+    : block_(std::make_unique<std::byte[]>(initialBytes)), heap_(requestHeapBytes_),
+      monotonic_(block_.get(), initialBytes, &heap_), counting_(monotonic_, requestBytes_) {}
+
+RequestArena::~RequestArena() {
+    if (currentArena == this) {
+        currentArena = nullptr;
+    }
+}
+
+void RequestArena::release() {
+    monotonic_.release();
+
+    totalRequests.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(requestBytes_, std::memory_order_relaxed);
+    totalHeapBytes.fetch_add(requestHeapBytes_, std::memory_order_relaxed);
+    std::uint64_t peak = peakRequestBytes.load(std::memory_order_relaxed);
+    while (requestBytes_ > peak && !peakRequestBytes.compare_exchange_weak(peak, requestBytes_, std::memory_order_relaxed)) {
+    }
+
+    requestBytes_ = 0;
+    requestHeapBytes_ = 0;
+}
+
+RequestArena *RequestArena::current() {
+    return currentArena;
+}
+
+RequestArena *RequestArena::exchangeCurrent(RequestArena *arena) {
+    return std::exchange(currentArena, arena);
+}
+
+RequestArena::Stats RequestArena::stats() {
+    return Stats{
+        .requests = totalRequests.load(std::memory_order_relaxed),
+        .bytes = totalBytes.load(std::memory_order_relaxed),
+        .heapBytes = totalHeapBytes.load(std::memory_order_relaxed),
+        .peakBytes = peakRequestBytes.load(std::memory_order_relaxed),
+    };
+}
+
+RequestArena::Scope::Scope(RequestArena &arena) : arena_{arena}, previous_{currentArena} {
+    currentArena = &arena_;
+}
+
+RequestArena::Scope::~Scope() {
+    currentArena = previous_;
+    arena_.release();
+}
+
+} // namespace trx::runtime
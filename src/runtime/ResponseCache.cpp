@@ -0,0 +1,102 @@
+#include "trx/runtime/ResponseCache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace trx::runtime {
+
+ResponseCache::ResponseCache(std::size_t maxEntries, std::size_t shardCount) {
+    shardCount = std::max<std::size_t>(1, shardCount);
+    maxEntriesPerShard_ = std::max<std::size_t>(1, (maxEntries + shardCount - 1) / shardCount);
+    shards_.reserve(shardCount);
+    for (std::size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+ResponseCache::Tables ResponseCache::tables(const std::vector<std::string> &names) {
+    Tables tables;
+    std::lock_guard<std::mutex> lock(tablesMutex_);
+    for (const auto &name : names) {
+        auto &counter = generations_[name];
+        if (!counter) {
+            counter = std::make_unique<std::atomic<std::uint64_t>>(0);
+        }
+        tables.generations.push_back(counter.get());
+    }
+    return tables;
+}
+
+std::vector<std::uint64_t> ResponseCache::snapshot(const Tables &tables) const {
+    std::vector<std::uint64_t> generations;
+    generations.reserve(tables.generations.size());
+    for (const auto *generation : tables.generations) {
+        generations.push_back(generation->load(std::memory_order_acquire));
+    }
+    return generations;
+}
+
+std::optional<ResponseCache::Value> ResponseCache::find(const std::string &key, const Tables &tables) {
+    auto &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    const auto entry = it->second;
+    const bool stale = entry->generations != snapshot(tables);
+    if (stale || Clock::now() >= entry->expires) {
+        if (stale) {
+            invalidations_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.entries.erase(entry);
+        shard.index.erase(it);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return entry->value;
+}
+
+void ResponseCache::store(std::string key, Value value, Clock::duration ttl, std::vector<std::uint64_t> snapshot) {
+    auto &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (const auto it = shard.index.find(key); it != shard.index.end()) {
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+    }
+    shard.entries.push_front(Entry{key, std::move(value), Clock::now() + ttl, std::move(snapshot)});
+    shard.index.emplace(std::move(key), shard.entries.begin());
+    while (shard.entries.size() > maxEntriesPerShard_) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ResponseCache::invalidate(const Tables &tables) {
+    for (auto *generation : tables.generations) {
+        generation->fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+ResponseCache::Stats ResponseCache::stats() const {
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    for (const auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->entries.size();
+    }
+    return stats;
+}
+
+ResponseCache::Shard &ResponseCache::shardFor(const std::string &key) {
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+} // namespace trx::runtime
@@ -3,12 +3,39 @@
 #include <sqlite3.h>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 
 namespace trx::runtime {
 
+namespace {
+
+SqlValue columnValue(sqlite3_stmt* stmt, int column) {
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER:
+            return SqlValue(static_cast<double>(sqlite3_column_int64(stmt, column)));
+        case SQLITE_FLOAT:
+            return SqlValue(sqlite3_column_double(stmt, column));
+        case SQLITE_NULL:
+            return SqlValue(nullptr);
+        default: {
+            int bytes = sqlite3_column_bytes(stmt, column);
+            const unsigned char* utf8 = sqlite3_column_text(stmt, column);
+            if (utf8 && bytes > 0) {
+                return SqlValue(std::string(reinterpret_cast<const char*>(utf8), bytes));
+            }
+            return SqlValue(std::string(""));
+        }
+    }
+}
+
+} // namespace
+
 SQLiteDriver::SQLiteDriver(const DatabaseConfig& config)
-    : config_(config), db_(nullptr) {}
+    : config_(config), db_(nullptr),
+      statements_(config.statementCacheSize, [this](sqlite3_stmt*& stmt) { finalizeCachedStatement(stmt); }) {}
 
 SQLiteDriver::~SQLiteDriver() {
     // Clean up cursors
@@ -19,6 +46,11 @@ SQLiteDriver::~SQLiteDriver() {
     }
     cursors_.clear();
     cursorSql_.clear();
+    statements_.clear();
+    for (auto* stmt : evictedBusy_) {
+        sqlite3_finalize(stmt);
+    }
+    evictedBusy_.clear();
 
     if (db_) {
         sqlite3_close(db_);
@@ -29,8 +61,38 @@ SQLiteDriver::~SQLiteDriver() {
 void SQLiteDriver::initialize() {
         // Open database
         std::string dbPath = config_.databasePath.empty() ? ":memory:" : config_.databasePath;
-        if (sqlite3_open(dbPath.c_str(), &db_) != SQLITE_OK) {
-            throw std::runtime_error("Failed to open SQLite database: " + std::string(sqlite3_errmsg(db_)));
+        const int flags = config_.readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+        if (sqlite3_open_v2(dbPath.c_str(), &db_, flags, nullptr) != SQLITE_OK) {
+            std::string error = db_ ? sqlite3_errmsg(db_) : "out of memory";
+            sqlite3_close(db_);
+            db_ = nullptr;
+            throw std::runtime_error("Failed to open SQLite database: " + error);
+        }
+
+        // Several connections may share a database file (one per server worker);
+        // wait for a competing writer instead of failing with SQLITE_BUSY.
+        sqlite3_busy_timeout(db_, config_.sqliteBusyTimeoutMs);
+
+        // The journal mode is stored in the file, so the writer switches it and read-only
+        // connections find it set. With WAL a commit only syncs at checkpoints; a power
+        // loss may lose the last transactions but never corrupts the database.
+        std::string pragmas;
+        if (config_.sqliteWal && !config_.readOnly) {
+            pragmas += "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;";
+        }
+        if (config_.sqliteMmapSize > 0) {
+            pragmas += "PRAGMA mmap_size=" + std::to_string(config_.sqliteMmapSize) + ";";
+        }
+        if (config_.sqliteCacheSize > 0) {
+            pragmas += "PRAGMA cache_size=-" + std::to_string(config_.sqliteCacheSize) + ";"; // negative: KiB, not pages
+        }
+        char* error = nullptr;
+        if (!pragmas.empty() && sqlite3_exec(db_, pragmas.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+            std::string message = error ? error : sqlite3_errmsg(db_);
+            sqlite3_free(error);
+            sqlite3_close(db_);
+            db_ = nullptr;
+            throw std::runtime_error("Failed to configure SQLite database: " + message);
         }
 
         // Note: Table creation is now handled by the Interpreter when processing TableDecl declarations
@@ -38,70 +100,88 @@ void SQLiteDriver::initialize() {
     }
 
 void SQLiteDriver::executeSql(const std::string& sql, const std::vector<SqlParameter>& params) {
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare SQL: " + std::string(sqlite3_errmsg(db_)));
-        }
+        bool cached = false;
+        sqlite3_stmt* stmt = acquireStatement(sql, cached);
 
         bindParameters(stmt, params);
 
         int rc = sqlite3_step(stmt);
         if (rc != SQLITE_DONE) {
             std::string error = sqlite3_errmsg(db_);
-            sqlite3_finalize(stmt);
+            releaseStatement(stmt, cached);
             throw std::runtime_error("Failed to execute SQL: " + error);
         }
 
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt, cached);
     }
 
-std::vector<std::vector<SqlValue>> SQLiteDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare SQL: " + std::string(sqlite3_errmsg(db_)));
+std::vector<std::size_t> SQLiteDriver::executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) {
+        std::vector<std::size_t> failed;
+        if (paramSets.empty()) {
+            return failed;
+        }
+        bool cached = false;
+        sqlite3_stmt* stmt = acquireStatement(sql, cached);
+        if (!stmt) {
+            releaseStatement(stmt, cached);
+            return failed;
         }
 
-        bindParameters(stmt, params);
+        // One prepared statement serves every set; only the bindings change
+        for (std::size_t i = 0; i < paramSets.size(); ++i) {
+            bindParameters(stmt, paramSets[i]);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                failed.push_back(i);
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        releaseStatement(stmt, cached);
+        return failed;
+    }
 
+std::vector<std::vector<SqlValue>> SQLiteDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
         std::vector<std::vector<SqlValue>> results;
+        queryRows(sql, params, [&](const std::vector<SqlValue>& row) {
+            results.push_back(row);
+            return true;
+        });
+        return results;
+    }
+
+void SQLiteDriver::queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) {
+        bool cached = false;
+        sqlite3_stmt* stmt = acquireStatement(sql, cached);
+
+        bindParameters(stmt, params);
+
+        std::vector<SqlValue> row; // Reused for every row
         int rc;
-        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-            std::vector<SqlValue> row;
-            int columnCount = sqlite3_column_count(stmt);
-            for (int i = 0; i < columnCount; ++i) {
-                SqlValue value;
-
-                switch (sqlite3_column_type(stmt, i)) {
-                    case SQLITE_INTEGER:
-                        value = SqlValue(static_cast<double>(sqlite3_column_int64(stmt, i)));
-                        break;
-                    case SQLITE_FLOAT:
-                        value = SqlValue(sqlite3_column_double(stmt, i));
-                        break;
-                    case SQLITE_TEXT:
-                        value = SqlValue(std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, i))));
-                        break;
-                    case SQLITE_NULL:
-                        value = SqlValue(nullptr);
-                        break;
-                    default:
-                        value = SqlValue(std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, i))));
-                        break;
+        try {
+            while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                int columnCount = sqlite3_column_count(stmt);
+                row.resize(columnCount);
+                for (int i = 0; i < columnCount; ++i) {
+                    row[i] = columnValue(stmt, i);
+                }
+                if (!onRow(row)) {
+                    rc = SQLITE_DONE;
+                    break;
                 }
-
-                row.push_back(value);
             }
-            results.push_back(row);
+        } catch (...) {
+            releaseStatement(stmt, cached);
+            throw;
         }
 
         if (rc != SQLITE_DONE) {
             std::string error = sqlite3_errmsg(db_);
-            sqlite3_finalize(stmt);
+            releaseStatement(stmt, cached);
             throw std::runtime_error("Failed to execute query: " + error);
         }
 
-        sqlite3_finalize(stmt);
-        return results;
+        releaseStatement(stmt, cached);
     }
 
 void SQLiteDriver::openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
@@ -144,10 +224,16 @@ bool SQLiteDriver::cursorNext(const std::string& name) {
             throw std::runtime_error("Cursor not found: " + name);
         }
 
+        if (!it->second) {
+            return false; // already past its last row
+        }
         int rc = sqlite3_step(it->second);
         if (rc == SQLITE_ROW) {
             return true;
         } else if (rc == SQLITE_DONE) {
+            // Stepping a finished statement again would run the query over from its first row
+            sqlite3_finalize(it->second);
+            it->second = nullptr;
             return false;
         } else {
             throw std::runtime_error("Failed to step cursor: " + std::string(sqlite3_errmsg(db_)));
@@ -161,47 +247,15 @@ std::vector<SqlValue> SQLiteDriver::cursorGetRow(const std::string& name) {
         }
 
         sqlite3_stmt* stmt = it->second;
+        if (!stmt) {
+            throw std::runtime_error("Cursor has no current row: " + name);
+        }
         int columnCount = sqlite3_column_count(stmt);
         std::vector<SqlValue> row;
+        row.reserve(columnCount);
 
         for (int i = 0; i < columnCount; ++i) {
-            SqlValue value;
-
-            switch (sqlite3_column_type(stmt, i)) {
-                case SQLITE_INTEGER:
-                    value = SqlValue(static_cast<double>(sqlite3_column_int64(stmt, i)));
-                    break;
-                case SQLITE_FLOAT:
-                    value = SqlValue(sqlite3_column_double(stmt, i));
-                    break;
-                case SQLITE_TEXT:
-                    {
-                        int bytes = sqlite3_column_bytes(stmt, i);
-                        const unsigned char* utf8 = sqlite3_column_text(stmt, i);
-                        if (utf8 && bytes > 0) {
-                            value = SqlValue(std::string(reinterpret_cast<const char*>(utf8), bytes));
-                        } else {
-                            value = SqlValue(std::string(""));
-                        }
-                    }
-                    break;
-                case SQLITE_NULL:
-                    value = SqlValue(nullptr);
-                    break;
-                default:
-                    {
-                        int bytes = sqlite3_column_bytes(stmt, i);
-                        const unsigned char* utf8 = sqlite3_column_text(stmt, i);
-                        if (utf8 && bytes > 0) {
-                            value = SqlValue(std::string(reinterpret_cast<const char*>(utf8), bytes));
-                        } else {
-                            value = SqlValue(std::string(""));
-                        }
-                    }
-                    break;
-            }
-
-            row.push_back(value);
+            row.push_back(columnValue(stmt, i));
         }
 
         return row;
@@ -275,9 +329,16 @@ void SQLiteDriver::createOrMigrateTable(const std::string& tableName, const std:
     }
 
 void SQLiteDriver::beginTransaction() {
-        executeSql("BEGIN TRANSACTION");
+        // Take the write lock up front. A deferred transaction that reads and then writes
+        // while another connection writes gets SQLITE_BUSY at once: the busy timeout cannot
+        // help, as the other writer needs this transaction's read lock gone to commit.
+        executeSql(config_.readOnly ? "BEGIN TRANSACTION" : "BEGIN IMMEDIATE TRANSACTION");
     }
 
+void SQLiteDriver::beginReadOnlyTransaction() {
+    executeSql("BEGIN TRANSACTION");
+}
+
 bool SQLiteDriver::isInTransaction() {
     return sqlite3_get_autocommit(db_) == 0;
 }
@@ -335,6 +396,93 @@ std::vector<TableColumn> SQLiteDriver::getTableSchema(const std::string& tableNa
     return columns;
 }
 
+std::optional<std::string> SQLiteDriver::schemaVersion() {
+    // FNV-1a over the CREATE statements; PRAGMA schema_version alone is a counter that
+    // two different databases can share
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const auto& row : querySql("SELECT type, name, sql FROM sqlite_master ORDER BY type, name")) {
+        for (const auto& value : row) {
+            const std::string text = value.isNull() ? std::string() : value.asString();
+            for (const unsigned char c : text) {
+                hash = (hash ^ c) * 1099511628211ull;
+            }
+            hash = (hash ^ 0xFF) * 1099511628211ull; // field separator
+        }
+    }
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return "sqlite:" + std::string(buffer);
+}
+
+void SQLiteDriver::setDeadline(const Deadline& deadline) {
+    deadline_ = deadline;
+    if (!db_) {
+        return;
+    }
+    if (!deadline_.isSet()) {
+        sqlite3_progress_handler(db_, 0, nullptr, nullptr);
+        sqlite3_busy_timeout(db_, config_.sqliteBusyTimeoutMs);
+        return;
+    }
+    // Looked at every thousand virtual machine steps: a statement still running when the
+    // deadline passes is interrupted and fails with SQLITE_INTERRUPT
+    sqlite3_progress_handler(db_, 1000, [](void* self) { return static_cast<SQLiteDriver*>(self)->deadline_.expired() ? 1 : 0; }, this);
+    const auto remaining = std::max<long long>(deadline_.remaining().count(), 1);
+    sqlite3_busy_timeout(db_, static_cast<int>(std::min<long long>(config_.sqliteBusyTimeoutMs, remaining)));
+}
+
+StatementCacheStats SQLiteDriver::statementCacheStats() const {
+    return statements_.stats();
+}
+
+sqlite3_stmt* SQLiteDriver::acquireStatement(const std::string& sql, bool& cached) {
+    cached = false;
+    sqlite3_stmt** entry = statements_.enabled() ? statements_.find(sql) : nullptr;
+    // A statement still stepping (a row callback re-running its own query)
+    // cannot be shared; such calls get a private statement instead.
+    if (entry && !sqlite3_stmt_busy(*entry)) {
+        cached = true;
+        return *entry;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        throw std::runtime_error("Failed to prepare SQL: " + std::string(sqlite3_errmsg(db_)));
+    }
+    // Empty statements prepare to a null handle; nothing worth caching
+    if (stmt && statements_.enabled() && !entry) {
+        statements_.insert(sql, stmt);
+        cached = true;
+    }
+    return stmt;
+}
+
+void SQLiteDriver::finalizeCachedStatement(sqlite3_stmt* stmt) {
+    // Evicted while a row callback is still reading from it; the reader finalizes it
+    if (sqlite3_stmt_busy(stmt)) {
+        evictedBusy_.push_back(stmt);
+    } else {
+        sqlite3_finalize(stmt);
+    }
+}
+
+void SQLiteDriver::releaseStatement(sqlite3_stmt* stmt, bool cached) {
+    if (cached) {
+        auto evicted = std::find(evictedBusy_.begin(), evictedBusy_.end(), stmt);
+        if (evicted != evictedBusy_.end()) {
+            evictedBusy_.erase(evicted);
+            sqlite3_finalize(stmt);
+            return;
+        }
+        // Resetting ends the statement so it no longer holds read locks, and
+        // drops bound values so they are not kept alive until the next use.
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    } else {
+        sqlite3_finalize(stmt);
+    }
+}
+
 void SQLiteDriver::bindParameters(sqlite3_stmt* stmt, const std::vector<SqlParameter>& params) {
     for (size_t i = 0; i < params.size(); ++i) {
         const auto& param = params[i];
@@ -0,0 +1,141 @@
+#include "trx/runtime/SchemaCache.h"
+
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/JsonWriter.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+namespace trx::runtime {
+
+namespace {
+
+const JsonValue *member(const JsonValue &object, const std::string &key) {
+    return object.isObject() ? object.findField(key) : nullptr;
+}
+
+const JsonValue &required(const JsonValue &object, const std::string &key) {
+    const auto *value = member(object, key);
+    if (!value) {
+        throw std::runtime_error("Schema cache entry has no '" + key + "'");
+    }
+    return *value;
+}
+
+JsonValue optionalNumber(const auto &value) {
+    return value ? JsonValue(static_cast<double>(*value)) : JsonValue();
+}
+
+} // namespace
+
+SchemaCache::SchemaCache(std::filesystem::path file, std::string version) : file_{std::move(file)}, version_{std::move(version)} {
+    std::ifstream in(file_, std::ios::binary);
+    if (!in) {
+        return;
+    }
+    const std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    try {
+        const JsonValue root = JsonParser(text).parse();
+        const auto *version = member(root, "version");
+        const auto *tables = member(root, "tables");
+        if (!version || !version->isString() || version->asString() != version_ || !tables || !tables->isArray()) {
+            return;
+        }
+        for (const auto &table : tables->asArray()) {
+            const auto *name = member(table, "table");
+            const auto *columns = member(table, "columns");
+            if (!name || !name->isString() || !columns || !columns->isArray()) {
+                continue;
+            }
+            std::vector<TableColumn> parsed;
+            for (const auto &column : columns->asArray()) {
+                TableColumn col;
+                col.name = required(column, "name").asString();
+                col.typeName = required(column, "type").asString();
+                col.isPrimaryKey = required(column, "primary_key").asBool();
+                col.isNullable = required(column, "nullable").asBool();
+                if (const auto *length = member(column, "length"); length && length->isNumber()) {
+                    col.length = static_cast<long>(length->asNumber());
+                }
+                if (const auto *scale = member(column, "scale"); scale && scale->isNumber()) {
+                    col.scale = static_cast<short>(scale->asNumber());
+                }
+                if (const auto *defaultValue = member(column, "default"); defaultValue && defaultValue->isString()) {
+                    col.defaultValue = defaultValue->asString();
+                }
+                parsed.push_back(std::move(col));
+            }
+            tables_[name->asString()] = std::move(parsed);
+        }
+    } catch (const std::exception &) {
+        // A damaged file is read again from the database and rewritten
+        tables_.clear();
+        dirty_ = true;
+    }
+}
+
+const std::vector<TableColumn> *SchemaCache::find(const std::string &table) const {
+    const auto it = tables_.find(table);
+    return it != tables_.end() ? &it->second : nullptr;
+}
+
+void SchemaCache::store(const std::string &table, std::vector<TableColumn> columns) {
+    tables_[table] = std::move(columns);
+    dirty_ = true;
+}
+
+bool SchemaCache::save() const {
+    if (!dirty_) {
+        return true;
+    }
+    JsonValue::Array tables;
+    for (const auto &[name, columns] : tables_) {
+        JsonValue::Array entries;
+        for (const auto &col : columns) {
+            JsonValue::Object entry;
+            entry["name"] = JsonValue(col.name);
+            entry["type"] = JsonValue(col.typeName);
+            entry["primary_key"] = JsonValue(col.isPrimaryKey);
+            entry["nullable"] = JsonValue(col.isNullable);
+            entry["length"] = optionalNumber(col.length);
+            entry["scale"] = optionalNumber(col.scale);
+            entry["default"] = col.defaultValue ? JsonValue(*col.defaultValue) : JsonValue();
+            entries.push_back(JsonValue(std::move(entry)));
+        }
+        JsonValue::Object table;
+        table["table"] = JsonValue(name);
+        table["columns"] = JsonValue(std::move(entries));
+        tables.push_back(JsonValue(std::move(table)));
+    }
+    JsonValue::Object root;
+    root["version"] = JsonValue(version_);
+    root["tables"] = JsonValue(std::move(tables));
+
+    // Written next to the target and renamed over it, so a concurrent start never reads half a file
+    std::error_code error;
+    if (file_.has_parent_path()) {
+        std::filesystem::create_directories(file_.parent_path(), error);
+    }
+    auto temporary = file_;
+    temporary += "." + std::to_string(::getpid()) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << JsonWriter::toString(JsonValue(std::move(root)));
+        if (!out.flush()) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, file_, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace trx::runtime
@@ -0,0 +1,508 @@
+#include "trx/runtime/SqlStatistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+
+namespace trx::runtime {
+
+struct SqlStatistics::Entry {
+    explicit Entry(std::string text) : statement(std::move(text)) {}
+
+    const std::string statement;
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> errors{0};
+    std::atomic<std::uint64_t> rows{0};
+    std::atomic<std::uint64_t> totalNanos{0};
+    std::atomic<std::uint64_t> maxNanos{0};
+    std::array<std::atomic<std::uint64_t>, LatencyHistogram::bucketBounds.size() + 1> buckets{};
+    std::mutex errorMutex;
+    std::string lastError;
+};
+
+namespace {
+
+bool identifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' || c == ':' || c == '?' || c == '"';
+}
+
+// Replaces "IN (?, ?, ?)" by "IN (...)" so lists of different lengths count as one statement
+std::string collapseInLists(std::string text) {
+    std::string out;
+    out.reserve(text.size());
+    std::size_t i = 0;
+    while (i < text.size()) {
+        const bool atIn = i + 4 <= text.size() && (text[i] == 'I' || text[i] == 'i') && (text[i + 1] == 'N' || text[i + 1] == 'n') &&
+                          (i == 0 || !identifierChar(text[i - 1]));
+        if (atIn) {
+            std::size_t open = i + 2;
+            if (open < text.size() && text[open] == ' ') {
+                ++open;
+            }
+            if (open < text.size() && text[open] == '(') {
+                std::size_t close = open + 1;
+                while (close < text.size() && (text[close] == '?' || text[close] == ',' || text[close] == ' ')) {
+                    ++close;
+                }
+                if (close < text.size() && text[close] == ')' && close > open + 1) {
+                    out.append(text, i, 2);
+                    out += " (...)";
+                    i = close + 1;
+                    continue;
+                }
+            }
+        }
+        out += text[i++];
+    }
+    return out;
+}
+
+// Names and types of the bind parameters, never their values
+std::string describeParameters(const std::vector<SqlParameter> &params) {
+    std::string out;
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        if (i > 0) {
+            out += ", ";
+        }
+        out += params[i].name.empty() ? "$" + std::to_string(i + 1) : params[i].name;
+        const auto &value = params[i].value;
+        out += value.isNull() ? "=<null>" : value.isString() ? "=<string>" : value.isNumber() ? "=<number>" : value.isBool() ? "=<bool>" : "=<json>";
+    }
+    return out;
+}
+
+} // namespace
+
+double SqlStatistics::StatementStats::quantile(double q) const {
+    std::uint64_t count = 0;
+    for (const auto bucket : buckets) {
+        count += bucket;
+    }
+    if (count == 0) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < LatencyHistogram::bucketBounds.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return LatencyHistogram::bucketBounds[i];
+        }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+SqlStatistics::SqlStatistics(Options options)
+    : options_(std::move(options)), other_(std::make_unique<Entry>("(other)")) {
+    if (!options_.log) {
+        options_.log = [](const std::string &line) { std::cerr << line << std::endl; };
+    }
+}
+
+SqlStatistics::SqlStatistics() : SqlStatistics(Options{}) {}
+
+SqlStatistics::~SqlStatistics() = default;
+
+SqlStatistics::Entry &SqlStatistics::statement(std::string_view sql) {
+    auto text = normalize(sql);
+    {
+        std::shared_lock lock(mutex_);
+        if (const auto it = entries_.find(text); it != entries_.end()) {
+            return *it->second;
+        }
+    }
+    std::unique_lock lock(mutex_);
+    if (const auto it = entries_.find(text); it != entries_.end()) {
+        return *it->second;
+    }
+    if (entries_.size() >= options_.maxStatements) {
+        return *other_;
+    }
+    auto entry = std::make_unique<Entry>(text);
+    return *entries_.emplace(std::move(text), std::move(entry)).first->second;
+}
+
+void SqlStatistics::record(Entry &entry, std::chrono::nanoseconds elapsed, std::size_t rows, bool newCall,
+                           const char *error, const std::vector<SqlParameter> *params) {
+    const auto nanos = static_cast<std::uint64_t>(std::max<std::int64_t>(0, elapsed.count()));
+    if (newCall) {
+        entry.calls.fetch_add(1, std::memory_order_relaxed);
+    }
+    entry.rows.fetch_add(rows, std::memory_order_relaxed);
+    entry.totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+    auto max = entry.maxNanos.load(std::memory_order_relaxed);
+    while (nanos > max && !entry.maxNanos.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+    const double seconds = static_cast<double>(nanos) / 1e9;
+    const auto bucket = std::lower_bound(LatencyHistogram::bucketBounds.begin(), LatencyHistogram::bucketBounds.end(), seconds) -
+                        LatencyHistogram::bucketBounds.begin();
+    entry.buckets[static_cast<std::size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+    if (error) {
+        entry.errors.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard lock(entry.errorMutex);
+        entry.lastError = error;
+    }
+
+    if (options_.slowQueryThreshold.count() > 0 && elapsed >= options_.slowQueryThreshold) {
+        std::ostringstream line;
+        line.setf(std::ios::fixed);
+        line.precision(1);
+        line << "Slow SQL (" << static_cast<double>(nanos) / 1e6 << " ms, " << rows << " rows" << (error ? ", failed" : "") << "): "
+             << entry.statement;
+        if (params && !params->empty()) {
+            line << " [" << describeParameters(*params) << "]";
+        }
+        options_.log(line.str());
+    }
+}
+
+std::vector<SqlStatistics::StatementStats> SqlStatistics::top(std::size_t count) const {
+    std::vector<StatementStats> all;
+    const auto snapshot = [&all](Entry &entry) {
+        StatementStats stats;
+        stats.statement = entry.statement;
+        stats.calls = entry.calls.load(std::memory_order_relaxed);
+        stats.errors = entry.errors.load(std::memory_order_relaxed);
+        stats.rows = entry.rows.load(std::memory_order_relaxed);
+        stats.totalSeconds = static_cast<double>(entry.totalNanos.load(std::memory_order_relaxed)) / 1e9;
+        stats.maxSeconds = static_cast<double>(entry.maxNanos.load(std::memory_order_relaxed)) / 1e9;
+        for (std::size_t i = 0; i < stats.buckets.size(); ++i) {
+            stats.buckets[i] = entry.buckets[i].load(std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard lock(entry.errorMutex);
+            stats.lastError = entry.lastError;
+        }
+        if (stats.calls > 0 || stats.totalSeconds > 0.0) {
+            all.push_back(std::move(stats));
+        }
+    };
+    {
+        std::shared_lock lock(mutex_);
+        all.reserve(entries_.size() + 1);
+        for (const auto &[text, entry] : entries_) {
+            snapshot(*entry);
+        }
+        snapshot(*other_);
+    }
+    const auto end = all.begin() + static_cast<std::ptrdiff_t>(std::min(count, all.size()));
+    std::partial_sort(all.begin(), end, all.end(),
+                      [](const StatementStats &a, const StatementStats &b) { return a.totalSeconds > b.totalSeconds; });
+    all.erase(end, all.end());
+    return all;
+}
+
+std::string SqlStatistics::normalize(std::string_view sql) {
+    std::string out;
+    out.reserve(sql.size());
+    bool space = false;
+    for (std::size_t i = 0; i < sql.size(); ++i) {
+        const char c = sql[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = true;
+            continue;
+        }
+        if (space && !out.empty()) {
+            out += ' ';
+        }
+        space = false;
+        if (c == '\'') {
+            // A quote inside a string literal is doubled
+            ++i;
+            while (i < sql.size() && !(sql[i] == '\'' && (i + 1 >= sql.size() || sql[i + 1] != '\''))) {
+                i += sql[i] == '\'' ? 2 : 1;
+            }
+            out += '?';
+            continue;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) && (out.empty() || !identifierChar(out.back()))) {
+            while (i + 1 < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i + 1])) || sql[i + 1] == '.')) {
+                ++i;
+            }
+            out += '?';
+            continue;
+        }
+        out += c;
+    }
+    return collapseInLists(std::move(out));
+}
+
+namespace {
+
+// Times one driver call and records it when it returns or throws
+class Timing {
+public:
+    Timing(SqlStatistics &statistics, SqlStatistics::Entry &entry, bool newCall = true, const std::vector<SqlParameter> *params = nullptr)
+        : statistics_{statistics}, entry_{entry}, newCall_{newCall}, params_{params}, start_{std::chrono::steady_clock::now()} {}
+
+    void done(std::size_t rows = 0) {
+        statistics_.record(entry_, std::chrono::steady_clock::now() - start_, rows, newCall_, nullptr, params_);
+    }
+
+    void failed(const std::exception &error) {
+        statistics_.record(entry_, std::chrono::steady_clock::now() - start_, 0, newCall_, error.what(), params_);
+    }
+
+private:
+    SqlStatistics &statistics_;
+    SqlStatistics::Entry &entry_;
+    bool newCall_;
+    const std::vector<SqlParameter> *params_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace
+
+InstrumentedDriver::InstrumentedDriver(std::unique_ptr<DatabaseDriver> driver, std::shared_ptr<SqlStatistics> statistics)
+    : driver_(std::move(driver)), statistics_(std::move(statistics)),
+      begin_(&statistics_->statement("BEGIN")), commit_(&statistics_->statement("COMMIT")),
+      rollback_(&statistics_->statement("ROLLBACK")) {}
+
+void InstrumentedDriver::initialize() {
+    driver_->initialize();
+}
+
+void InstrumentedDriver::executeSql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    Timing timing(*statistics_, statistics_->statement(sql), true, &params);
+    try {
+        driver_->executeSql(sql, params);
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+std::vector<std::size_t> InstrumentedDriver::executeBatch(const std::string& sql, const std::vector<std::vector<SqlParameter>>& paramSets) {
+    auto &entry = statistics_->statement(sql);
+    Timing timing(*statistics_, entry, true, paramSets.empty() ? nullptr : &paramSets.front());
+    std::vector<std::size_t> failed;
+    try {
+        failed = driver_->executeBatch(sql, paramSets);
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    if (!failed.empty()) {
+        const std::runtime_error error(std::to_string(failed.size()) + " of " + std::to_string(paramSets.size()) + " batch rows failed");
+        timing.failed(error);
+    } else {
+        timing.done();
+    }
+    return failed;
+}
+
+// A queued statement is timed while it is sent; its failure, if any, only shows in SQLCODE
+bool InstrumentedDriver::queueSql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    Timing timing(*statistics_, statistics_->statement(sql), true, &params);
+    try {
+        if (!driver_->queueSql(sql, params)) {
+            return false; // executeSql times it
+        }
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+    return true;
+}
+
+bool InstrumentedDriver::syncQueued() {
+    return driver_->syncQueued();
+}
+
+std::vector<std::vector<SqlValue>> InstrumentedDriver::querySql(const std::string& sql, const std::vector<SqlParameter>& params) {
+    Timing timing(*statistics_, statistics_->statement(sql), true, &params);
+    std::vector<std::vector<SqlValue>> rows;
+    try {
+        rows = driver_->querySql(sql, params);
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done(rows.size());
+    return rows;
+}
+
+void InstrumentedDriver::queryRows(const std::string& sql, const std::vector<SqlParameter>& params, const RowCallback& onRow) {
+    Timing timing(*statistics_, statistics_->statement(sql), true, &params);
+    std::size_t rows = 0;
+    try {
+        driver_->queryRows(sql, params, [&](const std::vector<SqlValue>& row) {
+            ++rows;
+            return onRow(row);
+        });
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done(rows);
+}
+
+void InstrumentedDriver::openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
+    openCursor(name, sql, params, false);
+}
+
+void InstrumentedDriver::openPositionedCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params) {
+    openCursor(name, sql, params, true);
+}
+
+void InstrumentedDriver::openCursor(const std::string& name, const std::string& sql, const std::vector<SqlParameter>& params, bool positioned) {
+    auto &entry = statistics_->statement(sql);
+    cursors_[name] = &entry;
+    Timing timing(*statistics_, entry, true, &params);
+    try {
+        if (positioned) {
+            driver_->openPositionedCursor(name, sql, params);
+        } else {
+            driver_->openCursor(name, sql, params);
+        }
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+void InstrumentedDriver::openDeclaredCursor(const std::string& name) {
+    const auto it = cursors_.find(name);
+    if (it == cursors_.end()) {
+        driver_->openDeclaredCursor(name);
+        return;
+    }
+    Timing timing(*statistics_, *it->second, false);
+    try {
+        driver_->openDeclaredCursor(name);
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+void InstrumentedDriver::openDeclaredCursorWithParams(const std::string& name, const std::vector<SqlParameter>& params) {
+    const auto it = cursors_.find(name);
+    if (it == cursors_.end()) {
+        driver_->openDeclaredCursorWithParams(name, params);
+        return;
+    }
+    Timing timing(*statistics_, *it->second, false, &params);
+    try {
+        driver_->openDeclaredCursorWithParams(name, params);
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+bool InstrumentedDriver::cursorNext(const std::string& name) {
+    const auto it = cursors_.find(name);
+    if (it == cursors_.end()) {
+        return driver_->cursorNext(name);
+    }
+    // Fetches add their time and rows to the cursor's statement without counting as calls
+    Timing timing(*statistics_, *it->second, false);
+    bool found = false;
+    try {
+        found = driver_->cursorNext(name);
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done(found ? 1 : 0);
+    return found;
+}
+
+std::vector<SqlValue> InstrumentedDriver::cursorGetRow(const std::string& name) {
+    return driver_->cursorGetRow(name);
+}
+
+void InstrumentedDriver::closeCursor(const std::string& name) {
+    cursors_.erase(name);
+    driver_->closeCursor(name);
+}
+
+void InstrumentedDriver::createOrMigrateTable(const std::string& tableName, const std::vector<TableColumn>& columns) {
+    driver_->createOrMigrateTable(tableName, columns);
+}
+
+std::vector<TableColumn> InstrumentedDriver::getTableSchema(const std::string& tableName) {
+    return driver_->getTableSchema(tableName);
+}
+
+std::optional<std::string> InstrumentedDriver::schemaVersion() {
+    return driver_->schemaVersion();
+}
+
+void InstrumentedDriver::beginTransaction() {
+    Timing timing(*statistics_, *begin_);
+    try {
+        driver_->beginTransaction();
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+void InstrumentedDriver::beginReadOnlyTransaction() {
+    Timing timing(*statistics_, *begin_);
+    try {
+        driver_->beginReadOnlyTransaction();
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+void InstrumentedDriver::commitTransaction() {
+    Timing timing(*statistics_, *commit_);
+    try {
+        driver_->commitTransaction();
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+void InstrumentedDriver::rollbackTransaction() {
+    Timing timing(*statistics_, *rollback_);
+    try {
+        driver_->rollbackTransaction();
+    } catch (const std::exception &error) {
+        timing.failed(error);
+        throw;
+    }
+    timing.done();
+}
+
+bool InstrumentedDriver::isInTransaction() {
+    return driver_->isInTransaction();
+}
+
+bool InstrumentedDriver::ping() {
+    return driver_->ping();
+}
+
+void InstrumentedDriver::setDeadline(const Deadline& deadline) {
+    driver_->setDeadline(deadline);
+}
+
+StatementCacheStats InstrumentedDriver::statementCacheStats() const {
+    return driver_->statementCacheStats();
+}
+
+std::unique_ptr<DatabaseDriver> InstrumentedDriver::openSibling() {
+    auto sibling = driver_->openSibling();
+    return sibling ? std::make_unique<InstrumentedDriver>(std::move(sibling), statistics_) : nullptr;
+}
+
+} // namespace trx::runtime
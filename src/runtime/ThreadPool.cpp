@@ -1,32 +1,169 @@
 #include "trx/runtime/ThreadPool.h"
 
-ThreadPool::ThreadPool(size_t threads) : stop(false) {
+#include "trx/runtime/Fiber.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+thread_local size_t workerIndex = ThreadPool::npos;
+thread_local const ThreadPool *workerPool = nullptr;
+}
+
+size_t ThreadPool::currentWorkerIndex() {
+    return workerIndex;
+}
+
+size_t ThreadPool::currentTaskSlot() {
+    if (!workerPool) {
+        return npos;
+    }
+    if (workerPool->fibersPerWorker == 1) {
+        return workerIndex;
+    }
+    const size_t fiber = trx::runtime::FiberScheduler::currentFiberIndex();
+    return fiber == trx::runtime::FiberScheduler::npos ? npos : workerIndex * workerPool->fibersPerWorker + fiber;
+}
+
+ThreadPool::ThreadPool(size_t threads, size_t maxQueued, size_t fibersPerWorker)
+    : maxQueued(maxQueued), fibersPerWorker(std::max<size_t>(1, fibersPerWorker)), waitTimes_(1, threads + 1), stop(false) {
+    if (threads == 0) {
+        throw std::invalid_argument("ThreadPool needs at least one thread");
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+        if (this->fibersPerWorker > 1) {
+            fiberWorkers.push_back(std::make_unique<FiberWorker>());
+        }
+    }
     for (size_t i = 0; i < threads; ++i) {
-        workers.emplace_back([this] {
-            for (;;) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(this->queueMutex);
-                    this->condition.wait(lock, [this] {
-                        return this->stop || !this->tasks.empty();
-                    });
-                    if (this->stop && this->tasks.empty())
-                        return;
-                    task = std::move(this->tasks.front());
-                    this->tasks.pop();
-                }
-                task();
+        workers.emplace_back([this, i] {
+            workerIndex = i;
+            workerPool = this;
+            if (this->fibersPerWorker > 1) {
+                runFibers(i);
+            } else {
+                runTasks(i);
             }
         });
     }
 }
 
+void ThreadPool::runTasks(size_t worker) {
+    for (;;) {
+        Task task;
+        if (take(worker, task)) {
+            observeWait(worker, task);
+            task.run();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        condition.wait(lock, [this] {
+            return stop || pending.load() > 0;
+        });
+        // Queued tasks still run after the destructor asks the workers to stop
+        if (stop && pending.load() == 0)
+            return;
+    }
+}
+
+void ThreadPool::runFibers(size_t worker) {
+    trx::runtime::FiberScheduler scheduler;
+    FiberWorker &self = *fiberWorkers[worker];
+    self.scheduler = &scheduler;
+    for (;;) {
+        Task task;
+        if (scheduler.active() < fibersPerWorker && take(worker, task)) {
+            observeWait(worker, task);
+            scheduler.spawn(std::move(task.run));
+            continue;
+        }
+        if (scheduler.active() > 0) {
+            // Every fiber is waiting. With room for another, push() wakes the poll; a task
+            // it queued between take() and publishing hasRoom shows in pending instead.
+            const bool room = scheduler.active() < fibersPerWorker;
+            self.hasRoom.store(room);
+            const bool queued = room && pending.load() > 0;
+            scheduler.poll(queued ? std::chrono::milliseconds(0) : std::chrono::milliseconds(-1));
+            self.hasRoom.store(false);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        condition.wait(lock, [this] {
+            return stop || pending.load() > 0;
+        });
+        if (stop && pending.load() == 0)
+            return;
+    }
+}
+
+void ThreadPool::observeWait(size_t worker, const Task &task) {
+    const std::chrono::duration<double> waited = std::chrono::steady_clock::now() - task.queuedAt;
+    waitTimes_.observe(worker, 0, waited.count());
+}
+
 ThreadPool::~ThreadPool() {
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
+        std::unique_lock<std::mutex> lock(sleepMutex);
         stop = true;
     }
     condition.notify_all();
     for (std::thread &worker : workers)
         worker.join();
-}
\ No newline at end of file
+}
+
+bool ThreadPool::push(std::function<void()> run, bool bounded) {
+    // Counted before the task is visible, so a worker taking it never drives pending below zero
+    const size_t queued = pending.fetch_add(1);
+    if (bounded && maxQueued > 0 && queued >= maxQueued) {
+        pending.fetch_sub(1);
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const size_t target = workerPool == this ? workerIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(Task{std::move(run), std::chrono::steady_clock::now()});
+    }
+    {
+        // A worker between checking pending and sleeping holds the lock, so it cannot miss this wakeup
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    condition.notify_one();
+    // Workers with waiting fibers sleep in their scheduler, not on the condition
+    for (size_t offset = 0; offset < fiberWorkers.size(); ++offset) {
+        FiberWorker &worker = *fiberWorkers[(target + offset) % fiberWorkers.size()];
+        if (worker.hasRoom.load()) {
+            worker.scheduler->wake();
+            break;
+        }
+    }
+    return true;
+}
+
+bool ThreadPool::take(size_t worker, Task &task) {
+    for (size_t offset = 0; offset < queues.size(); ++offset) {
+        auto &queue = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // Oldest first from every deque, so stealing does not reorder requests
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        pending.fetch_sub(1);
+        if (offset > 0) {
+            stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+    return false;
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+    Stats stats;
+    stats.queued = pending.load();
+    stats.rejected = rejected.load(std::memory_order_relaxed);
+    stats.stolen = stolen.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,306 @@
+#include "trx/runtime/Tracing.h"
+
+#include "trx/runtime/HttpClient.h"
+#include "trx/runtime/JsonWriter.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace trx::runtime {
+
+namespace {
+
+std::mt19937_64 &randomEngine() {
+    thread_local std::mt19937_64 engine{[] {
+        std::random_device device;
+        return (static_cast<std::uint64_t>(device()) << 32) ^ device() ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+    }()};
+    return engine;
+}
+
+template <std::size_t Size>
+void fillRandom(std::array<std::uint8_t, Size> &id) {
+    // An id of all zeros is invalid
+    do {
+        for (std::size_t i = 0; i < Size; i += 8) {
+            const auto bits = randomEngine()();
+            for (std::size_t j = 0; j < 8 && i + j < Size; ++j) {
+                id[i + j] = static_cast<std::uint8_t>(bits >> (j * 8));
+            }
+        }
+    } while (std::all_of(id.begin(), id.end(), [](std::uint8_t byte) { return byte == 0; }));
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1; // upper case is not allowed in traceparent
+}
+
+template <std::size_t Size>
+bool parseHex(std::string_view text, std::array<std::uint8_t, Size> &out) {
+    if (text.size() != Size * 2) {
+        return false;
+    }
+    for (std::size_t i = 0; i < Size; ++i) {
+        const int high = hexDigit(text[2 * i]);
+        const int low = hexDigit(text[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i] = static_cast<std::uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+template <std::size_t Size>
+void appendHex(std::string &out, const std::array<std::uint8_t, Size> &id) {
+    static constexpr char digits[] = "0123456789abcdef";
+    for (const auto byte : id) {
+        out += digits[byte >> 4];
+        out += digits[byte & 0x0f];
+    }
+}
+
+template <std::size_t Size>
+bool allZero(const std::array<std::uint8_t, Size> &id) {
+    return std::all_of(id.begin(), id.end(), [](std::uint8_t byte) { return byte == 0; });
+}
+
+std::uint64_t unixNanos() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool postBatch(const std::string &endpoint, const std::string &body) {
+    HttpCall call;
+    call.method = "POST";
+    call.url = endpoint;
+    call.headers["Content-Type"] = "application/json";
+    call.body = body;
+    call.timeoutMs = 10000;
+    try {
+        const auto reply = HttpClient::perform(call);
+        return reply.status >= 200 && reply.status < 300;
+    } catch (const std::exception &) {
+        return false;
+    }
+}
+
+} // namespace
+
+bool TraceContext::valid() const {
+    return !allZero(traceId) && !allZero(spanId);
+}
+
+std::optional<TraceContext> TraceContext::parse(std::string_view traceparent) {
+    // version "-" trace-id "-" parent-id "-" trace-flags; later versions may append fields
+    if (traceparent.size() < 55 || traceparent[2] != '-' || traceparent[35] != '-' || traceparent[52] != '-') {
+        return std::nullopt;
+    }
+    std::array<std::uint8_t, 1> version{};
+    std::array<std::uint8_t, 1> flags{};
+    TraceContext context;
+    if (!parseHex(traceparent.substr(0, 2), version) || version[0] == 0xff ||
+        !parseHex(traceparent.substr(3, 32), context.traceId) ||
+        !parseHex(traceparent.substr(36, 16), context.spanId) ||
+        !parseHex(traceparent.substr(53, 2), flags)) {
+        return std::nullopt;
+    }
+    if (traceparent.size() > 55 && (version[0] == 0 || traceparent[55] != '-')) {
+        return std::nullopt;
+    }
+    if (!context.valid()) {
+        return std::nullopt;
+    }
+    context.sampled = (flags[0] & 0x01) != 0;
+    return context;
+}
+
+std::string TraceContext::traceparent() const {
+    std::string header = "00-";
+    header.reserve(55);
+    appendHex(header, traceId);
+    header += '-';
+    appendHex(header, spanId);
+    header += sampled ? "-01" : "-00";
+    return header;
+}
+
+Tracer::Tracer(TracerOptions options, Exporter exporter)
+    : options_(std::move(options)), exporter_(std::move(exporter)) {
+    options_.maxBatchSize = std::max<std::size_t>(1, options_.maxBatchSize);
+    if (!exporter_) {
+        exporter_ = [endpoint = options_.endpoint](const std::string &body) { return postBatch(endpoint, body); };
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+Tracer::~Tracer() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void Tracer::submit(SpanData span) {
+    bool full = false;
+    {
+        std::lock_guard lock(mutex_);
+        if (queue_.size() >= options_.maxQueuedSpans) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        queue_.push_back(std::move(span));
+        full = queue_.size() == options_.maxBatchSize;
+    }
+    if (full) {
+        wake_.notify_one();
+    }
+}
+
+bool Tracer::sampleRoot() {
+    if (options_.sampleRatio >= 1.0) {
+        return true;
+    }
+    if (options_.sampleRatio <= 0.0) {
+        return false;
+    }
+    return std::uniform_real_distribution<double>(0.0, 1.0)(randomEngine()) < options_.sampleRatio;
+}
+
+void Tracer::run() {
+    std::vector<SpanData> pending;
+    std::vector<SpanData> batch;
+    bool stopping = false;
+    while (!stopping) {
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait_for(lock, options_.exportInterval, [this] { return stopping_ || queue_.size() >= options_.maxBatchSize; });
+            stopping = stopping_;
+            pending.swap(queue_);
+        }
+        for (std::size_t start = 0; start < pending.size(); start += options_.maxBatchSize) {
+            const auto end = std::min(start + options_.maxBatchSize, pending.size());
+            batch.assign(std::make_move_iterator(pending.begin() + static_cast<std::ptrdiff_t>(start)),
+                         std::make_move_iterator(pending.begin() + static_cast<std::ptrdiff_t>(end)));
+            if (exporter_(encode(options_.serviceName, batch))) {
+                exported_.fetch_add(batch.size(), std::memory_order_relaxed);
+            } else {
+                dropped_.fetch_add(batch.size(), std::memory_order_relaxed);
+            }
+        }
+        pending.clear();
+    }
+}
+
+std::string Tracer::encode(const std::string &serviceName, const std::vector<SpanData> &spans) {
+    std::string out;
+    JsonWriter writer(out);
+    out += R"({"resourceSpans":[{"resource":{"attributes":[{"key":"service.name","value":{"stringValue":)";
+    writer.writeString(serviceName);
+    out += R"(}}]},"scopeSpans":[{"scope":{"name":"trx"},"spans":[)";
+    for (std::size_t i = 0; i < spans.size(); ++i) {
+        const auto &span = spans[i];
+        if (i > 0) {
+            out += ',';
+        }
+        out += R"({"traceId":")";
+        appendHex(out, span.context.traceId);
+        out += R"(","spanId":")";
+        appendHex(out, span.context.spanId);
+        out += '"';
+        if (!allZero(span.parentSpanId)) {
+            out += R"(,"parentSpanId":")";
+            appendHex(out, span.parentSpanId);
+            out += '"';
+        }
+        out += R"(,"name":)";
+        writer.writeString(span.name);
+        out += R"(,"kind":)" + std::to_string(static_cast<int>(span.kind));
+        // 64-bit integers are strings in the JSON encoding
+        out += R"(,"startTimeUnixNano":")" + std::to_string(span.startUnixNanos);
+        out += R"(","endTimeUnixNano":")" + std::to_string(span.endUnixNanos) + '"';
+        out += R"(,"attributes":[)";
+        for (std::size_t a = 0; a < span.attributes.size(); ++a) {
+            const auto &[key, value] = span.attributes[a];
+            if (a > 0) {
+                out += ',';
+            }
+            out += R"({"key":)";
+            writer.writeString(key);
+            if (const auto *text = std::get_if<std::string>(&value)) {
+                out += R"(,"value":{"stringValue":)";
+                writer.writeString(*text);
+                out += "}}";
+            } else {
+                out += R"(,"value":{"intValue":")" + std::to_string(std::get<std::int64_t>(value)) + "\"}}";
+            }
+        }
+        out += ']';
+        if (span.error) {
+            out += R"(,"status":{"code":2,"message":)";
+            writer.writeString(*span.error);
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "]}]}]}";
+    return out;
+}
+
+Span::Span(Tracer *tracer, TraceContext &current, std::string name, SpanKind kind) {
+    if (!tracer) {
+        return;
+    }
+    if (current.valid() ? !current.sampled : !tracer->sampleRoot()) {
+        return;
+    }
+    tracer_ = tracer;
+    current_ = &current;
+    previous_ = current;
+    if (current.valid()) {
+        data_.context.traceId = current.traceId;
+        data_.parentSpanId = current.spanId;
+    } else {
+        fillRandom(data_.context.traceId);
+    }
+    fillRandom(data_.context.spanId);
+    data_.context.sampled = true;
+    data_.name = std::move(name);
+    data_.kind = kind;
+    data_.startUnixNanos = unixNanos();
+    current = data_.context;
+}
+
+Span::~Span() {
+    if (!tracer_) {
+        return;
+    }
+    data_.endUnixNanos = unixNanos();
+    *current_ = previous_;
+    tracer_->submit(std::move(data_));
+}
+
+void Span::setAttribute(std::string key, std::string value) {
+    if (tracer_) {
+        data_.attributes.emplace_back(std::move(key), std::move(value));
+    }
+}
+
+void Span::setAttribute(std::string key, std::int64_t value) {
+    if (tracer_) {
+        data_.attributes.emplace_back(std::move(key), value);
+    }
+}
+
+void Span::setError(std::string message) {
+    if (tracer_) {
+        data_.error = std::move(message);
+    }
+}
+
+} // namespace trx::runtime
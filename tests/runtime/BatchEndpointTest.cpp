@@ -0,0 +1,205 @@
+#include "TestUtils.h"
+
+#include "Server.h"
+
+#include "trx/runtime/HttpClient.h"
+#include "trx/runtime/JsonParser.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <netinet/in.h>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JsonValue;
+
+constexpr const char *source = R"TRX(
+    EXPORT METHOD POST ROUTINE add_row(row: JSON) : JSON {
+        EXEC SQL INSERT INTO batch_rows (id) VALUES (:row.id);
+        IF row.id = 2 {
+            THROW "row 2 is refused";
+        }
+        RETURN row;
+    }
+
+    EXPORT METHOD GET ROUTINE person/{id: INTEGER}() : JSON {
+        var name JSON;
+        EXEC SQL SELECT name INTO :name FROM batch_people WHERE id = :id;
+        RETURN { "id": id, "name": name };
+    }
+)TRX";
+
+// A loopback port nothing listens on yet
+int freePort() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+    ::close(fd);
+    return ntohs(address.sin_port);
+}
+
+std::optional<JsonValue> postBatch(int port, const std::string &body, long &status) {
+    trx::runtime::HttpCall call;
+    call.method = "POST";
+    call.url = "http://127.0.0.1:" + std::to_string(port) + "/api/_batch";
+    call.headers["Content-Type"] = "application/json";
+    call.body = body;
+    const auto reply = trx::runtime::HttpClient::perform(call);
+    status = reply.status;
+    if (reply.status != 200) {
+        return std::nullopt;
+    }
+    return trx::runtime::JsonParser(reply.body).parse();
+}
+
+bool waitForServer(int port) {
+    trx::runtime::HttpCall call;
+    call.method = "GET";
+    call.url = "http://127.0.0.1:" + std::to_string(port) + "/procedures";
+    call.timeoutMs = 1000;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        try {
+            if (trx::runtime::HttpClient::perform(call).status == 200) {
+                return true;
+            }
+        } catch (const std::exception &) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+double statusOf(const JsonValue &answer) {
+    const auto *status = answer.findField("status");
+    return status && status->isNumber() ? status->asNumber() : 0.0;
+}
+
+// The calls come back in their order whichever connection ran them
+bool answersInOrder(int port) {
+    constexpr int count = 12;
+    std::string calls = "[";
+    for (int id = 1; id <= count; ++id) {
+        calls += (id > 1 ? "," : "") + std::string("{\"method\": \"GET\", \"path\": \"/person/") + std::to_string(id) + "\"}";
+    }
+    calls += "]";
+
+    long status = 0;
+    const auto answers = postBatch(port, "{\"calls\": " + calls + ", \"parallel\": 4}", status);
+    if (!expect(answers && answers->isArray() && answers->asArray().size() == count, "a parallel batch should answer every call")) {
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        const auto &answer = answers->asArray()[i];
+        const auto *body = answer.findField("body");
+        const auto *id = body ? body->findField("id") : nullptr;
+        const auto *name = body ? body->findField("name") : nullptr;
+        if (!expect(statusOf(answer) == 200.0, "each call of a parallel batch should succeed") ||
+            !expect(id && id->asNumber() == i + 1, "answers should keep the order of the calls") ||
+            !expect(name && name->isString() && name->asString() == "person " + std::to_string(i + 1),
+                    "each answer should come from its own call")) {
+            return false;
+        }
+    }
+
+    for (const char *parallel : {"2.5", "0", "1000", "1e300", "\"4\""}) {
+        if (!expect(!postBatch(port, "{\"calls\": " + calls + ", \"parallel\": " + parallel + "}", status) && status == 400,
+                    std::string("parallel ") + parallel + " should be refused")) {
+            return false;
+        }
+    }
+    return expect(!postBatch(port, "{\"calls\": " + calls + ", \"parallel\": 2, \"transaction\": true}", status) && status == 400,
+                  "a batch should not run both in parallel and in one transaction");
+}
+
+// The first failing call rolls back the calls before it and stops the rest
+bool rollsBack(int port, const trx::runtime::DatabaseConfig &config) {
+    long status = 0;
+    const auto answers = postBatch(port, R"({"transaction": true, "calls": [
+        {"method": "POST", "path": "/add_row", "body": {"id": 1}},
+        {"method": "POST", "path": "/add_row", "body": {"id": 2}},
+        {"method": "POST", "path": "/add_row", "body": {"id": 3}}
+    ]})", status);
+    if (!expect(answers && answers->isArray() && answers->asArray().size() == 3, "a transaction batch should answer every call")) {
+        return false;
+    }
+    const auto &list = answers->asArray();
+    if (!expect(statusOf(list[0]) == 201.0, "the first call should succeed") ||
+        !expect(statusOf(list[1]) == 400.0, "the second call should fail") ||
+        !expect(statusOf(list[2]) == 424.0, "the call after the failure should not run")) {
+        return false;
+    }
+    auto db = trx::runtime::createDatabaseDriver(config);
+    const auto rows = db->querySql("SELECT COUNT(*) FROM batch_rows");
+    return expect(rows.size() == 1 && rows[0][0].asNumber() == 0.0, "the first call's row should be rolled back");
+}
+
+} // namespace
+
+bool runBatchEndpointTest() {
+    std::cout << "Running batch endpoint test...\n";
+
+    const auto directory = std::filesystem::temp_directory_path() / "trx_batch_endpoint_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto sourcePath = directory / "batch.trx";
+    std::ofstream(sourcePath) << source;
+
+    trx::cli::ServeOptions options;
+    options.port = freePort();
+    options.threadCount = 2;
+    options.poolMaxConnections = 8;
+    options.dbConfig.type = trx::runtime::DatabaseType::SQLITE;
+    options.dbConfig.databasePath = (directory / "batch.db").string();
+    {
+        auto db = trx::runtime::createDatabaseDriver(options.dbConfig);
+        db->executeSql("CREATE TABLE batch_rows (id INTEGER PRIMARY KEY)");
+        db->executeSql("CREATE TABLE batch_people (id INTEGER PRIMARY KEY, name TEXT)");
+        for (int id = 1; id <= 12; ++id) {
+            db->executeSql("INSERT INTO batch_people (id, name) VALUES (?, ?)",
+                           {{"id", JsonValue(static_cast<double>(id))}, {"name", JsonValue("person " + std::to_string(id))}});
+        }
+    }
+
+    int exitCode = 0;
+    std::thread server([&] { exitCode = trx::cli::runServer({sourcePath}, options); });
+    const bool passed = expect(waitForServer(options.port), "the server should start") && answersInOrder(options.port) &&
+                        rollsBack(options.port, options.dbConfig);
+    std::raise(SIGTERM);
+    server.join();
+
+    std::filesystem::remove_all(directory);
+    if (!passed || !expect(exitCode == 0, "the server should stop cleanly")) {
+        return false;
+    }
+    std::cout << "Batch endpoint test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runBatchEndpointTest()) {
+        std::cerr << "Batch endpoint tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
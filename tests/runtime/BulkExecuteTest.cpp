@@ -0,0 +1,109 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+bool runBulkExecuteTest() {
+    std::cout << "Running bulk execute test...\n";
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+
+    // Driver entry point: one statement, every set attempted, failures reported by index
+    {
+        trx::runtime::SQLiteDriver db(config);
+        db.initialize();
+        db.executeSql("CREATE TABLE bulk_rows (id INTEGER PRIMARY KEY, name TEXT)");
+
+        std::vector<std::vector<trx::runtime::SqlParameter>> paramSets;
+        for (double id : {1.0, 2.0, 2.0, 3.0}) {
+            paramSets.push_back({{"1", trx::runtime::SqlValue(id)}, {"2", trx::runtime::SqlValue("row")}});
+        }
+        const auto before = db.statementCacheStats();
+        const auto failed = db.executeBatch("INSERT INTO bulk_rows (id, name) VALUES (?, ?)", paramSets);
+        const auto after = db.statementCacheStats();
+        if (!expect(failed.size() == 1 && failed[0] == 2, "duplicate key should fail only its own parameter set") ||
+            !expect(db.querySql("SELECT COUNT(*) FROM bulk_rows")[0][0].asNumber() == 3.0, "sets after a failure should still run") ||
+            !expect(after.misses - before.misses == 1, "the batch should prepare its statement once")) {
+            return false;
+        }
+    }
+
+    // FOR loops whose body is a single INSERT are sent as one batch
+    {
+        constexpr const char *source = R"TRX(
+            ROUTINE import_rows(request: JSON) : JSON {
+                var prefix STRING := request.prefix;
+                FOR item IN request.items {
+                    EXEC SQL INSERT INTO bulk_rows (id, name) VALUES (:item.id, :prefix);
+                }
+                RETURN { "code": sqlcode };
+            }
+        )TRX";
+
+        trx::parsing::ParserDriver driver;
+        if (!driver.parseString(source, "bulk_execute.trx")) {
+            reportDiagnostics(driver);
+            return false;
+        }
+        trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+        interpreter.db().executeSql("CREATE TABLE bulk_rows (id INTEGER PRIMARY KEY, name TEXT)");
+
+        const auto importRows = [&](std::vector<double> ids) {
+            trx::runtime::JsonValue::Array items;
+            for (double id : ids) {
+                trx::runtime::JsonValue::Object item;
+                item["id"] = trx::runtime::JsonValue(id);
+                items.emplace_back(item);
+            }
+            trx::runtime::JsonValue::Object input;
+            input["prefix"] = trx::runtime::JsonValue("imported");
+            input["items"] = trx::runtime::JsonValue(items);
+            return interpreter.execute("import_rows", trx::runtime::JsonValue(input));
+        };
+
+        std::vector<double> ids;
+        for (int i = 1; i <= 2500; ++i) {
+            ids.push_back(i);
+        }
+        auto result = importRows(ids);
+        const auto rows = interpreter.db().querySql("SELECT COUNT(*), MIN(name), MAX(id) FROM bulk_rows");
+        if (!expect(result && result->asObject().at("code").asNumber() == 0.0, "successful batch should leave SQLCODE at 0") ||
+            !expect(rows[0][0].asNumber() == 2500.0 && rows[0][2].asNumber() == 2500.0, "every item should be inserted across chunks") ||
+            !expect(rows[0][1].asString() == "imported", "host variables outside the loop should be bound for every item")) {
+            return false;
+        }
+
+        // SQLCODE reflects the last item, as with one execution per item
+        result = importRows({3000.0, 1.0});
+        if (!expect(result && result->asObject().at("code").asNumber() == -1.0, "failing last item should set SQLCODE to -1")) {
+            return false;
+        }
+        result = importRows({2.0, 3001.0});
+        if (!expect(result && result->asObject().at("code").asNumber() == 0.0, "earlier failures should not leak into SQLCODE") ||
+            !expect(interpreter.db().querySql("SELECT COUNT(*) FROM bulk_rows")[0][0].asNumber() == 2502.0, "items around a failure should be inserted")) {
+            return false;
+        }
+    }
+
+    std::cout << "Bulk execute test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runBulkExecuteTest()) {
+        std::cerr << "Bulk execute tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/Bytecode.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runBytecodeTest() {
+    std::cout << "Running bytecode test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE crunch(request: JSON) : JSON {
+            var total INTEGER := 0;
+            var i INTEGER := 0;
+            var phase INTEGER := 0;
+            var kinds JSON := [];
+            WHILE i < request.limit {
+                IF phase = 0 {
+                    total := total + i * 2;
+                } ELSE {
+                    total := total - 1;
+                }
+                SWITCH phase {
+                    CASE 0 {
+                        append(kinds, 'zero');
+                    }
+                    CASE 1 {
+                        kinds[len(kinds)] := 'one';
+                    }
+                    DEFAULT {
+                        total := total + 0;
+                    }
+                }
+                phase := phase + 1;
+                IF phase = 3 {
+                    phase := 0;
+                }
+                i := i + 1;
+            }
+            FOR item IN request.items {
+                total := total + item.amount;
+            }
+            RETURN { "total": total, "kinds": kinds, "negated": -total, "done": NOT (i < request.limit) };
+        }
+
+        ROUTINE guarded(request: JSON) : JSON {
+            var caught JSON := {};
+            var attempts INTEGER := 0;
+            FOR item IN request.items {
+                TRY {
+                    attempts := attempts + 1;
+                    IF item > 1 {
+                        THROW { "item": item };
+                    }
+                } CATCH (failure) {
+                    caught := failure.value;
+                }
+            }
+            RETURN { "attempts": attempts, "caught": caught };
+        }
+
+        ROUTINE fallback(request: JSON) : JSON {
+            var untouched INTEGER;
+            RETURN { "value": request.value };
+        }
+
+        ROUTINE spin(request: JSON) : JSON {
+            WHILE true {
+                request.value := 1;
+            }
+            RETURN request;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "bytecode.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    // Control flow, arithmetic and literals compile to dedicated instructions
+    const auto *crunch = findProcedure(driver.context().module(), "crunch");
+    const auto *fallback = findProcedure(driver.context().module(), "fallback");
+    if (!expect(crunch != nullptr && fallback != nullptr, "routines should be parsed")) {
+        return false;
+    }
+    const auto crunchListing = trx::runtime::disassemble(*trx::runtime::compileProcedure(*crunch));
+    const auto fallbackListing = trx::runtime::disassemble(*trx::runtime::compileProcedure(*fallback));
+    if (!expect(crunchListing.find("EXEC_STATEMENT") == std::string::npos, "crunch should not need the tree-walker") ||
+        !expect(crunchListing.find("JUMP_IF_EQUAL") != std::string::npos && crunchListing.find("FOR_NEXT") != std::string::npos &&
+                    crunchListing.find("LOOP_GUARD") != std::string::npos, "SWITCH, FOR and WHILE should lower to jumps") ||
+        !expect(crunchListing.find("LOAD_SLOT") != std::string::npos, "plain locals should load by slot") ||
+        !expect(fallbackListing.find("EXEC_STATEMENT") != std::string::npos, "declarations without an initializer go to the tree-walker")) {
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    trx::runtime::JsonValue::Array items;
+    for (double amount : {10.0, 20.0}) {
+        trx::runtime::JsonValue::Object item;
+        item["amount"] = trx::runtime::JsonValue(amount);
+        items.emplace_back(item);
+    }
+    trx::runtime::JsonValue::Object input;
+    input["limit"] = trx::runtime::JsonValue(10.0);
+    input["items"] = trx::runtime::JsonValue(items);
+    const auto result = interpreter.execute("crunch", trx::runtime::JsonValue(input));
+    // Phase 0 (i = 0, 3, 6, 9) adds 2*i for 36, the other six iterations subtract 1, the items add 30
+    if (!expect(result && result->asObject().at("total").asNumber() == 60.0, "crunch total should match the tree-walker's semantics") ||
+        !expect(result->asObject().at("negated").asNumber() == -60.0, "unary minus should apply") ||
+        !expect(result->asObject().at("done").asBool(), "NOT should apply to the loop condition") ||
+        !expect(result->asObject().at("kinds").asArray().size() == 7, "both SWITCH cases should append")) {
+        return false;
+    }
+
+    input["items"] = trx::runtime::JsonValue(trx::runtime::JsonValue::Array{
+        trx::runtime::JsonValue(1.0), trx::runtime::JsonValue(2.0), trx::runtime::JsonValue(3.0)});
+    const auto guarded = interpreter.execute("guarded", trx::runtime::JsonValue(input));
+    if (!expect(guarded && guarded->asObject().at("attempts").asNumber() == 3.0, "a caught THROW should not end the loop") ||
+        !expect(guarded->asObject().at("caught").asObject().at("item").asNumber() == 3.0, "the catch variable should hold the thrown value")) {
+        return false;
+    }
+
+    input["value"] = trx::runtime::JsonValue(7.0);
+    const auto passed = interpreter.execute("fallback", trx::runtime::JsonValue(input));
+    if (!expect(passed && passed->asObject().at("value").asNumber() == 7.0, "mixed bytecode and tree-walker statements should share the frame")) {
+        return false;
+    }
+
+    bool limited = false;
+    try {
+        interpreter.execute("spin", trx::runtime::JsonValue(input));
+    } catch (const std::runtime_error &e) {
+        limited = std::string(e.what()).find("maximum iterations") != std::string::npos;
+    }
+    if (!expect(limited, "WHILE should still stop at the iteration limit")) {
+        return false;
+    }
+
+    std::cout << "Bytecode test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runBytecodeTest()) {
+        std::cerr << "Bytecode tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+std::unique_ptr<trx::runtime::Interpreter> makeInterpreter(const trx::ast::Module &module) {
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    return std::make_unique<trx::runtime::Interpreter>(module, std::make_unique<trx::runtime::SQLiteDriver>(config));
+}
+
+const trx::ast::ExpressionPtr *returned(const trx::ast::ProcedureDecl *procedure, std::size_t index) {
+    const auto *returnStmt = procedure ? std::get_if<trx::ast::ReturnStatement>(&procedure->body[index].node) : nullptr;
+    return returnStmt ? &returnStmt->value : nullptr;
+}
+
+} // namespace
+
+bool runCallBindingTest() {
+    std::cout << "Running call binding test...\n";
+
+    constexpr const char *source = R"TRX(
+        CONSTANT LIMIT 10;
+        CONSTANT GREETING 'hi';
+        CONSTANT ENABLED TRUE;
+        CONSTANT SHADOWED 1;
+
+        ROUTINE helper(n: JSON) : JSON {
+            RETURN { "value": n.value + LIMIT };
+        }
+
+        ROUTINE folded(request: JSON) : JSON {
+            var size INTEGER := len(request.items);
+            var doubled JSON := helper({ "value": size });
+            RETURN { "size": size, "doubled": doubled.value, "limit": LIMIT * 2 + 1, "greeting": GREETING + '!', "enabled": ENABLED };
+        }
+
+        ROUTINE unfolded(request: JSON) : JSON {
+            var shadowed INTEGER := 5;
+            IF request.divide {
+                RETURN { "value": 1 / 0 };
+            }
+            RETURN { "shadowed": SHADOWED };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "call_binding.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    const auto interpreter = makeInterpreter(driver.context().module());
+    const auto &module = driver.context().module();
+
+    // Calls are bound to builtins and routines before the first request
+    const auto *folded = findProcedure(module, "folded");
+    const auto *size = folded ? std::get_if<trx::ast::VariableDeclarationStatement>(&folded->body[0].node) : nullptr;
+    const auto *lenCall = size && size->initializer ? std::get_if<trx::ast::FunctionCallExpression>(&(*size->initializer)->node) : nullptr;
+    const auto *doubled = folded ? std::get_if<trx::ast::VariableDeclarationStatement>(&folded->body[1].node) : nullptr;
+    const auto *helperCall = doubled && doubled->initializer ? std::get_if<trx::ast::FunctionCallExpression>(&(*doubled->initializer)->node) : nullptr;
+    if (!expect(lenCall && lenCall->builtin == trx::ast::BuiltinFunction::Length, "len() should be bound to the length builtin") ||
+        !expect(helperCall && helperCall->builtin == trx::ast::BuiltinFunction::None && helperCall->routine == findProcedure(module, "helper"),
+                "a routine call should be bound to its declaration")) {
+        return false;
+    }
+
+    // CONSTANTs and operators over literals become literals
+    const auto *result = returned(folded, 2);
+    const auto *object = result ? std::get_if<trx::ast::ObjectLiteralExpression>(&(*result)->node) : nullptr;
+    const auto literalAt = [&](const std::string &key) -> const trx::ast::LiteralExpression * {
+        const auto it = object->properties.find(key);
+        return it == object->properties.end() ? nullptr : std::get_if<trx::ast::LiteralExpression>(&it->second->node);
+    };
+    if (!expect(object != nullptr, "folded should return an object literal")) {
+        return false;
+    }
+    const auto *limit = literalAt("limit");
+    const auto *greeting = literalAt("greeting");
+    const auto *enabled = literalAt("enabled");
+    if (!expect(limit && std::get<double>(limit->value) == 21.0, "LIMIT * 2 + 1 should fold to 21") ||
+        !expect(greeting && std::get<std::string>(greeting->value) == "hi!", "string constants should fold through concatenation") ||
+        !expect(enabled && std::get<bool>(enabled->value), "a TRUE constant should fold to a boolean")) {
+        return false;
+    }
+
+    // Rebound constants and operators that fail are left for run time
+    const auto *unfolded = findProcedure(module, "unfolded");
+    const auto *divide = unfolded ? std::get_if<trx::ast::IfStatement>(&unfolded->body[1].node) : nullptr;
+    const auto *divideReturn = divide ? std::get_if<trx::ast::ReturnStatement>(&divide->thenBranch[0].node) : nullptr;
+    const auto *divideObject = divideReturn ? std::get_if<trx::ast::ObjectLiteralExpression>(&divideReturn->value->node) : nullptr;
+    const auto *shadowedObject = std::get_if<trx::ast::ObjectLiteralExpression>(&(*returned(unfolded, 2))->node);
+    if (!expect(divideObject && std::holds_alternative<trx::ast::BinaryExpression>(divideObject->properties.at("value")->node),
+                "division by zero should not be folded") ||
+        !expect(shadowedObject && std::holds_alternative<trx::ast::VariableExpression>(shadowedObject->properties.at("shadowed")->node),
+                "a CONSTANT whose name is bound elsewhere should not be inlined")) {
+        return false;
+    }
+
+    trx::runtime::JsonValue::Object request;
+    request["items"] = trx::runtime::JsonValue(trx::runtime::JsonValue::Array{trx::runtime::JsonValue(1.0), trx::runtime::JsonValue(2.0)});
+    const auto output = interpreter->execute("folded", trx::runtime::JsonValue(request));
+    if (!expect(output && output->isObject(), "folded should return an object")) {
+        return false;
+    }
+    const auto &fields = output->asObject();
+    if (!expect(fields.at("size").asNumber() == 2.0 && fields.at("doubled").asNumber() == 12.0, "bound calls should run") ||
+        !expect(fields.at("limit").asNumber() == 21.0 && fields.at("greeting").asString() == "hi!" && fields.at("enabled").asBool(),
+                "folded values should be returned")) {
+        return false;
+    }
+
+    trx::runtime::JsonValue::Object quiet;
+    quiet["divide"] = trx::runtime::JsonValue(false);
+    const auto shadowed = interpreter->execute("unfolded", trx::runtime::JsonValue(quiet));
+    if (!expect(shadowed && shadowed->asObject().at("shadowed").asNumber() == 5.0, "a local should shadow a CONSTANT of the same name")) {
+        return false;
+    }
+    quiet["divide"] = trx::runtime::JsonValue(true);
+    bool divided = false;
+    try {
+        interpreter->execute("unfolded", trx::runtime::JsonValue(quiet));
+    } catch (const std::exception &) {
+        divided = true;
+    }
+    if (!expect(divided, "an unfolded division by zero should still fail when it runs")) {
+        return false;
+    }
+
+    // A copy made with copyModule() is loaded without touching the module it was copied
+    // from, so the parsed sources can be loaded again on a reload
+    trx::parsing::ParserDriver pristineDriver;
+    if (!pristineDriver.parseString(source, "call_binding_copy.trx")) {
+        reportDiagnostics(pristineDriver);
+        return false;
+    }
+    const auto &pristine = pristineDriver.context().module();
+    const auto copy = trx::ast::copyModule(pristine);
+    const auto copyInterpreter = makeInterpreter(copy);
+    const auto *pristineDoubled = std::get_if<trx::ast::VariableDeclarationStatement>(&findProcedure(pristine, "folded")->body[1].node);
+    const auto *pristineCall = std::get_if<trx::ast::FunctionCallExpression>(&(*pristineDoubled->initializer)->node);
+    const auto *copyDoubled = std::get_if<trx::ast::VariableDeclarationStatement>(&findProcedure(copy, "folded")->body[1].node);
+    const auto *copyCall = std::get_if<trx::ast::FunctionCallExpression>(&(*copyDoubled->initializer)->node);
+    const auto *pristineResult = returned(findProcedure(pristine, "folded"), 2);
+    const auto *pristineObject = std::get_if<trx::ast::ObjectLiteralExpression>(&(*pristineResult)->node);
+    if (!expect(pristineCall != copyCall, "the copy should not share expression nodes with the parsed module") ||
+        !expect(copyCall->routine == findProcedure(copy, "helper"), "the copy's calls should be bound to the copy's routines") ||
+        !expect(pristineCall->routine == nullptr, "loading the copy should leave the parsed module's calls unbound") ||
+        !expect(std::holds_alternative<trx::ast::BinaryExpression>(pristineObject->properties.at("limit")->node),
+                "loading the copy should leave the parsed module unfolded")) {
+        return false;
+    }
+    const auto copyOutput = copyInterpreter->execute("folded", trx::runtime::JsonValue(request));
+    if (!expect(copyOutput && copyOutput->asObject().at("doubled").asNumber() == 12.0, "the loaded copy should run")) {
+        return false;
+    }
+
+    // Calls to functions that do not exist stop the module from loading
+    constexpr const char *broken = R"TRX(
+        ROUTINE caller(request: JSON) : JSON {
+            IF request.never {
+                RETURN missing(request);
+            }
+            RETURN request;
+        }
+    )TRX";
+    trx::parsing::ParserDriver brokenDriver;
+    if (!brokenDriver.parseString(broken, "broken_calls.trx")) {
+        reportDiagnostics(brokenDriver);
+        return false;
+    }
+    std::string error;
+    try {
+        makeInterpreter(brokenDriver.context().module());
+    } catch (const std::exception &e) {
+        error = e.what();
+    }
+    if (!expect(error.find("missing") != std::string::npos && error.find("caller") != std::string::npos,
+                "an unknown function should be reported with its caller at load time")) {
+        return false;
+    }
+
+    std::cout << "Call binding test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runCallBindingTest()) {
+        std::cerr << "Call binding tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
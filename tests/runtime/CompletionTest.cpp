@@ -0,0 +1,160 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/TrxException.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runCompletionTest() {
+    std::cout << "Running completion test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE square(n: JSON) : JSON {
+            IF n.value < 0 {
+                THROW { "negative": n.value };
+            }
+            RETURN { "value": n.value * n.value };
+        }
+
+        ROUTINE squares(request: JSON) : JSON {
+            var total INTEGER := 0;
+            var i INTEGER := 0;
+            WHILE i < request.count {
+                var sq JSON := square({ "value": i });
+                total := total + sq.value;
+                i := i + 1;
+            }
+            RETURN { "total": total };
+        }
+
+        ROUTINE search(request: JSON) : JSON {
+            var i INTEGER := 0;
+            WHILE i < 10 {
+                FOR item IN request.items {
+                    SWITCH item {
+                        CASE 7 {
+                            TRY {
+                                IF i = 2 {
+                                    RETURN { "found": item, "round": i };
+                                }
+                            } CATCH (failure) {
+                                RETURN { "found": -1, "round": i };
+                            }
+                        }
+                    }
+                }
+                i := i + 1;
+            }
+            RETURN { "found": 0, "round": i };
+        }
+
+        ROUTINE guarded(request: JSON) : JSON {
+            var caught JSON;
+            var after INTEGER := 0;
+            TRY {
+                THROW 'local';
+                after := 1;
+            } CATCH (failure) {
+                caught := failure.value;
+            }
+            var nested JSON;
+            TRY {
+                var sq JSON := square({ "value": -3 });
+                after := 2;
+            } CATCH (failure) {
+                nested := failure.value;
+            }
+            RETURN { "caught": caught, "nested": nested, "after": after };
+        }
+
+        ROUTINE doomed(request: JSON) : JSON {
+            EXEC SQL INSERT INTO completion_rows (id) VALUES (1);
+            IF request.fail {
+                THROW { "reason": 'asked to fail' };
+            }
+            RETURN { "inserted": 1 };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "completion.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+    interpreter.db().executeSql("CREATE TABLE completion_rows (id INTEGER)");
+
+    // A helper called in a loop hands each value back through RETURN
+    trx::runtime::JsonValue::Object request;
+    request["count"] = trx::runtime::JsonValue(5.0);
+    const auto squared = interpreter.execute("squares", trx::runtime::JsonValue(request));
+    if (!expect(squared && squared->asObject().at("total").asNumber() == 30.0, "each helper call should return its own square")) {
+        return false;
+    }
+
+    // RETURN deep inside WHILE, FOR, SWITCH, TRY and IF leaves the routine at once
+    trx::runtime::JsonValue::Object lookup;
+    lookup["items"] = trx::runtime::JsonValue(trx::runtime::JsonValue::Array{trx::runtime::JsonValue(3.0), trx::runtime::JsonValue(7.0)});
+    const auto searched = interpreter.execute("search", trx::runtime::JsonValue(lookup));
+    if (!expect(searched && searched->asObject().at("found").asNumber() == 7.0 && searched->asObject().at("round").asNumber() == 2.0,
+                "a nested RETURN should end every enclosing statement and skip the CATCH")) {
+        return false;
+    }
+
+    // THROW is caught in the same routine and from a routine it calls
+    const auto guarded = interpreter.execute("guarded", trx::runtime::JsonValue(trx::runtime::JsonValue::Object{}));
+    if (!expect(guarded && guarded->isObject(), "guarded should return an object")) {
+        return false;
+    }
+    const auto &caught = guarded->asObject();
+    if (!expect(caught.at("caught").asString() == "local", "a local THROW should bind its value in CATCH") ||
+        !expect(caught.at("nested").isObject() && caught.at("nested").asObject().at("negative").asNumber() == -3.0,
+                "a THROW escaping a called routine should reach the caller's CATCH") ||
+        !expect(caught.at("after").asNumber() == 0.0, "statements after a THROW should not run")) {
+        return false;
+    }
+
+    // An uncaught THROW leaves execute() as an exception and rolls the routine back
+    trx::runtime::JsonValue::Object failing;
+    failing["fail"] = trx::runtime::JsonValue(true);
+    bool threw = false;
+    try {
+        interpreter.execute("doomed", trx::runtime::JsonValue(failing));
+    } catch (const trx::runtime::TrxThrowException &e) {
+        threw = e.getThrownValue().isObject() && e.getThrownValue().asObject().at("reason").asString() == "asked to fail";
+    }
+    if (!expect(threw, "an uncaught THROW should surface as TrxThrowException with its value") ||
+        !expect(interpreter.db().querySql("SELECT COUNT(*) FROM completion_rows")[0][0].asNumber() == 0.0,
+                "an uncaught THROW should roll back the routine's writes")) {
+        return false;
+    }
+    failing["fail"] = trx::runtime::JsonValue(false);
+    const auto kept = interpreter.execute("doomed", trx::runtime::JsonValue(failing));
+    if (!expect(kept && kept->asObject().at("inserted").asNumber() == 1.0, "a RETURN should still commit") ||
+        !expect(interpreter.db().querySql("SELECT COUNT(*) FROM completion_rows")[0][0].asNumber() == 1.0,
+                "the committed insert should be visible")) {
+        return false;
+    }
+
+    std::cout << "Completion test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runCompletionTest()) {
+        std::cerr << "Completion tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ConnectionPool.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+// SQLite connection whose health check result can be controlled by the test
+class FlakySQLiteDriver : public trx::runtime::SQLiteDriver {
+public:
+    FlakySQLiteDriver(const trx::runtime::DatabaseConfig &config, std::shared_ptr<std::atomic<bool>> healthy)
+        : SQLiteDriver(config), healthy_(std::move(healthy)) {}
+
+    bool ping() override { return healthy_->load() && SQLiteDriver::ping(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> healthy_;
+};
+
+} // namespace
+
+bool runConnectionPoolTest() {
+    std::cout << "Running connection pool test...\n";
+
+    const auto dbPath = (std::filesystem::temp_directory_path() / "trx_connection_pool_test.db").string();
+    std::remove(dbPath.c_str());
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = dbPath;
+
+    auto healthy = std::make_shared<std::atomic<bool>>(true);
+    const auto factory = [config, healthy]() -> std::unique_ptr<trx::runtime::DatabaseDriver> {
+        return std::make_unique<FlakySQLiteDriver>(config, healthy);
+    };
+
+    // Sizing and checkout timeout
+    {
+        trx::runtime::ConnectionPoolConfig poolConfig;
+        poolConfig.minConnections = 1;
+        poolConfig.maxConnections = 2;
+        poolConfig.checkoutTimeout = std::chrono::milliseconds(50);
+        trx::runtime::ConnectionPool pool(factory, poolConfig);
+        pool.initialize();
+        pool.initialize();
+        if (!expect(pool.stats().open == 1 && pool.stats().idle == 1, "initialize should open the minimum number of connections once")) {
+            return false;
+        }
+
+        auto first = pool.checkout();
+        auto second = pool.checkout();
+        if (!expect(pool.stats().open == 2 && pool.stats().inUse == 2, "pool should grow up to its maximum")) {
+            return false;
+        }
+
+        bool timedOut = false;
+        try {
+            auto third = pool.checkout();
+        } catch (const std::runtime_error &) {
+            timedOut = true;
+        }
+        if (!expect(timedOut, "checkout should time out when the pool is exhausted") ||
+            !expect(pool.stats().waits > 0, "exhausted checkout should be counted as a wait")) {
+            return false;
+        }
+
+        pool.checkin(std::move(second));
+        auto reused = pool.checkout();
+        if (!expect(pool.stats().created == 2, "returned connections should be reused")) {
+            return false;
+        }
+        pool.checkin(std::move(reused));
+        pool.checkin(std::move(first), false);
+        if (!expect(pool.stats().open == 1 && pool.stats().discarded == 1, "non-reusable connections should be closed")) {
+            return false;
+        }
+    }
+
+    // Idle connections above the minimum are pruned
+    {
+        trx::runtime::ConnectionPoolConfig poolConfig;
+        poolConfig.minConnections = 1;
+        poolConfig.maxConnections = 3;
+        poolConfig.idleTimeout = std::chrono::milliseconds(0);
+        trx::runtime::ConnectionPool pool(factory, poolConfig);
+        auto a = pool.checkout();
+        auto b = pool.checkout();
+        auto c = pool.checkout();
+        pool.checkin(std::move(a));
+        pool.checkin(std::move(b));
+        pool.checkin(std::move(c));
+        if (!expect(pool.stats().open == 1, "idle connections above the minimum should be closed")) {
+            return false;
+        }
+    }
+
+    // Broken connections fail the health check and are replaced
+    {
+        trx::runtime::ConnectionPoolConfig poolConfig;
+        poolConfig.minConnections = 1;
+        poolConfig.maxConnections = 1;
+        poolConfig.healthCheckInterval = std::chrono::milliseconds(0);
+        trx::runtime::ConnectionPool pool(factory, poolConfig);
+        pool.initialize();
+        healthy->store(false);
+        auto connection = pool.checkout();
+        healthy->store(true);
+        const auto stats = pool.stats();
+        if (!expect(stats.discarded == 1 && stats.created == 2, "unhealthy connection should be replaced on checkout")) {
+            return false;
+        }
+        pool.checkin(std::move(connection));
+    }
+
+    // Statement cache counters are added up over the pool's connections
+    {
+        trx::runtime::ConnectionPoolConfig poolConfig;
+        poolConfig.minConnections = 2;
+        poolConfig.maxConnections = 2;
+        auto pool = std::make_shared<trx::runtime::ConnectionPool>(factory, poolConfig);
+        pool->initialize();
+        auto held = pool->checkout();
+        held->querySql("SELECT 1");
+        held->querySql("SELECT 1");
+
+        trx::runtime::PooledDatabaseDriver db(pool);
+        db.querySql("SELECT 2");
+        db.querySql("SELECT 2");
+        db.querySql("SELECT 2");
+        auto stats = pool->statementCacheStats();
+        if (!expect(stats.hits == 2 && stats.misses == 1, "returned connections should report their cache counters")) {
+            return false;
+        }
+
+        pool->checkin(std::move(held));
+        stats = db.statementCacheStats();
+        if (!expect(stats.hits == 3 && stats.misses == 2, "counters of every connection should be added up") ||
+            !expect(stats.size == 2, "cache sizes should be added up over the open connections")) {
+            return false;
+        }
+    }
+
+    // Interpreter transactions check a connection out and return it on commit
+    {
+        constexpr const char *source = R"TRX(
+            ROUTINE add_row(row: JSON) {
+                EXEC SQL INSERT INTO pool_rows (id) VALUES (:row.id);
+            }
+        )TRX";
+
+        trx::parsing::ParserDriver driver;
+        if (!driver.parseString(source, "connection_pool.trx")) {
+            reportDiagnostics(driver);
+            return false;
+        }
+
+        trx::runtime::ConnectionPoolConfig poolConfig;
+        poolConfig.minConnections = 1;
+        poolConfig.maxConnections = 2;
+        auto pool = std::make_shared<trx::runtime::ConnectionPool>(config, poolConfig);
+        trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::PooledDatabaseDriver>(pool));
+        interpreter.db().executeSql("CREATE TABLE pool_rows (id INTEGER PRIMARY KEY)");
+        if (!expect(pool->stats().inUse == 0, "autocommit statements should return their connection")) {
+            return false;
+        }
+
+        interpreter.db().beginTransaction();
+        if (!expect(pool->stats().inUse == 1 && interpreter.db().isInTransaction(), "transaction should pin a connection")) {
+            return false;
+        }
+        interpreter.db().commitTransaction();
+        if (!expect(pool->stats().inUse == 0 && !interpreter.db().isInTransaction(), "commit should return the connection")) {
+            return false;
+        }
+
+        trx::runtime::JsonValue::Object row;
+        row["id"] = trx::runtime::JsonValue(1.0);
+        interpreter.execute("add_row", trx::runtime::JsonValue(row));
+        const auto rows = interpreter.db().querySql("SELECT COUNT(*) FROM pool_rows");
+        if (!expect(rows.size() == 1 && rows[0][0].asNumber() == 1.0, "routine insert should be committed") ||
+            !expect(pool->stats().inUse == 0, "routine execution should return its connection")) {
+            return false;
+        }
+    }
+
+    std::remove(dbPath.c_str());
+
+    std::cout << "Connection pool test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runConnectionPoolTest()) {
+        std::cerr << "Connection pool tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
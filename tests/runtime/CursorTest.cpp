@@ -1,6 +1,7 @@
 #include "TestUtils.h"
 
 #include <iostream>
+#include <vector>
 
 namespace trx::test {
 
@@ -96,6 +97,48 @@ bool runCursorTest() {
             // No output assignment needed for procedure
         }
 
+        ROUTINE test_cursor_reopen_using() : JSON {
+            EXEC SQL DROP TABLE IF EXISTS cursor_using_table;
+            EXEC SQL CREATE TABLE cursor_using_table (
+                id INTEGER PRIMARY KEY,
+                age INTEGER
+            );
+
+            EXEC SQL INSERT INTO cursor_using_table (id, age) VALUES (1, 25);
+            EXEC SQL INSERT INTO cursor_using_table (id, age) VALUES (2, 30);
+            EXEC SQL INSERT INTO cursor_using_table (id, age) VALUES (3, 35);
+
+            var min_age INTEGER := 30;
+            var max_age INTEGER := 25;
+            var first JSON := [];
+            var second JSON := [];
+            var id INTEGER;
+
+            // One declaration, opened twice with different USING values
+            EXEC SQL DECLARE using_cursor CURSOR FOR
+                SELECT id FROM cursor_using_table WHERE age >= ? ORDER BY id;
+
+            EXEC SQL OPEN using_cursor USING :min_age;
+            WHILE sqlcode = 0 {
+                EXEC SQL FETCH using_cursor INTO :id;
+                if (sqlcode = 0) {
+                    append(first, id);
+                }
+            }
+            EXEC SQL CLOSE using_cursor;
+
+            EXEC SQL OPEN using_cursor USING :max_age;
+            WHILE sqlcode = 0 {
+                EXEC SQL FETCH using_cursor INTO :id;
+                if (sqlcode = 0) {
+                    append(second, id);
+                }
+            }
+            EXEC SQL CLOSE using_cursor;
+
+            RETURN {"first": first, "second": second};
+        }
+
         ROUTINE test_cursor_json() {
             var cursor_results JSON := test_json_list_from_cursor();
             trace('cursor results fetched successfully');
@@ -144,6 +187,27 @@ bool runCursorTest() {
             return false;
         }
 
+        // Reopening a declared cursor must bind the new USING values; on PostgreSQL
+        // this reuses the DECLARE statement prepared on the first OPEN
+        std::cout << "Executing test_cursor_reopen_using...\n";
+        const auto reopened = interpreter.execute("test_cursor_reopen_using", input);
+        if (!expect(reopened.has_value(), "test_cursor_reopen_using should return a value")) {
+            return false;
+        }
+        const auto ids = [](const trx::runtime::JsonValue &rows) {
+            std::vector<double> values;
+            for (const auto &row : rows.asArray()) {
+                values.push_back(row.asNumber());
+            }
+            return values;
+        };
+        const auto &opens = reopened->asObject();
+        if (!expect(ids(opens.at("first")) == std::vector<double>{2, 3}, "the first OPEN should bind its USING value") ||
+            !expect(ids(opens.at("second")) == std::vector<double>{1, 2, 3},
+                    "reopening the cursor should bind the new USING value, not the first one")) {
+            return false;
+        }
+
         std::cout << backend.name << " tests passed.\n";
     }
 
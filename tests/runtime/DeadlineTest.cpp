@@ -0,0 +1,133 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/Deadline.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+namespace trx::test {
+
+bool runDeadlineTest() {
+    std::cout << "Running deadline test...\n";
+
+    using trx::runtime::Deadline;
+    using trx::runtime::JsonValue;
+    using namespace std::chrono_literals;
+
+    const auto soon = Deadline::after(50ms);
+    const auto later = Deadline::after(10s);
+    if (!expect(!Deadline().isSet() && !Deadline().expired(), "a default deadline should be unset and never expire") ||
+        !expect(soon.earliest(later) == soon && later.earliest(soon) == soon, "earliest() should pick the sooner deadline") ||
+        !expect(later.earliest(Deadline()) == later && Deadline().earliest(later) == later, "an unset deadline should never be earlier") ||
+        !expect(Deadline::after(-1s).expired() && Deadline::after(-1s).remaining() == 0ms, "a past deadline should have nothing left")) {
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+
+    // A query that would never finish is interrupted once the deadline passes
+    {
+        trx::runtime::SQLiteDriver driver(config);
+        driver.initialize();
+        driver.setDeadline(Deadline::after(100ms));
+        const auto started = std::chrono::steady_clock::now();
+        bool interrupted = false;
+        try {
+            driver.querySql("WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n) SELECT max(x) FROM n", {});
+        } catch (const std::runtime_error &) {
+            interrupted = true;
+        }
+        if (!expect(interrupted && std::chrono::steady_clock::now() - started < 5s, "SQLite should interrupt a query past its deadline")) {
+            return false;
+        }
+        driver.setDeadline({});
+        if (!expect(driver.querySql("SELECT 1", {}).size() == 1, "statements should run again once the deadline is cleared")) {
+            return false;
+        }
+    }
+
+    constexpr const char *source = R"TRX(
+        EXPORT TIMEOUT 0.1 ROUTINE spin(request: JSON) : JSON {
+            var rounds INTEGER := 0;
+            TRY {
+                FOR outer IN request.items {
+                    FOR inner IN request.items {
+                        rounds := rounds + 1;
+                    }
+                }
+            } CATCH (failure) {
+                rounds := -1;
+            }
+            RETURN { "rounds": rounds };
+        }
+
+        EXPORT TIMEOUT 30 ROUTINE quick(request: JSON) : JSON {
+            RETURN { "value": request.value * 2 };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver parser;
+    if (!parser.parseString(source, "deadline.trx")) {
+        reportDiagnostics(parser);
+        return false;
+    }
+    trx::runtime::Interpreter interpreter(parser.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    JsonValue::Array items(20000, JsonValue(1.0));
+    JsonValue::Object spinRequest;
+    spinRequest["items"] = JsonValue(std::move(items));
+
+    // TIMEOUT stops the routine between statements, and TRY cannot catch that
+    const auto started = std::chrono::steady_clock::now();
+    bool exceeded = false;
+    try {
+        interpreter.execute("spin", JsonValue(spinRequest));
+    } catch (const trx::runtime::DeadlineExceeded &) {
+        exceeded = true;
+    }
+    if (!expect(exceeded, "a routine past its TIMEOUT should raise DeadlineExceeded") ||
+        !expect(std::chrono::steady_clock::now() - started < 5s, "the routine should stop soon after its TIMEOUT") ||
+        !expect(!interpreter.deadline().isSet(), "the routine's deadline should not outlive the call")) {
+        return false;
+    }
+
+    JsonValue::Object quickRequest;
+    quickRequest["value"] = JsonValue(21.0);
+    const auto answer = interpreter.execute("quick", JsonValue(quickRequest));
+    if (!expect(answer && answer->asObject().at("value").asNumber() == 42.0, "a routine within its TIMEOUT should finish")) {
+        return false;
+    }
+
+    // The request's deadline applies on top of TIMEOUT: one already past stops even the quick routine
+    interpreter.setDeadline(Deadline::after(-1ms));
+    exceeded = false;
+    try {
+        interpreter.execute("quick", JsonValue(quickRequest));
+    } catch (const trx::runtime::DeadlineExceeded &) {
+        exceeded = true;
+    }
+    interpreter.setDeadline({});
+    if (!expect(exceeded, "a request past its deadline should not run") ||
+        !expect(interpreter.execute("quick", JsonValue(quickRequest)).has_value(), "clearing the deadline should let routines run again")) {
+        return false;
+    }
+
+    std::cout << "Deadline test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runDeadlineTest()) {
+        std::cerr << "Deadline tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
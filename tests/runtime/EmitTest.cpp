@@ -0,0 +1,109 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+bool runEmitTest() {
+    std::cout << "Running EMIT test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE emit_rows(request: JSON) {
+            var i INTEGER := 0;
+            WHILE i < request.count {
+                EMIT { "n": i };
+                i := i + 1;
+            }
+        }
+
+        ROUTINE emit_through_call(request: JSON) {
+            EMIT 'first';
+            emit_rows(request);
+            EMIT 'last';
+        }
+
+        ROUTINE emit_then_fail(request: JSON) {
+            EMIT 1;
+            THROW 'stopped';
+        }
+
+        ROUTINE plain(request: JSON) : JSON {
+            RETURN { "ok": true };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "emit.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    // Routines that EMIT, directly or through a call, are marked when the module loads
+    const auto &module = driver.context().module();
+    if (!expect(findProcedure(module, "emit_rows")->emits && findProcedure(module, "emit_through_call")->emits,
+                "emitting routines and their callers should be marked") ||
+        !expect(!findProcedure(module, "plain")->emits, "a routine without EMIT should not be marked")) {
+        return false;
+    }
+
+    trx::runtime::JsonValue::Object request;
+    request["count"] = trx::runtime::JsonValue(3.0);
+
+    // Without a sink the emitted values come back as a list
+    const auto collected = interpreter.execute("emit_rows", trx::runtime::JsonValue(request));
+    if (!expect(collected && collected->isArray() && collected->asArray().size() == 3, "emitted values should be returned as a list") ||
+        !expect(collected->asArray()[2].asObject().at("n").asNumber() == 2.0, "emitted values should keep their order")) {
+        return false;
+    }
+
+    // A sink sees every value as it is emitted, including those of called routines
+    std::vector<std::string> seen;
+    interpreter.setEmitSink([&](const trx::runtime::JsonValue &value) {
+        seen.push_back(value.isString() ? value.asString() : std::to_string(static_cast<int>(value.asObject().at("n").asNumber())));
+    });
+    interpreter.execute("emit_through_call", trx::runtime::JsonValue(request));
+    interpreter.setEmitSink(nullptr);
+    if (!expect(seen == std::vector<std::string>{"first", "0", "1", "2", "last"}, "a sink should receive values in emit order")) {
+        return false;
+    }
+
+    // A failing routine still fails, and the collecting sink is removed again
+    bool failed = false;
+    try {
+        interpreter.execute("emit_then_fail", trx::runtime::JsonValue(request));
+    } catch (const std::exception &) {
+        failed = true;
+    }
+    if (!expect(failed, "a THROW after EMIT should still fail the routine") ||
+        !expect(!interpreter.emitSink(), "the collecting sink should not outlive the call")) {
+        return false;
+    }
+
+    const auto plain = interpreter.execute("plain", trx::runtime::JsonValue(request));
+    if (!expect(plain && plain->isObject() && plain->asObject().at("ok").asBool(), "routines without EMIT should return as before")) {
+        return false;
+    }
+
+    std::cout << "EMIT test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runEmitTest()) {
+        std::cerr << "EMIT tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
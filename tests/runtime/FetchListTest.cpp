@@ -0,0 +1,144 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runFetchListTest() {
+    std::cout << "Running fetch list test...\n";
+
+    constexpr const char *source = R"TRX(
+        TYPE EMPLOYEE {
+            ID INTEGER;
+            NAME CHAR(20);
+            SALARY INTEGER;
+        }
+
+        ROUTINE pages(request: JSON) : JSON {
+            var page_size INTEGER := request.page_size;
+            var page LIST(EMPLOYEE);
+            var sizes JSON := [];
+            var names JSON := [];
+            EXEC SQL DECLARE emp CURSOR FOR SELECT id, name, salary FROM employees ORDER BY id;
+            EXEC SQL OPEN emp;
+            EXEC SQL FETCH emp INTO LIST :page LIMIT :page_size;
+            WHILE SQLCODE = 0 {
+                append(sizes, length(page));
+                FOR employee IN page {
+                    append(names, employee.name);
+                }
+                EXEC SQL FETCH emp INTO LIST :page LIMIT :page_size;
+            }
+            var done INTEGER := SQLCODE;
+            EXEC SQL CLOSE emp;
+            RETURN { "sizes": sizes, "names": names, "done": done, "last": page };
+        }
+
+        ROUTINE rest() : JSON {
+            var first LIST(EMPLOYEE);
+            var others LIST(EMPLOYEE);
+            EXEC SQL DECLARE emp2 CURSOR FOR SELECT id, name, salary FROM employees ORDER BY id;
+            EXEC SQL OPEN emp2;
+            EXEC SQL FETCH emp2 INTO LIST :first LIMIT 2;
+            EXEC SQL FETCH emp2 INTO LIST :others;
+            EXEC SQL CLOSE emp2;
+            RETURN { "first": first, "others": others };
+        }
+
+        ROUTINE rich(request: JSON) : JSON {
+            var minimum INTEGER := request.minimum;
+            var found LIST(EMPLOYEE);
+            var ids JSON;
+            EXEC SQL SELECT id, name, salary INTO LIST :found FROM employees WHERE salary >= :minimum ORDER BY salary DESC;
+            var code INTEGER := SQLCODE;
+            EXEC SQL SELECT id INTO LIST :ids FROM employees WHERE salary >= :minimum ORDER BY id;
+            RETURN { "found": found, "ids": ids, "code": code };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "fetch_list.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+    interpreter.db().executeSql("CREATE TABLE employees (id INTEGER PRIMARY KEY, name VARCHAR(20), salary INTEGER)");
+    interpreter.db().executeSql("INSERT INTO employees VALUES (1, 'Ann', 300), (2, 'Bob', 100), (3, 'Cid', 500), (4, 'Dee', 200), (5, 'Eve', 400)");
+
+    // Pages of LIMIT rows until a fetch finds none
+    trx::runtime::JsonValue::Object request;
+    request["page_size"] = trx::runtime::JsonValue(2.0);
+    const auto pages = interpreter.execute("pages", trx::runtime::JsonValue(request));
+    if (!expect(pages.has_value(), "pages should return a value")) {
+        return false;
+    }
+    const auto &paged = pages->asObject();
+    const auto &sizes = paged.at("sizes").asArray();
+    const auto &names = paged.at("names").asArray();
+    if (!expect(sizes.size() == 3 && sizes[0].asNumber() == 2.0 && sizes[1].asNumber() == 2.0 && sizes[2].asNumber() == 1.0,
+                "pages should hold LIMIT rows and then the remainder") ||
+        !expect(names.size() == 5 && names[0].asString() == "Ann" && names[4].asString() == "Eve", "every row should be read in order") ||
+        !expect(paged.at("done").asNumber() == 100.0, "a fetch past the last row should set SQLCODE to 100") ||
+        !expect(paged.at("last").asArray().empty(), "a fetch past the last row should leave an empty list")) {
+        return false;
+    }
+
+    // A literal LIMIT, then the rest of the cursor; rows are records of the element TYPE
+    const auto rest = interpreter.execute("rest", trx::runtime::JsonValue(trx::runtime::JsonValue::Object{}));
+    if (!expect(rest.has_value(), "rest should return a value")) {
+        return false;
+    }
+    const auto &first = rest->asObject().at("first").asArray();
+    const auto &others = rest->asObject().at("others").asArray();
+    if (!expect(first.size() == 2 && others.size() == 3, "LIMIT 2 should leave three rows for the next fetch") ||
+        !expect(first[0].isRecord(), "rows should be records of the list's element type") ||
+        !expect(others[0].findField("name")->asString() == "Cid" && others[0].findField("salary")->asNumber() == 500.0,
+                "columns should fill the fields in declaration order")) {
+        return false;
+    }
+
+    // SELECT INTO LIST reads every matching row; without a TYPE a single column gives its values
+    request.clear();
+    request["minimum"] = trx::runtime::JsonValue(300.0);
+    const auto rich = interpreter.execute("rich", trx::runtime::JsonValue(request));
+    if (!expect(rich.has_value(), "rich should return a value")) {
+        return false;
+    }
+    const auto &found = rich->asObject().at("found").asArray();
+    const auto &ids = rich->asObject().at("ids").asArray();
+    if (!expect(found.size() == 3 && found[0].findField("id")->asNumber() == 3.0 && found[2].findField("name")->asString() == "Ann",
+                "SELECT INTO LIST should read every row in query order") ||
+        !expect(rich->asObject().at("code").asNumber() == 0.0, "SELECT INTO LIST with rows should set SQLCODE to 0") ||
+        !expect(ids.size() == 3 && ids[0].asNumber() == 1.0 && ids[2].asNumber() == 5.0, "a single column should give a list of its values")) {
+        return false;
+    }
+
+    request["minimum"] = trx::runtime::JsonValue(1000.0);
+    const auto none = interpreter.execute("rich", trx::runtime::JsonValue(request));
+    if (!expect(none && none->asObject().at("found").asArray().empty() && none->asObject().at("code").asNumber() == 100.0,
+                "SELECT INTO LIST without rows should leave an empty list and set SQLCODE to 100")) {
+        return false;
+    }
+
+    std::cout << "Fetch list test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runFetchListTest()) {
+        std::cerr << "Fetch list tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
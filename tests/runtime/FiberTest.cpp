@@ -0,0 +1,182 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/Fiber.h"
+#include "trx/runtime/RequestArena.h"
+#include "trx/runtime/ThreadPool.h"
+
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::FiberScheduler;
+using trx::runtime::RequestArena;
+
+struct Pipe {
+    int read{-1};
+    int write{-1};
+
+    Pipe() {
+        int fds[2];
+        if (::pipe(fds) == 0) {
+            read = fds[0];
+            write = fds[1];
+        }
+    }
+
+    ~Pipe() {
+        ::close(read);
+        ::close(write);
+    }
+
+    void signal() const {
+        const char byte = 'x';
+        [[maybe_unused]] const auto written = ::write(write, &byte, 1);
+    }
+};
+
+bool interleavesWaitingFibers() {
+    FiberScheduler scheduler;
+    Pipe first;
+    Pipe second;
+    std::vector<int> finished;
+    std::set<std::size_t> indices;
+
+    for (const auto *pipe : {&first, &second}) {
+        scheduler.spawn([pipe, &finished, &indices, &first] {
+            indices.insert(FiberScheduler::currentFiberIndex());
+            const short ready = trx::runtime::waitForIo(pipe->read, POLLIN);
+            finished.push_back(pipe == &first ? 1 : 2);
+            if (!(ready & POLLIN)) {
+                finished.push_back(-1);
+            }
+        });
+    }
+    if (!expect(scheduler.active() == 2 && finished.empty(), "spawned fibers should wait instead of blocking the thread") ||
+        !expect(indices == std::set<std::size_t>{0, 1}, "active fibers should have distinct indices") ||
+        !expect(FiberScheduler::currentFiberIndex() == FiberScheduler::npos, "the scheduling thread is not a fiber")) {
+        return false;
+    }
+
+    second.signal();
+    scheduler.poll(std::chrono::milliseconds(1000));
+    first.signal();
+    scheduler.poll(std::chrono::milliseconds(1000));
+    return expect(finished == std::vector<int>{2, 1}, "fibers should resume in the order their descriptors became ready") &&
+           expect(scheduler.active() == 0, "finished fibers should no longer count as active");
+}
+
+bool timesOut() {
+    FiberScheduler scheduler;
+    Pipe idle;
+    short ready = -1;
+    scheduler.spawn([&idle, &ready] { ready = trx::runtime::waitForIo(idle.read, POLLIN, std::chrono::milliseconds(20)); });
+
+    const auto start = std::chrono::steady_clock::now();
+    while (scheduler.active() > 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        scheduler.poll(std::chrono::milliseconds(-1));
+    }
+    return expect(ready == 0, "a wait should report no events once its timeout passes") &&
+           expect(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20), "a wait should not end before its timeout");
+}
+
+bool keepsArenaPerFiber() {
+    FiberScheduler scheduler;
+    Pipe pipe;
+    RequestArena arena;
+    RequestArena *seenAfterWait = nullptr;
+    scheduler.spawn([&] {
+        RequestArena::Scope scope(arena);
+        trx::runtime::waitForIo(pipe.read, POLLIN);
+        seenAfterWait = RequestArena::current();
+    });
+
+    const bool switchedOut = expect(RequestArena::current() == nullptr, "a waiting fiber's arena should not leak to the thread");
+    pipe.signal();
+    scheduler.poll(std::chrono::milliseconds(1000));
+    return switchedOut && expect(seenAfterWait == &arena, "a fiber should find its own arena current after a wait") &&
+           expect(RequestArena::current() == nullptr, "the thread's arena should be restored after the fiber ends");
+}
+
+bool blocksOutsideFibers() {
+    Pipe pipe;
+    pipe.signal();
+    return expect(trx::runtime::waitForIo(pipe.read, POLLIN) & POLLIN, "outside a fiber a wait should poll the descriptor") &&
+           expect(trx::runtime::waitForIo(pipe.write, POLLIN, std::chrono::milliseconds(0)) == 0,
+                  "a zero timeout should return at once when nothing is ready");
+}
+
+bool runsWaitingTasksOnOneWorker() {
+    constexpr std::size_t fibers = 4;
+    std::array<Pipe, fibers> pipes;
+    std::atomic<std::size_t> waiting{0};
+    std::atomic<std::size_t> done{0};
+    std::mutex slotsMutex;
+    std::set<std::size_t> slots;
+    {
+        ThreadPool pool(1, 0, fibers);
+        for (auto &pipe : pipes) {
+            pool.enqueueTask([&pipe, &waiting, &done, &slotsMutex, &slots] {
+                {
+                    std::lock_guard<std::mutex> lock(slotsMutex);
+                    slots.insert(ThreadPool::currentTaskSlot());
+                }
+                waiting.fetch_add(1);
+                trx::runtime::waitForIo(pipe.read, POLLIN);
+                done.fetch_add(1);
+            });
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (waiting.load() < fibers && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (!expect(waiting.load() == fibers && done.load() == 0, "one worker should have every task waiting at once")) {
+            for (auto &pipe : pipes) {
+                pipe.signal();
+            }
+            return false;
+        }
+        for (auto &pipe : pipes) {
+            pipe.signal();
+        }
+    }
+    return expect(done.load() == fibers, "every task should finish before the pool is destroyed") &&
+           expect(slots == std::set<std::size_t>{0, 1, 2, 3}, "tasks in flight together should have distinct slots");
+}
+
+} // namespace
+
+bool runFiberTest() {
+    std::cout << "Running fiber test...\n";
+
+    if (!interleavesWaitingFibers() || !timesOut() || !keepsArenaPerFiber() || !blocksOutsideFibers() ||
+        !runsWaitingTasksOnOneWorker()) {
+        return false;
+    }
+
+    std::cout << "Fiber test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runFiberTest()) {
+        std::cerr << "Fiber tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runFrameSlotTest() {
+    std::cout << "Running frame slot test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE bump(request: JSON) : JSON {
+            var Total INTEGER := request.Amount;
+            counter := counter + total;
+            FOR item IN request.items {
+                TOTAL := total + item;
+            }
+            TRY {
+                THROW 'boom';
+            } CATCH (Failure) {
+                fresh := failure.value;
+            }
+            RETURN { "total": total, "counter": counter, "fresh": fresh };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "frame_slots.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    // Arguments come first, then one slot per distinct lowercased name in the body
+    const auto *procedure = findProcedure(driver.context().module(), "bump");
+    if (!expect(procedure != nullptr, "bump routine should be parsed")) {
+        return false;
+    }
+    const auto &slots = procedure->frameSlots;
+    const auto slotOf = [&](const std::string &name) {
+        return static_cast<std::size_t>(std::find(slots.begin(), slots.end(), name) - slots.begin());
+    };
+    const auto *declaration = std::get_if<trx::ast::VariableDeclarationStatement>(&procedure->body[0].node);
+    const auto *assignment = std::get_if<trx::ast::AssignmentStatement>(&procedure->body[1].node);
+    if (!expect(procedure->input && procedure->input->slot == 0 && slots.front() == "request", "input should take the first slot") ||
+        !expect(slots.size() == 6, "request, total, counter, item, failure and fresh should each get one slot") ||
+        !expect(declaration && declaration->slot == slotOf("total"), "declaration should be placed under its lowercased name") ||
+        !expect(assignment && assignment->target.slot == slotOf("counter"), "assignment target should share the slot of its name") ||
+        !expect(assignment && assignment->target.path.front().key == "counter", "path keys should be precomputed")) {
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+    interpreter.globalVariables()["counter"] = trx::runtime::JsonValue(10.0);
+
+    trx::runtime::JsonValue::Object input;
+    input["amount"] = trx::runtime::JsonValue(5.0);
+    input["items"] = trx::runtime::JsonValue(trx::runtime::JsonValue::Array{trx::runtime::JsonValue(1.0), trx::runtime::JsonValue(2.0)});
+    const auto result = interpreter.execute("bump", trx::runtime::JsonValue(input));
+    if (!expect(result && result->isObject(), "bump should return an object")) {
+        return false;
+    }
+    const auto &output = result->asObject();
+    if (!expect(output.at("total").asNumber() == 8.0, "locals should resolve case-insensitively through their slot") ||
+        !expect(output.at("counter").asNumber() == 15.0, "an unbound slot should fall through to the global") ||
+        !expect(output.at("fresh").asString() == "boom", "catch variables and implicit locals should be bound to slots")) {
+        return false;
+    }
+    const auto counter = interpreter.globalVariables().find("counter");
+    if (!expect(counter != interpreter.globalVariables().end() && counter->second.asNumber() == 15.0,
+                "assigning a global from a routine should update the global, not shadow it")) {
+        return false;
+    }
+
+    // A second call starts from a fresh frame
+    const auto again = interpreter.execute("bump", trx::runtime::JsonValue(input));
+    if (!expect(again && again->asObject().at("total").asNumber() == 8.0 && again->asObject().at("counter").asNumber() == 20.0,
+                "frames should not leak between calls")) {
+        return false;
+    }
+
+    std::cout << "Frame slot test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runFrameSlotTest()) {
+        std::cerr << "Frame slot tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
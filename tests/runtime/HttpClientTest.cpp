@@ -0,0 +1,260 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+// Minimal keep-alive HTTP server on the loopback interface; replies with the method and
+// path it was asked for, after a delay for paths starting with /slow
+class LoopbackServer {
+public:
+    LoopbackServer() {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        ::bind(listenFd_, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        ::listen(listenFd_, 16);
+        socklen_t length = sizeof(address);
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr *>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        acceptor_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~LoopbackServer() {
+        stopping_ = true;
+        acceptor_.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int fd : connections_) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+        for (int fd : connections_) {
+            ::close(fd);
+        }
+        ::close(listenFd_);
+    }
+
+    std::string base() const { return "http://127.0.0.1:" + std::to_string(port_); }
+    int accepted() const { return accepted_.load(); }
+
+private:
+    void acceptLoop() {
+        while (!stopping_) {
+            pollfd ready{.fd = listenFd_, .events = POLLIN, .revents = 0};
+            if (::poll(&ready, 1, 50) <= 0) {
+                continue;
+            }
+            const int fd = ::accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            ++accepted_;
+            std::lock_guard<std::mutex> lock(mutex_);
+            connections_.push_back(fd);
+            workers_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        char chunk[4096];
+        while (true) {
+            const auto headerEnd = buffer.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) {
+                const auto received = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    return;
+                }
+                buffer.append(chunk, static_cast<std::size_t>(received));
+                continue;
+            }
+            std::size_t bodyLength = 0;
+            if (const auto header = buffer.find("Content-Length: "); header != std::string::npos && header < headerEnd) {
+                bodyLength = std::stoul(buffer.substr(header + 16));
+            }
+            while (buffer.size() < headerEnd + 4 + bodyLength) {
+                const auto received = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    return;
+                }
+                buffer.append(chunk, static_cast<std::size_t>(received));
+            }
+            const auto methodEnd = buffer.find(' ');
+            const auto pathEnd = buffer.find(' ', methodEnd + 1);
+            const std::string method = buffer.substr(0, methodEnd);
+            const std::string path = buffer.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+            buffer.erase(0, headerEnd + 4 + bodyLength);
+
+            if (path.rfind("/slow", 0) == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            }
+            const std::string body = "{\"method\":\"" + method + "\",\"path\":\"" + path + "\"}";
+            const std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                                         std::to_string(body.size()) + "\r\n\r\n" + body;
+            if (::send(fd, response.data(), response.size(), MSG_NOSIGNAL) < 0) {
+                return;
+            }
+        }
+    }
+
+    int listenFd_{-1};
+    int port_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> accepted_{0};
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> connections_;
+    std::vector<std::thread> workers_;
+};
+
+// A loopback port nothing listens on
+int closedPort() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    ::getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+    ::close(fd);
+    return ntohs(address.sin_port);
+}
+
+} // namespace
+
+bool runHttpClientTest() {
+    std::cout << "Running HTTP client test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE sequential(request: JSON) : JSON {
+            var first JSON := http({ "method": 'GET', "url": request.base + '/one' });
+            var second JSON := http({ "method": 'POST', "url": request.base + '/two', "body": { "n": 2 } });
+            var third JSON := http({ "method": 'DELETE', "url": request.base + '/three' });
+            RETURN { "statuses": [first.status, second.status, third.status], "bodies": [first.body, second.body, third.body] };
+        }
+
+        ROUTINE fanout(request: JSON) : JSON {
+            var responses JSON := http_all(request.calls);
+            RETURN { "responses": responses };
+        }
+
+        ROUTINE unreachable(request: JSON) : JSON {
+            var response JSON := http({ "method": 'GET', "url": request.url, "timeout": 5 });
+            RETURN response;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "http_client.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    using trx::runtime::JsonValue;
+    LoopbackServer server;
+
+    // Calls one after another share a single kept-alive connection
+    JsonValue::Object request;
+    request["base"] = JsonValue(server.base());
+    const auto sequential = interpreter.execute("sequential", JsonValue(request));
+    if (!expect(sequential && sequential->isObject(), "sequential should return an object")) {
+        return false;
+    }
+    const auto &statuses = sequential->asObject().at("statuses").asArray();
+    const auto &bodies = sequential->asObject().at("bodies").asArray();
+    if (!expect(statuses.size() == 3 && statuses[0].asNumber() == 200.0 && statuses[2].asNumber() == 200.0, "each call should get a 200") ||
+        !expect(bodies[1].asString() == "{\"method\":\"POST\",\"path\":\"/two\"}" && bodies[2].asString().find("DELETE") != std::string::npos,
+                "each call should send its own method and path") ||
+        !expect(server.accepted() == 1, "sequential calls on a thread should reuse one connection")) {
+        return false;
+    }
+
+    // http_all runs the requests at the same time and keeps their order
+    const auto call = [](const std::string &url) {
+        JsonValue::Object entry;
+        entry["method"] = JsonValue("GET");
+        entry["url"] = JsonValue(url);
+        entry["timeout"] = JsonValue(5.0);
+        return JsonValue(std::move(entry));
+    };
+    JsonValue::Array calls;
+    for (int i = 0; i < 4; ++i) {
+        calls.push_back(call(server.base() + "/slow/" + std::to_string(i)));
+    }
+    calls.push_back(call("http://127.0.0.1:" + std::to_string(closedPort()) + "/nobody"));
+    JsonValue::Object fanoutRequest;
+    fanoutRequest["calls"] = JsonValue(std::move(calls));
+    const auto started = std::chrono::steady_clock::now();
+    const auto fanout = interpreter.execute("fanout", JsonValue(fanoutRequest));
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    if (!expect(fanout && fanout->isObject(), "fanout should return an object")) {
+        return false;
+    }
+    const auto &responses = fanout->asObject().at("responses").asArray();
+    bool ordered = responses.size() == 5;
+    for (std::size_t i = 0; ordered && i < 4; ++i) {
+        ordered = responses[i].asObject().at("status").asNumber() == 200.0 &&
+                  responses[i].asObject().at("body").asString().find("/slow/" + std::to_string(i)) != std::string::npos;
+    }
+    if (!expect(ordered, "http_all should return one response per request, in request order") ||
+        !expect(elapsed < std::chrono::milliseconds(1000), "four 300ms requests should overlap") ||
+        !expect(responses[4].asObject().at("status").asNumber() == 0.0 && !responses[4].asObject().at("error").asString().empty(),
+                "a request that gets no response should come back with status 0 and an error") ||
+        !expect(responses[4].asObject().at("body").isNull(), "a request that gets no response should have a null body, not an empty one")) {
+        return false;
+    }
+
+    // A single call that gets no response fails the routine, once
+    JsonValue::Object unreachableRequest;
+    unreachableRequest["url"] = JsonValue("http://127.0.0.1:" + std::to_string(closedPort()) + "/nobody");
+    std::string error;
+    try {
+        interpreter.execute("unreachable", JsonValue(unreachableRequest));
+    } catch (const std::exception &e) {
+        error = e.what();
+    }
+    if (!expect(error.find("HTTP request failed") != std::string::npos, "an unreachable host should raise an HTTP error")) {
+        return false;
+    }
+
+    std::cout << "HTTP client test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runHttpClientTest()) {
+        std::cerr << "HTTP client tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runInPlaceReadTest() {
+    std::cout << "Running in-place read test...\n";
+
+    constexpr const char *source = R"TRX(
+        TYPE ITEM {
+            ID INTEGER;
+            QTY INTEGER;
+        }
+
+        ROUTINE walk(request: JSON) : JSON {
+            var items LIST(ITEM);
+            var item ITEM;
+            var i INTEGER := 0;
+            WHILE i < request.count {
+                item.id := i;
+                item.qty := 1;
+                append(items, item);
+                i := i + 1;
+            }
+            var seen INTEGER := 0;
+            var total INTEGER := 0;
+            FOR entry IN items {
+                seen := seen + 1;
+                total := total + entry.qty;
+                append(items, entry);
+                IF seen = 1 {
+                    item.qty := 10;
+                    items[1] := item;
+                }
+            }
+            RETURN { "seen": seen, "total": total, "size": len(items), "same": items[0] = items[3] };
+        }
+
+        ROUTINE handover(request: JSON) : JSON {
+            var result JSON := request;
+            result.extra := len(request.values);
+            RETURN result;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "in_place.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    // FOR reads the list where it is stored: writes to later items are seen, items
+    // appended by the body are not iterated
+    trx::runtime::JsonValue::Object request;
+    request["count"] = trx::runtime::JsonValue(3.0);
+    const auto walked = interpreter.execute("walk", trx::runtime::JsonValue(request));
+    if (!expect(walked && walked->isObject(), "walk should return an object")) {
+        return false;
+    }
+    const auto &walk = walked->asObject();
+    if (!expect(walk.at("seen").asNumber() == 3.0, "FOR should stop after the items the list started with") ||
+        !expect(walk.at("total").asNumber() == 12.0, "FOR should see updates to items it has not reached yet") ||
+        !expect(walk.at("size").asNumber() == 6.0, "appends from the body should land in the list") ||
+        !expect(walk.at("same").asBool(), "comparing two stored records should compare their fields")) {
+        return false;
+    }
+
+    // The input is handed to the routine and the returned local handed back
+    trx::runtime::JsonValue::Object payload;
+    payload["values"] = trx::runtime::JsonValue(trx::runtime::JsonValue::Array{trx::runtime::JsonValue(1.0), trx::runtime::JsonValue(2.0)});
+    const auto handed = interpreter.execute("handover", trx::runtime::JsonValue(std::move(payload)));
+    if (!expect(handed && handed->isObject(), "handover should return an object") ||
+        !expect(handed->asObject().at("extra").asNumber() == 2.0 && handed->asObject().at("values").asArray().size() == 2,
+                "the returned local should carry the input and the new field")) {
+        return false;
+    }
+
+    std::cout << "In-place read test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runInPlaceReadTest()) {
+        std::cerr << "In-place read tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ConnectionPool.h"
+#include "trx/runtime/JobQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JobQueue;
+using trx::runtime::JsonValue;
+
+constexpr const char *source = R"TRX(
+    ROUTINE queue_work(request: JSON) : JSON {
+        var job JSON;
+        job := BATCH record_work(request);
+        RETURN { "job": job };
+    }
+
+    ROUTINE queue_then_fail(request: JSON) : JSON {
+        BATCH record_work(request);
+        THROW 'changed my mind';
+    }
+
+    ROUTINE record_work(request: JSON) : JSON {
+        EXEC SQL INSERT INTO work_done (item) VALUES (:request.item);
+        IF request.item = 'bad' {
+            THROW 'bad item';
+        }
+        RETURN { "done": request.item };
+    }
+)TRX";
+
+JsonValue item(const std::string &name) {
+    JsonValue::Object object;
+    object["item"] = JsonValue(name);
+    return JsonValue(object);
+}
+
+double count(trx::runtime::DatabaseDriver &db, const std::string &sql) {
+    const auto row = db.queryFirstRow(sql);
+    return row && !row->empty() && row->front().isNumber() ? row->front().asNumber() : -1.0;
+}
+
+// Polls the job until it stops running, or gives up after a few seconds
+std::optional<trx::runtime::JobStatus> settled(JobQueue &queue, const std::string &id) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        auto status = queue.status(id);
+        if (status && (status->state == "succeeded" || status->state == "failed")) {
+            return status;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            return status;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+bool rejectsUnknownRoutines() {
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString("ROUTINE lost(request: JSON) : JSON { BATCH nowhere(request); RETURN request; }", "lost.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    bool rejected = false;
+    try {
+        trx::runtime::Interpreter interpreter(driver.context().module(), nullptr);
+    } catch (const std::runtime_error &) {
+        rejected = true;
+    }
+    trx::parsing::ParserDriver badDriver;
+    return expect(rejected, "a BATCH of an unknown routine should fail to load") &&
+           expect(!badDriver.parseString("ROUTINE bad(request: JSON) { BATCH record_work(request.item + 1); }", "bad.trx"),
+                  "BATCH should only take a variable as its argument");
+}
+
+} // namespace
+
+bool runJobQueueTest() {
+    std::cout << "Running job queue test...\n";
+
+    if (!rejectsUnknownRoutines()) {
+        return false;
+    }
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "jobs.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    const auto dbPath = (std::filesystem::temp_directory_path() / "trx_job_queue_test.db").string();
+    std::remove(dbPath.c_str());
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = dbPath;
+    auto pool = std::make_shared<trx::runtime::ConnectionPool>(config);
+    const auto makeDriver = [pool]() -> std::unique_ptr<trx::runtime::DatabaseDriver> {
+        return std::make_unique<trx::runtime::PooledDatabaseDriver>(pool);
+    };
+
+    trx::runtime::Interpreter interpreter(driver.context().module(), makeDriver());
+    interpreter.db().executeSql("CREATE TABLE work_done (item TEXT)");
+    JobQueue::createTable(interpreter.db());
+
+    bool refused = false;
+    try {
+        interpreter.execute("queue_work", item("a"));
+    } catch (const std::exception &) {
+        refused = true;
+    }
+    if (!expect(refused, "BATCH should fail while no job queue is running")) {
+        return false;
+    }
+
+    trx::runtime::JobQueueOptions options;
+    options.workers = 2;
+    options.maxAttempts = 3;
+    options.retryDelay = std::chrono::milliseconds(10);
+    options.pollInterval = std::chrono::milliseconds(20);
+    JobQueue queue(options, makeDriver);
+    interpreter.setJobQueue(&queue);
+
+    std::vector<std::unique_ptr<trx::runtime::Interpreter>> workers;
+    for (std::size_t i = 0; i < options.workers; ++i) {
+        workers.push_back(interpreter.fork(makeDriver()));
+    }
+    queue.start([&workers](std::size_t worker, const std::string &routine, const JsonValue &argument) {
+        auto result = workers[worker]->execute(routine, argument);
+        return result ? std::move(*result) : JsonValue();
+    });
+
+    const auto queued = interpreter.execute("queue_work", item("a"));
+    const auto *job = queued && queued->isObject() ? queued->findField("job") : nullptr;
+    if (!expect(job && job->isString(), "an assigned BATCH should hand back the job's id")) {
+        return false;
+    }
+    const auto done = settled(queue, job->asString());
+    if (!expect(done && done->state == "succeeded" && done->attempts == 1, "the job should run once and succeed") ||
+        !expect(done->routine == "record_work" && done->argument.findField("item")->asString() == "a",
+                "the job should keep its routine and argument") ||
+        !expect(done->result.findField("done") && done->result.findField("done")->asString() == "a",
+                "the routine's result should be recorded") ||
+        !expect(count(interpreter.db(), "SELECT COUNT(*) FROM work_done WHERE item = 'a'") == 1.0, "the job's routine should have run")) {
+        return false;
+    }
+
+    const auto failing = interpreter.execute("queue_work", item("bad"));
+    const auto failed = settled(queue, failing->findField("job")->asString());
+    if (!expect(failed && failed->state == "failed" && failed->attempts == 3, "a failing job should be retried until it runs out of attempts") ||
+        !expect(failed->lastError.find("bad item") != std::string::npos, "the thrown value should be kept as the job's error") ||
+        !expect(count(interpreter.db(), "SELECT COUNT(*) FROM work_done WHERE item = 'bad'") == 0.0,
+                "each failed attempt should roll back its own work")) {
+        return false;
+    }
+
+    const double jobsBefore = count(interpreter.db(), "SELECT COUNT(*) FROM trx_jobs");
+    bool thrown = false;
+    try {
+        interpreter.execute("queue_then_fail", item("c"));
+    } catch (const std::exception &) {
+        thrown = true;
+    }
+    if (!expect(thrown, "the routine should fail") ||
+        !expect(count(interpreter.db(), "SELECT COUNT(*) FROM trx_jobs") == jobsBefore,
+                "a job queued by a routine that rolled back should not exist")) {
+        return false;
+    }
+
+    queue.stop();
+    const auto stats = queue.stats();
+    if (!expect(stats.enqueued == 3 && stats.succeeded == 1 && stats.retried == 2 && stats.failed == 1 && stats.running == 0,
+                "the counters should follow every job") ||
+        !expect(queue.runTimes().snapshot(0).count == 4, "every attempt should be timed") ||
+        !expect(!queue.status("missing"), "an unknown id should have no status")) {
+        return false;
+    }
+
+    // Nothing runs the jobs now, so the second one finds the queue full
+    trx::runtime::JobQueueOptions bounded;
+    bounded.maxPending = 1;
+    JobQueue full(bounded, makeDriver);
+    interpreter.setJobQueue(&full);
+    interpreter.execute("queue_work", item("d"));
+    bool rejected = false;
+    try {
+        interpreter.execute("queue_work", item("e"));
+    } catch (const std::exception &) {
+        rejected = true;
+    }
+    if (!expect(rejected && full.stats().rejected == 1, "BATCH should fail once the queue holds its limit")) {
+        return false;
+    }
+
+    std::remove(dbPath.c_str());
+    std::cout << "Job queue test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runJobQueueTest()) {
+        std::cerr << "Job queue tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+std::string parseError(const std::string &text, const trx::runtime::RecordLayout *layout = nullptr) {
+    try {
+        trx::runtime::JsonParser parser(text);
+        layout ? parser.parse(*layout) : parser.parse();
+    } catch (const trx::runtime::JsonParseError &e) {
+        return e.what();
+    }
+    return {};
+}
+
+} // namespace
+
+bool runJsonParserTest() {
+    std::cout << "Running JSON parser test...\n";
+
+    using trx::runtime::JsonParser;
+    using trx::runtime::JsonValue;
+
+    // Plain JSON: nested containers, lowercased keys, escapes inside long strings
+    {
+        const std::string text = "{ \"Name\" : \"a fairly long string value with a \\\"quote\\\" past sixteen bytes\",\n"
+                                 "                \"list\": [1, -2.5e2, true, null, {\"Inner\": \"\\u00e9\\ud83d\\ude00\"}], \"empty\": {} }";
+        JsonParser parser(text);
+        const auto value = parser.parse();
+        const auto &object = value.asObject();
+        const auto &list = object.at("list").asArray();
+        if (!expect(object.at("name").asString() == "a fairly long string value with a \"quote\" past sixteen bytes",
+                    "escaped quotes should be decoded within a long string") ||
+            !expect(list.size() == 5 && list[1].asNumber() == -250.0 && list[2].asBool() && list[3].isNull(), "arrays should hold every kind of value") ||
+            !expect(list[4].asObject().at("inner").asString() == "\xC3\xA9\xF0\x9F\x98\x80", "unicode escapes and surrogate pairs should become UTF-8") ||
+            !expect(object.at("empty").isObject() && object.at("empty").asObject().empty(), "an empty object should parse")) {
+            return false;
+        }
+    }
+    if (!expect(parseError("{\"a\": 1} x") == "Unexpected trailing data in JSON payload", "trailing data should be rejected") ||
+        !expect(parseError("{\"a\": \"open") == "Unterminated string literal", "an open string should be rejected") ||
+        !expect(parseError("[1 2]") == "Expected comma in array literal", "array items need commas") ||
+        !expect(parseError(std::string(600, '[') + std::string(600, ']')) == "JSON payload is nested too deeply", "deep nesting should be refused")) {
+        return false;
+    }
+
+    // Bodies for a TYPE input are decoded into its record
+    constexpr const char *source = R"TRX(
+        TYPE LINE {
+            SKU CHAR(10);
+            QTY INTEGER;
+        }
+
+        TYPE ORDER {
+            ID INTEGER;
+            PAID BOOLEAN;
+            LINES LIST(LINE);
+            MAIN LINE;
+        }
+
+        ROUTINE total(order: ORDER) : JSON {
+            var sum INTEGER := 0;
+            FOR line IN order.lines {
+                sum := sum + line.qty;
+            }
+            RETURN { "id": order.id, "sum": sum, "main": order.main.sku };
+        }
+    )TRX";
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "json_parser.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+    const auto layout = interpreter.recordLayout("ORDER");
+    if (!expect(layout && layout->fields.size() == 4, "a TYPE should have a layout with one entry per field")) {
+        return false;
+    }
+
+    const std::string body = R"({"Id": 7, "extra": {"deep": [1, {"x": "\"}"}]}, "lines": [{"sku": "A", "qty": 2}, {"QTY": 3, "sku": "B", "junk": null}],
+                                 "main": {"sku": "M", "qty": 1}, "paid": false})";
+    JsonParser parser(body);
+    auto order = parser.parse(*layout);
+    const auto *record = std::get_if<JsonValue::Record>(&order.data);
+    if (!expect(record && record->shape == interpreter.recordShape("ORDER"), "the body should become a record of the declared TYPE") ||
+        !expect(record->fields[0].asNumber() == 7.0 && !record->fields[1].asBool(), "fields should be matched case-insensitively in any order") ||
+        !expect(std::holds_alternative<JsonValue::Record>(record->fields[2].asArray()[1].data), "list items of a TYPE should be records too") ||
+        !expect(order.findField("extra") == nullptr, "keys without a field should be skipped")) {
+        return false;
+    }
+    const auto totalled = interpreter.execute("total", std::move(order));
+    if (!expect(totalled && totalled->asObject().at("sum").asNumber() == 5.0 && totalled->asObject().at("main").asString() == "M",
+                "a routine should read the decoded record")) {
+        return false;
+    }
+
+    if (!expect(parseError(R"({"lines": [{"qty": 1}, {"qty": "two"}]})", layout.get()) == "Field 'lines[1].qty' must be a number",
+                "a wrong kind should be reported with its path") ||
+        !expect(parseError(R"({"main": [1]})", layout.get()) == "Field 'main' must be an object", "a nested TYPE should need an object") ||
+        !expect(parseError(R"({"lines": {}})", layout.get()) == "Field 'lines' must be a list", "a LIST field should need an array") ||
+        !expect(parseError("[1]", layout.get()) == "Request payload must be a JSON object", "a TYPE body should be an object")) {
+        return false;
+    }
+
+    std::cout << "JSON parser test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runJsonParserTest()) {
+        std::cerr << "JSON parser tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
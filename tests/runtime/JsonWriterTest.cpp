@@ -0,0 +1,101 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/JsonWriter.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace trx::test {
+
+bool runJsonWriterTest() {
+    std::cout << "Running JSON writer test...\n";
+    using trx::runtime::JsonValue;
+    using trx::runtime::JsonWriter;
+
+    // Numbers keep 15 significant digits and integers print without a fraction
+    const auto number = [](double value) { return JsonWriter::toString(JsonValue(value)); };
+    if (!expect(number(42.0) == "42", "an integral number should print without a fraction") ||
+        !expect(number(-0.5) == "-0.5", "a fraction should print as written") ||
+        !expect(number(1234567.0) == "1234567", "seven digit integers should not switch to exponent form") ||
+        !expect(number(0.1 + 0.2) == "0.3", "numbers should be rounded to 15 significant digits") ||
+        !expect(number(1e21) == "1e+21", "large numbers should use exponent form") ||
+        !expect(number(std::numeric_limits<double>::infinity()) == "null" && number(std::nan("")) == "null",
+                "non-finite numbers should be written as null")) {
+        return false;
+    }
+
+    // Quotes, backslashes and control characters are escaped; other bytes pass through
+    const std::string text = std::string("say \"hi\"\\\n\t") + '\x01' + "caf\xC3\xA9";
+    if (!expect(JsonWriter::toString(JsonValue(text)) == "\"say \\\"hi\\\"\\\\\\n\\t\\u0001caf\xC3\xA9\"",
+                "strings should be escaped")) {
+        return false;
+    }
+
+    // Containers and records
+    JsonValue::Array items{JsonValue(1.0), JsonValue(true), JsonValue(), JsonValue(std::string("x"))};
+    if (!expect(JsonWriter::toString(JsonValue(items)) == "[1,true,null,\"x\"]", "arrays should be written in order")) {
+        return false;
+    }
+    auto shape = std::make_shared<trx::runtime::RecordShape>();
+    shape->name = "POINT";
+    shape->keys = {"x", "label"};
+    auto point = JsonValue::record(shape);
+    point.asRecord().fields[0] = JsonValue(3.0);
+    point.asRecord().fields[1] = JsonValue(std::string("a\"b"));
+    if (!expect(JsonWriter::toString(point) == "{\"x\":3,\"label\":\"a\\\"b\"}", "records should be written in shape order")) {
+        return false;
+    }
+
+    // Writing appends to the caller's buffer
+    std::string out = "prefix:";
+    JsonWriter writer(out);
+    writer.write(JsonValue(JsonValue::Array{}));
+    writer.writeString("k");
+    if (!expect(out == "prefix:[]\"k\"", "the writer should append to its buffer")) {
+        return false;
+    }
+
+    // Output parses back to the same value
+    JsonValue::Object object;
+    object["name"] = JsonValue(std::string("line\nbreak \"quoted\""));
+    object["items"] = JsonValue(items);
+    object["nested"] = point;
+    object["ratio"] = JsonValue(2.0 / 3.0);
+    const JsonValue original(object);
+    const auto written = JsonWriter::toString(original);
+    const auto reparsed = trx::runtime::JsonParser(written).parse();
+    if (!expect(reparsed.asObject().at("name") == original.asObject().at("name") &&
+                    reparsed.asObject().at("items") == original.asObject().at("items") &&
+                    reparsed.asObject().at("nested") == original.asObject().at("nested"),
+                "written JSON should parse back to the same value") ||
+        !expect(std::abs(reparsed.asObject().at("ratio").asNumber() - 2.0 / 3.0) < 1e-14, "numbers should survive a round trip")) {
+        return false;
+    }
+
+    // Streaming a value uses the same format
+    std::ostringstream stream;
+    stream << original;
+    if (!expect(stream.str() == written, "operator<< should match the writer")) {
+        return false;
+    }
+
+    std::cout << "JSON writer test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runJsonWriterTest()) {
+        std::cerr << "JSON writer tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
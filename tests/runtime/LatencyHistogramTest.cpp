@@ -0,0 +1,99 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/LatencyHistogram.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+bool runLatencyHistogramTest() {
+    std::cout << "Running latency histogram test...\n";
+
+    using trx::runtime::LatencyHistogram;
+
+    // Bucket bounds are inclusive upper limits and counts come back cumulative
+    {
+        LatencyHistogram histogram(2, 1);
+        histogram.observe(0, 0, 0.0005);  // first bucket, on the boundary
+        histogram.observe(0, 0, 0.0006);  // second bucket
+        histogram.observe(0, 0, 0.3);     // le=0.5
+        histogram.observe(0, 0, 60.0);    // +Inf only
+        histogram.observe(0, 0, -1.0);    // clock skew counts as zero
+
+        const auto snapshot = histogram.snapshot(0);
+        if (!expect(snapshot.buckets[0] == 2, "boundary and negative values should land in the first bucket") ||
+            !expect(snapshot.buckets[1] == 3, "bucket counts should be cumulative") ||
+            !expect(snapshot.buckets[8] == 3 && snapshot.buckets[9] == 4, "0.3s should fall under le=0.5") ||
+            !expect(snapshot.buckets[13] == 4 && snapshot.buckets.back() == 5, "values past the last bound should only reach +Inf") ||
+            !expect(snapshot.count == 5, "count should equal the +Inf bucket") ||
+            !expect(std::fabs(snapshot.sum - 60.3011) < 1e-6, "sum should add up observed seconds")) {
+            return false;
+        }
+
+        const auto untouched = histogram.snapshot(1);
+        const auto outOfRange = histogram.snapshot(7);
+        if (!expect(untouched.count == 0 && untouched.sum == 0.0, "unobserved series should be empty") ||
+            !expect(outOfRange.count == 0, "out-of-range snapshot should be empty")) {
+            return false;
+        }
+
+        bool threw = false;
+        try {
+            histogram.observe(0, 2, 0.01);
+        } catch (const std::out_of_range &) {
+            threw = true;
+        }
+        if (!expect(threw, "observe should reject an out-of-range series")) {
+            return false;
+        }
+    }
+
+    // Concurrent writers, including threads sharing a shard, lose no observations
+    {
+        constexpr int threads = 8;
+        constexpr int perThread = 20000;
+        LatencyHistogram histogram(3, 4);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&histogram, t] {
+                for (int i = 0; i < perThread; ++i) {
+                    histogram.observe(static_cast<std::size_t>(t), static_cast<std::size_t>(i % 3), 0.002);
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+
+        std::uint64_t total = 0;
+        for (std::size_t series = 0; series < 3; ++series) {
+            const auto snapshot = histogram.snapshot(series);
+            if (!expect(snapshot.buckets[1] == 0 && snapshot.buckets[2] == snapshot.count, "2ms should land under le=0.0025")) {
+                return false;
+            }
+            total += snapshot.count;
+        }
+        if (!expect(total == static_cast<std::uint64_t>(threads) * perThread, "every concurrent observation should be counted")) {
+            return false;
+        }
+    }
+
+    std::cout << "Latency histogram test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runLatencyHistogramTest()) {
+        std::cerr << "Latency histogram tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
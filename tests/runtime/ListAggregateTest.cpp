@@ -0,0 +1,141 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ListAggregate.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace trx::test {
+
+bool runListAggregateTest() {
+    std::cout << "Running list aggregate test...\n";
+
+    using trx::runtime::JsonValue;
+
+    const auto item = [](double amount, const std::string &status) {
+        JsonValue::Object object;
+        object["amount"] = JsonValue(amount);
+        object["status"] = JsonValue(status);
+        return JsonValue(std::move(object));
+    };
+
+    // Enough items to fill whole lanes and a tail; items without the field are skipped
+    JsonValue::Array items;
+    double expected = 0.0;
+    for (int i = 1; i <= 1001; ++i) {
+        items.push_back(item(i, i % 3 == 0 ? "paid" : "open"));
+        expected += i;
+    }
+    items.push_back(JsonValue(JsonValue::Object{}));
+
+    const auto summary = trx::runtime::summarizeField(items, "AMOUNT");
+    if (!expect(summary.count == 1001 && summary.sum == expected, "sum should add every number in the field") ||
+        !expect(summary.min == 1.0 && summary.max == 1001.0, "min and max should span the field")) {
+        return false;
+    }
+
+    // Split across threads, the results stay the same
+    const auto parallel = trx::runtime::summarizeField(items, "amount", 16);
+    if (!expect(parallel.count == summary.count && parallel.sum == summary.sum && parallel.min == 1.0 && parallel.max == 1001.0,
+                "a parallel summary should match a serial one") ||
+        !expect(trx::runtime::countMatching(items, "status", JsonValue("paid"), 16) == 333, "count_if should compare strings") ||
+        !expect(trx::runtime::countMatching(items, "amount", JsonValue(7.0), 16) == 1, "count_if should compare numbers") ||
+        !expect(trx::runtime::countMatching(items, "status", JsonValue()) == 1, "a null value should count items without the field")) {
+        return false;
+    }
+
+    items.push_back(item(0, "open"));
+    items.back().asObject()["amount"] = JsonValue("many");
+    bool rejected = false;
+    try {
+        trx::runtime::summarizeField(items, "amount", 16);
+    } catch (const std::runtime_error &) {
+        rejected = true;
+    }
+    if (!expect(rejected, "a field that is not a number should be an error, also on another thread")) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        TYPE INVOICE {
+            ID INTEGER;
+            AMOUNT DECIMAL(10,2);
+            PAID INTEGER;
+        }
+
+        ROUTINE statement(request: JSON) : JSON {
+            var invoices LIST(INVOICE);
+            var invoice INVOICE;
+            FOR entry IN request.invoices {
+                invoice.id := entry.id;
+                invoice.amount := entry.amount;
+                invoice.paid := entry.paid;
+                append(invoices, invoice);
+            }
+            var none LIST(INVOICE);
+            RETURN {
+                "total": sum(invoices, "amount"),
+                "smallest": min(invoices, "amount"),
+                "largest": max(invoices, "amount"),
+                "average": avg(invoices, "amount"),
+                "paid": count_if(invoices, "paid", 1),
+                "values": sum(request.values),
+                "empty": sum(none, "amount"),
+                "nothing": avg(none, "amount")
+            };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "list_aggregate.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    const auto invoice = [](double id, double amount, double paid) {
+        JsonValue::Object object;
+        object["id"] = JsonValue(id);
+        object["amount"] = JsonValue(amount);
+        object["paid"] = JsonValue(paid);
+        return JsonValue(std::move(object));
+    };
+    JsonValue::Object request;
+    request["invoices"] = JsonValue(JsonValue::Array{invoice(1, 120, 1), invoice(2, 30, 0), invoice(3, 50, 1)});
+    request["values"] = JsonValue(JsonValue::Array{JsonValue(1.5), JsonValue(2.5)});
+
+    const auto result = interpreter.execute("statement", JsonValue(request));
+    if (!expect(result.has_value(), "statement should return a value")) {
+        return false;
+    }
+    const auto &totals = result->asObject();
+    if (!expect(totals.at("total").asNumber() == 200.0, "sum should total a record field") ||
+        !expect(totals.at("smallest").asNumber() == 30.0 && totals.at("largest").asNumber() == 120.0, "min and max should read a record field") ||
+        !expect(totals.at("average").asNumber() == 200.0 / 3.0, "avg should divide the sum by the count") ||
+        !expect(totals.at("paid").asNumber() == 2.0, "count_if should count matching records") ||
+        !expect(totals.at("values").asNumber() == 4.0, "without a field the items themselves should be summed") ||
+        !expect(totals.at("empty").asNumber() == 0.0 && totals.at("nothing").isNull(), "an empty list should sum to 0 and average to null")) {
+        return false;
+    }
+
+    std::cout << "List aggregate test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runListAggregateTest()) {
+        std::cerr << "List aggregate tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ListIndex.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runListIndexTest() {
+    std::cout << "Running list index test...\n";
+
+    using trx::runtime::JsonValue;
+
+    const auto item = [](double id, const std::string &region, double customer) {
+        JsonValue::Object owner;
+        owner["id"] = JsonValue(customer);
+        JsonValue::Object object;
+        object["id"] = JsonValue(id);
+        object["region"] = JsonValue(region);
+        object["owner"] = JsonValue(std::move(owner));
+        return JsonValue(std::move(object));
+    };
+    JsonValue::Array items;
+    items.push_back(item(1, "north", 10));
+    items.push_back(item(2, "south", 20));
+    items.push_back(item(3, "north", 10));
+    items.push_back(JsonValue(JsonValue::Object{}));
+
+    // Keys are the field's text; the first item with a key wins and items without one are left out
+    const auto byId = trx::runtime::indexBy(items, "ID");
+    const auto *second = trx::runtime::lookup(byId, JsonValue(2.0));
+    if (!expect(byId.asObject().size() == 3, "items without the field should be left out") ||
+        !expect(second && second->findField("region")->asString() == "south", "lookup should find an item by number") ||
+        !expect(trx::runtime::lookup(byId, JsonValue("3")) != nullptr, "a number and its text should share a key") ||
+        !expect(trx::runtime::lookup(byId, JsonValue(7.0)) == nullptr, "a missing key should find nothing")) {
+        return false;
+    }
+    const auto byOwner = trx::runtime::indexBy(items, "owner.id");
+    if (!expect(trx::runtime::lookup(byOwner, JsonValue(10.0))->findField("id")->asNumber() == 1.0, "the first item with a key should win")) {
+        return false;
+    }
+
+    // Groups keep every item with the key, in list order; a list given up is moved in
+    auto groups = trx::runtime::groupBy(std::move(items), "region");
+    const auto *north = trx::runtime::lookup(groups, JsonValue("north"));
+    if (!expect(north && north->asArray().size() == 2 && north->asArray()[1].findField("id")->asNumber() == 3.0,
+                "groups should hold every item with the key in order") ||
+        !expect(groups.asObject().size() == 2, "each distinct key should make one group")) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        TYPE LINE {
+            ID INTEGER;
+            CUSTOMER INTEGER;
+            TOTAL INTEGER;
+        }
+
+        ROUTINE reconcile(request: JSON) : JSON {
+            var lines LIST(LINE);
+            var line LINE;
+            FOR entry IN request.lines {
+                line.id := entry.id;
+                line.customer := entry.customer;
+                line.total := entry.total;
+                append(lines, line);
+            }
+            var customers JSON := index_by(request.customers, "id");
+            var byCustomer JSON := group_by(lines, "customer");
+            var matched JSON := [];
+            FOR current IN lines {
+                append(matched, lookup(customers, current.customer));
+            }
+            var orders JSON := lookup(byCustomer, 7);
+            RETURN { "matched": matched, "orders": length(orders) };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "list_index.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    const auto line = [](double id, double customer, double total) {
+        JsonValue::Object object;
+        object["id"] = JsonValue(id);
+        object["customer"] = JsonValue(customer);
+        object["total"] = JsonValue(total);
+        return JsonValue(std::move(object));
+    };
+    const auto customer = [](double id, const std::string &name) {
+        JsonValue::Object object;
+        object["id"] = JsonValue(id);
+        object["name"] = JsonValue(name);
+        return JsonValue(std::move(object));
+    };
+    JsonValue::Array lines{line(1, 7, 10), line(2, 8, 20), line(3, 7, 30), line(4, 9, 40)};
+    JsonValue::Array customers{customer(7, "Ada"), customer(8, "Ben")};
+    JsonValue::Object request;
+    request["lines"] = JsonValue(lines);
+    request["customers"] = JsonValue(customers);
+
+    const auto result = interpreter.execute("reconcile", JsonValue(request));
+    if (!expect(result.has_value(), "reconcile should return a value")) {
+        return false;
+    }
+    const auto &matched = result->asObject().at("matched").asArray();
+    const auto name = [&](std::size_t i) { return matched[i].findField("name")->asString(); };
+    if (!expect(matched.size() == 4 && name(0) == "Ada" && name(1) == "Ben" && name(2) == "Ada",
+                "lookup should find the customer of each line") ||
+        !expect(matched[3].isNull(), "a line without a customer should find null") ||
+        !expect(result->asObject().at("orders").asNumber() == 2.0, "group_by should collect records by a field")) {
+        return false;
+    }
+
+    std::cout << "List index test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runListIndexTest()) {
+        std::cerr << "List index tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
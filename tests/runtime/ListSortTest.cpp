@@ -0,0 +1,139 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ListSort.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runListSortTest() {
+    std::cout << "Running list sort test...\n";
+
+    using trx::runtime::JsonValue;
+
+    constexpr const char *source = R"TRX(
+        TYPE LINE {
+            ID INTEGER;
+            REGION CHAR(10);
+            TOTAL INTEGER;
+        }
+
+        ROUTINE ranked(request: JSON) : JSON {
+            var lines LIST(LINE);
+            var line LINE;
+            FOR entry IN request.lines {
+                line.id := entry.id;
+                line.region := entry.region;
+                line.total := entry.total;
+                append(lines, line);
+            }
+            SORT lines BY region, total DESC;
+            var ids JSON := request.empty;
+            FOR sorted IN lines {
+                append(ids, sorted.id);
+            }
+            RETURN { "ids": ids };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "list_sort.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    // Later keys order ties of earlier ones, and rows equal on every key keep their order
+    const auto line = [](double id, const std::string &region, double total) {
+        JsonValue::Object row;
+        row["id"] = JsonValue(id);
+        row["region"] = JsonValue(region);
+        row["total"] = JsonValue(total);
+        return JsonValue(std::move(row));
+    };
+    JsonValue::Object request;
+    request["lines"] = JsonValue(JsonValue::Array{line(1, "west", 10), line(2, "east", 5), line(3, "west", 30),
+                                                  line(4, "east", 5), line(5, "east", 20), line(6, "west", 10)});
+    request["empty"] = JsonValue(JsonValue::Array{});
+    const auto ranked = interpreter.execute("ranked", JsonValue(request));
+    if (!expect(ranked && ranked->isObject(), "ranked should return an object")) {
+        return false;
+    }
+    const auto &ids = ranked->asObject().at("ids").asArray();
+    const std::vector<double> expected{5, 2, 4, 3, 1, 6};
+    bool matches = ids.size() == expected.size();
+    for (std::size_t i = 0; matches && i < ids.size(); ++i) {
+        matches = ids[i].asNumber() == expected[i];
+    }
+    if (!expect(matches, "SORT should order by region, then by total descending, keeping ties stable")) {
+        return false;
+    }
+
+    // Numbers sort before strings, and items without the key go last either way
+    {
+        const auto keyed = [](const JsonValue &value, double id) {
+            JsonValue::Object row;
+            row["id"] = JsonValue(id);
+            if (!value.isNull()) {
+                row["k"] = value;
+            }
+            return JsonValue(std::move(row));
+        };
+        JsonValue::Array mixed{keyed(JsonValue(), 1), keyed(JsonValue(std::string("b")), 2), keyed(JsonValue(3.0), 3),
+                               keyed(JsonValue(std::string("a")), 4), keyed(JsonValue(true), 5), keyed(JsonValue(1.0), 6)};
+        JsonValue::Array descending = mixed;
+        trx::runtime::sortByKeys(mixed, {trx::ast::SortKey{.order = 1.0, .fieldName = "k"}});
+        trx::runtime::sortByKeys(descending, {trx::ast::SortKey{.order = -1.0, .fieldName = "k"}});
+        const auto order = [](const JsonValue::Array &items) {
+            std::vector<double> result;
+            for (const auto &item : items) {
+                result.push_back(item.asObject().at("id").asNumber());
+            }
+            return result;
+        };
+        if (!expect(order(mixed) == std::vector<double>{6, 3, 4, 2, 1, 5}, "ascending should rank numbers, strings, then the rest") ||
+            !expect(order(descending) == std::vector<double>{3, 6, 2, 4, 1, 5}, "descending should flip values but keep missing keys last")) {
+            return false;
+        }
+    }
+
+    // Large lists take the parallel path and still match a stable sort
+    {
+        JsonValue::Array items;
+        for (int i = 0; i < 50000; ++i) {
+            JsonValue::Object row;
+            row["id"] = JsonValue(static_cast<double>(i));
+            row["bucket"] = JsonValue(static_cast<double>((i * 7919) % 97));
+            items.push_back(JsonValue(std::move(row)));
+        }
+        JsonValue::Array reference = items;
+        std::stable_sort(reference.begin(), reference.end(), [](const JsonValue &a, const JsonValue &b) {
+            return a.asObject().at("bucket").asNumber() > b.asObject().at("bucket").asNumber();
+        });
+        trx::runtime::sortByKeys(items, {trx::ast::SortKey{.order = -1.0, .fieldName = "bucket"}}, 1000);
+        if (!expect(items == reference, "a parallel sort should give the same order as a stable sort")) {
+            return false;
+        }
+    }
+
+    std::cout << "List sort test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runListSortTest()) {
+        std::cerr << "List sort tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
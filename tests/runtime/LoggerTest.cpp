@@ -0,0 +1,180 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/Logger.h"
+
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JsonValue;
+using trx::runtime::LogLevel;
+using trx::runtime::Logger;
+
+// Every line the logger wrote, parsed; JsonParser lowercases object keys
+struct CapturedLines {
+    std::mutex mutex;
+    std::vector<JsonValue> lines;
+
+    CapturedLines() {
+        Logger::instance().setSink([this](std::string_view batch) {
+            std::istringstream stream{std::string(batch)};
+            std::lock_guard lock(mutex);
+            for (std::string line; std::getline(stream, line);) {
+                lines.push_back(trx::runtime::JsonParser(line).parse());
+            }
+        });
+    }
+
+    ~CapturedLines() {
+        Logger::instance().flush();
+        Logger::instance().setSink(nullptr);
+    }
+
+    std::vector<JsonValue> take() {
+        Logger::instance().flush();
+        std::lock_guard lock(mutex);
+        return std::exchange(lines, {});
+    }
+};
+
+bool parsesLevels() {
+    return expect(trx::runtime::parseLogLevel("warn") == LogLevel::Warn && trx::runtime::parseLogLevel("off") == LogLevel::Off,
+                  "level names should parse") &&
+           expect(!trx::runtime::parseLogLevel("verbose"), "unknown level names should not parse");
+}
+
+bool writesFields() {
+    CapturedLines captured;
+    Logger::setLevel(LogLevel::Debug);
+
+    JsonValue::Object object;
+    object["id"] = JsonValue(7.0);
+    const JsonValue value(object);
+    const std::string sql = "SELECT \"name\" FROM people";
+    trx::runtime::logDebug("SQL EXEC", {{"sql", sql}, {"rows", std::size_t{3}}, {"seconds", 0.5}, {"found", true}, {"value", value}});
+
+    Logger::setLevel(LogLevel::Warn);
+    trx::runtime::logInfo("filtered out");
+    trx::runtime::logError("kept");
+    trx::runtime::logError(std::string(2000, 'x'));
+
+    const auto lines = captured.take();
+    if (!expect(lines.size() == 3, "records below the level should not be written")) {
+        return false;
+    }
+    const auto &first = lines[0].asObject();
+    if (!expect(first.at("level").asString() == "debug" && first.at("msg").asString() == "SQL EXEC" && first.count("time") == 1,
+                "a record should carry its level, message and time") ||
+        !expect(first.at("sql").asString() == sql && first.at("rows").asNumber() == 3.0 && first.at("seconds").asNumber() == 0.5 &&
+                    first.at("found").asBool(),
+                "fields should keep their types") ||
+        !expect(first.at("value").asObject().at("id").asNumber() == 7.0, "JSON values should be written as JSON, not as strings") ||
+        !expect(lines[1].asObject().at("msg").asString() == "kept", "records at or above the level should be written") ||
+        !expect(lines[2].asObject().count("truncated") == 1 && lines[2].asObject().at("msg").asString().size() < 2000,
+                "text longer than a record holds should be cut short and marked")) {
+        return false;
+    }
+    return true;
+}
+
+bool writesFromManyThreads() {
+    CapturedLines captured;
+    Logger::setLevel(LogLevel::Info);
+    constexpr int threadCount = 4;
+    constexpr int perThread = 200; // fits a ring, so nothing is dropped however slow the writer is
+    const auto droppedBefore = Logger::instance().dropped();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i) {
+                trx::runtime::logInfo("tick", {{"worker", t}, {"i", i}});
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    const auto lines = captured.take();
+    std::set<double> rings;
+    std::vector<int> next(threadCount, 0);
+    bool ordered = true;
+    for (const auto &line : lines) {
+        const auto &record = line.asObject();
+        const auto worker = static_cast<int>(record.at("worker").asNumber());
+        ordered = ordered && static_cast<int>(record.at("i").asNumber()) == next[worker]++;
+        rings.insert(record.at("thread").asNumber());
+    }
+    return expect(lines.size() == threadCount * perThread && Logger::instance().dropped() == droppedBefore,
+                  "every record from every thread should be written once") &&
+           expect(ordered, "each thread's records should stay in order") &&
+           expect(rings.size() == threadCount, "each thread should log through a ring of its own");
+}
+
+} // namespace
+
+bool runLoggerTest() {
+    std::cout << "Running logger test...\n";
+
+    if (!parsesLevels() || !writesFields() || !writesFromManyThreads()) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        ROUTINE greet(request: JSON) : JSON {
+            debug('not written');
+            info('hello ' + request.name);
+            error(request);
+            RETURN request;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "logged.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::Interpreter interpreter(driver.context().module(), nullptr);
+    CapturedLines captured;
+    Logger::setLevel(LogLevel::Info);
+    JsonValue::Object request;
+    request["name"] = JsonValue("Ada");
+    const auto result = interpreter.execute("greet", JsonValue(request));
+    const auto lines = captured.take();
+    if (!expect(result.has_value(), "the routine should still run") ||
+        !expect(lines.size() == 2, "debug() should be filtered at the info level") ||
+        !expect(lines[0].asObject().at("level").asString() == "info" && lines[0].asObject().at("msg").asString() == "hello Ada",
+                "a string passed to info() should be the message") ||
+        !expect(lines[1].asObject().at("level").asString() == "error" &&
+                    lines[1].asObject().at("value").asObject().at("name").asString() == "Ada",
+                "other values should be logged as a JSON field")) {
+        return false;
+    }
+
+    std::cout << "Logger test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runLoggerTest()) {
+        std::cerr << "Logger tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/Bytecode.h"
+#include "trx/runtime/NativeLibrary.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JsonValue;
+namespace native = trx::runtime::native;
+
+constexpr const char *source = R"TRX(
+    ROUTINE answer(request: JSON) : JSON {
+        RETURN { "from": 'interpreter' };
+    }
+
+    ROUTINE total(request: JSON) : JSON {
+        var sum INTEGER := 0;
+        FOR item IN request.items {
+            sum := sum + item;
+        }
+        RETURN { "sum": sum };
+    }
+)TRX";
+
+// Stands in for the code trx compile would build, so the test can tell which one ran
+native::Result nativeAnswer(native::Frame &frame) {
+    JsonValue::Object result;
+    result["from"] = JsonValue("native");
+    frame.returnValue = JsonValue(result);
+    return native::Result::Returned;
+}
+
+std::string from(trx::runtime::Interpreter &interpreter) {
+    const auto result = interpreter.execute("answer", JsonValue::object());
+    const auto *field = result ? result->findField("from") : nullptr;
+    return field && field->isString() ? field->asString() : "";
+}
+
+} // namespace
+
+bool runNativeLibraryTest() {
+    std::cout << "Running native library test...\n";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "native.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = ":memory:";
+    trx::runtime::Interpreter interpreter(driver.context().module(), trx::runtime::createDatabaseDriver(config));
+
+    const auto *answer = interpreter.getRoutine("answer");
+    const auto *total = interpreter.getRoutine("total");
+    const auto *answerProgram = interpreter.programFor(answer);
+    const auto *totalProgram = interpreter.programFor(total);
+    const auto code = trx::runtime::translateRoutines({{"answer", answerProgram}, {"total", totalProgram}});
+    if (!expect(code.find("Result routine0(Frame &f)") != std::string::npos && code.find("Result routine1(Frame &f)") != std::string::npos,
+                "every routine should get a function") ||
+        !expect(code.find(trx::runtime::fingerprint(*totalProgram)) != std::string::npos, "the library should record what it was compiled from") ||
+        !expect(code.find("goto L") != std::string::npos, "the FOR loop should jump in place") ||
+        !expect(trx::runtime::fingerprint(*answerProgram) != trx::runtime::fingerprint(*totalProgram), "different programs should differ")) {
+        return false;
+    }
+
+    // The routine whose fingerprint matches runs natively; the stale one stays interpreted
+    const std::string current = trx::runtime::fingerprint(*answerProgram);
+    const std::vector<native::Routine> routines{{"answer", current.c_str(), nativeAnswer}, {"total", "stale", nativeAnswer}};
+    const native::Module module{native::abiVersion, sizeof(JsonValue), routines.size(), routines.data()};
+    const auto library = std::make_shared<trx::runtime::NativeLibrary>(module);
+    const auto interpreted = interpreter.setNativeLibrary(library);
+    if (!expect(interpreted == std::vector<std::string>{"total"}, "only the stale routine should fall back") ||
+        !expect(interpreter.nativeRoutine(answer) && !interpreter.nativeRoutine(total), "the routines should be told apart") ||
+        !expect(from(interpreter) == "native", "the compiled code should run")) {
+        return false;
+    }
+    JsonValue::Object request;
+    request["items"] = JsonValue(JsonValue::Array{JsonValue(1.0), JsonValue(2.0), JsonValue(3.0)});
+    const auto sum = interpreter.execute("total", JsonValue(request));
+    if (!expect(sum && sum->findField("sum")->asNumber() == 6.0, "the fallback should still run its bytecode")) {
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig forkConfig = config;
+    auto forked = interpreter.fork(trx::runtime::createDatabaseDriver(forkConfig));
+    if (!expect(from(*forked) == "native", "a fork should keep the library")) {
+        return false;
+    }
+    interpreter.setNativeLibrary(nullptr);
+    if (!expect(from(interpreter) == "interpreter", "without a library every routine should be interpreted")) {
+        return false;
+    }
+
+    const native::Module other{native::abiVersion + 1, sizeof(JsonValue), routines.size(), routines.data()};
+    bool refused = false;
+    try {
+        trx::runtime::NativeLibrary mismatched(other);
+    } catch (const std::runtime_error &) {
+        refused = true;
+    }
+    bool missing = false;
+    try {
+        trx::runtime::NativeLibrary::open("does_not_exist.so");
+    } catch (const std::runtime_error &) {
+        missing = true;
+    }
+    if (!expect(refused, "a library built for another runtime should be refused") ||
+        !expect(missing, "a missing library should fail to load")) {
+        return false;
+    }
+
+    std::cout << "Native library test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runNativeLibraryTest()) {
+        std::cerr << "Native library tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
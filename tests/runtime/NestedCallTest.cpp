@@ -0,0 +1,143 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/TrxException.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+// Counts the savepoints the interpreter opens
+class SavepointCountingDriver : public trx::runtime::SQLiteDriver {
+public:
+    SavepointCountingDriver(const trx::runtime::DatabaseConfig &config, int &savepoints)
+        : SQLiteDriver(config), savepoints_{savepoints} {}
+
+    void executeSql(const std::string &sql, const std::vector<trx::runtime::SqlParameter> &params = {}) override {
+        if (sql.rfind("SAVEPOINT ", 0) == 0) {
+            ++savepoints_;
+        }
+        SQLiteDriver::executeSql(sql, params);
+    }
+
+private:
+    int &savepoints_;
+};
+
+} // namespace
+
+bool runNestedCallTest() {
+    std::cout << "Running nested call test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE twice(n: JSON) : JSON {
+            RETURN { "value": n.value * 2 };
+        }
+
+        ROUTINE record(n: JSON) : JSON {
+            IF n.write {
+                EXEC SQL INSERT INTO nested_rows (id) VALUES (:n.id);
+            }
+            IF n.fail {
+                THROW 'record failed';
+            }
+            RETURN { "id": n.id };
+        }
+
+        ROUTINE relay(n: JSON) : JSON {
+            var inner JSON := record({ "id": n.id, "write": true, "fail": false });
+            IF n.fail {
+                THROW 'relay failed';
+            }
+            RETURN inner;
+        }
+
+        ROUTINE pure(request: JSON) : JSON {
+            var total INTEGER := 0;
+            var i INTEGER := 0;
+            WHILE i < 10 {
+                var doubled JSON := twice({ "value": i });
+                total := total + doubled.value;
+                i := i + 1;
+            }
+            var skipped JSON := record({ "id": 1, "write": false, "fail": false });
+            RETURN { "total": total, "skipped": skipped.id };
+        }
+
+        ROUTINE writes(request: JSON) : JSON {
+            var kept JSON := record({ "id": 1, "write": true, "fail": false });
+            TRY {
+                var lost JSON := record({ "id": 2, "write": true, "fail": true });
+            } CATCH (failure) {
+            }
+            TRY {
+                var relayed JSON := relay({ "id": 3, "fail": true });
+            } CATCH (failure) {
+            }
+            var relayed JSON := relay({ "id": 4, "fail": false });
+            RETURN { "kept": kept.id, "relayed": relayed.id };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "nested_calls.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    int savepoints = 0;
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<SavepointCountingDriver>(config, savepoints));
+    interpreter.db().executeSql("CREATE TABLE nested_rows (id INTEGER)");
+
+    // Calls point at their routine, and routines without SQL anywhere below them are marked
+    const auto *twice = findProcedure(driver.context().module(), "twice");
+    const auto *relay = findProcedure(driver.context().module(), "relay");
+    const auto *relayCall = relay ? std::get_if<trx::ast::VariableDeclarationStatement>(&relay->body[0].node) : nullptr;
+    const auto *callee = relayCall && relayCall->initializer ? std::get_if<trx::ast::FunctionCallExpression>(&(*relayCall->initializer)->node) : nullptr;
+    if (!expect(twice && !twice->runsSql, "a routine without SQL should be marked SQL-free") ||
+        !expect(relay && relay->runsSql, "a routine calling one that runs SQL should be marked as running SQL") ||
+        !expect(callee && callee->routine == findProcedure(driver.context().module(), "record"), "calls should point at the routine they name")) {
+        return false;
+    }
+
+    // Nested calls that never reach the database open no savepoint
+    const auto pure = interpreter.execute("pure", trx::runtime::JsonValue(trx::runtime::JsonValue::Object{}));
+    if (!expect(pure && pure->asObject().at("total").asNumber() == 90.0, "nested calls should return their values") ||
+        !expect(pure->asObject().at("skipped").asNumber() == 1.0, "a call skipping its SQL should still return") ||
+        !expect(savepoints == 0, "calls that run no SQL should not open savepoints")) {
+        return false;
+    }
+
+    // Calls that write get a savepoint opened before their first statement, outer calls first
+    const auto written = interpreter.execute("writes", trx::runtime::JsonValue(trx::runtime::JsonValue::Object{}));
+    if (!expect(written && written->asObject().at("relayed").asNumber() == 4.0, "writes should return the relayed id")) {
+        return false;
+    }
+    const auto rows = interpreter.db().querySql("SELECT id FROM nested_rows ORDER BY id");
+    if (!expect(rows.size() == 2 && rows[0][0].asNumber() == 1.0 && rows[1][0].asNumber() == 4.0,
+                "failed calls should roll back their writes, including those of routines they called") ||
+        !expect(savepoints == 6, "each writing call, and each caller of one, should open exactly one savepoint")) {
+        return false;
+    }
+
+    std::cout << "Nested call test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runNestedCallTest()) {
+        std::cerr << "Nested call tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+bool runNodeArenaTest() {
+    std::cout << "Running node arena test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE first(request: JSON) : JSON {
+            var Total INTEGER := request.Amount;
+            RETURN { "total": total + 1 };
+        }
+
+        ROUTINE second(request: JSON) : JSON {
+            var total INTEGER := request.amount;
+            RETURN { "total": TOTAL * 2 };
+        }
+    )TRX";
+
+    const auto initializerPath = [](const trx::ast::ProcedureDecl &procedure) {
+        const auto *declaration = std::get_if<trx::ast::VariableDeclarationStatement>(&procedure.body[0].node);
+        const auto *value = declaration && declaration->initializer ? std::get_if<trx::ast::VariableExpression>(&(*declaration->initializer)->node) : nullptr;
+        return value ? value->path : std::vector<trx::ast::VariableSegment>{};
+    };
+
+    std::shared_ptr<trx::ast::NodeArena> parsedArena;
+    trx::ast::Module copy;
+    {
+        trx::parsing::ParserDriver driver;
+        if (!driver.parseString(source, "node_arena.trx")) {
+            reportDiagnostics(driver);
+            return false;
+        }
+        const auto &module = driver.context().module();
+        parsedArena = module.arena;
+        if (!expect(parsedArena && parsedArena->bytesUsed() > 0, "parsed expressions should be allocated in the module's arena")) {
+            return false;
+        }
+
+        // Names are interned once, case-folded, whichever routine spells them
+        const auto *first = findProcedure(module, "first");
+        const auto *second = findProcedure(module, "second");
+        const auto firstPath = first ? initializerPath(*first) : std::vector<trx::ast::VariableSegment>{};
+        const auto secondPath = second ? initializerPath(*second) : std::vector<trx::ast::VariableSegment>{};
+        if (!expect(firstPath.size() == 2 && secondPath.size() == 2, "initializers should be field paths") ||
+            !expect(firstPath[1].key == "amount" && firstPath[1].key == secondPath[1].key, "keys should be lowercased") ||
+            !expect(&firstPath[1].key.str() == &secondPath[1].key.str(), "equal keys should share one interned string") ||
+            !expect(trx::ast::Symbol::of("REQUEST") == firstPath[0].key, "symbols should compare by identity")) {
+            return false;
+        }
+
+        copy = trx::ast::copyModule(module);
+        if (!expect(copy.arena != parsedArena && copy.arena->bytesUsed() > 0, "a copy should get an arena of its own")) {
+            return false;
+        }
+    }
+
+    // The parser is gone, but the copy's nodes keep their arena alive while it runs
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::ast::Module merged;
+    merged.declarations = std::move(copy.declarations);
+    copy = {};
+    trx::runtime::Interpreter interpreter(merged, std::make_unique<trx::runtime::SQLiteDriver>(config));
+    trx::runtime::JsonValue::Object input;
+    input["amount"] = trx::runtime::JsonValue(4.0);
+    const auto output = interpreter.execute("second", trx::runtime::JsonValue(input));
+    if (!expect(output && output->asObject().at("total").asNumber() == 8.0, "routines should run from arena nodes")) {
+        return false;
+    }
+
+    std::cout << "Node arena test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runNodeArenaTest()) {
+        std::cerr << "Node arena tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ConnectionPool.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JsonValue;
+
+constexpr const char *source = R"TRX(
+    ROUTINE enrich(request: JSON) : JSON {
+        var items JSON := request.items;
+        var seen INTEGER := 0;
+        var name JSON;
+        PARALLEL FOR item IN items MAX 3 {
+            EXEC SQL SELECT name INTO :name FROM parallel_people WHERE id = :item.id;
+            item.name := name;
+            item.twice := item.id * 2;
+            seen := seen + 1;
+        }
+        RETURN { "items": items, "seen": seen };
+    }
+
+    ROUTINE first_failure(request: JSON) : JSON {
+        var caught JSON;
+        TRY {
+            PARALLEL FOR item IN request.items {
+                IF item.id >= 3 {
+                    THROW item.id;
+                }
+            }
+        } CATCH (ex) {
+            caught := ex.value;
+        }
+        RETURN { "caught": caught };
+    }
+
+    ROUTINE read_after_write(request: JSON) : JSON {
+        var items JSON := request.items;
+        var name JSON;
+        EXEC SQL INSERT INTO parallel_people (id, name) VALUES (100, 'added');
+        PARALLEL FOR item IN items {
+            EXEC SQL SELECT name INTO :name FROM parallel_people WHERE id = 100;
+            item.name := name;
+        }
+        EXEC SQL DELETE FROM parallel_people WHERE id = 100;
+        RETURN { "items": items };
+    }
+
+    ROUTINE write_then_fail(request: JSON) {
+        PARALLEL FOR item IN request.items {
+            EXEC SQL INSERT INTO parallel_marks (id) VALUES (:item.id);
+        }
+        THROW "undo";
+    }
+)TRX";
+
+JsonValue request(int count) {
+    JsonValue::Array items;
+    for (int id = 1; id <= count; ++id) {
+        JsonValue::Object item;
+        item["id"] = JsonValue(static_cast<double>(id));
+        items.push_back(JsonValue(item));
+    }
+    JsonValue::Object object;
+    object["items"] = JsonValue(items);
+    return JsonValue(object);
+}
+
+bool enriches(trx::runtime::Interpreter &interpreter, const std::string &label) {
+    constexpr int count = 20;
+    const auto result = interpreter.execute("enrich", request(count));
+    if (!expect(result && result->isObject(), label + ": the routine should return an object")) {
+        return false;
+    }
+    const auto *items = result->findField("items");
+    if (!expect(items && items->isArray() && items->asArray().size() == count, label + ": every item should come back")) {
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        const auto &item = items->asArray()[i];
+        const auto *name = item.findField("name");
+        const auto *twice = item.findField("twice");
+        if (!expect(item.findField("id")->asNumber() == i + 1, label + ": items should keep their order") ||
+            !expect(name && name->isString() && name->asString() == "person " + std::to_string(i + 1),
+                    label + ": each iteration should run its own SELECT") ||
+            !expect(twice && twice->asNumber() == 2.0 * (i + 1), label + ": the loop variable's final value should be collected")) {
+            return false;
+        }
+    }
+    return expect(result->findField("seen")->asNumber() == 0.0, label + ": assignments to outer locals should stay in their iteration");
+}
+
+bool reportsFirstFailure(trx::runtime::Interpreter &interpreter, const std::string &label) {
+    const auto result = interpreter.execute("first_failure", request(8));
+    const auto *caught = result ? result->findField("caught") : nullptr;
+    return expect(caught && caught->isNumber() && caught->asNumber() == 3.0,
+                  label + ": the failure of the earliest failing item should reach the CATCH");
+}
+
+// Iterations on other connections would not see the routine's uncommitted rows, and theirs
+// would not be undone with it
+bool staysInTransaction(trx::runtime::Interpreter &interpreter, const std::string &label) {
+    const auto result = interpreter.execute("read_after_write", request(4));
+    const auto *items = result ? result->findField("items") : nullptr;
+    if (!expect(items && items->isArray() && items->asArray().size() == 4, label + ": every item should come back")) {
+        return false;
+    }
+    for (const auto &item : items->asArray()) {
+        const auto *name = item.findField("name");
+        if (!expect(name && name->isString() && name->asString() == "added",
+                    label + ": iterations should see what the routine wrote before the loop")) {
+            return false;
+        }
+    }
+
+    bool threw = false;
+    try {
+        interpreter.execute("write_then_fail", request(4));
+    } catch (const std::exception &) {
+        threw = true;
+    }
+    const auto rows = interpreter.db().querySql("SELECT COUNT(*) FROM parallel_marks");
+    return expect(threw, label + ": the routine should fail after the loop") &&
+           expect(rows.size() == 1 && rows[0][0].asNumber() == 0.0, label + ": rows the loop wrote should roll back with the routine");
+}
+
+} // namespace
+
+bool runParallelForTest() {
+    std::cout << "Running PARALLEL FOR test...\n";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "parallel_for.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::parsing::ParserDriver badDriver;
+    if (!expect(!badDriver.parseString("ROUTINE bad(items: JSON) { PARALLEL FOR item IN items LIMIT 2 { } }", "bad.trx"),
+                "only MAX should be accepted after the collection")) {
+        return false;
+    }
+
+    const auto dbPath = (std::filesystem::temp_directory_path() / "trx_parallel_for_test.db").string();
+    std::remove(dbPath.c_str());
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = dbPath;
+
+    // Through a pool every worker gets connections of its own
+    auto pool = std::make_shared<trx::runtime::ConnectionPool>(config);
+    trx::runtime::Interpreter pooled(driver.context().module(), std::make_unique<trx::runtime::PooledDatabaseDriver>(pool));
+    pooled.db().executeSql("CREATE TABLE parallel_people (id INTEGER PRIMARY KEY, name TEXT)");
+    for (int id = 1; id <= 20; ++id) {
+        pooled.db().executeSql("INSERT INTO parallel_people (id, name) VALUES (?, ?)",
+                               {{"id", JsonValue(static_cast<double>(id))}, {"name", JsonValue("person " + std::to_string(id))}});
+    }
+    pooled.db().executeSql("CREATE TABLE parallel_marks (id INTEGER PRIMARY KEY)");
+    if (!enriches(pooled, "pooled") || !reportsFirstFailure(pooled, "pooled") || !staysInTransaction(pooled, "pooled")) {
+        return false;
+    }
+
+    // A driver without siblings runs the iterations one after another, with the same results
+    trx::runtime::Interpreter single(driver.context().module(), trx::runtime::createDatabaseDriver(config));
+    if (!enriches(single, "single connection") || !reportsFirstFailure(single, "single connection") ||
+        !staysInTransaction(single, "single connection")) {
+        return false;
+    }
+
+    std::remove(dbPath.c_str());
+    std::cout << "PARALLEL FOR test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runParallelForTest()) {
+        std::cerr << "PARALLEL FOR tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/PostgreSQLValues.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+// Big-endian bytes of |value|, as the server sends them
+std::string bigEndian(std::int64_t value, int bytes) {
+    std::string data(bytes, '\0');
+    for (int i = bytes - 1; i >= 0; --i) {
+        data[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+    return data;
+}
+
+// Binary numeric: header, then base-10000 digits
+std::string numeric(int weight, std::uint16_t sign, int scale, const std::vector<int> &digits) {
+    std::string data = bigEndian(static_cast<std::int64_t>(digits.size()), 2) + bigEndian(weight, 2) + bigEndian(sign, 2) + bigEndian(scale, 2);
+    for (int digit : digits) {
+        data += bigEndian(digit, 2);
+    }
+    return data;
+}
+
+trx::runtime::SqlValue decodeNumeric(const std::string &data) {
+    return trx::runtime::postgres::numericValue(data.data(), static_cast<int>(data.size()));
+}
+
+std::string decodeDate(std::int64_t days) {
+    const auto data = bigEndian(days, 4);
+    return trx::runtime::postgres::dateValue(data.data(), 4).asString();
+}
+
+std::string decodeTimestamp(std::int64_t micros, bool withZone) {
+    const auto data = bigEndian(micros, 8);
+    return trx::runtime::postgres::timestampValue(data.data(), 8, withZone).asString();
+}
+
+} // namespace
+
+bool runPostgreSQLValuesTest() {
+    std::cout << "Running PostgreSQL values test...\n";
+
+    // numeric
+    const auto cents = decodeNumeric(numeric(0, 0x0000, 2, {12, 5000}));
+    const auto small = decodeNumeric(numeric(-1, 0x4000, 3, {10}));
+    const auto large = decodeNumeric(numeric(2, 0x0000, 0, {1234, 5678, 9012}));
+    const auto fraction = decodeNumeric(numeric(-1, 0x0000, 20, {1234, 5678, 9012, 3456, 7890}));
+    if (!expect(cents.isNumber() && cents.asNumber() == 12.5, "12.50 should decode to 12.5") ||
+        !expect(small.isNumber() && small.asNumber() == -0.001, "-0.001 should decode with its sign") ||
+        !expect(large.isNumber() && large.asNumber() == 123456789012.0, "digits above the point should be scaled") ||
+        !expect(fraction.isNumber() && fraction.asNumber() == 0.12345678901234567890, "digits beyond a double should round like strtod") ||
+        !expect(decodeNumeric(numeric(0, 0x0000, 0, {})).asNumber() == 0.0, "zero has no digits") ||
+        !expect(std::isnan(decodeNumeric(numeric(0, 0xC000, 0, {})).asNumber()), "NaN should decode to NaN") ||
+        !expect(decodeNumeric(numeric(0, 0xD000, 0, {})).asNumber() == std::numeric_limits<double>::infinity(), "Infinity should decode") ||
+        !expect(decodeNumeric(numeric(0, 0xF000, 0, {})).asNumber() == -std::numeric_limits<double>::infinity(), "-Infinity should decode") ||
+        !expect(!decodeNumeric(numeric(0, 0x0000, 0, {1, 2}).substr(0, 10)).isNumber(), "a cut-short numeric should not decode to a number")) {
+        return false;
+    }
+
+    // date, as printed with DateStyle ISO
+    if (!expect(decodeDate(0) == "2000-01-01", "day 0 should be 2000-01-01") ||
+        !expect(decodeDate(8780) == "2024-01-15", "a date after 2000 should decode") ||
+        !expect(decodeDate(-1) == "1999-12-31", "a date before 2000 should decode") ||
+        !expect(decodeDate(-746117) == "0044-03-15 BC", "a BC date should be written with a BC suffix") ||
+        !expect(decodeDate(std::numeric_limits<std::int32_t>::max()) == "infinity", "the largest date should be infinity") ||
+        !expect(decodeDate(std::numeric_limits<std::int32_t>::min()) == "-infinity", "the smallest date should be -infinity")) {
+        return false;
+    }
+
+    // timestamp and timestamptz, as printed with DateStyle ISO and TimeZone UTC
+    constexpr std::int64_t day = 86400000000LL;
+    constexpr std::int64_t morning = 8780 * day + (9 * 3600 + 30 * 60) * 1000000LL;
+    if (!expect(decodeTimestamp(morning, false) == "2024-01-15 09:30:00", "a timestamp should decode") ||
+        !expect(decodeTimestamp(morning + 250000, false) == "2024-01-15 09:30:00.25", "trailing zeros of a fraction should be dropped") ||
+        !expect(decodeTimestamp(morning + 1, false) == "2024-01-15 09:30:00.000001", "microseconds should be kept") ||
+        !expect(decodeTimestamp(morning, true) == "2024-01-15 09:30:00+00", "a timestamptz should be written in UTC") ||
+        !expect(decodeTimestamp(-500000, false) == "1999-12-31 23:59:59.5", "a timestamp before 2000 should decode") ||
+        !expect(decodeTimestamp(-746117 * day + 10 * 3600 * 1000000LL, true) == "0044-03-15 10:00:00+00 BC", "a BC timestamptz should end in BC") ||
+        !expect(decodeTimestamp(std::numeric_limits<std::int64_t>::max(), true) == "infinity", "the largest timestamp should be infinity")) {
+        return false;
+    }
+
+    std::cout << "PostgreSQL values test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runPostgreSQLValuesTest()) {
+        std::cerr << "PostgreSQL values tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/Profiler.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace trx::test {
+
+namespace {
+
+// Folded output as stack -> microseconds
+std::map<std::string, std::uint64_t> parseFolded(const std::string &folded) {
+    std::map<std::string, std::uint64_t> stacks;
+    std::istringstream lines(folded);
+    std::string line;
+    while (std::getline(lines, line)) {
+        const auto space = line.rfind(' ');
+        if (space != std::string::npos) {
+            stacks[line.substr(0, space)] = std::stoull(line.substr(space + 1));
+        }
+    }
+    return stacks;
+}
+
+bool countsSelfTime() {
+    trx::runtime::Profiler profiler;
+    {
+        trx::runtime::Profiler::Scope outer(&profiler, "outer");
+        {
+            trx::runtime::Profiler::Scope inner(&profiler, "in;ner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        trx::runtime::Profiler::Scope nothing(nullptr, "ignored");
+    }
+
+    const auto wall = parseFolded(profiler.folded());
+    const auto cpu = parseFolded(profiler.folded(trx::runtime::Profiler::Metric::Cpu));
+    return expect(wall.count("outer;in,ner") && wall.at("outer;in,ner") >= 20000, "the inner frame should own the sleep, with ';' escaped") &&
+           expect(!wall.count("outer") || wall.at("outer") < 10000, "a frame's own time should leave out its children") &&
+           expect(!cpu.count("outer;in,ner") || cpu.at("outer;in,ner") < 10000, "sleeping should cost no CPU time") &&
+           expect(profiler.totalMicros() >= 20000, "the total should cover the outermost frame");
+}
+
+} // namespace
+
+bool runProfilerTest() {
+    std::cout << "Running profiler test...\n";
+
+    if (!countsSelfTime()) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        ROUTINE store(request: JSON) : JSON {
+            EXEC SQL INSERT INTO profiled_rows (id) VALUES (:request.id);
+            RETURN request;
+        }
+
+        ROUTINE fill(request: JSON) : JSON {
+            var i INTEGER := 0;
+            WHILE i < request.count {
+                var stored JSON := store({ "id": i });
+                i := i + 1;
+            }
+            RETURN { "count": i };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "tests/profiled.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = ":memory:";
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+    interpreter.db().executeSql("CREATE TABLE profiled_rows (id INTEGER)");
+
+    trx::runtime::Profiler profiler;
+    interpreter.setProfiler(&profiler);
+    trx::runtime::JsonValue::Object request;
+    request["count"] = trx::runtime::JsonValue(500.0);
+    const auto result = interpreter.execute("fill", trx::runtime::JsonValue(request));
+    interpreter.setProfiler(nullptr);
+
+    // Statements are named by file:line, nested under their routine, with SQL split out
+    const auto stacks = parseFolded(profiler.folded());
+    const std::string loop = "fill;profiled.trx:9 WHILE";
+    const std::string call = loop + ";profiled.trx:10 var;store";
+    if (!expect(result && result->asObject().at("count").asNumber() == 500.0, "the profiled routine should still run") ||
+        !expect(stacks.count(call + ";profiled.trx:3 EXEC SQL;[sql]"), "SQL time should sit under the statement that ran it") ||
+        !expect(stacks.count(loop + ";profiled.trx:11 assignment"), "the loop body's statements should be frames of the loop")) {
+        std::cerr << profiler.folded();
+        return false;
+    }
+    for (const auto &[stack, micros] : stacks) {
+        if (!expect(stack.rfind("fill", 0) == 0, "every stack should start at the routine that was called")) {
+            return false;
+        }
+    }
+
+    // Without a profiler nothing more is recorded
+    const auto before = profiler.folded();
+    interpreter.execute("fill", trx::runtime::JsonValue(request));
+    if (!expect(profiler.folded() == before, "a detached profiler should record nothing")) {
+        return false;
+    }
+
+    std::cout << "Profiler test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runProfilerTest()) {
+        std::cerr << "Profiler tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+bool runQueryRowsTest() {
+    std::cout << "Running query rows test...\n";
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.statementCacheSize = 1;
+
+    // Streaming, early stop and re-entrant queries
+    {
+        trx::runtime::SQLiteDriver db(config);
+        db.initialize();
+        db.executeSql("CREATE TABLE stream_rows (id INTEGER PRIMARY KEY)");
+        db.executeSql("WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < 1000) INSERT INTO stream_rows SELECT x FROM n");
+
+        size_t seen = 0;
+        db.queryRows("SELECT id FROM stream_rows ORDER BY id", {}, [&](const std::vector<trx::runtime::SqlValue> &row) {
+            ++seen;
+            return row[0].asNumber() < 10.0;
+        });
+        if (!expect(seen == 10, "callback returning false should stop the query")) {
+            return false;
+        }
+
+        // The same SQL again from inside the callback, plus a different one that evicts the outer statement
+        size_t outer = 0;
+        size_t inner = 0;
+        const std::string sql = "SELECT id FROM stream_rows WHERE id <= ?";
+        db.queryRows(sql, {{"", trx::runtime::SqlValue(3.0)}}, [&](const std::vector<trx::runtime::SqlValue> &) {
+            ++outer;
+            inner += db.querySql(sql, {{"", trx::runtime::SqlValue(2.0)}}).size();
+            inner += db.querySql("SELECT COUNT(*) FROM stream_rows").size();
+            return true;
+        });
+        if (!expect(outer == 3 && inner == 9, "nested queries should not disturb the running statement")) {
+            return false;
+        }
+
+        const auto first = db.queryFirstRow("SELECT id FROM stream_rows WHERE id > ? ORDER BY id", {{"", trx::runtime::SqlValue(500.0)}});
+        const auto none = db.queryFirstRow("SELECT id FROM stream_rows WHERE id > 5000");
+        if (!expect(first && (*first)[0].asNumber() == 501.0, "queryFirstRow should return the first match") ||
+            !expect(!none, "queryFirstRow should report no match")) {
+            return false;
+        }
+
+        // An early stop must not leave the table locked
+        db.executeSql("DELETE FROM stream_rows WHERE id > 100");
+        if (!expect(db.querySql("SELECT COUNT(*) FROM stream_rows")[0][0].asNumber() == 100.0, "writes should succeed after an early stop")) {
+            return false;
+        }
+    }
+
+    // SELECT INTO reads a single row even when many match
+    {
+        constexpr const char *source = R"TRX(
+            ROUTINE first_id(request: JSON) : JSON {
+                var min INTEGER := request.min;
+                var first INTEGER;
+                EXEC SQL SELECT id INTO :first FROM stream_rows WHERE id > :min ORDER BY id;
+                RETURN { "id": first };
+            }
+        )TRX";
+
+        trx::parsing::ParserDriver driver;
+        if (!driver.parseString(source, "query_rows.trx")) {
+            reportDiagnostics(driver);
+            return false;
+        }
+        trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+        interpreter.db().executeSql("CREATE TABLE stream_rows (id INTEGER PRIMARY KEY)");
+        interpreter.db().executeSql("WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < 1000) INSERT INTO stream_rows SELECT x FROM n");
+
+        trx::runtime::JsonValue::Object input;
+        input["min"] = trx::runtime::JsonValue(10.0);
+        const auto result = interpreter.execute("first_id", trx::runtime::JsonValue(input));
+        if (!expect(result && result->isObject() && result->asObject().at("id").asNumber() == 11.0, "SELECT INTO should bind the first row")) {
+            return false;
+        }
+    }
+
+    std::cout << "Query rows test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runQueryRowsTest()) {
+        std::cerr << "Query rows tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
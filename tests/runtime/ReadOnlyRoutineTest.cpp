@@ -0,0 +1,204 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+// Counts the transactions and savepoints the interpreter opens
+struct TransactionCounts {
+    int begins{0};
+    int readOnlyBegins{0};
+    int savepoints{0};
+};
+
+class TransactionCountingDriver : public trx::runtime::SQLiteDriver {
+public:
+    TransactionCountingDriver(const trx::runtime::DatabaseConfig &config, TransactionCounts &counts)
+        : SQLiteDriver(config), counts_{counts} {}
+
+    void executeSql(const std::string &sql, const std::vector<trx::runtime::SqlParameter> &params = {}) override {
+        if (sql.rfind("SAVEPOINT ", 0) == 0) {
+            ++counts_.savepoints;
+        }
+        SQLiteDriver::executeSql(sql, params);
+    }
+
+    void beginTransaction() override {
+        ++counts_.begins;
+        SQLiteDriver::beginTransaction();
+    }
+
+    void beginReadOnlyTransaction() override {
+        ++counts_.readOnlyBegins;
+        SQLiteDriver::beginTransaction();
+    }
+
+private:
+    TransactionCounts &counts_;
+};
+
+bool classifiesStatements() {
+    const auto readOnly = [](trx::ast::SqlStatementKind kind, const std::string &sql) {
+        trx::ast::SqlStatement statement;
+        statement.kind = kind;
+        statement.sql = sql;
+        trx::ast::compileSqlStatement(statement);
+        return statement.compiled.readOnly;
+    };
+    using Kind = trx::ast::SqlStatementKind;
+    return expect(readOnly(Kind::SelectInto, "SELECT name INTO :name FROM people WHERE id = :id"), "SELECT INTO host variables only reads") &&
+           expect(readOnly(Kind::ExecImmediate, "WITH recent AS (SELECT id FROM people) SELECT count(*) FROM recent"), "a WITH query only reads") &&
+           expect(readOnly(Kind::DeclareCursor, "DECLARE c CURSOR FOR SELECT id FROM people"), "a cursor over a query only reads") &&
+           expect(readOnly(Kind::FetchCursor, "") && readOnly(Kind::CloseCursor, ""), "cursor steps only read") &&
+           expect(!readOnly(Kind::ExecImmediate, "INSERT INTO people (id) VALUES (1)"), "an INSERT writes") &&
+           expect(!readOnly(Kind::ExecImmediate, "WITH gone AS (DELETE FROM people RETURNING id) SELECT count(*) FROM gone"),
+                  "a WITH that deletes writes") &&
+           expect(!readOnly(Kind::ExecImmediate, "SELECT * INTO people_copy FROM people"), "SELECT INTO a table writes") &&
+           expect(!readOnly(Kind::DeclareCursor, "DECLARE c CURSOR FOR SELECT id FROM people FOR UPDATE"), "FOR UPDATE locks rows") &&
+           expect(!readOnly(Kind::ExecImmediate, "SELECT id FROM people FOR SHARE"), "FOR SHARE locks rows") &&
+           expect(!readOnly(Kind::ExecImmediate, "CREATE INDEX people_name ON people (name)"), "DDL is not read-only");
+}
+
+} // namespace
+
+bool runReadOnlyRoutineTest() {
+    std::cout << "Running read-only routine test...\n";
+
+    if (!classifiesStatements()) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        ROUTINE lookup(request: JSON) : JSON {
+            var name CHAR(20);
+            EXEC SQL SELECT name INTO :name FROM readonly_people WHERE id = :request.id;
+            RETURN { "name": name };
+        }
+
+        ROUTINE listing(request: JSON) : JSON {
+            var names JSON := [];
+            var name CHAR(20);
+            EXEC SQL DECLARE people_cursor CURSOR FOR SELECT name FROM readonly_people ORDER BY id;
+            EXEC SQL OPEN people_cursor;
+            EXEC SQL FETCH people_cursor INTO :name;
+            WHILE sqlcode = 0 {
+                append(names, name);
+                EXEC SQL FETCH people_cursor INTO :name;
+            }
+            EXEC SQL CLOSE people_cursor;
+            RETURN names;
+        }
+
+        ROUTINE add(request: JSON) : JSON {
+            EXEC SQL INSERT INTO readonly_people (id, name) VALUES (:request.id, :request.name);
+            var found JSON := lookup(request);
+            RETURN found;
+        }
+
+        ROUTINE relay(request: JSON) : JSON {
+            var added JSON := add(request);
+            RETURN added;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "read_only.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = ":memory:";
+    TransactionCounts primary;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<TransactionCountingDriver>(config, primary));
+    interpreter.db().executeSql("CREATE TABLE readonly_people (id INTEGER, name TEXT)");
+
+    // Routines that only read, and call only routines that only read, are marked read-only
+    const auto *lookup = interpreter.getRoutine("lookup");
+    const auto *listing = interpreter.getRoutine("listing");
+    const auto *add = interpreter.getRoutine("add");
+    const auto *relay = interpreter.getRoutine("relay");
+    if (!expect(lookup && listing && add && relay, "every routine should be registered") ||
+        !expect(lookup->readOnly && !lookup->usesCursors, "a routine with only SELECT INTO should be read-only") ||
+        !expect(listing->readOnly && listing->usesCursors, "a routine reading through a cursor should be read-only and use cursors") ||
+        !expect(!add->readOnly && !relay->readOnly, "a routine that writes, or calls one that does, should not be read-only")) {
+        return false;
+    }
+
+    trx::runtime::JsonValue::Object person;
+    person["id"] = trx::runtime::JsonValue(1.0);
+    person["name"] = trx::runtime::JsonValue("Ada");
+    primary = {};
+    const auto added = interpreter.execute("add", trx::runtime::JsonValue(person));
+    if (!expect(added && added->asObject().at("name").asString() == "Ada", "a writing routine should see its own write through a read-only call") ||
+        !expect(primary.begins == 1 && primary.savepoints == 0, "a writing routine should get a transaction, and its read-only call no savepoint")) {
+        return false;
+    }
+
+    primary = {};
+    const auto found = interpreter.execute("lookup", trx::runtime::JsonValue(person));
+    if (!expect(found && found->asObject().at("name").asString() == "Ada", "a read-only routine should read committed rows") ||
+        !expect(primary.begins == 0 && primary.readOnlyBegins == 0 && primary.savepoints == 0, "a read-only routine should run in autocommit")) {
+        return false;
+    }
+
+    primary = {};
+    const auto listed = interpreter.execute("listing", trx::runtime::JsonValue::object());
+    if (!expect(listed && listed->isArray() && listed->asArray().size() == 1, "a cursor routine should read every row") ||
+        !expect(primary.begins == 0 && primary.readOnlyBegins == 1, "a routine with cursors should get a read-only transaction")) {
+        return false;
+    }
+
+    // With a replica driver, read-only routines read from it and writes stay on the primary
+    const auto replicaPath = (std::filesystem::temp_directory_path() / "trx_read_only_replica.db").string();
+    std::remove(replicaPath.c_str());
+    trx::runtime::DatabaseConfig replicaConfig;
+    replicaConfig.type = trx::runtime::DatabaseType::SQLITE;
+    replicaConfig.databasePath = replicaPath;
+    {
+        trx::runtime::SQLiteDriver seed(replicaConfig);
+        seed.initialize();
+        seed.executeSql("CREATE TABLE readonly_people (id INTEGER, name TEXT)");
+        seed.executeSql("INSERT INTO readonly_people (id, name) VALUES (1, 'Replica')");
+    }
+    TransactionCounts replica;
+    interpreter.setReplicaDriver(std::make_unique<TransactionCountingDriver>(replicaConfig, replica));
+
+    const auto fromReplica = interpreter.execute("lookup", trx::runtime::JsonValue(person));
+    const auto listedReplica = interpreter.execute("listing", trx::runtime::JsonValue::object());
+    person["id"] = trx::runtime::JsonValue(2.0);
+    person["name"] = trx::runtime::JsonValue("Grace");
+    primary = {};
+    const auto relayed = interpreter.execute("relay", trx::runtime::JsonValue(person));
+    std::remove(replicaPath.c_str());
+    if (!expect(fromReplica && fromReplica->asObject().at("name").asString() == "Replica", "a read-only routine should read from the replica") ||
+        !expect(listedReplica && listedReplica->asArray().size() == 1 && replica.readOnlyBegins == 1, "cursor routines should run on the replica too") ||
+        !expect(relayed && relayed->asObject().at("name").asString() == "Grace", "reads inside a write transaction should stay on the primary") ||
+        !expect(primary.begins == 1 && replica.begins == 0, "writes should go to the primary only")) {
+        return false;
+    }
+
+    std::cout << "Read-only routine test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runReadOnlyRoutineTest()) {
+        std::cerr << "Read-only routine tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
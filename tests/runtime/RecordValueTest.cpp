@@ -0,0 +1,123 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace trx::test {
+
+bool runRecordValueTest() {
+    std::cout << "Running record value test...\n";
+
+    constexpr const char *source = R"TRX(
+        TYPE PERSON {
+            NAME CHAR(32);
+            AGE INTEGER;
+        }
+
+        ROUTINE roster(request: JSON) : JSON {
+            var people LIST(PERSON);
+            var p PERSON;
+            var i INTEGER := 0;
+            WHILE i < request.count {
+                p.name := 'n';
+                p.AGE := i;
+                append(people, p);
+                i := i + 1;
+            }
+            var total INTEGER := 0;
+            FOR person IN people {
+                total := total + person.age;
+            }
+            var expected JSON := { "name": "n", "age": 2 };
+            RETURN { "people": people, "total": total, "same": p = expected };
+        }
+
+        ROUTINE widen(request: JSON) : JSON {
+            var p PERSON;
+            p.name := 'x';
+            p.nickname := 'y';
+            RETURN p;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "record_values.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    // Field accesses through declared records carry their offset in the TYPE
+    const auto *procedure = findProcedure(driver.context().module(), "roster");
+    const auto *loop = procedure ? std::get_if<trx::ast::WhileStatement>(&procedure->body[3].node) : nullptr;
+    const auto *assignAge = loop ? std::get_if<trx::ast::AssignmentStatement>(&loop->body[1].node) : nullptr;
+    const auto *forStmt = procedure ? std::get_if<trx::ast::ForStatement>(&procedure->body[5].node) : nullptr;
+    const auto *sum = forStmt ? std::get_if<trx::ast::AssignmentStatement>(&forStmt->body[0].node) : nullptr;
+    const auto *readAge = sum ? std::get_if<trx::ast::BinaryExpression>(&sum->value->node) : nullptr;
+    const auto *ageOperand = readAge ? std::get_if<trx::ast::VariableExpression>(&readAge->rhs->node) : nullptr;
+    if (!expect(assignAge && assignAge->target.path[1].field == 1, "p.AGE should resolve to the second field of PERSON") ||
+        !expect(ageOperand && ageOperand->path[1].field == 1, "a loop variable over LIST(PERSON) should be typed as PERSON")) {
+        return false;
+    }
+
+    trx::runtime::JsonValue::Object request;
+    request["count"] = trx::runtime::JsonValue(3.0);
+    const auto result = interpreter.execute("roster", trx::runtime::JsonValue(request));
+    if (!expect(result && result->isObject(), "roster should return an object")) {
+        return false;
+    }
+    const auto &output = result->asObject();
+    const auto &people = output.at("people").asArray();
+    if (!expect(people.size() == 3, "roster should collect three people") ||
+        !expect(output.at("total").asNumber() == 3.0, "loop should read ages through the records") ||
+        !expect(output.at("same").asBool(), "a record should equal an object with the same fields")) {
+        return false;
+    }
+    for (std::size_t i = 0; i < people.size(); ++i) {
+        if (!expect(people[i].isRecord() && people[i].isObject(), "list elements should stay records") ||
+            !expect(people[i].asRecord().shape == people[0].asRecord().shape, "records of one TYPE should share a shape") ||
+            !expect(people[i].findField("age") && people[i].findField("age")->asNumber() == static_cast<double>(i),
+                    "each appended record should keep its own field values")) {
+            return false;
+        }
+    }
+    std::ostringstream printed;
+    printed << people[1];
+    if (!expect(printed.str() == "{\"name\":\"n\",\"age\":1}", "records should print their fields in declaration order")) {
+        return false;
+    }
+
+    // Adding a field outside the TYPE turns the record into a plain object
+    const auto widened = interpreter.execute("widen", trx::runtime::JsonValue(trx::runtime::JsonValue::Object{}));
+    if (!expect(widened && widened->isObject() && !widened->isRecord(), "widen should return a plain object")) {
+        return false;
+    }
+    const auto &fields = widened->asObject();
+    if (!expect(fields.size() == 3, "the object should keep the declared fields and the new one") ||
+        !expect(fields.at("name").asString() == "x" && fields.at("nickname").asString() == "y" && fields.at("age").isNull(),
+                "field values should survive the conversion")) {
+        return false;
+    }
+
+    std::cout << "Record value test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runRecordValueTest()) {
+        std::cerr << "Record value tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
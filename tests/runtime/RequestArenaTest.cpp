@@ -0,0 +1,82 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/JsonValue.h"
+#include "trx/runtime/RequestArena.h"
+
+#include <iostream>
+#include <memory_resource>
+#include <string>
+
+namespace trx::test {
+
+bool runRequestArenaTest() {
+    std::cout << "Running request arena test...\n";
+
+    using trx::runtime::JsonValue;
+    using trx::runtime::RequestArena;
+
+    const auto before = RequestArena::stats();
+    RequestArena arena(1024);
+
+    // A scope makes the arena current and releases what the request allocated
+    JsonValue kept;
+    {
+        RequestArena::Scope scope(arena);
+        if (!expect(RequestArena::current() == &arena, "a scope should make its arena current")) {
+            return false;
+        }
+
+        JsonValue::Object payload(RequestArena::current()->resource());
+        payload.emplace("name", JsonValue(std::string("widget")));
+        payload.emplace("qty", JsonValue(3.0));
+        JsonValue input(std::move(payload));
+        if (!expect(input.asObject().get_allocator().resource() == arena.resource(), "a moved object should stay in the arena") ||
+            !expect(arena.bytesInUse() > 0, "building the payload should allocate from the arena")) {
+            return false;
+        }
+
+        // Copies leave the arena so they can outlive the request
+        kept = input;
+        if (!expect(kept.asObject().get_allocator().resource() == std::pmr::get_default_resource(),
+                    "a copy should allocate from the default resource")) {
+            return false;
+        }
+    }
+    if (!expect(RequestArena::current() == nullptr, "the previous arena should be restored after the scope") ||
+        !expect(arena.bytesInUse() == 0, "releasing should reset the bytes in use") ||
+        !expect(kept.asObject().at("name").asString() == "widget" && kept.asObject().at("qty").asNumber() == 3.0,
+                "a copied value should survive the release")) {
+        return false;
+    }
+
+    // Requests larger than the reused block go to the heap and are counted
+    {
+        RequestArena::Scope scope(arena);
+        JsonValue::Array values(arena.resource());
+        for (int i = 0; i < 256; ++i) {
+            values.emplace_back(static_cast<double>(i));
+        }
+    }
+    const auto after = RequestArena::stats();
+    if (!expect(after.requests - before.requests == 2, "each scope should count one request") ||
+        !expect(after.bytes > before.bytes, "allocated bytes should be totalled") ||
+        !expect(after.heapBytes > before.heapBytes, "spilling past the first block should count heap bytes") ||
+        !expect(after.peakBytes >= 256 * sizeof(JsonValue), "the largest request should set the peak")) {
+        return false;
+    }
+
+    std::cout << "Request arena test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runRequestArenaTest()) {
+        std::cerr << "Request arena tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
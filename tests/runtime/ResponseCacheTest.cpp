@@ -0,0 +1,151 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ResponseCache.h"
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::ResponseCache;
+
+ResponseCache::Value value(const std::string &body) {
+    ResponseCache::Value cached;
+    cached.contentType = "application/json";
+    cached.body = body;
+    return cached;
+}
+
+bool runCacheTests() {
+    ResponseCache cache(4, 1);
+    const auto items = cache.tables({"items"});
+    const auto orders = cache.tables({"orders"});
+    const auto both = cache.tables({"items", "orders"});
+    const auto ttl = std::chrono::seconds(60);
+
+    if (!expect(!cache.find("/item/1", items), "an empty cache should miss")) {
+        return false;
+    }
+    cache.store("/item/1", value("one"), ttl, cache.snapshot(items));
+    const auto hit = cache.find("/item/1", items);
+    if (!expect(hit && hit->body == "one" && hit->contentType == "application/json", "a stored response should be found")) {
+        return false;
+    }
+
+    // Writing another table leaves the entry alone; writing its own table makes it stale
+    cache.store("/report", value("report"), ttl, cache.snapshot(both));
+    cache.invalidate(orders);
+    if (!expect(cache.find("/item/1", items).has_value(), "a write to an unrelated table should not invalidate") ||
+        !expect(!cache.find("/report", both), "a write to any table an entry read should invalidate it")) {
+        return false;
+    }
+
+    // A response built from data read before a write is never served after it
+    const auto before = cache.snapshot(items);
+    cache.invalidate(items);
+    cache.store("/item/2", value("old"), ttl, before);
+    if (!expect(!cache.find("/item/2", items), "a store racing a write should not be served")) {
+        return false;
+    }
+
+    // Expired entries miss
+    cache.store("/short", value("short"), std::chrono::milliseconds(1), cache.snapshot(items));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    if (!expect(!cache.find("/short", items), "an expired entry should miss")) {
+        return false;
+    }
+
+    // The least recently used entry goes first
+    for (int i = 0; i < 4; ++i) {
+        cache.store("/lru/" + std::to_string(i), value(std::to_string(i)), ttl, cache.snapshot(items));
+    }
+    cache.find("/lru/0", items);
+    cache.store("/lru/4", value("4"), ttl, cache.snapshot(items));
+    if (!expect(cache.find("/lru/0", items).has_value() && !cache.find("/lru/1", items), "the least recently used entry should be evicted")) {
+        return false;
+    }
+
+    const auto stats = cache.stats();
+    return expect(stats.entries == 4 && stats.evictions >= 1 && stats.invalidations == 2 && stats.hits >= 4,
+                  "stats should count entries, evictions, invalidations and hits");
+}
+
+bool runTableTests() {
+    constexpr const char *source = R"TRX(
+        ROUTINE lookup(request: JSON) : JSON {
+            var name CHAR(40);
+            EXEC SQL SELECT i.name INTO :name FROM items i JOIN categories c ON c.id = i.category WHERE i.id = :request.id;
+            RETURN { "name": name };
+        }
+
+        ROUTINE report(request: JSON) : JSON {
+            EXEC SQL DECLARE totals CURSOR FOR SELECT o.total FROM orders o, customers AS c WHERE c.id = o.customer;
+            RETURN lookup(request);
+        }
+
+        ROUTINE record(request: JSON) {
+            EXEC SQL INSERT INTO audit (event) VALUES ('seen');
+            EXEC SQL UPDATE items SET name = 'x' WHERE id = 1;
+            EXEC SQL DELETE FROM "Orders" WHERE id = 2;
+        }
+
+        ROUTINE migrate(request: JSON) {
+            EXEC SQL CREATE TABLE IF NOT EXISTS archive (id INTEGER);
+            record(request);
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "tables.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+
+    const auto &module = driver.context().module();
+    const auto sorted = [](std::vector<std::string> names) {
+        std::sort(names.begin(), names.end());
+        return names;
+    };
+    using Names = std::vector<std::string>;
+    return expect(sorted(findProcedure(module, "lookup")->readsTables) == Names{"categories", "items"}, "FROM and JOIN tables should be read") &&
+           expect(sorted(findProcedure(module, "report")->readsTables) == Names{"categories", "customers", "items", "orders"},
+                  "a comma list of tables and a callee's reads should be read") &&
+           expect(findProcedure(module, "lookup")->writesTables.empty(), "a SELECT should write nothing") &&
+           expect(sorted(findProcedure(module, "record")->writesTables) == Names{"audit", "items", "orders"},
+                  "INSERT, UPDATE and DELETE targets should be written") &&
+           expect(sorted(findProcedure(module, "migrate")->writesTables) == Names{"archive", "audit", "items", "orders"},
+                  "DDL targets and a callee's writes should be written");
+}
+
+} // namespace
+
+bool runResponseCacheTest() {
+    std::cout << "Running response cache test...\n";
+    if (!runCacheTests() || !runTableTests()) {
+        return false;
+    }
+    std::cout << "Response cache test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runResponseCacheTest()) {
+        std::cerr << "Response cache tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
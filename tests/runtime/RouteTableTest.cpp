@@ -0,0 +1,118 @@
+#include "TestUtils.h"
+
+#include "RouteTable.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+trx::ast::ProcedureDecl route(std::string name, std::string pathTemplate,
+                              std::vector<std::pair<std::string, std::string>> parameters = {}) {
+    trx::ast::ProcedureDecl procedure;
+    procedure.name.baseName = std::move(name);
+    procedure.name.pathTemplate = std::move(pathTemplate);
+    for (auto &[paramName, typeName] : parameters) {
+        trx::ast::ParameterDecl param;
+        param.name.name = std::move(paramName);
+        param.type.name = std::move(typeName);
+        procedure.name.pathParameters.push_back(std::move(param));
+    }
+    return procedure;
+}
+
+const trx::ast::ProcedureDecl *lookup(const trx::cli::RouteTable &routes, std::string_view method, std::string_view path) {
+    trx::cli::RouteTable::Match match;
+    return routes.match(method, path, match) ? match.procedure : nullptr;
+}
+
+} // namespace
+
+bool runRouteTableTest() {
+    std::cout << "Running route table test...\n";
+
+    const auto me = route("users", "users/me");
+    const auto byId = route("users", "users/{id}", {{"id", "INTEGER"}});
+    const auto byName = route("users", "users/{name}", {{"name", "_CHAR"}});
+    const auto createUser = route("users", "users/me");
+    const auto price = route("price", "price/{amount}/{active}", {{"amount", "DECIMAL"}, {"active", "BOOLEAN"}});
+    const auto order = route("orders", "orders/{id}", {{"id", "INTEGER"}});
+    const auto fileLatest = route("files", "files/latest");
+    const auto fileVersions = route("files", "files/{name}/versions", {{"name", "_CHAR"}});
+
+    trx::cli::RouteTable routes;
+    routes.add("GET", &byName);
+    routes.add("GET", &byId);
+    routes.add("GET", &me);
+    routes.add("POST", &createUser);
+    routes.add("GET", &price);
+    routes.add("GET", &order);
+    routes.add("GET", &fileLatest);
+    routes.add("GET", &fileVersions);
+
+    // Literal segments win over parameters, and INTEGER parameters are tried before CHAR
+    trx::cli::RouteTable::Match match;
+    if (!expect(lookup(routes, "GET", "/users/me") == &me, "a literal segment should win over a parameter") ||
+        !expect(routes.match("GET", "/users/42", match) && match.procedure == &byId, "a numeric segment should match the INTEGER parameter") ||
+        !expect(match.parameters() == std::map<std::string, std::string>{{"id", "42"}}, "the INTEGER parameter should be bound by name") ||
+        !expect(routes.match("GET", "/users/bob", match) && match.procedure == &byName, "a non-numeric segment should fall back to the CHAR parameter") ||
+        !expect(match.parameters().at("name") == "bob", "the CHAR parameter should be bound by name")) {
+        return false;
+    }
+
+    // A parameter branch is taken when the literal one does not match the rest of the path
+    if (!expect(lookup(routes, "GET", "/files/latest") == &fileLatest, "the literal route should match on its own") ||
+        !expect(routes.match("GET", "/files/latest/versions", match) && match.procedure == &fileVersions,
+                "a parameter should match when the literal branch has no route beneath it") ||
+        !expect(match.parameters().at("name") == "latest", "the backtracked parameter should be bound")) {
+        return false;
+    }
+
+    // Typed parameters reject values their type cannot be converted from, rather than binding 0
+    if (!expect(lookup(routes, "GET", "/orders/abc") == nullptr, "a non-numeric value should not match an INTEGER parameter") ||
+        !expect(lookup(routes, "GET", "/orders/1.5") == nullptr, "a fraction should not match an INTEGER parameter") ||
+        !expect(lookup(routes, "GET", "/orders/-3") == &order, "a negative integer should match an INTEGER parameter") ||
+        !expect(lookup(routes, "GET", "/orders/") == nullptr, "an empty segment should not match a parameter") ||
+        !expect(routes.match("GET", "/price/12.50/true", match) && match.procedure == &price, "DECIMAL and BOOLEAN parameters should accept their values") ||
+        !expect(match.count == 2 && match.values[0] == "12.50" && match.values[1] == "true", "parameter values should be kept in template order") ||
+        !expect(lookup(routes, "GET", "/price/12.50/yes") == nullptr, "a BOOLEAN parameter should reject other words")) {
+        return false;
+    }
+
+    // Each method has routes of its own
+    if (!expect(lookup(routes, "POST", "/users/me") == &createUser, "POST should match the POST route") ||
+        !expect(lookup(routes, "POST", "/users/42") == nullptr, "a GET route should not answer POST") ||
+        !expect(lookup(routes, "DELETE", "/users/me") == nullptr, "a method without routes should not match")) {
+        return false;
+    }
+
+    // The /api/ prefix is optional, and paths must match a whole route
+    if (!expect(lookup(routes, "GET", "/api/users/me") == &me, "the /api/ prefix should be stripped") ||
+        !expect(lookup(routes, "GET", "users/me") == &me, "a path without a leading slash should match") ||
+        !expect(lookup(routes, "GET", "/apiusers/me") == nullptr, "only a whole /api/ segment should be stripped") ||
+        !expect(lookup(routes, "GET", "/users") == nullptr, "a prefix of a route should not match") ||
+        !expect(lookup(routes, "GET", "/users/me/extra") == nullptr, "extra segments should not match")) {
+        return false;
+    }
+
+    std::cout << "Route table test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runRouteTableTest()) {
+        std::cerr << "Route table tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
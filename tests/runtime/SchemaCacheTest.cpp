@@ -0,0 +1,136 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/SchemaCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+trx::runtime::DatabaseConfig sqliteConfig(const std::string &path) {
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = path;
+    return config;
+}
+
+} // namespace
+
+bool runSchemaCacheTest() {
+    std::cout << "Running schema cache test...\n";
+
+    const auto dbPath = (std::filesystem::temp_directory_path() / "trx_schema_cache_test.db").string();
+    const auto cachePath = (std::filesystem::temp_directory_path() / "trx_schema_cache_test" / "schema.json").string();
+    std::remove(dbPath.c_str());
+    std::filesystem::remove_all(std::filesystem::path(cachePath).parent_path());
+
+    trx::runtime::SQLiteDriver driver(sqliteConfig(dbPath));
+    driver.initialize();
+    driver.executeSql("CREATE TABLE items (id INTEGER PRIMARY KEY, name VARCHAR(20) NOT NULL)");
+
+    // The version follows the table definitions
+    const auto version = driver.schemaVersion();
+    if (!expect(version.has_value() && driver.schemaVersion() == version, "the SQLite schema version should be stable")) {
+        return false;
+    }
+
+    // Stored columns survive a reload under the same version only
+    {
+        trx::runtime::SchemaCache cache(cachePath, *version);
+        if (!expect(cache.find("items") == nullptr, "a missing cache file should start empty")) {
+            return false;
+        }
+        cache.store("items", driver.getTableSchema("items"));
+        if (!expect(cache.save() && std::filesystem::exists(cachePath), "save should create the cache file and its directory")) {
+            return false;
+        }
+    }
+    {
+        trx::runtime::SchemaCache cache(cachePath, *version);
+        const auto *columns = cache.find("items");
+        if (!expect(columns && columns->size() == 2, "a reload under the same version should find the table") ||
+            !expect((*columns)[0].name == "id" && (*columns)[0].isPrimaryKey && (*columns)[0].typeName == "INTEGER",
+                    "the key column should round-trip") ||
+            !expect((*columns)[1].name == "name" && !(*columns)[1].isNullable && (*columns)[1].length == 20L,
+                    "the text column should keep its length and nullability")) {
+            return false;
+        }
+    }
+    driver.executeSql("ALTER TABLE items ADD COLUMN price DECIMAL");
+    const auto altered = driver.schemaVersion();
+    if (!expect(altered.has_value() && altered != version, "altering a table should change the schema version")) {
+        return false;
+    }
+    {
+        trx::runtime::SchemaCache cache(cachePath, *altered);
+        if (!expect(cache.find("items") == nullptr, "entries read under another version should be ignored")) {
+            return false;
+        }
+    }
+
+    // The interpreter resolves TYPE FROM TABLE through the cache named by TRX_SCHEMA_CACHE
+    constexpr const char *source = R"TRX(
+        TYPE item_row FROM TABLE items;
+
+        ROUTINE fields() : JSON {
+            RETURN {};
+        }
+    )TRX";
+    {
+        trx::runtime::SchemaCache cache(cachePath, *altered);
+        trx::runtime::TableColumn column;
+        column.name = "cached_only";
+        column.typeName = "CHAR";
+        cache.store("items", {column});
+        cache.save();
+    }
+    ::setenv("TRX_SCHEMA_CACHE", cachePath.c_str(), 1);
+    trx::parsing::ParserDriver parser;
+    if (!parser.parseString(source, "schema_cache.trx")) {
+        reportDiagnostics(parser);
+        return false;
+    }
+    trx::runtime::Interpreter interpreter(parser.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(sqliteConfig(dbPath)));
+    const auto *record = findRecord(parser.context().module(), "item_row");
+    if (!expect(record && record->fields.size() == 1 && record->fields[0].name.name == "cached_only",
+                "a warm start should take the columns from the cache instead of the database")) {
+        return false;
+    }
+
+    // A new version is read from the database and written back
+    driver.executeSql("CREATE TABLE other (id INTEGER)");
+    trx::parsing::ParserDriver coldParser;
+    coldParser.parseString(source, "schema_cache.trx");
+    trx::runtime::Interpreter cold(coldParser.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(sqliteConfig(dbPath)));
+    const auto *coldRecord = findRecord(coldParser.context().module(), "item_row");
+    trx::runtime::SchemaCache reloaded(cachePath, *driver.schemaVersion());
+    ::unsetenv("TRX_SCHEMA_CACHE");
+    if (!expect(coldRecord && coldRecord->fields.size() == 3, "a changed schema should be read from the database") ||
+        !expect(reloaded.find("items") && reloaded.find("items")->size() == 3, "the refreshed columns should be saved")) {
+        return false;
+    }
+
+    std::remove(dbPath.c_str());
+    std::filesystem::remove_all(std::filesystem::path(cachePath).parent_path());
+    std::cout << "Schema cache test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runSchemaCacheTest()) {
+        std::cerr << "Schema cache tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
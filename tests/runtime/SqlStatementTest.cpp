@@ -116,6 +116,52 @@ bool validateCursorProcedure(const trx::ast::ProcedureDecl &procedure) {
     return true;
 }
 
+bool validateCompiledProcedure(const trx::ast::ProcedureDecl &procedure) {
+    if (!expect(procedure.body.size() == 3, "compiled procedure does not contain three statements")) {
+        return false;
+    }
+
+    const auto getSql = [&](std::size_t index) -> const trx::ast::SqlStatement * {
+        const auto *sql = std::get_if<trx::ast::SqlStatement>(&procedure.body[index].node);
+        if (!expect(sql != nullptr, "statement is not SQL")) {
+            return nullptr;
+        }
+        return sql;
+    };
+
+    const auto *intoStmt = getSql(0);
+    if (!intoStmt) {
+        return false;
+    }
+    if (!expect(intoStmt->kind == trx::ast::SqlStatementKind::SelectInto, "SELECT INTO statement kind mismatch") ||
+        !expect(intoStmt->compiled.text == "SELECT NAME, VALUE FROM CUSTOMERS WHERE ID = ?", "SELECT INTO should drop the INTO clause") ||
+        !expect(intoStmt->compiled.intoCount == 2, "SELECT INTO target count mismatch") ||
+        !expect(intoStmt->hostVariables.size() == 3, "SELECT INTO host variable count mismatch")) {
+        return false;
+    }
+
+    const auto *declareStmt = getSql(1);
+    if (!declareStmt) {
+        return false;
+    }
+    if (!expect(declareStmt->compiled.text == "SELECT NAME FROM CUSTOMERS", "DECLARE should compile to its SELECT")) {
+        return false;
+    }
+
+    const auto *updateStmt = getSql(2);
+    if (!updateStmt) {
+        return false;
+    }
+    if (!expect(updateStmt->compiled.setAssignments.size() == 2, "UPDATE CURRENT OF assignment count mismatch") ||
+        !expect(updateStmt->compiled.text == "UPDATE CUSTOMERS SET NAME = ?, VALUE = ? WHERE CURRENT OF cur",
+                "unexpected compiled UPDATE CURRENT OF text") ||
+        !expect(updateStmt->compiled.currentOfCursor == "CUR", "UPDATE CURRENT OF should name its cursor")) {
+        return false;
+    }
+
+    return true;
+}
+
 bool runSqlStatementTests() {
     constexpr const char *source = R"TRX(
         TYPE SAMPLE {
@@ -136,6 +182,12 @@ bool runSqlStatementTests() {
             EXEC SQL FETCH mycursor INTO :output.NAME, :output.RESULT;
             EXEC SQL CLOSE mycursor;
         }
+
+        ROUTINE compiled_examples(sample: SAMPLE): SAMPLE {
+            EXEC SQL SELECT NAME, VALUE INTO :output.NAME, :output.RESULT FROM CUSTOMERS WHERE ID = :sample.VALUE;
+            EXEC SQL DECLARE cur CURSOR FOR SELECT NAME FROM CUSTOMERS;
+            EXEC SQL UPDATE CUSTOMERS SET NAME = :sample.NAME, VALUE = :sample.VALUE WHERE CURRENT OF cur;
+        }
     )TRX";
 
     trx::parsing::ParserDriver driver;
@@ -158,7 +210,31 @@ bool runSqlStatementTests() {
         return false;
     }
 
-    return validateCursorProcedure(*cursorProcedure);
+    if (!validateCursorProcedure(*cursorProcedure)) {
+        return false;
+    }
+
+    const auto *compiledProcedure = findProcedure(driver.context().module(), "compiled_examples");
+    if (!expect(compiledProcedure != nullptr, "compiled_examples procedure not found")) {
+        return false;
+    }
+
+    if (!validateCompiledProcedure(*compiledProcedure)) {
+        return false;
+    }
+
+    // Cursors a WHERE CURRENT OF names are marked when the module is resolved, so the
+    // driver can fetch them one row at a time from the start
+    auto module = driver.context().module();
+    trx::ast::resolveCalls(module);
+    const auto declaration = [&](std::string_view routine, std::size_t index) {
+        return std::get_if<trx::ast::SqlStatement>(&findProcedure(module, routine)->body[index].node);
+    };
+    if (!expect(declaration("compiled_examples", 1)->compiled.positioned, "a cursor named by WHERE CURRENT OF should be positioned") ||
+        !expect(!declaration("cursor_examples", 0)->compiled.positioned, "other cursors should keep prefetching rows")) {
+        return false;
+    }
+    return true;
 }
 
 } // namespace trx::test
@@ -0,0 +1,135 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SqlStatistics.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::SqlParameter;
+using trx::runtime::SqlStatistics;
+
+bool normalizesStatements() {
+    return expect(SqlStatistics::normalize("SELECT  name\n  FROM people WHERE id = 42") == "SELECT name FROM people WHERE id = ?",
+                  "whitespace should collapse and numbers become '?'") &&
+           expect(SqlStatistics::normalize("UPDATE people SET name = 'O''Brien' WHERE id = ?") == "UPDATE people SET name = ? WHERE id = ?",
+                  "string literals, with doubled quotes, should become '?'") &&
+           expect(SqlStatistics::normalize("SELECT id FROM t2 WHERE id IN (1, 2, 3)") == "SELECT id FROM t2 WHERE id IN (...)",
+                  "identifiers keep their digits and IN lists collapse") &&
+           expect(SqlStatistics::normalize("SELECT * FROM t WHERE id IN (?,?)") == SqlStatistics::normalize("SELECT * FROM t WHERE id IN (7)"),
+                  "IN lists of any length should count as one statement");
+}
+
+const SqlStatistics::StatementStats *find(const std::vector<SqlStatistics::StatementStats> &all, const std::string &statement) {
+    for (const auto &stats : all) {
+        if (stats.statement == statement) {
+            return &stats;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool runSqlStatisticsTest() {
+    std::cout << "Running SQL statistics test...\n";
+
+    if (!normalizesStatements()) {
+        return false;
+    }
+
+    std::vector<std::string> slowLog;
+    SqlStatistics::Options options;
+    options.slowQueryThreshold = std::chrono::microseconds(1);
+    options.log = [&slowLog](const std::string &line) { slowLog.push_back(line); };
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = ":memory:";
+    config.sqlStatistics = std::make_shared<SqlStatistics>(options);
+    auto driver = trx::runtime::createDatabaseDriver(config);
+    if (!expect(dynamic_cast<trx::runtime::InstrumentedDriver *>(driver.get()) != nullptr, "the factory should wrap drivers when statistics are on")) {
+        return false;
+    }
+    driver->initialize();
+
+    driver->executeSql("CREATE TABLE stats_people (id INTEGER, name TEXT)");
+    driver->beginTransaction();
+    for (int id = 1; id <= 3; ++id) {
+        driver->executeSql("INSERT INTO stats_people (id, name) VALUES (?, ?)",
+                           {SqlParameter{"id", trx::runtime::JsonValue(static_cast<double>(id))}, SqlParameter{"name", trx::runtime::JsonValue("secret")}});
+    }
+    driver->commitTransaction();
+    const auto rows = driver->querySql("SELECT id FROM stats_people WHERE id > 1");
+    const auto first = driver->queryFirstRow("SELECT name FROM stats_people WHERE id = 2");
+    driver->openCursor("people", "SELECT id FROM stats_people ORDER BY id");
+    driver->openDeclaredCursor("people");
+    int fetched = 0;
+    while (driver->cursorNext("people")) {
+        ++fetched;
+    }
+    driver->closeCursor("people");
+    bool threw = false;
+    try {
+        driver->executeSql("INSERT INTO missing_table VALUES (1)");
+    } catch (const std::exception &) {
+        threw = true;
+    }
+
+    const auto all = config.sqlStatistics->top(100);
+    const auto *insert = find(all, "INSERT INTO stats_people (id, name) VALUES (?, ?)");
+    const auto *select = find(all, "SELECT id FROM stats_people WHERE id > ?");
+    const auto *single = find(all, "SELECT name FROM stats_people WHERE id = ?");
+    const auto *cursor = find(all, "SELECT id FROM stats_people ORDER BY id");
+    const auto *failing = find(all, "INSERT INTO missing_table VALUES (?)");
+    const auto *commit = find(all, "COMMIT");
+    if (!expect(rows.size() == 2 && first && fetched == 3 && threw, "the wrapped driver should behave like the one it wraps") ||
+        !expect(insert && insert->calls == 3 && insert->errors == 0, "calls should be counted per normalized statement") ||
+        !expect(select && select->rows == 2 && single && single->rows == 1, "rows read should be counted, including a first-row query") ||
+        !expect(cursor && cursor->calls == 1 && cursor->rows == 3, "cursor fetches should add rows to the cursor's statement, not calls") ||
+        !expect(failing && failing->errors == 1 && !failing->lastError.empty(), "failures should be counted with their message") ||
+        !expect(commit && commit->calls == 1, "transactions should be timed too")) {
+        return false;
+    }
+
+    std::uint64_t bucketed = 0;
+    for (const auto bucket : insert->buckets) {
+        bucketed += bucket;
+    }
+    if (!expect(bucketed == 3 && insert->quantile(0.5) > 0.0, "each call should land in a latency bucket") ||
+        !expect(config.sqlStatistics->top(2).size() == 2, "top() should return at most the count asked for")) {
+        return false;
+    }
+
+    bool sawInsert = false;
+    for (const auto &line : slowLog) {
+        if (!expect(line.find("secret") == std::string::npos, "the slow query log should not show parameter values")) {
+            return false;
+        }
+        sawInsert = sawInsert || line.find("VALUES (?, ?) [id=<number>, name=<string>]") != std::string::npos;
+    }
+    if (!expect(sawInsert, "slow statements should be logged with their parameters described")) {
+        return false;
+    }
+
+    std::cout << "SQL statistics test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runSqlStatisticsTest()) {
+        std::cerr << "SQL statistics tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ConnectionPool.h"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JsonValue;
+
+std::string firstText(trx::runtime::DatabaseDriver &db, const std::string &sql) {
+    const auto row = db.queryFirstRow(sql);
+    return row && !row->empty() && row->front().isString() ? row->front().asString() : std::string();
+}
+
+double firstNumber(trx::runtime::DatabaseDriver &db, const std::string &sql) {
+    const auto row = db.queryFirstRow(sql);
+    return row && !row->empty() && row->front().isNumber() ? row->front().asNumber() : -1.0;
+}
+
+void removeDatabase(const std::string &path) {
+    for (const char *suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+}
+
+} // namespace
+
+bool runSqliteWalTest() {
+    std::cout << "Running SQLite WAL test...\n";
+
+    const auto dbPath = (std::filesystem::temp_directory_path() / "trx_sqlite_wal_test.db").string();
+    removeDatabase(dbPath);
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = dbPath;
+    config.sqliteWal = true;
+    config.sqliteBusyTimeoutMs = 2000;
+    config.sqliteMmapSize = 8 * 1024 * 1024;
+    config.sqliteCacheSize = 4096;
+
+    auto writer = trx::runtime::createDatabaseDriver(config);
+    writer->initialize();
+    if (!expect(firstText(*writer, "PRAGMA journal_mode") == "wal", "the writer should switch the file to WAL") ||
+        !expect(firstNumber(*writer, "PRAGMA cache_size") == -4096.0, "the cache size should be set in KiB") ||
+        !expect(firstNumber(*writer, "PRAGMA busy_timeout") == 2000.0, "the busy timeout should follow the config")) {
+        return false;
+    }
+    writer->executeSql("CREATE TABLE wal_items (id INTEGER PRIMARY KEY, name TEXT)");
+    for (int id = 1; id <= 100; ++id) {
+        writer->executeSql("INSERT INTO wal_items (id, name) VALUES (?, ?)",
+                           {{"id", JsonValue(static_cast<double>(id))}, {"name", JsonValue("item " + std::to_string(id))}});
+    }
+
+    auto readerConfig = config;
+    readerConfig.readOnly = true;
+    auto reader = trx::runtime::createDatabaseDriver(readerConfig);
+    reader->initialize();
+    bool refused = false;
+    try {
+        reader->executeSql("INSERT INTO wal_items (id, name) VALUES (101, 'nope')");
+    } catch (const std::exception &) {
+        refused = true;
+    }
+    if (!expect(refused, "a read-only connection should refuse writes") ||
+        !expect(firstNumber(*reader, "SELECT COUNT(*) FROM wal_items") == 100.0, "a read-only connection should read")) {
+        return false;
+    }
+
+    // With the writer in the middle of a transaction, readers keep going on the last commit
+    writer->beginTransaction();
+    writer->executeSql("INSERT INTO wal_items (id, name) VALUES (101, 'pending')");
+    auto readers = std::make_shared<trx::runtime::ConnectionPool>(readerConfig);
+    std::atomic<int> wrongCounts{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&readers, &wrongCounts]() {
+            trx::runtime::PooledDatabaseDriver db(readers);
+            for (int i = 0; i < 50; ++i) {
+                try {
+                    if (firstNumber(db, "SELECT COUNT(*) FROM wal_items") != 100.0) {
+                        ++wrongCounts;
+                    }
+                } catch (const std::exception &) {
+                    ++wrongCounts;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    writer->commitTransaction();
+    if (!expect(wrongCounts == 0, "readers should neither wait for nor see the open write transaction") ||
+        !expect(firstNumber(*reader, "SELECT COUNT(*) FROM wal_items") == 101.0, "readers should see the write once committed")) {
+        return false;
+    }
+
+    reader.reset();
+    readers.reset();
+    writer.reset();
+    removeDatabase(dbPath);
+    std::cout << "SQLite WAL test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runSqliteWalTest()) {
+        std::cerr << "SQLite WAL tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
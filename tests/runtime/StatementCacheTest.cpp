@@ -0,0 +1,121 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/StatementCache.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+bool runStatementCacheTest() {
+    std::cout << "Running statement cache test...\n";
+
+    // LRU bookkeeping and finalization
+    {
+        std::vector<int> finalized;
+        trx::runtime::StatementCache<int> cache(2, [&](int &handle) { finalized.push_back(handle); });
+        cache.insert("a", 1);
+        cache.insert("b", 2);
+        if (!expect(cache.find("a") && *cache.find("a") == 1, "cached handle should be found")) {
+            return false;
+        }
+        cache.insert("c", 3);
+        if (!expect(!cache.find("b"), "least recently used entry should be evicted") ||
+            !expect(finalized.size() == 1 && finalized[0] == 2, "evicted handle should be finalized")) {
+            return false;
+        }
+        const auto stats = cache.stats();
+        if (!expect(stats.hits == 2 && stats.misses == 1 && stats.evictions == 1 && stats.size == 2,
+                    "cache should count hits, misses and evictions")) {
+            return false;
+        }
+        cache.clear();
+        if (!expect(finalized.size() == 3 && cache.stats().size == 0, "clear should finalize every handle")) {
+            return false;
+        }
+    }
+
+    // SQLite statements are reused across executions
+    {
+        trx::runtime::DatabaseConfig config;
+        config.type = trx::runtime::DatabaseType::SQLITE;
+        config.statementCacheSize = 2;
+        trx::runtime::SQLiteDriver db(config);
+        db.initialize();
+
+        db.executeSql("CREATE TABLE cache_rows (id INTEGER PRIMARY KEY, name TEXT)");
+        db.beginTransaction();
+        for (int i = 0; i < 10; ++i) {
+            db.executeSql("INSERT INTO cache_rows (id, name) VALUES (?, ?)",
+                          {{"", trx::runtime::SqlValue(static_cast<double>(i))}, {"", trx::runtime::SqlValue(std::string("row"))}});
+        }
+        db.commitTransaction();
+
+        auto stats = db.statementCacheStats();
+        if (!expect(stats.hits == 9, "repeated insert should hit the cache") ||
+            !expect(stats.size == 2 && stats.capacity == 2, "cache should stay within its capacity")) {
+            return false;
+        }
+
+        const auto rows = db.querySql("SELECT COUNT(*) FROM cache_rows WHERE name = ?", {{"", trx::runtime::SqlValue(std::string("row"))}});
+        if (!expect(rows.size() == 1 && rows[0][0].asNumber() == 10.0, "inserts through cached statements should be visible")) {
+            return false;
+        }
+
+        // A failed step must leave the statement reusable
+        bool failed = false;
+        try {
+            db.executeSql("INSERT INTO cache_rows (id, name) VALUES (?, ?)",
+                          {{"", trx::runtime::SqlValue(0.0)}, {"", trx::runtime::SqlValue(std::string("dup"))}});
+        } catch (const std::runtime_error &) {
+            failed = true;
+        }
+        db.executeSql("INSERT INTO cache_rows (id, name) VALUES (?, ?)",
+                      {{"", trx::runtime::SqlValue(10.0)}, {"", trx::runtime::SqlValue()}});
+        const auto nulls = db.querySql("SELECT COUNT(*) FROM cache_rows WHERE name IS NULL");
+        if (!expect(failed, "constraint violation should still be reported") ||
+            !expect(nulls.size() == 1 && nulls[0][0].asNumber() == 1.0, "statement should be reusable after a failed step")) {
+            return false;
+        }
+
+        // Cached queries must not keep the database locked between calls
+        db.beginTransaction();
+        db.executeSql("DELETE FROM cache_rows WHERE id = ?", {{"", trx::runtime::SqlValue(10.0)}});
+        db.rollbackTransaction();
+        if (!expect(!db.isInTransaction(), "rollback should end the transaction")) {
+            return false;
+        }
+    }
+
+    // A zero capacity disables caching
+    {
+        trx::runtime::DatabaseConfig config;
+        config.type = trx::runtime::DatabaseType::SQLITE;
+        config.statementCacheSize = 0;
+        trx::runtime::SQLiteDriver db(config);
+        db.initialize();
+        db.querySql("SELECT 1");
+        db.querySql("SELECT 1");
+        const auto stats = db.statementCacheStats();
+        if (!expect(stats.hits == 0 && stats.size == 0, "disabled cache should not keep statements")) {
+            return false;
+        }
+    }
+
+    std::cout << "Statement cache test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runStatementCacheTest()) {
+        std::cerr << "Statement cache tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -115,6 +115,80 @@ bool runThreadPoolTest() {
         std::cout << "Task ordering test passed - all 20 tasks completed\n";
     }
 
+    // Test the queue limit and load shedding
+    {
+        ThreadPool pool(1, 2);
+        std::mutex gate;
+        std::unique_lock<std::mutex> hold(gate);
+        std::atomic<int> ran{0};
+        std::atomic<bool> started{false};
+
+        // The worker blocks on the first task, so the next two fill the queue
+        pool.enqueueTask([&]() {
+            started = true;
+            std::lock_guard<std::mutex> wait(gate);
+            ran++;
+        });
+        while (!started) {
+            std::this_thread::yield();
+        }
+        const bool first = pool.tryEnqueueTask([&ran]() { ran++; });
+        const bool second = pool.tryEnqueueTask([&ran]() { ran++; });
+        const bool third = pool.tryEnqueueTask([&ran]() { ran++; });
+        pool.enqueueTask([&ran]() { ran++; }); // enqueueTask ignores the limit
+        const auto full = pool.stats();
+        hold.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (!first || !second || third) {
+            std::cerr << "Expected two tasks to be queued and the third rejected\n";
+            return false;
+        }
+        if (full.queued != 3 || full.rejected != 1 || ran != 4) {
+            std::cerr << "Unexpected queue stats: queued " << full.queued << ", rejected " << full.rejected << ", ran " << ran << "\n";
+            return false;
+        }
+        if (pool.waitTimes().snapshot(0).count != 4 || pool.tryEnqueueTask([]() {}) == false) {
+            std::cerr << "Expected every started task to record its wait and the queue to accept tasks again\n";
+            return false;
+        }
+
+        std::cout << "Queue limit test passed\n";
+    }
+
+    // Test that an idle worker steals from a busy one
+    {
+        ThreadPool pool(2);
+        std::mutex gate;
+        std::unique_lock<std::mutex> hold(gate);
+        std::atomic<int> ran{0};
+        std::atomic<bool> started{false};
+
+        // Tasks a worker queues go to its own deque; the blocked worker cannot run them
+        pool.enqueueTask([&]() {
+            for (int i = 0; i < 5; ++i) {
+                pool.enqueueTask([&ran]() { ran++; });
+            }
+            started = true;
+            std::lock_guard<std::mutex> wait(gate);
+        });
+        while (!started) {
+            std::this_thread::yield();
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (ran < 5 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        hold.unlock();
+
+        if (ran != 5 || pool.stats().stolen < 5) {
+            std::cerr << "Expected the idle worker to steal all 5 tasks, ran " << ran << ", stolen " << pool.stats().stolen << "\n";
+            return false;
+        }
+
+        std::cout << "Work stealing test passed\n";
+    }
+
     std::cout << "All ThreadPool tests passed!\n";
     return true;
 }
@@ -0,0 +1,201 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/JsonParser.h"
+#include "trx/runtime/SQLiteDriver.h"
+#include "trx/runtime/Tracing.h"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trx::test {
+
+namespace {
+
+using trx::runtime::JsonValue;
+using trx::runtime::Span;
+using trx::runtime::SpanKind;
+using trx::runtime::TraceContext;
+using trx::runtime::Tracer;
+
+// Every span exported through a tracer, by name, as the OTLP JSON described it
+struct ExportedSpans {
+    std::mutex mutex;
+    std::vector<JsonValue> spans;
+
+    Tracer::Exporter exporter() {
+        return [this](const std::string &body) {
+            const auto request = trx::runtime::JsonParser(body).parse();
+            std::lock_guard lock(mutex);
+            // JsonParser lowercases object keys
+            for (const auto &span : request.asObject().at("resourcespans").asArray()[0].asObject().at("scopespans").asArray()[0].asObject().at("spans").asArray()) {
+                spans.push_back(span);
+            }
+            return true;
+        };
+    }
+
+    const JsonValue::Object *find(const std::string &name) const {
+        for (const auto &span : spans) {
+            if (span.asObject().at("name").asString() == name) {
+                return &span.asObject();
+            }
+        }
+        return nullptr;
+    }
+};
+
+std::string attribute(const JsonValue::Object &span, const std::string &key) {
+    for (const auto &entry : span.at("attributes").asArray()) {
+        if (entry.asObject().at("key").asString() == key) {
+            const auto &value = entry.asObject().at("value").asObject();
+            return value.count("stringvalue") ? value.at("stringvalue").asString() : value.at("intvalue").asString();
+        }
+    }
+    return {};
+}
+
+std::string parentOf(const JsonValue::Object &span) {
+    return span.count("parentspanid") ? span.at("parentspanid").asString() : std::string{};
+}
+
+bool parsesTraceparent() {
+    const std::string header = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01";
+    const auto context = TraceContext::parse(header);
+    return expect(context && context->sampled && context->traceparent() == header, "a valid traceparent should round-trip") &&
+           expect(TraceContext::parse("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00").value_or(TraceContext{}).valid(),
+                  "an unsampled traceparent is still valid") &&
+           expect(!TraceContext::parse("00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01"), "upper case hex is invalid") &&
+           expect(!TraceContext::parse("00-00000000000000000000000000000000-00f067aa0ba902b7-01"), "an all-zero trace id is invalid") &&
+           expect(!TraceContext::parse("00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01"), "an all-zero parent id is invalid") &&
+           expect(!TraceContext::parse("ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"), "version ff is invalid") &&
+           expect(!TraceContext::parse("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra"), "version 00 has no extra fields") &&
+           expect(TraceContext::parse("01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra").has_value(),
+                  "later versions may add fields");
+}
+
+bool nestsSpans() {
+    ExportedSpans exported;
+    TraceContext current;
+    {
+        Tracer tracer({.endpoint = {}, .serviceName = "test"}, exported.exporter());
+        {
+            Span outer(&tracer, current, "outer", SpanKind::Server);
+            const auto outerContext = current;
+            {
+                Span inner(&tracer, current, "inner");
+                inner.setAttribute("answer", std::int64_t{42});
+                inner.setError("failed");
+            }
+            if (!expect(current.spanId == outerContext.spanId, "an ended span should restore its parent as current")) {
+                return false;
+            }
+        }
+        if (!expect(!current.valid(), "the root span should leave no context behind")) {
+            return false;
+        }
+
+        // An incoming trace that was not sampled records nothing but keeps propagating
+        auto unsampled = TraceContext::parse("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00").value();
+        Span ignored(&tracer, unsampled, "ignored");
+        if (!expect(!ignored.recording() && unsampled.traceparent().ends_with("00f067aa0ba902b7-00"), "an unsampled trace should pass through unchanged")) {
+            return false;
+        }
+    }
+
+    const auto *outer = exported.find("outer");
+    const auto *inner = exported.find("inner");
+    return expect(exported.spans.size() == 2 && outer && inner, "both sampled spans should be exported when the tracer stops") &&
+           expect(inner->at("traceid").asString() == outer->at("traceid").asString() && parentOf(*inner) == outer->at("spanid").asString(),
+                  "the inner span should be a child of the outer one") &&
+           expect(parentOf(*outer).empty() && outer->at("kind").asNumber() == 2.0, "the outer span should be a server root") &&
+           expect(attribute(*inner, "answer") == "42" && inner->at("status").asObject().at("code").asNumber() == 2.0,
+                  "attributes and errors should be exported");
+}
+
+} // namespace
+
+bool runTracingTest() {
+    std::cout << "Running tracing test...\n";
+
+    if (!parsesTraceparent() || !nestsSpans()) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        ROUTINE store(request: JSON) : JSON {
+            EXEC SQL INSERT INTO traced_rows (id) VALUES (:request.id);
+            RETURN request;
+        }
+
+        ROUTINE fetch(request: JSON) : JSON {
+            var stored JSON := store(request);
+            var id INTEGER;
+            EXEC SQL SELECT id INTO :id FROM traced_rows WHERE id = :request.id;
+            RETURN { "id": id };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "traced.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = ":memory:";
+    trx::runtime::Interpreter interpreter(driver.context().module(), std::make_unique<trx::runtime::SQLiteDriver>(config));
+    interpreter.db().executeSql("CREATE TABLE traced_rows (id INTEGER)");
+
+    ExportedSpans exported;
+    const auto incoming = TraceContext::parse("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01").value();
+    {
+        Tracer tracer({}, exported.exporter());
+        interpreter.setTracer(&tracer);
+        interpreter.traceContext() = incoming;
+        JsonValue::Object request;
+        request["id"] = JsonValue(7.0);
+        const auto result = interpreter.execute("fetch", JsonValue(request));
+        interpreter.setTracer(nullptr);
+        if (!expect(result && result->asObject().at("id").asNumber() == 7.0, "the traced routine should still run") ||
+            !expect(interpreter.traceContext().spanId == incoming.spanId, "the interpreter should be back at the incoming context")) {
+            return false;
+        }
+    }
+
+    // fetch -> store -> INSERT, then fetch -> SELECT, all in the caller's trace
+    const auto *fetch = exported.find("fetch");
+    const auto *store = exported.find("store");
+    const auto *insert = exported.find("INSERT");
+    const auto *select = exported.find("SELECT");
+    if (!expect(fetch && store && insert && select, "routine calls and SQL statements should each get a span") ||
+        !expect(fetch->at("traceid").asString() == "4bf92f3577b34da6a3ce929d0e0e4736" && parentOf(*fetch) == "00f067aa0ba902b7",
+                "the routine span should continue the incoming trace") ||
+        !expect(parentOf(*store) == fetch->at("spanid").asString() && parentOf(*insert) == store->at("spanid").asString() &&
+                    parentOf(*select) == fetch->at("spanid").asString(),
+                "spans should nest the way the calls did") ||
+        !expect(insert->at("kind").asNumber() == 3.0 && attribute(*insert, "db.statement").find("INSERT INTO traced_rows") == 0,
+                "SQL spans should be client spans carrying their statement") ||
+        !expect(attribute(*select, "db.rows") == "1", "a SELECT INTO that found a row should report it")) {
+        return false;
+    }
+
+    std::cout << "Tracing test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runTracingTest()) {
+        std::cerr << "Tracing tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/SQLiteDriver.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace trx::test {
+
+namespace {
+
+std::unique_ptr<trx::runtime::SQLiteDriver> memoryDriver() {
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    return std::make_unique<trx::runtime::SQLiteDriver>(config);
+}
+
+} // namespace
+
+bool runTypeCheckTest() {
+    std::cout << "Running type check test...\n";
+
+    using trx::runtime::JsonValue;
+
+    // Operands that can never fit their operator are reported when the module loads
+    constexpr const char *mistyped = R"TRX(
+        ROUTINE broken(request: JSON) : JSON {
+            var count INTEGER := 1;
+            IF request.flag {
+                RETURN "a" - count;
+            }
+            RETURN (count < 2) AND 5;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver mistypedDriver;
+    if (!mistypedDriver.parseString(mistyped, "mistyped.trx")) {
+        reportDiagnostics(mistypedDriver);
+        return false;
+    }
+    std::string message;
+    try {
+        trx::runtime::Interpreter interpreter(mistypedDriver.context().module(), memoryDriver());
+    } catch (const std::runtime_error &e) {
+        message = e.what();
+    }
+    if (!expect(message.find("Subtract operator requires numeric operands in routine 'broken'") != std::string::npos,
+                "subtracting from a string should be reported at load time") ||
+        !expect(message.find("And operator requires boolean operands") != std::string::npos, "AND of a number should be reported too")) {
+        return false;
+    }
+
+    constexpr const char *source = R"TRX(
+        TYPE LINE {
+            AMOUNT DECIMAL(10,2);
+            QTY INTEGER;
+        }
+
+        ROUTINE invoice(request: JSON) : JSON {
+            var total DECIMAL(10,2) := 0;
+            var line LINE;
+            var loose JSON := 0;
+            FOR entry IN request.lines {
+                line.amount := entry.amount;
+                line.qty := entry.qty;
+                total := total + line.qty * line.amount;
+                loose := loose + entry.qty * entry.amount;
+            }
+            var count INTEGER := 0;
+            count := "not a number";
+            RETURN {
+                "total": total,
+                "loose": loose,
+                "literal": 0.1 + 0.2,
+                "third": total / 3,
+                "label": "total " + total,
+                "count": count + "!"
+            };
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "type_check.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+    trx::runtime::Interpreter interpreter(driver.context().module(), memoryDriver());
+
+    const auto line = [](double amount, double qty) {
+        JsonValue::Object object;
+        object["amount"] = JsonValue(amount);
+        object["qty"] = JsonValue(qty);
+        return JsonValue(std::move(object));
+    };
+    JsonValue::Array lines;
+    for (int i = 0; i < 10; ++i) {
+        lines.push_back(line(0.1, 1));
+    }
+    JsonValue::Object request;
+    request["lines"] = JsonValue(std::move(lines));
+
+    const auto result = interpreter.execute("invoice", JsonValue(request));
+    if (!expect(result.has_value(), "invoice should return a value")) {
+        return false;
+    }
+    const auto &totals = result->asObject();
+    if (!expect(totals.at("total").asNumber() == 1.0, "DECIMAL(10,2) arithmetic should keep exact cents") ||
+        !expect(totals.at("loose").asNumber() != 1.0, "numbers of unknown scale should add as doubles") ||
+        !expect(totals.at("literal").asNumber() == 0.3, "literals should add at the scale they are written with") ||
+        !expect(totals.at("third").asNumber() == 1.0 / 3, "division should not be rounded") ||
+        !expect(totals.at("label").asString() == "total 1", "adding a DECIMAL to a string should concatenate") ||
+        !expect(totals.at("count").asString() == "not a number!", "a declared type should not stop a variable holding another value")) {
+        return false;
+    }
+
+    std::cout << "Type check test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runTypeCheckTest()) {
+        std::cerr << "Type check tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
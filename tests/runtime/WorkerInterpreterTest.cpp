@@ -0,0 +1,148 @@
+#include "TestUtils.h"
+
+#include "trx/runtime/ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trx::test {
+
+bool runWorkerInterpreterTest() {
+    std::cout << "Running worker interpreter test...\n";
+
+    constexpr const char *source = R"TRX(
+        ROUTINE add_item(item: JSON) {
+            EXEC SQL INSERT INTO worker_items (id, worker) VALUES (:item.id, :item.worker);
+        }
+
+        ROUTINE count_items() : JSON {
+            var result JSON := {};
+            var total INTEGER;
+            EXEC SQL DECLARE count_cursor CURSOR FOR SELECT COUNT(*) FROM worker_items;
+            EXEC SQL OPEN count_cursor;
+            EXEC SQL FETCH count_cursor INTO :total;
+            EXEC SQL CLOSE count_cursor;
+            result.total := total;
+            RETURN result;
+        }
+    )TRX";
+
+    trx::parsing::ParserDriver driver;
+    if (!driver.parseString(source, "worker_interpreter.trx")) {
+        reportDiagnostics(driver);
+        return false;
+    }
+
+    const auto dbPath = (std::filesystem::temp_directory_path() / "trx_worker_interpreter_test.db").string();
+    std::remove(dbPath.c_str());
+
+    trx::runtime::DatabaseConfig config;
+    config.type = trx::runtime::DatabaseType::SQLITE;
+    config.databasePath = dbPath;
+
+    trx::runtime::Interpreter primary(driver.context().module(), trx::runtime::createDatabaseDriver(config));
+    primary.db().executeSql("CREATE TABLE worker_items (id INTEGER PRIMARY KEY, worker INTEGER)");
+    primary.globalVariables()["greeting"] = trx::runtime::JsonValue("hello");
+
+    // Forked interpreters start from the prototype's globals but own their copy
+    auto sibling = primary.fork(trx::runtime::createDatabaseDriver(config));
+    const auto greetingIt = sibling->globalVariables().find("greeting");
+    if (!expect(greetingIt != sibling->globalVariables().end() && greetingIt->second.asString() == "hello",
+                "forked interpreter should copy global variables")) {
+        return false;
+    }
+    sibling->globalVariables()["greeting"] = trx::runtime::JsonValue("changed");
+    if (!expect(primary.globalVariables().at("greeting").asString() == "hello",
+                "forked interpreter globals should be independent")) {
+        return false;
+    }
+    if (!expect(sibling->getRoutine("add_item") != nullptr, "forked interpreter should resolve routines")) {
+        return false;
+    }
+
+    // One interpreter per pool worker, each with its own connection, running concurrently
+    constexpr std::size_t workerCount = 4;
+    constexpr int itemsPerWorker = 25;
+    std::vector<std::unique_ptr<trx::runtime::Interpreter>> interpreters;
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        interpreters.push_back(primary.fork(trx::runtime::createDatabaseDriver(config)));
+    }
+
+    std::atomic<int> completed{0};
+    std::atomic<int> failures{0};
+    std::mutex errorMutex;
+    std::string firstError;
+    {
+        ThreadPool pool(workerCount);
+        if (!expect(pool.size() == workerCount, "thread pool should report its worker count")) {
+            return false;
+        }
+        for (int id = 0; id < static_cast<int>(workerCount) * itemsPerWorker; ++id) {
+            pool.enqueueTask([&, id]() {
+                const auto index = ThreadPool::currentWorkerIndex();
+                try {
+                    if (index >= workerCount) {
+                        throw std::runtime_error("task did not run on a pool worker");
+                    }
+                    trx::runtime::JsonValue::Object item;
+                    item["id"] = trx::runtime::JsonValue(static_cast<double>(id));
+                    item["worker"] = trx::runtime::JsonValue(static_cast<double>(index));
+                    interpreters[index]->execute("add_item", trx::runtime::JsonValue(item));
+                } catch (const std::exception &ex) {
+                    failures++;
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (firstError.empty()) {
+                        firstError = ex.what();
+                    }
+                }
+                completed++;
+            });
+        }
+        while (completed < static_cast<int>(workerCount) * itemsPerWorker) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    if (!expect(ThreadPool::currentWorkerIndex() == ThreadPool::npos, "main thread should not report a worker index")) {
+        return false;
+    }
+    if (!expect(failures == 0, "concurrent executions failed: " + firstError)) {
+        return false;
+    }
+
+    const auto result = primary.execute("count_items", trx::runtime::JsonValue::object());
+    if (!expect(result.has_value() && result->isObject(), "count_items should return an object")) {
+        return false;
+    }
+    if (!expect(result->asObject().at("total").asNumber() == workerCount * itemsPerWorker,
+                "all rows inserted by worker interpreters should be visible")) {
+        return false;
+    }
+
+    interpreters.clear();
+    sibling.reset();
+    std::remove(dbPath.c_str());
+
+    std::cout << "Worker interpreter test passed\n";
+    return true;
+}
+
+} // namespace trx::test
+
+int main() {
+    if (!trx::test::runWorkerInterpreterTest()) {
+        std::cerr << "Worker interpreter tests failed.\n";
+        return 1;
+    }
+
+    std::cout << "All tests passed!\n";
+    return 0;
+}
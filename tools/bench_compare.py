@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+Compare two trx_bench result files
+
+Reads the JSON written by `trx_bench --benchmark_out=<file> --benchmark_out_format=json`
+(or `make bench`) for a baseline and a candidate build, and prints the change in time
+per iteration for every benchmark both runs have. Exits non-zero when a benchmark got
+slower than --threshold, so it can gate a CI job.
+"""
+
+import argparse
+import json
+import sys
+from typing import Dict
+
+
+def load(path: str) -> Dict[str, float]:
+    """Real time per iteration in nanoseconds, by benchmark name"""
+    scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+    with open(path) as handle:
+        report = json.load(handle)
+    times = {}
+    for entry in report.get("benchmarks", []):
+        # With --benchmark_repetitions, compare the medians only
+        if entry.get("run_type") == "aggregate" and entry.get("aggregate_name") != "median":
+            continue
+        name = entry.get("run_name", entry["name"])
+        times[name] = entry["real_time"] * scale[entry.get("time_unit", "ns")]
+    return times
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare two trx_bench JSON result files")
+    parser.add_argument("baseline", help="results of the reference build")
+    parser.add_argument("candidate", help="results of the build under test")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percentage slowdown reported as a regression (default: 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    candidate = load(args.candidate)
+
+    regressions = 0
+    width = max((len(name) for name in baseline), default=10)
+    print(f"{'Benchmark':<{width}}  {'Baseline':>12}  {'Candidate':>12}  {'Change':>8}")
+    for name, before in baseline.items():
+        after = candidate.get(name)
+        if after is None:
+            print(f"{name:<{width}}  {before:>10.0f}ns  {'missing':>12}")
+            continue
+        change = (after - before) / before * 100.0 if before else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:<{width}}  {before:>10.0f}ns  {after:>10.0f}ns  {change:>+7.1f}%{flag}")
+    for name in candidate.keys() - baseline.keys():
+        print(f"{name:<{width}}  {'new':>12}  {candidate[name]:>10.0f}ns")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -436,7 +436,7 @@ void yyerror(YYLTYPE *loc, trx::parsing::ParserDriver &driver, void *scanner, co
 %token <number> NUMBER
 %token INCLUDE CONSTANT ROUTINE TABLE PRIMARY KEY NULL_K TYPE FROM VAR LIST
 %token EXPORT
-%token IF ELSE WHILE FOR IN SWITCH CASE DEFAULT CALL TRY CATCH THROW RETURN
+%token IF ELSE WHILE FOR PARALLEL IN SWITCH CASE DEFAULT CALL TRY CATCH THROW RETURN SORT EMIT BATCH
 %token EXEC_SQL
 %token ASSIGN
 %token AND OR NOT TRUE FALSE
@@ -445,7 +445,7 @@ void yyerror(YYLTYPE *loc, trx::parsing::ParserDriver &driver, void *scanner, co
 %token DATE TIME JSON
 %token SQLCODE TIMESTAMP WEEK WEEKDAY
 %token GET POST PUT DELETE PATCH HEAD OPTIONS
-%token HEADERS BODY METHOD TIMEOUT
+%token HEADERS BODY METHOD TIMEOUT CACHE
 %token LBRACE RBRACE LBRACKET RBRACKET LPAREN RPAREN COMMA SEMICOLON SLASH
 
 %type <text> identifier
@@ -454,7 +454,7 @@ void yyerror(YYLTYPE *loc, trx::parsing::ParserDriver &driver, void *scanner, co
 %type <text> include_target
 %type <text> key
 %type <ptr> fields field_def
-%type <ptr> routine_body block statement_list statement assignment_statement variable_declaration_statement throw_statement return_statement try_catch_statement if_statement else_clause while_statement for_statement switch_statement case_clauses case_clause default_clause sql_statement expression_statement arguments sql_chunks sql_chunk
+%type <ptr> routine_body block statement_list statement assignment_statement variable_declaration_statement throw_statement emit_statement batch_statement batch_call return_statement sort_statement sort_keys sort_key try_catch_statement if_statement else_clause while_statement for_statement parallel_limit switch_statement case_clauses case_clause default_clause sql_statement expression_statement arguments sql_chunks sql_chunk
 %type <ptr> format_decl
 %type <ptr> variable expression variable_reference
 %type <ptr> logical_or_expression logical_and_expression equality_expression relational_expression additive_expression multiplicative_expression unary_expression primary_expression builtin literal object_properties array_elements
@@ -818,6 +818,8 @@ routine_decl
             if (config) {
                 procedure.httpMethod = config->httpMethod;
                 procedure.httpHeaders = std::move(config->httpHeaders);
+                procedure.cacheSeconds = config->cacheSeconds;
+                procedure.timeoutSeconds = config->timeoutSeconds;
                 delete config;
             }
 
@@ -878,6 +880,8 @@ routine_decl
             if (config) {
                 procedure.httpMethod = config->httpMethod;
                 procedure.httpHeaders = std::move(config->httpHeaders);
+                procedure.cacheSeconds = config->cacheSeconds;
+                procedure.timeoutSeconds = config->timeoutSeconds;
                 delete config;
             }
 
@@ -940,6 +944,8 @@ routine_decl
             if (config) {
                 procedure.httpMethod = config->httpMethod;
                 procedure.httpHeaders = std::move(config->httpHeaders);
+                procedure.cacheSeconds = config->cacheSeconds;
+                procedure.timeoutSeconds = config->timeoutSeconds;
                 delete config;
             }
 
@@ -1013,6 +1019,28 @@ routine_config
           }
           $$ = config;
       }
+    | routine_config CACHE NUMBER
+      {
+          auto config = static_cast<trx::ast::ProcedureConfig*>($1);
+          if ($3 <= 0) {
+              delete config;
+              yyerror(&@3, driver, scanner, "CACHE needs a positive number of seconds");
+              YYERROR;
+          }
+          config->cacheSeconds = $3;
+          $$ = config;
+      }
+    | routine_config TIMEOUT NUMBER
+      {
+          auto config = static_cast<trx::ast::ProcedureConfig*>($1);
+          if ($3 <= 0) {
+              delete config;
+              yyerror(&@3, driver, scanner, "TIMEOUT needs a positive number of seconds");
+              YYERROR;
+          }
+          config->timeoutSeconds = $3;
+          $$ = config;
+      }
     ;
 
 routine_name
@@ -1161,6 +1189,14 @@ statement
         {
             $$ = $1;
         }
+    | emit_statement
+        {
+            $$ = $1;
+        }
+    | batch_statement
+        {
+            $$ = $1;
+        }
     | try_catch_statement
         {
             $$ = $1;
@@ -1189,6 +1225,10 @@ statement
         {
             $$ = $1;
         }
+    | sort_statement
+        {
+            $$ = $1;
+        }
     | expression_statement
         {
             $$ = $1;
@@ -1271,6 +1311,36 @@ variable_declaration_statement
           std::free($3);
           $$ = stmt;
       }
+    | VAR identifier _DECIMAL LPAREN NUMBER COMMA NUMBER RPAREN SEMICOLON
+      {
+          auto stmt = new trx::ast::Statement();
+          stmt->location = makeLocation(driver, @1);
+          stmt->node = trx::ast::VariableDeclarationStatement{
+              .name = {.name = $2 ? std::string($2) : std::string{}, .location = makeLocation(driver, @2)},
+              .typeName = "DECIMAL",
+              .initializer = std::nullopt,
+              .tableName = std::nullopt,
+              .scale = static_cast<short>(toLength($7))
+          };
+          std::free($2);
+          $$ = stmt;
+      }
+    | VAR identifier _DECIMAL LPAREN NUMBER COMMA NUMBER RPAREN ASSIGN expression SEMICOLON
+      {
+          auto stmt = new trx::ast::Statement();
+          stmt->location = makeLocation(driver, @1);
+          auto value = expressionFrom($10);
+          stmt->node = trx::ast::VariableDeclarationStatement{
+              .name = {.name = $2 ? std::string($2) : std::string{}, .location = makeLocation(driver, @2)},
+              .typeName = "DECIMAL",
+              .initializer = std::move(*value),
+              .tableName = std::nullopt,
+              .scale = static_cast<short>(toLength($7))
+          };
+          delete value;
+          std::free($2);
+          $$ = stmt;
+      }
     | VAR identifier FROM TABLE identifier SEMICOLON
       {
           auto stmt = new trx::ast::Statement();
@@ -1300,6 +1370,65 @@ throw_statement
       }
     ;
 
+emit_statement
+    : EMIT expression SEMICOLON
+      {
+          auto stmt = new trx::ast::Statement();
+          stmt->location = makeLocation(driver, @1);
+          auto value = expressionFrom($2);
+          stmt->node = trx::ast::EmitStatement{
+              .value = std::move(*value)
+          };
+          delete value;
+          $$ = stmt;
+      }
+    ;
+
+batch_statement
+    : batch_call SEMICOLON
+      {
+          $$ = $1;
+      }
+    | variable ASSIGN batch_call SEMICOLON
+      {
+          auto stmt = statementFrom($3);
+          auto target = variableFrom($1);
+          stmt->location = makeLocation(driver, @1);
+          std::get<trx::ast::BatchStatement>(stmt->node).jobId = std::move(*target);
+          delete target;
+          $$ = stmt;
+      }
+    ;
+
+batch_call
+    : BATCH identifier LPAREN RPAREN
+      {
+          auto stmt = new trx::ast::Statement();
+          stmt->location = makeLocation(driver, @1);
+          stmt->node = trx::ast::BatchStatement{
+              .name = $2 ? std::string($2) : std::string{},
+              .argument = std::nullopt,
+              .jobId = std::nullopt
+          };
+          std::free($2);
+          $$ = stmt;
+      }
+    | BATCH identifier LPAREN variable RPAREN
+      {
+          auto stmt = new trx::ast::Statement();
+          stmt->location = makeLocation(driver, @1);
+          auto argument = variableFrom($4);
+          stmt->node = trx::ast::BatchStatement{
+              .name = $2 ? std::string($2) : std::string{},
+              .argument = std::move(*argument),
+              .jobId = std::nullopt
+          };
+          delete argument;
+          std::free($2);
+          $$ = stmt;
+      }
+    ;
+
 return_statement
     : RETURN expression SEMICOLON
       {
@@ -1314,6 +1443,72 @@ return_statement
       }
     ;
 
+sort_statement
+    : SORT variable identifier sort_keys SEMICOLON
+      {
+          const bool by = toLowerCopy($3 ? std::string($3) : std::string{}) == "by";
+          std::free($3);
+          auto target = variableFrom($2);
+          auto keys = static_cast<std::vector<trx::ast::SortKey> *>($4);
+          if (!by) {
+              delete target;
+              delete keys;
+              yyerror(&@3, driver, scanner, "Expected BY after the SORT target");
+              YYERROR;
+          }
+          auto stmt = new trx::ast::Statement();
+          stmt->location = makeLocation(driver, @1);
+          stmt->node = trx::ast::SortStatement{
+              .array = std::move(*target),
+              .keys = std::move(*keys)
+          };
+          delete target;
+          delete keys;
+          $$ = stmt;
+      }
+    ;
+
+sort_keys
+    : sort_key
+      {
+          auto keys = new std::vector<trx::ast::SortKey>();
+          auto key = static_cast<trx::ast::SortKey *>($1);
+          keys->push_back(std::move(*key));
+          delete key;
+          $$ = keys;
+      }
+    | sort_keys COMMA sort_key
+      {
+          auto keys = static_cast<std::vector<trx::ast::SortKey> *>($1);
+          auto key = static_cast<trx::ast::SortKey *>($3);
+          keys->push_back(std::move(*key));
+          delete key;
+          $$ = keys;
+      }
+    ;
+
+sort_key
+    : identifier
+      {
+          auto key = new trx::ast::SortKey{.order = 1.0, .fieldName = toLowerCopy($1 ? std::string($1) : std::string{})};
+          std::free($1);
+          $$ = key;
+      }
+    | identifier identifier
+      {
+          const auto direction = toLowerCopy($2 ? std::string($2) : std::string{});
+          std::free($2);
+          if (direction != "asc" && direction != "desc") {
+              std::free($1);
+              yyerror(&@2, driver, scanner, "Expected ASC or DESC after a SORT key");
+              YYERROR;
+          }
+          auto key = new trx::ast::SortKey{.order = direction == "desc" ? -1.0 : 1.0, .fieldName = toLowerCopy($1 ? std::string($1) : std::string{})};
+          std::free($1);
+          $$ = key;
+      }
+    ;
+
 try_catch_statement
     : TRY block CATCH LPAREN variable RPAREN block
       {
@@ -1400,6 +1595,47 @@ for_statement
                     stmt->node = std::move(node);
                     $$ = stmt;
             }
+        | PARALLEL FOR variable IN expression parallel_limit block
+            {
+                    auto stmt = new trx::ast::Statement();
+                    stmt->location = makeLocation(driver, @1);
+                    auto loopVar = variableFrom($3);
+                    auto collection = expressionFrom($5);
+                    auto body = statementListFrom($7);
+                    trx::ast::ForStatement node;
+                    node.loopVar = std::move(*loopVar);
+                    node.collection = std::move(*collection);
+                    node.body = std::move(*body);
+                    node.parallel = true;
+                    if ($6) {
+                            auto limit = expressionFrom($6);
+                            node.maxParallel = std::move(*limit);
+                            delete limit;
+                    }
+                    delete loopVar;
+                    delete collection;
+                    delete body;
+                    stmt->node = std::move(node);
+                    $$ = stmt;
+            }
+        ;
+
+parallel_limit
+        : /* empty */
+            {
+                    $$ = nullptr;
+            }
+        | identifier expression
+            {
+                    const auto keyword = toLowerCopy($1 ? std::string($1) : std::string{});
+                    std::free($1);
+                    if (keyword != "max") {
+                            delete expressionFrom($2);
+                            yyerror(&@1, driver, scanner, "Expected MAX or a block after PARALLEL FOR ... IN");
+                            YYERROR;
+                    }
+                    $$ = $2;
+            }
         ;
 
 switch_statement
@@ -1484,6 +1720,7 @@ sql_statement
               delete fragments;
               classifySqlStatement(node);
           }
+          trx::ast::compileSqlStatement(node);
           stmt->node = std::move(node);
           $$ = stmt;
       }